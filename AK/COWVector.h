@@ -110,6 +110,14 @@ public:
             m_detail->m_members.clear();
     }
 
+    void clear_with_capacity()
+    {
+        if (m_detail->ref_count() > 1)
+            m_detail = make_ref_counted<Detail>();
+        else
+            m_detail->m_members.clear_with_capacity();
+    }
+
     T& mutable_at(size_t index)
     {
         // We're handing out a mutable reference, so make sure we own the data exclusively.
@@ -85,8 +85,10 @@ WebContentView::WebContentView(QWidget* window, WebContentOptions const& web_con
         horizontalScrollBar()->setPageStep(m_viewport_rect.width());
     };
 
-    on_ready_to_paint = [this]() {
-        viewport()->update();
+    on_ready_to_paint = [this](auto const& damaged_rect) {
+        auto inverse_device_pixel_ratio = 1 / m_device_pixel_ratio;
+        auto rect = QRectF(damaged_rect.x() * inverse_device_pixel_ratio, damaged_rect.y() * inverse_device_pixel_ratio, damaged_rect.width() * inverse_device_pixel_ratio, damaged_rect.height() * inverse_device_pixel_ratio);
+        viewport()->update(rect.toAlignedRect());
     };
 
     on_scroll_by_delta = [this](auto x_delta, auto y_delta) {
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibCrypto/Authentication/HMAC.h>
+#include <LibCrypto/Hash/HKDF.h>
+#include <LibCrypto/Hash/SHA2.h>
+#include <LibTest/TestCase.h>
+
+using HMACSHA256 = Crypto::Authentication::HMAC<Crypto::Hash::SHA256>;
+
+// https://www.rfc-editor.org/rfc/rfc5869#appendix-A.1
+TEST_CASE(test_case_1_sha256)
+{
+    Array<u8, 22> const input_keying_material {
+        0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+        0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b
+    };
+    Array<u8, 13> const salt {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c
+    };
+    Array<u8, 10> const info {
+        0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9
+    };
+    Array<u8, 32> const expected_pseudorandom_key {
+        0x07, 0x77, 0x09, 0x36, 0x2c, 0x2e, 0x32, 0xdf, 0x0d, 0xdc, 0x3f, 0x0d, 0xc4, 0x7b, 0xba, 0x63,
+        0x90, 0xb6, 0xc7, 0x3b, 0xb5, 0x0f, 0x9c, 0x31, 0x22, 0xec, 0x84, 0x4a, 0xd7, 0xc2, 0xb3, 0xe5
+    };
+    Array<u8, 42> const expected_output_keying_material {
+        0x3c, 0xb2, 0x5f, 0x25, 0xfa, 0xac, 0xd5, 0x7a, 0x90, 0x43, 0x4f, 0x64, 0xd0, 0x36, 0x2f, 0x2a,
+        0x2d, 0x2d, 0x0a, 0x90, 0xcf, 0x1a, 0x5a, 0x4c, 0x5d, 0xb0, 0x2d, 0x56, 0xec, 0xc4, 0xc5, 0xbf,
+        0x34, 0x00, 0x72, 0x08, 0xd5, 0xb8, 0x87, 0x18, 0x58, 0x65
+    };
+
+    auto pseudorandom_key = MUST(Crypto::Hash::HKDF::extract<HMACSHA256>(salt, input_keying_material));
+    EXPECT_EQ(pseudorandom_key, expected_pseudorandom_key.span());
+
+    auto output_keying_material = MUST(Crypto::Hash::HKDF::expand<HMACSHA256>(pseudorandom_key, info, 42));
+    EXPECT_EQ(output_keying_material, expected_output_keying_material.span());
+
+    auto derived_key = MUST(Crypto::Hash::HKDF::derive_key<HMACSHA256>(salt, input_keying_material, info, 42));
+    EXPECT_EQ(derived_key, expected_output_keying_material.span());
+}
+
+// https://www.rfc-editor.org/rfc/rfc5869#appendix-A.2
+TEST_CASE(test_case_2_sha256)
+{
+    Array<u8, 80> const input_keying_material {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+        0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+        0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+        0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+        0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f
+    };
+    Array<u8, 80> const salt {
+        0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+        0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+        0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+        0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+        0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf
+    };
+    Array<u8, 80> const info {
+        0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+        0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+        0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+        0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+        0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+    };
+    Array<u8, 32> const expected_pseudorandom_key {
+        0x06, 0xa6, 0xb8, 0x8c, 0x58, 0x53, 0x36, 0x1a, 0x06, 0x10, 0x4c, 0x9c, 0xeb, 0x35, 0xb4, 0x5c,
+        0xef, 0x76, 0x00, 0x14, 0x90, 0x46, 0x71, 0x01, 0x4a, 0x19, 0x3f, 0x40, 0xc1, 0x5f, 0xc2, 0x44
+    };
+    Array<u8, 82> const expected_output_keying_material {
+        0xb1, 0x1e, 0x39, 0x8d, 0xc8, 0x03, 0x27, 0xa1, 0xc8, 0xe7, 0xf7, 0x8c, 0x59, 0x6a, 0x49, 0x34,
+        0x4f, 0x01, 0x2e, 0xda, 0x2d, 0x4e, 0xfa, 0xd8, 0xa0, 0x50, 0xcc, 0x4c, 0x19, 0xaf, 0xa9, 0x7c,
+        0x59, 0x04, 0x5a, 0x99, 0xca, 0xc7, 0x82, 0x72, 0x71, 0xcb, 0x41, 0xc6, 0x5e, 0x59, 0x0e, 0x09,
+        0xda, 0x32, 0x75, 0x60, 0x0c, 0x2f, 0x09, 0xb8, 0x36, 0x77, 0x93, 0xa9, 0xac, 0xa3, 0xdb, 0x71,
+        0xcc, 0x30, 0xc5, 0x81, 0x79, 0xec, 0x3e, 0x87, 0xc1, 0x4c, 0x01, 0xd5, 0xc1, 0xf3, 0x43, 0x4f,
+        0x1d, 0x87
+    };
+
+    auto pseudorandom_key = MUST(Crypto::Hash::HKDF::extract<HMACSHA256>(salt, input_keying_material));
+    EXPECT_EQ(pseudorandom_key, expected_pseudorandom_key.span());
+
+    auto output_keying_material = MUST(Crypto::Hash::HKDF::expand<HMACSHA256>(pseudorandom_key, info, 82));
+    EXPECT_EQ(output_keying_material, expected_output_keying_material.span());
+
+    auto derived_key = MUST(Crypto::Hash::HKDF::derive_key<HMACSHA256>(salt, input_keying_material, info, 82));
+    EXPECT_EQ(derived_key, expected_output_keying_material.span());
+}
+
+// https://www.rfc-editor.org/rfc/rfc5869#appendix-A.3
+TEST_CASE(test_case_3_sha256)
+{
+    Array<u8, 22> const input_keying_material {
+        0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+        0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b
+    };
+    Array<u8, 32> const expected_pseudorandom_key {
+        0x19, 0xef, 0x24, 0xa3, 0x2c, 0x71, 0x7b, 0x16, 0x7f, 0x33, 0xa9, 0x1d, 0x6f, 0x64, 0x8b, 0xdf,
+        0x96, 0x59, 0x67, 0x76, 0xaf, 0xdb, 0x63, 0x77, 0xac, 0x43, 0x4c, 0x1c, 0x29, 0x3c, 0xcb, 0x04
+    };
+    Array<u8, 42> const expected_output_keying_material {
+        0x8d, 0xa4, 0xe7, 0x75, 0xa5, 0x63, 0xc1, 0x8f, 0x71, 0x5f, 0x80, 0x2a, 0x06, 0x3c, 0x5a, 0x31,
+        0xb8, 0xa1, 0x1f, 0x5c, 0x5e, 0xe1, 0x87, 0x9e, 0xc3, 0x45, 0x4e, 0x5f, 0x3c, 0x73, 0x8d, 0x2d,
+        0x9d, 0x20, 0x13, 0x95, 0xfa, 0xa4, 0xb6, 0x1a, 0x96, 0xc8
+    };
+
+    auto pseudorandom_key = MUST(Crypto::Hash::HKDF::extract<HMACSHA256>(ReadonlyBytes {}, input_keying_material));
+    EXPECT_EQ(pseudorandom_key, expected_pseudorandom_key.span());
+
+    auto output_keying_material = MUST(Crypto::Hash::HKDF::expand<HMACSHA256>(pseudorandom_key, ReadonlyBytes {}, 42));
+    EXPECT_EQ(output_keying_material, expected_output_keying_material.span());
+
+    auto derived_key = MUST(Crypto::Hash::HKDF::derive_key<HMACSHA256>(ReadonlyBytes {}, input_keying_material, ReadonlyBytes {}, 42));
+    EXPECT_EQ(derived_key, expected_output_keying_material.span());
+}
+
+// The first steps of the TLS 1.3 key schedule in the simple 1-RTT handshake, which feed HKDF the HkdfLabel structures
+// as info.
+// https://www.rfc-editor.org/rfc/rfc8448#section-3
+TEST_CASE(rfc8448_key_schedule_sha256)
+{
+    Array<u8, 32> const zeros {};
+    Array<u8, 32> const expected_early_secret {
+        0x33, 0xad, 0x0a, 0x1c, 0x60, 0x7e, 0xc0, 0x3b, 0x09, 0xe6, 0xcd, 0x98, 0x93, 0x68, 0x0c, 0xe2,
+        0x10, 0xad, 0xf3, 0x00, 0xaa, 0x1f, 0x26, 0x60, 0xe1, 0xb2, 0x2e, 0x10, 0xf1, 0x70, 0xf9, 0x2a
+    };
+    // HkdfLabel { 32, "tls13 derived", SHA-256("") }
+    Array<u8, 49> const derived_info {
+        0x00, 0x20, 0x0d, 0x74, 0x6c, 0x73, 0x31, 0x33, 0x20, 0x64, 0x65, 0x72, 0x69, 0x76, 0x65, 0x64,
+        0x20, 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9,
+        0x24, 0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8,
+        0x55
+    };
+    Array<u8, 32> const expected_derived_secret {
+        0x6f, 0x26, 0x15, 0xa1, 0x08, 0xc7, 0x02, 0xc5, 0x67, 0x8f, 0x54, 0xfc, 0x9d, 0xba, 0xb6, 0x97,
+        0x16, 0xc0, 0x76, 0x18, 0x9c, 0x48, 0x25, 0x0c, 0xeb, 0xea, 0xc3, 0x57, 0x6c, 0x36, 0x11, 0xba
+    };
+    // The (EC)DHE shared secret of the client's and the server's x25519 key shares.
+    Array<u8, 32> const shared_secret {
+        0x8b, 0xd4, 0x05, 0x4f, 0xb5, 0x5b, 0x9d, 0x63, 0xfd, 0xfb, 0xac, 0xf9, 0xf0, 0x4b, 0x9f, 0x0d,
+        0x35, 0xe6, 0xd6, 0x3f, 0x53, 0x75, 0x63, 0xef, 0xd4, 0x62, 0x72, 0x90, 0x0f, 0x89, 0x49, 0x2d
+    };
+    Array<u8, 32> const expected_handshake_secret {
+        0x1d, 0xc8, 0x26, 0xe9, 0x36, 0x06, 0xaa, 0x6f, 0xdc, 0x0a, 0xad, 0xc1, 0x2f, 0x74, 0x1b, 0x01,
+        0x04, 0x6a, 0xa6, 0xb9, 0x9f, 0x69, 0x1e, 0xd2, 0x21, 0xa9, 0xf0, 0xca, 0x04, 0x3f, 0xbe, 0xac
+    };
+
+    auto early_secret = MUST(Crypto::Hash::HKDF::extract<HMACSHA256>(ReadonlyBytes {}, zeros));
+    EXPECT_EQ(early_secret, expected_early_secret.span());
+
+    auto derived_secret = MUST(Crypto::Hash::HKDF::expand<HMACSHA256>(early_secret, derived_info, 32));
+    EXPECT_EQ(derived_secret, expected_derived_secret.span());
+
+    auto handshake_secret = MUST(Crypto::Hash::HKDF::extract<HMACSHA256>(derived_secret, shared_secret));
+    EXPECT_EQ(handshake_secret, expected_handshake_secret.span());
+}
+
+TEST_CASE(output_too_long)
+{
+    Array<u8, 32> const pseudorandom_key {};
+    EXPECT(!Crypto::Hash::HKDF::expand<HMACSHA256>(pseudorandom_key, ReadonlyBytes {}, 255 * 32).is_error());
+    EXPECT(Crypto::Hash::HKDF::expand<HMACSHA256>(pseudorandom_key, ReadonlyBytes {}, 255 * 32 + 1).is_error());
+}
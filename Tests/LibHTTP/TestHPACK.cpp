@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Hex.h>
+#include <LibHTTP/HPACK.h>
+#include <LibTest/TestCase.h>
+
+static ByteBuffer bytes_from_hex(StringView hex)
+{
+    return MUST(decode_hex(hex.replace(" "sv, ""sv, ReplaceMode::All)));
+}
+
+static void expect_headers(Vector<HTTP::HPACK::Header> const& headers, Vector<HTTP::HPACK::Header> const& expected_headers)
+{
+    EXPECT_EQ(headers.size(), expected_headers.size());
+    for (size_t i = 0; i < min(headers.size(), expected_headers.size()); ++i) {
+        EXPECT_EQ(headers[i].name, expected_headers[i].name);
+        EXPECT_EQ(headers[i].value, expected_headers[i].value);
+    }
+}
+
+// https://www.rfc-editor.org/rfc/rfc7541#appendix-C.3
+TEST_CASE(decode_requests_without_huffman_coding)
+{
+    HTTP::HPACK::Decoder decoder;
+
+    auto headers = TRY_OR_FAIL(decoder.decode(bytes_from_hex("8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d"sv)));
+    expect_headers(headers, { { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" }, { ":authority", "www.example.com" } });
+
+    headers = TRY_OR_FAIL(decoder.decode(bytes_from_hex("8286 84be 5808 6e6f 2d63 6163 6865"sv)));
+    expect_headers(headers, { { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" }, { ":authority", "www.example.com" }, { "cache-control", "no-cache" } });
+
+    headers = TRY_OR_FAIL(decoder.decode(bytes_from_hex("8287 85bf 400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d 7661 6c75 65"sv)));
+    expect_headers(headers, { { ":method", "GET" }, { ":scheme", "https" }, { ":path", "/index.html" }, { ":authority", "www.example.com" }, { "custom-key", "custom-value" } });
+}
+
+// https://www.rfc-editor.org/rfc/rfc7541#appendix-C.4
+TEST_CASE(decode_requests_with_huffman_coding)
+{
+    HTTP::HPACK::Decoder decoder;
+
+    auto headers = TRY_OR_FAIL(decoder.decode(bytes_from_hex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"sv)));
+    expect_headers(headers, { { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" }, { ":authority", "www.example.com" } });
+
+    headers = TRY_OR_FAIL(decoder.decode(bytes_from_hex("8286 84be 5886 a8eb 1064 9cbf"sv)));
+    expect_headers(headers, { { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" }, { ":authority", "www.example.com" }, { "cache-control", "no-cache" } });
+
+    headers = TRY_OR_FAIL(decoder.decode(bytes_from_hex("8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf"sv)));
+    expect_headers(headers, { { ":method", "GET" }, { ":scheme", "https" }, { ":path", "/index.html" }, { ":authority", "www.example.com" }, { "custom-key", "custom-value" } });
+}
+
+// https://www.rfc-editor.org/rfc/rfc7541#appendix-C.6
+TEST_CASE(decode_responses_with_eviction)
+{
+    HTTP::HPACK::Decoder decoder { 256 };
+
+    auto headers = TRY_OR_FAIL(decoder.decode(bytes_from_hex("4882 6402 5885 aec3 771a 4b61 96d0 7abe 9410 54d4 44a8 2005 9504 0b81 66e0 82a6 2d1b ff6e 919d 29ad 1718 63c7 8f0b 97c8 e9ae 82ae 43d3"sv)));
+    expect_headers(headers, { { ":status", "302" }, { "cache-control", "private" }, { "date", "Mon, 21 Oct 2013 20:13:21 GMT" }, { "location", "https://www.example.com" } });
+
+    headers = TRY_OR_FAIL(decoder.decode(bytes_from_hex("4883 640e ffc1 c0bf"sv)));
+    expect_headers(headers, { { ":status", "307" }, { "cache-control", "private" }, { "date", "Mon, 21 Oct 2013 20:13:21 GMT" }, { "location", "https://www.example.com" } });
+
+    headers = TRY_OR_FAIL(decoder.decode(bytes_from_hex("88c1 6196 d07a be94 1054 d444 a820 0595 040b 8166 e084 a62d 1bff c05a 839b d9ab 77ad 94e7 821d d7f2 e6c7 b335 dfdf cd5b 3960 d5af 2708 7f36 72c1 ab27 0fb5 291f 9587 3160 65c0 03ed 4ee5 b106 3d50 07"sv)));
+    expect_headers(headers, { { ":status", "200" }, { "cache-control", "private" }, { "date", "Mon, 21 Oct 2013 20:13:22 GMT" }, { "location", "https://www.example.com" }, { "content-encoding", "gzip" }, { "set-cookie", "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1" } });
+}
+
+TEST_CASE(encode_requests)
+{
+    HTTP::HPACK::Encoder encoder;
+
+    auto header_block = TRY_OR_FAIL(encoder.encode({ { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" }, { ":authority", "www.example.com" } }));
+    EXPECT_EQ(header_block, bytes_from_hex("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"sv));
+
+    header_block = TRY_OR_FAIL(encoder.encode({ { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" }, { ":authority", "www.example.com" }, { "cache-control", "no-cache" } }));
+    EXPECT_EQ(header_block, bytes_from_hex("8286 84be 5886 a8eb 1064 9cbf"sv));
+
+    header_block = TRY_OR_FAIL(encoder.encode({ { ":method", "GET" }, { ":scheme", "https" }, { ":path", "/index.html" }, { ":authority", "www.example.com" }, { "custom-key", "custom-value" } }));
+    EXPECT_EQ(header_block, bytes_from_hex("8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf"sv));
+}
+
+TEST_CASE(encoded_headers_round_trip)
+{
+    HTTP::HPACK::Encoder encoder;
+    HTTP::HPACK::Decoder decoder;
+
+    Vector<HTTP::HPACK::Header> headers {
+        { ":method", "POST" },
+        { ":path", "/api?q=%F0%9F%90%9E" },
+        { "authorization", "Bearer secret" },
+        { "x-binary", "\x01\x7f\xfe\xff" },
+        { "content-length", "12345" },
+    };
+    for (int i = 0; i < 3; ++i)
+        expect_headers(TRY_OR_FAIL(decoder.decode(TRY_OR_FAIL(encoder.encode(headers)))), headers);
+
+    encoder.set_maximum_table_size(0);
+    expect_headers(TRY_OR_FAIL(decoder.decode(TRY_OR_FAIL(encoder.encode(headers)))), headers);
+}
+
+TEST_CASE(reject_invalid_header_blocks)
+{
+    // Index 0.
+    EXPECT(HTTP::HPACK::Decoder {}.decode(bytes_from_hex("80"sv)).is_error());
+
+    // An index past the end of the dynamic table.
+    EXPECT(HTTP::HPACK::Decoder {}.decode(bytes_from_hex("be"sv)).is_error());
+
+    // A string longer than the header block.
+    EXPECT(HTTP::HPACK::Decoder {}.decode(bytes_from_hex("4005 6e61 6d65"sv)).is_error());
+
+    // Huffman padding of more than 7 bits.
+    EXPECT(HTTP::HPACK::Decoder {}.decode(bytes_from_hex("4082 1fff 0161"sv)).is_error());
+
+    // Huffman padding that isn't all ones.
+    EXPECT(HTTP::HPACK::Decoder {}.decode(bytes_from_hex("4081 1801 61"sv)).is_error());
+
+    // A dynamic table size update after a header.
+    EXPECT(HTTP::HPACK::Decoder {}.decode(bytes_from_hex("823f e11f"sv)).is_error());
+
+    // A dynamic table size update larger than the maximum.
+    EXPECT(HTTP::HPACK::Decoder { 256 }.decode(bytes_from_hex("3fe1 1f"sv)).is_error());
+
+    // An integer that doesn't end.
+    EXPECT(HTTP::HPACK::Decoder {}.decode(bytes_from_hex("ffff ffff ffff ffff ffff"sv)).is_error());
+}
@@ -0,0 +1,476 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/HashMap.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/Socket.h>
+#include <LibCore/TCPServer.h>
+#include <LibCore/Timer.h>
+#include <LibHTTP/HPACK.h>
+#include <LibHTTP/Http2Connection.h>
+#include <LibTest/TestCase.h>
+#include <LibURL/URL.h>
+
+// https://httpwg.org/specs/rfc9113.html
+// Just enough of an HTTP/2 server (without TLS, so "h2c") to answer the requests of one client connection.
+// Responses are held back until a number of requests have arrived, and are then sent in reverse order, a frame at a
+// time and in turn across streams, honoring the client's flow control.
+class TestServer {
+public:
+    struct Options {
+        u32 max_concurrent_streams { 100 };
+        size_t respond_after { 1 };
+    };
+
+    struct Request {
+        ByteString method;
+        ByteString path;
+        ByteString priority;
+        size_t body_size { 0 };
+    };
+
+    static ErrorOr<NonnullOwnPtr<TestServer>> create(Options options)
+    {
+        auto listener = TRY(Core::TCPServer::try_create());
+        TRY(listener->listen({ 127, 0, 0, 1 }, 0));
+        return adopt_nonnull_own_or_enomem(new (nothrow) TestServer(move(listener), options));
+    }
+
+    ErrorOr<NonnullRefPtr<HTTP::Http2Connection>> connect()
+    {
+        auto socket = TRY(Core::TCPSocket::connect({ { 127, 0, 0, 1 }, *m_listener->local_port() }));
+        return HTTP::Http2Connection::try_create(move(socket));
+    }
+
+    HTTP::HttpRequest request(StringView path, StringView accept = {}) const
+    {
+        HTTP::HttpRequest request;
+        request.set_url(URL::URL(ByteString::formatted("http://127.0.0.1:{}{}", *m_listener->local_port(), path)));
+        if (!accept.is_empty())
+            request.set_headers({ { "Accept", ByteString { accept } } });
+        return request;
+    }
+
+    size_t accepted_connection_count() const { return m_accepted_connection_count; }
+    size_t max_open_stream_count() const { return m_max_open_stream_count; }
+    Vector<Request> const& received_requests() const { return m_received_requests; }
+    Vector<u32> const& reset_stream_ids() const { return m_reset_stream_ids; }
+
+    // Closes the connection instead of answering the next requests.
+    void close_connection() { m_socket->close(); }
+    bool closes_on_request { false };
+
+private:
+    struct Stream {
+        Request request;
+        i64 send_window { 0 };
+        ByteBuffer response_body;
+        size_t response_body_offset { 0 };
+    };
+
+    TestServer(NonnullRefPtr<Core::TCPServer> listener, Options options)
+        : m_listener(move(listener))
+        , m_options(options)
+    {
+        m_listener->on_ready_to_accept = [this] {
+            m_socket = MUST(m_listener->accept());
+            ++m_accepted_connection_count;
+            m_socket->on_ready_to_read = [this] { read_from_socket(); };
+
+            u8 settings[6] = { 0, 3 };
+            write_u32(settings + 2, m_options.max_concurrent_streams);
+            send_frame(0x4, 0, 0, { settings, sizeof(settings) });
+        };
+    }
+
+    static void write_u32(u8* output, u32 value)
+    {
+        output[0] = value >> 24;
+        output[1] = value >> 16;
+        output[2] = value >> 8;
+        output[3] = value;
+    }
+
+    static u32 read_u32(ReadonlyBytes bytes)
+    {
+        return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+    }
+
+    void send_frame(u8 type, u8 flags, u32 stream_id, ReadonlyBytes payload)
+    {
+        u8 header[9] = { static_cast<u8>(payload.size() >> 16), static_cast<u8>(payload.size() >> 8), static_cast<u8>(payload.size()), type, flags };
+        write_u32(header + 5, stream_id);
+        MUST(m_socket->write_until_depleted({ header, sizeof(header) }));
+        MUST(m_socket->write_until_depleted(payload));
+    }
+
+    void send_window_update(u32 stream_id, u32 increment)
+    {
+        u8 payload[4];
+        write_u32(payload, increment);
+        send_frame(0x8, 0, stream_id, { payload, sizeof(payload) });
+    }
+
+    void read_from_socket()
+    {
+        while (MUST(m_socket->can_read_without_blocking())) {
+            u8 buffer[16384];
+            auto bytes = MUST(m_socket->read_some({ buffer, sizeof(buffer) }));
+            if (bytes.is_empty()) {
+                m_socket->on_ready_to_read = nullptr;
+                return;
+            }
+            m_buffer.append(bytes);
+        }
+
+        if (!m_has_received_preface) {
+            if (m_buffer.size() < 24)
+                return;
+            VERIFY(StringView { m_buffer.bytes().slice(0, 24) } == "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"sv);
+            m_buffer = MUST(m_buffer.slice(24, m_buffer.size() - 24));
+            m_has_received_preface = true;
+        }
+
+        while (m_buffer.size() >= 9) {
+            u32 length = (m_buffer[0] << 16) | (m_buffer[1] << 8) | m_buffer[2];
+            if (m_buffer.size() < 9 + length)
+                break;
+            auto type = m_buffer[3];
+            auto flags = m_buffer[4];
+            auto stream_id = read_u32(m_buffer.bytes().slice(5)) & 0x7fffffff;
+            auto payload = MUST(ByteBuffer::copy(m_buffer.bytes().slice(9, length)));
+            m_buffer = MUST(m_buffer.slice(9 + length, m_buffer.size() - 9 - length));
+            handle_frame(type, flags, stream_id, payload);
+            if (!m_socket->is_open())
+                return;
+        }
+    }
+
+    void handle_frame(u8 type, u8 flags, u32 stream_id, ReadonlyBytes payload)
+    {
+        switch (type) {
+        case 0x0: {
+            auto& stream = *m_streams.get(stream_id).value();
+            stream.request.body_size += payload.size();
+            if (!payload.is_empty()) {
+                send_window_update(0, payload.size());
+                send_window_update(stream_id, payload.size());
+            }
+            if (flags & 0x1)
+                did_receive_request(stream_id);
+            break;
+        }
+        case 0x1: {
+            // NOTE: The client only sends CONTINUATION frames for header blocks far larger than any in these tests.
+            VERIFY(flags & 0x4);
+            auto headers = MUST(m_decoder.decode(payload));
+
+            Stream stream;
+            stream.send_window = m_initial_window_size;
+            for (auto& header : headers) {
+                if (header.name == ":method"sv)
+                    stream.request.method = header.value;
+                else if (header.name == ":path"sv)
+                    stream.request.path = header.value;
+                else if (header.name == "priority"sv)
+                    stream.request.priority = header.value;
+            }
+            m_streams.set(stream_id, make<Stream>(move(stream)));
+            m_max_open_stream_count = max(m_max_open_stream_count, m_streams.size());
+            if (flags & 0x1)
+                did_receive_request(stream_id);
+            break;
+        }
+        case 0x3:
+            m_reset_stream_ids.append(stream_id);
+            m_streams.remove(stream_id);
+            m_responding_stream_ids.remove_all_matching([&](auto id) { return id == stream_id; });
+            break;
+        case 0x4:
+            if (flags & 0x1)
+                break;
+            for (size_t i = 0; i + 6 <= payload.size(); i += 6) {
+                if (payload[i] == 0 && payload[i + 1] == 4)
+                    m_initial_window_size = read_u32(payload.slice(i + 2));
+            }
+            send_frame(0x4, 0x1, 0, {});
+            break;
+        case 0x8: {
+            auto increment = read_u32(payload) & 0x7fffffff;
+            if (stream_id == 0)
+                m_connection_send_window += increment;
+            else if (auto stream = m_streams.get(stream_id); stream.has_value())
+                (*stream)->send_window += increment;
+            schedule_sending_response_bodies();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void did_receive_request(u32 stream_id)
+    {
+        m_received_requests.append(m_streams.get(stream_id).value()->request);
+        if (closes_on_request) {
+            close_connection();
+            return;
+        }
+
+        m_requests_awaiting_response.append(stream_id);
+        if (m_requests_awaiting_response.size() < m_options.respond_after)
+            return;
+
+        for (auto id : m_requests_awaiting_response.in_reverse())
+            respond(id);
+        m_requests_awaiting_response.clear();
+    }
+
+    void respond(u32 stream_id)
+    {
+        auto& stream = *m_streams.get(stream_id).value();
+        auto const& request = stream.request;
+
+        if (request.method == "POST"sv) {
+            auto body = ByteString::formatted("received {} bytes", request.body_size);
+            stream.response_body = MUST(ByteBuffer::copy(body.bytes()));
+        } else if (request.path.starts_with("/bytes/"sv)) {
+            auto size = request.path.substring_view(7).to_number<size_t>().value();
+            stream.response_body = MUST(ByteBuffer::create_uninitialized(size));
+            for (size_t i = 0; i < size; ++i)
+                stream.response_body[i] = i % 251;
+        } else {
+            stream.response_body = MUST(ByteBuffer::copy(request.path.bytes()));
+        }
+
+        auto header_block = MUST(m_encoder.encode({ { ":status", "200" }, { "content-length", ByteString::number(stream.response_body.size()) } }));
+        send_frame(0x1, 0x4, stream_id, header_block);
+        m_responding_stream_ids.append(stream_id);
+        schedule_sending_response_bodies();
+    }
+
+    void schedule_sending_response_bodies()
+    {
+        if (m_is_sending_scheduled)
+            return;
+        m_is_sending_scheduled = true;
+        Core::deferred_invoke([this] {
+            m_is_sending_scheduled = false;
+            send_response_bodies();
+        });
+    }
+
+    // Sends one DATA frame per turn of the event loop, so neither end blocks on writing to the other.
+    void send_response_bodies()
+    {
+        for (size_t i = 0; i < m_responding_stream_ids.size(); ++i) {
+            auto stream_id = m_responding_stream_ids[i];
+            auto& stream = *m_streams.get(stream_id).value();
+
+            auto remaining = stream.response_body.size() - stream.response_body_offset;
+            auto size = min<i64>(min<i64>(remaining, 16384), min(stream.send_window, m_connection_send_window));
+            if (size <= 0 && remaining > 0)
+                continue;
+
+            send_frame(0x0, size == static_cast<i64>(remaining) ? 0x1 : 0x0, stream_id, stream.response_body.bytes().slice(stream.response_body_offset, size));
+            stream.response_body_offset += size;
+            stream.send_window -= size;
+            m_connection_send_window -= size;
+
+            m_responding_stream_ids.remove(i);
+            if (stream.response_body_offset == stream.response_body.size())
+                m_streams.remove(stream_id);
+            else
+                m_responding_stream_ids.append(stream_id);
+
+            schedule_sending_response_bodies();
+            return;
+        }
+    }
+
+    NonnullRefPtr<Core::TCPServer> m_listener;
+    Options m_options;
+    OwnPtr<Core::TCPSocket> m_socket;
+    size_t m_accepted_connection_count { 0 };
+
+    ByteBuffer m_buffer;
+    bool m_has_received_preface { false };
+    HTTP::HPACK::Decoder m_decoder;
+    HTTP::HPACK::Encoder m_encoder;
+
+    HashMap<u32, NonnullOwnPtr<Stream>> m_streams;
+    size_t m_max_open_stream_count { 0 };
+    Vector<Request> m_received_requests;
+    Vector<u32> m_requests_awaiting_response;
+    Vector<u32> m_responding_stream_ids;
+    Vector<u32> m_reset_stream_ids;
+
+    i64 m_initial_window_size { 65535 };
+    i64 m_connection_send_window { 65535 };
+    bool m_is_sending_scheduled { false };
+};
+
+struct Response {
+    ByteString status;
+    ByteBuffer body;
+    bool is_finished { false };
+    Optional<Core::NetworkJob::Error> error;
+};
+
+static HTTP::Http2Connection::StreamCallbacks callbacks_for(Response& response)
+{
+    return {
+        .on_headers = [&response](auto const& headers, bool end_stream) {
+            for (auto const& header : headers) {
+                if (header.name == ":status"sv)
+                    response.status = header.value;
+            }
+            if (end_stream)
+                response.is_finished = true;
+        },
+        .on_data = [&response](auto bytes, bool end_stream) {
+            response.body.append(bytes);
+            if (end_stream)
+                response.is_finished = true;
+        },
+        .on_error = [&response](auto error) {
+            response.error = error;
+            response.is_finished = true;
+        },
+    };
+}
+
+static bool wait_for(ReadonlySpan<Response> responses)
+{
+    bool has_timed_out = false;
+    auto timer = Core::Timer::create_single_shot(5000, [&] { has_timed_out = true; });
+    timer->start();
+    Core::EventLoop::current().spin_until([&] {
+        return has_timed_out || all_of(responses, [](auto const& response) { return response.is_finished; });
+    });
+    return !has_timed_out;
+}
+
+TEST_CASE(requests_are_multiplexed_on_one_connection)
+{
+    Core::EventLoop event_loop;
+    auto server = TRY_OR_FAIL(TestServer::create({ .respond_after = 20 }));
+    auto connection = TRY_OR_FAIL(server->connect());
+
+    Vector<Response> responses;
+    responses.resize(20);
+    for (size_t i = 0; i < responses.size(); ++i)
+        connection->open_stream(server->request(ByteString::formatted("/resource/{}", i)), callbacks_for(responses[i]));
+    EXPECT_EQ(connection->stream_count(), 20u);
+
+    EXPECT(wait_for(responses));
+    for (size_t i = 0; i < responses.size(); ++i) {
+        EXPECT(!responses[i].error.has_value());
+        EXPECT_EQ(responses[i].status, "200"sv);
+        EXPECT_EQ(StringView { responses[i].body }, ByteString::formatted("/resource/{}", i));
+    }
+
+    // All of the requests were in flight at once, on a single connection.
+    EXPECT_EQ(server->accepted_connection_count(), 1u);
+    EXPECT_EQ(server->max_open_stream_count(), 20u);
+    EXPECT_EQ(connection->stream_count(), 0u);
+    EXPECT(connection->is_usable());
+}
+
+TEST_CASE(waiting_streams_open_most_urgent_first)
+{
+    Core::EventLoop event_loop;
+    auto server = TRY_OR_FAIL(TestServer::create({ .max_concurrent_streams = 1 }));
+    auto connection = TRY_OR_FAIL(server->connect());
+
+    // Have the server's settings arrive first.
+    Vector<Response> responses;
+    responses.resize(5);
+    connection->open_stream(server->request("/first"sv), callbacks_for(responses[0]));
+    EXPECT(wait_for(responses.span().slice(0, 1)));
+
+    connection->open_stream(server->request("/script"sv), callbacks_for(responses[1]));
+    connection->open_stream(server->request("/image"sv, "image/avif,image/webp,*/*"sv), callbacks_for(responses[2]));
+    connection->open_stream(server->request("/style"sv, "text/css,*/*;q=0.1"sv), callbacks_for(responses[3]));
+    connection->open_stream(server->request("/document"sv, "text/html,*/*"sv), callbacks_for(responses[4]));
+    EXPECT(wait_for(responses));
+
+    Vector<StringView> paths;
+    for (auto const& request : server->received_requests())
+        paths.append(request.path);
+    EXPECT_EQ(paths, (Vector<StringView> { "/first"sv, "/script"sv, "/document"sv, "/style"sv, "/image"sv }));
+    EXPECT_EQ(server->received_requests()[2].priority, "u=0"sv);
+    EXPECT_EQ(server->received_requests()[4].priority, "u=5, i"sv);
+    EXPECT_EQ(server->max_open_stream_count(), 1u);
+}
+
+TEST_CASE(bodies_larger_than_the_flow_control_windows)
+{
+    Core::EventLoop event_loop;
+    auto server = TRY_OR_FAIL(TestServer::create({ .respond_after = 2 }));
+    auto connection = TRY_OR_FAIL(server->connect());
+
+    auto post = server->request("/upload"sv);
+    post.set_method(HTTP::HttpRequest::Method::POST);
+    post.set_body(TRY_OR_FAIL(ByteBuffer::create_zeroed(200 * KiB)));
+
+    Vector<Response> responses;
+    responses.resize(2);
+    connection->open_stream(post, callbacks_for(responses[0]));
+    connection->open_stream(server->request("/bytes/3000000"sv), callbacks_for(responses[1]));
+    EXPECT(wait_for(responses));
+
+    EXPECT_EQ(StringView { responses[0].body }, "received 204800 bytes"sv);
+
+    EXPECT(!responses[1].error.has_value());
+    EXPECT_EQ(responses[1].body.size(), 3000000u);
+    bool is_intact = true;
+    for (size_t i = 0; i < responses[1].body.size(); ++i)
+        is_intact &= responses[1].body[i] == i % 251;
+    EXPECT(is_intact);
+}
+
+TEST_CASE(cancelled_streams_are_reset)
+{
+    Core::EventLoop event_loop;
+    auto server = TRY_OR_FAIL(TestServer::create({ .respond_after = 2 }));
+    auto connection = TRY_OR_FAIL(server->connect());
+
+    Vector<Response> responses;
+    responses.resize(2);
+    auto cancelled_stream = connection->open_stream(server->request("/bytes/1000000"sv), callbacks_for(responses[0]));
+    connection->open_stream(server->request("/bytes/1000000"sv), callbacks_for(responses[1]));
+
+    Core::EventLoop::current().spin_until([&] { return !responses[0].body.is_empty() || responses[1].is_finished; });
+    connection->cancel_stream(cancelled_stream);
+    EXPECT(wait_for(responses.span().slice(1)));
+
+    EXPECT(!responses[0].is_finished);
+    EXPECT_EQ(responses[1].body.size(), 1000000u);
+    EXPECT_EQ(server->reset_stream_ids(), (Vector<u32> { 1 }));
+}
+
+TEST_CASE(streams_fail_when_the_connection_closes)
+{
+    Core::EventLoop event_loop;
+    auto server = TRY_OR_FAIL(TestServer::create({}));
+    auto connection = TRY_OR_FAIL(server->connect());
+
+    bool has_closed = false;
+    connection->on_close = [&] { has_closed = true; };
+
+    server->closes_on_request = true;
+    Vector<Response> responses;
+    responses.resize(2);
+    connection->open_stream(server->request("/a"sv), callbacks_for(responses[0]));
+    connection->open_stream(server->request("/b"sv), callbacks_for(responses[1]));
+    EXPECT(wait_for(responses));
+
+    for (auto const& response : responses)
+        EXPECT(response.error.has_value());
+    Core::EventLoop::current().spin_until([&] { return has_closed; });
+    EXPECT(!connection->is_usable());
+}
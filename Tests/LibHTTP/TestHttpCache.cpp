@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/MemoryStream.h>
+#include <LibCore/System.h>
+#include <LibFileSystem/FileSystem.h>
+#include <LibHTTP/HttpCache.h>
+#include <LibTest/TestCase.h>
+#include <LibURL/URL.h>
+#include <stdlib.h>
+
+using RequestHeaders = HashMap<ByteString, ByteString>;
+using ResponseHeaders = HTTP::HttpCache::Headers;
+using Freshness = HTTP::HttpCache::Freshness;
+
+template<>
+struct AK::Formatter<Freshness> : Formatter<StringView> {
+    ErrorOr<void> format(FormatBuilder& builder, Freshness freshness)
+    {
+        return Formatter<StringView>::format(builder, freshness == Freshness::Fresh ? "Fresh"sv : "MustBeRevalidated"sv);
+    }
+};
+
+// The cache keeps its responses in the user's cache directory, so point that somewhere only the tests use.
+class TemporaryCacheDirectory {
+public:
+    TemporaryCacheDirectory()
+    {
+        char pattern[] = "/tmp/TestHttpCache.XXXXXX";
+        m_path = MUST(Core::System::mkdtemp(pattern));
+        VERIFY(setenv("XDG_CACHE_HOME", m_path.to_byte_string().characters(), 1) == 0);
+    }
+
+    ~TemporaryCacheDirectory()
+    {
+        (void)FileSystem::remove(m_path, FileSystem::RecursionMode::Allowed);
+    }
+
+private:
+    String m_path;
+};
+
+static HTTP::HttpCache& cache()
+{
+    static TemporaryCacheDirectory directory;
+    return HTTP::HttpCache::the();
+}
+
+// Each test uses URLs of its own, as the cache keeps one response per URL.
+static URL::URL url(StringView path)
+{
+    return URL::URL(ByteString::formatted("https://example.com/{}", path));
+}
+
+// Sends a response through a cache writer, the way RequestServer passes responses on to its clients.
+static void receive(URL::URL const& url, u32 status_code, ResponseHeaders const& response_headers, StringView body, RequestHeaders request_headers = {}, ByteString method = "GET")
+{
+    (void)cache();
+    AllocatingMemoryStream client;
+    HTTP::HttpCache::Writer writer { client, move(method), url, move(request_headers), {} };
+    writer.did_receive_response(status_code, response_headers);
+    MUST(writer.write_until_depleted(body.bytes()));
+    writer.did_finish(true);
+    EXPECT_EQ(client.used_buffer_size(), body.length());
+}
+
+static Optional<HTTP::HttpCache::Match> find(URL::URL const& url, RequestHeaders const& request_headers = {})
+{
+    return cache().find("GET", url, request_headers);
+}
+
+static Optional<Freshness> freshness_of(URL::URL const& url, RequestHeaders const& request_headers = {})
+{
+    auto match = find(url, request_headers);
+    if (!match.has_value())
+        return {};
+    return match->freshness;
+}
+
+static ByteString body_of(HTTP::HttpCache::CachedResponse const& response)
+{
+    auto file = MUST(cache().open_body(response));
+    auto body = MUST(file->read_until_eof());
+    return ByteString { body.bytes() };
+}
+
+TEST_CASE(fresh_responses_are_answered_from_the_cache)
+{
+    receive(url("fresh"sv), 200, { { "Cache-Control", "max-age=3600" }, { "Content-Type", "text/plain" } }, "Hello, cache!"sv);
+
+    auto match = find(url("fresh"sv));
+    VERIFY(match.has_value());
+    EXPECT_EQ(match->freshness, Freshness::Fresh);
+    EXPECT_EQ(match->response.status_code, 200u);
+    EXPECT_EQ(match->response.response_headers.get("content-type"sv), "text/plain"sv);
+    EXPECT_EQ(match->response.body_size, 13u);
+    EXPECT_EQ(body_of(match->response), "Hello, cache!"sv);
+
+    // The fragment isn't part of what's cached.
+    EXPECT_EQ(freshness_of(URL::URL("https://example.com/fresh#fragment"sv)), Freshness::Fresh);
+    EXPECT(!find(url("fresh?query"sv)).has_value());
+}
+
+TEST_CASE(max_age_takes_the_age_of_the_response_into_account)
+{
+    receive(url("max-age-0"sv), 200, { { "Cache-Control", "max-age=0" }, { "ETag", "\"0\"" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("max-age-0"sv)), Freshness::MustBeRevalidated);
+
+    // Both the Age header and a Date long before the response was received make the response older than its max-age.
+    receive(url("age"sv), 200, { { "Cache-Control", "max-age=3600" }, { "Age", "7200" }, { "ETag", "\"1\"" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("age"sv)), Freshness::MustBeRevalidated);
+
+    receive(url("old-date"sv), 200, { { "Cache-Control", "max-age=3600" }, { "Date", "Thu, 01 Jan 1998 00:00:00 GMT" }, { "ETag", "\"2\"" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("old-date"sv)), Freshness::MustBeRevalidated);
+
+    receive(url("young"sv), 200, { { "Cache-Control", "public, max-age=\"3600\"" }, { "Age", "60" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("young"sv)), Freshness::Fresh);
+
+    // A max-age that can't be understood makes the response stale.
+    receive(url("bad-max-age"sv), 200, { { "Cache-Control", "max-age=soon" }, { "ETag", "\"3\"" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("bad-max-age"sv)), Freshness::MustBeRevalidated);
+}
+
+TEST_CASE(expires_is_only_used_without_max_age)
+{
+    receive(url("expires-later"sv), 200, { { "Expires", "Fri, 01 Jan 2100 00:00:00 GMT" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("expires-later"sv)), Freshness::Fresh);
+
+    receive(url("expired"sv), 200, { { "Expires", "Thu, 01 Jan 1998 00:00:00 GMT" }, { "ETag", "\"0\"" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("expired"sv)), Freshness::MustBeRevalidated);
+
+    receive(url("max-age-over-expires"sv), 200, { { "Cache-Control", "max-age=3600" }, { "Expires", "Thu, 01 Jan 1998 00:00:00 GMT" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("max-age-over-expires"sv)), Freshness::Fresh);
+
+    // An Expires header that can't be understood means the response has already expired.
+    receive(url("bad-expires"sv), 200, { { "Expires", "0" }, { "ETag", "\"1\"" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("bad-expires"sv)), Freshness::MustBeRevalidated);
+}
+
+TEST_CASE(heuristic_freshness)
+{
+    // A tenth of the time since the response was last modified, which is years here.
+    receive(url("last-modified"sv), 200, { { "Last-Modified", "Thu, 01 Jan 1998 00:00:00 GMT" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("last-modified"sv)), Freshness::Fresh);
+
+    receive(url("last-modified-404"sv), 404, { { "Last-Modified", "Thu, 01 Jan 1998 00:00:00 GMT" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("last-modified-404"sv)), Freshness::Fresh);
+
+    // Only some status codes can be cached without being told how long they stay fresh.
+    receive(url("last-modified-302"sv), 302, { { "Last-Modified", "Thu, 01 Jan 1998 00:00:00 GMT" } }, "body"sv);
+    EXPECT(!find(url("last-modified-302"sv)).has_value());
+
+    // Without a Last-Modified header, the response is stale right away, but can still be revalidated.
+    receive(url("etag-only"sv), 200, { { "ETag", "\"0\"" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("etag-only"sv)), Freshness::MustBeRevalidated);
+}
+
+TEST_CASE(responses_that_would_never_be_used_are_not_stored)
+{
+    receive(url("no-freshness-or-validators"sv), 200, {}, "body"sv);
+    EXPECT(!find(url("no-freshness-or-validators"sv)).has_value());
+
+    receive(url("no-store"sv), 200, { { "Cache-Control", "max-age=3600, no-store" } }, "body"sv);
+    EXPECT(!find(url("no-store"sv)).has_value());
+
+    receive(url("request-no-store"sv), 200, { { "Cache-Control", "max-age=3600" } }, "body"sv, { { "Cache-Control", "no-store" } });
+    EXPECT(!find(url("request-no-store"sv)).has_value());
+
+    receive(url("partial"sv), 200, { { "Cache-Control", "max-age=3600" }, { "Content-Range", "bytes 0-3/10" } }, "body"sv);
+    EXPECT(!find(url("partial"sv)).has_value());
+
+    receive(url("head"sv), 200, { { "Cache-Control", "max-age=3600" } }, ""sv, {}, "HEAD");
+    EXPECT(!find(url("head"sv)).has_value());
+}
+
+TEST_CASE(no_cache_means_revalidating_fresh_responses)
+{
+    receive(url("response-no-cache"sv), 200, { { "Cache-Control", "no-cache, max-age=3600" }, { "ETag", "\"0\"" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("response-no-cache"sv)), Freshness::MustBeRevalidated);
+
+    receive(url("request-no-cache"sv), 200, { { "Cache-Control", "max-age=3600" }, { "ETag", "\"1\"" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("request-no-cache"sv)), Freshness::Fresh);
+    EXPECT_EQ(freshness_of(url("request-no-cache"sv), { { "Cache-Control", "no-cache" } }), Freshness::MustBeRevalidated);
+    EXPECT_EQ(freshness_of(url("request-no-cache"sv), { { "Pragma", "no-cache" } }), Freshness::MustBeRevalidated);
+
+    // Pragma only counts when there's no Cache-Control header.
+    EXPECT_EQ(freshness_of(url("request-no-cache"sv), { { "Cache-Control", "max-stale" }, { "Pragma", "no-cache" } }), Freshness::Fresh);
+
+    // Without validators, a response that needs to be revalidated can't be used at all.
+    receive(url("no-cache-without-validators"sv), 200, { { "Cache-Control", "max-age=3600" } }, "body"sv);
+    EXPECT(!find(url("no-cache-without-validators"sv), { { "Cache-Control", "no-cache" } }).has_value());
+}
+
+TEST_CASE(requests_that_bypass_the_cache)
+{
+    receive(url("bypass"sv), 200, { { "Cache-Control", "max-age=3600" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("bypass"sv)), Freshness::Fresh);
+
+    EXPECT(!cache().find("POST", url("bypass"sv), {}).has_value());
+    EXPECT(!cache().find("HEAD", url("bypass"sv), {}).has_value());
+    for (auto name : { "Authorization"sv, "Range"sv, "If-Match"sv, "If-None-Match"sv, "If-Modified-Since"sv, "If-Unmodified-Since"sv, "If-Range"sv })
+        EXPECT(!find(url("bypass"sv), { { name, "x" } }).has_value());
+    EXPECT(!find(url("bypass"sv), { { "Cache-Control", "no-store" } }).has_value());
+}
+
+TEST_CASE(vary)
+{
+    receive(url("vary"sv), 200, { { "Cache-Control", "max-age=3600" }, { "Vary", "Accept-Language" } }, "English"sv, { { "Accept-Language", "en" }, { "Accept", "text/html" } });
+
+    EXPECT_EQ(freshness_of(url("vary"sv), { { "Accept-Language", "en" } }), Freshness::Fresh);
+    // Header names aren't case sensitive, and the headers not named in Vary don't matter.
+    EXPECT_EQ(freshness_of(url("vary"sv), { { "accept-language", " en " }, { "Accept", "image/png" } }), Freshness::Fresh);
+    EXPECT(!find(url("vary"sv), { { "Accept-Language", "fr" } }).has_value());
+    EXPECT(!find(url("vary"sv)).has_value());
+
+    // A header the request that was answered didn't have can't be in later requests either.
+    receive(url("vary-missing-header"sv), 200, { { "Cache-Control", "max-age=3600" }, { "Vary", "Accept-Language" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("vary-missing-header"sv)), Freshness::Fresh);
+    EXPECT(!find(url("vary-missing-header"sv), { { "Accept-Language", "en" } }).has_value());
+
+    // Every header named in Vary has to match.
+    receive(url("vary-list"sv), 200, { { "Cache-Control", "max-age=3600" }, { "Vary", "Accept, Accept-Encoding" } }, "body"sv, { { "Accept", "text/html" }, { "Accept-Encoding", "gzip" } });
+    EXPECT_EQ(freshness_of(url("vary-list"sv), { { "Accept", "text/html" }, { "Accept-Encoding", "gzip" } }), Freshness::Fresh);
+    EXPECT(!find(url("vary-list"sv), { { "Accept", "text/html" }, { "Accept-Encoding", "br" } }).has_value());
+    EXPECT(!find(url("vary-list"sv), { { "Accept", "text/html" } }).has_value());
+
+    // A response that varies on anything at all can't be used for any other request, so it isn't stored.
+    receive(url("vary-star"sv), 200, { { "Cache-Control", "max-age=3600" }, { "Vary", "*" } }, "body"sv);
+    EXPECT(!find(url("vary-star"sv)).has_value());
+
+    // Storing the response to a request with other headers replaces the one that was there.
+    receive(url("vary"sv), 200, { { "Cache-Control", "max-age=3600" }, { "Vary", "Accept-Language" } }, "Français"sv, { { "Accept-Language", "fr" } });
+    auto match = find(url("vary"sv), { { "Accept-Language", "fr" } });
+    VERIFY(match.has_value());
+    EXPECT_EQ(body_of(match->response), "Français"sv);
+    EXPECT(!find(url("vary"sv), { { "Accept-Language", "en" } }).has_value());
+}
+
+TEST_CASE(revalidation)
+{
+    receive(url("revalidate"sv), 200, { { "Cache-Control", "max-age=0" }, { "ETag", "\"v1\"" }, { "Last-Modified", "Thu, 01 Jan 1998 00:00:00 GMT" }, { "X-Original", "yes" } }, "Original body"sv);
+
+    auto match = find(url("revalidate"sv));
+    VERIFY(match.has_value());
+    EXPECT_EQ(match->freshness, Freshness::MustBeRevalidated);
+
+    RequestHeaders request_headers;
+    HTTP::HttpCache::add_validators(match->response, request_headers);
+    EXPECT_EQ(request_headers.get("If-None-Match"sv), "\"v1\""sv);
+    EXPECT_EQ(request_headers.get("If-Modified-Since"sv), "Thu, 01 Jan 1998 00:00:00 GMT"sv);
+
+    // A 304 response freshens the stored response with its headers, and the client gets that instead. The writer gets
+    // the client's request headers, without the validators.
+    AllocatingMemoryStream client;
+    HTTP::HttpCache::Writer writer { client, "GET", url("revalidate"sv), {}, match->response };
+    writer.did_receive_response(304, { { "Cache-Control", "max-age=3600" }, { "Content-Length", "0" } });
+    writer.did_finish(true);
+
+    VERIFY(writer.has_revalidated_response());
+    auto revalidated_response = writer.take_revalidated_response();
+    VERIFY(revalidated_response.has_value());
+    EXPECT_EQ(revalidated_response->status_code, 200u);
+    EXPECT_EQ(revalidated_response->response_headers.get("Cache-Control"sv), "max-age=3600"sv);
+    EXPECT_EQ(revalidated_response->response_headers.get("X-Original"sv), "yes"sv);
+    EXPECT(!revalidated_response->response_headers.contains("Content-Length"sv));
+    EXPECT_EQ(body_of(*revalidated_response), "Original body"sv);
+
+    match = find(url("revalidate"sv));
+    VERIFY(match.has_value());
+    EXPECT_EQ(match->freshness, Freshness::Fresh);
+    EXPECT_EQ(body_of(match->response), "Original body"sv);
+
+    // Any other response replaces the stored one.
+    receive(url("revalidate"sv), 200, { { "Cache-Control", "max-age=3600" }, { "ETag", "\"v2\"" } }, "New body"sv);
+    match = find(url("revalidate"sv));
+    VERIFY(match.has_value());
+    EXPECT_EQ(match->response.response_headers.get("ETag"sv), "\"v2\""sv);
+    EXPECT_EQ(body_of(match->response), "New body"sv);
+}
+
+TEST_CASE(unsafe_methods_invalidate_stored_responses)
+{
+    receive(url("invalidate"sv), 200, { { "Cache-Control", "max-age=3600" } }, "body"sv);
+    EXPECT_EQ(freshness_of(url("invalidate"sv)), Freshness::Fresh);
+
+    // Only once they've succeeded.
+    receive(url("invalidate"sv), 500, {}, ""sv, {}, "POST");
+    EXPECT_EQ(freshness_of(url("invalidate"sv)), Freshness::Fresh);
+
+    receive(url("invalidate"sv), 204, {}, ""sv, {}, "POST");
+    EXPECT(!find(url("invalidate"sv)).has_value());
+}
+
+TEST_CASE(failed_responses_are_not_stored)
+{
+    (void)cache();
+    AllocatingMemoryStream client;
+    HTTP::HttpCache::Writer writer { client, "GET", url("failed"sv), {}, {} };
+    writer.did_receive_response(200, { { "Cache-Control", "max-age=3600" } });
+    MUST(writer.write_until_depleted("partial bo"sv.bytes()));
+    writer.did_finish(false);
+    EXPECT(!find(url("failed"sv)).has_value());
+}
@@ -9,9 +9,11 @@
 #include <AK/Debug.h>
 #include <AK/StringBuilder.h>
 #include <AK/Tuple.h>
+#include <LibJIT/Assembler.h>
 #include <LibRegex/Regex.h>
 #include <LibRegex/RegexDebug.h>
 #include <LibRegex/RegexMatcher.h>
+#include <LibThreading/Thread.h>
 #include <stdio.h>
 
 static ECMAScriptOptions match_test_api_options(ECMAScriptOptions const options)
@@ -1078,6 +1080,286 @@ TEST_CASE(optimizer_alternation)
     }
 }
 
+TEST_CASE(optimizer_literal_prefix)
+{
+    Array tests {
+        // Pattern, Subject, Expected matches
+        Tuple { "foo(bar|baz)+"sv, "xxfoo fobar foobazbar"sv, 1u },
+        Tuple { "(ab)c"sv, "aabcabcaab ab c abc"sv, 3u },
+        Tuple { "ab+"sv, "a ab abbb b"sv, 2u },
+        Tuple { "a\\d"sv, "a a1 aa2 a"sv, 2u },
+    };
+
+    for (auto& test : tests) {
+        Regex<ECMA262> re(test.get<0>());
+        auto result = re.search(test.get<1>());
+        EXPECT_EQ(result.count, test.get<2>());
+    }
+
+    // Case insensitive matching must not skip over differently cased prefixes.
+    Regex<ECMA262> re("foo\\d", ECMAScriptFlags::Insensitive);
+    auto result = re.search("xFOO1 foo2 Foo"sv);
+    EXPECT_EQ(result.count, 2u);
+    EXPECT_EQ(result.matches.first().view, "FOO1"sv);
+}
+
+TEST_CASE(optimizer_required_literal)
+{
+    struct _test {
+        StringView pattern;
+        Optional<StringView> literal_prefix;
+        Optional<StringView> required_literal;
+    };
+
+    _test const tests[] {
+        { "\\w+@example\\.com"sv, {}, "@example.com"sv },
+        { "\\d+px"sv, {}, "px"sv },
+        { "ab\\d+cdef"sv, "ab"sv, "cdef"sv },
+        { "(?:ab)*cd"sv, {}, "cd"sv },
+        { "x(?:ab)+cd"sv, "xab"sv, "cd"sv },
+        { "\\d(?:abc|abd)"sv, {}, "ab"sv },
+        // Alternatives and optional parts aren't required.
+        { "\\d(?:abc|xyz)"sv, {}, {} },
+        { "\\d(?:abc)?"sv, {}, {} },
+        // Lookarounds don't consume what they look at.
+        { "\\d(?=abc)"sv, {}, {} },
+    };
+
+    for (auto& test : tests) {
+        Regex<ECMA262> re(test.pattern);
+        auto& optimization_data = re.parser_result.optimization_data;
+        EXPECT_EQ(optimization_data.literal_prefix.map([](auto& literal) { return literal.view(); }), test.literal_prefix);
+        EXPECT_EQ(optimization_data.required_literal.map([](auto& literal) { return literal.view(); }), test.required_literal);
+    }
+
+    Array tests_with_subjects {
+        // Pattern, Subject, Expected matches
+        Tuple { "\\w+@example\\.com"sv, "mail me at a@example.com or b@example.org, c@example.com"sv, 2u },
+        Tuple { "\\d+px"sv, "10px 20em 30px 4"sv, 2u },
+        Tuple { "(?:ab)*cd"sv, "abcd cd abab"sv, 2u },
+        Tuple { "\\d+px"sv, "no lengths in here"sv, 0u },
+    };
+
+    for (auto& test : tests_with_subjects) {
+        Regex<ECMA262> re(test.get<0>(), (ECMAScriptFlags)regex::AllFlags::Global);
+        EXPECT_EQ(re.match(test.get<1>()).count, test.get<2>());
+
+        // UTF-16 subjects get the same treatment.
+        auto subject = MUST(AK::utf8_to_utf16(test.get<1>()));
+        Utf16View view { subject };
+        EXPECT_EQ(re.match(view).count, test.get<2>());
+    }
+
+    // The literal has to start on a code unit boundary, not just anywhere in the bytes of the subject.
+    Regex<ECMA262> re("\\d+px", (ECMAScriptFlags)regex::AllFlags::Global);
+    Vector<u16> subject { 0x7031, 0x7800, '2', 'p', 'x' };
+    Utf16View view { subject };
+    auto result = re.match(view);
+    EXPECT_EQ(result.count, 1u);
+    EXPECT_EQ(result.matches.first().view.length(), 3u);
+}
+
+TEST_CASE(compiled_pattern_cache)
+{
+    auto make_pattern = [] {
+        // Make sure the pattern doesn't share its storage with the one used for the first compilation.
+        StringBuilder builder;
+        builder.append("(?<key>[a-z]+)=(?<value>\\d+)"sv);
+        return builder.to_byte_string();
+    };
+
+    {
+        Regex<ECMA262> re(make_pattern());
+        EXPECT(re.has_match("a=1"sv));
+    }
+
+    // The second compilation comes from the cache, and must keep working after the first one is gone.
+    Regex<ECMA262> re(make_pattern());
+    auto result = re.match("key=42"sv);
+    EXPECT(result.success);
+    EXPECT_EQ(result.capture_group_matches.first()[0].capture_group_name, "key");
+    EXPECT_EQ(result.capture_group_matches.first()[1].view, "42"sv);
+
+    // Different flags must not share compiled patterns.
+    Regex<ECMA262> insensitive_re(make_pattern(), ECMAScriptFlags::Insensitive);
+    EXPECT(insensitive_re.has_match("KEY=42"sv));
+    EXPECT(!re.has_match("KEY=42"sv));
+}
+
+TEST_CASE(compiled_pattern_cache_eviction)
+{
+    Regex<ECMA262> hot_re("^hot(\\d+)$");
+
+    // Push a lot more patterns through the cache than it can hold, while keeping one of them in use.
+    for (size_t i = 0; i < 300; ++i) {
+        Regex<ECMA262> re(ByteString::formatted("^p{}-(\\d+)$", i));
+        EXPECT(re.has_match(ByteString::formatted("p{}-{}", i, i)));
+        EXPECT(!re.has_match(ByteString::formatted("p{}-x", i)));
+
+        Regex<ECMA262> hot_re_again("^hot(\\d+)$");
+        EXPECT(hot_re_again.has_match("hot42"sv));
+    }
+
+    auto result = hot_re.match("hot1234"sv);
+    EXPECT(result.success);
+    EXPECT_EQ(result.capture_group_matches.first()[0].view, "1234"sv);
+}
+
+TEST_CASE(compiled_pattern_cache_across_threads)
+{
+    // A Regex may be destroyed on another thread than the one it was compiled on, and each thread's cache goes away when
+    // the thread exits, so cached patterns must not share anything with the regexes compiled from them.
+    Optional<Regex<ECMA262>> ecma262_re;
+    Optional<Regex<PosixExtended>> posix_re;
+    Optional<Regex<ECMA262>> ecma262_cached_re;
+    Optional<Regex<PosixExtended>> posix_cached_re;
+
+    auto thread = Threading::Thread::construct([&] {
+        ecma262_re = Regex<ECMA262>("(?<key>[a-z]+)=(?<value>\\d+)");
+        posix_re = Regex<PosixExtended>("(?<key>[a-z]+)=(?<value>[0-9]+)");
+        ecma262_cached_re = Regex<ECMA262>("(?<key>[a-z]+)=(?<value>\\d+)");
+        posix_cached_re = Regex<PosixExtended>("(?<key>[a-z]+)=(?<value>[0-9]+)");
+        return 0;
+    });
+    thread->start();
+    (void)TRY_OR_FAIL(thread->join());
+
+    // Compile the same patterns on this thread while the ones from the other thread are still around.
+    Regex<ECMA262> local_re("(?<key>[a-z]+)=(?<value>\\d+)");
+    EXPECT(local_re.has_match("a=1"sv));
+
+    ecma262_re.clear();
+    posix_re.clear();
+
+    auto check = [](auto& re) {
+        auto result = re.match("key=42"sv);
+        EXPECT(result.success);
+        EXPECT_EQ(result.capture_group_matches.first()[0].capture_group_name, "key");
+        EXPECT_EQ(result.capture_group_matches.first()[1].capture_group_name, "value");
+        EXPECT_EQ(result.capture_group_matches.first()[1].view, "42"sv);
+    };
+    check(*ecma262_cached_re);
+    check(*posix_cached_re);
+    check(local_re);
+}
+
+TEST_CASE(match_with_scratch_state)
+{
+    struct _test {
+        StringView pattern;
+        StringView subject;
+        bool matches;
+    };
+
+    constexpr _test tests[] {
+        { "^(a+)+$"sv, "aaaaaaaaaaaa"sv, true },
+        { "^(a+)+$"sv, "aaaaaaaaaaab"sv, false },
+        { "(?:foo|bar)baz"sv, "barbaz"sv, true },
+        { "(?:foo|bar)baz"sv, "barfoo"sv, false },
+        { "(\\w+)@(\\w+)\\.com"sv, "bob@example.com"sv, true },
+        { "^$"sv, ""sv, true },
+        { "a{2,3}?b"sv, "aab"sv, true },
+    };
+
+    // One scratch state is good for any number of patterns and matches, as long as they take turns.
+    MatchScratchState scratch_state;
+    for (size_t round = 0; round < 3; ++round) {
+        for (auto& test : tests) {
+            Regex<ECMA262> re(test.pattern);
+            EXPECT_EQ(re.has_match(test.subject, scratch_state), test.matches);
+            EXPECT_EQ(re.has_match(test.subject, scratch_state), re.has_match(test.subject));
+
+            auto subject = MUST(AK::utf8_to_utf16(test.subject));
+            Utf16View view { subject };
+            EXPECT_EQ(re.has_match(view, scratch_state), test.matches);
+        }
+    }
+
+    // Scratch state does not change how stateful patterns carry over their position.
+    Regex<ECMA262> global_re("a+"sv, (ECMAScriptFlags)regex::AllFlags::Global);
+    Regex<ECMA262> reference_re("a+"sv, (ECMAScriptFlags)regex::AllFlags::Global);
+    for (auto subject : { "aab"sv, "baa"sv, "aab"sv, "bbb"sv, "aab"sv })
+        EXPECT_EQ(global_re.has_match(subject, scratch_state), reference_re.has_match(subject));
+}
+
+TEST_CASE(native_regex_matches_interpreter)
+{
+#if JIT_ARCH_SUPPORTED
+    struct _test {
+        StringView pattern;
+        bool expect_compiled;
+    };
+    constexpr _test patterns[] {
+        { "abc"sv, true },
+        { "a[b-d]+c"sv, true },
+        { "(?:ab|cd)*e"sv, true },
+        { "^\\d+$"sv, true },
+        { "[^a-z]\\w*?x"sv, true },
+        { "a.c"sv, true },
+        { "(?:a*)*b"sv, true },
+        { "(?:(?:a|b)*c?)*d"sv, true },
+        { "(a)b"sv, false },
+        { "a(?=b)"sv, false },
+    };
+    constexpr StringView inputs[] {
+        ""sv, "abc"sv, "abbbdc"sv, "ac"sv, "ababcde"sv, "cdcdx"sv, "12345"sv, "123a"sv, "A_zx"sv, "9x"sv, "a\nc"sv, "aaab"sv, "aaaa"sv,
+    };
+
+    Vector<u64> scratch;
+    for (auto& test : patterns) {
+        Regex<ECMA262> re(test.pattern);
+        auto native = regex::NativeRegex::try_compile(re.parser_result.bytecode, re.options());
+        EXPECT_EQ(native != nullptr, test.expect_compiled);
+        if (!native)
+            continue;
+
+        for (auto input : inputs) {
+            // match() only succeeds if the first successful path consumes the entire input.
+            auto result = re.match(input);
+            size_t end = 0;
+            auto native_result = native->execute(input, 0, end, scratch);
+            EXPECT_NE(native_result, regex::NativeRegex::Result::OutOfBacktrackingSpace);
+            EXPECT_EQ(native_result == regex::NativeRegex::Result::Matched && end == input.length(), result.success);
+        }
+    }
+#endif
+}
+
+TEST_CASE(native_regex_on_several_threads)
+{
+#if JIT_ARCH_SUPPORTED
+    // Each execution brings its own scratch space, so the same native code can run on several threads at once.
+    Regex<ECMA262> re("(?:ab|cd)*e"sv);
+    auto native = regex::NativeRegex::try_compile(re.parser_result.bytecode, re.options());
+    EXPECT(native);
+    if (!native)
+        return;
+
+    Atomic<size_t> mismatches { 0 };
+    Vector<NonnullRefPtr<Threading::Thread>> threads;
+    for (size_t i = 0; i < 4; ++i) {
+        threads.append(Threading::Thread::construct([&, i] {
+            Vector<u64> scratch;
+            for (size_t j = 0; j < 1000; ++j) {
+                // Both the length of the run and whether it matches at all differ between the threads.
+                auto input = ByteString::formatted("{}{}", ByteString::repeated("ab"sv, i + j % 7), (i + j) % 2 ? "e"sv : "x"sv);
+                size_t end = 0;
+                auto result = native->execute(input, 0, end, scratch);
+                auto matched = result == regex::NativeRegex::Result::Matched && end == input.length();
+                if (matched != input.ends_with('e'))
+                    ++mismatches;
+            }
+            return 0;
+        }));
+        threads.last()->start();
+    }
+    for (auto& thread : threads)
+        (void)TRY_OR_FAIL(thread->join());
+
+    EXPECT_EQ(mismatches.load(), 0u);
+#endif
+}
+
 TEST_CASE(posix_basic_dollar_is_end_anchor)
 {
     // Ensure that a dollar sign at the end only matches the end of the line.
@@ -123,6 +123,9 @@ constexpr static u32 pointers[] = {
 NonnullRefPtr<SQL::BTree> setup_btree(SQL::Serializer&);
 void insert_and_get_to_and_from_btree(int);
 void insert_into_and_scan_btree(int);
+void remove_from_and_search_btree(int);
+void remove_all_from_btree(int);
+void bulk_load_and_search_btree(int, double);
 
 NonnullRefPtr<SQL::BTree> setup_btree(SQL::Serializer& serializer)
 {
@@ -223,6 +226,210 @@ void insert_into_and_scan_btree(int num_keys)
     }
 }
 
+void remove_from_and_search_btree(int num_keys)
+{
+    ScopeGuard guard([]() { unlink("/tmp/test.db"); });
+    {
+        auto heap = MUST(SQL::Heap::create("/tmp/test.db"));
+        TRY_OR_FAIL(heap->open());
+        SQL::Serializer serializer(heap);
+        auto btree = setup_btree(serializer);
+
+        for (auto ix = 0; ix < num_keys; ix++) {
+            SQL::Key k(btree->descriptor());
+            k[0] = keys[ix];
+            k.set_block_index(pointers[ix]);
+            btree->insert(k);
+        }
+
+        // Remove every other key.
+        for (auto ix = 0; ix < num_keys; ix += 2) {
+            SQL::Key k(btree->descriptor());
+            k[0] = keys[ix];
+            k.set_block_index(pointers[ix]);
+            EXPECT(btree->remove(k));
+            EXPECT(!btree->remove(k));
+        }
+    }
+
+    {
+        auto heap = MUST(SQL::Heap::create("/tmp/test.db"));
+        TRY_OR_FAIL(heap->open());
+        SQL::Serializer serializer(heap);
+        auto btree = setup_btree(serializer);
+
+        for (auto ix = 0; ix < num_keys; ix++) {
+            SQL::Key k(btree->descriptor());
+            k[0] = keys[ix];
+
+            // Removed keys are gone from the tree.
+            EXPECT_EQ(btree->get(k).has_value(), ix % 2 == 1);
+
+            // The first key not less than a key that was in the tree is the key itself, or the next key that's left.
+            auto next_key_from = [&](int key, bool include_key) {
+                Optional<int> next_key;
+                for (auto other = 1; other < num_keys; other += 2) {
+                    if ((keys[other] > key || (include_key && keys[other] == key)) && (!next_key.has_value() || keys[other] < next_key.value()))
+                        next_key = keys[other];
+                }
+                return next_key;
+            };
+            auto iter = btree->lower_bound(k);
+            auto next_key = next_key_from(keys[ix], true);
+            if (next_key.has_value()) {
+                EXPECT(!iter.is_end());
+                EXPECT_EQ((*iter)[0].to_int<i32>(), next_key.value());
+                EXPECT_NE((*iter).block_index(), 0u);
+            } else {
+                EXPECT(iter.is_end());
+            }
+
+            // The first key not less than one more than that is the next key in the tree.
+            k[0] = keys[ix] + 1;
+            iter = btree->lower_bound(k);
+            next_key = next_key_from(keys[ix], false);
+            if (next_key.has_value()) {
+                EXPECT(!iter.is_end());
+                EXPECT_EQ((*iter)[0].to_int<i32>(), next_key.value());
+            } else {
+                EXPECT(iter.is_end());
+            }
+        }
+
+        // Iterating over the tree produces the keys that are left, in order.
+        int count = 0;
+        SQL::Tuple prev;
+        for (auto iter = btree->begin(); !iter.is_end(); iter++, count++) {
+            if (prev.size())
+                EXPECT(prev < *iter);
+            EXPECT_NE((*iter).block_index(), 0u);
+            prev = *iter;
+        }
+        EXPECT_EQ(count, num_keys / 2);
+    }
+}
+
+void remove_all_from_btree(int num_keys)
+{
+    ScopeGuard guard([]() { unlink("/tmp/test.db"); });
+    auto heap = MUST(SQL::Heap::create("/tmp/test.db"));
+    TRY_OR_FAIL(heap->open());
+    SQL::Serializer serializer(heap);
+    auto btree = setup_btree(serializer);
+
+    // Keys are inserted and removed in different orders, so that nodes all over the tree run empty.
+    auto make_key = [&](int ix, int stride) {
+        SQL::Key k(btree->descriptor());
+        auto value = static_cast<int>((static_cast<i64>(ix) * stride) % num_keys);
+        k[0] = value;
+        k.set_block_index(static_cast<u32>(value + 1));
+        return k;
+    };
+
+    auto count_keys = [&]() {
+        int count = 0;
+        SQL::Tuple prev;
+        for (auto iter = btree->begin(); !iter.is_end(); iter++, count++) {
+            if (prev.size())
+                EXPECT(prev < *iter);
+            prev = *iter;
+        }
+        return count;
+    };
+
+    for (auto round = 0; round < 2; ++round) {
+        for (auto ix = 0; ix < num_keys; ix++)
+            EXPECT(btree->insert(make_key(ix, 7919)));
+        EXPECT_EQ(count_keys(), num_keys);
+
+        for (auto ix = 0; ix < num_keys; ix++) {
+            auto k = make_key(ix, 104729);
+            EXPECT(btree->remove(k));
+            EXPECT(!btree->get(k).has_value());
+            if (ix == num_keys / 2)
+                EXPECT_EQ(count_keys(), num_keys - ix - 1);
+        }
+        EXPECT(btree->is_empty());
+        EXPECT(btree->begin().is_end());
+    }
+}
+
+void bulk_load_and_search_btree(int num_keys, double fill_factor)
+{
+    ScopeGuard guard([]() { unlink("/tmp/test.db"); });
+
+    // Keys are spread out, so that every other one can be inserted between them afterwards.
+    auto make_key = [](auto& btree, int value) {
+        SQL::Key k(btree->descriptor());
+        k[0] = value;
+        k.set_block_index(static_cast<u32>(value + 1));
+        return k;
+    };
+
+    {
+        auto heap = MUST(SQL::Heap::create("/tmp/test.db"));
+        TRY_OR_FAIL(heap->open());
+        SQL::Serializer serializer(heap);
+        auto btree = setup_btree(serializer);
+
+        Vector<SQL::Key> bulk_keys;
+        for (auto ix = num_keys - 1; ix >= 0; ix--)
+            bulk_keys.append(make_key(btree, ix * 2));
+
+        auto duplicate_keys = bulk_keys;
+        duplicate_keys.append(make_key(btree, 0));
+        EXPECT(!btree->bulk_load(move(duplicate_keys), fill_factor));
+        EXPECT(btree->is_empty());
+
+        EXPECT(btree->bulk_load(move(bulk_keys), fill_factor));
+        EXPECT(!btree->is_empty());
+        EXPECT(!btree->bulk_load({ make_key(btree, 1) }, fill_factor));
+
+        for (auto ix = 0; ix < num_keys; ix += 3)
+            EXPECT(btree->insert(make_key(btree, ix * 2 + 1)));
+        EXPECT(!btree->insert(make_key(btree, 0)));
+    }
+
+    {
+        auto heap = MUST(SQL::Heap::create("/tmp/test.db"));
+        TRY_OR_FAIL(heap->open());
+        SQL::Serializer serializer(heap);
+        auto btree = setup_btree(serializer);
+
+        Vector<int> expected;
+        for (auto ix = 0; ix < num_keys; ix++) {
+            expected.append(ix * 2);
+            if (ix % 3 == 0)
+                expected.append(ix * 2 + 1);
+        }
+
+        Vector<int> scanned;
+        for (auto iter = btree->begin(); !iter.is_end(); iter++) {
+            EXPECT_EQ((*iter).block_index(), static_cast<u32>((*iter)[0].to_int<i32>().value() + 1));
+            scanned.append((*iter)[0].to_int<i32>().value());
+        }
+        EXPECT_EQ(scanned, expected);
+
+        for (auto value : expected) {
+            SQL::Key k(btree->descriptor());
+            k[0] = value;
+            auto pointer = btree->get(k);
+            EXPECT(pointer.has_value());
+            EXPECT_EQ(pointer.value_or(0), static_cast<u32>(value + 1));
+
+            k[0] = value + 1;
+            auto iter = btree->lower_bound(k);
+            auto next = expected.find_first_index_if([&](auto other) { return other > value; });
+            if (next.has_value()) {
+                EXPECT(!iter.is_end());
+                EXPECT_EQ((*iter)[0].to_int<i32>(), expected[*next]);
+            } else {
+                EXPECT(iter.is_end());
+            }
+        }
+    }
+}
+
 TEST_CASE(btree_one_key)
 {
     insert_and_get_to_and_from_btree(1);
@@ -317,3 +524,39 @@ TEST_CASE(btree_scan_50_keys)
 {
     insert_into_and_scan_btree(50);
 }
+
+TEST_CASE(btree_remove_and_lower_bound_10_keys)
+{
+    remove_from_and_search_btree(10);
+}
+
+TEST_CASE(btree_remove_and_lower_bound_50_keys)
+{
+    remove_from_and_search_btree(50);
+}
+
+TEST_CASE(btree_remove_all_10_keys)
+{
+    remove_all_from_btree(10);
+}
+
+TEST_CASE(btree_remove_all_5000_keys)
+{
+    remove_all_from_btree(5000);
+}
+
+TEST_CASE(btree_bulk_load_one_key)
+{
+    bulk_load_and_search_btree(1, SQL::BTree::DEFAULT_FILL_FACTOR);
+}
+
+TEST_CASE(btree_bulk_load_1000_keys)
+{
+    bulk_load_and_search_btree(1000, SQL::BTree::DEFAULT_FILL_FACTOR);
+}
+
+TEST_CASE(btree_bulk_load_into_sparse_nodes)
+{
+    // Small nodes make for a tree a few levels deep.
+    bulk_load_and_search_btree(5000, 0.05);
+}
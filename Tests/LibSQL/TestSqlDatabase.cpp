@@ -9,7 +9,9 @@
 
 #include <AK/ScopeGuard.h>
 #include <AK/StringBuilder.h>
+#include <LibCore/File.h>
 #include <LibCore/System.h>
+#include <LibFileSystem/FileSystem.h>
 #include <LibSQL/BTree.h>
 #include <LibSQL/Database.h>
 #include <LibSQL/Heap.h>
@@ -17,6 +19,13 @@
 #include <LibSQL/Row.h>
 #include <LibSQL/Value.h>
 #include <LibTest/TestCase.h>
+#include <LibThreading/Thread.h>
+
+#ifdef AK_OS_SERENITY
+#    define TEST_INPUT(x) ("/usr/Tests/LibSQL/test-inputs/" x)
+#else
+#    define TEST_INPUT(x) ("test-inputs/" x)
+#endif
 
 static NonnullRefPtr<SQL::SchemaDef> setup_schema(SQL::Database& db)
 {
@@ -119,6 +128,23 @@ TEST_CASE(create_from_unreadable_file)
     EXPECT(should_be_error.is_error());
 }
 
+TEST_CASE(create_from_partial_page)
+{
+    ScopeGuard guard([]() { unlink("/tmp/test.db"); });
+
+    // Files that aren't made up of whole pages, whether shorter or longer than a single one.
+    for (auto size : { 10u, SQL::Block::DEFAULT_SIZE + 10 }) {
+        {
+            auto file = MUST(Core::File::open("/tmp/test.db"sv, Core::File::OpenMode::Write | Core::File::OpenMode::Truncate));
+            MUST(file->write_until_depleted(MUST(ByteBuffer::create_zeroed(size))));
+        }
+
+        auto heap = MUST(SQL::Heap::create("/tmp/test.db"));
+        auto should_be_error = heap->open();
+        EXPECT(should_be_error.is_error());
+    }
+}
+
 TEST_CASE(create_in_non_existing_dir)
 {
     auto heap = MUST(SQL::Heap::create("/tmp/bogus/test.db"));
@@ -235,3 +261,104 @@ TEST_CASE(reuse_row_storage)
     auto size_in_bytes_after_reinsertion = MUST(db->file_size_in_bytes());
     EXPECT(size_in_bytes_after_reinsertion <= original_size_in_bytes);
 }
+
+TEST_CASE(read_snapshot_while_writing)
+{
+    ScopeGuard guard([]() {
+        unlink("/tmp/test.db");
+        unlink("/tmp/test.db-wal");
+    });
+    auto db = MUST(SQL::Database::create("/tmp/test.db"));
+    MUST(db->open());
+    (void)setup_table(db);
+    insert_into_table(db, 10);
+    commit(db);
+
+    auto snapshot = MUST(db->create_snapshot());
+    EXPECT(snapshot->is_snapshot());
+
+    // The snapshot is read on another thread while rows keep being inserted and committed.
+    Atomic<bool> snapshot_was_consistent { true };
+    auto reader = Threading::Thread::construct([&]() -> intptr_t {
+        auto table = MUST(snapshot->get_table("TestSchema", "TestTable"));
+        for (auto pass = 0; pass < 20; ++pass) {
+            auto rows = snapshot->select_all(*table);
+            if (rows.is_error() || rows.value().size() != 10)
+                snapshot_was_consistent = false;
+        }
+        return 0;
+    });
+    reader->start();
+
+    auto table = MUST(db->get_table("TestSchema", "TestTable"));
+    for (auto ix = 10; ix < 200; ++ix) {
+        SQL::Row row(*table);
+        row["TextColumn"] = ByteString::formatted("Test{}", ix);
+        row["IntColumn"] = ix;
+        TRY_OR_FAIL(db->insert(row));
+        commit(db);
+    }
+
+    MUST(reader->join());
+    EXPECT(snapshot_was_consistent.load());
+    verify_table_contents(snapshot, 10);
+    verify_table_contents(db, 200);
+}
+
+TEST_CASE(migrate_legacy_database)
+{
+    ScopeGuard guard([]() {
+        unlink("/tmp/test.db");
+        unlink("/tmp/test.db-wal");
+    });
+
+    // A database from heap version 6, with 50 rows ('Test_<n>', n * 3 % 50) and an index on the integer column.
+    {
+        auto legacy_file = MUST(Core::File::open(TEST_INPUT("version-6.db"sv), Core::File::OpenMode::Read));
+        auto contents = MUST(legacy_file->read_until_eof());
+        auto file = MUST(Core::File::open("/tmp/test.db"sv, Core::File::OpenMode::Write | Core::File::OpenMode::Truncate));
+        MUST(file->write_until_depleted(contents));
+    }
+
+    auto verify_contents = [](SQL::Database& db) {
+        auto table = MUST(db.get_table("TESTSCHEMA", "TESTTABLE"));
+
+        // Rows are listed from the one inserted last, just like before the migration
+        auto rows = TRY_OR_FAIL(db.select_all(*table));
+        EXPECT_EQ(rows.size(), 50u);
+        for (size_t ix = 0; ix < rows.size(); ++ix) {
+            auto number = 49 - static_cast<i32>(ix);
+            EXPECT_EQ(rows[ix]["TEXTCOLUMN"].to_byte_string(), ByteString::formatted("Test_{}", number));
+            EXPECT_EQ(rows[ix]["INTCOLUMN"].to_int<i32>(), number * 3 % 50);
+        }
+
+        EXPECT_EQ(table->indexes().size(), 1u);
+        auto tree = db.index_tree(table->indexes()[0]);
+        i32 expected_value = 0;
+        for (auto it = tree->begin(); !it.is_end(); ++it) {
+            EXPECT_EQ((*it)[0].to_int<i32>(), expected_value);
+            auto row = TRY_OR_FAIL(db.select_row(*table, (*it).block_index()));
+            EXPECT_EQ(row["INTCOLUMN"].to_int<i32>(), expected_value);
+            ++expected_value;
+        }
+        EXPECT_EQ(expected_value, 50);
+    };
+
+    {
+        auto db = MUST(SQL::Database::create("/tmp/test.db"));
+        MUST(db->open());
+        verify_contents(db);
+        commit(db);
+    }
+
+    {
+        auto heap = MUST(SQL::Heap::create("/tmp/test.db"));
+        MUST(heap->open());
+        EXPECT_EQ(heap->version(), SQL::Heap::VERSION);
+        EXPECT(!FileSystem::exists("/tmp/test.db-migrating"sv));
+    }
+
+    auto db = MUST(SQL::Database::create("/tmp/test.db"));
+    MUST(db->open());
+    verify_contents(db);
+}
@@ -6,11 +6,16 @@
 
 #include <AK/ScopeGuard.h>
 #include <AK/StringBuilder.h>
+#include <LibCore/File.h>
 #include <LibCore/System.h>
 #include <LibSQL/Heap.h>
 #include <LibTest/TestCase.h>
 
 static constexpr auto db_path = "/tmp/test.db"sv;
+static constexpr auto wal_path = "/tmp/test.db-wal"sv;
+
+// A bit less than a page's worth of data, so that storage of N times this size takes up N pages.
+static constexpr size_t data_size_per_page = SQL::Block::DEFAULT_SIZE - 32;
 
 static NonnullRefPtr<SQL::Heap> create_heap()
 {
@@ -19,6 +24,24 @@ static NonnullRefPtr<SQL::Heap> create_heap()
     return heap;
 }
 
+static ByteBuffer read_file(StringView path)
+{
+    auto file = MUST(Core::File::open(path, Core::File::OpenMode::Read));
+    return MUST(file->read_until_eof());
+}
+
+static void write_file(StringView path, ReadonlyBytes data)
+{
+    auto file = MUST(Core::File::open(path, Core::File::OpenMode::Write));
+    MUST(file->write_until_depleted(data));
+}
+
+static ByteString read_string(SQL::Heap& heap, SQL::Block::Index index)
+{
+    auto data = MUST(heap.read_storage(index));
+    return ByteString { StringView { data } };
+}
+
 TEST_CASE(heap_write_large_storage_without_flush)
 {
     ScopeGuard guard([]() { MUST(Core::System::unlink(db_path)); });
@@ -27,7 +50,7 @@ TEST_CASE(heap_write_large_storage_without_flush)
 
     // Write large storage spanning multiple blocks
     StringBuilder builder;
-    MUST(builder.try_append_repeated('x', SQL::Block::DATA_SIZE * 4));
+    MUST(builder.try_append_repeated('x', data_size_per_page * 4));
     auto long_string = builder.string_view();
     TRY_OR_FAIL(heap->write_storage(storage_block_id, long_string.bytes()));
 
@@ -44,7 +67,7 @@ TEST_CASE(heap_write_large_storage_with_flush)
 
     // Write large storage spanning multiple blocks
     StringBuilder builder;
-    MUST(builder.try_append_repeated('x', SQL::Block::DATA_SIZE * 4));
+    MUST(builder.try_append_repeated('x', data_size_per_page * 4));
     auto long_string = builder.string_view();
     TRY_OR_FAIL(heap->write_storage(storage_block_id, long_string.bytes()));
     MUST(heap->flush());
@@ -62,7 +85,7 @@ TEST_CASE(heap_overwrite_large_storage)
 
     // Write large storage spanning multiple blocks
     StringBuilder builder;
-    MUST(builder.try_append_repeated('x', SQL::Block::DATA_SIZE * 4));
+    MUST(builder.try_append_repeated('x', data_size_per_page * 4));
     auto long_string = builder.string_view();
     TRY_OR_FAIL(heap->write_storage(storage_block_id, long_string.bytes()));
     MUST(heap->flush());
@@ -76,7 +99,7 @@ TEST_CASE(heap_overwrite_large_storage)
 
     // Write a smaller string and read back - heap size should be at most the previous size
     builder.clear();
-    MUST(builder.try_append_repeated('y', SQL::Block::DATA_SIZE * 2));
+    MUST(builder.try_append_repeated('y', data_size_per_page * 2));
     auto shorter_string = builder.string_view();
     TRY_OR_FAIL(heap->write_storage(storage_block_id, shorter_string.bytes()));
     MUST(heap->flush());
@@ -87,7 +110,7 @@ TEST_CASE(heap_overwrite_large_storage)
 
     // Write a longer string and read back - heap size is expected to grow
     builder.clear();
-    MUST(builder.try_append_repeated('z', SQL::Block::DATA_SIZE * 6));
+    MUST(builder.try_append_repeated('z', data_size_per_page * 6));
     auto longest_string = builder.string_view();
     TRY_OR_FAIL(heap->write_storage(storage_block_id, longest_string.bytes()));
     MUST(heap->flush());
@@ -105,7 +128,7 @@ TEST_CASE(heap_reuse_freed_blocks_after_storage_trim)
     // First, write storage spanning 4 blocks
     auto first_index = heap->request_new_block_index();
     StringBuilder builder;
-    MUST(builder.try_append_repeated('x', SQL::Block::DATA_SIZE * 4));
+    MUST(builder.try_append_repeated('x', data_size_per_page * 4));
     auto long_string = builder.string_view();
     TRY_OR_FAIL(heap->write_storage(first_index, long_string.bytes()));
     MUST(heap->flush());
@@ -113,7 +136,7 @@ TEST_CASE(heap_reuse_freed_blocks_after_storage_trim)
 
     // Then, overwrite the first storage and reduce it to 2 blocks
     builder.clear();
-    MUST(builder.try_append_repeated('x', SQL::Block::DATA_SIZE * 2));
+    MUST(builder.try_append_repeated('x', data_size_per_page * 2));
     long_string = builder.string_view();
     TRY_OR_FAIL(heap->write_storage(first_index, long_string.bytes()));
     MUST(heap->flush());
@@ -134,7 +157,7 @@ TEST_CASE(heap_reuse_freed_blocks_after_reopening_file)
 
     size_t original_heap_size = 0;
     StringBuilder builder;
-    MUST(builder.try_append_repeated('x', SQL::Block::DATA_SIZE * 4));
+    MUST(builder.try_append_repeated('x', data_size_per_page * 4));
     auto long_string = builder.string_view();
 
     {
@@ -148,7 +171,7 @@ TEST_CASE(heap_reuse_freed_blocks_after_reopening_file)
 
         // Then, overwrite the first storage and reduce it to 2 blocks
         builder.clear();
-        MUST(builder.try_append_repeated('x', SQL::Block::DATA_SIZE * 2));
+        MUST(builder.try_append_repeated('x', data_size_per_page * 2));
         long_string = builder.string_view();
         TRY_OR_FAIL(heap->write_storage(first_index, long_string.bytes()));
         MUST(heap->flush());
@@ -176,7 +199,7 @@ TEST_CASE(heap_free_storage)
 
     // Write large storage spanning multiple blocks
     StringBuilder builder;
-    MUST(builder.try_append_repeated('x', SQL::Block::DATA_SIZE * 4));
+    MUST(builder.try_append_repeated('x', data_size_per_page * 4));
     auto long_string = builder.string_view();
     TRY_OR_FAIL(heap->write_storage(storage_block_id, long_string.bytes()));
     MUST(heap->flush());
@@ -192,3 +215,297 @@ TEST_CASE(heap_free_storage)
     auto new_heap_size = MUST(heap->file_size_in_bytes());
     EXPECT(new_heap_size <= heap_size);
 }
+
+TEST_CASE(heap_buffer_pool)
+{
+    ScopeGuard guard([]() { MUST(Core::System::unlink(db_path)); });
+    auto heap = create_heap();
+    heap->set_buffer_pool_capacity(2);
+
+    Vector<SQL::Block::Index> block_ids;
+    for (auto i = 0; i < 3; ++i) {
+        auto block_id = heap->request_new_block_index();
+        auto data = ByteString::formatted("block {}", i);
+        TRY_OR_FAIL(heap->write_storage(block_id, data.bytes()));
+        block_ids.append(block_id);
+    }
+    MUST(heap->flush());
+
+    // Flushed blocks are cached, but the pool only has room for two of them
+    auto statistics = heap->buffer_pool_statistics();
+    EXPECT_EQ(statistics.cached_blocks, 2u);
+    EXPECT_EQ(statistics.evictions, 2u);
+
+    // The last two blocks written are still in the pool, the first one has to be read from the file
+    for (auto i = 2; i >= 0; --i) {
+        auto data = TRY_OR_FAIL(heap->read_storage(block_ids[i]));
+        EXPECT_EQ(StringView { data }, ByteString::formatted("block {}", i));
+    }
+
+    statistics = heap->buffer_pool_statistics();
+    EXPECT_EQ(statistics.hits, 2u);
+    EXPECT_EQ(statistics.misses, 1u);
+
+    // Reading the same block again should never go to the file
+    auto misses = statistics.misses;
+    TRY_OR_FAIL(heap->read_storage(block_ids[2]));
+    TRY_OR_FAIL(heap->read_storage(block_ids[2]));
+    EXPECT_EQ(heap->buffer_pool_statistics().misses, misses);
+}
+
+TEST_CASE(heap_buffer_pool_pinned_blocks)
+{
+    ScopeGuard guard([]() { MUST(Core::System::unlink(db_path)); });
+    auto heap = create_heap();
+    heap->set_buffer_pool_capacity(1);
+
+    auto first_data = MUST(ByteBuffer::create_uninitialized(data_size_per_page));
+    first_data.bytes().fill('a');
+    auto second_data = MUST(ByteBuffer::create_uninitialized(data_size_per_page));
+    second_data.bytes().fill('b');
+
+    auto first_block_id = heap->request_new_block_index();
+    TRY_OR_FAIL(heap->write_storage(first_block_id, first_data));
+    auto second_block_id = heap->request_new_block_index();
+    TRY_OR_FAIL(heap->write_storage(second_block_id, second_data));
+    MUST(heap->flush());
+
+    // Reading storage that fits in a single page pins that page in the pool, without copying it
+    TRY_OR_FAIL(heap->read_storage(first_block_id));
+    {
+        auto storage = TRY_OR_FAIL(heap->read_pinned_storage(first_block_id));
+        EXPECT_EQ(heap->buffer_pool_statistics().pinned_blocks, 1u);
+
+        // The only frame is pinned, so the other page can't take its place
+        auto evictions = heap->buffer_pool_statistics().evictions;
+        auto data = TRY_OR_FAIL(heap->read_storage(second_block_id));
+        EXPECT(data.bytes() == second_data.bytes());
+        EXPECT_EQ(heap->buffer_pool_statistics().evictions, evictions);
+        EXPECT(storage.bytes() == first_data.bytes());
+    }
+
+    // Once released, the page can be evicted again
+    auto statistics = heap->buffer_pool_statistics();
+    EXPECT_EQ(statistics.pinned_blocks, 0u);
+    TRY_OR_FAIL(heap->read_storage(second_block_id));
+    EXPECT_EQ(heap->buffer_pool_statistics().evictions, statistics.evictions + 1);
+    TRY_OR_FAIL(heap->read_storage(second_block_id));
+    EXPECT_EQ(heap->buffer_pool_statistics().misses, statistics.misses + 1);
+}
+
+TEST_CASE(heap_recover_from_wal)
+{
+    ScopeGuard guard([]() {
+        MUST(Core::System::unlink(db_path));
+        MUST(Core::System::unlink(wal_path));
+    });
+
+    SQL::Block::Index storage_block_id = 0;
+    ByteBuffer heap_file_contents;
+    ByteBuffer wal_contents;
+    {
+        auto heap = create_heap();
+        storage_block_id = heap->request_new_block_index();
+        TRY_OR_FAIL(heap->write_storage(storage_block_id, "committed"sv.bytes()));
+        MUST(heap->flush());
+
+        // Committed blocks are in the log, not in the heap's file yet
+        EXPECT(MUST(Core::System::stat(wal_path)).st_size > 0);
+
+        // Simulate a crash by grabbing the files before the Heap can checkpoint the log
+        heap_file_contents = read_file(db_path);
+        wal_contents = read_file(wal_path);
+    }
+
+    // A transaction that was cut short must be ignored
+    MUST(wal_contents.try_append("torn frame"sv.bytes()));
+    write_file(db_path, heap_file_contents);
+    write_file(wal_path, wal_contents);
+
+    auto heap = create_heap();
+    auto stored_string = TRY_OR_FAIL(heap->read_storage(storage_block_id));
+    EXPECT_EQ(StringView { stored_string }, "committed"sv);
+    EXPECT_EQ(MUST(Core::System::stat(wal_path)).st_size, 0);
+}
+
+TEST_CASE(heap_checkpoint)
+{
+    ScopeGuard guard([]() {
+        MUST(Core::System::unlink(db_path));
+        MUST(Core::System::unlink(wal_path));
+    });
+
+    auto heap = create_heap();
+    auto storage_block_id = heap->request_new_block_index();
+    TRY_OR_FAIL(heap->write_storage(storage_block_id, "checkpointed"sv.bytes()));
+    MUST(heap->flush());
+    MUST(heap->checkpoint());
+
+    EXPECT_EQ(MUST(Core::System::stat(wal_path)).st_size, 0);
+    EXPECT_EQ(MUST(Core::System::stat(db_path)).st_size, static_cast<off_t>(2 * SQL::Block::DEFAULT_SIZE));
+
+    auto stored_string = TRY_OR_FAIL(heap->read_storage(storage_block_id));
+    EXPECT_EQ(StringView { stored_string }, "checkpointed"sv);
+}
+
+TEST_CASE(heap_pack_small_storage)
+{
+    ScopeGuard guard([]() { MUST(Core::System::unlink(db_path)); });
+    auto heap = create_heap();
+
+    Vector<SQL::Block::Index> block_ids;
+    for (auto i = 0; i < 1000; ++i) {
+        auto data = ByteString::formatted("storage {}", i);
+        block_ids.append(TRY_OR_FAIL(heap->insert_storage(data.bytes())));
+    }
+    MUST(heap->flush());
+
+    // Many storages share a page, instead of taking up a page each
+    EXPECT(MUST(heap->file_size_in_bytes()) <= 8 * heap->page_size());
+
+    for (auto i = 0; i < 1000; ++i) {
+        auto data = TRY_OR_FAIL(heap->read_storage(block_ids[i]));
+        EXPECT_EQ(StringView { data }, ByteString::formatted("storage {}", i));
+    }
+}
+
+TEST_CASE(heap_grow_packed_storage)
+{
+    ScopeGuard guard([]() { MUST(Core::System::unlink(db_path)); });
+    auto heap = create_heap();
+
+    Vector<SQL::Block::Index> block_ids;
+    for (auto i = 0; i < 10; ++i) {
+        auto data = ByteString::formatted("storage {}", i);
+        block_ids.append(TRY_OR_FAIL(heap->insert_storage(data.bytes())));
+    }
+
+    // Storage that outgrows the page it shares with other storage moves to overflow pages
+    StringBuilder builder;
+    MUST(builder.try_append_repeated('x', data_size_per_page * 3));
+    auto long_string = builder.string_view();
+    TRY_OR_FAIL(heap->write_storage(block_ids[5], long_string.bytes()));
+    MUST(heap->flush());
+
+    auto stored_long_string = TRY_OR_FAIL(heap->read_storage(block_ids[5]));
+    EXPECT_EQ(long_string.bytes(), stored_long_string.bytes());
+
+    // Growing a little only moves storage around within its page
+    TRY_OR_FAIL(heap->write_storage(block_ids[3], "a slightly longer storage 3"sv.bytes()));
+    MUST(heap->flush());
+
+    for (auto i = 0; i < 10; ++i) {
+        auto data = TRY_OR_FAIL(heap->read_storage(block_ids[i]));
+        if (i == 3)
+            EXPECT_EQ(StringView { data }, "a slightly longer storage 3"sv);
+        else if (i != 5)
+            EXPECT_EQ(StringView { data }, ByteString::formatted("storage {}", i));
+    }
+
+    // And shrinking it again releases the overflow pages
+    auto heap_size = MUST(heap->file_size_in_bytes());
+    TRY_OR_FAIL(heap->write_storage(block_ids[5], "storage 5"sv.bytes()));
+    TRY_OR_FAIL(heap->write_storage(heap->request_new_block_index(), long_string.bytes()));
+    MUST(heap->flush());
+    EXPECT(MUST(heap->file_size_in_bytes()) <= heap_size + heap->page_size());
+    auto shrunk_string = TRY_OR_FAIL(heap->read_storage(block_ids[5]));
+    EXPECT_EQ(StringView { shrunk_string }, "storage 5"sv);
+}
+
+TEST_CASE(heap_free_packed_storage)
+{
+    ScopeGuard guard([]() { MUST(Core::System::unlink(db_path)); });
+    auto heap = create_heap();
+
+    Vector<SQL::Block::Index> block_ids;
+    for (auto i = 0; i < 500; ++i) {
+        auto data = ByteString::formatted("storage {}", i);
+        block_ids.append(TRY_OR_FAIL(heap->insert_storage(data.bytes())));
+    }
+    MUST(heap->flush());
+    auto heap_size = MUST(heap->file_size_in_bytes());
+
+    for (auto block_id : block_ids) {
+        EXPECT(heap->has_block(block_id));
+        TRY_OR_FAIL(heap->free_storage(block_id));
+        EXPECT(!heap->has_block(block_id));
+    }
+    MUST(heap->flush());
+
+    // Pages that are left empty are reused
+    for (auto i = 0; i < 500; ++i) {
+        auto data = ByteString::formatted("storage {}", i);
+        TRY_OR_FAIL(heap->insert_storage(data.bytes()));
+    }
+    MUST(heap->flush());
+    EXPECT_EQ(MUST(heap->file_size_in_bytes()), heap_size);
+}
+
+TEST_CASE(heap_page_size)
+{
+    ScopeGuard guard([]() {
+        MUST(Core::System::unlink(db_path));
+        MUST(Core::System::unlink(wal_path));
+    });
+
+    EXPECT(SQL::Heap::create(db_path, 1000).is_error());
+    EXPECT(SQL::Heap::create(db_path, 32 * KiB).is_error());
+
+    StringBuilder builder;
+    MUST(builder.try_append_repeated('x', 10 * KiB));
+    auto long_string = builder.string_view();
+
+    SQL::Block::Index storage_block_id = 0;
+    {
+        auto heap = MUST(SQL::Heap::create(db_path, 16 * KiB));
+        MUST(heap->open());
+        EXPECT_EQ(heap->page_size(), 16 * KiB);
+
+        // Storage that fits in a single page of this size doesn't need overflow pages
+        storage_block_id = heap->request_new_block_index();
+        TRY_OR_FAIL(heap->write_storage(storage_block_id, long_string.bytes()));
+        MUST(heap->flush());
+        EXPECT_EQ(MUST(heap->file_size_in_bytes()), 2 * 16 * KiB);
+    }
+
+    // The page size the file was created with wins over the one asked for
+    auto heap = create_heap();
+    EXPECT_EQ(heap->page_size(), 16 * KiB);
+    auto stored_long_string = TRY_OR_FAIL(heap->read_storage(storage_block_id));
+    EXPECT_EQ(long_string.bytes(), stored_long_string.bytes());
+}
+
+TEST_CASE(heap_snapshot)
+{
+    ScopeGuard guard([]() {
+        MUST(Core::System::unlink(db_path));
+        MUST(Core::System::unlink(wal_path));
+    });
+
+    auto heap = create_heap();
+    auto storage_block_id = heap->request_new_block_index();
+    TRY_OR_FAIL(heap->write_storage(storage_block_id, "before"sv.bytes()));
+    MUST(heap->flush());
+
+    auto snapshot = MUST(heap->create_snapshot());
+    EXPECT(snapshot->is_read_only());
+    EXPECT(snapshot->write_storage(storage_block_id, "from snapshot"sv.bytes()).is_error());
+
+    // Neither uncommitted nor committed changes are seen by the snapshot, not even after a checkpoint
+    TRY_OR_FAIL(heap->write_storage(storage_block_id, "after"sv.bytes()));
+    auto new_storage_block_id = TRY_OR_FAIL(heap->insert_storage("new"sv.bytes()));
+    EXPECT_EQ(read_string(snapshot, storage_block_id), "before"sv);
+
+    MUST(heap->flush());
+    EXPECT_EQ(read_string(snapshot, storage_block_id), "before"sv);
+    EXPECT(!snapshot->has_block(new_storage_block_id));
+
+    MUST(heap->checkpoint());
+    EXPECT_EQ(read_string(snapshot, storage_block_id), "before"sv);
+    EXPECT_EQ(read_string(heap, storage_block_id), "after"sv);
+
+    // A snapshot taken later sees the later commits
+    auto later_snapshot = MUST(heap->create_snapshot());
+    EXPECT_EQ(read_string(later_snapshot, storage_block_id), "after"sv);
+    EXPECT_EQ(read_string(later_snapshot, new_storage_block_id), "new"sv);
+}
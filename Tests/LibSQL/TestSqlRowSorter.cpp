@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibSQL/RowSorter.h>
+#include <LibSQL/Tuple.h>
+#include <LibSQL/TupleDescriptor.h>
+#include <LibSQL/Value.h>
+#include <LibTest/TestCase.h>
+
+namespace {
+
+constexpr size_t row_count = 1000;
+
+NonnullRefPtr<SQL::TupleDescriptor> sort_descriptor(SQL::Order order)
+{
+    NonnullRefPtr<SQL::TupleDescriptor> descriptor = adopt_ref(*new SQL::TupleDescriptor);
+    descriptor->append({ "", "", "", SQL::SQLType::Integer, order });
+    return descriptor;
+}
+
+// Appends the rows 0 to row_count - 1, keyed by their value modulo 10 and in a scrambled order.
+void append_rows(SQL::RowSorter& sorter, NonnullRefPtr<SQL::TupleDescriptor> const& descriptor)
+{
+    for (size_t ix = 0; ix < row_count; ++ix) {
+        auto value = static_cast<i32>((ix * 7) % row_count);
+
+        SQL::Tuple row;
+        row.append(SQL::Value { value });
+
+        SQL::Tuple sort_key { descriptor };
+        sort_key[0] = value % 10;
+
+        MUST(sorter.append(row, sort_key));
+    }
+}
+
+Vector<i32> read_rows(SQL::RowSorter& sorter)
+{
+    Vector<i32> values;
+    while (true) {
+        auto row = MUST(sorter.next());
+        if (!row.has_value())
+            break;
+        values.append(row.value()[0].to_int<i32>().value());
+    }
+    return values;
+}
+
+// The sorters must be stable, so rows with equal keys have to come out in the order they went in.
+Vector<i32> expected_rows(SQL::Order order)
+{
+    Vector<i32> values;
+    for (size_t key = 0; key < 10; ++key) {
+        auto actual_key = order == SQL::Order::Ascending ? key : 9 - key;
+        for (size_t ix = 0; ix < row_count; ++ix) {
+            auto value = static_cast<i32>((ix * 7) % row_count);
+            if (static_cast<size_t>(value % 10) == actual_key)
+                values.append(value);
+        }
+    }
+    return values;
+}
+
+}
+
+TEST_CASE(sort_in_memory)
+{
+    for (auto order : { SQL::Order::Ascending, SQL::Order::Descending }) {
+        SQL::RowSorter sorter;
+        append_rows(sorter, sort_descriptor(order));
+        MUST(sorter.finish());
+
+        EXPECT_EQ(sorter.spilled_run_count(), 0u);
+        EXPECT_EQ(read_rows(sorter), expected_rows(order));
+    }
+}
+
+TEST_CASE(sort_spilled_to_disk)
+{
+    for (auto order : { SQL::Order::Ascending, SQL::Order::Descending }) {
+        SQL::RowSorter sorter { {}, 4 * KiB };
+        append_rows(sorter, sort_descriptor(order));
+        MUST(sorter.finish());
+
+        EXPECT(sorter.spilled_run_count() > 1);
+        EXPECT_EQ(read_rows(sorter), expected_rows(order));
+    }
+}
+
+TEST_CASE(sort_top_rows)
+{
+    for (size_t limit : { 0, 1, 10, 150, 999, 1000, 5000 }) {
+        SQL::RowSorter sorter { limit };
+        append_rows(sorter, sort_descriptor(SQL::Order::Ascending));
+        MUST(sorter.finish());
+
+        auto expected = expected_rows(SQL::Order::Ascending);
+        expected.shrink(min(limit, expected.size()));
+
+        EXPECT_EQ(sorter.spilled_run_count(), 0u);
+        EXPECT_EQ(read_rows(sorter), expected);
+    }
+}
+
+TEST_CASE(sort_top_rows_exceeding_memory_budget)
+{
+    SQL::RowSorter sorter { 500, 4 * KiB };
+    append_rows(sorter, sort_descriptor(SQL::Order::Descending));
+    MUST(sorter.finish());
+
+    // The rows don't fit the budget, so everything was sorted instead of just the top rows.
+    EXPECT(sorter.spilled_run_count() > 1);
+    EXPECT_EQ(read_rows(sorter), expected_rows(SQL::Order::Descending));
+}
+
+TEST_CASE(reset_sorter)
+{
+    auto descriptor = sort_descriptor(SQL::Order::Ascending);
+    SQL::RowSorter sorter { {}, 4 * KiB };
+
+    for (auto pass = 0; pass < 2; ++pass) {
+        append_rows(sorter, descriptor);
+        MUST(sorter.finish());
+        EXPECT_EQ(read_rows(sorter), expected_rows(SQL::Order::Ascending));
+        sorter.reset();
+    }
+}
@@ -9,7 +9,9 @@
 
 #include <AK/QuickSort.h>
 #include <AK/ScopeGuard.h>
+#include <LibSQL/AST/CompiledExpression.h>
 #include <LibSQL/AST/Parser.h>
+#include <LibSQL/AST/QueryPlan.h>
 #include <LibSQL/Database.h>
 #include <LibSQL/Result.h>
 #include <LibSQL/ResultSet.h>
@@ -384,6 +386,52 @@ TEST_CASE(select_inner_join)
     EXPECT_EQ(result[0].row[2].to_byte_string(), "Test_12");
 }
 
+TEST_CASE(select_join_with_filters_on_each_table)
+{
+    ScopeGuard guard([]() { unlink(db_name); });
+    auto database = MUST(SQL::Database::create(db_name));
+    MUST(database->open());
+    create_two_tables(database);
+    auto result = execute(database,
+        "INSERT INTO TestSchema.TestTable1 ( TextColumn1, IntColumn ) VALUES "
+        "( 'Test_1', 42 ), "
+        "( 'Test_2', 43 ), "
+        "( 'Test_3', 44 ), "
+        "( 'Test_4', 45 ), "
+        "( 'Test_5', 46 );");
+    EXPECT(result.size() == 5);
+    result = execute(database,
+        "INSERT INTO TestSchema.TestTable2 ( TextColumn2, IntColumn ) VALUES "
+        "( 'Test_10', 40 ), "
+        "( 'Test_11', 41 ), "
+        "( 'Test_12', 42 ), "
+        "( 'Test_13', 47 ), "
+        "( 'Test_14', 48 );");
+    EXPECT(result.size() == 5);
+
+    result = execute(database,
+        "SELECT TextColumn1, TextColumn2 "
+        "FROM TestSchema.TestTable1, TestSchema.TestTable2 "
+        "WHERE (TestTable1.IntColumn > 44) AND (TestTable2.IntColumn < TestTable1.IntColumn) AND (TextColumn2 <> 'Test_11') "
+        "ORDER BY TextColumn1, TextColumn2;");
+    EXPECT_EQ(result.size(), 4u);
+    EXPECT_EQ(result[0].row[0].to_byte_string(), "Test_4");
+    EXPECT_EQ(result[0].row[1].to_byte_string(), "Test_10");
+    EXPECT_EQ(result[1].row[0].to_byte_string(), "Test_4");
+    EXPECT_EQ(result[1].row[1].to_byte_string(), "Test_12");
+    EXPECT_EQ(result[2].row[0].to_byte_string(), "Test_5");
+    EXPECT_EQ(result[2].row[1].to_byte_string(), "Test_10");
+    EXPECT_EQ(result[3].row[0].to_byte_string(), "Test_5");
+    EXPECT_EQ(result[3].row[1].to_byte_string(), "Test_12");
+
+    result = execute(database, "SELECT * FROM TestSchema.TestTable1, TestSchema.TestTable2 LIMIT 7 OFFSET 3;");
+    EXPECT_EQ(result.size(), 7u);
+
+    auto error = try_execute(database, "SELECT * FROM TestSchema.TestTable1, TestSchema.TestTable2 WHERE (IntColumn = 42) AND (TextColumn1 = 'Test_1');");
+    EXPECT(error.is_error());
+    EXPECT_EQ(error.error().error(), SQL::SQLErrorCode::AmbiguousColumnName);
+}
+
 TEST_CASE(select_with_like)
 {
     ScopeGuard guard([]() { unlink(db_name); });
@@ -634,6 +682,34 @@ TEST_CASE(select_with_order_limit_and_offset)
     EXPECT_EQ(result[9].row[1].to_int<i32>(), 19);
 }
 
+TEST_CASE(select_with_order_by_and_limit_matches_full_sort)
+{
+    ScopeGuard guard([]() { unlink(db_name); });
+    auto database = MUST(SQL::Database::create(db_name));
+    MUST(database->open());
+    create_table(database);
+    for (auto count = 0; count < 100; count++) {
+        auto result = execute(database,
+            ByteString::formatted("INSERT INTO TestSchema.TestTable ( TextColumn, IntColumn ) VALUES ( 'Test_{}', {} );", count, count % 5));
+        EXPECT(result.size() == 1);
+    }
+
+    // Only the top rows are kept when there's a LIMIT, which must not change which of the rows with
+    // equal sort keys are produced.
+    auto all_rows = execute(database, "SELECT TextColumn, IntColumn FROM TestSchema.TestTable ORDER BY IntColumn DESC;");
+    EXPECT_EQ(all_rows.size(), 100u);
+    for (size_t i = 0; i < all_rows.size(); ++i)
+        EXPECT_EQ(all_rows[i].row[1].to_int<i32>(), static_cast<i32>(4 - i / 20));
+
+    for (auto offset : { 0, 19, 95 }) {
+        auto result = execute(database, ByteString::formatted("SELECT TextColumn, IntColumn FROM TestSchema.TestTable ORDER BY IntColumn DESC LIMIT 7 OFFSET {};", offset));
+        EXPECT_EQ(result.size(), min(7u, 100u - offset));
+
+        for (size_t i = 0; i < result.size(); ++i)
+            EXPECT_EQ(result[i].row[0], all_rows[offset + i].row[0]);
+    }
+}
+
 TEST_CASE(select_with_limit_out_of_bounds)
 {
     ScopeGuard guard([]() { unlink(db_name); });
@@ -1060,4 +1136,361 @@ TEST_CASE(update_all_rows)
     }
 }
 
+Vector<ByteString> explain(NonnullRefPtr<SQL::Database> database, ByteString const& sql)
+{
+    auto result = execute(move(database), ByteString::formatted("EXPLAIN {}", sql));
+    EXPECT_EQ(result.command(), SQL::SQLCommand::Explain);
+
+    Vector<ByteString> lines;
+    for (auto const& row : result)
+        lines.append(row.row[0].to_byte_string());
+    return lines;
+}
+
+TEST_CASE(create_index)
+{
+    ScopeGuard guard([]() { unlink(db_name); });
+    auto database = MUST(SQL::Database::create(db_name));
+    MUST(database->open());
+    create_table(database);
+
+    auto result = execute(database, "CREATE INDEX IntIndex ON TestSchema.TestTable (IntColumn);");
+    EXPECT_EQ(result.command(), SQL::SQLCommand::Create);
+
+    auto table = MUST(database->get_table("TESTSCHEMA", "TESTTABLE"));
+    EXPECT_EQ(table->num_indexes(), 1u);
+    EXPECT_EQ(table->indexes()[0]->name(), "INTINDEX");
+    EXPECT_EQ(table->indexes()[0]->size(), 1u);
+
+    result = execute(database, "CREATE INDEX IF NOT EXISTS IntIndex ON TestSchema.TestTable (IntColumn);");
+    EXPECT_EQ(result.command(), SQL::SQLCommand::Create);
+
+    auto error = try_execute(database, "CREATE INDEX IntIndex ON TestSchema.TestTable (TextColumn);");
+    EXPECT(error.is_error());
+    EXPECT_EQ(error.error().error(), SQL::SQLErrorCode::IndexExists);
+
+    error = try_execute(database, "CREATE INDEX BogusIndex ON TestSchema.TestTable (BogusColumn);");
+    EXPECT(error.is_error());
+    EXPECT_EQ(error.error().error(), SQL::SQLErrorCode::ColumnDoesNotExist);
+
+    error = try_execute(database, "CREATE INDEX BogusIndex ON TestSchema.BogusTable (IntColumn);");
+    EXPECT(error.is_error());
+    EXPECT_EQ(error.error().error(), SQL::SQLErrorCode::TableDoesNotExist);
+
+    error = try_execute(database, "CREATE UNIQUE INDEX UniqueIndex ON TestSchema.TestTable (IntColumn);");
+    EXPECT(error.is_error());
+    EXPECT_EQ(error.error().error(), SQL::SQLErrorCode::NotYetImplemented);
+}
+
+TEST_CASE(select_using_index)
+{
+    ScopeGuard guard([]() { unlink(db_name); });
+    {
+        auto database = MUST(SQL::Database::create(db_name));
+        MUST(database->open());
+        create_table(database);
+
+        // Rows inserted before the index is created have to end up in it just the same.
+        for (auto count = 0; count < 100; ++count)
+            execute(database, ByteString::formatted("INSERT INTO TestSchema.TestTable VALUES ( 'T{}', {} );", count, (count * 37) % 200));
+        execute(database, "CREATE INDEX IntIndex ON TestSchema.TestTable (IntColumn);");
+        for (auto count = 100; count < 200; ++count)
+            execute(database, ByteString::formatted("INSERT INTO TestSchema.TestTable VALUES ( 'T{}', {} );", count, (count * 37) % 200));
+
+        auto plan = explain(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE IntColumn = 74;");
+        EXPECT_EQ(plan.size(), 3u);
+        EXPECT_EQ(plan[0], "PROJECT (1 column)");
+        EXPECT_EQ(plan[1], "  FILTER (1 condition)");
+        EXPECT_EQ(plan[2], "    SEARCH TABLE TESTSCHEMA.TESTTABLE USING INDEX INTINDEX (INTCOLUMN=?)");
+
+        auto result = execute(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE IntColumn = 74;");
+        EXPECT_EQ(result.size(), 1u);
+        EXPECT_EQ(result[0].row[0], "T2"sv);
+
+        result = execute(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE 111 = IntColumn;");
+        EXPECT_EQ(result.size(), 1u);
+        EXPECT_EQ(result[0].row[0], "T3"sv);
+
+        result = execute(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE IntColumn = ?;", placeholders(148));
+        EXPECT_EQ(result.size(), 1u);
+        EXPECT_EQ(result[0].row[0], "T4"sv);
+
+        plan = explain(database, "SELECT IntColumn FROM TestSchema.TestTable WHERE (IntColumn >= 50) AND (IntColumn < 60);");
+        EXPECT_EQ(plan.size(), 3u);
+        EXPECT_EQ(plan[2], "    SEARCH TABLE TESTSCHEMA.TESTTABLE USING INDEX INTINDEX (INTCOLUMN>=? AND INTCOLUMN<?)");
+
+        // Rows read through the index come in index order.
+        result = execute(database, "SELECT IntColumn FROM TestSchema.TestTable WHERE (IntColumn >= 50) AND (IntColumn < 60);");
+        EXPECT_EQ(result.size(), 10u);
+        for (auto i = 0u; i < result.size(); ++i)
+            EXPECT_EQ(result[i].row[0], 50 + i);
+
+        result = execute(database, "SELECT IntColumn FROM TestSchema.TestTable WHERE (195 < IntColumn) AND (TextColumn <> 'T7');");
+        EXPECT_EQ(result.size(), 4u);
+
+        // A predicate that doesn't compare the indexed column with a constant can't use the index.
+        plan = explain(database, "SELECT IntColumn FROM TestSchema.TestTable WHERE IntColumn + 1 = 75;");
+        EXPECT_EQ(plan.size(), 3u);
+        EXPECT_EQ(plan[2], "    SCAN TABLE TESTSCHEMA.TESTTABLE");
+
+        plan = explain(database, "SELECT IntColumn FROM TestSchema.TestTable ORDER BY IntColumn LIMIT 5;");
+        EXPECT_EQ(plan.size(), 3u);
+        EXPECT_EQ(plan[0], "LIMIT 5");
+        EXPECT_EQ(plan[1], "  PROJECT (1 column)");
+        EXPECT_EQ(plan[2], "    SCAN TABLE TESTSCHEMA.TESTTABLE USING INDEX INTINDEX");
+
+        result = execute(database, "SELECT IntColumn FROM TestSchema.TestTable ORDER BY IntColumn LIMIT 5;");
+        EXPECT_EQ(result.size(), 5u);
+        for (auto i = 0u; i < result.size(); ++i)
+            EXPECT_EQ(result[i].row[0], i);
+
+        plan = explain(database, "SELECT IntColumn FROM TestSchema.TestTable ORDER BY IntColumn DESC LIMIT 5;");
+        EXPECT_EQ(plan.size(), 4u);
+        EXPECT_EQ(plan[1], "  SORT (1 key, top 5)");
+        EXPECT_EQ(plan[3], "      SCAN TABLE TESTSCHEMA.TESTTABLE");
+
+        execute(database, "DELETE FROM TestSchema.TestTable WHERE IntColumn = 74;");
+        result = execute(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE IntColumn = 74;");
+        EXPECT(result.is_empty());
+
+        execute(database, "UPDATE TestSchema.TestTable SET IntColumn=1000 WHERE IntColumn = 111;");
+        result = execute(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE IntColumn = 111;");
+        EXPECT(result.is_empty());
+        result = execute(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE IntColumn = 1000;");
+        EXPECT_EQ(result.size(), 1u);
+        EXPECT_EQ(result[0].row[0], "T3"sv);
+    }
+    {
+        auto database = MUST(SQL::Database::create(db_name));
+        MUST(database->open());
+
+        auto plan = explain(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE IntColumn = 148;");
+        EXPECT_EQ(plan.size(), 3u);
+        EXPECT_EQ(plan[2], "    SEARCH TABLE TESTSCHEMA.TESTTABLE USING INDEX INTINDEX (INTCOLUMN=?)");
+
+        auto result = execute(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE IntColumn = 148;");
+        EXPECT_EQ(result.size(), 1u);
+        EXPECT_EQ(result[0].row[0], "T4"sv);
+
+        result = execute(database, "SELECT IntColumn FROM TestSchema.TestTable ORDER BY IntColumn;");
+        EXPECT_EQ(result.size(), 199u);
+        for (auto i = 1u; i < result.size(); ++i)
+            EXPECT(result[i - 1].row[0] <= result[i].row[0]);
+    }
+}
+
+TEST_CASE(select_join_using_index)
+{
+    ScopeGuard guard([]() { unlink(db_name); });
+    auto database = MUST(SQL::Database::create(db_name));
+    MUST(database->open());
+    create_two_tables(database);
+    execute(database, "CREATE INDEX TextIndex ON TestSchema.TestTable2 (TextColumn2, IntColumn);");
+
+    for (auto count = 0; count < 20; ++count) {
+        execute(database, ByteString::formatted("INSERT INTO TestSchema.TestTable1 VALUES ( 'T{}', {} );", count, count));
+        execute(database, ByteString::formatted("INSERT INTO TestSchema.TestTable2 VALUES ( 'T{}', {} );", count % 4, count));
+    }
+
+    auto sql = "SELECT TextColumn1, TestTable2.IntColumn "
+               "FROM TestSchema.TestTable1, TestSchema.TestTable2 "
+               "WHERE (TextColumn2 = 'T2') AND (TestTable2.IntColumn > 9) AND (TestTable1.IntColumn = TestTable2.IntColumn) "
+               "ORDER BY TextColumn1;";
+
+    auto plan = explain(database, sql);
+    EXPECT_EQ(plan.size(), 7u);
+    EXPECT_EQ(plan[0], "SORT (1 key)");
+    EXPECT_EQ(plan[1], "  PROJECT (3 columns)");
+    EXPECT_EQ(plan[2], "    FILTER (1 condition)");
+    EXPECT_EQ(plan[3], "      NESTED LOOP JOIN");
+    EXPECT_EQ(plan[4], "        SCAN TABLE TESTSCHEMA.TESTTABLE1");
+    EXPECT_EQ(plan[5], "        FILTER (2 conditions)");
+    EXPECT_EQ(plan[6], "          SEARCH TABLE TESTSCHEMA.TESTTABLE2 USING INDEX TEXTINDEX (TEXTCOLUMN2=? AND INTCOLUMN>?)");
+
+    auto result = execute(database, sql);
+    EXPECT_EQ(result.size(), 3u);
+    EXPECT_EQ(result[0].row[0], "T10"sv);
+    EXPECT_EQ(result[0].row[1], 10);
+    EXPECT_EQ(result[1].row[0], "T14"sv);
+    EXPECT_EQ(result[1].row[1], 14);
+    EXPECT_EQ(result[2].row[0], "T18"sv);
+    EXPECT_EQ(result[2].row[1], 18);
+}
+
+TEST_CASE(insert_multiple_rows_into_indexed_table)
+{
+    ScopeGuard guard([]() { unlink(db_name); });
+
+    auto insert_rows = [](auto& database, int first, int last) {
+        StringBuilder sql;
+        sql.append("INSERT INTO TestSchema.TestTable VALUES "sv);
+        for (auto count = first; count < last; ++count)
+            sql.appendff("{}( 'T{}', {} )", count == first ? "" : ", ", count, (count * 37) % 1000);
+        sql.append(';');
+
+        auto result = execute(database, sql.to_byte_string());
+        EXPECT_EQ(result.size(), static_cast<size_t>(last - first));
+    };
+
+    {
+        auto database = MUST(SQL::Database::create(db_name));
+        MUST(database->open());
+        create_table(database);
+        execute(database, "CREATE INDEX IntIndex ON TestSchema.TestTable (IntColumn);");
+
+        // The first rows are bulk loaded into the empty index, the next ones are inserted into it.
+        insert_rows(database, 0, 900);
+        insert_rows(database, 900, 1000);
+
+        // Rows are only inserted once all of them have been checked.
+        auto error = try_execute(database, "INSERT INTO TestSchema.TestTable VALUES ( 'T1000', 1000 ), ( 1001, 'T1001' );");
+        EXPECT(error.is_error());
+        EXPECT_EQ(error.error().error(), SQL::SQLErrorCode::InvalidValueType);
+
+        MUST(database->commit());
+    }
+
+    {
+        auto database = MUST(SQL::Database::create(db_name));
+        MUST(database->open());
+
+        auto result = execute(database, "SELECT TextColumn FROM TestSchema.TestTable;");
+        EXPECT_EQ(result.size(), 1000u);
+
+        result = execute(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE IntColumn = 74;");
+        EXPECT_EQ(result.size(), 1u);
+        EXPECT_EQ(result[0].row[0], "T2"sv);
+
+        result = execute(database, "SELECT TextColumn FROM TestSchema.TestTable WHERE IntColumn = 963;");
+        EXPECT_EQ(result.size(), 1u);
+        EXPECT_EQ(result[0].row[0], "T999"sv);
+
+        result = execute(database, "SELECT IntColumn FROM TestSchema.TestTable ORDER BY IntColumn;");
+        EXPECT_EQ(result.size(), 1000u);
+        for (auto i = 0u; i < result.size(); ++i)
+            EXPECT_EQ(result[i].row[0], i);
+
+        // Indexes created on a table that already has rows are bulk loaded as well.
+        execute(database, "CREATE INDEX TextIndex ON TestSchema.TestTable (TextColumn);");
+        result = execute(database, "SELECT IntColumn FROM TestSchema.TestTable WHERE TextColumn = 'T999';");
+        EXPECT_EQ(result.size(), 1u);
+        EXPECT_EQ(result[0].row[0], 963);
+    }
+}
+
+
+NonnullRefPtr<SQL::AST::Select> parse_select(StringView sql)
+{
+    auto parser = SQL::AST::Parser(SQL::AST::Lexer(sql));
+    auto statement = parser.next_statement();
+    VERIFY(!parser.has_errors() && is<SQL::AST::Select>(*statement));
+    return static_cast<SQL::AST::Select&>(*statement);
+}
+
+Vector<SQL::Tuple> read_plan(SQL::AST::QueryPlan& plan)
+{
+    Vector<SQL::Tuple> rows;
+    while (true) {
+        auto row = MUST(plan.next());
+        if (!row.has_value())
+            break;
+        rows.append(row.release_value());
+    }
+    return rows;
+}
+
+TEST_CASE(compiled_expressions)
+{
+    ScopeGuard guard([]() { unlink(db_name); });
+    auto database = MUST(SQL::Database::create(db_name));
+    MUST(database->open());
+    create_table(database);
+    auto table = MUST(database->get_table("TESTSCHEMA", "TESTTABLE"));
+    auto row_descriptor = table->to_tuple_descriptor();
+
+    SQL::Tuple row { row_descriptor };
+    row[0] = "Test"sv;
+    row[1] = 42;
+
+    auto placeholder_values = placeholders(3);
+    SQL::AST::ExecutionContext context { database, nullptr, placeholder_values, &row };
+
+    auto compile = [&](StringView expression) {
+        auto select = parse_select(ByteString::formatted("SELECT * FROM TestSchema.TestTable WHERE {};", expression));
+        return MUST(SQL::AST::CompiledExpression::compile(*select->where_clause(), row_descriptor));
+    };
+
+    auto constant = compile("1 + 2 * 3 - 4"sv);
+    EXPECT(constant.is_constant());
+    EXPECT_EQ(constant.instruction_count(), 0u);
+
+    auto arithmetic = compile("IntColumn + 2 * 3"sv);
+    EXPECT_EQ(arithmetic.instruction_count(), 1u);
+    EXPECT_EQ(MUST(arithmetic.evaluate(context)), 48);
+
+    auto with_placeholder = compile("IntColumn * ?"sv);
+    EXPECT_EQ(with_placeholder.instruction_count(), 2u);
+    EXPECT_EQ(MUST(with_placeholder.evaluate(context)), 126);
+
+    auto like = compile("TestTable.TextColumn LIKE 'T_s%'"sv);
+    EXPECT_EQ(like.instruction_count(), 1u);
+    EXPECT_EQ(MUST(like.evaluate(context)), true);
+
+    // Errors are reported when the expression is evaluated, just like before it was compiled.
+    auto missing_column = compile("BogusColumn + 1"sv);
+    auto error = missing_column.evaluate(context);
+    EXPECT(error.is_error());
+    EXPECT_EQ(error.error().error(), SQL::SQLErrorCode::ColumnDoesNotExist);
+
+    auto type_mismatch = compile("1 || 'x'"sv);
+    EXPECT(!type_mismatch.is_constant());
+    error = type_mismatch.evaluate(context);
+    EXPECT(error.is_error());
+    EXPECT_EQ(error.error().error(), SQL::SQLErrorCode::BooleanOperatorTypeMismatch);
+}
+
+TEST_CASE(rebind_query_plan)
+{
+    ScopeGuard guard([]() { unlink(db_name); });
+    auto database = MUST(SQL::Database::create(db_name));
+    MUST(database->open());
+    create_table(database);
+    execute(database, "CREATE INDEX IntIndex ON TestSchema.TestTable (IntColumn);");
+
+    for (auto count = 0; count < 20; ++count)
+        execute(database, ByteString::formatted("INSERT INTO TestSchema.TestTable VALUES ( 'T{}', {} );", count, count % 5));
+
+    auto select = parse_select("SELECT TextColumn FROM TestSchema.TestTable WHERE (IntColumn = ?) AND (TextColumn != 'T0') ORDER BY TextColumn;"sv);
+    auto plan = MUST(SQL::AST::QueryPlan::create(*select, database, placeholders(0)));
+    EXPECT_EQ(plan->explain()[3], "      SEARCH TABLE TESTSCHEMA.TESTTABLE USING INDEX INTINDEX (INTCOLUMN=?)");
+
+    auto rows = read_plan(*plan);
+    EXPECT_EQ(rows.size(), 3u);
+    EXPECT_EQ(rows[0][0], "T10"sv);
+
+    // The plan picks up rows that were inserted since it was created, and the new placeholder values.
+    execute(database, "INSERT INTO TestSchema.TestTable VALUES ( 'T20', 3 );");
+    EXPECT(plan->rebind(database, placeholders(3)));
+    rows = read_plan(*plan);
+    EXPECT_EQ(rows.size(), 5u);
+    EXPECT_EQ(rows[0][0], "T13"sv);
+    EXPECT_EQ(rows[4][0], "T8"sv);
+
+    // Values that can't be looked up in the index don't fit the plan.
+    EXPECT(!plan->rebind(database, placeholders("3"sv)));
+    EXPECT(!plan->rebind(database, { SQL::Value {} }));
+
+    // Neither does a table with another index.
+    EXPECT(plan->rebind(database, placeholders(1)));
+    execute(database, "CREATE INDEX TextIndex ON TestSchema.TestTable (TextColumn);");
+    EXPECT(!plan->rebind(database, placeholders(1)));
+
+    auto limited_select = parse_select("SELECT TextColumn FROM TestSchema.TestTable LIMIT ?;"sv);
+    auto limited_plan = MUST(SQL::AST::QueryPlan::create(*limited_select, database, placeholders(2)));
+    EXPECT_EQ(read_plan(*limited_plan).size(), 2u);
+    EXPECT(limited_plan->rebind(database, placeholders(2)));
+    EXPECT_EQ(read_plan(*limited_plan).size(), 2u);
+    EXPECT(!limited_plan->rebind(database, placeholders(3)));
+}
+
 }
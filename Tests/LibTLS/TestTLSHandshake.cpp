@@ -9,7 +9,9 @@
 #include <LibCore/EventLoop.h>
 #include <LibCrypto/ASN1/ASN1.h>
 #include <LibCrypto/ASN1/PEM.h>
+#include <LibCrypto/Curves/X25519.h>
 #include <LibFileSystem/FileSystem.h>
+#include <LibTLS/KeySchedule.h>
 #include <LibTLS/TLSv12.h>
 #include <LibTest/TestCase.h>
 
@@ -82,3 +84,213 @@ TEST_CASE(test_TLS_hello_handshake)
 
     loop.exec();
 }
+
+// The simple 1-RTT handshake with an x25519 key share and TLS_AES_128_GCM_SHA256.
+// https://www.rfc-editor.org/rfc/rfc8448#section-3
+static constexpr auto rfc8448_hash = Crypto::Hash::HashKind::SHA256;
+
+static ByteBuffer rfc8448_client_hello_and_server_hello()
+{
+    Array<u8, 196> const client_hello {
+        0x01, 0x00, 0x00, 0xc0, 0x03, 0x03, 0xcb, 0x34, 0xec, 0xb1, 0xe7, 0x81, 0x63, 0xba, 0x1c, 0x38,
+        0xc6, 0xda, 0xcb, 0x19, 0x6a, 0x6d, 0xff, 0xa2, 0x1a, 0x8d, 0x99, 0x12, 0xec, 0x18, 0xa2, 0xef,
+        0x62, 0x83, 0x02, 0x4d, 0xec, 0xe7, 0x00, 0x00, 0x06, 0x13, 0x01, 0x13, 0x03, 0x13, 0x02, 0x01,
+        0x00, 0x00, 0x91, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x09, 0x00, 0x00, 0x06, 0x73, 0x65, 0x72, 0x76,
+        0x65, 0x72, 0xff, 0x01, 0x00, 0x01, 0x00, 0x00, 0x0a, 0x00, 0x14, 0x00, 0x12, 0x00, 0x1d, 0x00,
+        0x17, 0x00, 0x18, 0x00, 0x19, 0x01, 0x00, 0x01, 0x01, 0x01, 0x02, 0x01, 0x03, 0x01, 0x04, 0x00,
+        0x23, 0x00, 0x00, 0x00, 0x33, 0x00, 0x26, 0x00, 0x24, 0x00, 0x1d, 0x00, 0x20, 0x99, 0x38, 0x1d,
+        0xe5, 0x60, 0xe4, 0xbd, 0x43, 0xd2, 0x3d, 0x8e, 0x43, 0x5a, 0x7d, 0xba, 0xfe, 0xb3, 0xc0, 0x6e,
+        0x51, 0xc1, 0x3c, 0xae, 0x4d, 0x54, 0x13, 0x69, 0x1e, 0x52, 0x9a, 0xaf, 0x2c, 0x00, 0x2b, 0x00,
+        0x03, 0x02, 0x03, 0x04, 0x00, 0x0d, 0x00, 0x20, 0x00, 0x1e, 0x04, 0x03, 0x05, 0x03, 0x06, 0x03,
+        0x02, 0x03, 0x08, 0x04, 0x08, 0x05, 0x08, 0x06, 0x04, 0x01, 0x05, 0x01, 0x06, 0x01, 0x02, 0x01,
+        0x04, 0x02, 0x05, 0x02, 0x06, 0x02, 0x02, 0x02, 0x00, 0x2d, 0x00, 0x02, 0x01, 0x01, 0x00, 0x1c,
+        0x00, 0x02, 0x40, 0x01
+    };
+    Array<u8, 90> const server_hello {
+        0x02, 0x00, 0x00, 0x56, 0x03, 0x03, 0xa6, 0xaf, 0x06, 0xa4, 0x12, 0x18, 0x60, 0xdc, 0x5e, 0x6e,
+        0x60, 0x24, 0x9c, 0xd3, 0x4c, 0x95, 0x93, 0x0c, 0x8a, 0xc5, 0xcb, 0x14, 0x34, 0xda, 0xc1, 0x55,
+        0x77, 0x2e, 0xd3, 0xe2, 0x69, 0x28, 0x00, 0x13, 0x01, 0x00, 0x00, 0x2e, 0x00, 0x33, 0x00, 0x24,
+        0x00, 0x1d, 0x00, 0x20, 0xc9, 0x82, 0x88, 0x76, 0x11, 0x20, 0x95, 0xfe, 0x66, 0x76, 0x2b, 0xdb,
+        0xf7, 0xc6, 0x72, 0xe1, 0x56, 0xd6, 0xcc, 0x25, 0x3b, 0x83, 0x3d, 0xf1, 0xdd, 0x69, 0xb1, 0xb0,
+        0x4e, 0x75, 0x1f, 0x0f, 0x00, 0x2b, 0x00, 0x02, 0x03, 0x04
+    };
+
+    ByteBuffer messages;
+    messages.append(client_hello);
+    messages.append(server_hello);
+    return messages;
+}
+
+TEST_CASE(test_TLS13_key_share_rfc8448)
+{
+    Array<u8, 32> const client_private_key {
+        0x49, 0xaf, 0x42, 0xba, 0x7f, 0x79, 0x94, 0x85, 0x2d, 0x71, 0x3e, 0xf2, 0x78, 0x4b, 0xcb, 0xca,
+        0xa7, 0x91, 0x1d, 0xe2, 0x6a, 0xdc, 0x56, 0x42, 0xcb, 0x63, 0x45, 0x40, 0xe7, 0xea, 0x50, 0x05
+    };
+    Array<u8, 32> const server_private_key {
+        0xb1, 0x58, 0x0e, 0xea, 0xdf, 0x6d, 0xd5, 0x89, 0xb8, 0xef, 0x4f, 0x2d, 0x56, 0x52, 0x57, 0x8c,
+        0xc8, 0x10, 0xe9, 0x98, 0x01, 0x91, 0xec, 0x8d, 0x05, 0x83, 0x08, 0xce, 0xa2, 0x16, 0xa2, 0x1e
+    };
+    Array<u8, 32> const expected_shared_secret {
+        0x8b, 0xd4, 0x05, 0x4f, 0xb5, 0x5b, 0x9d, 0x63, 0xfd, 0xfb, 0xac, 0xf9, 0xf0, 0x4b, 0x9f, 0x0d,
+        0x35, 0xe6, 0xd6, 0x3f, 0x53, 0x75, 0x63, 0xef, 0xd4, 0x62, 0x72, 0x90, 0x0f, 0x89, 0x49, 0x2d
+    };
+
+    // The public keys are the key_share entries of the ClientHello and the ServerHello.
+    auto messages = rfc8448_client_hello_and_server_hello();
+    auto client_public_key = messages.bytes().slice(0x6d, 32);
+    auto server_public_key = messages.bytes().slice(196 + 0x34, 32);
+
+    Crypto::Curves::X25519 curve;
+    EXPECT_EQ(TRY_OR_FAIL(curve.generate_public_key(client_private_key)).bytes(), client_public_key);
+    EXPECT_EQ(TRY_OR_FAIL(curve.generate_public_key(server_private_key)).bytes(), server_public_key);
+
+    auto client_shared_point = TRY_OR_FAIL(curve.compute_coordinate(client_private_key, server_public_key));
+    EXPECT_EQ(TRY_OR_FAIL(curve.derive_premaster_key(client_shared_point)), expected_shared_secret.span());
+    auto server_shared_point = TRY_OR_FAIL(curve.compute_coordinate(server_private_key, client_public_key));
+    EXPECT_EQ(TRY_OR_FAIL(curve.derive_premaster_key(server_shared_point)), expected_shared_secret.span());
+}
+
+TEST_CASE(test_TLS13_key_schedule_rfc8448)
+{
+    Array<u8, 32> const shared_secret {
+        0x8b, 0xd4, 0x05, 0x4f, 0xb5, 0x5b, 0x9d, 0x63, 0xfd, 0xfb, 0xac, 0xf9, 0xf0, 0x4b, 0x9f, 0x0d,
+        0x35, 0xe6, 0xd6, 0x3f, 0x53, 0x75, 0x63, 0xef, 0xd4, 0x62, 0x72, 0x90, 0x0f, 0x89, 0x49, 0x2d
+    };
+    Array<u8, 32> const expected_handshake_secret {
+        0x1d, 0xc8, 0x26, 0xe9, 0x36, 0x06, 0xaa, 0x6f, 0xdc, 0x0a, 0xad, 0xc1, 0x2f, 0x74, 0x1b, 0x01,
+        0x04, 0x6a, 0xa6, 0xb9, 0x9f, 0x69, 0x1e, 0xd2, 0x21, 0xa9, 0xf0, 0xca, 0x04, 0x3f, 0xbe, 0xac
+    };
+    Array<u8, 32> const expected_client_handshake_traffic_secret {
+        0xb3, 0xed, 0xdb, 0x12, 0x6e, 0x06, 0x7f, 0x35, 0xa7, 0x80, 0xb3, 0xab, 0xf4, 0x5e, 0x2d, 0x8f,
+        0x3b, 0x1a, 0x95, 0x07, 0x38, 0xf5, 0x2e, 0x96, 0x00, 0x74, 0x6a, 0x0e, 0x27, 0xa5, 0x5a, 0x21
+    };
+    Array<u8, 32> const expected_server_handshake_traffic_secret {
+        0xb6, 0x7b, 0x7d, 0x69, 0x0c, 0xc1, 0x6c, 0x4e, 0x75, 0xe5, 0x42, 0x13, 0xcb, 0x2d, 0x37, 0xb4,
+        0xe9, 0xc9, 0x12, 0xbc, 0xde, 0xd9, 0x10, 0x5d, 0x42, 0xbe, 0xfd, 0x59, 0xd3, 0x91, 0xad, 0x38
+    };
+    Array<u8, 16> const expected_server_handshake_key {
+        0x3f, 0xce, 0x51, 0x60, 0x09, 0xc2, 0x17, 0x27, 0xd0, 0xf2, 0xe4, 0xe8, 0x6e, 0xe4, 0x03, 0xbc
+    };
+    Array<u8, 12> const expected_server_handshake_iv {
+        0x5d, 0x31, 0x3e, 0xb2, 0x67, 0x12, 0x76, 0xee, 0x13, 0x00, 0x0b, 0x30
+    };
+    Array<u8, 16> const expected_client_handshake_key {
+        0xdb, 0xfa, 0xa6, 0x93, 0xd1, 0x76, 0x2c, 0x5b, 0x66, 0x6a, 0xf5, 0xd9, 0x50, 0x25, 0x8d, 0x01
+    };
+    Array<u8, 12> const expected_client_handshake_iv {
+        0x5b, 0xd3, 0xc7, 0x1b, 0x83, 0x6e, 0x0b, 0x76, 0xbb, 0x73, 0x26, 0x5f
+    };
+    Array<u8, 32> const expected_master_secret {
+        0x18, 0xdf, 0x06, 0x84, 0x3d, 0x13, 0xa0, 0x8b, 0xf2, 0xa4, 0x49, 0x84, 0x4c, 0x5f, 0x8a, 0x47,
+        0x80, 0x01, 0xbc, 0x4d, 0x4c, 0x62, 0x79, 0x84, 0xd5, 0xa4, 0x1d, 0xa8, 0xd0, 0x40, 0x29, 0x19
+    };
+
+    auto messages = rfc8448_client_hello_and_server_hello();
+    auto hash = rfc8448_hash;
+
+    auto zeros = TRY_OR_FAIL(ByteBuffer::create_zeroed(TLS::KeySchedule::hash_length(hash)));
+    auto early_secret = TRY_OR_FAIL(TLS::KeySchedule::hkdf_extract(hash, {}, zeros));
+    auto salt = TRY_OR_FAIL(TLS::KeySchedule::derive_next_stage_salt(hash, early_secret));
+    auto handshake_secret = TRY_OR_FAIL(TLS::KeySchedule::hkdf_extract(hash, salt, shared_secret));
+    EXPECT_EQ(handshake_secret, expected_handshake_secret.span());
+
+    auto transcript_hash = TRY_OR_FAIL(TLS::KeySchedule::hash_of(hash, messages));
+    auto client_handshake_traffic_secret = TRY_OR_FAIL(TLS::KeySchedule::derive_secret(hash, handshake_secret, "c hs traffic"sv, transcript_hash));
+    EXPECT_EQ(client_handshake_traffic_secret, expected_client_handshake_traffic_secret.span());
+    auto server_handshake_traffic_secret = TRY_OR_FAIL(TLS::KeySchedule::derive_secret(hash, handshake_secret, "s hs traffic"sv, transcript_hash));
+    EXPECT_EQ(server_handshake_traffic_secret, expected_server_handshake_traffic_secret.span());
+
+    EXPECT_EQ(TRY_OR_FAIL(TLS::KeySchedule::hkdf_expand_label(hash, server_handshake_traffic_secret, "key"sv, {}, 16)), expected_server_handshake_key.span());
+    EXPECT_EQ(TRY_OR_FAIL(TLS::KeySchedule::hkdf_expand_label(hash, server_handshake_traffic_secret, "iv"sv, {}, 12)), expected_server_handshake_iv.span());
+    EXPECT_EQ(TRY_OR_FAIL(TLS::KeySchedule::hkdf_expand_label(hash, client_handshake_traffic_secret, "key"sv, {}, 16)), expected_client_handshake_key.span());
+    EXPECT_EQ(TRY_OR_FAIL(TLS::KeySchedule::hkdf_expand_label(hash, client_handshake_traffic_secret, "iv"sv, {}, 12)), expected_client_handshake_iv.span());
+
+    salt = TRY_OR_FAIL(TLS::KeySchedule::derive_next_stage_salt(hash, handshake_secret));
+    auto master_secret = TRY_OR_FAIL(TLS::KeySchedule::hkdf_extract(hash, salt, zeros));
+    EXPECT_EQ(master_secret, expected_master_secret.span());
+}
+
+TEST_CASE(test_TLS13_finished_and_application_secrets_rfc8448)
+{
+    Array<u8, 32> const server_handshake_traffic_secret {
+        0xb6, 0x7b, 0x7d, 0x69, 0x0c, 0xc1, 0x6c, 0x4e, 0x75, 0xe5, 0x42, 0x13, 0xcb, 0x2d, 0x37, 0xb4,
+        0xe9, 0xc9, 0x12, 0xbc, 0xde, 0xd9, 0x10, 0x5d, 0x42, 0xbe, 0xfd, 0x59, 0xd3, 0x91, 0xad, 0x38
+    };
+    Array<u8, 32> const client_handshake_traffic_secret {
+        0xb3, 0xed, 0xdb, 0x12, 0x6e, 0x06, 0x7f, 0x35, 0xa7, 0x80, 0xb3, 0xab, 0xf4, 0x5e, 0x2d, 0x8f,
+        0x3b, 0x1a, 0x95, 0x07, 0x38, 0xf5, 0x2e, 0x96, 0x00, 0x74, 0x6a, 0x0e, 0x27, 0xa5, 0x5a, 0x21
+    };
+    Array<u8, 32> const master_secret {
+        0x18, 0xdf, 0x06, 0x84, 0x3d, 0x13, 0xa0, 0x8b, 0xf2, 0xa4, 0x49, 0x84, 0x4c, 0x5f, 0x8a, 0x47,
+        0x80, 0x01, 0xbc, 0x4d, 0x4c, 0x62, 0x79, 0x84, 0xd5, 0xa4, 0x1d, 0xa8, 0xd0, 0x40, 0x29, 0x19
+    };
+    // Transcript-Hash(ClientHello...CertificateVerify)
+    Array<u8, 32> const transcript_hash_up_to_certificate_verify {
+        0xed, 0xb7, 0x72, 0x5f, 0xa7, 0xa3, 0x47, 0x3b, 0x03, 0x1e, 0xc8, 0xef, 0x65, 0xa2, 0x48, 0x54,
+        0x93, 0x90, 0x01, 0x38, 0xa2, 0xb9, 0x12, 0x91, 0x40, 0x7d, 0x79, 0x51, 0xa0, 0x61, 0x10, 0xed
+    };
+    // Transcript-Hash(ClientHello...server Finished)
+    Array<u8, 32> const transcript_hash_up_to_server_finished {
+        0x96, 0x08, 0x10, 0x2a, 0x0f, 0x1c, 0xcc, 0x6d, 0xb6, 0x25, 0x0b, 0x7b, 0x7e, 0x41, 0x7b, 0x1a,
+        0x00, 0x0e, 0xaa, 0xda, 0x3d, 0xaa, 0xe4, 0x77, 0x7a, 0x76, 0x86, 0xc9, 0xff, 0x83, 0xdf, 0x13
+    };
+    // Transcript-Hash(ClientHello...client Finished)
+    Array<u8, 32> const transcript_hash_up_to_client_finished {
+        0x20, 0x91, 0x45, 0xa9, 0x6e, 0xe8, 0xe2, 0xa1, 0x22, 0xff, 0x81, 0x00, 0x47, 0xcc, 0x95, 0x26,
+        0x84, 0x65, 0x8d, 0x60, 0x49, 0xe8, 0x64, 0x29, 0x42, 0x6d, 0xb8, 0x7c, 0x54, 0xad, 0x14, 0x3d
+    };
+    Array<u8, 32> const expected_server_verify_data {
+        0x9b, 0x9b, 0x14, 0x1d, 0x90, 0x63, 0x37, 0xfb, 0xd2, 0xcb, 0xdc, 0xe7, 0x1d, 0xf4, 0xde, 0xda,
+        0x4a, 0xb4, 0x2c, 0x30, 0x95, 0x72, 0xcb, 0x7f, 0xff, 0xee, 0x54, 0x54, 0xb7, 0x8f, 0x07, 0x18
+    };
+    Array<u8, 32> const expected_client_verify_data {
+        0xa8, 0xec, 0x43, 0x6d, 0x67, 0x76, 0x34, 0xae, 0x52, 0x5a, 0xc1, 0xfc, 0xeb, 0xe1, 0x1a, 0x03,
+        0x9e, 0xc1, 0x76, 0x94, 0xfa, 0xc6, 0xe9, 0x85, 0x27, 0xb6, 0x42, 0xf2, 0xed, 0xd5, 0xce, 0x61
+    };
+    Array<u8, 32> const expected_client_application_traffic_secret {
+        0x9e, 0x40, 0x64, 0x6c, 0xe7, 0x9a, 0x7f, 0x9d, 0xc0, 0x5a, 0xf8, 0x88, 0x9b, 0xce, 0x65, 0x52,
+        0x87, 0x5a, 0xfa, 0x0b, 0x06, 0xdf, 0x00, 0x87, 0xf7, 0x92, 0xeb, 0xb7, 0xc1, 0x75, 0x04, 0xa5
+    };
+    Array<u8, 32> const expected_server_application_traffic_secret {
+        0xa1, 0x1a, 0xf9, 0xf0, 0x55, 0x31, 0xf8, 0x56, 0xad, 0x47, 0x11, 0x6b, 0x45, 0xa9, 0x50, 0x32,
+        0x82, 0x04, 0xb4, 0xf4, 0x4b, 0xfb, 0x6b, 0x3a, 0x4b, 0x4f, 0x1f, 0x3f, 0xcb, 0x63, 0x16, 0x43
+    };
+    Array<u8, 16> const expected_server_application_key {
+        0x9f, 0x02, 0x28, 0x3b, 0x6c, 0x9c, 0x07, 0xef, 0xc2, 0x6b, 0xb9, 0xf2, 0xac, 0x92, 0xe3, 0x56
+    };
+    Array<u8, 12> const expected_server_application_iv {
+        0xcf, 0x78, 0x2b, 0x88, 0xdd, 0x83, 0x54, 0x9a, 0xad, 0xf1, 0xe9, 0x84
+    };
+    Array<u8, 32> const expected_resumption_master_secret {
+        0x7d, 0xf2, 0x35, 0xf2, 0x03, 0x1d, 0x2a, 0x05, 0x12, 0x87, 0xd0, 0x2b, 0x02, 0x41, 0xb0, 0xbf,
+        0xda, 0xf8, 0x6c, 0xc8, 0x56, 0x23, 0x1f, 0x2d, 0x5a, 0xba, 0x46, 0xc4, 0x34, 0xec, 0x19, 0x6c
+    };
+    // The pre-shared key that goes with the NewSessionTicket, whose ticket_nonce is 00 00.
+    Array<u8, 2> const ticket_nonce {
+        0x00, 0x00
+    };
+    Array<u8, 32> const expected_pre_shared_key {
+        0x4e, 0xcd, 0x0e, 0xb6, 0xec, 0x3b, 0x4d, 0x87, 0xf5, 0xd6, 0x02, 0x8f, 0x92, 0x2c, 0xa4, 0xc5,
+        0x85, 0x1a, 0x27, 0x7f, 0xd4, 0x13, 0x11, 0xc9, 0xe6, 0x2d, 0x2c, 0x94, 0x92, 0xe1, 0xc4, 0xf3
+    };
+
+    auto hash = rfc8448_hash;
+
+    auto server_verify_data = TRY_OR_FAIL(TLS::KeySchedule::compute_finished_verify_data(hash, server_handshake_traffic_secret, transcript_hash_up_to_certificate_verify));
+    EXPECT_EQ(server_verify_data, expected_server_verify_data.span());
+    auto client_verify_data = TRY_OR_FAIL(TLS::KeySchedule::compute_finished_verify_data(hash, client_handshake_traffic_secret, transcript_hash_up_to_server_finished));
+    EXPECT_EQ(client_verify_data, expected_client_verify_data.span());
+
+    auto client_application_traffic_secret = TRY_OR_FAIL(TLS::KeySchedule::derive_secret(hash, master_secret, "c ap traffic"sv, transcript_hash_up_to_server_finished));
+    EXPECT_EQ(client_application_traffic_secret, expected_client_application_traffic_secret.span());
+    auto server_application_traffic_secret = TRY_OR_FAIL(TLS::KeySchedule::derive_secret(hash, master_secret, "s ap traffic"sv, transcript_hash_up_to_server_finished));
+    EXPECT_EQ(server_application_traffic_secret, expected_server_application_traffic_secret.span());
+    EXPECT_EQ(TRY_OR_FAIL(TLS::KeySchedule::hkdf_expand_label(hash, server_application_traffic_secret, "key"sv, {}, 16)), expected_server_application_key.span());
+    EXPECT_EQ(TRY_OR_FAIL(TLS::KeySchedule::hkdf_expand_label(hash, server_application_traffic_secret, "iv"sv, {}, 12)), expected_server_application_iv.span());
+
+    auto resumption_master_secret = TRY_OR_FAIL(TLS::KeySchedule::derive_secret(hash, master_secret, "res master"sv, transcript_hash_up_to_client_finished));
+    EXPECT_EQ(resumption_master_secret, expected_resumption_master_secret.span());
+    auto pre_shared_key = TRY_OR_FAIL(TLS::KeySchedule::hkdf_expand_label(hash, resumption_master_secret, "resumption"sv, ticket_nonce, TLS::KeySchedule::hash_length(hash)));
+    EXPECT_EQ(pre_shared_key, expected_pre_shared_key.span());
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/LexicalPath.h>
+#include <LibCore/Resource.h>
+#include <LibCore/ResourceImplementationFile.h>
+#include <LibCore/System.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/Font/BitmapFont.h>
+#include <LibGfx/Font/OpenType/Font.h>
+#include <LibGfx/Font/ScaledFont.h>
+#include <LibGfx/Painter.h>
+#include <LibTest/TestCase.h>
+#include <LibWeb/Painting/GlyphRasterCache.h>
+
+static NonnullRefPtr<Gfx::Font> load_vector_font(float point_size)
+{
+    static RefPtr<Gfx::VectorFont> typeface;
+    if (!typeface) {
+#if !defined(AK_OS_SERENITY)
+        // Get from Build/lagom/bin/TestGlyphRasterCache to Build/lagom/Root/res.
+        auto source_root = LexicalPath(MUST(Core::System::current_executable_path())).parent().parent().string();
+        Core::ResourceImplementation::install(make<Core::ResourceImplementationFile>(MUST(String::formatted("{}/Root/res", source_root))));
+#endif
+        auto resource = MUST(Core::Resource::load_from_uri("resource://fonts/LiberationSans-Regular.ttf"sv));
+        typeface = MUST(OpenType::Font::try_load_from_resource(resource));
+    }
+    return typeface->scaled_font(point_size);
+}
+
+// A coverage mask with every value from 0 to 255 in it, in a shape that isn't a multiple of four pixels wide.
+static NonnullRefPtr<Web::Painting::GlyphCoverageMask> create_test_mask()
+{
+    auto glyph_bitmap = MUST(Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, { 23, 13 }));
+    for (int y = 0; y < glyph_bitmap->height(); ++y) {
+        for (int x = 0; x < glyph_bitmap->width(); ++x) {
+            auto coverage = (y * glyph_bitmap->width() + x) % 256;
+            // Leave a few runs of four uncovered pixels, which take a shortcut.
+            if (y % 4 == 1 && x < 8)
+                coverage = 0;
+            glyph_bitmap->set_pixel(x, y, Color(0, 0, 0, coverage));
+        }
+    }
+    return MUST(Web::Painting::GlyphCoverageMask::create_from_glyph_bitmap(*glyph_bitmap));
+}
+
+static NonnullRefPtr<Gfx::Bitmap> create_target(Gfx::BitmapFormat format, bool transparent_stripes)
+{
+    auto target = MUST(Gfx::Bitmap::create(format, { 40, 24 }));
+    for (int y = 0; y < target->height(); ++y) {
+        for (int x = 0; x < target->width(); ++x) {
+            u8 alpha = 255;
+            if (transparent_stripes && x % 7 < 2)
+                alpha = x % 7 == 0 ? 0 : 100;
+            target->set_pixel(x, y, Color(x * 6, y * 10, 200 - x * 3, alpha));
+        }
+    }
+    return target;
+}
+
+// Gfx::Bitmap::get_pixel() can't read RGBA8888 bitmaps.
+static Color pixel_at(Gfx::Bitmap const& bitmap, int x, int y)
+{
+    if (bitmap.format() != Gfx::BitmapFormat::RGBA8888)
+        return bitmap.get_pixel(x, y);
+    auto rgba = bitmap.scanline(y)[x];
+    return Color(rgba & 0xff, (rgba >> 8) & 0xff, (rgba >> 16) & 0xff, rgba >> 24);
+}
+
+// What blending the color into a pixel with the given coverage should come out as, worked out in floating point.
+static Color expected_pixel(Color destination, u8 coverage, Color color, bool target_is_opaque)
+{
+    if (target_is_opaque)
+        destination = destination.with_alpha(255);
+    float source_alpha = coverage / 255.0f * color.alpha() / 255.0f;
+    float destination_alpha = destination.alpha() / 255.0f;
+    float alpha = source_alpha + destination_alpha * (1 - source_alpha);
+    if (alpha == 0)
+        return destination;
+    auto channel = [&](u8 source, u8 destination) {
+        return static_cast<u8>(round((source * source_alpha + destination * destination_alpha * (1 - source_alpha)) / alpha));
+    };
+    return Color(channel(color.red(), destination.red()), channel(color.green(), destination.green()), channel(color.blue(), destination.blue()), static_cast<u8>(round(alpha * 255)));
+}
+
+static bool is_close_to(Color actual, Color expected, bool compare_alpha)
+{
+    // Translucent results lose a little more to rounding, as their color channels are stored without the alpha applied.
+    int tolerance = expected.alpha() == 255 ? 1 : 2;
+    auto close = [&](u8 a, u8 b) { return abs(a - b) <= tolerance; };
+    if (compare_alpha && !close(actual.alpha(), expected.alpha()))
+        return false;
+    // Fully transparent pixels can have any color.
+    if (expected.alpha() == 0)
+        return actual.alpha() <= 1;
+    return close(actual.red(), expected.red()) && close(actual.green(), expected.green()) && close(actual.blue(), expected.blue());
+}
+
+static void expect_blend_matches_reference(Gfx::BitmapFormat format, bool transparent_stripes, Color color, Gfx::IntRect const& clip_rect, Gfx::IntPoint position)
+{
+    auto mask = create_test_mask();
+    auto before = create_target(format, transparent_stripes);
+    auto after = MUST(before->clone());
+    mask->blend_into(*after, clip_rect, position, color);
+
+    bool target_is_opaque = format == Gfx::BitmapFormat::BGRx8888;
+    auto mask_rect = Gfx::IntRect { position, mask->size() };
+    size_t mismatches = 0;
+    for (int y = 0; y < before->height(); ++y) {
+        for (int x = 0; x < before->width(); ++x) {
+            auto original = pixel_at(*before, x, y);
+            auto expected = original;
+            if (mask_rect.contains(x, y) && clip_rect.contains(x, y)) {
+                auto coverage = ((y - position.y()) * mask->size().width() + (x - position.x())) % 256;
+                if ((y - position.y()) % 4 == 1 && x - position.x() < 8)
+                    coverage = 0;
+                if (coverage != 0)
+                    expected = expected_pixel(original, coverage, color, target_is_opaque);
+            }
+            auto actual = pixel_at(*after, x, y);
+            if (!is_close_to(actual, expected, !target_is_opaque)) {
+                if (mismatches++ < 5)
+                    warnln("Pixel at {},{} is {}, expected {}", x, y, actual, expected);
+            }
+        }
+    }
+    EXPECT_EQ(mismatches, 0u);
+}
+
+TEST_CASE(coverage_mask_blends_like_the_reference_on_opaque_targets)
+{
+    Gfx::IntRect everything { 0, 0, 40, 24 };
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRx8888, false, Color(10, 120, 240), everything, { 3, 5 });
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRx8888, false, Color(10, 120, 240, 128), everything, { 3, 5 });
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRA8888, false, Color(250, 20, 90), everything, { 0, 0 });
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRA8888, false, Color(250, 20, 90, 60), everything, { 1, 2 });
+}
+
+TEST_CASE(coverage_mask_blends_like_the_reference_on_transparent_targets)
+{
+    Gfx::IntRect everything { 0, 0, 40, 24 };
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRA8888, true, Color(250, 20, 90), everything, { 2, 4 });
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRA8888, true, Color(250, 20, 90, 200), everything, { 2, 4 });
+}
+
+TEST_CASE(coverage_mask_blends_into_rgba_targets)
+{
+    Gfx::IntRect everything { 0, 0, 40, 24 };
+    expect_blend_matches_reference(Gfx::BitmapFormat::RGBA8888, false, Color(250, 20, 90), everything, { 5, 1 });
+    expect_blend_matches_reference(Gfx::BitmapFormat::RGBA8888, true, Color(30, 160, 220, 180), everything, { 5, 1 });
+}
+
+TEST_CASE(coverage_mask_is_clipped)
+{
+    // Clip rects that cut the mask at widths that aren't a multiple of four, and masks that hang off the target.
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRx8888, false, Color(10, 120, 240), { 6, 7, 9, 5 }, { 3, 5 });
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRA8888, true, Color(10, 120, 240), { 5, 0, 30, 24 }, { 1, 2 });
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRx8888, false, Color(10, 120, 240), { 0, 0, 40, 24 }, { -5, -3 });
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRx8888, false, Color(10, 120, 240), { 0, 0, 40, 24 }, { 30, 18 });
+    expect_blend_matches_reference(Gfx::BitmapFormat::BGRx8888, false, Color(10, 120, 240), { 0, 0, 40, 24 }, { 50, 30 });
+}
+
+TEST_CASE(cached_glyphs_are_drawn_like_the_painter_draws_them)
+{
+    auto font = load_vector_font(18);
+    u32 const code_points[] = { 'A', 'g', 'W', '&', 0xe9 };
+    Gfx::FloatPoint const positions[] = { { 4, 3 }, { 4.25f, 3 }, { 4.5f, 3.75f }, { 10.8f, 2.1f } };
+    Color const colors[] = { Color::Black, Color(200, 40, 90), Color(0, 0, 255, 128) };
+
+    for (auto code_point : code_points) {
+        for (auto position : positions) {
+            for (auto color : colors) {
+                auto painted = MUST(Gfx::Bitmap::create(Gfx::BitmapFormat::BGRx8888, { 40, 40 }));
+                painted->fill(Color::White);
+                auto blended = MUST(painted->clone());
+
+                Gfx::Painter painter { *painted };
+                painter.draw_glyph(position, code_point, *font, color);
+
+                auto glyph = Web::Painting::GlyphRasterCache::the().rasterize_glyph(*font, code_point, position);
+                VERIFY(glyph.has_value());
+                VERIFY(glyph->mask);
+                glyph->mask->blend_into(*blended, blended->rect(), glyph->position, color);
+
+                size_t mismatches = 0;
+                for (int y = 0; y < painted->height(); ++y) {
+                    for (int x = 0; x < painted->width(); ++x) {
+                        if (!is_close_to(blended->get_pixel(x, y), painted->get_pixel(x, y), false))
+                            ++mismatches;
+                    }
+                }
+                EXPECT_EQ(mismatches, 0u);
+            }
+        }
+    }
+}
+
+TEST_CASE(glyphs_are_only_rasterized_once_per_subpixel_offset)
+{
+    auto font = load_vector_font(14);
+    auto& cache = Web::Painting::GlyphRasterCache::the();
+
+    auto first = cache.rasterize_glyph(*font, 'x', { 10, 10 });
+    VERIFY(first.has_value());
+    VERIFY(first->mask);
+
+    // Moving by whole pixels moves the glyph, but draws it with the same mask.
+    auto moved = cache.rasterize_glyph(*font, 'x', { 25, 13 });
+    VERIFY(moved.has_value());
+    EXPECT_EQ(moved->mask.ptr(), first->mask.ptr());
+    EXPECT_EQ(moved->position, first->position.translated(15, 3));
+
+    // A different subpixel offset needs a mask of its own.
+    auto shifted = cache.rasterize_glyph(*font, 'x', { 10.5f, 10 });
+    VERIFY(shifted.has_value());
+    EXPECT_NE(shifted->mask.ptr(), first->mask.ptr());
+
+    // So does the same glyph in a different size.
+    auto larger = cache.rasterize_glyph(*load_vector_font(28), 'x', { 10, 10 });
+    VERIFY(larger.has_value());
+    EXPECT_NE(larger->mask.ptr(), first->mask.ptr());
+    EXPECT(larger->mask->size().height() > first->mask->size().height());
+}
+
+TEST_CASE(glyphs_without_coverage_have_no_mask)
+{
+    auto font = load_vector_font(14);
+    auto space = Web::Painting::GlyphRasterCache::the().rasterize_glyph(*font, ' ', { 10, 10 });
+    VERIFY(space.has_value());
+    EXPECT(!space->mask);
+}
+
+TEST_CASE(bitmap_font_glyphs_are_left_to_the_painter)
+{
+    auto font = MUST(Gfx::BitmapFont::create(10, 8, true, 256));
+    EXPECT(!Web::Painting::GlyphRasterCache::the().rasterize_glyph(*font, 'A', { 10, 10 }).has_value());
+}
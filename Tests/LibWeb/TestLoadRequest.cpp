@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+#include <LibWeb/Loader/LoadRequest.h>
+
+// ResourceLoader only hands a preloaded response over to a load whose request compares equal to the preload's.
+
+static Web::LoadRequest create_request()
+{
+    Web::LoadRequest request;
+    request.set_url(URL::URL("https://example.com/script.js"sv));
+    request.set_header("Accept", "*/*");
+    request.set_header("Referer", "https://example.com/");
+    request.set_header("Cookie", "a=b");
+    return request;
+}
+
+TEST_CASE(same_request)
+{
+    auto request = create_request();
+    auto other = create_request();
+    EXPECT(request == other);
+    EXPECT_EQ(request.hash(), other.hash());
+
+    // Header names are case-insensitive.
+    other.set_header("accept", "*/*");
+    EXPECT(request == other);
+}
+
+TEST_CASE(different_headers)
+{
+    auto request = create_request();
+
+    auto other = create_request();
+    other.set_header("Accept", "text/css,*/*;q=0.1");
+    EXPECT(request != other);
+
+    other = create_request();
+    other.set_header("Origin", "https://example.com");
+    EXPECT(request != other);
+
+    Web::LoadRequest without_cookies;
+    without_cookies.set_url(URL::URL("https://example.com/script.js"sv));
+    without_cookies.set_header("Accept", "*/*");
+    without_cookies.set_header("Referer", "https://example.com/");
+    EXPECT(request != without_cookies);
+}
+
+TEST_CASE(different_credentials)
+{
+    auto request = create_request();
+    EXPECT(request.includes_credentials());
+
+    auto other = create_request();
+    other.set_includes_credentials(false);
+    EXPECT(request != other);
+}
+
+TEST_CASE(different_method_or_url)
+{
+    auto request = create_request();
+
+    auto other = create_request();
+    other.set_method("POST");
+    EXPECT(request != other);
+
+    other = create_request();
+    other.set_url(URL::URL("https://example.com/other.js"sv));
+    EXPECT(request != other);
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibGfx/Bitmap.h>
+#include <LibTest/TestCase.h>
+#include <LibWeb/Painting/BorderRadiusCornerClipper.h>
+#include <LibWeb/Painting/CommandExecutorCPU.h>
+#include <LibWeb/Painting/CommandList.h>
+#include <LibWeb/Painting/RecordingPainter.h>
+
+static Web::Painting::CornerRadii const corner_radii { { 40, 40 }, { 40, 40 }, { 40, 40 }, { 40, 40 } };
+static Gfx::IntRect const outer_rect { 50, 50, 400, 400 };
+static Gfx::IntRect const inner_rect { 150, 150, 200, 200 };
+
+// What a stacking context records for its contents: a box whose rounded corners clip what's painted inside of it.
+static void record_contents(Web::Painting::RecordingPainter& painter, u32 corner_clipper_id)
+{
+    painter.sample_under_corners(corner_clipper_id, corner_radii, inner_rect, Web::Painting::CornerClip::Outside);
+    painter.fill_rect(inner_rect, Color::Blue);
+    painter.fill_ellipse({ 120, 120, 260, 120 }, Color::Red);
+    painter.blit_corner_clipping(corner_clipper_id, inner_rect);
+}
+
+// The contents are painted inside of another box with rounded corners, whose corner clipper takes the first ID.
+template<typename Callback>
+static void record_page(Web::Painting::CommandList& command_list, Callback record_contents_of_page)
+{
+    Web::Painting::RecordingPainter painter(command_list);
+    painter.fill_rect({ 0, 0, 500, 500 }, Color::White);
+    painter.sample_under_corners(0, corner_radii, outer_rect, Web::Painting::CornerClip::Outside);
+    painter.fill_rect(outer_rect, Color::Green);
+    record_contents_of_page(painter);
+    painter.blit_corner_clipping(0, outer_rect);
+}
+
+static NonnullRefPtr<Gfx::Bitmap> paint(Web::Painting::CommandList& command_list)
+{
+    auto bitmap = MUST(Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, { 500, 500 }));
+    Web::Painting::CommandExecutorCPU executor { *bitmap };
+    command_list.execute(executor);
+    return bitmap;
+}
+
+static bool have_same_pixels(Gfx::Bitmap const& bitmap, Gfx::Bitmap const& other)
+{
+    for (int y = 0; y < bitmap.height(); ++y) {
+        for (int x = 0; x < bitmap.width(); ++x) {
+            if (bitmap.get_pixel(x, y) != other.get_pixel(x, y))
+                return false;
+        }
+    }
+    return true;
+}
+
+// The contents recorded the first time around, where their corner clipper was the only one.
+static Web::Painting::CommandList retain_contents()
+{
+    Web::Painting::CommandList command_list;
+    Web::Painting::RecordingPainter painter(command_list);
+    painter.fill_rect({ 0, 0, 500, 500 }, Color::White);
+    auto first_command_index = command_list.size();
+    record_contents(painter, 0);
+    return command_list.copy_commands_from(first_command_index);
+}
+
+TEST_CASE(retained_commands_paint_like_recording_them_again)
+{
+    auto retained_commands = retain_contents();
+    EXPECT_EQ(retained_commands.size(), 4u);
+
+    Web::Painting::CommandList recorded_again;
+    record_page(recorded_again, [](auto& painter) { record_contents(painter, 1); });
+    auto expected = paint(recorded_again);
+
+    // The box around the contents was cut off at its corners.
+    EXPECT_EQ(expected->get_pixel(outer_rect.left(), outer_rect.top()), Color::White);
+    EXPECT_EQ(expected->get_pixel(inner_rect.left(), inner_rect.top()), Color::Green);
+
+    Web::Painting::CommandList retained;
+    record_page(retained, [&](auto&) { retained.append_commands_of(retained_commands, 1); });
+    EXPECT(have_same_pixels(*paint(retained), *expected));
+}
+
+TEST_CASE(retained_commands_need_corner_clipper_ids_of_their_own)
+{
+    auto retained_commands = retain_contents();
+
+    Web::Painting::CommandList recorded_again;
+    record_page(recorded_again, [](auto& painter) { record_contents(painter, 1); });
+    auto expected = paint(recorded_again);
+
+    // With the IDs they were recorded with, the contents take over the corner clipper of the box around them.
+    Web::Painting::CommandList retained;
+    record_page(retained, [&](auto&) { retained.append_commands_of(retained_commands, 0); });
+    auto bitmap = paint(retained);
+    EXPECT(!have_same_pixels(*bitmap, *expected));
+    EXPECT_EQ(bitmap->get_pixel(outer_rect.left(), outer_rect.top()), Color::Green);
+}
+
+TEST_CASE(retained_commands_can_be_appended_more_than_once)
+{
+    auto retained_commands = retain_contents();
+
+    Web::Painting::CommandList recorded_again;
+    record_page(recorded_again, [](auto& painter) { record_contents(painter, 1); });
+    auto expected = paint(recorded_again);
+
+    // Each frame that doesn't change the contents appends the same commands again.
+    for (int i = 0; i < 3; ++i) {
+        Web::Painting::CommandList retained;
+        record_page(retained, [&](auto&) { retained.append_commands_of(retained_commands, 1); });
+        EXPECT(have_same_pixels(*paint(retained), *expected));
+    }
+    EXPECT_EQ(retained_commands.size(), 4u);
+}
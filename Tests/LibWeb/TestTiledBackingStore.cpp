@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibGfx/Bitmap.h>
+#include <LibTest/TestCase.h>
+#include <LibWeb/Painting/CommandExecutorCPU.h>
+#include <LibWeb/Painting/CommandList.h>
+#include <LibWeb/Painting/RecordingPainter.h>
+#include <LibWeb/Painting/TiledBackingStore.h>
+
+using Web::Painting::TiledBackingStore;
+
+static constexpr Gfx::IntSize viewport_size { 800, 600 };
+static constexpr int tile_size = TiledBackingStore::tile_size;
+
+// The commands for a document with the viewport scrolled to the given location, which are recorded relative to the viewport.
+static Web::Painting::CommandList record_document(Gfx::IntPoint viewport_location)
+{
+    Web::Painting::CommandList command_list;
+    Web::Painting::RecordingPainter painter(command_list);
+    painter.translate(-viewport_location);
+    painter.fill_rect({ -500, -500, 2300, 3000 }, Color::White);
+    for (int i = 0; i < 30; ++i) {
+        painter.fill_rect({ i * 41, i * 67, 150, 90 }, Color(i * 8, 255 - i * 8, 128));
+        painter.fill_ellipse({ 1200 - i * 40, i * 66, 120, 80 }, Color(255, i * 8, 0, 160));
+        painter.draw_line({ 0, i * 67 }, { 1300, 2000 - i * 67 }, Color::Black, 3);
+    }
+    return command_list;
+}
+
+// Commands that paint all of the document in one color, to tell which tiles were painted with them.
+static Web::Painting::CommandList record_fill(Color color)
+{
+    Web::Painting::CommandList command_list;
+    Web::Painting::RecordingPainter painter(command_list);
+    painter.fill_rect({ -5000, -5000, 10000, 10000 }, color);
+    return command_list;
+}
+
+static NonnullRefPtr<Gfx::Bitmap> paint_viewport(Gfx::IntPoint viewport_location)
+{
+    auto command_list = record_document(viewport_location);
+    auto bitmap = MUST(Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, viewport_size));
+    Web::Painting::CommandExecutorCPU executor { *bitmap };
+    command_list.execute(executor);
+    return bitmap;
+}
+
+static NonnullRefPtr<Gfx::Bitmap> copy_viewport(TiledBackingStore const& backing_store, Gfx::IntPoint viewport_location)
+{
+    auto bitmap = MUST(Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, viewport_size));
+    backing_store.copy_into(*bitmap, viewport_location, { viewport_location, viewport_size });
+    return bitmap;
+}
+
+static bool paint_missing_tiles(TiledBackingStore& backing_store, Web::Painting::CommandList& command_list, Gfx::IntPoint viewport_location, size_t maximum_tile_count = NumericLimits<size_t>::max())
+{
+    return backing_store.paint_missing_tiles(command_list, viewport_location, { viewport_location, viewport_size }, Gfx::BitmapFormat::BGRA8888, maximum_tile_count);
+}
+
+static bool have_same_pixels(Gfx::Bitmap const& bitmap, Gfx::Bitmap const& other, Gfx::IntRect const& rect)
+{
+    for (int y = rect.top(); y < rect.bottom(); ++y) {
+        for (int x = rect.left(); x < rect.right(); ++x) {
+            if (bitmap.get_pixel(x, y) != other.get_pixel(x, y))
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool is_filled_with(Gfx::Bitmap const& bitmap, Gfx::IntRect const& rect, Color color)
+{
+    for (int y = rect.top(); y < rect.bottom(); ++y) {
+        for (int x = rect.left(); x < rect.right(); ++x) {
+            if (bitmap.get_pixel(x, y) != color)
+                return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE(tiles_match_painting_the_viewport)
+{
+    // The viewport doesn't line up with the tiles, and the document can extend to negative coordinates.
+    Array<Gfx::IntPoint, 3> const viewport_locations { Gfx::IntPoint { 0, 0 }, { 37, 450 }, { -200, -130 } };
+
+    for (auto viewport_location : viewport_locations) {
+        TiledBackingStore backing_store;
+        auto command_list = record_document(viewport_location);
+        EXPECT(!paint_missing_tiles(backing_store, command_list, viewport_location));
+
+        auto expected = paint_viewport(viewport_location);
+        EXPECT(have_same_pixels(*copy_viewport(backing_store, viewport_location), *expected, expected->rect()));
+    }
+}
+
+TEST_CASE(scrolling_only_paints_tiles_that_were_missing)
+{
+    TiledBackingStore backing_store;
+    auto command_list = record_document({ 0, 0 });
+    paint_missing_tiles(backing_store, command_list, { 0, 0 });
+
+    // The rows of tiles up to y=768 were painted for the first viewport, the row below them comes into view now.
+    Gfx::IntPoint scrolled_viewport_location { 0, 300 };
+    auto fill_command_list = record_fill(Color::Magenta);
+    EXPECT(!paint_missing_tiles(backing_store, fill_command_list, scrolled_viewport_location));
+
+    auto bitmap = copy_viewport(backing_store, scrolled_viewport_location);
+    auto expected = paint_viewport(scrolled_viewport_location);
+    auto first_new_row_in_viewport = 3 * tile_size - scrolled_viewport_location.y();
+    EXPECT(have_same_pixels(*bitmap, *expected, { 0, 0, viewport_size.width(), first_new_row_in_viewport }));
+    EXPECT(is_filled_with(*bitmap, { 0, first_new_row_in_viewport, viewport_size.width(), viewport_size.height() - first_new_row_in_viewport }, Color::Magenta));
+}
+
+TEST_CASE(invalidated_tiles_are_painted_again)
+{
+    TiledBackingStore backing_store;
+    auto command_list = record_document({ 0, 0 });
+    paint_missing_tiles(backing_store, command_list, { 0, 0 });
+
+    // Damaging a few pixels throws away the one tile they're in.
+    backing_store.invalidate({ 300, 300, 10, 10 });
+    auto fill_command_list = record_fill(Color::Magenta);
+    EXPECT(!paint_missing_tiles(backing_store, fill_command_list, { 0, 0 }));
+
+    auto bitmap = copy_viewport(backing_store, { 0, 0 });
+    auto expected = paint_viewport({ 0, 0 });
+    Gfx::IntRect invalidated_tile_rect { tile_size, tile_size, tile_size, tile_size };
+    EXPECT(is_filled_with(*bitmap, invalidated_tile_rect, Color::Magenta));
+    EXPECT(have_same_pixels(*bitmap, *expected, { 0, 0, viewport_size.width(), tile_size }));
+    EXPECT(have_same_pixels(*bitmap, *expected, { 0, tile_size, tile_size, tile_size }));
+    EXPECT(have_same_pixels(*bitmap, *expected, { 2 * tile_size, tile_size, viewport_size.width() - 2 * tile_size, viewport_size.height() - tile_size }));
+
+    // Invalidating everything paints all of it again.
+    backing_store.invalidate_all();
+    EXPECT(!paint_missing_tiles(backing_store, fill_command_list, { 0, 0 }));
+    EXPECT(is_filled_with(*copy_viewport(backing_store, { 0, 0 }), { {}, viewport_size }, Color::Magenta));
+}
+
+TEST_CASE(tiles_closest_to_the_middle_are_painted_first)
+{
+    // The viewport is covered by 4x3 tiles, of which the second one in the second row is closest to its center.
+    TiledBackingStore backing_store;
+    auto fill_command_list = record_fill(Color::Magenta);
+    EXPECT(paint_missing_tiles(backing_store, fill_command_list, { 0, 0 }, 1));
+
+    auto command_list = record_document({ 0, 0 });
+    EXPECT(paint_missing_tiles(backing_store, command_list, { 0, 0 }, 5));
+    EXPECT(!paint_missing_tiles(backing_store, command_list, { 0, 0 }, 6));
+
+    auto bitmap = copy_viewport(backing_store, { 0, 0 });
+    auto expected = paint_viewport({ 0, 0 });
+    EXPECT(is_filled_with(*bitmap, { tile_size, tile_size, tile_size, tile_size }, Color::Magenta));
+    EXPECT(have_same_pixels(*bitmap, *expected, { 0, 0, viewport_size.width(), tile_size }));
+    EXPECT(have_same_pixels(*bitmap, *expected, { 0, tile_size, tile_size, tile_size }));
+    EXPECT(have_same_pixels(*bitmap, *expected, { 2 * tile_size, tile_size, viewport_size.width() - 2 * tile_size, tile_size }));
+    EXPECT(have_same_pixels(*bitmap, *expected, { 0, 2 * tile_size, viewport_size.width(), viewport_size.height() - 2 * tile_size }));
+}
+
+TEST_CASE(tiles_outside_of_a_rect_are_discarded)
+{
+    TiledBackingStore backing_store;
+    auto command_list = record_document({ 0, 0 });
+    paint_missing_tiles(backing_store, command_list, { 0, 0 });
+
+    backing_store.discard_tiles_outside({ 0, 0, tile_size, tile_size });
+    auto fill_command_list = record_fill(Color::Magenta);
+    EXPECT(!paint_missing_tiles(backing_store, fill_command_list, { 0, 0 }));
+
+    auto bitmap = copy_viewport(backing_store, { 0, 0 });
+    auto expected = paint_viewport({ 0, 0 });
+    EXPECT(have_same_pixels(*bitmap, *expected, { 0, 0, tile_size, tile_size }));
+    EXPECT(is_filled_with(*bitmap, { tile_size, 0, viewport_size.width() - tile_size, tile_size }, Color::Magenta));
+    EXPECT(is_filled_with(*bitmap, { 0, tile_size, viewport_size.width(), viewport_size.height() - tile_size }, Color::Magenta));
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/PaintStyle.h>
+#include <LibGfx/Path.h>
+#include <LibTest/TestCase.h>
+#include <LibWeb/Painting/CommandExecutorCPU.h>
+#include <LibWeb/Painting/CommandList.h>
+#include <LibWeb/Painting/RecordingPainter.h>
+
+static void record_commands(Web::Painting::CommandList& command_list)
+{
+    Web::Painting::RecordingPainter painter(command_list);
+    painter.fill_rect({ 0, 0, 1300, 1100 }, Color::White);
+
+    // Shapes that straddle the edges between tiles.
+    for (int i = 0; i < 20; ++i) {
+        painter.fill_rect({ i * 61, i * 53, 150, 90 }, Color(i * 12, 255 - i * 12, 128));
+        painter.fill_ellipse({ 1200 - i * 60, i * 50, 120, 80 }, Color(255, i * 12, 0, 160));
+        painter.draw_line({ 0, i * 55 }, { 1300, 1100 - i * 55 }, Color::Black, 3);
+    }
+    painter.fill_rect_with_rounded_corners({ 400, 400, 300, 300 }, Color::Blue, 40);
+
+    painter.save();
+    painter.add_clip_rect({ 480, 480, 100, 600 });
+    painter.translate(20, 30);
+    painter.fill_rect({ 0, 0, 1300, 1100 }, Color(0, 0, 0, 100));
+    painter.restore();
+
+    Gfx::Path path;
+    path.move_to({ 100, 1000 });
+    path.line_to({ 1200, 600 });
+    path.line_to({ 1250, 1050 });
+    path.close();
+    painter.fill_path({
+        .path = path,
+        .paint_style = MUST(Gfx::SolidColorPaintStyle::create(Color::Magenta)),
+        .opacity = 0.5f,
+    });
+}
+
+static NonnullRefPtr<Gfx::Bitmap> paint_at_once(Web::Painting::CommandList& command_list)
+{
+    auto bitmap = MUST(Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, { 1300, 1100 }));
+    Web::Painting::CommandExecutorCPU executor { *bitmap };
+    command_list.execute(executor);
+    return bitmap;
+}
+
+static bool have_same_pixels(Gfx::Bitmap const& bitmap, Gfx::Bitmap const& other, Gfx::IntRect const& rect)
+{
+    for (int y = rect.top(); y < rect.bottom(); ++y) {
+        for (int x = rect.left(); x < rect.right(); ++x) {
+            if (bitmap.get_pixel(x, y) != other.get_pixel(x, y))
+                return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE(tiles_match_painting_at_once)
+{
+    Web::Painting::CommandList command_list;
+    record_commands(command_list);
+    EXPECT(command_list.can_be_executed_in_tiles());
+
+    auto expected = paint_at_once(command_list);
+
+    auto bitmap = MUST(Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, { 1300, 1100 }));
+    Web::Painting::CommandExecutorCPU::execute_in_tiles(command_list, *bitmap, bitmap->rect());
+    EXPECT(have_same_pixels(*bitmap, *expected, bitmap->rect()));
+}
+
+TEST_CASE(small_tiles_match_painting_at_once)
+{
+    Web::Painting::CommandList command_list;
+    record_commands(command_list);
+
+    auto expected = paint_at_once(command_list);
+
+    // Many more tiles than there are threads to paint them.
+    static constexpr int tile_size = 100;
+    auto bitmap = MUST(Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, { 1300, 1100 }));
+    Vector<Web::Painting::CommandExecutorCPU::Tile> tiles;
+    for (int y = 0; y < bitmap->height(); y += tile_size) {
+        for (int x = 0; x < bitmap->width(); x += tile_size) {
+            auto tile_bitmap = MUST(Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, { tile_size, tile_size }));
+            tiles.append({ move(tile_bitmap), { x, y } });
+        }
+    }
+
+    // Painting twice goes through the same threads again.
+    for (int i = 0; i < 2; ++i) {
+        Web::Painting::CommandExecutorCPU::execute_in_tiles(command_list, tiles);
+        for (auto const& tile : tiles) {
+            auto tile_rect = Gfx::IntRect { tile.location, tile.bitmap->size() };
+            auto expected_tile = MUST(expected->cropped(tile_rect));
+            EXPECT(have_same_pixels(*tile.bitmap, *expected_tile, tile.bitmap->rect()));
+        }
+    }
+}
+
+TEST_CASE(only_the_given_rect_is_painted)
+{
+    Web::Painting::CommandList command_list;
+    record_commands(command_list);
+
+    auto expected = paint_at_once(command_list);
+
+    auto bitmap = MUST(Gfx::Bitmap::create(Gfx::BitmapFormat::BGRA8888, { 1300, 1100 }));
+    bitmap->fill(Color::Green);
+    Gfx::IntRect rect_to_paint { 300, 250, 700, 600 };
+    Web::Painting::CommandExecutorCPU::execute_in_tiles(command_list, *bitmap, rect_to_paint);
+
+    EXPECT(have_same_pixels(*bitmap, *expected, rect_to_paint));
+    EXPECT_EQ(bitmap->get_pixel(rect_to_paint.left() - 1, rect_to_paint.top()), Color::Green);
+    EXPECT_EQ(bitmap->get_pixel(rect_to_paint.right(), rect_to_paint.bottom() - 1), Color::Green);
+    EXPECT_EQ(bitmap->get_pixel(0, 0), Color::Green);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Error.h>
+
+namespace Crypto::Hash {
+
+// https://www.rfc-editor.org/rfc/rfc5869
+class HKDF {
+public:
+    // https://www.rfc-editor.org/rfc/rfc5869#section-2.2
+    template<typename PRF>
+    static ErrorOr<ByteBuffer> extract(ReadonlyBytes salt, ReadonlyBytes input_keying_material)
+    requires requires(PRF t) {
+        t.digest_size();
+    }
+    {
+        // Note: A missing salt is set to HashLen zeros, which is what HMAC pads an empty key to anyway.
+        PRF prf(salt);
+
+        // PRK = HMAC-Hash(salt, IKM)
+        auto pseudorandom_key = prf.process(input_keying_material);
+        return ByteBuffer::copy(pseudorandom_key.immutable_data(), prf.digest_size());
+    }
+
+    // https://www.rfc-editor.org/rfc/rfc5869#section-2.3
+    template<typename PRF>
+    static ErrorOr<ByteBuffer> expand(ReadonlyBytes pseudorandom_key, ReadonlyBytes info, size_t key_length_bytes)
+    requires requires(PRF t) {
+        t.digest_size();
+    }
+    {
+        PRF prf(pseudorandom_key);
+        size_t h_len = prf.digest_size();
+
+        // L: length of output keying material in octets (<= 255*HashLen)
+        if (key_length_bytes > 255 * h_len)
+            return Error::from_string_view("derived key too long"sv);
+
+        auto key = TRY(ByteBuffer::create_uninitialized(key_length_bytes));
+
+        // T(0) = empty string (zero length)
+        // T(i) = HMAC-Hash(PRK, T(i-1) | info | i)
+        // OKM = first L octets of T = T(1) | T(2) | T(3) | ...
+        ReadonlyBytes previous_block;
+        u8 counter = 1;
+        for (size_t offset = 0; offset < key_length_bytes; offset += h_len, ++counter) {
+            prf.update(previous_block);
+            prf.update(info);
+            prf.update(ReadonlyBytes { &counter, 1 });
+            auto block = prf.digest();
+
+            auto block_length = min(h_len, key_length_bytes - offset);
+            key.overwrite(offset, block.immutable_data(), block_length);
+            previous_block = key.bytes().slice(offset, block_length);
+        }
+
+        return key;
+    }
+
+    template<typename PRF>
+    static ErrorOr<ByteBuffer> derive_key(ReadonlyBytes salt, ReadonlyBytes input_keying_material, ReadonlyBytes info, size_t key_length_bytes)
+    {
+        auto pseudorandom_key = TRY(extract<PRF>(salt, input_keying_material));
+        return expand<PRF>(pseudorandom_key, info, key_length_bytes);
+    }
+};
+
+}
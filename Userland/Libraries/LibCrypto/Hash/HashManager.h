@@ -157,6 +157,17 @@ public:
             m_algorithm = Empty {};
             break;
         }
+
+        // Hand anything that was fed to us before we knew the algorithm over to it right away, so that it
+        // shows up in a peek() that isn't preceded by another update().
+        if (!m_pre_init_buffer.is_empty()) {
+            m_algorithm.visit(
+                [&](Empty&) {},
+                [&](auto& hash) {
+                    hash.update(m_pre_init_buffer);
+                    m_pre_init_buffer.clear();
+                });
+        }
     }
 
     virtual void update(u8 const* data, size_t length) override
@@ -176,9 +187,13 @@ public:
 
     virtual DigestType peek() override
     {
+        // Note: The hashes pad their own state to compute the digest, so have a copy do that to be able to keep going.
         return m_algorithm.visit(
             [&](Empty&) -> DigestType { VERIFY_NOT_REACHED(); },
-            [&](auto& hash) -> DigestType { return hash.peek(); });
+            [&](auto& hash) -> DigestType {
+                auto copy = hash;
+                return copy.peek();
+            });
     }
 
     virtual DigestType digest() override
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Endian.h>
+#include <AK/Random.h>
+#include <LibCrypto/Hash/HashManager.h>
+#include <LibCrypto/Hash/SHA1.h>
+#include <LibCrypto/Hash/SHA2.h>
+#include <LibCrypto/PK/Code/Code.h>
+
+namespace Crypto::PK {
+
+// https://www.rfc-editor.org/rfc/rfc8017#section-9.1
+// The salt is as long as the hash, which is what TLS and most other users of PSS ask for.
+template<typename HashFunction>
+class EMSA_PSS : public Code<HashFunction> {
+public:
+    template<typename... Args>
+    EMSA_PSS(Args... args)
+        : Code<HashFunction>(args...)
+    {
+    }
+
+    // https://www.rfc-editor.org/rfc/rfc8017#section-9.1.1
+    virtual void encode(ReadonlyBytes in, ByteBuffer& out, size_t em_bits) override
+    {
+        auto& hash_fn = this->hasher();
+        auto h_len = hash_fn.digest_size();
+        auto s_len = h_len;
+        auto em_len = (em_bits + 7) / 8;
+
+        // 2. Let mHash = Hash(M), an octet string of length hLen.
+        hash_fn.update(in);
+        auto message_hash = hash_fn.digest();
+
+        // 3. If emLen < hLen + sLen + 2, output "encoding error" and stop.
+        if (em_len < h_len + s_len + 2) {
+            dbgln("EMSA-PSS-ENCODE: encoding error");
+            return;
+        }
+
+        // 4. Generate a random octet string salt of length sLen.
+        Vector<u8, 64> salt;
+        salt.resize(s_len);
+        fill_with_random(salt);
+
+        // 5. Let M' = (0x)00 00 00 00 00 00 00 00 || mHash || salt;
+        // 6. Let H = Hash(M'), an octet string of length hLen.
+        auto hash = hash_of_padded_message(message_hash.bytes(), salt);
+
+        // 7. Generate an octet string PS consisting of emLen - sLen - hLen - 2 zero octets.
+        // 8. Let DB = PS || 0x01 || salt; DB is an octet string of length emLen - hLen - 1.
+        auto db_len = em_len - h_len - 1;
+        for (size_t i = 0; i < db_len - s_len - 1; ++i)
+            out[i] = 0x00;
+        out[db_len - s_len - 1] = 0x01;
+        out.overwrite(db_len - s_len, salt.data(), s_len);
+
+        // 9. Let dbMask = MGF(H, emLen - hLen - 1).
+        // 10. Let maskedDB = DB \xor dbMask.
+        apply_mask(out.bytes().slice(0, db_len), hash.bytes());
+
+        // 11. Set the leftmost 8emLen - emBits bits of the leftmost octet in maskedDB to zero.
+        out[0] &= 0xff >> (8 * em_len - em_bits);
+
+        // 12. Let EM = maskedDB || H || 0xbc.
+        out.overwrite(db_len, hash.immutable_data(), h_len);
+        out[em_len - 1] = 0xbc;
+    }
+
+    // https://www.rfc-editor.org/rfc/rfc8017#section-9.1.2
+    virtual VerificationConsistency verify(ReadonlyBytes msg, ReadonlyBytes emsg, size_t em_bits) override
+    {
+        auto& hash_fn = this->hasher();
+        auto h_len = hash_fn.digest_size();
+        auto s_len = h_len;
+        auto em_len = (em_bits + 7) / 8;
+
+        // Note: The RSA verification primitive doesn't keep the leading zeros of the integer it hands us, nor does it
+        //       know about emLen, so line the encoded message up with the emLen octets it is supposed to fill.
+        auto em_result = ByteBuffer::create_zeroed(em_len);
+        if (em_result.is_error())
+            return VerificationConsistency::Inconsistent;
+        auto em = em_result.release_value();
+        while (emsg.size() > em_len) {
+            if (emsg[0] != 0)
+                return VerificationConsistency::Inconsistent;
+            emsg = emsg.slice(1);
+        }
+        em.overwrite(em_len - emsg.size(), emsg.data(), emsg.size());
+
+        // 2. Let mHash = Hash(M), an octet string of length hLen.
+        hash_fn.update(msg);
+        auto message_hash = hash_fn.digest();
+
+        // 3. If emLen < hLen + sLen + 2, output "inconsistent" and stop.
+        if (em_len < h_len + s_len + 2)
+            return VerificationConsistency::Inconsistent;
+
+        // 4. If the rightmost octet of EM does not have hexadecimal value 0xbc, output "inconsistent" and stop.
+        if (em[em_len - 1] != 0xbc)
+            return VerificationConsistency::Inconsistent;
+
+        // 5. Let maskedDB be the leftmost emLen - hLen - 1 octets of EM, and let H be the next hLen octets.
+        auto db_len = em_len - h_len - 1;
+        auto db = em.bytes().slice(0, db_len);
+        auto hash = em.bytes().slice(db_len, h_len);
+
+        // 6. If the leftmost 8emLen - emBits bits of the leftmost octet in maskedDB are not all equal to zero,
+        //    output "inconsistent" and stop.
+        u8 unused_bits_mask = ~(0xff >> (8 * em_len - em_bits));
+        if (db[0] & unused_bits_mask)
+            return VerificationConsistency::Inconsistent;
+
+        // 7. Let dbMask = MGF(H, emLen - hLen - 1).
+        // 8. Let DB = maskedDB \xor dbMask.
+        apply_mask(db, hash);
+
+        // 9. Set the leftmost 8emLen - emBits bits of the leftmost octet in DB to zero.
+        db[0] &= ~unused_bits_mask;
+
+        // 10. If the emLen - hLen - sLen - 2 leftmost octets of DB are not zero or if the octet at position
+        //     emLen - hLen - sLen - 1 (the leftmost position is "position 1") does not have hexadecimal value 0x01,
+        //     output "inconsistent" and stop.
+        for (size_t i = 0; i < db_len - s_len - 1; ++i) {
+            if (db[i] != 0)
+                return VerificationConsistency::Inconsistent;
+        }
+        if (db[db_len - s_len - 1] != 0x01)
+            return VerificationConsistency::Inconsistent;
+
+        // 11. Let salt be the last sLen octets of DB.
+        auto salt = db.slice(db_len - s_len);
+
+        // 12. Let M' = (0x)00 00 00 00 00 00 00 00 || mHash || salt;
+        // 13. Let H' = Hash(M'), an octet string of length hLen.
+        auto expected_hash = hash_of_padded_message(message_hash.bytes(), salt);
+
+        // 14. If H = H', output "consistent." Otherwise, output "inconsistent."
+        if (ReadonlyBytes { hash } != expected_hash.bytes())
+            return VerificationConsistency::Inconsistent;
+        return VerificationConsistency::Consistent;
+    }
+
+private:
+    auto hash_of_padded_message(ReadonlyBytes message_hash, ReadonlyBytes salt)
+    {
+        auto& hash_fn = this->hasher();
+        u8 const padding[8] {};
+        hash_fn.update(padding, sizeof(padding));
+        hash_fn.update(message_hash);
+        hash_fn.update(salt);
+        return hash_fn.digest();
+    }
+
+    // https://www.rfc-editor.org/rfc/rfc8017#appendix-B.2.1
+    void apply_mask(Bytes data, ReadonlyBytes seed)
+    {
+        auto& hash_fn = this->hasher();
+        auto h_len = hash_fn.digest_size();
+        for (u32 counter = 0; counter * h_len < data.size(); ++counter) {
+            auto big_endian_counter = AK::convert_between_host_and_big_endian(counter);
+            hash_fn.update(seed);
+            hash_fn.update(reinterpret_cast<u8 const*>(&big_endian_counter), sizeof(big_endian_counter));
+            auto mask = hash_fn.digest();
+
+            auto offset = counter * h_len;
+            for (size_t i = 0; i < h_len && offset + i < data.size(); ++i)
+                data[offset + i] ^= mask.immutable_data()[i];
+        }
+    }
+};
+
+}
@@ -28,6 +28,8 @@ public:
     ScaledFontMetrics metrics() const { return m_font->metrics(m_x_scale, m_y_scale); }
     ScaledGlyphMetrics glyph_metrics(u32 glyph_id) const { return m_font->glyph_metrics(glyph_id, m_x_scale, m_y_scale, m_point_width, m_point_height); }
     RefPtr<Gfx::Bitmap> rasterize_glyph(u32 glyph_id, GlyphSubpixelOffset) const;
+    // Unlike rasterize_glyph(), this doesn't keep the bitmap around, for callers that have their own cache of glyphs.
+    RefPtr<Gfx::Bitmap> rasterize_glyph_without_caching(u32 glyph_id, GlyphSubpixelOffset subpixel_offset) const { return m_font->rasterize_glyph(glyph_id, m_x_scale, m_y_scale, subpixel_offset); }
     bool append_glyph_path_to(Gfx::Path&, u32 glyph_id) const;
 
     // ^Gfx::Font
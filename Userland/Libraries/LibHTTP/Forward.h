@@ -8,6 +8,8 @@
 
 namespace HTTP {
 
+class Http2Connection;
+class HttpCache;
 class HttpRequest;
 class HttpResponse;
 class HttpsJob;
@@ -0,0 +1,517 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/StringBuilder.h>
+#include <LibHTTP/HPACK.h>
+
+namespace HTTP::HPACK {
+
+// https://www.rfc-editor.org/rfc/rfc7541#section-4.1
+static constexpr size_t entry_overhead = 32;
+
+// Bounds what a peer can make us allocate for a single header block.
+static constexpr size_t maximum_header_list_size = 256 * KiB;
+
+// https://www.rfc-editor.org/rfc/rfc7541#appendix-A
+struct StaticEntry {
+    StringView name;
+    StringView value;
+};
+static constexpr Array<StaticEntry, 61> static_table { {
+    { ":authority"sv, ""sv },
+    { ":method"sv, "GET"sv },
+    { ":method"sv, "POST"sv },
+    { ":path"sv, "/"sv },
+    { ":path"sv, "/index.html"sv },
+    { ":scheme"sv, "http"sv },
+    { ":scheme"sv, "https"sv },
+    { ":status"sv, "200"sv },
+    { ":status"sv, "204"sv },
+    { ":status"sv, "206"sv },
+    { ":status"sv, "304"sv },
+    { ":status"sv, "400"sv },
+    { ":status"sv, "404"sv },
+    { ":status"sv, "500"sv },
+    { "accept-charset"sv, ""sv },
+    { "accept-encoding"sv, "gzip, deflate"sv },
+    { "accept-language"sv, ""sv },
+    { "accept-ranges"sv, ""sv },
+    { "accept"sv, ""sv },
+    { "access-control-allow-origin"sv, ""sv },
+    { "age"sv, ""sv },
+    { "allow"sv, ""sv },
+    { "authorization"sv, ""sv },
+    { "cache-control"sv, ""sv },
+    { "content-disposition"sv, ""sv },
+    { "content-encoding"sv, ""sv },
+    { "content-language"sv, ""sv },
+    { "content-length"sv, ""sv },
+    { "content-location"sv, ""sv },
+    { "content-range"sv, ""sv },
+    { "content-type"sv, ""sv },
+    { "cookie"sv, ""sv },
+    { "date"sv, ""sv },
+    { "etag"sv, ""sv },
+    { "expect"sv, ""sv },
+    { "expires"sv, ""sv },
+    { "from"sv, ""sv },
+    { "host"sv, ""sv },
+    { "if-match"sv, ""sv },
+    { "if-modified-since"sv, ""sv },
+    { "if-none-match"sv, ""sv },
+    { "if-range"sv, ""sv },
+    { "if-unmodified-since"sv, ""sv },
+    { "last-modified"sv, ""sv },
+    { "link"sv, ""sv },
+    { "location"sv, ""sv },
+    { "max-forwards"sv, ""sv },
+    { "proxy-authenticate"sv, ""sv },
+    { "proxy-authorization"sv, ""sv },
+    { "range"sv, ""sv },
+    { "referer"sv, ""sv },
+    { "refresh"sv, ""sv },
+    { "retry-after"sv, ""sv },
+    { "server"sv, ""sv },
+    { "set-cookie"sv, ""sv },
+    { "strict-transport-security"sv, ""sv },
+    { "transfer-encoding"sv, ""sv },
+    { "user-agent"sv, ""sv },
+    { "vary"sv, ""sv },
+    { "via"sv, ""sv },
+    { "www-authenticate"sv, ""sv },
+} };
+
+// https://www.rfc-editor.org/rfc/rfc7541#appendix-B
+// The code of every byte, and of EOS last. The code is canonical, which the decoder relies on.
+struct HuffmanCode {
+    u32 code;
+    u8 length;
+};
+static constexpr u16 huffman_eos = 256;
+static constexpr Array<HuffmanCode, 257> huffman_codes { {
+    { 0x1ff8, 13 }, { 0x7fffd8, 23 }, { 0xfffffe2, 28 }, { 0xfffffe3, 28 },
+    { 0xfffffe4, 28 }, { 0xfffffe5, 28 }, { 0xfffffe6, 28 }, { 0xfffffe7, 28 },
+    { 0xfffffe8, 28 }, { 0xffffea, 24 }, { 0x3ffffffc, 30 }, { 0xfffffe9, 28 },
+    { 0xfffffea, 28 }, { 0x3ffffffd, 30 }, { 0xfffffeb, 28 }, { 0xfffffec, 28 },
+    { 0xfffffed, 28 }, { 0xfffffee, 28 }, { 0xfffffef, 28 }, { 0xffffff0, 28 },
+    { 0xffffff1, 28 }, { 0xffffff2, 28 }, { 0x3ffffffe, 30 }, { 0xffffff3, 28 },
+    { 0xffffff4, 28 }, { 0xffffff5, 28 }, { 0xffffff6, 28 }, { 0xffffff7, 28 },
+    { 0xffffff8, 28 }, { 0xffffff9, 28 }, { 0xffffffa, 28 }, { 0xffffffb, 28 },
+    { 0x14, 6 }, { 0x3f8, 10 }, { 0x3f9, 10 }, { 0xffa, 12 },
+    { 0x1ff9, 13 }, { 0x15, 6 }, { 0xf8, 8 }, { 0x7fa, 11 },
+    { 0x3fa, 10 }, { 0x3fb, 10 }, { 0xf9, 8 }, { 0x7fb, 11 },
+    { 0xfa, 8 }, { 0x16, 6 }, { 0x17, 6 }, { 0x18, 6 },
+    { 0x0, 5 }, { 0x1, 5 }, { 0x2, 5 }, { 0x19, 6 },
+    { 0x1a, 6 }, { 0x1b, 6 }, { 0x1c, 6 }, { 0x1d, 6 },
+    { 0x1e, 6 }, { 0x1f, 6 }, { 0x5c, 7 }, { 0xfb, 8 },
+    { 0x7ffc, 15 }, { 0x20, 6 }, { 0xffb, 12 }, { 0x3fc, 10 },
+    { 0x1ffa, 13 }, { 0x21, 6 }, { 0x5d, 7 }, { 0x5e, 7 },
+    { 0x5f, 7 }, { 0x60, 7 }, { 0x61, 7 }, { 0x62, 7 },
+    { 0x63, 7 }, { 0x64, 7 }, { 0x65, 7 }, { 0x66, 7 },
+    { 0x67, 7 }, { 0x68, 7 }, { 0x69, 7 }, { 0x6a, 7 },
+    { 0x6b, 7 }, { 0x6c, 7 }, { 0x6d, 7 }, { 0x6e, 7 },
+    { 0x6f, 7 }, { 0x70, 7 }, { 0x71, 7 }, { 0x72, 7 },
+    { 0xfc, 8 }, { 0x73, 7 }, { 0xfd, 8 }, { 0x1ffb, 13 },
+    { 0x7fff0, 19 }, { 0x1ffc, 13 }, { 0x3ffc, 14 }, { 0x22, 6 },
+    { 0x7ffd, 15 }, { 0x3, 5 }, { 0x23, 6 }, { 0x4, 5 },
+    { 0x24, 6 }, { 0x5, 5 }, { 0x25, 6 }, { 0x26, 6 },
+    { 0x27, 6 }, { 0x6, 5 }, { 0x74, 7 }, { 0x75, 7 },
+    { 0x28, 6 }, { 0x29, 6 }, { 0x2a, 6 }, { 0x7, 5 },
+    { 0x2b, 6 }, { 0x76, 7 }, { 0x2c, 6 }, { 0x8, 5 },
+    { 0x9, 5 }, { 0x2d, 6 }, { 0x77, 7 }, { 0x78, 7 },
+    { 0x79, 7 }, { 0x7a, 7 }, { 0x7b, 7 }, { 0x7ffe, 15 },
+    { 0x7fc, 11 }, { 0x3ffd, 14 }, { 0x1ffd, 13 }, { 0xffffffc, 28 },
+    { 0xfffe6, 20 }, { 0x3fffd2, 22 }, { 0xfffe7, 20 }, { 0xfffe8, 20 },
+    { 0x3fffd3, 22 }, { 0x3fffd4, 22 }, { 0x3fffd5, 22 }, { 0x7fffd9, 23 },
+    { 0x3fffd6, 22 }, { 0x7fffda, 23 }, { 0x7fffdb, 23 }, { 0x7fffdc, 23 },
+    { 0x7fffdd, 23 }, { 0x7fffde, 23 }, { 0xffffeb, 24 }, { 0x7fffdf, 23 },
+    { 0xffffec, 24 }, { 0xffffed, 24 }, { 0x3fffd7, 22 }, { 0x7fffe0, 23 },
+    { 0xffffee, 24 }, { 0x7fffe1, 23 }, { 0x7fffe2, 23 }, { 0x7fffe3, 23 },
+    { 0x7fffe4, 23 }, { 0x1fffdc, 21 }, { 0x3fffd8, 22 }, { 0x7fffe5, 23 },
+    { 0x3fffd9, 22 }, { 0x7fffe6, 23 }, { 0x7fffe7, 23 }, { 0xffffef, 24 },
+    { 0x3fffda, 22 }, { 0x1fffdd, 21 }, { 0xfffe9, 20 }, { 0x3fffdb, 22 },
+    { 0x3fffdc, 22 }, { 0x7fffe8, 23 }, { 0x7fffe9, 23 }, { 0x1fffde, 21 },
+    { 0x7fffea, 23 }, { 0x3fffdd, 22 }, { 0x3fffde, 22 }, { 0xfffff0, 24 },
+    { 0x1fffdf, 21 }, { 0x3fffdf, 22 }, { 0x7fffeb, 23 }, { 0x7fffec, 23 },
+    { 0x1fffe0, 21 }, { 0x1fffe1, 21 }, { 0x3fffe0, 22 }, { 0x1fffe2, 21 },
+    { 0x7fffed, 23 }, { 0x3fffe1, 22 }, { 0x7fffee, 23 }, { 0x7fffef, 23 },
+    { 0xfffea, 20 }, { 0x3fffe2, 22 }, { 0x3fffe3, 22 }, { 0x3fffe4, 22 },
+    { 0x7ffff0, 23 }, { 0x3fffe5, 22 }, { 0x3fffe6, 22 }, { 0x7ffff1, 23 },
+    { 0x3ffffe0, 26 }, { 0x3ffffe1, 26 }, { 0xfffeb, 20 }, { 0x7fff1, 19 },
+    { 0x3fffe7, 22 }, { 0x7ffff2, 23 }, { 0x3fffe8, 22 }, { 0x1ffffec, 25 },
+    { 0x3ffffe2, 26 }, { 0x3ffffe3, 26 }, { 0x3ffffe4, 26 }, { 0x7ffffde, 27 },
+    { 0x7ffffdf, 27 }, { 0x3ffffe5, 26 }, { 0xfffff1, 24 }, { 0x1ffffed, 25 },
+    { 0x7fff2, 19 }, { 0x1fffe3, 21 }, { 0x3ffffe6, 26 }, { 0x7ffffe0, 27 },
+    { 0x7ffffe1, 27 }, { 0x3ffffe7, 26 }, { 0x7ffffe2, 27 }, { 0xfffff2, 24 },
+    { 0x1fffe4, 21 }, { 0x1fffe5, 21 }, { 0x3ffffe8, 26 }, { 0x3ffffe9, 26 },
+    { 0xffffffd, 28 }, { 0x7ffffe3, 27 }, { 0x7ffffe4, 27 }, { 0x7ffffe5, 27 },
+    { 0xfffec, 20 }, { 0xfffff3, 24 }, { 0xfffed, 20 }, { 0x1fffe6, 21 },
+    { 0x3fffe9, 22 }, { 0x1fffe7, 21 }, { 0x1fffe8, 21 }, { 0x7ffff3, 23 },
+    { 0x3fffea, 22 }, { 0x3fffeb, 22 }, { 0x1ffffee, 25 }, { 0x1ffffef, 25 },
+    { 0xfffff4, 24 }, { 0xfffff5, 24 }, { 0x3ffffea, 26 }, { 0x7ffff4, 23 },
+    { 0x3ffffeb, 26 }, { 0x7ffffe6, 27 }, { 0x3ffffec, 26 }, { 0x3ffffed, 26 },
+    { 0x7ffffe7, 27 }, { 0x7ffffe8, 27 }, { 0x7ffffe9, 27 }, { 0x7ffffea, 27 },
+    { 0x7ffffeb, 27 }, { 0xffffffe, 28 }, { 0x7ffffec, 27 }, { 0x7ffffed, 27 },
+    { 0x7ffffee, 27 }, { 0x7ffffef, 27 }, { 0x7fffff0, 27 }, { 0x3ffffee, 26 },
+    { 0x3fffffff, 30 },
+} };
+
+static constexpr u8 maximum_huffman_code_length = 30;
+
+struct HuffmanDecodingTable {
+    // For each code length, the first code of that length, how many codes have it, and where their symbols start.
+    Array<u32, maximum_huffman_code_length + 1> first_code {};
+    Array<u16, maximum_huffman_code_length + 1> code_count {};
+    Array<u16, maximum_huffman_code_length + 1> first_symbol_index {};
+
+    // The symbols ordered by code.
+    Array<u16, huffman_codes.size()> symbols {};
+};
+
+static HuffmanDecodingTable const& huffman_decoding_table()
+{
+    static HuffmanDecodingTable const table = [] {
+        HuffmanDecodingTable table;
+        size_t symbol_index = 0;
+        for (u8 length = 1; length <= maximum_huffman_code_length; ++length) {
+            table.first_symbol_index[length] = symbol_index;
+            for (u16 symbol = 0; symbol < huffman_codes.size(); ++symbol) {
+                if (huffman_codes[symbol].length != length)
+                    continue;
+                if (table.code_count[length] == 0)
+                    table.first_code[length] = huffman_codes[symbol].code;
+                ++table.code_count[length];
+                table.symbols[symbol_index++] = symbol;
+            }
+        }
+        return table;
+    }();
+    return table;
+}
+
+// https://www.rfc-editor.org/rfc/rfc7541#section-5.2
+static ErrorOr<ByteString> huffman_decode(ReadonlyBytes bytes)
+{
+    auto const& table = huffman_decoding_table();
+
+    StringBuilder builder;
+    u32 code = 0;
+    u8 length = 0;
+    for (auto byte : bytes) {
+        for (int bit = 7; bit >= 0; --bit) {
+            code = (code << 1) | ((byte >> bit) & 1);
+            ++length;
+            if (length > maximum_huffman_code_length)
+                return Error::from_string_literal("HPACK: Invalid Huffman code");
+
+            if (table.code_count[length] == 0 || code < table.first_code[length] || code - table.first_code[length] >= table.code_count[length])
+                continue;
+
+            auto symbol = table.symbols[table.first_symbol_index[length] + code - table.first_code[length]];
+            if (symbol == huffman_eos)
+                return Error::from_string_literal("HPACK: Huffman-encoded string contains EOS");
+            TRY(builder.try_append(static_cast<char>(symbol)));
+            code = 0;
+            length = 0;
+        }
+    }
+
+    // The string is padded with the most significant bits of EOS, which are all ones, to the end of the last byte.
+    if (length > 7 || code != (1u << length) - 1)
+        return Error::from_string_literal("HPACK: Invalid Huffman padding");
+
+    return builder.to_byte_string();
+}
+
+static size_t huffman_encoded_length(StringView string)
+{
+    size_t bit_count = 0;
+    for (auto byte : string.bytes())
+        bit_count += huffman_codes[byte].length;
+    return (bit_count + 7) / 8;
+}
+
+static ErrorOr<void> huffman_encode(StringView string, ByteBuffer& output)
+{
+    u64 bits = 0;
+    u8 bit_count = 0;
+    for (auto byte : string.bytes()) {
+        auto const& code = huffman_codes[byte];
+        bits = (bits << code.length) | code.code;
+        bit_count += code.length;
+        while (bit_count >= 8) {
+            bit_count -= 8;
+            TRY(output.try_append(static_cast<u8>(bits >> bit_count)));
+        }
+    }
+    if (bit_count > 0) {
+        auto padding = 8 - bit_count;
+        TRY(output.try_append(static_cast<u8>((bits << padding) | ((1u << padding) - 1))));
+    }
+    return {};
+}
+
+// https://www.rfc-editor.org/rfc/rfc7541#section-5.1
+static ErrorOr<u64> decode_integer(ReadonlyBytes bytes, size_t& offset, u8 prefix_bits)
+{
+    if (offset >= bytes.size())
+        return Error::from_string_literal("HPACK: Header block ends in an integer");
+
+    u64 const prefix_maximum = (1u << prefix_bits) - 1;
+    u64 value = bytes[offset++] & prefix_maximum;
+    if (value < prefix_maximum)
+        return value;
+
+    for (u8 shift = 0;; shift += 7) {
+        if (offset >= bytes.size())
+            return Error::from_string_literal("HPACK: Header block ends in an integer");
+        // Nothing the decoder deals in needs more than 32 bits.
+        if (shift > 28)
+            return Error::from_string_literal("HPACK: Integer is too large");
+
+        auto byte = bytes[offset++];
+        value += static_cast<u64>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+}
+
+static ErrorOr<void> encode_integer(ByteBuffer& output, u8 first_byte_flags, u8 prefix_bits, u64 value)
+{
+    u64 const prefix_maximum = (1u << prefix_bits) - 1;
+    if (value < prefix_maximum)
+        return output.try_append(static_cast<u8>(first_byte_flags | value));
+
+    TRY(output.try_append(static_cast<u8>(first_byte_flags | prefix_maximum)));
+    value -= prefix_maximum;
+    while (value >= 0x80) {
+        TRY(output.try_append(static_cast<u8>((value & 0x7f) | 0x80)));
+        value >>= 7;
+    }
+    return output.try_append(static_cast<u8>(value));
+}
+
+// https://www.rfc-editor.org/rfc/rfc7541#section-5.2
+static ErrorOr<ByteString> decode_string(ReadonlyBytes bytes, size_t& offset)
+{
+    if (offset >= bytes.size())
+        return Error::from_string_literal("HPACK: Header block ends in a string");
+
+    bool is_huffman_encoded = bytes[offset] & 0x80;
+    auto length = TRY(decode_integer(bytes, offset, 7));
+    if (length > bytes.size() - offset)
+        return Error::from_string_literal("HPACK: String is longer than the header block");
+
+    auto string_bytes = bytes.slice(offset, length);
+    offset += length;
+    if (is_huffman_encoded)
+        return huffman_decode(string_bytes);
+    return ByteString { string_bytes };
+}
+
+static ErrorOr<void> encode_string(ByteBuffer& output, StringView string)
+{
+    auto huffman_length = huffman_encoded_length(string);
+    if (huffman_length < string.length()) {
+        TRY(encode_integer(output, 0x80, 7, huffman_length));
+        return huffman_encode(string, output);
+    }
+    TRY(encode_integer(output, 0, 7, string.length()));
+    return output.try_append(string.bytes());
+}
+
+static size_t entry_size(Header const& header)
+{
+    return header.name.length() + header.value.length() + entry_overhead;
+}
+
+DynamicTable::DynamicTable(size_t maximum_size)
+    : m_maximum_size(maximum_size)
+{
+}
+
+void DynamicTable::set_maximum_size(size_t maximum_size)
+{
+    m_maximum_size = maximum_size;
+    evict_down_to(maximum_size);
+}
+
+void DynamicTable::evict_down_to(size_t size)
+{
+    while (m_size > size)
+        m_size -= entry_size(m_entries.take_last());
+}
+
+// https://www.rfc-editor.org/rfc/rfc7541#section-4.4
+void DynamicTable::add(Header header)
+{
+    auto size = entry_size(header);
+    if (size > m_maximum_size) {
+        // Adding an entry larger than the table empties it, without adding the entry.
+        evict_down_to(0);
+        return;
+    }
+    evict_down_to(m_maximum_size - size);
+    m_entries.prepend(move(header));
+    m_size += size;
+}
+
+Decoder::Decoder(size_t maximum_table_size)
+    : m_table(maximum_table_size)
+    , m_maximum_table_size(maximum_table_size)
+{
+}
+
+// https://www.rfc-editor.org/rfc/rfc7541#section-2.3.3
+ErrorOr<Header> Decoder::header_at(u64 index) const
+{
+    if (index == 0)
+        return Error::from_string_literal("HPACK: Index 0 is not a header");
+    if (index <= static_table.size()) {
+        auto const& entry = static_table[index - 1];
+        return Header { entry.name, entry.value };
+    }
+    index -= static_table.size() + 1;
+    if (index >= m_table.entry_count())
+        return Error::from_string_literal("HPACK: Index is past the end of the dynamic table");
+    return m_table.entry(index);
+}
+
+// https://www.rfc-editor.org/rfc/rfc7541#section-6
+ErrorOr<Vector<Header>> Decoder::decode(ReadonlyBytes header_block)
+{
+    Vector<Header> headers;
+    size_t header_list_size = 0;
+    bool may_update_table_size = true;
+
+    size_t offset = 0;
+    while (offset < header_block.size()) {
+        auto first_byte = header_block[offset];
+
+        // https://www.rfc-editor.org/rfc/rfc7541#section-6.3
+        if ((first_byte & 0xe0) == 0x20) {
+            if (!may_update_table_size)
+                return Error::from_string_literal("HPACK: Dynamic table size update after a header");
+            auto size = TRY(decode_integer(header_block, offset, 5));
+            if (size > m_maximum_table_size)
+                return Error::from_string_literal("HPACK: Dynamic table size update exceeds the maximum");
+            m_table.set_maximum_size(size);
+            continue;
+        }
+        may_update_table_size = false;
+
+        Header header;
+        if (first_byte & 0x80) {
+            // https://www.rfc-editor.org/rfc/rfc7541#section-6.1
+            header = TRY(header_at(TRY(decode_integer(header_block, offset, 7))));
+        } else {
+            // https://www.rfc-editor.org/rfc/rfc7541#section-6.2
+            bool is_indexed = (first_byte & 0xc0) == 0x40;
+            auto name_index = TRY(decode_integer(header_block, offset, is_indexed ? 6 : 4));
+            if (name_index == 0)
+                header.name = TRY(decode_string(header_block, offset));
+            else
+                header.name = TRY(header_at(name_index)).name;
+            header.value = TRY(decode_string(header_block, offset));
+
+            if (is_indexed)
+                m_table.add(header);
+        }
+
+        header_list_size += entry_size(header);
+        if (header_list_size > maximum_header_list_size)
+            return Error::from_string_literal("HPACK: Header list is too large");
+        TRY(headers.try_append(move(header)));
+    }
+
+    return headers;
+}
+
+Encoder::Encoder()
+    : m_table(4096)
+{
+}
+
+void Encoder::set_maximum_table_size(size_t maximum_size)
+{
+    // NOTE: The table never grows beyond the default, so a peer can't make us keep more than that around.
+    maximum_size = min(maximum_size, static_cast<size_t>(4096));
+    if (maximum_size == m_table.maximum_size())
+        return;
+    m_table.set_maximum_size(maximum_size);
+    m_pending_table_size_update = maximum_size;
+}
+
+// https://www.rfc-editor.org/rfc/rfc7541#section-7.1.3
+// Headers whose values mostly differ between requests, which would only push more useful entries out of the table.
+static bool should_index(StringView name)
+{
+    return !name.is_one_of(":path"sv, "content-length"sv, "if-modified-since"sv, "if-none-match"sv, "if-range"sv, "range"sv);
+}
+
+// Headers that shouldn't be compressed against other headers, as that would allow guessing them (as in CRIME).
+static bool is_sensitive(StringView name)
+{
+    return name.is_one_of("authorization"sv, "proxy-authorization"sv);
+}
+
+ErrorOr<ByteBuffer> Encoder::encode(Vector<Header> const& headers)
+{
+    ByteBuffer output;
+
+    if (m_pending_table_size_update.has_value()) {
+        TRY(encode_integer(output, 0x20, 5, *m_pending_table_size_update));
+        m_pending_table_size_update.clear();
+    }
+
+    for (auto const& header : headers) {
+        Optional<size_t> name_index;
+        Optional<size_t> header_index;
+        for (size_t i = 0; i < static_table.size() && !header_index.has_value(); ++i) {
+            if (static_table[i].name != header.name)
+                continue;
+            if (!name_index.has_value())
+                name_index = i + 1;
+            if (static_table[i].value == header.value)
+                header_index = i + 1;
+        }
+        for (size_t i = 0; i < m_table.entry_count() && !header_index.has_value(); ++i) {
+            auto const& entry = m_table.entry(i);
+            if (entry.name != header.name)
+                continue;
+            if (!name_index.has_value())
+                name_index = static_table.size() + i + 1;
+            if (entry.value == header.value)
+                header_index = static_table.size() + i + 1;
+        }
+
+        // https://www.rfc-editor.org/rfc/rfc7541#section-6.1
+        if (header_index.has_value() && !is_sensitive(header.name)) {
+            TRY(encode_integer(output, 0x80, 7, *header_index));
+            continue;
+        }
+
+        // https://www.rfc-editor.org/rfc/rfc7541#section-6.2
+        if (is_sensitive(header.name))
+            TRY(encode_integer(output, 0x10, 4, name_index.value_or(0)));
+        else if (should_index(header.name))
+            TRY(encode_integer(output, 0x40, 6, name_index.value_or(0)));
+        else
+            TRY(encode_integer(output, 0x00, 4, name_index.value_or(0)));
+
+        if (!name_index.has_value())
+            TRY(encode_string(output, header.name));
+        TRY(encode_string(output, header.value));
+
+        if (!is_sensitive(header.name) && should_index(header.name))
+            m_table.add(header);
+    }
+
+    return output;
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/ByteString.h>
+#include <AK/Error.h>
+#include <AK/Optional.h>
+#include <AK/Vector.h>
+
+// https://www.rfc-editor.org/rfc/rfc7541
+// HPACK, the header compression of HTTP/2.
+namespace HTTP::HPACK {
+
+struct Header {
+    ByteString name;
+    ByteString value;
+};
+
+// https://www.rfc-editor.org/rfc/rfc7541#section-2.3.2
+// The headers recently sent on a connection, which both ends keep in sync so they can refer to them by index.
+class DynamicTable {
+public:
+    explicit DynamicTable(size_t maximum_size);
+
+    size_t maximum_size() const { return m_maximum_size; }
+    void set_maximum_size(size_t);
+
+    size_t entry_count() const { return m_entries.size(); }
+    Header const& entry(size_t index) const { return m_entries[index]; }
+
+    // Makes the header the first entry, evicting the oldest ones to make room for it.
+    void add(Header);
+
+private:
+    void evict_down_to(size_t);
+
+    // Newest first.
+    Vector<Header> m_entries;
+    size_t m_size { 0 };
+    size_t m_maximum_size { 0 };
+};
+
+class Decoder {
+public:
+    // The maximum size is the one advertised to the peer in SETTINGS_HEADER_TABLE_SIZE, which its encoder can't exceed.
+    explicit Decoder(size_t maximum_table_size = 4096);
+
+    // Decodes a complete header block. Any error is fatal to the connection, as the tables are out of sync after it.
+    ErrorOr<Vector<Header>> decode(ReadonlyBytes header_block);
+
+private:
+    ErrorOr<Header> header_at(u64 index) const;
+
+    DynamicTable m_table;
+    size_t m_maximum_table_size { 0 };
+};
+
+class Encoder {
+public:
+    Encoder();
+
+    // Follows the peer's SETTINGS_HEADER_TABLE_SIZE. The change is announced at the start of the next header block.
+    void set_maximum_table_size(size_t);
+
+    ErrorOr<ByteBuffer> encode(Vector<Header> const&);
+
+private:
+    DynamicTable m_table;
+    Optional<size_t> m_pending_table_size_update;
+};
+
+}
@@ -0,0 +1,827 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Debug.h>
+#include <AK/StringBuilder.h>
+#include <LibHTTP/Http2Connection.h>
+#include <LibURL/Parser.h>
+
+namespace HTTP {
+
+// https://httpwg.org/specs/rfc9113.html#preface
+static constexpr auto connection_preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"sv;
+
+static constexpr size_t frame_header_size = 9;
+
+// The largest frame the server may send us, which is the default as we don't ask for more.
+static constexpr u32 maximum_received_frame_size = 16384;
+
+// Bounds a header block split over CONTINUATION frames, as the decoder bounds the header list.
+static constexpr size_t maximum_header_block_size = 256 * KiB;
+
+// How much each stream, and the connection as a whole, may receive before we have to acknowledge it. The defaults are
+// 64 KiB, which would stall any connection that's faster than 64 KiB per round trip.
+static constexpr u32 stream_receive_window_size = 1 * MiB;
+static constexpr u32 connection_receive_window_size = 16 * MiB;
+static constexpr u32 default_window_size = 65535;
+static constexpr i64 maximum_window_size = 0x7fffffff;
+
+// https://httpwg.org/specs/rfc9113.html#FrameHeader
+static constexpr u8 flag_end_stream = 0x1;
+static constexpr u8 flag_ack = 0x1;
+static constexpr u8 flag_end_headers = 0x4;
+static constexpr u8 flag_padded = 0x8;
+static constexpr u8 flag_priority = 0x20;
+
+// https://httpwg.org/specs/rfc9113.html#SettingValues
+enum class Setting : u16 {
+    HeaderTableSize = 0x1,
+    EnablePush = 0x2,
+    MaxConcurrentStreams = 0x3,
+    InitialWindowSize = 0x4,
+    MaxFrameSize = 0x5,
+    MaxHeaderListSize = 0x6,
+};
+
+static u32 read_u32(ReadonlyBytes bytes)
+{
+    return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+}
+
+static void append_u16(Vector<u8, 16>& output, u16 value)
+{
+    output.append(value >> 8);
+    output.append(value);
+}
+
+static void append_u32(Vector<u8, 16>& output, u32 value)
+{
+    output.append(value >> 24);
+    output.append(value >> 16);
+    output.append(value >> 8);
+    output.append(value);
+}
+
+// https://www.rfc-editor.org/rfc/rfc9218#section-4
+struct Priority {
+    u8 urgency { 3 };
+    bool incremental { false };
+};
+
+// The priority the request's own Priority header gives it, or else one guessed from what the request accepts: documents
+// and style sheets hold up rendering, while images can be shown as they trickle in.
+static Priority priority_of(HttpRequest const& request, Optional<ByteString const&> priority_header)
+{
+    Priority priority;
+
+    if (priority_header.has_value()) {
+        for (auto parameter : priority_header->split_view(',')) {
+            parameter = parameter.trim_whitespace();
+            if (parameter.starts_with("u="sv)) {
+                if (auto urgency = parameter.substring_view(2).to_number<u8>(); urgency.has_value() && *urgency <= 7)
+                    priority.urgency = *urgency;
+            } else if (parameter.is_one_of("i"sv, "i=?1"sv)) {
+                priority.incremental = true;
+            }
+        }
+        return priority;
+    }
+
+    for (auto const& header : request.headers()) {
+        if (!header.name.equals_ignoring_ascii_case("Accept"sv))
+            continue;
+        if (header.value.starts_with("text/html"sv))
+            priority.urgency = 0;
+        else if (header.value.starts_with("text/css"sv))
+            priority.urgency = 1;
+        else if (header.value.starts_with("image/"sv))
+            priority = { 5, true };
+    }
+    return priority;
+}
+
+// https://httpwg.org/specs/rfc9113.html#HttpRequest
+static ErrorOr<Vector<HPACK::Header>> request_headers_for(HttpRequest const& request, Priority& priority)
+{
+    auto const& url = request.url();
+    Vector<HPACK::Header> headers;
+
+    StringBuilder authority;
+    TRY(authority.try_append(TRY(url.serialized_host())));
+    if (url.port().has_value())
+        TRY(authority.try_appendff(":{}", *url.port()));
+
+    // NOTE: The percent_encode is so that e.g. spaces are properly encoded.
+    StringBuilder path;
+    TRY(path.try_append(URL::percent_encode(url.serialize_path(), URL::PercentEncodeSet::EncodeURI)));
+    if (url.query().has_value()) {
+        TRY(path.try_append('?'));
+        TRY(path.try_append(*url.query()));
+    }
+
+    TRY(headers.try_append({ ":method", request.method_name() }));
+    TRY(headers.try_append({ ":scheme", url.scheme().to_byte_string() }));
+    TRY(headers.try_append({ ":authority", authority.to_byte_string() }));
+    TRY(headers.try_append({ ":path", path.to_byte_string() }));
+
+    Optional<ByteString const&> priority_header;
+    bool has_content_length = false;
+    for (auto const& header : request.headers()) {
+        auto name = header.name.to_lowercase();
+
+        // https://httpwg.org/specs/rfc9113.html#ConnectionSpecific
+        if (name.is_one_of("connection"sv, "host"sv, "keep-alive"sv, "proxy-connection"sv, "transfer-encoding"sv, "upgrade"sv))
+            continue;
+        if (name == "te"sv && !header.value.equals_ignoring_ascii_case("trailers"sv))
+            continue;
+
+        if (name == "content-length"sv)
+            has_content_length = true;
+        else if (name == "priority"sv)
+            priority_header = header.value;
+        TRY(headers.try_append({ move(name), header.value }));
+    }
+
+    if (!has_content_length && (!request.body().is_empty() || request.method() == HttpRequest::Method::POST))
+        TRY(headers.try_append({ "content-length", ByteString::number(request.body().size()) }));
+
+    priority = priority_of(request, priority_header);
+    if (!priority_header.has_value() && (priority.urgency != Priority {}.urgency || priority.incremental))
+        TRY(headers.try_append({ "priority", ByteString::formatted("u={}{}", priority.urgency, priority.incremental ? ", i"sv : ""sv) }));
+
+    return headers;
+}
+
+// https://httpwg.org/specs/rfc9113.html#padding
+static ErrorOr<ReadonlyBytes, Http2Connection::ErrorCode> remove_padding(u8 flags, ReadonlyBytes payload)
+{
+    if (!(flags & flag_padded))
+        return payload;
+    if (payload.is_empty() || payload[0] >= payload.size())
+        return Http2Connection::ErrorCode::ProtocolError;
+    return payload.slice(1, payload.size() - 1 - payload[0]);
+}
+
+Http2Connection::Http2Connection(NonnullOwnPtr<Core::Socket> socket)
+    : m_socket(move(socket))
+{
+    m_socket->on_ready_to_read = [this] { read_from_socket(); };
+    send_connection_preface();
+}
+
+Http2Connection::~Http2Connection()
+{
+    m_socket->on_ready_to_read = nullptr;
+}
+
+void Http2Connection::send_connection_preface()
+{
+    if (auto result = m_socket->write_until_depleted(connection_preface.bytes()); result.is_error()) {
+        dbgln("Http2Connection: Failed to send the connection preface: {}", result.error());
+        deferred_invoke([this] { close(Core::NetworkJob::Error::ConnectionFailed); });
+        return;
+    }
+
+    // https://httpwg.org/specs/rfc9113.html#PUSH_PROMISE
+    // NOTE: We have nowhere to put pushed responses, so we don't want any.
+    Vector<u8, 16> settings;
+    append_u16(settings, to_underlying(Setting::EnablePush));
+    append_u32(settings, 0);
+    append_u16(settings, to_underlying(Setting::InitialWindowSize));
+    append_u32(settings, stream_receive_window_size);
+    send_frame(FrameType::Settings, 0, 0, settings);
+
+    send_window_update(0, connection_receive_window_size - default_window_size);
+}
+
+Http2Connection::StreamHandle Http2Connection::open_stream(HttpRequest const& request, StreamCallbacks callbacks)
+{
+    VERIFY(is_usable());
+
+    auto stream = make<Stream>();
+    stream->handle = m_next_stream_handle++;
+    stream->callbacks = move(callbacks);
+
+    Priority priority;
+    stream->request_headers = request_headers_for(request, priority).release_value_but_fixme_should_propagate_errors();
+    stream->request_body = request.body();
+    stream->urgency = priority.urgency;
+
+    // Streams wait in order of urgency, and in the order they were opened within the same urgency.
+    auto position = m_waiting_streams.find_first_index_if([&](auto const& waiting_stream) { return waiting_stream->urgency > stream->urgency; });
+    auto handle = stream->handle;
+    m_waiting_streams.insert(position.value_or(m_waiting_streams.size()), move(stream));
+
+    dbgln_if(HTTP2_DEBUG, "Http2Connection: Request for {} will get stream handle {} (urgency {})", request.url(), handle, priority.urgency);
+    open_waiting_streams();
+    return handle;
+}
+
+void Http2Connection::cancel_stream(StreamHandle handle)
+{
+    if (m_waiting_streams.remove_first_matching([&](auto const& stream) { return stream->handle == handle; })) {
+        did_become_idle_if_needed();
+        return;
+    }
+
+    for (auto const& it : m_streams) {
+        if (it.value->handle != handle)
+            continue;
+        auto stream_id = it.key;
+        dbgln_if(HTTP2_DEBUG, "Http2Connection: Cancelling stream {}", stream_id);
+        m_streams.remove(stream_id);
+        send_reset_stream(stream_id, ErrorCode::Cancel);
+        open_waiting_streams();
+        did_become_idle_if_needed();
+        return;
+    }
+}
+
+void Http2Connection::open_waiting_streams()
+{
+    while (!m_waiting_streams.is_empty() && m_streams.size() < m_peer_max_concurrent_streams && is_usable()) {
+        auto stream = m_waiting_streams.take_first();
+        auto stream_id = m_next_stream_id;
+        m_next_stream_id += 2;
+
+        stream->id = stream_id;
+        stream->send_window = m_peer_initial_window_size;
+        auto header_block = m_encoder.encode(stream->request_headers);
+        stream->request_headers.clear();
+        bool has_body = !stream->request_body.is_empty();
+        m_streams.set(stream_id, move(stream));
+
+        if (header_block.is_error()) {
+            fail_connection(ErrorCode::InternalError);
+            return;
+        }
+
+        // https://httpwg.org/specs/rfc9113.html#HeaderBlock
+        auto remaining = header_block.value().bytes();
+        auto type = FrameType::Headers;
+        do {
+            auto fragment = remaining.trim(m_peer_max_frame_size);
+            remaining = remaining.slice(fragment.size());
+
+            u8 flags = 0;
+            if (type == FrameType::Headers && !has_body)
+                flags |= flag_end_stream;
+            if (remaining.is_empty())
+                flags |= flag_end_headers;
+            send_frame(type, flags, stream_id, fragment);
+            type = FrameType::Continuation;
+        } while (!remaining.is_empty());
+
+        if (m_is_closed)
+            return;
+        dbgln_if(HTTP2_DEBUG, "Http2Connection: Opened stream {} ({} streams open, {} waiting)", stream_id, m_streams.size(), m_waiting_streams.size());
+    }
+
+    send_request_bodies();
+}
+
+// https://httpwg.org/specs/rfc9113.html#FlowControl
+void Http2Connection::send_request_bodies()
+{
+    Vector<u32> stream_ids;
+    for (auto const& it : m_streams) {
+        if (it.value->request_body_offset < it.value->request_body.size())
+            stream_ids.append(it.key);
+    }
+
+    for (auto stream_id : stream_ids) {
+        while (!m_is_closed && m_connection_send_window > 0) {
+            auto stream = m_streams.get(stream_id);
+            if (!stream.has_value())
+                break;
+
+            auto& body = (*stream)->request_body;
+            auto& offset = (*stream)->request_body_offset;
+            auto size = min(min(static_cast<i64>(body.size() - offset), static_cast<i64>(m_peer_max_frame_size)), min((*stream)->send_window, m_connection_send_window));
+            if (size <= 0)
+                break;
+
+            bool is_last_frame = offset + size == body.size();
+            send_frame(FrameType::Data, is_last_frame ? flag_end_stream : 0, stream_id, body.bytes().slice(offset, size));
+            (*stream)->send_window -= size;
+            m_connection_send_window -= size;
+            offset += size;
+
+            if (is_last_frame) {
+                body.clear();
+                offset = 0;
+                break;
+            }
+        }
+    }
+}
+
+void Http2Connection::read_from_socket()
+{
+    // NOTE: The stream callbacks may drop the last reference to this connection.
+    NonnullRefPtr<Http2Connection> protector(*this);
+
+    while (!m_is_closed) {
+        auto can_read_without_blocking = m_socket->can_read_without_blocking();
+        if (can_read_without_blocking.is_error()) {
+            close(Core::NetworkJob::Error::TransmissionFailed);
+            return;
+        }
+        if (!can_read_without_blocking.value())
+            break;
+
+        auto buffer_size = m_receive_buffer.size();
+        auto buffer = m_receive_buffer.get_bytes_for_writing(64 * KiB);
+        if (buffer.is_error()) {
+            close(Core::NetworkJob::Error::TransmissionFailed);
+            return;
+        }
+
+        auto read_bytes = m_socket->read_some(buffer.value());
+        if (read_bytes.is_error()) {
+            if (read_bytes.error().is_errno() && read_bytes.error().code() == EINTR) {
+                m_receive_buffer.resize(buffer_size);
+                continue;
+            }
+            dbgln("Http2Connection: Failed to read from the socket: {}", read_bytes.error());
+            close(Core::NetworkJob::Error::TransmissionFailed);
+            return;
+        }
+
+        m_receive_buffer.resize(buffer_size + read_bytes.value().size());
+        if (read_bytes.value().is_empty())
+            break;
+    }
+
+    process_received_frames();
+
+    if (!m_is_closed && m_socket->is_eof()) {
+        dbgln_if(HTTP2_DEBUG, "Http2Connection: The server closed the connection");
+        close(Core::NetworkJob::Error::TransmissionFailed);
+    }
+}
+
+void Http2Connection::process_received_frames()
+{
+    size_t offset = 0;
+    while (!m_is_closed) {
+        auto bytes = m_receive_buffer.bytes().slice(offset);
+        if (bytes.size() < frame_header_size)
+            break;
+
+        // https://httpwg.org/specs/rfc9113.html#FrameHeader
+        FrameHeader header {
+            .length = static_cast<u32>((bytes[0] << 16) | (bytes[1] << 8) | bytes[2]),
+            .type = static_cast<FrameType>(bytes[3]),
+            .flags = bytes[4],
+            .stream_id = read_u32(bytes.slice(5)) & 0x7fffffff,
+        };
+        if (header.length > maximum_received_frame_size) {
+            fail_connection(ErrorCode::FrameSizeError);
+            return;
+        }
+        if (bytes.size() < frame_header_size + header.length)
+            break;
+        offset += frame_header_size + header.length;
+
+        dbgln_if(HTTP2_DEBUG, "Http2Connection: Received frame of type {} with flags {:#x} and {} bytes on stream {}", to_underlying(header.type), header.flags, header.length, header.stream_id);
+        if (auto result = handle_frame(header, bytes.slice(frame_header_size, header.length)); result.is_error()) {
+            fail_connection(result.error());
+            return;
+        }
+    }
+
+    if (m_is_closed || offset == 0)
+        return;
+
+    if (offset == m_receive_buffer.size()) {
+        m_receive_buffer.clear();
+        return;
+    }
+    auto remaining_bytes = ByteBuffer::copy(m_receive_buffer.bytes().slice(offset));
+    if (remaining_bytes.is_error()) {
+        close(Core::NetworkJob::Error::TransmissionFailed);
+        return;
+    }
+    m_receive_buffer = remaining_bytes.release_value();
+}
+
+Http2Connection::ConnectionErrorOr Http2Connection::handle_frame(FrameHeader const& header, ReadonlyBytes payload)
+{
+    // https://httpwg.org/specs/rfc9113.html#CONTINUATION
+    if (m_partial_header_block.has_value() && (header.type != FrameType::Continuation || header.stream_id != m_partial_header_block->stream_id))
+        return ErrorCode::ProtocolError;
+
+    switch (header.type) {
+    case FrameType::Data:
+        return handle_data(header, payload);
+    case FrameType::Headers:
+        return handle_headers(header, payload);
+    case FrameType::Priority:
+        // NOTE: These are deprecated, and only the server would have a use for them.
+        if (header.stream_id == 0)
+            return ErrorCode::ProtocolError;
+        return {};
+    case FrameType::ResetStream:
+        return handle_reset_stream(header, payload);
+    case FrameType::Settings:
+        return handle_settings(header, payload);
+    case FrameType::PushPromise:
+        // https://httpwg.org/specs/rfc9113.html#PUSH_PROMISE
+        // "A client cannot push. [...] receipt of a PUSH_PROMISE frame [after disabling push] MUST be treated as a connection
+        //  error of type PROTOCOL_ERROR."
+        return ErrorCode::ProtocolError;
+    case FrameType::Ping:
+        return handle_ping(header, payload);
+    case FrameType::GoAway:
+        return handle_goaway(header, payload);
+    case FrameType::WindowUpdate:
+        return handle_window_update(header, payload);
+    case FrameType::Continuation:
+        return handle_continuation(header, payload);
+    }
+
+    // "Implementations MUST ignore and discard frames of unknown types."
+    return {};
+}
+
+// https://httpwg.org/specs/rfc9113.html#DATA
+Http2Connection::ConnectionErrorOr Http2Connection::handle_data(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (header.stream_id == 0)
+        return ErrorCode::ProtocolError;
+
+    // The whole frame counts against the windows, padding included, even if the stream has been closed since.
+    m_connection_unacknowledged_received_size += header.length;
+    if (m_connection_unacknowledged_received_size >= connection_receive_window_size / 2)
+        send_window_update(0, exchange(m_connection_unacknowledged_received_size, 0));
+
+    auto data = TRY(remove_padding(header.flags, payload));
+
+    auto stream = m_streams.get(header.stream_id);
+    if (!stream.has_value()) {
+        if (header.stream_id >= m_next_stream_id)
+            return ErrorCode::ProtocolError;
+        return {};
+    }
+    if (!(*stream)->has_received_headers) {
+        send_reset_stream(header.stream_id, ErrorCode::ProtocolError);
+        fail_stream(header.stream_id, Core::NetworkJob::Error::ProtocolFailed);
+        return {};
+    }
+
+    if (header.flags & flag_end_stream) {
+        auto ended_stream = m_streams.take(header.stream_id).release_value();
+        ended_stream->callbacks.on_data(data, true);
+        did_close_stream();
+        return {};
+    }
+
+    (*stream)->unacknowledged_received_size += header.length;
+    if ((*stream)->unacknowledged_received_size >= stream_receive_window_size / 2)
+        send_window_update(header.stream_id, exchange((*stream)->unacknowledged_received_size, 0));
+
+    // NOTE: The callback may cancel the stream, which destroys it.
+    auto on_data = move((*stream)->callbacks.on_data);
+    on_data(data, false);
+    if (stream = m_streams.get(header.stream_id); stream.has_value())
+        (*stream)->callbacks.on_data = move(on_data);
+    return {};
+}
+
+// https://httpwg.org/specs/rfc9113.html#HEADERS
+Http2Connection::ConnectionErrorOr Http2Connection::handle_headers(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (header.stream_id == 0)
+        return ErrorCode::ProtocolError;
+
+    auto fragment = TRY(remove_padding(header.flags, payload));
+    if (header.flags & flag_priority) {
+        if (fragment.size() < 5)
+            return ErrorCode::FrameSizeError;
+        fragment = fragment.slice(5);
+    }
+
+    bool end_stream = header.flags & flag_end_stream;
+    if (header.flags & flag_end_headers)
+        return handle_header_block(header.stream_id, fragment, end_stream);
+
+    auto fragment_copy = ByteBuffer::copy(fragment);
+    if (fragment_copy.is_error())
+        return ErrorCode::InternalError;
+    m_partial_header_block = PartialHeaderBlock { header.stream_id, fragment_copy.release_value(), end_stream };
+    return {};
+}
+
+// https://httpwg.org/specs/rfc9113.html#CONTINUATION
+Http2Connection::ConnectionErrorOr Http2Connection::handle_continuation(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (!m_partial_header_block.has_value())
+        return ErrorCode::ProtocolError;
+
+    auto& fragment = m_partial_header_block->fragment;
+    if (fragment.size() + payload.size() > maximum_header_block_size)
+        return ErrorCode::EnhanceYourCalm;
+    if (fragment.try_append(payload).is_error())
+        return ErrorCode::InternalError;
+
+    if (!(header.flags & flag_end_headers))
+        return {};
+
+    auto header_block = m_partial_header_block.release_value();
+    return handle_header_block(header_block.stream_id, header_block.fragment, header_block.end_stream);
+}
+
+Http2Connection::ConnectionErrorOr Http2Connection::handle_header_block(u32 stream_id, ReadonlyBytes header_block, bool end_stream)
+{
+    // NOTE: The block is decoded even if the stream is gone, as it still changes the decoder's table.
+    auto headers = m_decoder.decode(header_block);
+    if (headers.is_error()) {
+        dbgln("Http2Connection: Failed to decode the headers of stream {}: {}", stream_id, headers.error());
+        return ErrorCode::CompressionError;
+    }
+
+    // We don't let the server push, so it can't start any streams.
+    if (stream_id % 2 == 0 || stream_id >= m_next_stream_id)
+        return ErrorCode::ProtocolError;
+
+    auto stream = m_streams.get(stream_id);
+    if (!stream.has_value())
+        return {};
+    (*stream)->has_received_headers = true;
+
+    if (end_stream) {
+        auto ended_stream = m_streams.take(stream_id).release_value();
+        ended_stream->callbacks.on_headers(headers.value(), true);
+        did_close_stream();
+        return {};
+    }
+
+    // NOTE: The callback may cancel the stream, which destroys it.
+    auto on_headers = move((*stream)->callbacks.on_headers);
+    on_headers(headers.value(), false);
+    if (stream = m_streams.get(stream_id); stream.has_value())
+        (*stream)->callbacks.on_headers = move(on_headers);
+    return {};
+}
+
+// https://httpwg.org/specs/rfc9113.html#RST_STREAM
+Http2Connection::ConnectionErrorOr Http2Connection::handle_reset_stream(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (header.stream_id == 0 || header.stream_id >= m_next_stream_id)
+        return ErrorCode::ProtocolError;
+    if (payload.size() != 4)
+        return ErrorCode::FrameSizeError;
+
+    dbgln_if(HTTP2_DEBUG, "Http2Connection: Stream {} was reset with error code {}", header.stream_id, read_u32(payload));
+    if (m_streams.contains(header.stream_id))
+        fail_stream(header.stream_id, Core::NetworkJob::Error::TransmissionFailed);
+    return {};
+}
+
+// https://httpwg.org/specs/rfc9113.html#SETTINGS
+Http2Connection::ConnectionErrorOr Http2Connection::handle_settings(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (header.stream_id != 0)
+        return ErrorCode::ProtocolError;
+    if (header.flags & flag_ack) {
+        if (!payload.is_empty())
+            return ErrorCode::FrameSizeError;
+        return {};
+    }
+    if (payload.size() % 6 != 0)
+        return ErrorCode::FrameSizeError;
+
+    for (size_t offset = 0; offset < payload.size(); offset += 6) {
+        auto identifier = static_cast<Setting>((payload[offset] << 8) | payload[offset + 1]);
+        auto value = read_u32(payload.slice(offset + 2));
+        dbgln_if(HTTP2_DEBUG, "Http2Connection: Setting {} = {}", to_underlying(identifier), value);
+
+        switch (identifier) {
+        case Setting::HeaderTableSize:
+            m_encoder.set_maximum_table_size(value);
+            break;
+        case Setting::EnablePush:
+            if (value > 1)
+                return ErrorCode::ProtocolError;
+            break;
+        case Setting::MaxConcurrentStreams:
+            m_peer_max_concurrent_streams = value;
+            break;
+        case Setting::InitialWindowSize: {
+            if (value > maximum_window_size)
+                return ErrorCode::FlowControlError;
+            // "[A] SETTINGS_INITIAL_WINDOW_SIZE [change] can alter the initial flow-control window size for streams [...]
+            //  the receiver MUST adjust the size of all stream flow-control windows that it maintains by the difference
+            //  between the new value and the old value."
+            auto difference = static_cast<i64>(value) - static_cast<i64>(m_peer_initial_window_size);
+            for (auto& it : m_streams) {
+                it.value->send_window += difference;
+                if (it.value->send_window > maximum_window_size)
+                    return ErrorCode::FlowControlError;
+            }
+            m_peer_initial_window_size = value;
+            break;
+        }
+        case Setting::MaxFrameSize:
+            if (value < 16384 || value > 16777215)
+                return ErrorCode::ProtocolError;
+            m_peer_max_frame_size = value;
+            break;
+        case Setting::MaxHeaderListSize:
+        default:
+            // "An endpoint that receives a SETTINGS frame with any unknown or unsupported identifier MUST ignore that setting."
+            break;
+        }
+    }
+
+    send_frame(FrameType::Settings, flag_ack, 0, {});
+    open_waiting_streams();
+    return {};
+}
+
+// https://httpwg.org/specs/rfc9113.html#PING
+Http2Connection::ConnectionErrorOr Http2Connection::handle_ping(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (header.stream_id != 0)
+        return ErrorCode::ProtocolError;
+    if (payload.size() != 8)
+        return ErrorCode::FrameSizeError;
+
+    if (!(header.flags & flag_ack))
+        send_frame(FrameType::Ping, flag_ack, 0, payload);
+    return {};
+}
+
+// https://httpwg.org/specs/rfc9113.html#GOAWAY
+Http2Connection::ConnectionErrorOr Http2Connection::handle_goaway(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (header.stream_id != 0)
+        return ErrorCode::ProtocolError;
+    if (payload.size() < 8)
+        return ErrorCode::FrameSizeError;
+
+    auto last_stream_id = read_u32(payload) & 0x7fffffff;
+    dbgln_if(HTTP2_DEBUG, "Http2Connection: Server is going away after stream {} with error code {}", last_stream_id, read_u32(payload.slice(4)));
+    m_has_received_goaway = true;
+
+    // The streams after the last one the server will process were never looked at, and neither were the waiting ones.
+    Vector<NonnullOwnPtr<Stream>> unprocessed_streams = move(m_waiting_streams);
+    Vector<u32> unprocessed_stream_ids;
+    for (auto const& it : m_streams) {
+        if (it.key > last_stream_id)
+            unprocessed_stream_ids.append(it.key);
+    }
+    for (auto stream_id : unprocessed_stream_ids)
+        unprocessed_streams.append(m_streams.take(stream_id).release_value());
+
+    for (auto& stream : unprocessed_streams)
+        stream->callbacks.on_error(Core::NetworkJob::Error::ConnectionFailed);
+
+    did_become_idle_if_needed();
+    return {};
+}
+
+// https://httpwg.org/specs/rfc9113.html#WINDOW_UPDATE
+Http2Connection::ConnectionErrorOr Http2Connection::handle_window_update(FrameHeader const& header, ReadonlyBytes payload)
+{
+    if (payload.size() != 4)
+        return ErrorCode::FrameSizeError;
+    auto increment = read_u32(payload) & 0x7fffffff;
+
+    if (header.stream_id == 0) {
+        if (increment == 0)
+            return ErrorCode::ProtocolError;
+        m_connection_send_window += increment;
+        if (m_connection_send_window > maximum_window_size)
+            return ErrorCode::FlowControlError;
+    } else {
+        auto stream = m_streams.get(header.stream_id);
+        if (!stream.has_value())
+            return {};
+
+        (*stream)->send_window += increment;
+        if (increment == 0 || (*stream)->send_window > maximum_window_size) {
+            send_reset_stream(header.stream_id, increment == 0 ? ErrorCode::ProtocolError : ErrorCode::FlowControlError);
+            fail_stream(header.stream_id, Core::NetworkJob::Error::ProtocolFailed);
+            return {};
+        }
+    }
+
+    send_request_bodies();
+    return {};
+}
+
+void Http2Connection::send_frame(FrameType type, u8 flags, u32 stream_id, ReadonlyBytes payload)
+{
+    if (m_is_closed)
+        return;
+
+    auto frame = ByteBuffer::create_uninitialized(frame_header_size + payload.size());
+    if (frame.is_error()) {
+        close(Core::NetworkJob::Error::TransmissionFailed);
+        return;
+    }
+
+    auto& bytes = frame.value();
+    bytes[0] = payload.size() >> 16;
+    bytes[1] = payload.size() >> 8;
+    bytes[2] = payload.size();
+    bytes[3] = to_underlying(type);
+    bytes[4] = flags;
+    bytes[5] = stream_id >> 24;
+    bytes[6] = stream_id >> 16;
+    bytes[7] = stream_id >> 8;
+    bytes[8] = stream_id;
+    bytes.overwrite(frame_header_size, payload.data(), payload.size());
+
+    if (auto result = m_socket->write_until_depleted(bytes); result.is_error()) {
+        dbgln("Http2Connection: Failed to send a frame: {}", result.error());
+        close(Core::NetworkJob::Error::TransmissionFailed);
+    }
+}
+
+void Http2Connection::send_reset_stream(u32 stream_id, ErrorCode error_code)
+{
+    Vector<u8, 16> payload;
+    append_u32(payload, to_underlying(error_code));
+    send_frame(FrameType::ResetStream, 0, stream_id, payload);
+}
+
+void Http2Connection::send_window_update(u32 stream_id, u32 increment)
+{
+    Vector<u8, 16> payload;
+    append_u32(payload, increment);
+    send_frame(FrameType::WindowUpdate, 0, stream_id, payload);
+}
+
+void Http2Connection::fail_stream(u32 stream_id, Core::NetworkJob::Error error)
+{
+    auto stream = m_streams.take(stream_id);
+    if (!stream.has_value())
+        return;
+    stream.value()->callbacks.on_error(error);
+    did_close_stream();
+}
+
+void Http2Connection::did_close_stream()
+{
+    open_waiting_streams();
+    did_become_idle_if_needed();
+}
+
+void Http2Connection::did_become_idle_if_needed()
+{
+    if (m_is_closed || stream_count() != 0)
+        return;
+
+    // Once the server is going away, the connection is no use to anyone.
+    if (m_has_received_goaway) {
+        close(Core::NetworkJob::Error::ConnectionFailed);
+        return;
+    }
+
+    if (on_idle)
+        on_idle();
+}
+
+// https://httpwg.org/specs/rfc9113.html#ConnectionErrorHandler
+void Http2Connection::fail_connection(ErrorCode error_code)
+{
+    dbgln("Http2Connection: Closing the connection with error code {}", to_underlying(error_code));
+
+    // NOTE: We never accept a stream from the server, so the last one we processed is always 0.
+    Vector<u8, 16> payload;
+    append_u32(payload, 0);
+    append_u32(payload, to_underlying(error_code));
+    send_frame(FrameType::GoAway, 0, 0, payload);
+
+    close(Core::NetworkJob::Error::ProtocolFailed);
+}
+
+void Http2Connection::close(Core::NetworkJob::Error error)
+{
+    if (m_is_closed)
+        return;
+    m_is_closed = true;
+    m_socket->on_ready_to_read = nullptr;
+    m_socket->close();
+
+    auto streams = move(m_streams);
+    auto waiting_streams = move(m_waiting_streams);
+    for (auto& it : streams)
+        it.value->callbacks.on_error(error);
+    for (auto& stream : waiting_streams)
+        stream->callbacks.on_error(error);
+
+    // NOTE: Whoever is notified may drop their reference to us, which may well be the last one.
+    deferred_invoke([this] {
+        if (on_close)
+            on_close();
+    });
+}
+
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Function.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/Vector.h>
+#include <LibCore/EventReceiver.h>
+#include <LibCore/NetworkJob.h>
+#include <LibCore/Socket.h>
+#include <LibHTTP/HPACK.h>
+#include <LibHTTP/HttpRequest.h>
+
+namespace HTTP {
+
+// https://httpwg.org/specs/rfc9113.html
+// The client end of an HTTP/2 connection, which carries any number of requests at once, each on its own stream.
+// Requests beyond what the server is willing to have in flight wait for a stream, the most urgent ones first.
+class Http2Connection final : public Core::EventReceiver {
+    C_OBJECT(Http2Connection);
+
+public:
+    virtual ~Http2Connection() override;
+
+    struct StreamCallbacks {
+        // Called for the response headers, any informational responses before them, and the trailers.
+        Function<void(Vector<HPACK::Header> const&, bool end_stream)> on_headers;
+        Function<void(ReadonlyBytes, bool end_stream)> on_data;
+        Function<void(Core::NetworkJob::Error)> on_error;
+    };
+
+    using StreamHandle = u64;
+
+    // The callbacks are not called after the stream has ended, failed, or been cancelled.
+    StreamHandle open_stream(HttpRequest const&, StreamCallbacks);
+    void cancel_stream(StreamHandle);
+
+    // Whether new streams can be opened, which they can't once either end has started to close the connection.
+    bool is_usable() const { return !m_is_closed && !m_has_received_goaway; }
+    size_t stream_count() const { return m_streams.size() + m_waiting_streams.size(); }
+
+    // Called whenever the last stream ends, and once the connection is closed.
+    Function<void()> on_idle;
+    Function<void()> on_close;
+
+    // https://httpwg.org/specs/rfc9113.html#ErrorCodes
+    enum class ErrorCode : u32 {
+        NoError = 0x0,
+        ProtocolError = 0x1,
+        InternalError = 0x2,
+        FlowControlError = 0x3,
+        SettingsTimeout = 0x4,
+        StreamClosed = 0x5,
+        FrameSizeError = 0x6,
+        RefusedStream = 0x7,
+        Cancel = 0x8,
+        CompressionError = 0x9,
+        ConnectError = 0xa,
+        EnhanceYourCalm = 0xb,
+    };
+
+private:
+    explicit Http2Connection(NonnullOwnPtr<Core::Socket>);
+
+    // https://httpwg.org/specs/rfc9113.html#FrameTypes
+    enum class FrameType : u8 {
+        Data = 0x0,
+        Headers = 0x1,
+        Priority = 0x2,
+        ResetStream = 0x3,
+        Settings = 0x4,
+        PushPromise = 0x5,
+        Ping = 0x6,
+        GoAway = 0x7,
+        WindowUpdate = 0x8,
+        Continuation = 0x9,
+    };
+
+    struct FrameHeader {
+        u32 length { 0 };
+        FrameType type { FrameType::Data };
+        u8 flags { 0 };
+        u32 stream_id { 0 };
+    };
+
+    struct Stream {
+        StreamHandle handle { 0 };
+        u32 id { 0 };
+
+        // https://www.rfc-editor.org/rfc/rfc9218#section-4
+        u8 urgency { 3 };
+
+        Vector<HPACK::Header> request_headers;
+        ByteBuffer request_body;
+        size_t request_body_offset { 0 };
+
+        i64 send_window { 0 };
+        u32 unacknowledged_received_size { 0 };
+        bool has_received_headers { false };
+
+        StreamCallbacks callbacks;
+    };
+
+    // A header block that continues in CONTINUATION frames.
+    struct PartialHeaderBlock {
+        u32 stream_id { 0 };
+        ByteBuffer fragment;
+        bool end_stream { false };
+    };
+
+    using ConnectionErrorOr = ErrorOr<void, ErrorCode>;
+
+    void send_connection_preface();
+    void read_from_socket();
+    void process_received_frames();
+    ConnectionErrorOr handle_frame(FrameHeader const&, ReadonlyBytes payload);
+    ConnectionErrorOr handle_data(FrameHeader const&, ReadonlyBytes payload);
+    ConnectionErrorOr handle_headers(FrameHeader const&, ReadonlyBytes payload);
+    ConnectionErrorOr handle_continuation(FrameHeader const&, ReadonlyBytes payload);
+    ConnectionErrorOr handle_header_block(u32 stream_id, ReadonlyBytes header_block, bool end_stream);
+    ConnectionErrorOr handle_reset_stream(FrameHeader const&, ReadonlyBytes payload);
+    ConnectionErrorOr handle_settings(FrameHeader const&, ReadonlyBytes payload);
+    ConnectionErrorOr handle_ping(FrameHeader const&, ReadonlyBytes payload);
+    ConnectionErrorOr handle_goaway(FrameHeader const&, ReadonlyBytes payload);
+    ConnectionErrorOr handle_window_update(FrameHeader const&, ReadonlyBytes payload);
+
+    void send_frame(FrameType, u8 flags, u32 stream_id, ReadonlyBytes payload);
+    void send_reset_stream(u32 stream_id, ErrorCode);
+    void send_window_update(u32 stream_id, u32 increment);
+
+    void open_waiting_streams();
+    void send_request_bodies();
+    void fail_stream(u32 stream_id, Core::NetworkJob::Error);
+    void did_close_stream();
+    void did_become_idle_if_needed();
+
+    void fail_connection(ErrorCode);
+    void close(Core::NetworkJob::Error);
+
+    NonnullOwnPtr<Core::Socket> m_socket;
+    ByteBuffer m_receive_buffer;
+
+    HPACK::Encoder m_encoder;
+    HPACK::Decoder m_decoder;
+    Optional<PartialHeaderBlock> m_partial_header_block;
+
+    HashMap<u32, NonnullOwnPtr<Stream>> m_streams;
+    Vector<NonnullOwnPtr<Stream>> m_waiting_streams;
+    StreamHandle m_next_stream_handle { 1 };
+    u32 m_next_stream_id { 1 };
+
+    // https://httpwg.org/specs/rfc9113.html#SettingValues
+    // The server's settings, which bound what we send it.
+    u32 m_peer_max_concurrent_streams { 100 };
+    u32 m_peer_initial_window_size { 65535 };
+    u32 m_peer_max_frame_size { 16384 };
+
+    i64 m_connection_send_window { 65535 };
+    u32 m_connection_unacknowledged_received_size { 0 };
+
+    bool m_has_received_goaway { false };
+    bool m_is_closed { false };
+};
+
+}
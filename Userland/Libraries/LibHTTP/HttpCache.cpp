@@ -0,0 +1,631 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/Debug.h>
+#include <AK/Endian.h>
+#include <AK/GenericShorthands.h>
+#include <AK/Hex.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/QuickSort.h>
+#include <LibCore/DirIterator.h>
+#include <LibCore/Directory.h>
+#include <LibCore/StandardPaths.h>
+#include <LibCore/System.h>
+#include <LibCrypto/Hash/SHA2.h>
+#include <LibHTTP/HttpCache.h>
+#include <unistd.h>
+
+namespace HTTP {
+
+static constexpr u64 budget_in_bytes = 256 * MiB;
+
+// Larger responses would push too much else out of the cache.
+static constexpr u64 maximum_response_size = budget_in_bytes / 8;
+
+// Eviction goes a bit below the budget, so it isn't needed again right away.
+static constexpr u64 size_after_eviction = budget_in_bytes / 10 * 9;
+
+static constexpr auto temporary_file_extension = ".tmp"sv;
+
+// Temporary files this old were left behind by a RequestServer that didn't get to finish them.
+static constexpr auto abandoned_temporary_file_age = Duration::from_seconds(60 * 60);
+
+// Headers that only apply to a single connection, or that mustn't be replayed from the cache.
+static bool is_header_to_leave_out(StringView name)
+{
+    return name.is_one_of_ignoring_ascii_case("Connection"sv, "Keep-Alive"sv, "Proxy-Connection"sv, "TE"sv, "Transfer-Encoding"sv, "Upgrade"sv, "Set-Cookie"sv);
+}
+
+static Optional<StringView> find_request_header(HashMap<ByteString, ByteString> const& headers, StringView name)
+{
+    for (auto const& header : headers) {
+        if (header.key.equals_ignoring_ascii_case(name))
+            return header.value.view().trim_whitespace();
+    }
+    return {};
+}
+
+static Optional<StringView> find_response_header(HttpCache::Headers const& headers, StringView name)
+{
+    if (auto value = headers.get(name); value.has_value())
+        return value->view().trim_whitespace();
+    return {};
+}
+
+// https://httpwg.org/specs/rfc9111.html#cache-request-directive
+// https://httpwg.org/specs/rfc9111.html#cache-response-directive
+struct CacheControl {
+    Optional<i64> max_age;
+    bool no_cache { false };
+    bool no_store { false };
+};
+
+static CacheControl parse_cache_control(Optional<StringView> value)
+{
+    CacheControl cache_control;
+    if (!value.has_value())
+        return cache_control;
+
+    for (auto directive : value->split_view(',')) {
+        auto name = directive;
+        StringView argument;
+        if (auto equals_index = directive.find('='); equals_index.has_value()) {
+            name = directive.substring_view(0, *equals_index);
+            argument = directive.substring_view(*equals_index + 1).trim_whitespace().trim("\""sv);
+        }
+        name = name.trim_whitespace();
+
+        if (name.equals_ignoring_ascii_case("max-age"sv)) {
+            // NOTE: A max-age that can't be understood makes the response stale right away.
+            cache_control.max_age = max(argument.to_number<i64>().value_or(0), 0);
+        } else if (name.equals_ignoring_ascii_case("no-cache"sv)) {
+            cache_control.no_cache = true;
+        } else if (name.equals_ignoring_ascii_case("no-store"sv)) {
+            cache_control.no_store = true;
+        }
+    }
+    return cache_control;
+}
+
+// https://httpwg.org/specs/rfc9110.html#http.date
+// Only the preferred format, IMF-fixdate ("Sun, 06 Nov 1994 08:49:37 GMT"), which is what servers are required to send.
+static Optional<UnixDateTime> parse_http_date(Optional<StringView> date)
+{
+    static constexpr Array month_names { "Jan"sv, "Feb"sv, "Mar"sv, "Apr"sv, "May"sv, "Jun"sv, "Jul"sv, "Aug"sv, "Sep"sv, "Oct"sv, "Nov"sv, "Dec"sv };
+
+    if (!date.has_value())
+        return {};
+
+    auto parts = date->split_view(' ');
+    if (parts.size() != 6 || parts[5] != "GMT"sv)
+        return {};
+
+    auto day = parts[1].to_number<u8>();
+    auto year = parts[3].to_number<i32>();
+    Optional<u8> month;
+    for (size_t i = 0; i < month_names.size(); ++i) {
+        if (parts[2] == month_names[i])
+            month = i + 1;
+    }
+
+    auto time = parts[4].split_view(':');
+    if (time.size() != 3)
+        return {};
+    auto hour = time[0].to_number<u8>();
+    auto minute = time[1].to_number<u8>();
+    auto second = time[2].to_number<u8>();
+
+    if (!day.has_value() || !month.has_value() || !year.has_value() || !hour.has_value() || !minute.has_value() || !second.has_value())
+        return {};
+    if (*day < 1 || *day > 31 || *hour > 23 || *minute > 59 || *second > 60)
+        return {};
+
+    return UnixDateTime::from_unix_time_parts(*year, *month, *day, *hour, *minute, *second, 0);
+}
+
+// https://httpwg.org/specs/rfc9110.html#overview.of.status.codes
+static bool is_heuristically_cacheable(u32 status_code)
+{
+    return first_is_one_of(status_code, 200u, 203u, 204u, 300u, 301u, 308u, 404u, 405u, 410u, 414u, 501u);
+}
+
+static bool has_validators(HttpCache::Headers const& response_headers)
+{
+    return response_headers.contains("ETag"sv) || response_headers.contains("Last-Modified"sv);
+}
+
+// https://httpwg.org/specs/rfc9111.html#calculating.freshness.lifetime
+static Duration freshness_lifetime(HttpCache::CachedResponse const& response)
+{
+    auto const& headers = response.response_headers;
+
+    auto cache_control = parse_cache_control(find_response_header(headers, "Cache-Control"sv));
+    if (cache_control.max_age.has_value())
+        return Duration::from_seconds(*cache_control.max_age);
+
+    auto date = parse_http_date(find_response_header(headers, "Date"sv)).value_or(response.response_time);
+
+    if (auto expires = find_response_header(headers, "Expires"sv); expires.has_value()) {
+        // NOTE: An Expires header that can't be understood means the response has already expired.
+        auto expiry_date = parse_http_date(expires);
+        if (!expiry_date.has_value() || *expiry_date < date)
+            return Duration::zero();
+        return *expiry_date - date;
+    }
+
+    // https://httpwg.org/specs/rfc9111.html#heuristic.freshness
+    // Like most caches, this uses a tenth of the time since the response was last modified.
+    if (is_heuristically_cacheable(response.status_code)) {
+        if (auto last_modified = parse_http_date(find_response_header(headers, "Last-Modified"sv)); last_modified.has_value() && *last_modified < date)
+            return Duration::from_seconds((date - *last_modified).to_seconds() / 10);
+    }
+
+    return Duration::zero();
+}
+
+// https://httpwg.org/specs/rfc9111.html#age.calculations
+static Duration current_age(HttpCache::CachedResponse const& response, UnixDateTime now)
+{
+    auto const& headers = response.response_headers;
+
+    auto date = parse_http_date(find_response_header(headers, "Date"sv)).value_or(response.response_time);
+    auto age_value = Duration::from_seconds(find_response_header(headers, "Age"sv).value_or(""sv).to_number<i64>().value_or(0));
+
+    auto apparent_age = max(response.response_time - date, Duration::zero());
+    auto response_delay = response.response_time - response.request_time;
+    auto corrected_age_value = age_value + response_delay;
+    auto corrected_initial_age = max(apparent_age, corrected_age_value);
+    auto resident_time = now - response.response_time;
+    return corrected_initial_age + resident_time;
+}
+
+static ByteString file_name_for(URL::URL const& url)
+{
+    auto key = url.serialize(URL::ExcludeFragment::Yes);
+    return encode_hex(Crypto::Hash::SHA256::hash(key).bytes());
+}
+
+static bool is_safe_method(StringView method)
+{
+    return method.is_one_of_ignoring_ascii_case("GET"sv, "HEAD"sv, "OPTIONS"sv, "TRACE"sv);
+}
+
+// Requests the cache stays out of entirely: those it can't answer, and those whose responses it can't store.
+static bool cache_is_bypassed_for(ByteString const& method, URL::URL const& url, HashMap<ByteString, ByteString> const& request_headers)
+{
+    if (!method.equals_ignoring_ascii_case("GET"sv))
+        return true;
+    if (!url.scheme().is_one_of("http"sv, "https"sv))
+        return true;
+
+    if (parse_cache_control(find_request_header(request_headers, "Cache-Control"sv)).no_store)
+        return true;
+
+    // NOTE: Responses to conditional and range requests are the client's business, and responses to requests with
+    //       credentials can only be shared when the server says so, which isn't worth telling apart here.
+    for (auto name : { "Authorization"sv, "Range"sv, "If-Match"sv, "If-None-Match"sv, "If-Modified-Since"sv, "If-Unmodified-Since"sv, "If-Range"sv }) {
+        if (find_request_header(request_headers, name).has_value())
+            return true;
+    }
+    return false;
+}
+
+HttpCache& HttpCache::the()
+{
+    static HttpCache cache;
+    return cache;
+}
+
+ByteString HttpCache::directory()
+{
+    return ByteString::formatted("{}/RequestServer/HTTP", Core::StandardPaths::cache_directory());
+}
+
+HttpCache::HttpCache()
+    : m_directory(directory())
+{
+    if (auto result = Core::Directory::create(m_directory, Core::Directory::CreateDirectories::Yes); result.is_error())
+        dbgln("HttpCache: Unable to create {}: {}", m_directory, result.error());
+    load_index();
+}
+
+ByteString HttpCache::path_of(StringView file_name) const
+{
+    return ByteString::formatted("{}/{}", m_directory, file_name);
+}
+
+void HttpCache::load_index()
+{
+    m_index.clear();
+    m_size = 0;
+
+    auto now = UnixDateTime::now();
+    Core::DirIterator iterator { m_directory, Core::DirIterator::SkipDots };
+    while (iterator.has_next()) {
+        auto file_name = iterator.next_path();
+        auto stat = Core::System::stat(path_of(file_name));
+        if (stat.is_error() || !S_ISREG(stat.value().st_mode))
+            continue;
+        auto modification_time = UnixDateTime::from_seconds_since_epoch(stat.value().st_mtime);
+
+        if (file_name.ends_with(temporary_file_extension)) {
+            if (now - modification_time > abandoned_temporary_file_age)
+                (void)Core::System::unlink(path_of(file_name));
+            continue;
+        }
+
+        m_index.set(file_name, { static_cast<u64>(stat.value().st_size), modification_time });
+        m_size += stat.value().st_size;
+    }
+}
+
+void HttpCache::evict_least_recently_used_responses()
+{
+    // NOTE: Other RequestServers share the directory, so this starts from what's actually in it.
+    load_index();
+    if (m_size <= budget_in_bytes)
+        return;
+
+    Vector<ByteString> file_names;
+    file_names.ensure_capacity(m_index.size());
+    for (auto const& entry : m_index)
+        file_names.unchecked_append(entry.key);
+    quick_sort(file_names, [&](auto const& a, auto const& b) {
+        return m_index.get(a)->last_use_time < m_index.get(b)->last_use_time;
+    });
+
+    for (auto const& file_name : file_names) {
+        if (m_size <= size_after_eviction)
+            break;
+        remove(file_name);
+    }
+    dbgln_if(HTTPCACHE_DEBUG, "HttpCache: Evicted responses down to {} bytes", m_size);
+}
+
+void HttpCache::remove(StringView file_name)
+{
+    (void)Core::System::unlink(path_of(file_name));
+    if (auto entry = m_index.take(file_name); entry.has_value())
+        m_size -= entry->size;
+}
+
+void HttpCache::did_use(StringView file_name)
+{
+    // NOTE: The modification time is how other RequestServers know the response has been used.
+    (void)Core::System::utime(path_of(file_name), {});
+    if (auto entry = m_index.get(file_name); entry.has_value())
+        entry->last_use_time = UnixDateTime::now();
+}
+
+Optional<HttpCache::CachedResponse> HttpCache::read_response(StringView file_name, URL::URL const& url)
+{
+    auto read = [&]() -> ErrorOr<Optional<CachedResponse>> {
+        auto file = TRY(Core::File::open(path_of(file_name), Core::File::OpenMode::Read));
+
+        auto metadata_size = TRY(file->read_value<LittleEndian<u32>>());
+        auto metadata = TRY(ByteBuffer::create_uninitialized(metadata_size));
+        TRY(file->read_until_filled(metadata));
+
+        auto json = TRY(JsonValue::from_string(metadata));
+        if (!json.is_object())
+            return Optional<CachedResponse> {};
+        auto const& object = json.as_object();
+
+        // NOTE: This also rules out the (unlikely) case of two URLs with the same hash.
+        if (object.get_byte_string("url"sv) != url.serialize(URL::ExcludeFragment::Yes))
+            return Optional<CachedResponse> {};
+
+        CachedResponse response;
+        response.file_name = file_name;
+        response.status_code = object.get_u32("status_code"sv).value_or(0);
+        response.request_time = UnixDateTime::from_seconds_since_epoch(object.get_i64("request_time"sv).value_or(0));
+        response.response_time = UnixDateTime::from_seconds_since_epoch(object.get_i64("response_time"sv).value_or(0));
+
+        auto read_headers = [&](StringView key, Headers& headers) {
+            if (auto headers_object = object.get_object(key); headers_object.has_value()) {
+                headers_object->for_each_member([&](auto const& name, auto const& value) {
+                    if (value.is_string())
+                        headers.set(name, value.as_string());
+                });
+            }
+        };
+        read_headers("response_headers"sv, response.response_headers);
+        read_headers("varying_request_headers"sv, response.varying_request_headers);
+
+        response.body_offset = sizeof(u32) + metadata_size;
+        response.body_size = TRY(file->size()) - response.body_offset;
+        return response;
+    };
+
+    auto response_or_error = read();
+    if (response_or_error.is_error()) {
+        // NOTE: Not having a file is how a response not being in the cache looks.
+        if (!response_or_error.error().is_errno() || response_or_error.error().code() != ENOENT) {
+            dbgln("HttpCache: Unable to read {}: {}", file_name, response_or_error.error());
+            remove(file_name);
+        }
+        return {};
+    }
+    return response_or_error.release_value();
+}
+
+ErrorOr<void> HttpCache::write_metadata(Core::File& file, URL::URL const& url, CachedResponse& response)
+{
+    auto headers_to_json = [](Headers const& headers) {
+        JsonObject object;
+        for (auto const& header : headers)
+            object.set(header.key, header.value);
+        return object;
+    };
+
+    JsonObject object;
+    object.set("url", url.serialize(URL::ExcludeFragment::Yes));
+    object.set("status_code", response.status_code);
+    // NOTE: Rounding up would make the response look younger than it is.
+    object.set("request_time", response.request_time.truncated_seconds_since_epoch());
+    object.set("response_time", response.response_time.truncated_seconds_since_epoch());
+    object.set("response_headers", headers_to_json(response.response_headers));
+    object.set("varying_request_headers", headers_to_json(response.varying_request_headers));
+    auto metadata = object.to_byte_string();
+
+    TRY(file.write_value<LittleEndian<u32>>(metadata.length()));
+    TRY(file.write_until_depleted(metadata.bytes()));
+    response.body_offset = sizeof(u32) + metadata.length();
+    return {};
+}
+
+ErrorOr<NonnullOwnPtr<Core::File>> HttpCache::create_temporary_file(ByteString& path)
+{
+    path = ByteString::formatted("{}/{}-{}{}", m_directory, getpid(), m_temporary_file_count++, temporary_file_extension);
+    return Core::File::open(path, Core::File::OpenMode::Write | Core::File::OpenMode::Truncate, 0600);
+}
+
+void HttpCache::commit(ByteString const& temporary_path, CachedResponse const& response)
+{
+    // NOTE: Renaming replaces the old response in one go, so nobody ever reads a response that's partly written.
+    if (auto result = Core::System::rename(temporary_path, path_of(response.file_name)); result.is_error()) {
+        dbgln("HttpCache: Unable to store {}: {}", response.file_name, result.error());
+        (void)Core::System::unlink(temporary_path);
+        return;
+    }
+
+    auto size = response.body_offset + response.body_size;
+    if (auto entry = m_index.get(response.file_name); entry.has_value())
+        m_size -= entry->size;
+    m_index.set(response.file_name, { size, UnixDateTime::now() });
+    m_size += size;
+
+    if (m_size > budget_in_bytes)
+        evict_least_recently_used_responses();
+}
+
+Optional<HttpCache::Match> HttpCache::find(ByteString const& method, URL::URL const& url, HashMap<ByteString, ByteString> const& request_headers)
+{
+    if (cache_is_bypassed_for(method, url, request_headers))
+        return {};
+
+    auto file_name = file_name_for(url);
+    if (!m_index.contains(file_name)) {
+        // NOTE: Another RequestServer may have stored it since the index was loaded.
+        if (!Core::System::stat(path_of(file_name)).is_error())
+            load_index();
+        if (!m_index.contains(file_name))
+            return {};
+    }
+
+    auto response = read_response(file_name, url);
+    if (!response.has_value())
+        return {};
+
+    // https://httpwg.org/specs/rfc9111.html#caching.negotiated.responses
+    if (auto vary = find_response_header(response->response_headers, "Vary"sv); vary.has_value()) {
+        for (auto name : vary->split_view(',')) {
+            name = name.trim_whitespace();
+            if (name == "*"sv || find_request_header(request_headers, name) != find_response_header(response->varying_request_headers, name))
+                return {};
+        }
+    }
+
+    did_use(file_name);
+
+    auto request_cache_control = parse_cache_control(find_request_header(request_headers, "Cache-Control"sv));
+    auto response_cache_control = parse_cache_control(find_response_header(response->response_headers, "Cache-Control"sv));
+    bool is_fresh = freshness_lifetime(*response) > current_age(*response, UnixDateTime::now());
+
+    // https://httpwg.org/specs/rfc9111.html#field.pragma
+    bool request_has_pragma_no_cache = !request_headers.contains("Cache-Control"sv) && find_request_header(request_headers, "Pragma"sv).map([](auto value) { return value.contains("no-cache"sv); }).value_or(false);
+
+    if (is_fresh && !response_cache_control.no_cache && !request_cache_control.no_cache && !request_has_pragma_no_cache) {
+        dbgln_if(HTTPCACHE_DEBUG, "HttpCache: Answering {} from the cache", url);
+        return Match { response.release_value(), Freshness::Fresh };
+    }
+
+    if (!has_validators(response->response_headers))
+        return {};
+
+    dbgln_if(HTTPCACHE_DEBUG, "HttpCache: Revalidating {}", url);
+    return Match { response.release_value(), Freshness::MustBeRevalidated };
+}
+
+void HttpCache::add_validators(CachedResponse const& response, HashMap<ByteString, ByteString>& request_headers)
+{
+    if (auto etag = response.response_headers.get("ETag"sv); etag.has_value())
+        request_headers.set("If-None-Match", *etag);
+    if (auto last_modified = response.response_headers.get("Last-Modified"sv); last_modified.has_value())
+        request_headers.set("If-Modified-Since", *last_modified);
+}
+
+ErrorOr<NonnullOwnPtr<Core::File>> HttpCache::open_body(CachedResponse const& response)
+{
+    auto file = TRY(Core::File::open(path_of(response.file_name), Core::File::OpenMode::Read));
+    TRY(file->seek(response.body_offset, SeekMode::SetPosition));
+    return file;
+}
+
+// https://httpwg.org/specs/rfc9111.html#freshening.responses
+Optional<HttpCache::CachedResponse> HttpCache::freshen(CachedResponse const& stored_response, URL::URL const& url, Headers const& response_headers, UnixDateTime request_time, UnixDateTime response_time)
+{
+    auto response = stored_response;
+    for (auto const& header : response_headers) {
+        if (is_header_to_leave_out(header.key) || header.key.equals_ignoring_ascii_case("Content-Length"sv))
+            continue;
+        response.response_headers.set(header.key, header.value);
+    }
+    response.request_time = request_time;
+    response.response_time = response_time;
+
+    // The metadata comes before the body, so the response has to be written out again.
+    ByteString temporary_path;
+    auto rewrite = [&]() -> ErrorOr<void> {
+        auto body = TRY(open_body(stored_response));
+        auto file = TRY(create_temporary_file(temporary_path));
+        TRY(write_metadata(*file, url, response));
+
+        Array<u8, 64 * KiB> buffer;
+        u64 copied_size = 0;
+        while (copied_size < stored_response.body_size) {
+            auto bytes = TRY(body->read_some(buffer));
+            if (bytes.is_empty())
+                return Error::from_string_literal("Stored response is shorter than expected");
+            TRY(file->write_until_depleted(bytes));
+            copied_size += bytes.size();
+        }
+        return {};
+    };
+
+    if (auto result = rewrite(); result.is_error()) {
+        dbgln("HttpCache: Unable to freshen {}: {}", url, result.error());
+        if (!temporary_path.is_empty())
+            (void)Core::System::unlink(temporary_path);
+        return {};
+    }
+
+    commit(temporary_path, response);
+    return response;
+}
+
+HttpCache::Writer::Writer(Stream& destination, ByteString method, URL::URL url, HashMap<ByteString, ByteString> request_headers, Optional<CachedResponse> response_to_revalidate)
+    : m_destination(destination)
+    , m_method(move(method))
+    , m_url(move(url))
+    , m_request_headers(move(request_headers))
+    , m_response_to_revalidate(move(response_to_revalidate))
+    , m_request_time(UnixDateTime::now())
+{
+}
+
+HttpCache::Writer::~Writer()
+{
+    stop_storing();
+}
+
+void HttpCache::Writer::stop_storing()
+{
+    if (!m_file)
+        return;
+    m_file = nullptr;
+    m_response_to_store.clear();
+    (void)Core::System::unlink(m_temporary_path);
+}
+
+void HttpCache::Writer::did_receive_response(u32 status_code, Headers const& response_headers)
+{
+    // NOTE: This is also called with the trailers, if there are any.
+    if (m_has_received_response)
+        return;
+    m_has_received_response = true;
+
+    auto& cache = HttpCache::the();
+    auto response_time = UnixDateTime::now();
+
+    // https://httpwg.org/specs/rfc9111.html#invalidation
+    if (!is_safe_method(m_method)) {
+        if (status_code >= 200 && status_code < 400)
+            cache.remove(file_name_for(m_url));
+        return;
+    }
+
+    if (cache_is_bypassed_for(m_method, m_url, m_request_headers))
+        return;
+
+    // https://httpwg.org/specs/rfc9111.html#validation.received
+    if (status_code == 304 && m_response_to_revalidate.has_value()) {
+        m_revalidated_response = cache.freshen(*m_response_to_revalidate, m_url, response_headers, m_request_time, response_time);
+        return;
+    }
+
+    // https://httpwg.org/specs/rfc9111.html#response.cacheability
+    if (!is_heuristically_cacheable(status_code) || response_headers.contains("Content-Range"sv))
+        return;
+    if (parse_cache_control(find_response_header(response_headers, "Cache-Control"sv)).no_store)
+        return;
+
+    CachedResponse response;
+    response.file_name = file_name_for(m_url);
+    response.status_code = status_code;
+    response.request_time = m_request_time;
+    response.response_time = response_time;
+    for (auto const& header : response_headers) {
+        if (!is_header_to_leave_out(header.key))
+            response.response_headers.set(header.key, header.value);
+    }
+
+    if (auto vary = find_response_header(response_headers, "Vary"sv); vary.has_value()) {
+        for (auto name : vary->split_view(',')) {
+            name = name.trim_whitespace();
+            if (name == "*"sv)
+                return;
+            if (auto value = find_request_header(m_request_headers, name); value.has_value())
+                response.varying_request_headers.set(name, *value);
+        }
+    }
+
+    // A response that's never fresh and can't be revalidated would never be used.
+    if (freshness_lifetime(response) == Duration::zero() && !has_validators(response.response_headers))
+        return;
+
+    auto file_or_error = cache.create_temporary_file(m_temporary_path);
+    if (file_or_error.is_error()) {
+        dbgln("HttpCache: Unable to create a file for {}: {}", m_url, file_or_error.error());
+        return;
+    }
+    m_file = file_or_error.release_value();
+
+    if (auto result = cache.write_metadata(*m_file, m_url, response); result.is_error()) {
+        dbgln("HttpCache: Unable to store {}: {}", m_url, result.error());
+        stop_storing();
+        return;
+    }
+    m_response_to_store = move(response);
+}
+
+ErrorOr<size_t> HttpCache::Writer::write_some(ReadonlyBytes bytes)
+{
+    auto written = TRY(m_destination.write_some(bytes));
+    if (m_file) {
+        m_response_to_store->body_size += written;
+        if (m_response_to_store->body_size > maximum_response_size || m_file->write_until_depleted(bytes.trim(written)).is_error())
+            stop_storing();
+    }
+    return written;
+}
+
+void HttpCache::Writer::did_finish(bool success)
+{
+    if (!m_file)
+        return;
+    if (!success) {
+        stop_storing();
+        return;
+    }
+
+    m_file = nullptr;
+    HttpCache::the().commit(m_temporary_path, m_response_to_store.release_value());
+}
+
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/ByteString.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Stream.h>
+#include <AK/Time.h>
+#include <LibCore/File.h>
+#include <LibURL/URL.h>
+
+namespace HTTP {
+
+// https://httpwg.org/specs/rfc9111.html
+// A private HTTP cache, kept on disk so it's shared by every RequestServer and outlives them. Each stored response is a
+// file in the cache directory named after its URL, holding the response's metadata followed by its body. The cache
+// keeps an index of those files with their sizes and when they were last used (which is also recorded in their
+// modification times), and drops the least recently used ones once they take up more than its budget.
+class HttpCache {
+    AK_MAKE_NONCOPYABLE(HttpCache);
+    AK_MAKE_NONMOVABLE(HttpCache);
+
+public:
+    using Headers = HashMap<ByteString, ByteString, CaseInsensitiveStringTraits>;
+
+    static HttpCache& the();
+    static ByteString directory();
+
+    struct CachedResponse {
+        ByteString file_name;
+        u32 status_code { 0 };
+        Headers response_headers;
+
+        // The values the request headers named in the response's Vary header had. Headers that weren't in the request
+        // aren't in here either.
+        Headers varying_request_headers;
+
+        UnixDateTime request_time;
+        UnixDateTime response_time;
+
+        u64 body_offset { 0 };
+        u64 body_size { 0 };
+    };
+
+    enum class Freshness {
+        Fresh,
+        MustBeRevalidated,
+    };
+
+    struct Match {
+        CachedResponse response;
+        Freshness freshness { Freshness::Fresh };
+    };
+
+    // https://httpwg.org/specs/rfc9111.html#constructing.responses.from.caches
+    // Returns the stored response the request can be answered with, and whether it has to be revalidated first.
+    Optional<Match> find(ByteString const& method, URL::URL const&, HashMap<ByteString, ByteString> const& request_headers);
+
+    // https://httpwg.org/specs/rfc9111.html#validation.sent
+    static void add_validators(CachedResponse const&, HashMap<ByteString, ByteString>& request_headers);
+
+    ErrorOr<NonnullOwnPtr<Core::File>> open_body(CachedResponse const&);
+
+    // Sits between an HTTP job and the pipe to the client, and stores the response on its way through if it can be.
+    // This also freshens the stored response the request revalidates, if it's still good.
+    class Writer final : public Stream {
+    public:
+        Writer(Stream& destination, ByteString method, URL::URL, HashMap<ByteString, ByteString> request_headers, Optional<CachedResponse> response_to_revalidate);
+        virtual ~Writer() override;
+
+        void did_receive_response(u32 status_code, Headers const& response_headers);
+        void did_finish(bool success);
+
+        // Set once a 304 response has confirmed the stored response is still good, which the client gets instead.
+        bool has_revalidated_response() const { return m_revalidated_response.has_value(); }
+        Optional<CachedResponse> take_revalidated_response() { return exchange(m_revalidated_response, {}); }
+
+        virtual ErrorOr<Bytes> read_some(Bytes) override { return Error::from_errno(EBADF); }
+        virtual ErrorOr<size_t> write_some(ReadonlyBytes) override;
+        virtual bool is_eof() const override { return m_destination.is_eof(); }
+        virtual bool is_open() const override { return m_destination.is_open(); }
+        virtual void close() override { m_destination.close(); }
+
+    private:
+        void stop_storing();
+
+        Stream& m_destination;
+        ByteString m_method;
+        URL::URL m_url;
+        HashMap<ByteString, ByteString> m_request_headers;
+        Optional<CachedResponse> m_response_to_revalidate;
+        Optional<CachedResponse> m_revalidated_response;
+        UnixDateTime m_request_time;
+        bool m_has_received_response { false };
+
+        // While the response is being stored.
+        Optional<CachedResponse> m_response_to_store;
+        ByteString m_temporary_path;
+        OwnPtr<Core::File> m_file;
+    };
+
+private:
+    HttpCache();
+
+    friend class Writer;
+
+    struct IndexEntry {
+        u64 size { 0 };
+        UnixDateTime last_use_time;
+    };
+
+    ByteString path_of(StringView file_name) const;
+    Optional<CachedResponse> read_response(StringView file_name, URL::URL const&);
+    ErrorOr<NonnullOwnPtr<Core::File>> create_temporary_file(ByteString& path);
+    ErrorOr<void> write_metadata(Core::File&, URL::URL const&, CachedResponse&);
+    void commit(ByteString const& temporary_path, CachedResponse const&);
+    Optional<CachedResponse> freshen(CachedResponse const&, URL::URL const&, Headers const& response_headers, UnixDateTime request_time, UnixDateTime response_time);
+    void remove(StringView file_name);
+    void did_use(StringView file_name);
+
+    void load_index();
+    void evict_least_recently_used_responses();
+
+    ByteString m_directory;
+    HashMap<ByteString, IndexEntry> m_index;
+    u64 m_size { 0 };
+    u64 m_temporary_file_count { 0 };
+};
+
+}
@@ -107,8 +107,29 @@ void Job::start(Core::BufferedSocketBase& socket)
     });
 }
 
+void Job::start(Http2Connection& connection)
+{
+    VERIFY(!m_socket && !m_http2_connection);
+    m_http2_connection = connection;
+    dbgln_if(HTTPJOB_DEBUG, "Starting request for {} on an HTTP/2 connection", url());
+
+    NonnullRefPtr<Job> protector(*this);
+    m_http2_stream = connection.open_stream(m_request,
+        {
+            .on_headers = [this, protector](auto const& headers, bool end_stream) { did_receive_http2_headers(headers, end_stream); },
+            .on_data = [this, protector](auto data, bool end_stream) { did_receive_http2_data(data, end_stream); },
+            .on_error = [this, protector](auto error) { deferred_invoke([this, error] { did_fail(error); }); },
+        });
+}
+
 void Job::shutdown(ShutdownMode mode)
 {
+    if (m_http2_connection) {
+        // NOTE: Other requests are using the connection, so this only ever closes our stream.
+        m_http2_connection->cancel_stream(m_http2_stream);
+        m_http2_connection = nullptr;
+        return;
+    }
     if (!m_socket)
         return;
     if (mode == ShutdownMode::CloseSocket) {
@@ -362,34 +383,7 @@ void Job::on_socket_connected()
                 return deferred_invoke([this] { did_fail(Core::NetworkJob::Error::ProtocolFailed); });
             }
             auto value = line.substring(name.length() + 2, line.length() - name.length() - 2);
-            if (name.equals_ignoring_ascii_case("Set-Cookie"sv)) {
-                dbgln_if(JOB_DEBUG, "Job: Received Set-Cookie header: '{}'", value);
-                m_set_cookie_headers.append(move(value));
-
-                auto can_read_without_blocking = m_socket->can_read_without_blocking();
-                if (can_read_without_blocking.is_error())
-                    return deferred_invoke([this] { did_fail(Core::NetworkJob::Error::TransmissionFailed); });
-                if (!can_read_without_blocking.value())
-                    return;
-            } else if (auto existing_value = m_headers.get(name); existing_value.has_value()) {
-                StringBuilder builder;
-                builder.append(existing_value.value());
-                builder.append(',');
-                builder.append(value);
-                m_headers.set(name, builder.to_byte_string());
-            } else {
-                m_headers.set(name, value);
-            }
-            if (name.equals_ignoring_ascii_case("Content-Encoding"sv)) {
-                // Assume that any content-encoding means that we can't decode it as a stream :(
-                dbgln_if(JOB_DEBUG, "Content-Encoding {} detected, cannot stream output :(", value);
-                m_can_stream_response = false;
-            } else if (name.equals_ignoring_ascii_case("Content-Length"sv)) {
-                auto length = value.to_number<u64>();
-                if (length.has_value())
-                    m_content_length = length.value();
-            }
-            dbgln_if(JOB_DEBUG, "Job: [{}] = '{}'", name, value);
+            add_response_header(name, move(value));
 
             auto can_read_without_blocking = m_socket->can_read_without_blocking();
             if (can_read_without_blocking.is_error())
@@ -584,6 +578,113 @@ void Job::on_socket_connected()
     });
 }
 
+void Job::add_response_header(StringView name, ByteString value)
+{
+    if (name.equals_ignoring_ascii_case("Set-Cookie"sv)) {
+        dbgln_if(JOB_DEBUG, "Job: Received Set-Cookie header: '{}'", value);
+        m_set_cookie_headers.append(move(value));
+        return;
+    }
+
+    if (name.equals_ignoring_ascii_case("Content-Encoding"sv)) {
+        // Assume that any content-encoding means that we can't decode it as a stream :(
+        dbgln_if(JOB_DEBUG, "Content-Encoding {} detected, cannot stream output :(", value);
+        m_can_stream_response = false;
+    } else if (name.equals_ignoring_ascii_case("Content-Length"sv)) {
+        auto length = value.to_number<u64>();
+        if (length.has_value())
+            m_content_length = length.value();
+    }
+    dbgln_if(JOB_DEBUG, "Job: [{}] = '{}'", name, value);
+
+    if (auto existing_value = m_headers.get(name); existing_value.has_value()) {
+        StringBuilder builder;
+        builder.append(existing_value.value());
+        builder.append(',');
+        builder.append(value);
+        m_headers.set(name, builder.to_byte_string());
+    } else {
+        m_headers.set(name, move(value));
+    }
+}
+
+// https://httpwg.org/specs/rfc9113.html#HttpResponse
+void Job::did_receive_http2_headers(Vector<HPACK::Header> const& headers, bool end_stream)
+{
+    if (m_state == State::Finished)
+        return;
+
+    if (m_state == State::InBody) {
+        // These are the trailers, which have to end the stream.
+        for (auto const& header : headers) {
+            if (!header.name.starts_with(':'))
+                add_response_header(header.name, header.value);
+        }
+        if (!end_stream)
+            return fail_http2_stream(Core::NetworkJob::Error::ProtocolFailed);
+        return finish_up();
+    }
+
+    Optional<u32> code;
+    for (auto const& header : headers) {
+        if (header.name == ":status"sv)
+            code = header.value.to_number<u32>();
+    }
+    if (!code.has_value()) {
+        dbgln("Job: Expected numeric HTTP status in HTTP/2 response");
+        return fail_http2_stream(Core::NetworkJob::Error::ProtocolFailed);
+    }
+
+    // Informational responses come before the actual one, and we have no use for them.
+    if (*code >= 100 && *code < 200)
+        return;
+
+    m_code = *code;
+    for (auto const& header : headers) {
+        if (!header.name.starts_with(':'))
+            add_response_header(header.name, header.value);
+    }
+
+    if (on_headers_received) {
+        if (!m_set_cookie_headers.is_empty())
+            m_headers.set("Set-Cookie", JsonArray { m_set_cookie_headers }.to_byte_string());
+        on_headers_received(m_headers, m_code);
+    }
+    m_state = State::InBody;
+
+    if (end_stream)
+        finish_up();
+}
+
+void Job::did_receive_http2_data(ReadonlyBytes data, bool end_stream)
+{
+    if (m_state != State::InBody)
+        return;
+
+    if (!data.is_empty()) {
+        auto payload = ByteBuffer::copy(data);
+        if (payload.is_error())
+            return fail_http2_stream(Core::NetworkJob::Error::TransmissionFailed);
+
+        m_received_buffers.append(make<ReceivedBuffer>(payload.release_value()));
+        m_buffered_size += data.size();
+        m_received_size += data.size();
+        flush_received_buffers();
+
+        deferred_invoke([this] { did_progress(m_content_length, m_received_size); });
+    }
+
+    if (end_stream)
+        finish_up();
+}
+
+void Job::fail_http2_stream(Core::NetworkJob::Error error)
+{
+    m_state = State::Finished;
+    m_http2_connection->cancel_stream(m_http2_stream);
+    deferred_invoke([this, error] { did_fail(error); });
+}
+
 void Job::timer_event(Core::TimerEvent& event)
 {
     event.accept();
@@ -10,6 +10,7 @@
 #include <AK/Optional.h>
 #include <LibCore/NetworkJob.h>
 #include <LibCore/Socket.h>
+#include <LibHTTP/Http2Connection.h>
 #include <LibHTTP/HttpRequest.h>
 #include <LibHTTP/HttpResponse.h>
 
@@ -25,6 +26,9 @@ public:
     virtual void start(Core::BufferedSocketBase&) override;
     virtual void shutdown(ShutdownMode) override;
 
+    // Sends the request on a stream of the connection, rather than on a socket of its own.
+    void start(Http2Connection&);
+
     Core::Socket const* socket() const { return m_socket; }
     URL::URL url() const { return m_request.url(); }
 
@@ -39,6 +43,10 @@ protected:
     ErrorOr<ByteString> read_line(size_t);
     ErrorOr<ByteBuffer> receive(size_t);
     void timer_event(Core::TimerEvent&) override;
+    void add_response_header(StringView name, ByteString value);
+    void did_receive_http2_headers(Vector<HPACK::Header> const&, bool end_stream);
+    void did_receive_http2_data(ReadonlyBytes, bool end_stream);
+    void fail_http2_stream(Core::NetworkJob::Error);
 
     enum class State {
         InStatus,
@@ -51,6 +59,8 @@ protected:
     HttpRequest m_request;
     State m_state { State::InStatus };
     Core::BufferedSocketBase* m_socket { nullptr };
+    RefPtr<Http2Connection> m_http2_connection;
+    Http2Connection::StreamHandle m_http2_stream { 0 };
     bool m_legacy_connection { false };
     int m_code { -1 };
     HashMap<ByteString, ByteString, CaseInsensitiveStringTraits> m_headers;
@@ -0,0 +1,624 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/CharacterTypes.h>
+#include <AK/Debug.h>
+#include <AK/HashMap.h>
+#include <LibJIT/Assembler.h>
+#include <LibRegex/RegexJIT.h>
+#include <LibRegex/RegexMatch.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+namespace regex {
+
+// Number of entries on the backtracking stack. Each entry is a resume address and a string position,
+// followed by the values the checkpoints had when the entry was pushed.
+static constexpr size_t c_backtracking_stack_entries = 4096;
+
+// Every backtracking entry carries a copy of all checkpoints, so don't bother with patterns that have lots of them.
+static constexpr size_t c_max_checkpoints = 16;
+
+static constexpr size_t backtracking_stack_entry_size(size_t checkpoint_count)
+{
+    return (2 + checkpoint_count) * sizeof(u64);
+}
+
+static constexpr i64 c_native_failed = -1;
+static constexpr i64 c_native_out_of_backtracking_space = -2;
+
+bool NativeRegex::is_enabled()
+{
+    static bool const s_enabled = getenv("LIBREGEX_JIT") != nullptr;
+    return s_enabled;
+}
+
+#if JIT_ARCH_SUPPORTED
+
+namespace {
+
+using Assembler = JIT::Assembler;
+using Operand = Assembler::Operand;
+using Reg = Assembler::Reg;
+using Condition = Assembler::Condition;
+
+// Register assignment; the first five are the arguments of the native function.
+constexpr auto INPUT = Reg::RDI;
+constexpr auto LENGTH = Reg::RSI;
+constexpr auto POSITION = Reg::RDX;
+constexpr auto CHECKPOINTS = Reg::RCX;
+constexpr auto STACK_LIMIT = Reg::R8;
+constexpr auto STACK_BASE = Reg::R9;
+constexpr auto STACK_TOP = Reg::R10;
+constexpr auto SCRATCH = Reg::RAX;
+constexpr auto SCRATCH2 = Reg::R11;
+
+struct Range {
+    u32 from;
+    u32 to;
+};
+
+struct CharacterSet {
+    bool inverse { false };
+    Vector<Range, 4> ranges;
+};
+
+class Compiler {
+public:
+    Compiler(ByteCode const& bytecode, AllOptions options)
+        : m_bytecode(bytecode)
+        , m_options(options)
+        , m_assembler(m_output)
+    {
+    }
+
+    bool compile();
+
+    Vector<u8> const& output() const { return m_output; }
+    size_t checkpoint_count() const { return m_checkpoint_count; }
+
+    void link_resume_addresses(FlatPtr base)
+    {
+        for (auto& slot : m_resume_address_slots) {
+            FlatPtr address = base + slot.label->offset_of_label_in_instruction_stream.value();
+            memcpy(m_output.data() + slot.offset_in_output, &address, sizeof(address));
+        }
+    }
+
+private:
+    bool collect_instructions();
+    bool compile_compare(size_t instruction_position);
+    Optional<CharacterSet> character_set_for_compare(size_t instruction_position) const;
+    void compile_character_set(CharacterSet const&);
+    void compile_string(Vector<u32> const&);
+    void compile_fork(OpCodeId form, size_t next_instruction, size_t target);
+
+    void push_backtrack_entry(Assembler::Label& resume_label, bool replace_existing_entry);
+    void save_checkpoints(Reg entry);
+    void restore_checkpoints(Reg entry);
+    Assembler::Label& make_resume_label(size_t instruction_position);
+
+    Assembler::Label& label_for(size_t instruction_position) { return m_labels.find(instruction_position)->value; }
+
+    ByteCode const& m_bytecode;
+    AllOptions m_options;
+    Vector<u8> m_output;
+    Assembler m_assembler;
+
+    HashMap<size_t, Assembler::Label> m_labels;
+    Vector<size_t> m_instruction_positions;
+    size_t m_checkpoint_count { 0 };
+
+    Assembler::Label m_backtrack;
+    Assembler::Label m_out_of_backtracking_space;
+
+    // Every fork site gets its own resume stub, so its address doubles as the site's identity
+    // (needed to implement ForkReplace*, which replaces the entry pushed by an earlier visit).
+    Vector<NonnullOwnPtr<Assembler::Label>> m_resume_labels;
+    Vector<size_t> m_resume_targets;
+    struct ResumeAddressSlot {
+        size_t offset_in_output;
+        Assembler::Label* label;
+    };
+    Vector<ResumeAddressSlot> m_resume_address_slots;
+};
+
+bool Compiler::collect_instructions()
+{
+    Vector<ssize_t> jump_targets;
+
+    MatchState state;
+    while (state.instruction_position < m_bytecode.size()) {
+        auto& opcode = m_bytecode.get_opcode(state);
+        auto next_instruction = static_cast<ssize_t>(state.instruction_position + opcode.size());
+        switch (opcode.opcode_id()) {
+        case OpCodeId::Compare:
+            if (!character_set_for_compare(state.instruction_position).has_value())
+                return false;
+            break;
+        case OpCodeId::Jump:
+            jump_targets.append(next_instruction + static_cast<OpCode_Jump const&>(opcode).offset());
+            break;
+        case OpCodeId::ForkJump:
+        case OpCodeId::ForkReplaceJump:
+            jump_targets.append(next_instruction + static_cast<OpCode_ForkJump const&>(opcode).offset());
+            break;
+        case OpCodeId::ForkStay:
+        case OpCodeId::ForkReplaceStay:
+            jump_targets.append(next_instruction + static_cast<OpCode_ForkStay const&>(opcode).offset());
+            break;
+        case OpCodeId::JumpNonEmpty:
+            jump_targets.append(next_instruction + static_cast<OpCode_JumpNonEmpty const&>(opcode).offset());
+            m_checkpoint_count = max(m_checkpoint_count, static_cast<size_t>(static_cast<OpCode_JumpNonEmpty const&>(opcode).checkpoint()) + 1);
+            break;
+        case OpCodeId::Checkpoint:
+            m_checkpoint_count = max(m_checkpoint_count, static_cast<OpCode_Checkpoint const&>(opcode).id() + 1);
+            break;
+        case OpCodeId::CheckBegin:
+        case OpCodeId::CheckEnd:
+            // Only the plain "start/end of input" interpretation is supported.
+            if (m_options.has_flag_set(AllFlags::MatchNotBeginOfLine)
+                || m_options.has_flag_set(AllFlags::MatchNotEndOfLine)
+                || (m_options.has_flag_set(AllFlags::Multiline) && m_options.has_flag_set(AllFlags::Internal_ConsiderNewline)))
+                return false;
+            break;
+        default:
+            dbgln_if(REGEX_DEBUG, "[JIT] Unsupported opcode {} at {}", opcode.name(), state.instruction_position);
+            return false;
+        }
+
+        m_instruction_positions.append(state.instruction_position);
+        m_labels.set(state.instruction_position, {});
+        state.instruction_position += opcode.size();
+    }
+
+    if (m_checkpoint_count > c_max_checkpoints)
+        return false;
+
+    // Running off the end of the bytecode is how a match succeeds.
+    m_labels.set(m_bytecode.size(), {});
+
+    for (auto target : jump_targets) {
+        if (target < 0 || !m_labels.contains(static_cast<size_t>(target)))
+            return false;
+    }
+    return true;
+}
+
+Optional<CharacterSet> Compiler::character_set_for_compare(size_t instruction_position) const
+{
+    auto argument_count = m_bytecode.at(instruction_position + 1);
+    size_t offset = instruction_position + 3;
+
+    CharacterSet set;
+    for (size_t i = 0; i < argument_count; ++i) {
+        auto compare_type = static_cast<CharacterCompareType>(m_bytecode.at(offset++));
+        switch (compare_type) {
+        case CharacterCompareType::Inverse:
+            // Only a leading inversion of the whole set is supported.
+            if (i != 0)
+                return {};
+            set.inverse = true;
+            break;
+        case CharacterCompareType::Char: {
+            auto ch = m_bytecode.at(offset++);
+            set.ranges.append({ static_cast<u32>(ch), static_cast<u32>(ch) });
+            break;
+        }
+        case CharacterCompareType::CharRange: {
+            CharRange range = m_bytecode.at(offset++);
+            set.ranges.append({ range.from, range.to });
+            break;
+        }
+        case CharacterCompareType::LookupTable: {
+            auto count = m_bytecode.at(offset++);
+            for (size_t j = 0; j < count; ++j) {
+                CharRange range = m_bytecode.at(offset++);
+                set.ranges.append({ range.from, range.to });
+            }
+            break;
+        }
+        case CharacterCompareType::CharClass:
+            switch (static_cast<CharClass>(m_bytecode.at(offset++))) {
+            case CharClass::Digit:
+                set.ranges.append({ '0', '9' });
+                break;
+            case CharClass::Word:
+                set.ranges.append({ '0', '9' });
+                set.ranges.append({ 'A', 'Z' });
+                set.ranges.append({ '_', '_' });
+                set.ranges.append({ 'a', 'z' });
+                break;
+            case CharClass::Alnum:
+                set.ranges.append({ '0', '9' });
+                set.ranges.append({ 'A', 'Z' });
+                set.ranges.append({ 'a', 'z' });
+                break;
+            case CharClass::Alpha:
+                set.ranges.append({ 'A', 'Z' });
+                set.ranges.append({ 'a', 'z' });
+                break;
+            case CharClass::Lower:
+                set.ranges.append({ 'a', 'z' });
+                break;
+            case CharClass::Upper:
+                set.ranges.append({ 'A', 'Z' });
+                break;
+            case CharClass::Xdigit:
+                set.ranges.append({ '0', '9' });
+                set.ranges.append({ 'A', 'F' });
+                set.ranges.append({ 'a', 'f' });
+                break;
+            default:
+                // Space needs the unicode tables, and the rest are rare enough not to bother.
+                return {};
+            }
+            break;
+        case CharacterCompareType::AnyChar:
+            // '.' is only supported on its own, where it behaves like the set of everything but newlines.
+            if (argument_count != 1)
+                return {};
+            set.inverse = true;
+            if (!(m_options.has_flag_set(AllFlags::SingleLine) && m_options.has_flag_set(AllFlags::Internal_ConsiderNewline))) {
+                set.ranges.append({ '\n', '\n' });
+                if (m_options.has_flag_set(AllFlags::Internal_ECMA262DotSemantics))
+                    set.ranges.append({ '\r', '\r' });
+            }
+            break;
+        case CharacterCompareType::String:
+            // Strings are handled separately, see compile_compare().
+            if (argument_count != 1 || m_bytecode.at(offset) == 0)
+                return {};
+            return CharacterSet {};
+        default:
+            return {};
+        }
+    }
+
+    if (!set.inverse && set.ranges.is_empty())
+        return {};
+
+    for (auto& range : set.ranges) {
+        if (range.from > range.to || range.to > NumericLimits<i32>::max())
+            return {};
+    }
+
+    return set;
+}
+
+Assembler::Label& Compiler::make_resume_label(size_t instruction_position)
+{
+    m_resume_labels.append(make<Assembler::Label>());
+    m_resume_targets.append(instruction_position);
+    return *m_resume_labels.last();
+}
+
+// NOTE: Both of these clobber SCRATCH.
+void Compiler::save_checkpoints(Reg entry)
+{
+    for (size_t i = 0; i < m_checkpoint_count; ++i) {
+        m_assembler.mov(Operand::Register(SCRATCH), Operand::Mem64BaseAndOffset(CHECKPOINTS, i * sizeof(u64)));
+        m_assembler.mov(Operand::Mem64BaseAndOffset(entry, (2 + i) * sizeof(u64)), Operand::Register(SCRATCH));
+    }
+}
+
+void Compiler::restore_checkpoints(Reg entry)
+{
+    for (size_t i = 0; i < m_checkpoint_count; ++i) {
+        m_assembler.mov(Operand::Register(SCRATCH), Operand::Mem64BaseAndOffset(entry, (2 + i) * sizeof(u64)));
+        m_assembler.mov(Operand::Mem64BaseAndOffset(CHECKPOINTS, i * sizeof(u64)), Operand::Register(SCRATCH));
+    }
+}
+
+void Compiler::push_backtrack_entry(Assembler::Label& resume_label, bool replace_existing_entry)
+{
+    // The checkpoints are saved along with the position, as a resumed path has to see them the way they were
+    // when it forked off. Otherwise a JumpNonEmpty may look at the checkpoint of a path that has been abandoned
+    // since, and keep looping back without ever consuming anything (e.g. /(?:a*)*b/ on "ac").
+    auto entry_size = backtracking_stack_entry_size(m_checkpoint_count);
+
+    // SCRATCH = address of the resume stub (patched in once the code has been placed).
+    m_assembler.mov(Operand::Register(SCRATCH), Operand::Imm(0), Assembler::Patchable::Yes);
+    m_resume_address_slots.append({ m_output.size() - sizeof(FlatPtr), &resume_label });
+
+    Assembler::Label push_new_entry;
+    Assembler::Label done;
+
+    if (replace_existing_entry) {
+        // Look for an entry left behind by an earlier visit of this fork, and replace it.
+        Assembler::Label search_loop;
+        m_assembler.mov(Operand::Register(SCRATCH2), Operand::Register(STACK_TOP));
+        search_loop.link(m_assembler);
+        m_assembler.jump_if(Operand::Register(SCRATCH2), Condition::EqualTo, Operand::Register(STACK_BASE), push_new_entry);
+        m_assembler.sub(Operand::Register(SCRATCH2), Operand::Imm(entry_size));
+        m_assembler.jump_if(Operand::Mem64BaseAndOffset(SCRATCH2, 0), Condition::NotEqualTo, Operand::Register(SCRATCH), search_loop);
+        m_assembler.mov(Operand::Mem64BaseAndOffset(SCRATCH2, 8), Operand::Register(POSITION));
+        save_checkpoints(SCRATCH2);
+        m_assembler.jump(done);
+    }
+
+    push_new_entry.link(m_assembler);
+    m_assembler.jump_if(Operand::Register(STACK_TOP), Condition::AboveOrEqual, Operand::Register(STACK_LIMIT), m_out_of_backtracking_space);
+    m_assembler.mov(Operand::Mem64BaseAndOffset(STACK_TOP, 0), Operand::Register(SCRATCH));
+    m_assembler.mov(Operand::Mem64BaseAndOffset(STACK_TOP, 8), Operand::Register(POSITION));
+    save_checkpoints(STACK_TOP);
+    m_assembler.add(Operand::Register(STACK_TOP), Operand::Imm(entry_size));
+
+    done.link(m_assembler);
+}
+
+void Compiler::compile_fork(OpCodeId form, size_t next_instruction, size_t target)
+{
+    switch (form) {
+    case OpCodeId::Jump:
+        m_assembler.jump(label_for(target));
+        break;
+    case OpCodeId::ForkJump:
+    case OpCodeId::ForkReplaceJump:
+        // Try the jump target first, and come back to the next instruction if that fails.
+        push_backtrack_entry(make_resume_label(next_instruction), form == OpCodeId::ForkReplaceJump);
+        m_assembler.jump(label_for(target));
+        break;
+    case OpCodeId::ForkStay:
+    case OpCodeId::ForkReplaceStay:
+        push_backtrack_entry(make_resume_label(target), form == OpCodeId::ForkReplaceStay);
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+void Compiler::compile_character_set(CharacterSet const& set)
+{
+    // Fail at the end of the input, otherwise load the current character.
+    m_assembler.jump_if(Operand::Register(POSITION), Condition::AboveOrEqual, Operand::Register(LENGTH), m_backtrack);
+    m_assembler.mov(Operand::Register(SCRATCH), Operand::Register(INPUT));
+    m_assembler.add(Operand::Register(SCRATCH), Operand::Register(POSITION));
+    m_assembler.mov8(Operand::Register(SCRATCH), Operand::Mem64BaseAndOffset(SCRATCH, 0));
+
+    Assembler::Label in_set;
+    for (auto& range : set.ranges) {
+        if (range.from == range.to) {
+            m_assembler.jump_if(Operand::Register(SCRATCH), Condition::EqualTo, Operand::Imm(range.from), in_set);
+            continue;
+        }
+        Assembler::Label next_range;
+        m_assembler.jump_if(Operand::Register(SCRATCH), Condition::Below, Operand::Imm(range.from), next_range);
+        m_assembler.jump_if(Operand::Register(SCRATCH), Condition::BelowOrEqual, Operand::Imm(range.to), in_set);
+        next_range.link(m_assembler);
+    }
+
+    Assembler::Label done;
+    if (set.inverse) {
+        m_assembler.add(Operand::Register(POSITION), Operand::Imm(1));
+        m_assembler.jump(done);
+        in_set.link(m_assembler);
+        m_assembler.jump(m_backtrack);
+    } else {
+        m_assembler.jump(m_backtrack);
+        in_set.link(m_assembler);
+        m_assembler.add(Operand::Register(POSITION), Operand::Imm(1));
+    }
+    done.link(m_assembler);
+}
+
+void Compiler::compile_string(Vector<u32> const& string)
+{
+    m_assembler.mov(Operand::Register(SCRATCH2), Operand::Register(POSITION));
+    m_assembler.add(Operand::Register(SCRATCH2), Operand::Imm(string.size()));
+    m_assembler.jump_if(Operand::Register(SCRATCH2), Condition::Above, Operand::Register(LENGTH), m_backtrack);
+
+    m_assembler.mov(Operand::Register(SCRATCH2), Operand::Register(INPUT));
+    m_assembler.add(Operand::Register(SCRATCH2), Operand::Register(POSITION));
+    for (size_t i = 0; i < string.size(); ++i) {
+        m_assembler.mov8(Operand::Register(SCRATCH), Operand::Mem64BaseAndOffset(SCRATCH2, i));
+        m_assembler.jump_if(Operand::Register(SCRATCH), Condition::NotEqualTo, Operand::Imm(string[i]), m_backtrack);
+    }
+    m_assembler.add(Operand::Register(POSITION), Operand::Imm(string.size()));
+}
+
+bool Compiler::compile_compare(size_t instruction_position)
+{
+    auto first_compare_type = static_cast<CharacterCompareType>(m_bytecode.at(instruction_position + 3));
+    if (first_compare_type == CharacterCompareType::String) {
+        auto length = m_bytecode.at(instruction_position + 4);
+        Vector<u32> string;
+        for (size_t i = 0; i < length; ++i) {
+            auto ch = m_bytecode.at(instruction_position + 5 + i);
+            if (ch > NumericLimits<i32>::max())
+                return false;
+            string.append(ch);
+        }
+        compile_string(string);
+        return true;
+    }
+
+    auto set = character_set_for_compare(instruction_position);
+    if (!set.has_value())
+        return false;
+    compile_character_set(*set);
+    return true;
+}
+
+bool Compiler::compile()
+{
+    if (!collect_instructions())
+        return false;
+
+    m_assembler.enter();
+
+    // The backtracking stack lives right after the checkpoints in the scratch space.
+    m_assembler.mov(Operand::Register(STACK_BASE), Operand::Register(CHECKPOINTS));
+    m_assembler.add(Operand::Register(STACK_BASE), Operand::Imm(m_checkpoint_count * sizeof(u64)));
+    m_assembler.mov(Operand::Register(STACK_TOP), Operand::Register(STACK_BASE));
+
+    MatchState state;
+    for (auto instruction_position : m_instruction_positions) {
+        label_for(instruction_position).link(m_assembler);
+
+        state.instruction_position = instruction_position;
+        auto& opcode = m_bytecode.get_opcode(state);
+        auto next_instruction = instruction_position + opcode.size();
+
+        switch (opcode.opcode_id()) {
+        case OpCodeId::Compare:
+            if (!compile_compare(instruction_position))
+                return false;
+            break;
+        case OpCodeId::Jump:
+            m_assembler.jump(label_for(next_instruction + static_cast<OpCode_Jump const&>(opcode).offset()));
+            break;
+        case OpCodeId::ForkJump:
+        case OpCodeId::ForkReplaceJump:
+            compile_fork(opcode.opcode_id(), next_instruction, next_instruction + static_cast<OpCode_ForkJump const&>(opcode).offset());
+            break;
+        case OpCodeId::ForkStay:
+        case OpCodeId::ForkReplaceStay:
+            compile_fork(opcode.opcode_id(), next_instruction, next_instruction + static_cast<OpCode_ForkStay const&>(opcode).offset());
+            break;
+        case OpCodeId::Checkpoint: {
+            auto id = static_cast<OpCode_Checkpoint const&>(opcode).id();
+            m_assembler.mov(Operand::Register(SCRATCH), Operand::Register(POSITION));
+            m_assembler.add(Operand::Register(SCRATCH), Operand::Imm(1));
+            m_assembler.mov(Operand::Mem64BaseAndOffset(CHECKPOINTS, id * sizeof(u64)), Operand::Register(SCRATCH));
+            break;
+        }
+        case OpCodeId::JumpNonEmpty: {
+            auto& jump = static_cast<OpCode_JumpNonEmpty const&>(opcode);
+            auto target = next_instruction + jump.offset();
+            auto form = jump.form();
+
+            // Only loop back if the loop body consumed something since the checkpoint.
+            Assembler::Label skip;
+            m_assembler.mov(Operand::Register(SCRATCH), Operand::Mem64BaseAndOffset(CHECKPOINTS, jump.checkpoint() * sizeof(u64)));
+            m_assembler.jump_if(Operand::Register(SCRATCH), Condition::EqualTo, Operand::Imm(0), skip);
+            m_assembler.mov(Operand::Register(SCRATCH2), Operand::Register(POSITION));
+            m_assembler.add(Operand::Register(SCRATCH2), Operand::Imm(1));
+            m_assembler.jump_if(Operand::Register(SCRATCH), Condition::EqualTo, Operand::Register(SCRATCH2), skip);
+            if (form != OpCodeId::Jump && form != OpCodeId::ForkJump && form != OpCodeId::ForkStay && form != OpCodeId::ForkReplaceJump && form != OpCodeId::ForkReplaceStay)
+                return false;
+            compile_fork(form, next_instruction, target);
+            skip.link(m_assembler);
+            break;
+        }
+        case OpCodeId::CheckBegin:
+            m_assembler.jump_if(Operand::Register(POSITION), Condition::NotEqualTo, Operand::Imm(0), m_backtrack);
+            break;
+        case OpCodeId::CheckEnd:
+            m_assembler.jump_if(Operand::Register(POSITION), Condition::NotEqualTo, Operand::Register(LENGTH), m_backtrack);
+            break;
+        default:
+            VERIFY_NOT_REACHED();
+        }
+    }
+
+    // Success: return the end position of the match.
+    label_for(m_bytecode.size()).link(m_assembler);
+    m_assembler.mov(Operand::Register(Reg::RAX), Operand::Register(POSITION));
+    m_assembler.exit();
+
+    // Failure: resume at the most recent backtracking entry, if there is one.
+    m_backtrack.link(m_assembler);
+    Assembler::Label no_more_entries;
+    m_assembler.jump_if(Operand::Register(STACK_TOP), Condition::EqualTo, Operand::Register(STACK_BASE), no_more_entries);
+    m_assembler.sub(Operand::Register(STACK_TOP), Operand::Imm(backtracking_stack_entry_size(m_checkpoint_count)));
+    m_assembler.mov(Operand::Register(POSITION), Operand::Mem64BaseAndOffset(STACK_TOP, 8));
+    restore_checkpoints(STACK_TOP);
+    m_assembler.mov(Operand::Register(SCRATCH), Operand::Mem64BaseAndOffset(STACK_TOP, 0));
+    m_assembler.jump(Operand::Register(SCRATCH));
+
+    no_more_entries.link(m_assembler);
+    m_assembler.mov(Operand::Register(Reg::RAX), Operand::Imm(static_cast<u64>(c_native_failed)));
+    m_assembler.exit();
+
+    m_out_of_backtracking_space.link(m_assembler);
+    m_assembler.mov(Operand::Register(Reg::RAX), Operand::Imm(static_cast<u64>(c_native_out_of_backtracking_space)));
+    m_assembler.exit();
+
+    // Resume stubs; note that compiling them can't create new ones.
+    for (size_t i = 0; i < m_resume_labels.size(); ++i) {
+        m_resume_labels[i]->link(m_assembler);
+        m_assembler.jump(label_for(m_resume_targets[i]));
+    }
+
+    return true;
+}
+
+}
+
+#endif
+
+OwnPtr<NativeRegex> NativeRegex::try_compile([[maybe_unused]] ByteCode const& bytecode, [[maybe_unused]] AllOptions options)
+{
+#if JIT_ARCH_SUPPORTED
+    // Case folding and multi-byte code points are left to the interpreter.
+    if (options.has_flag_set(AllFlags::Insensitive) || options.has_flag_set(AllFlags::Unicode) || options.has_flag_set(AllFlags::UnicodeSets))
+        return nullptr;
+
+    Compiler compiler(bytecode, options);
+    if (!compiler.compile())
+        return nullptr;
+
+    auto size = compiler.output().size();
+    auto* code = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        dbgln_if(REGEX_DEBUG, "[JIT] mmap: {}", strerror(errno));
+        return nullptr;
+    }
+
+    compiler.link_resume_addresses(reinterpret_cast<FlatPtr>(code));
+    memcpy(code, compiler.output().data(), size);
+
+    if (mprotect(code, size, PROT_READ | PROT_EXEC) < 0) {
+        dbgln_if(REGEX_DEBUG, "[JIT] mprotect: {}", strerror(errno));
+        munmap(code, size);
+        return nullptr;
+    }
+
+    dbgln_if(REGEX_DEBUG, "[JIT] Compiled {} bytes of bytecode to {} bytes of machine code", bytecode.size(), size);
+    return adopt_own(*new NativeRegex(code, size, compiler.checkpoint_count(), options));
+#else
+    return nullptr;
+#endif
+}
+
+NativeRegex::NativeRegex(void* code, size_t size, size_t checkpoint_count, AllOptions options)
+    : m_code(code)
+    , m_size(size)
+    , m_checkpoint_count(checkpoint_count)
+    , m_options(options)
+{
+}
+
+NativeRegex::~NativeRegex()
+{
+    munmap(m_code, m_size);
+}
+
+NativeRegex::Result NativeRegex::execute(StringView input, size_t start, size_t& end, Vector<u64>& scratch) const
+{
+    // Checkpoints followed by the backtracking stack.
+    auto scratch_size = m_checkpoint_count + c_backtracking_stack_entries * backtracking_stack_entry_size(m_checkpoint_count) / sizeof(u64);
+    if (scratch.size() < scratch_size)
+        scratch.resize(scratch_size);
+
+    for (size_t i = 0; i < m_checkpoint_count; ++i)
+        scratch[i] = 0;
+
+    auto function = reinterpret_cast<NativeFunction>(m_code);
+    auto result = function(reinterpret_cast<u8 const*>(input.characters_without_null_termination()), input.length(), start, scratch.data(), scratch.data() + scratch.size());
+
+    if (result == c_native_failed)
+        return Result::Failed;
+    if (result == c_native_out_of_backtracking_space)
+        return Result::OutOfBacktrackingSpace;
+
+    end = static_cast<size_t>(result);
+    return Result::Matched;
+}
+
+}
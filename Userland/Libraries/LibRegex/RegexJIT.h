@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Noncopyable.h>
+#include <AK/OwnPtr.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibRegex/RegexByteCode.h>
+#include <LibRegex/RegexOptions.h>
+
+namespace regex {
+
+// Machine code for the subset of the bytecode that doesn't need the full interpreter state:
+// character compares, jumps, forks and loop checkpoints, without capture groups, lookarounds,
+// repetitions or unicode/case-insensitive matching. Everything else stays in the interpreter.
+//
+// This is an opt-in tier; set LIBREGEX_JIT in the environment to compile patterns once they've
+// been matched against often enough.
+class NativeRegex {
+    AK_MAKE_NONCOPYABLE(NativeRegex);
+    AK_MAKE_NONMOVABLE(NativeRegex);
+
+public:
+    static constexpr size_t compilation_threshold = 16;
+
+    static bool is_enabled();
+    static OwnPtr<NativeRegex> try_compile(ByteCode const&, AllOptions);
+
+    ~NativeRegex();
+
+    AllOptions options() const { return m_options; }
+
+    enum class Result {
+        Matched,
+        Failed,
+        OutOfBacktrackingSpace,
+    };
+
+    // Attempts a match at exactly `start`; on success, `end` is set to the position after the match.
+    // `scratch` holds the checkpoints and the backtracking stack, and can be reused between executions.
+    // NOTE: It's up to the caller so that the same NativeRegex can be executed on several threads at once.
+    Result execute(StringView input, size_t start, size_t& end, Vector<u64>& scratch) const;
+
+private:
+    using NativeFunction = i64 (*)(u8 const* input, size_t length, size_t start, u64* scratch, u64* scratch_end);
+
+    NativeRegex(void* code, size_t size, size_t checkpoint_count, AllOptions);
+
+    void* m_code { nullptr };
+    size_t m_size { 0 };
+    size_t m_checkpoint_count { 0 };
+    AllOptions m_options;
+};
+
+}
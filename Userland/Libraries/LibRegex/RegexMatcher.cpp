@@ -4,9 +4,11 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
-#include <AK/BumpAllocator.h>
 #include <AK/ByteString.h>
 #include <AK/Debug.h>
+#include <AK/IntrusiveList.h>
+#include <AK/MemMem.h>
+#include <AK/ScopeGuard.h>
 #include <AK/StringBuilder.h>
 #include <LibRegex/RegexMatcher.h>
 #include <LibRegex/RegexParser.h>
@@ -21,6 +23,49 @@ namespace regex {
 static RegexDebug s_regex_dbg(stderr);
 #endif
 
+// Positions in these views are plain offsets into their code units, so we can look for literals in them directly.
+static bool can_search_for_literal(RegexStringView const& view)
+{
+    return view.is_string_view() || (view.is_u16_view() && !view.unicode());
+}
+
+static Optional<size_t> find_literal(RegexStringView const& view, StringView literal, size_t start)
+{
+    if (view.is_string_view()) {
+        auto haystack = view.string_view();
+        if (start > haystack.length())
+            return {};
+        auto offset = AK::memmem_optional(haystack.characters_without_null_termination() + start, haystack.length() - start, literal.characters_without_null_termination(), literal.length());
+        if (!offset.has_value())
+            return {};
+        return start + *offset;
+    }
+
+    // The literal is plain ASCII, so it's one code unit per character in UTF-16 as well.
+    auto haystack = view.u16_view();
+    if (start > haystack.length_in_code_units())
+        return {};
+
+    Vector<u16, 32> needle;
+    for (auto character : literal)
+        needle.append(static_cast<u16>(character));
+
+    auto const* haystack_bytes = reinterpret_cast<u8 const*>(haystack.data() + start);
+    auto haystack_size = (haystack.length_in_code_units() - start) * sizeof(u16);
+    size_t byte_offset = 0;
+    while (byte_offset < haystack_size) {
+        auto offset = AK::memmem_optional(haystack_bytes + byte_offset, haystack_size - byte_offset, needle.data(), needle.size() * sizeof(u16));
+        if (!offset.has_value())
+            return {};
+        byte_offset += *offset;
+        // Only matches that start on a code unit boundary count.
+        if (byte_offset % sizeof(u16) == 0)
+            return start + byte_offset / sizeof(u16);
+        ++byte_offset;
+    }
+    return {};
+}
+
 template<class Parser>
 regex::Parser::Result Regex<Parser>::parse_pattern(StringView pattern, typename ParserTraits<Parser>::OptionsType regex_options)
 {
@@ -30,16 +75,158 @@ regex::Parser::Result Regex<Parser>::parse_pattern(StringView pattern, typename
     return parser.parse();
 }
 
+namespace {
+
+// Parsing and optimizing a pattern is much more expensive than copying the resulting bytecode,
+// and a lot of users (header validation in LibWeb, regex literals in JS loops, ...) compile the
+// same handful of patterns over and over, so keep the most recently compiled ones around.
+static constexpr size_t c_compiled_pattern_cache_size = 128;
+
+struct CompiledPatternKey {
+    ByteString pattern;
+    FlagsUnderlyingType options { 0 };
+
+    bool operator==(CompiledPatternKey const&) const = default;
+};
+
+struct CompiledPatternKeyTraits : public DefaultTraits<CompiledPatternKey> {
+    static unsigned hash(CompiledPatternKey const& key) { return pair_int_hash(key.pattern.hash(), key.options); }
+};
+
+// Copies a parse result, so that the copy doesn't share any reference-counted data with the original. The bytecode
+// refers to capture group names by pointing into the pattern or the capture group names it was compiled from, so
+// those pointers are moved over to the given copies. NOTE: The capture groups of the copy are left for the caller to fill in.
+template<typename CaptureGroupNames>
+static regex::Parser::Result copy_parser_result(regex::Parser::Result const& parser_result, StringView pattern, StringView pattern_copy, CaptureGroupNames const& capture_group_names_copy)
+{
+    auto copy_string = [](Optional<ByteString> const& string) -> Optional<ByteString> {
+        if (!string.has_value())
+            return {};
+        return ByteString { string->view() };
+    };
+
+    regex::Parser::Result copy {
+        parser_result.bytecode,
+        parser_result.capture_groups_count,
+        parser_result.named_capture_groups_count,
+        parser_result.match_length_minimum,
+        parser_result.error,
+        parser_result.error_token,
+        {},
+        parser_result.options,
+        {
+            copy_string(parser_result.optimization_data.pure_substring_search),
+            copy_string(parser_result.optimization_data.literal_prefix),
+            copy_string(parser_result.optimization_data.required_literal),
+        },
+    };
+
+    auto pattern_start = bit_cast<FlatPtr>(pattern.characters_without_null_termination());
+    auto& bytecode = copy.bytecode;
+    MatchState state;
+    while (state.instruction_position < bytecode.size()) {
+        auto& opcode = bytecode.get_opcode(state);
+        if (opcode.opcode_id() == OpCodeId::SaveRightNamedCaptureGroup) {
+            auto name = static_cast<OpCode_SaveRightNamedCaptureGroup const&>(opcode).name();
+            auto name_start = bit_cast<FlatPtr>(name.characters_without_null_termination());
+            char const* name_copy = nullptr;
+            if (name_start >= pattern_start && name_start + name.length() <= pattern_start + pattern.length()) {
+                name_copy = pattern_copy.characters_without_null_termination() + (name_start - pattern_start);
+            } else {
+                auto it = capture_group_names_copy.find_if([&](auto const& capture_group_name) { return capture_group_name.view() == name; });
+                VERIFY(it != capture_group_names_copy.end());
+                name_copy = it->view().characters_without_null_termination();
+            }
+            bytecode[state.instruction_position + 1] = bit_cast<ByteCodeValueType>(name_copy);
+        }
+        state.instruction_position += opcode.size();
+    }
+
+    return copy;
+}
+
+// NOTE: Reference counts aren't atomic, so the cache keeps its own copies of everything and hands out copies of those:
+//       A Regex may well be destroyed on another thread than the one it was compiled on, and the cache goes away on thread exit.
+struct CompiledPattern {
+    CompiledPattern(CompiledPatternKey const& key, regex::Parser::Result const& parser_result)
+        : key { ByteString { key.pattern.view() }, key.options }
+    {
+        for (auto const& name : parser_result.capture_groups)
+            capture_group_names.append(name.view());
+        this->parser_result = copy_parser_result(parser_result, key.pattern, this->key.pattern, capture_group_names);
+    }
+
+    CompiledPatternKey key;
+    Vector<ByteString> capture_group_names;
+    regex::Parser::Result parser_result;
+
+    IntrusiveListNode<CompiledPattern> lru_list_node;
+    using LRUList = IntrusiveList<&CompiledPattern::lru_list_node>;
+};
+
+template<class Parser>
+class CompiledPatternCache {
+public:
+    static CompiledPatternCache& the()
+    {
+        // NOTE: This is per-thread so that no locking is needed on the lookup path.
+        static thread_local CompiledPatternCache s_the;
+        return s_the;
+    }
+
+    CompiledPattern const* get(CompiledPatternKey const& key)
+    {
+        auto it = m_patterns.find(key);
+        if (it == m_patterns.end())
+            return nullptr;
+        m_lru_list.prepend(*it->value);
+        return it->value.ptr();
+    }
+
+    void set(CompiledPatternKey const& key, regex::Parser::Result const& parser_result)
+    {
+        if (m_patterns.size() >= c_compiled_pattern_cache_size) {
+            auto* least_recently_used = m_lru_list.take_last();
+            m_patterns.remove(least_recently_used->key);
+        }
+
+        auto compiled_pattern = make<CompiledPattern>(key, parser_result);
+        m_lru_list.prepend(*compiled_pattern);
+        m_patterns.set(compiled_pattern->key, move(compiled_pattern));
+    }
+
+private:
+    HashMap<CompiledPatternKey, NonnullOwnPtr<CompiledPattern>, CompiledPatternKeyTraits> m_patterns;
+    // Most recently used first. NOTE: This has to go away before the patterns it links together.
+    CompiledPattern::LRUList m_lru_list;
+};
+
+}
+
 template<class Parser>
 Regex<Parser>::Regex(ByteString pattern, typename ParserTraits<Parser>::OptionsType regex_options)
     : pattern_value(move(pattern))
 {
-    regex::Lexer lexer(pattern_value);
+    auto& cache = CompiledPatternCache<Parser>::the();
+    CompiledPatternKey key { pattern_value, to_underlying(regex_options.value()) };
+
+    if (auto const* compiled_pattern = cache.get(key)) {
+        Vector<DeprecatedFlyString> capture_groups;
+        for (auto const& name : compiled_pattern->capture_group_names)
+            capture_groups.append(name.view());
+        parser_result = copy_parser_result(compiled_pattern->parser_result, compiled_pattern->key.pattern, pattern_value, capture_groups);
+        parser_result.capture_groups = move(capture_groups);
+    } else {
+        regex::Lexer lexer(pattern_value);
 
-    Parser parser(lexer, regex_options);
-    parser_result = parser.parse();
+        Parser parser(lexer, regex_options);
+        parser_result = parser.parse();
+
+        run_optimization_passes();
+        if (parser_result.error == regex::Error::NoError)
+            cache.set(key, parser_result);
+    }
 
-    run_optimization_passes();
     if (parser_result.error == regex::Error::NoError)
         matcher = make<Matcher<Parser>>(this, static_cast<decltype(regex_options.value())>(parser_result.options.value()));
 }
@@ -109,13 +296,64 @@ RegexResult Matcher<Parser>::match(RegexStringView view, Optional<typename Parse
             return match(view.lines(), regex_options); // FIXME: how do we know, which line ending a line has (1char or 2char)? This is needed to get the correct match offsets from start of string...
     }
 
-    Vector<RegexStringView> views;
-    views.append(view);
-    return match(views, regex_options);
+    return match(ReadonlySpan<RegexStringView> { &view, 1 }, regex_options);
 }
 
 template<typename Parser>
-RegexResult Matcher<Parser>::match(Vector<RegexStringView> const& views, Optional<typename ParserTraits<Parser>::OptionsType> regex_options) const
+RegexResult Matcher<Parser>::match(ReadonlySpan<RegexStringView> views, Optional<typename ParserTraits<Parser>::OptionsType> regex_options) const
+{
+    MatchScratchState scratch_state;
+    size_t operations = 0;
+
+    auto match_count = match_views(views, m_regex_options | regex_options.value_or({}).value(), scratch_state, operations);
+    if (!match_count.has_value())
+        return { false, 0, {}, {}, {}, operations };
+
+    auto& state = scratch_state.state;
+    RegexResult result {
+        *match_count != 0,
+        *match_count,
+        move(state.matches).release(),
+        move(state.capture_group_matches).release(),
+        operations,
+        m_pattern->parser_result.capture_groups_count,
+        m_pattern->parser_result.named_capture_groups_count,
+    };
+
+    if (*match_count) {
+        // Make sure there are as many capture matches as there are actual matches.
+        if (result.capture_group_matches.size() < *match_count)
+            result.capture_group_matches.resize(*match_count);
+        for (auto& matches : result.capture_group_matches)
+            matches.resize(m_pattern->parser_result.capture_groups_count + 1);
+        if (!scratch_state.input.regex_options.has_flag_set(AllFlags::SkipTrimEmptyMatches)) {
+            for (auto& matches : result.capture_group_matches)
+                matches.template remove_all_matching([](auto& match) { return match.view.is_null(); });
+        }
+    } else {
+        result.capture_group_matches.clear_with_capacity();
+    }
+
+    return result;
+}
+
+template<typename Parser>
+bool Matcher<Parser>::has_match(RegexStringView view, MatchScratchState& scratch_state, Optional<typename ParserTraits<Parser>::OptionsType> regex_options) const
+{
+    AllOptions options = m_regex_options | regex_options.value_or({}).value();
+
+    if constexpr (!IsSame<Parser, ECMA262>) {
+        if (options.has_flag_set(AllFlags::Multiline))
+            return match(view, regex_options).success;
+    }
+
+    size_t operations = 0;
+    auto match_count = match_views(ReadonlySpan<RegexStringView> { &view, 1 }, options, scratch_state, operations);
+    return match_count.value_or(0) != 0;
+}
+
+template<typename Parser>
+Optional<size_t> Matcher<Parser>::match_views(ReadonlySpan<RegexStringView> views, AllOptions options, MatchScratchState& scratch_state, size_t& operations) const
 {
     // If the pattern *itself* isn't stateful, reset any changes to start_offset.
     if (!((AllFlags)m_regex_options.value() & AllFlags::Internal_Stateful))
@@ -123,14 +361,44 @@ RegexResult Matcher<Parser>::match(Vector<RegexStringView> const& views, Optiona
 
     size_t match_count { 0 };
 
-    MatchInput input;
-    MatchState state;
-    size_t operations = 0;
-
-    input.regex_options = m_regex_options | regex_options.value_or({}).value();
+    // Start from a clean slate, but hang on to whatever the buffers grew to during earlier matches.
+    auto& input = scratch_state.input;
+    input.view = {};
+    input.match_index = 0;
+    input.line = 0;
+    input.column = 0;
+    input.global_offset = 0;
+    input.fail_counter = 0;
+    input.saved_positions.clear_with_capacity();
+    input.saved_code_unit_positions.clear_with_capacity();
+    input.saved_forks_since_last_save.clear_with_capacity();
+    input.checkpoints.clear_with_capacity();
+    input.fork_to_replace.clear();
+
+    auto& state = scratch_state.state;
+    state.string_position_before_match = 0;
+    state.string_position = 0;
+    state.string_position_in_code_units = 0;
+    state.instruction_position = 0;
+    state.fork_at_position = 0;
+    state.forks_since_last_save = 0;
+    state.initiating_fork.clear();
+    state.matches.clear_with_capacity();
+    state.capture_group_matches.clear_with_capacity();
+    state.repetition_marks.clear_with_capacity();
+
+    input.regex_options = options;
     input.start_offset = m_pattern->start_offset;
     size_t lines_to_skip = 0;
 
+    if (NativeRegex::is_enabled()) {
+        auto calls_left = m_match_calls_before_native_compilation.load(AK::MemoryOrder::memory_order_relaxed);
+        while (calls_left > 0 && !m_match_calls_before_native_compilation.compare_exchange_strong(calls_left, calls_left - 1, AK::MemoryOrder::memory_order_relaxed)) {
+        }
+        if (calls_left == 1)
+            m_native_regex.store(NativeRegex::try_compile(m_pattern->parser_result.bytecode, input.regex_options).leak_ptr(), AK::MemoryOrder::memory_order_release);
+    }
+
     bool unicode = input.regex_options.has_flag_set(AllFlags::Unicode);
     for (auto const& view : views)
         const_cast<RegexStringView&>(view).set_unicode(unicode);
@@ -185,6 +453,13 @@ RegexResult Matcher<Parser>::match(Vector<RegexStringView> const& views, Optiona
 
     auto single_match_only = input.regex_options.has_flag_set(AllFlags::SingleMatch);
 
+    // If every match has to start with a known literal, we can skip straight to the positions where it occurs,
+    // and if it has to contain one, there's nothing left to find once that doesn't occur anymore.
+    auto const& optimization_data = m_pattern->parser_result.optimization_data;
+    auto can_search_for_literals = !input.regex_options.has_flag_set(AllFlags::Insensitive);
+    auto can_skip_to_literal_prefix = can_search_for_literals && continue_search && optimization_data.literal_prefix.has_value();
+    auto can_look_for_required_literal = can_search_for_literals && optimization_data.required_literal.has_value();
+
     for (auto const& view : views) {
         if (lines_to_skip != 0) {
             ++input.line;
@@ -199,6 +474,7 @@ RegexResult Matcher<Parser>::match(Vector<RegexStringView> const& views, Optiona
         state.string_position = view_index;
         state.string_position_in_code_units = view_index;
         bool succeeded = false;
+        Optional<size_t> required_literal_position;
 
         if (view_index == view_length && m_pattern->parser_result.match_length_minimum == 0) {
             // Run the code until it tries to consume something.
@@ -214,7 +490,7 @@ RegexResult Matcher<Parser>::match(Vector<RegexStringView> const& views, Optiona
             state.instruction_position = 0;
             state.repetition_marks.clear();
 
-            auto success = execute(input, state, temp_operations);
+            auto success = execute(input, state, scratch_state, temp_operations);
             // This success is acceptable only if it doesn't read anything from the input (input length is 0).
             if (success && (state.string_position <= view_index)) {
                 operations = temp_operations;
@@ -245,6 +521,19 @@ RegexResult Matcher<Parser>::match(Vector<RegexStringView> const& views, Optiona
             if (match_length_minimum && match_length_minimum > view_length - view_index)
                 break;
 
+            if (can_skip_to_literal_prefix && can_search_for_literal(view)) {
+                auto next_candidate = find_literal(view, *optimization_data.literal_prefix, view_index);
+                if (!next_candidate.has_value())
+                    break;
+                view_index = *next_candidate;
+            }
+
+            if (can_look_for_required_literal && can_search_for_literal(view) && (!required_literal_position.has_value() || *required_literal_position < view_index)) {
+                required_literal_position = find_literal(view, *optimization_data.required_literal, view_index);
+                if (!required_literal_position.has_value())
+                    break;
+            }
+
             input.column = match_count;
             input.match_index = match_count;
 
@@ -253,7 +542,7 @@ RegexResult Matcher<Parser>::match(Vector<RegexStringView> const& views, Optiona
             state.instruction_position = 0;
             state.repetition_marks.clear();
 
-            auto success = execute(input, state, operations);
+            auto success = execute(input, state, scratch_state, operations);
             if (success) {
                 succeeded = true;
 
@@ -286,9 +575,8 @@ RegexResult Matcher<Parser>::match(Vector<RegexStringView> const& views, Optiona
                     append_match(input, state, view_index);
                     break;
                 }
-                if (state.string_position < view_length) {
-                    return { false, 0, {}, {}, {}, operations };
-                }
+                if (state.string_position < view_length)
+                    return {};
 
                 append_match(input, state, view_index);
                 break;
@@ -308,117 +596,14 @@ RegexResult Matcher<Parser>::match(Vector<RegexStringView> const& views, Optiona
             break;
     }
 
-    RegexResult result {
-        match_count != 0,
-        match_count,
-        move(state.matches).release(),
-        move(state.capture_group_matches).release(),
-        operations,
-        m_pattern->parser_result.capture_groups_count,
-        m_pattern->parser_result.named_capture_groups_count,
-    };
-
-    if (match_count) {
-        // Make sure there are as many capture matches as there are actual matches.
-        if (result.capture_group_matches.size() < match_count)
-            result.capture_group_matches.resize(match_count);
-        for (auto& matches : result.capture_group_matches)
-            matches.resize(m_pattern->parser_result.capture_groups_count + 1);
-        if (!input.regex_options.has_flag_set(AllFlags::SkipTrimEmptyMatches)) {
-            for (auto& matches : result.capture_group_matches)
-                matches.template remove_all_matching([](auto& match) { return match.view.is_null(); });
-        }
-    } else {
-        result.capture_group_matches.clear_with_capacity();
-    }
-
-    return result;
+    return match_count;
 }
 
-template<typename T>
-class BumpAllocatedLinkedList {
-public:
-    BumpAllocatedLinkedList() = default;
-
-    ALWAYS_INLINE void append(T value)
-    {
-        auto node_ptr = m_allocator.allocate(move(value));
-        VERIFY(node_ptr);
-
-        if (!m_first) {
-            m_first = node_ptr;
-            m_last = node_ptr;
-            return;
-        }
-
-        node_ptr->previous = m_last;
-        m_last->next = node_ptr;
-        m_last = node_ptr;
-    }
-
-    ALWAYS_INLINE T take_last()
-    {
-        VERIFY(m_last);
-        T value = move(m_last->value);
-        if (m_last == m_first) {
-            m_last = nullptr;
-            m_first = nullptr;
-        } else {
-            m_last = m_last->previous;
-            m_last->next = nullptr;
-        }
-        return value;
-    }
-
-    ALWAYS_INLINE T& last()
-    {
-        return m_last->value;
-    }
-
-    ALWAYS_INLINE bool is_empty() const
-    {
-        return m_first == nullptr;
-    }
-
-    auto reverse_begin() { return ReverseIterator(m_last); }
-    auto reverse_end() { return ReverseIterator(); }
-
-private:
-    struct Node {
-        T value;
-        Node* next { nullptr };
-        Node* previous { nullptr };
-    };
-
-    struct ReverseIterator {
-        ReverseIterator() = default;
-        explicit ReverseIterator(Node* node)
-            : m_node(node)
-        {
-        }
-
-        T* operator->() { return &m_node->value; }
-        T& operator*() { return m_node->value; }
-        bool operator==(ReverseIterator const& it) const { return m_node == it.m_node; }
-        ReverseIterator& operator++()
-        {
-            if (m_node)
-                m_node = m_node->previous;
-            return *this;
-        }
-
-    private:
-        Node* m_node;
-    };
-
-    UniformBumpAllocator<Node, true, 2 * MiB> m_allocator;
-    Node* m_first { nullptr };
-    Node* m_last { nullptr };
-};
-
 template<class Parser>
-bool Matcher<Parser>::execute(MatchInput const& input, MatchState& state, size_t& operations) const
+bool Matcher<Parser>::execute(MatchInput const& input, MatchState& state, MatchScratchState& scratch_state, size_t& operations) const
 {
+    auto& states_to_try_next = scratch_state.states_to_try_next;
+
     if (m_pattern->parser_result.optimization_data.pure_substring_search.has_value() && input.view.is_string_view()) {
         // Yay, we can do a simple substring search!
         auto& needle = m_pattern->parser_result.optimization_data.pure_substring_search.value();
@@ -439,7 +624,25 @@ bool Matcher<Parser>::execute(MatchInput const& input, MatchState& state, size_t
         return true;
     }
 
-    BumpAllocatedLinkedList<MatchState> states_to_try_next;
+    auto const* native_regex = m_native_regex.load(AK::MemoryOrder::memory_order_acquire);
+    if (native_regex && input.view.is_string_view() && !input.view.unicode() && native_regex->options().value() == input.regex_options.value()) {
+        size_t end = 0;
+        ++operations;
+        switch (native_regex->execute(input.view.string_view(), state.string_position, end, scratch_state.native_regex_scratch)) {
+        case NativeRegex::Result::Matched:
+            state.string_position = end;
+            state.string_position_in_code_units = end;
+            return true;
+        case NativeRegex::Result::Failed:
+            return false;
+        case NativeRegex::Result::OutOfBacktrackingSpace:
+            // Let the interpreter have a go, it has no such limit.
+            break;
+        }
+    }
+
+    // Leftover states would share the buffers of the final state, and force copies once that is modified.
+    ScopeGuard clear_states_to_try_next = [&] { states_to_try_next.clear(); };
 #if REGEX_DEBUG
     size_t recursion_level = 0;
 #endif
@@ -7,10 +7,13 @@
 #pragma once
 
 #include "RegexByteCode.h"
+#include "RegexJIT.h"
 #include "RegexMatch.h"
 #include "RegexOptions.h"
 #include "RegexParser.h"
 
+#include <AK/Atomic.h>
+#include <AK/BumpAllocator.h>
 #include <AK/Forward.h>
 #include <AK/GenericLexer.h>
 #include <AK/HashMap.h>
@@ -30,6 +33,121 @@ struct Block {
     size_t end;
 };
 
+template<typename T>
+class BumpAllocatedLinkedList {
+public:
+    BumpAllocatedLinkedList() = default;
+
+    ALWAYS_INLINE void append(T value)
+    {
+        Node* node_ptr;
+        if (m_free_nodes) {
+            // Reuse a node that was taken off the list before, its value is in a moved-from state.
+            node_ptr = m_free_nodes;
+            m_free_nodes = node_ptr->previous;
+            node_ptr->value = move(value);
+            node_ptr->previous = nullptr;
+        } else {
+            node_ptr = m_allocator.allocate(move(value));
+            VERIFY(node_ptr);
+        }
+
+        if (!m_first) {
+            m_first = node_ptr;
+            m_last = node_ptr;
+            return;
+        }
+
+        node_ptr->previous = m_last;
+        m_last->next = node_ptr;
+        m_last = node_ptr;
+    }
+
+    ALWAYS_INLINE T take_last()
+    {
+        VERIFY(m_last);
+        auto* node_ptr = m_last;
+        T value = move(node_ptr->value);
+        if (m_last == m_first) {
+            m_last = nullptr;
+            m_first = nullptr;
+        } else {
+            m_last = m_last->previous;
+            m_last->next = nullptr;
+        }
+        release_node(node_ptr);
+        return value;
+    }
+
+    // Drops all values, but keeps their nodes around for the next append()s.
+    void clear()
+    {
+        while (m_last) {
+            auto* node_ptr = m_last;
+            m_last = node_ptr->previous;
+            {
+                // Let go of whatever the value holds on to, so that nothing keeps sharing it.
+                [[maybe_unused]] T discarded = move(node_ptr->value);
+            }
+            release_node(node_ptr);
+        }
+        m_first = nullptr;
+    }
+
+    ALWAYS_INLINE T& last()
+    {
+        return m_last->value;
+    }
+
+    ALWAYS_INLINE bool is_empty() const
+    {
+        return m_first == nullptr;
+    }
+
+    auto reverse_begin() { return ReverseIterator(m_last); }
+    auto reverse_end() { return ReverseIterator(); }
+
+private:
+    struct Node {
+        T value;
+        Node* next { nullptr };
+        Node* previous { nullptr };
+    };
+
+    struct ReverseIterator {
+        ReverseIterator() = default;
+        explicit ReverseIterator(Node* node)
+            : m_node(node)
+        {
+        }
+
+        T* operator->() { return &m_node->value; }
+        T& operator*() { return m_node->value; }
+        bool operator==(ReverseIterator const& it) const { return m_node == it.m_node; }
+        ReverseIterator& operator++()
+        {
+            if (m_node)
+                m_node = m_node->previous;
+            return *this;
+        }
+
+    private:
+        Node* m_node { nullptr };
+    };
+
+    ALWAYS_INLINE void release_node(Node* node_ptr)
+    {
+        node_ptr->next = nullptr;
+        node_ptr->previous = m_free_nodes;
+        m_free_nodes = node_ptr;
+    }
+
+    UniformBumpAllocator<Node, true, 2 * MiB> m_allocator;
+    Node* m_first { nullptr };
+    Node* m_last { nullptr };
+    Node* m_free_nodes { nullptr };
+};
+
 }
 
 static constexpr size_t const c_max_recursion = 5000;
@@ -48,6 +166,30 @@ struct RegexResult final {
 template<class Parser>
 class Regex;
 
+template<class Parser>
+class Matcher;
+
+// Everything a match needs besides the pattern and the input, so that callers matching
+// over and over (e.g. for every element or every line) can keep it around and have the
+// buffers it grew during earlier matches reused instead of allocating them again.
+// NOTE: A scratch state must only be used by one match at a time.
+class MatchScratchState {
+    AK_MAKE_NONCOPYABLE(MatchScratchState);
+    AK_MAKE_NONMOVABLE(MatchScratchState);
+
+public:
+    MatchScratchState() = default;
+
+private:
+    template<class Parser>
+    friend class Matcher;
+
+    MatchInput input;
+    MatchState state;
+    Detail::BumpAllocatedLinkedList<MatchState> states_to_try_next;
+    Vector<u64> native_regex_scratch;
+};
+
 template<class Parser>
 class Matcher final {
 
@@ -57,10 +199,20 @@ public:
         , m_regex_options(regex_options.value_or({}))
     {
     }
-    ~Matcher() = default;
+    ~Matcher()
+    {
+        delete m_native_regex.load();
+    }
 
     RegexResult match(RegexStringView, Optional<typename ParserTraits<Parser>::OptionsType> = {}) const;
-    RegexResult match(Vector<RegexStringView> const&, Optional<typename ParserTraits<Parser>::OptionsType> = {}) const;
+    RegexResult match(ReadonlySpan<RegexStringView>, Optional<typename ParserTraits<Parser>::OptionsType> = {}) const;
+    RegexResult match(Vector<RegexStringView> const& views, Optional<typename ParserTraits<Parser>::OptionsType> regex_options = {}) const
+    {
+        return match(views.span(), regex_options);
+    }
+
+    // Like match(view, options).success, but using (and growing) the caller's scratch state instead of fresh buffers.
+    bool has_match(RegexStringView, MatchScratchState&, Optional<typename ParserTraits<Parser>::OptionsType> = {}) const;
 
     typename ParserTraits<Parser>::OptionsType options() const
     {
@@ -73,10 +225,17 @@ public:
     }
 
 private:
-    bool execute(MatchInput const& input, MatchState& state, size_t& operations) const;
+    // Returns the number of matches, or nothing if the views were rejected as a whole.
+    Optional<size_t> match_views(ReadonlySpan<RegexStringView>, AllOptions, MatchScratchState&, size_t& operations) const;
+    bool execute(MatchInput const& input, MatchState& state, MatchScratchState&, size_t& operations) const;
 
     Regex<Parser> const* m_pattern;
     typename ParserTraits<Parser>::OptionsType const m_regex_options;
+
+    // NOTE: The same Regex may be matched against on several threads at once. Only the match call that uses up the
+    //       countdown compiles native code, which is only published once it's done.
+    mutable Atomic<NativeRegex*> m_native_regex { nullptr };
+    mutable Atomic<size_t> m_match_calls_before_native_compilation { NativeRegex::compilation_threshold };
 };
 
 template<class Parser>
@@ -225,6 +384,13 @@ public:
         return result.success;
     }
 
+    bool has_match(RegexStringView view, MatchScratchState& scratch_state, Optional<typename ParserTraits<Parser>::OptionsType> regex_options = {}) const
+    {
+        if (!matcher || parser_result.error != Error::NoError)
+            return false;
+        return matcher->has_match(view, scratch_state, AllOptions { regex_options.value_or({}) } | AllFlags::SkipSubExprResults);
+    }
+
     using BasicBlockList = Vector<Detail::Block>;
     static BasicBlockList split_basic_blocks(ByteCode const&);
 
@@ -232,6 +398,7 @@ private:
     void run_optimization_passes();
     void attempt_rewrite_loops_as_atomic_groups(BasicBlockList const&);
     bool attempt_rewrite_entire_match_as_substring_search(BasicBlockList const&);
+    void fill_optimization_data();
 };
 
 // free standing functions for match, search and has_match
@@ -298,5 +465,6 @@ bool has_match(Vector<RegexStringView> const& views, Regex<Parser>& pattern, Opt
 
 using regex::has_match;
 using regex::match;
+using regex::MatchScratchState;
 using regex::Regex;
 using regex::RegexResult;
@@ -37,6 +37,9 @@ void Regex<Parser>::run_optimization_passes()
     attempt_rewrite_loops_as_atomic_groups(blocks);
 
     parser_result.bytecode.flatten();
+
+    if (parser_result.error == Error::NoError)
+        fill_optimization_data();
 }
 
 template<typename Parser>
@@ -572,6 +575,118 @@ bool Regex<Parser>::attempt_rewrite_entire_match_as_substring_search(BasicBlockL
     return true;
 }
 
+template<typename Parser>
+void Regex<Parser>::fill_optimization_data()
+{
+    // Find the literals that every match has to contain, so the matcher can skip over positions that can't match:
+    // - The literal that every match starts with, which the matcher can skip straight to.
+    //   e.g. /foo(bar|baz)+/ -> "foo"
+    // - The longest literal that every match contains somewhere; if it doesn't occur past a position, no match can start there.
+    //   e.g. /\w+@example\.com/ -> "@example.com"
+    auto& bytecode = parser_result.bytecode;
+
+    // An instruction is executed on every path to the end of the bytecode, unless a forward jump from before it can skip over it.
+    size_t furthest_forward_jump_target = 0;
+    // Whether nothing that consumes input or forks can have run yet.
+    bool is_at_start = true;
+
+    StringBuilder literal;
+    bool literal_is_prefix = false;
+    Optional<ByteString> longest_literal;
+
+    auto finish_literal = [&] {
+        if (literal.is_empty())
+            return;
+        auto string = literal.to_byte_string();
+        // The matcher already skips to the prefix, so the required literal is only useful if it's another one.
+        if (literal_is_prefix)
+            parser_result.optimization_data.literal_prefix = move(string);
+        else if (!longest_literal.has_value() || string.length() > longest_literal->length())
+            longest_literal = move(string);
+        literal.clear();
+        literal_is_prefix = false;
+    };
+
+    MatchState state;
+    while (state.instruction_position < bytecode.size()) {
+        auto& opcode = bytecode.get_opcode(state);
+        auto position = state.instruction_position;
+        auto is_executed_by_every_match = position >= furthest_forward_jump_target;
+
+        auto handle_jump = [&](ssize_t offset) {
+            // Forks to the next instruction are left behind by the alternation optimizer, and go nowhere.
+            if (offset == 0)
+                return;
+            finish_literal();
+            is_at_start = false;
+            auto target = static_cast<ssize_t>(position + opcode.size()) + offset;
+            if (target > static_cast<ssize_t>(position))
+                furthest_forward_jump_target = max(furthest_forward_jump_target, static_cast<size_t>(target));
+        };
+
+        switch (opcode.opcode_id()) {
+        case OpCodeId::Compare: {
+            auto flat_compares = static_cast<OpCode_Compare const&>(opcode).flat_compares();
+            // Multiple arguments in a single Compare are alternatives, not a sequence.
+            // Only plain ASCII is guaranteed to be encoded the same way in the pattern and the subject.
+            auto is_ascii_character = flat_compares.size() == 1
+                && flat_compares.first().type == CharacterCompareType::Char
+                && flat_compares.first().value <= 0x7f;
+
+            if (is_executed_by_every_match && is_ascii_character) {
+                if (literal.is_empty())
+                    literal_is_prefix = is_at_start;
+                literal.append(static_cast<char>(flat_compares.first().value));
+            } else {
+                finish_literal();
+            }
+            is_at_start = false;
+            break;
+        }
+        case OpCodeId::SaveLeftCaptureGroup:
+        case OpCodeId::SaveRightCaptureGroup:
+        case OpCodeId::SaveRightNamedCaptureGroup:
+        case OpCodeId::ClearCaptureGroup:
+        case OpCodeId::Checkpoint:
+        case OpCodeId::ResetRepeat:
+        case OpCodeId::CheckBegin:
+        case OpCodeId::CheckEnd:
+        case OpCodeId::CheckBoundary:
+            // These don't consume any input, so they don't split up a literal.
+            if (!is_executed_by_every_match)
+                finish_literal();
+            break;
+        case OpCodeId::Jump:
+            handle_jump(static_cast<OpCode_Jump const&>(opcode).offset());
+            break;
+        case OpCodeId::ForkJump:
+        case OpCodeId::ForkReplaceJump:
+            handle_jump(static_cast<OpCode_ForkJump const&>(opcode).offset());
+            break;
+        case OpCodeId::ForkStay:
+        case OpCodeId::ForkReplaceStay:
+            handle_jump(static_cast<OpCode_ForkStay const&>(opcode).offset());
+            break;
+        case OpCodeId::JumpNonEmpty:
+            handle_jump(static_cast<OpCode_JumpNonEmpty const&>(opcode).offset());
+            break;
+        case OpCodeId::Repeat:
+            // Repeat only ever jumps back.
+            handle_jump(0);
+            break;
+        default:
+            // Lookarounds move the string position around, so give up on whatever follows them.
+            finish_literal();
+            state.instruction_position = bytecode.size();
+            continue;
+        }
+        state.instruction_position += opcode.size();
+    }
+    finish_literal();
+
+    parser_result.optimization_data.required_literal = move(longest_literal);
+}
+
 template<typename Parser>
 void Regex<Parser>::attempt_rewrite_loops_as_atomic_groups(BasicBlockList const& basic_blocks)
 {
@@ -58,6 +58,10 @@ public:
 
         struct {
             Optional<ByteString> pure_substring_search;
+            // Literal that every match must start with; used to skip over positions that can't match.
+            Optional<ByteString> literal_prefix;
+            // The longest literal that every match must contain; there's nothing left to find once it doesn't occur anymore.
+            Optional<ByteString> required_literal;
         } optimization_data {};
     };
 
@@ -510,6 +510,8 @@ public:
     UnaryOperator type() const { return m_type; }
     virtual ResultOr<Value> evaluate(ExecutionContext&) const override;
 
+    static ResultOr<Value> apply(UnaryOperator, Value const&);
+
 private:
     UnaryOperator m_type;
 };
@@ -566,6 +568,8 @@ public:
     BinaryOperator type() const { return m_type; }
     virtual ResultOr<Value> evaluate(ExecutionContext&) const override;
 
+    static ResultOr<Value> apply(BinaryOperator, Value const& lhs, Value const& rhs);
+
 private:
     BinaryOperator m_type;
 };
@@ -673,6 +677,11 @@ public:
     RefPtr<Expression> const& escape() const { return m_escape; }
     virtual ResultOr<Value> evaluate(ExecutionContext&) const override;
 
+    static ResultOr<Value> apply(MatchOperator, bool invert_expression, Value const& lhs, Value const& rhs, Optional<Value> const& escape);
+
+    // Translates a LIKE pattern into the POSIX basic regular expression it stands for.
+    static ResultOr<ByteString> like_pattern_to_regex(Value const& pattern, Optional<Value> const& escape);
+
 private:
     MatchOperator m_type;
     RefPtr<Expression> m_escape;
@@ -831,6 +840,36 @@ private:
     bool m_is_error_if_table_exists;
 };
 
+class CreateIndex : public Statement {
+public:
+    CreateIndex(ByteString schema_name, ByteString table_name, ByteString index_name, Vector<NonnullRefPtr<OrderingTerm>> indexed_columns, bool is_unique, bool is_error_if_index_exists)
+        : m_schema_name(move(schema_name))
+        , m_table_name(move(table_name))
+        , m_index_name(move(index_name))
+        , m_indexed_columns(move(indexed_columns))
+        , m_is_unique(is_unique)
+        , m_is_error_if_index_exists(is_error_if_index_exists)
+    {
+    }
+
+    ByteString const& schema_name() const { return m_schema_name; }
+    ByteString const& table_name() const { return m_table_name; }
+    ByteString const& index_name() const { return m_index_name; }
+    Vector<NonnullRefPtr<OrderingTerm>> const& indexed_columns() const { return m_indexed_columns; }
+    bool is_unique() const { return m_is_unique; }
+    bool is_error_if_index_exists() const { return m_is_error_if_index_exists; }
+
+    ResultOr<ResultSet> execute(ExecutionContext&) const override;
+
+private:
+    ByteString m_schema_name;
+    ByteString m_table_name;
+    ByteString m_index_name;
+    Vector<NonnullRefPtr<OrderingTerm>> m_indexed_columns;
+    bool m_is_unique;
+    bool m_is_error_if_index_exists;
+};
+
 class AlterTable : public Statement {
 public:
     ByteString const& schema_name() const { return m_schema_name; }
@@ -1107,4 +1146,18 @@ private:
     NonnullRefPtr<QualifiedTableName> m_qualified_table_name;
 };
 
+class Explain : public Statement {
+public:
+    Explain(NonnullRefPtr<Select> select_statement)
+        : m_select_statement(move(select_statement))
+    {
+    }
+
+    NonnullRefPtr<Select> const& select_statement() const { return m_select_statement; }
+    ResultOr<ResultSet> execute(ExecutionContext&) const override;
+
+private:
+    NonnullRefPtr<Select> m_select_statement;
+};
+
 }
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/TypeCasts.h>
+#include <LibSQL/AST/CompiledExpression.h>
+#include <LibSQL/Tuple.h>
+
+namespace SQL::AST {
+
+CompiledExpression::~CompiledExpression() = default;
+
+ErrorOr<CompiledExpression> CompiledExpression::compile(Expression const& expression, TupleDescriptor const& row_descriptor)
+{
+    CompiledExpression compiled;
+    compiled.m_row_size = row_descriptor.size();
+    compiled.m_result = TRY(compiled.compile_expression(expression, row_descriptor));
+    TRY(compiled.m_registers.try_resize(compiled.m_register_count));
+    return compiled;
+}
+
+ErrorOr<CompiledExpression::Operand> CompiledExpression::add_constant(Value value)
+{
+    TRY(m_constants.try_append(move(value)));
+    return Operand { Operand::Type::Constant, m_constants.size() - 1 };
+}
+
+ErrorOr<CompiledExpression::Operand> CompiledExpression::add_instruction(size_t destination, Instruction instruction)
+{
+    TRY(m_instructions.try_append(move(instruction)));
+    return Operand { Operand::Type::Register, destination };
+}
+
+ErrorOr<CompiledExpression::Operand> CompiledExpression::compile_expression(Expression const& expression, TupleDescriptor const& row_descriptor)
+{
+    if (is<NumericLiteral>(expression))
+        return add_constant(Value { static_cast<NumericLiteral const&>(expression).value() });
+    if (is<StringLiteral>(expression))
+        return add_constant(Value { static_cast<StringLiteral const&>(expression).value() });
+    if (is<BooleanLiteral>(expression))
+        return add_constant(Value { static_cast<BooleanLiteral const&>(expression).value() });
+    if (is<NullLiteral>(expression))
+        return add_constant(Value {});
+
+    if (is<Placeholder>(expression)) {
+        auto destination = allocate_register();
+        return add_instruction(destination, LoadPlaceholder { destination, static_cast<Placeholder const&>(expression).parameter_index() });
+    }
+
+    if (is<ColumnNameExpression>(expression))
+        return compile_column(static_cast<ColumnNameExpression const&>(expression), row_descriptor);
+
+    // Operators whose operands are all constants are applied right away, unless that fails; the
+    // error is reported when the expression is evaluated instead.
+    if (is<UnaryOperatorExpression>(expression)) {
+        auto const& unary = static_cast<UnaryOperatorExpression const&>(expression);
+        auto operand = TRY(compile_expression(*unary.expression(), row_descriptor));
+
+        if (operand.type == Operand::Type::Constant) {
+            if (auto value = UnaryOperatorExpression::apply(unary.type(), m_constants[operand.index]); !value.is_error())
+                return add_constant(value.release_value());
+        }
+
+        auto destination = allocate_register();
+        return add_instruction(destination, ApplyUnaryOperator { destination, unary.type(), operand });
+    }
+
+    if (is<BinaryOperatorExpression>(expression)) {
+        auto const& binary = static_cast<BinaryOperatorExpression const&>(expression);
+        auto lhs = TRY(compile_expression(*binary.lhs(), row_descriptor));
+        auto rhs = TRY(compile_expression(*binary.rhs(), row_descriptor));
+
+        if (lhs.type == Operand::Type::Constant && rhs.type == Operand::Type::Constant) {
+            if (auto value = BinaryOperatorExpression::apply(binary.type(), m_constants[lhs.index], m_constants[rhs.index]); !value.is_error())
+                return add_constant(value.release_value());
+        }
+
+        auto destination = allocate_register();
+        return add_instruction(destination, ApplyBinaryOperator { destination, binary.type(), lhs, rhs });
+    }
+
+    if (is<ChainedExpression>(expression)) {
+        auto const& chained = static_cast<ChainedExpression const&>(expression);
+
+        Vector<Operand> elements;
+        TRY(elements.try_ensure_capacity(chained.expressions().size()));
+        bool all_constant = true;
+
+        for (auto const& element : chained.expressions()) {
+            auto operand = TRY(compile_expression(*element, row_descriptor));
+            all_constant &= operand.type == Operand::Type::Constant;
+            elements.unchecked_append(operand);
+        }
+
+        if (all_constant) {
+            Vector<Value> values;
+            TRY(values.try_ensure_capacity(elements.size()));
+            for (auto const& element : elements)
+                values.unchecked_append(m_constants[element.index]);
+
+            if (auto value = Value::create_tuple(move(values)); !value.is_error())
+                return add_constant(value.release_value());
+        }
+
+        auto destination = allocate_register();
+        return add_instruction(destination, MakeTuple { destination, move(elements) });
+    }
+
+    if (is<MatchExpression>(expression))
+        return compile_match(static_cast<MatchExpression const&>(expression), row_descriptor);
+
+    auto destination = allocate_register();
+    return add_instruction(destination, Evaluate { destination, expression });
+}
+
+ErrorOr<CompiledExpression::Operand> CompiledExpression::compile_column(ColumnNameExpression const& column, TupleDescriptor const& row_descriptor)
+{
+    Optional<size_t> index_in_row;
+    for (size_t i = 0; i < row_descriptor.size(); ++i) {
+        auto const& column_descriptor = row_descriptor[i];
+        if (!column.table_name().is_empty() && column_descriptor.table != column.table_name())
+            continue;
+        if (column_descriptor.name != column.column_name())
+            continue;
+
+        if (index_in_row.has_value())
+            return add_instruction(allocate_register(), Fail { SQLErrorCode::AmbiguousColumnName, column.column_name() });
+        index_in_row = i;
+    }
+
+    if (!index_in_row.has_value())
+        return add_instruction(allocate_register(), Fail { SQLErrorCode::ColumnDoesNotExist, column.column_name() });
+    return Operand { Operand::Type::Column, *index_in_row };
+}
+
+ErrorOr<CompiledExpression::Operand> CompiledExpression::compile_match(MatchExpression const& match, TupleDescriptor const& row_descriptor)
+{
+    // GLOB and MATCH aren't implemented, and fail without looking at their operands.
+    if (match.type() != MatchOperator::Like && match.type() != MatchOperator::Regexp) {
+        auto destination = allocate_register();
+        return add_instruction(destination, Evaluate { destination, match });
+    }
+
+    auto lhs = TRY(compile_expression(*match.lhs(), row_descriptor));
+    auto rhs = TRY(compile_expression(*match.rhs(), row_descriptor));
+
+    Optional<Operand> escape;
+    if (match.type() == MatchOperator::Like && match.escape())
+        escape = TRY(compile_expression(*match.escape(), row_descriptor));
+
+    auto destination = allocate_register();
+    Match instruction { destination, match.type(), match.invert_expression(), lhs, rhs, escape, {}, {} };
+
+    bool pattern_is_constant = rhs.type == Operand::Type::Constant && (!escape.has_value() || escape->type == Operand::Type::Constant);
+    if (pattern_is_constant) {
+        auto const& pattern = m_constants[rhs.index];
+
+        if (match.type() == MatchOperator::Like) {
+            Optional<Value> escape_value;
+            if (escape.has_value())
+                escape_value = m_constants[escape->index];
+
+            if (auto regex = MatchExpression::like_pattern_to_regex(pattern, escape_value); !regex.is_error())
+                instruction.like_regex = TRY(try_make<Regex<PosixBasic>>(regex.release_value()));
+        } else {
+            auto regex = TRY(try_make<Regex<PosixExtended>>(pattern.to_byte_string()));
+            if (regex->parser_result.error == regex::Error::NoError)
+                instruction.regexp_regex = move(regex);
+        }
+    }
+
+    return add_instruction(destination, move(instruction));
+}
+
+Value const& CompiledExpression::value_of(Operand const& operand, Tuple const& row) const
+{
+    switch (operand.type) {
+    case Operand::Type::Constant:
+        return m_constants[operand.index];
+    case Operand::Type::Column:
+        return row[operand.index];
+    case Operand::Type::Register:
+        return m_registers[operand.index];
+    }
+    VERIFY_NOT_REACHED();
+}
+
+ResultOr<void> CompiledExpression::execute(Instruction const& instruction, ExecutionContext& context, Tuple const& row)
+{
+    return instruction.visit(
+        [&](LoadPlaceholder const& load) -> ResultOr<void> {
+            if (load.parameter_index >= context.placeholder_values.size())
+                return Result { SQLCommand::Unknown, SQLErrorCode::InvalidNumberOfPlaceholderValues };
+            m_registers[load.destination] = context.placeholder_values[load.parameter_index];
+            return {};
+        },
+        [&](ApplyUnaryOperator const& apply) -> ResultOr<void> {
+            m_registers[apply.destination] = TRY(UnaryOperatorExpression::apply(apply.op, value_of(apply.operand, row)));
+            return {};
+        },
+        [&](ApplyBinaryOperator const& apply) -> ResultOr<void> {
+            m_registers[apply.destination] = TRY(BinaryOperatorExpression::apply(apply.op, value_of(apply.lhs, row), value_of(apply.rhs, row)));
+            return {};
+        },
+        [&](MakeTuple const& make_tuple) -> ResultOr<void> {
+            Vector<Value> values;
+            TRY(values.try_ensure_capacity(make_tuple.elements.size()));
+            for (auto const& element : make_tuple.elements)
+                values.unchecked_append(value_of(element, row));
+
+            m_registers[make_tuple.destination] = TRY(Value::create_tuple(move(values)));
+            return {};
+        },
+        [&](Match const& match) -> ResultOr<void> {
+            auto const& lhs = value_of(match.lhs, row);
+
+            Optional<bool> matched;
+            if (match.like_regex)
+                matched = match.like_regex->match(lhs.to_byte_string(), PosixFlags::Insensitive | PosixFlags::Unicode).success;
+            else if (match.regexp_regex)
+                matched = match.regexp_regex->match(lhs.to_byte_string(), PosixFlags::Insensitive | PosixFlags::Unicode).success;
+
+            if (matched.has_value()) {
+                m_registers[match.destination] = Value(match.invert_expression ? !*matched : *matched);
+                return {};
+            }
+
+            Optional<Value> escape;
+            if (match.escape.has_value())
+                escape = value_of(*match.escape, row);
+
+            m_registers[match.destination] = TRY(MatchExpression::apply(match.op, match.invert_expression, lhs, value_of(match.rhs, row), escape));
+            return {};
+        },
+        [&](Evaluate const& evaluate) -> ResultOr<void> {
+            m_registers[evaluate.destination] = TRY(evaluate.expression->evaluate(context));
+            return {};
+        },
+        [&](Fail const& fail) -> ResultOr<void> {
+            return Result { SQLCommand::Unknown, fail.error, fail.message };
+        });
+}
+
+ResultOr<Value> CompiledExpression::evaluate(ExecutionContext& context)
+{
+    VERIFY(context.current_row);
+    auto const& row = *context.current_row;
+    VERIFY(row.size() == m_row_size);
+
+    for (auto const& instruction : m_instructions)
+        TRY(execute(instruction, context, row));
+
+    return value_of(m_result, row);
+}
+
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/ByteString.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Variant.h>
+#include <AK/Vector.h>
+#include <LibRegex/Regex.h>
+#include <LibSQL/AST/AST.h>
+#include <LibSQL/Result.h>
+#include <LibSQL/TupleDescriptor.h>
+#include <LibSQL/Value.h>
+
+namespace SQL::AST {
+
+// An expression compiled against the descriptor of the rows it's going to be evaluated on. Column
+// names are resolved to positions in the row once, parts of the expression that only consist of
+// literals are folded into constants, and what's left is flattened into a list of instructions
+// that each write their result into a register. The row is taken from the context's current_row,
+// just like when evaluating the expression itself.
+//
+// Column names that don't resolve, and kinds of expressions the compiler doesn't know about, are
+// reported or evaluated when the compiled expression is evaluated, so it behaves exactly like the
+// expression it was compiled from.
+class CompiledExpression {
+    AK_MAKE_NONCOPYABLE(CompiledExpression);
+    AK_MAKE_DEFAULT_MOVABLE(CompiledExpression);
+
+public:
+    static ErrorOr<CompiledExpression> compile(Expression const&, TupleDescriptor const& row_descriptor);
+    ~CompiledExpression();
+
+    ResultOr<Value> evaluate(ExecutionContext&);
+
+    [[nodiscard]] size_t instruction_count() const { return m_instructions.size(); }
+    [[nodiscard]] bool is_constant() const { return m_result.type == Operand::Type::Constant; }
+
+private:
+    struct Operand {
+        enum class Type : u8 {
+            Constant,
+            Column,
+            Register,
+        };
+
+        Type type { Type::Constant };
+        size_t index { 0 };
+    };
+
+    struct LoadPlaceholder {
+        size_t destination { 0 };
+        size_t parameter_index { 0 };
+    };
+
+    struct ApplyUnaryOperator {
+        size_t destination { 0 };
+        UnaryOperator op;
+        Operand operand;
+    };
+
+    struct ApplyBinaryOperator {
+        size_t destination { 0 };
+        BinaryOperator op;
+        Operand lhs;
+        Operand rhs;
+    };
+
+    struct MakeTuple {
+        size_t destination { 0 };
+        Vector<Operand> elements;
+    };
+
+    // The regular expression is compiled up front if the pattern is a constant.
+    struct Match {
+        size_t destination { 0 };
+        MatchOperator op;
+        bool invert_expression { false };
+        Operand lhs;
+        Operand rhs;
+        Optional<Operand> escape;
+        OwnPtr<Regex<PosixBasic>> like_regex;
+        OwnPtr<Regex<PosixExtended>> regexp_regex;
+    };
+
+    // Falls back to evaluating the expression itself.
+    struct Evaluate {
+        size_t destination { 0 };
+        NonnullRefPtr<Expression const> expression;
+    };
+
+    // Reports a column name that didn't resolve.
+    struct Fail {
+        SQLErrorCode error { SQLErrorCode::NoError };
+        ByteString message;
+    };
+
+    using Instruction = Variant<LoadPlaceholder, ApplyUnaryOperator, ApplyBinaryOperator, MakeTuple, Match, Evaluate, Fail>;
+
+    CompiledExpression() = default;
+
+    ErrorOr<Operand> compile_expression(Expression const&, TupleDescriptor const& row_descriptor);
+    ErrorOr<Operand> compile_column(ColumnNameExpression const&, TupleDescriptor const& row_descriptor);
+    ErrorOr<Operand> compile_match(MatchExpression const&, TupleDescriptor const& row_descriptor);
+    ErrorOr<Operand> add_constant(Value);
+    ErrorOr<Operand> add_instruction(size_t destination, Instruction);
+    size_t allocate_register() { return m_register_count++; }
+
+    Value const& value_of(Operand const&, Tuple const& row) const;
+    ResultOr<void> execute(Instruction const&, ExecutionContext&, Tuple const& row);
+
+    Vector<Instruction> m_instructions;
+    Vector<Value> m_constants;
+    Vector<Value> m_registers;
+    size_t m_register_count { 0 };
+    size_t m_row_size { 0 };
+    Operand m_result;
+};
+
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibSQL/AST/AST.h>
+#include <LibSQL/Database.h>
+#include <LibSQL/Meta.h>
+
+namespace SQL::AST {
+
+ResultOr<ResultSet> CreateIndex::execute(ExecutionContext& context) const
+{
+    // FIXME: Removed keys stay behind in index trees, which makes enforcing uniqueness more involved than refusing duplicate keys.
+    if (m_is_unique)
+        return Result { SQLCommand::Create, SQLErrorCode::NotYetImplemented, "Unique indexes are not yet implemented"sv };
+
+    auto table_def = TRY(context.database->get_table(m_schema_name, m_table_name));
+    auto index_def = TRY(IndexDef::create(table_def, m_index_name, false));
+
+    for (auto const& indexed_column : m_indexed_columns) {
+        if (!is<ColumnNameExpression>(*indexed_column->expression()))
+            return Result { SQLCommand::Create, SQLErrorCode::NotYetImplemented, "Indexes on expressions are not yet implemented"sv };
+        if (indexed_column->order() != Order::Ascending)
+            return Result { SQLCommand::Create, SQLErrorCode::NotYetImplemented, "Descending index columns are not yet implemented"sv };
+
+        auto const& column_name_expression = static_cast<ColumnNameExpression const&>(*indexed_column->expression());
+        if (!column_name_expression.table_name().is_empty() && column_name_expression.table_name() != m_table_name)
+            return Result { SQLCommand::Create, SQLErrorCode::ColumnDoesNotExist, column_name_expression.column_name() };
+
+        auto column = table_def->columns().first_matching([&](auto const& column) { return column->name() == column_name_expression.column_name(); });
+        if (!column.has_value())
+            return Result { SQLCommand::Create, SQLErrorCode::ColumnDoesNotExist, column_name_expression.column_name() };
+
+        index_def->append_column(column.value()->name(), column.value()->type());
+    }
+
+    if (auto result = context.database->add_index(*table_def, *index_def); result.is_error()) {
+        if (result.error().error() != SQLErrorCode::IndexExists || m_is_error_if_index_exists)
+            return result.release_error();
+    }
+
+    return ResultSet { SQLCommand::Create };
+}
+
+}
@@ -5,6 +5,7 @@
  */
 
 #include <LibSQL/AST/AST.h>
+#include <LibSQL/AST/CompiledExpression.h>
 #include <LibSQL/Database.h>
 #include <LibSQL/Meta.h>
 #include <LibSQL/Row.h>
@@ -19,10 +20,14 @@ ResultOr<ResultSet> Delete::execute(ExecutionContext& context) const
 
     ResultSet result { SQLCommand::Delete };
 
+    Optional<CompiledExpression> where_clause;
+    if (auto const& expression = this->where_clause())
+        where_clause = TRY(CompiledExpression::compile(*expression, table_def->to_tuple_descriptor()));
+
     for (auto& table_row : TRY(context.database->select_all(*table_def))) {
         context.current_row = &table_row;
 
-        if (auto const& where_clause = this->where_clause()) {
+        if (where_clause.has_value()) {
             auto where_result = TRY(where_clause->evaluate(context)).to_bool();
             if (!where_result.has_value() || !where_result.value())
                 continue;
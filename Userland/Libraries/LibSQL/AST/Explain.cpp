@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibSQL/AST/AST.h>
+#include <LibSQL/AST/QueryPlan.h>
+#include <LibSQL/Database.h>
+
+namespace SQL::AST {
+
+ResultOr<ResultSet> Explain::execute(ExecutionContext& context) const
+{
+    Vector<Value> placeholder_values;
+    TRY(placeholder_values.try_append(context.placeholder_values.data(), context.placeholder_values.size()));
+
+    auto plan = TRY(QueryPlan::create(*m_select_statement, context.database, move(placeholder_values)));
+    auto lines = plan->explain();
+
+    ResultSet result { SQLCommand::Explain, { "plan"sv } };
+    TRY(result.try_ensure_capacity(lines.size()));
+
+    for (auto& line : lines) {
+        Tuple tuple;
+        tuple.append(Value { move(line) });
+        result.unchecked_append({ move(tuple), Tuple {} });
+    }
+
+    return result;
+}
+
+}
@@ -61,11 +61,15 @@ ResultOr<Value> BinaryOperatorExpression::evaluate(ExecutionContext& context) co
 {
     Value lhs_value = TRY(lhs()->evaluate(context));
     Value rhs_value = TRY(rhs()->evaluate(context));
+    return apply(type(), lhs_value, rhs_value);
+}
 
-    switch (type()) {
+ResultOr<Value> BinaryOperatorExpression::apply(BinaryOperator type, Value const& lhs_value, Value const& rhs_value)
+{
+    switch (type) {
     case BinaryOperator::Concatenate: {
         if (lhs_value.type() != SQLType::Text)
-            return Result { SQLCommand::Unknown, SQLErrorCode::BooleanOperatorTypeMismatch, BinaryOperator_name(type()) };
+            return Result { SQLCommand::Unknown, SQLErrorCode::BooleanOperatorTypeMismatch, BinaryOperator_name(type) };
 
         AK::StringBuilder builder;
         builder.append(lhs_value.to_byte_string());
@@ -106,7 +110,7 @@ ResultOr<Value> BinaryOperatorExpression::evaluate(ExecutionContext& context) co
         auto lhs_bool_maybe = lhs_value.to_bool();
         auto rhs_bool_maybe = rhs_value.to_bool();
         if (!lhs_bool_maybe.has_value() || !rhs_bool_maybe.has_value())
-            return Result { SQLCommand::Unknown, SQLErrorCode::BooleanOperatorTypeMismatch, BinaryOperator_name(type()) };
+            return Result { SQLCommand::Unknown, SQLErrorCode::BooleanOperatorTypeMismatch, BinaryOperator_name(type) };
 
         return Value(lhs_bool_maybe.release_value() && rhs_bool_maybe.release_value());
     }
@@ -114,7 +118,7 @@ ResultOr<Value> BinaryOperatorExpression::evaluate(ExecutionContext& context) co
         auto lhs_bool_maybe = lhs_value.to_bool();
         auto rhs_bool_maybe = rhs_value.to_bool();
         if (!lhs_bool_maybe.has_value() || !rhs_bool_maybe.has_value())
-            return Result { SQLCommand::Unknown, SQLErrorCode::BooleanOperatorTypeMismatch, BinaryOperator_name(type()) };
+            return Result { SQLCommand::Unknown, SQLErrorCode::BooleanOperatorTypeMismatch, BinaryOperator_name(type) };
 
         return Value(lhs_bool_maybe.release_value() || rhs_bool_maybe.release_value());
     }
@@ -126,20 +130,22 @@ ResultOr<Value> BinaryOperatorExpression::evaluate(ExecutionContext& context) co
 ResultOr<Value> UnaryOperatorExpression::evaluate(ExecutionContext& context) const
 {
     Value expression_value = TRY(NestedExpression::evaluate(context));
+    return apply(type(), expression_value);
+}
 
-    switch (type()) {
+ResultOr<Value> UnaryOperatorExpression::apply(UnaryOperator type, Value const& expression_value)
+{
+    switch (type) {
     case UnaryOperator::Plus:
         if (expression_value.type() == SQLType::Integer || expression_value.type() == SQLType::Float)
             return expression_value;
-        return Result { SQLCommand::Unknown, SQLErrorCode::NumericOperatorTypeMismatch, UnaryOperator_name(type()) };
+        return Result { SQLCommand::Unknown, SQLErrorCode::NumericOperatorTypeMismatch, UnaryOperator_name(type) };
     case UnaryOperator::Minus:
         return expression_value.negate();
     case UnaryOperator::Not:
-        if (expression_value.type() == SQLType::Boolean) {
-            expression_value = !expression_value.to_bool().value();
-            return expression_value;
-        }
-        return Result { SQLCommand::Unknown, SQLErrorCode::BooleanOperatorTypeMismatch, UnaryOperator_name(type()) };
+        if (expression_value.type() == SQLType::Boolean)
+            return Value(!expression_value.to_bool().value());
+        return Result { SQLCommand::Unknown, SQLErrorCode::BooleanOperatorTypeMismatch, UnaryOperator_name(type) };
     case UnaryOperator::BitwiseNot:
         return expression_value.bitwise_not();
     default:
@@ -179,46 +185,65 @@ ResultOr<Value> MatchExpression::evaluate(ExecutionContext& context) const
         Value lhs_value = TRY(lhs()->evaluate(context));
         Value rhs_value = TRY(rhs()->evaluate(context));
 
-        char escape_char = '\0';
-        if (escape()) {
-            auto escape_str = TRY(escape()->evaluate(context)).to_byte_string();
-            if (escape_str.length() != 1)
-                return Result { SQLCommand::Unknown, SQLErrorCode::SyntaxError, "ESCAPE should be a single character" };
-            escape_char = escape_str[0];
-        }
+        Optional<Value> escape_value;
+        if (escape())
+            escape_value = TRY(escape()->evaluate(context));
+        return apply(type(), invert_expression(), lhs_value, rhs_value, escape_value);
+    }
+    case MatchOperator::Regexp: {
+        Value lhs_value = TRY(lhs()->evaluate(context));
+        Value rhs_value = TRY(rhs()->evaluate(context));
+        return apply(type(), invert_expression(), lhs_value, rhs_value, {});
+    }
+    default:
+        return apply(type(), invert_expression(), Value {}, Value {}, {});
+    }
+}
 
-        // Compile the pattern into a simple regex.
-        // https://sqlite.org/lang_expr.html#the_like_glob_regexp_and_match_operators
-        bool escaped = false;
-        AK::StringBuilder builder;
-        builder.append('^');
-        for (auto c : rhs_value.to_byte_string()) {
-            if (escape() && c == escape_char && !escaped) {
-                escaped = true;
-            } else if (s_posix_basic_metacharacters.contains(c)) {
-                escaped = false;
-                builder.append('\\');
-                builder.append(c);
-            } else if (c == '_' && !escaped) {
-                builder.append('.');
-            } else if (c == '%' && !escaped) {
-                builder.append(".*"sv);
-            } else {
-                escaped = false;
-                builder.append(c);
-            }
+ResultOr<ByteString> MatchExpression::like_pattern_to_regex(Value const& pattern, Optional<Value> const& escape)
+{
+    char escape_char = '\0';
+    if (escape.has_value()) {
+        auto escape_str = escape->to_byte_string();
+        if (escape_str.length() != 1)
+            return Result { SQLCommand::Unknown, SQLErrorCode::SyntaxError, "ESCAPE should be a single character" };
+        escape_char = escape_str[0];
+    }
+
+    // Compile the pattern into a simple regex.
+    // https://sqlite.org/lang_expr.html#the_like_glob_regexp_and_match_operators
+    bool escaped = false;
+    AK::StringBuilder builder;
+    builder.append('^');
+    for (auto c : pattern.to_byte_string()) {
+        if (escape.has_value() && c == escape_char && !escaped) {
+            escaped = true;
+        } else if (s_posix_basic_metacharacters.contains(c)) {
+            escaped = false;
+            builder.append('\\');
+            builder.append(c);
+        } else if (c == '_' && !escaped) {
+            builder.append('.');
+        } else if (c == '%' && !escaped) {
+            builder.append(".*"sv);
+        } else {
+            escaped = false;
+            builder.append(c);
         }
-        builder.append('$');
+    }
+    builder.append('$');
+    return builder.to_byte_string();
+}
 
-        // FIXME: We should probably cache this regex.
-        auto regex = Regex<PosixBasic>(builder.to_byte_string());
+ResultOr<Value> MatchExpression::apply(MatchOperator type, bool invert_expression, Value const& lhs_value, Value const& rhs_value, Optional<Value> const& escape)
+{
+    switch (type) {
+    case MatchOperator::Like: {
+        auto regex = Regex<PosixBasic>(TRY(like_pattern_to_regex(rhs_value, escape)));
         auto result = regex.match(lhs_value.to_byte_string(), PosixFlags::Insensitive | PosixFlags::Unicode);
-        return Value(invert_expression() ? !result.success : result.success);
+        return Value(invert_expression ? !result.success : result.success);
     }
     case MatchOperator::Regexp: {
-        Value lhs_value = TRY(lhs()->evaluate(context));
-        Value rhs_value = TRY(rhs()->evaluate(context));
-
         auto regex = Regex<PosixExtended>(rhs_value.to_byte_string());
         auto err = regex.parser_result.error;
         if (err != regex::Error::NoError) {
@@ -230,7 +255,7 @@ ResultOr<Value> MatchExpression::evaluate(ExecutionContext& context) const
         }
 
         auto result = regex.match(lhs_value.to_byte_string(), PosixFlags::Insensitive | PosixFlags::Unicode);
-        return Value(invert_expression() ? !result.success : result.success);
+        return Value(invert_expression ? !result.success : result.success);
     }
     case MatchOperator::Glob:
         return Result { SQLCommand::Unknown, SQLErrorCode::NotYetImplemented, "GLOB expression is not yet implemented"sv };
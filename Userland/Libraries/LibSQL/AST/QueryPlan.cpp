@@ -0,0 +1,1031 @@
+/*
+ * Copyright (c) 2021, Jan de Visser <jan@de-visser.net>
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Checked.h>
+#include <AK/NumericLimits.h>
+#include <AK/StringBuilder.h>
+#include <AK/TypeCasts.h>
+#include <LibSQL/AST/QueryPlan.h>
+#include <LibSQL/BTree.h>
+#include <LibSQL/Database.h>
+#include <LibSQL/Meta.h>
+#include <LibSQL/Row.h>
+
+namespace SQL::AST {
+
+void PlanNode::append_explain_line(Vector<ByteString>& lines, size_t depth, StringView description)
+{
+    lines.append(ByteString::formatted("{}{}", ByteString::repeated(' ', depth * 2), description));
+}
+
+ResultOr<Optional<Tuple>> SingleRowNode::next(ExecutionContext&)
+{
+    if (m_exhausted)
+        return Optional<Tuple> {};
+
+    m_exhausted = true;
+    return Tuple {};
+}
+
+void SingleRowNode::explain(Vector<ByteString>& lines, size_t depth) const
+{
+    append_explain_line(lines, depth, "SINGLE ROW"sv);
+}
+
+static ByteString qualified_table_name(TableDef const& table)
+{
+    return ByteString::formatted("{}.{}", table.parent()->name(), table.name());
+}
+
+// The indexes a table had when the plan was made. A table that has gained an index since then is
+// planned again, as the index might be the better way to read it.
+static Vector<ByteString> index_names(TableDef const& table)
+{
+    Vector<ByteString> names;
+    for (auto const& index : table.indexes())
+        names.append(index->name());
+    return names;
+}
+
+TableScanNode::TableScanNode(NonnullRefPtr<TableDef> table)
+    : m_table(move(table))
+    , m_descriptor(m_table->to_tuple_descriptor())
+    , m_index_names(index_names(m_table))
+    , m_next_block_index(m_table->block_index())
+{
+}
+
+ResultOr<Optional<Tuple>> TableScanNode::next(ExecutionContext& context)
+{
+    if (m_next_block_index == 0)
+        return Optional<Tuple> {};
+
+    auto row = TRY(context.database->select_row(*m_table, m_next_block_index));
+    m_next_block_index = row.next_block_index();
+
+    // The descriptor of a deserialized row doesn't know which table its columns belong to.
+    Tuple tuple { m_descriptor, row.block_index() };
+    for (size_t i = 0; i < row.size(); ++i)
+        tuple[i] = row[i];
+    return tuple;
+}
+
+void TableScanNode::rewind()
+{
+    m_next_block_index = m_table->block_index();
+}
+
+// Looks a table up again in another version of the database, which only helps if it still has the
+// same columns and indexes.
+static RefPtr<TableDef> find_unchanged_table(Database& database, TableDef const& table, TupleDescriptor const& descriptor, Vector<ByteString> const& names_of_indexes)
+{
+    auto current_table = database.get_table(table.parent()->name(), table.name());
+    if (current_table.is_error())
+        return nullptr;
+
+    if (*current_table.value()->to_tuple_descriptor() != descriptor || index_names(current_table.value()) != names_of_indexes)
+        return nullptr;
+    return current_table.release_value();
+}
+
+bool TableScanNode::rebind(ExecutionContext& context)
+{
+    auto table = find_unchanged_table(*context.database, m_table, m_descriptor, m_index_names);
+    if (!table)
+        return false;
+
+    m_table = table.release_nonnull();
+    return true;
+}
+
+void TableScanNode::explain(Vector<ByteString>& lines, size_t depth) const
+{
+    append_explain_line(lines, depth, ByteString::formatted("SCAN TABLE {}", qualified_table_name(m_table)));
+}
+
+IndexScanNode::IndexScanNode(NonnullRefPtr<TableDef> table, NonnullRefPtr<IndexDef> index, Vector<KeyValue> equal_values, Optional<Bound> lower_bound, Optional<Bound> upper_bound)
+    : m_table(move(table))
+    , m_index(move(index))
+    , m_descriptor(m_table->to_tuple_descriptor())
+    , m_index_names(index_names(m_table))
+    , m_equal_values(move(equal_values))
+    , m_lower_bound(move(lower_bound))
+    , m_upper_bound(move(upper_bound))
+{
+    VERIFY(m_equal_values.size() + ((m_lower_bound.has_value() || m_upper_bound.has_value()) ? 1 : 0) <= m_index->size());
+}
+
+Key IndexScanNode::make_bound_key(BTree const& tree, Optional<Bound> const& bound) const
+{
+    auto descriptor = adopt_ref(*new TupleDescriptor);
+    auto key_size = m_equal_values.size() + (bound.has_value() ? 1 : 0);
+    for (size_t i = 0; i < key_size; ++i)
+        descriptor->append((*tree.descriptor())[i]);
+
+    Key key { descriptor };
+    for (size_t i = 0; i < m_equal_values.size(); ++i)
+        key[i] = m_equal_values[i].value;
+    if (bound.has_value())
+        key[m_equal_values.size()] = bound->value.value;
+    return key;
+}
+
+void IndexScanNode::start_index_walk(Database& database)
+{
+    m_tree = database.index_tree(m_index);
+
+    auto lower_key = make_bound_key(*m_tree, m_lower_bound);
+    m_upper_key = make_bound_key(*m_tree, m_upper_bound);
+
+    auto it = lower_key.is_null() ? m_tree->begin() : m_tree->lower_bound(lower_key);
+    if (m_lower_bound.has_value() && !m_lower_bound->is_inclusive) {
+        while (!it.is_end() && (*it).compare(lower_key) == 0)
+            ++it;
+    }
+    m_iterator = it;
+}
+
+Optional<Block::Index> IndexScanNode::next_block_index()
+{
+    for (auto& it = *m_iterator; !it.is_end(); ++it) {
+        if (!m_upper_key.is_null()) {
+            auto compare = (*it).compare(m_upper_key);
+            if (compare > 0 || (compare == 0 && m_upper_bound.has_value() && !m_upper_bound->is_inclusive))
+                break;
+        }
+
+        // Indexes written before removed keys were taken out of them can still have keys without a row.
+        auto block_index = (*it).block_index();
+        if (block_index == 0)
+            continue;
+
+        ++it;
+        return block_index;
+    }
+    return {};
+}
+
+ResultOr<Optional<Tuple>> IndexScanNode::next(ExecutionContext& context)
+{
+    if (!m_iterator.has_value())
+        start_index_walk(*context.database);
+
+    auto block_index = next_block_index();
+    if (!block_index.has_value())
+        return Optional<Tuple> {};
+
+    auto row = TRY(context.database->select_row(*m_table, *block_index));
+
+    Tuple tuple { m_descriptor, row.block_index() };
+    for (size_t i = 0; i < row.size(); ++i)
+        tuple[i] = row[i];
+    return tuple;
+}
+
+void IndexScanNode::rewind()
+{
+    m_iterator.clear();
+    m_tree = nullptr;
+}
+
+bool IndexScanNode::rebind(ExecutionContext& context)
+{
+    auto table = find_unchanged_table(*context.database, m_table, m_descriptor, m_index_names);
+    if (!table)
+        return false;
+
+    auto index = table->indexes().find_if([&](auto const& index) { return index->name() == m_index->name(); });
+    VERIFY(!index.is_end());
+
+    // The new values have to be usable for looking up keys, just like the ones the plan was made for.
+    auto key_descriptor = (*index)->to_tuple_descriptor();
+    auto reevaluate = [&](KeyValue& key_value, size_t key_part) {
+        auto value = key_value.expression->evaluate(context);
+        if (value.is_error() || value.value().is_null() || value.value().type() != (*key_descriptor)[key_part].type)
+            return false;
+
+        key_value.value = value.release_value();
+        return true;
+    };
+
+    for (size_t i = 0; i < m_equal_values.size(); ++i) {
+        if (!reevaluate(m_equal_values[i], i))
+            return false;
+    }
+    if (m_lower_bound.has_value() && !reevaluate(m_lower_bound->value, m_equal_values.size()))
+        return false;
+    if (m_upper_bound.has_value() && !reevaluate(m_upper_bound->value, m_equal_values.size()))
+        return false;
+
+    m_table = table.release_nonnull();
+    m_index = *index;
+    return true;
+}
+
+void IndexScanNode::explain(Vector<ByteString>& lines, size_t depth) const
+{
+    auto const& key_parts = m_index->key_definition();
+
+    StringBuilder constraints;
+    auto append_constraint = [&](size_t key_part, StringView op) {
+        if (!constraints.is_empty())
+            constraints.append(" AND "sv);
+        constraints.appendff("{}{}?", key_parts[key_part]->name(), op);
+    };
+
+    for (size_t i = 0; i < m_equal_values.size(); ++i)
+        append_constraint(i, "="sv);
+    if (m_lower_bound.has_value())
+        append_constraint(m_equal_values.size(), m_lower_bound->is_inclusive ? ">="sv : ">"sv);
+    if (m_upper_bound.has_value())
+        append_constraint(m_equal_values.size(), m_upper_bound->is_inclusive ? "<="sv : "<"sv);
+
+    if (constraints.is_empty())
+        append_explain_line(lines, depth, ByteString::formatted("SCAN TABLE {} USING INDEX {}", qualified_table_name(m_table), m_index->name()));
+    else
+        append_explain_line(lines, depth, ByteString::formatted("SEARCH TABLE {} USING INDEX {} ({})", qualified_table_name(m_table), m_index->name(), constraints.string_view()));
+}
+
+FilterNode::FilterNode(NonnullOwnPtr<PlanNode> child, Vector<CompiledExpression> predicates, PredicatesAreConjuncts predicates_are_conjuncts)
+    : m_child(move(child))
+    , m_predicates(move(predicates))
+    , m_predicates_are_conjuncts(predicates_are_conjuncts)
+{
+}
+
+ResultOr<Optional<Tuple>> FilterNode::next(ExecutionContext& context)
+{
+    while (true) {
+        auto row = TRY(m_child->next(context));
+        if (!row.has_value())
+            return row;
+
+        context.current_row = &row.value();
+
+        bool matches = true;
+        for (auto& predicate : m_predicates) {
+            auto result = TRY(predicate.evaluate(context)).to_bool();
+            if (!result.has_value() && m_predicates_are_conjuncts == PredicatesAreConjuncts::Yes)
+                return Result { SQLCommand::Unknown, SQLErrorCode::BooleanOperatorTypeMismatch, BinaryOperator_name(BinaryOperator::And) };
+
+            if (!result.has_value() || !result.value()) {
+                matches = false;
+                break;
+            }
+        }
+
+        context.current_row = nullptr;
+        if (matches)
+            return row;
+    }
+}
+
+void FilterNode::explain(Vector<ByteString>& lines, size_t depth) const
+{
+    append_explain_line(lines, depth, ByteString::formatted("FILTER ({} {})", m_predicates.size(), m_predicates.size() == 1 ? "condition"sv : "conditions"sv));
+    m_child->explain(lines, depth + 1);
+}
+
+NestedLoopJoinNode::NestedLoopJoinNode(NonnullOwnPtr<PlanNode> outer, NonnullOwnPtr<PlanNode> inner, NonnullRefPtr<TupleDescriptor> descriptor)
+    : m_outer(move(outer))
+    , m_inner(move(inner))
+    , m_descriptor(move(descriptor))
+{
+}
+
+ResultOr<Optional<Tuple>> NestedLoopJoinNode::next(ExecutionContext& context)
+{
+    while (true) {
+        if (!m_outer_row.has_value()) {
+            m_outer_row = TRY(m_outer->next(context));
+            if (!m_outer_row.has_value())
+                return Optional<Tuple> {};
+
+            m_inner->rewind();
+        }
+
+        auto inner_row = TRY(m_inner->next(context));
+        if (!inner_row.has_value()) {
+            m_outer_row.clear();
+            continue;
+        }
+
+        Tuple row { m_descriptor };
+        auto const& outer_row = m_outer_row.value();
+        for (size_t i = 0; i < outer_row.size(); ++i)
+            row[i] = outer_row[i];
+        for (size_t i = 0; i < inner_row->size(); ++i)
+            row[outer_row.size() + i] = (*inner_row)[i];
+
+        return row;
+    }
+}
+
+void NestedLoopJoinNode::rewind()
+{
+    m_outer->rewind();
+    m_outer_row.clear();
+}
+
+void NestedLoopJoinNode::explain(Vector<ByteString>& lines, size_t depth) const
+{
+    append_explain_line(lines, depth, "NESTED LOOP JOIN"sv);
+    m_outer->explain(lines, depth + 1);
+    m_inner->explain(lines, depth + 1);
+}
+
+ProjectNode::ProjectNode(NonnullOwnPtr<PlanNode> child, Vector<CompiledExpression> expressions)
+    : m_child(move(child))
+    , m_expressions(move(expressions))
+{
+}
+
+ResultOr<Optional<Tuple>> ProjectNode::next(ExecutionContext& context)
+{
+    auto row = TRY(m_child->next(context));
+    if (!row.has_value())
+        return row;
+
+    context.current_row = &row.value();
+
+    Tuple result;
+    for (auto& expression : m_expressions)
+        result.append(TRY(expression.evaluate(context)));
+
+    context.current_row = nullptr;
+    return result;
+}
+
+void ProjectNode::explain(Vector<ByteString>& lines, size_t depth) const
+{
+    append_explain_line(lines, depth, ByteString::formatted("PROJECT ({} {})", m_expressions.size(), m_expressions.size() == 1 ? "column"sv : "columns"sv));
+    m_child->explain(lines, depth + 1);
+}
+
+SortNode::SortNode(NonnullOwnPtr<PlanNode> child, NonnullRefPtr<TupleDescriptor> sort_descriptor, Optional<size_t> limit)
+    : m_child(move(child))
+    , m_sort_descriptor(move(sort_descriptor))
+    , m_limit(limit)
+    , m_sorter(limit)
+{
+}
+
+ResultOr<Optional<Tuple>> SortNode::next(ExecutionContext& context)
+{
+    if (!m_is_sorted) {
+        auto sort_key_size = m_sort_descriptor->size();
+
+        while (true) {
+            auto row = TRY(m_child->next(context));
+            if (!row.has_value())
+                break;
+
+            VERIFY(row->size() >= sort_key_size);
+            auto row_size = row->size() - sort_key_size;
+
+            Tuple sort_key { m_sort_descriptor };
+            Tuple result;
+            for (size_t i = 0; i < row_size; ++i)
+                result.append((*row)[i]);
+            for (size_t i = 0; i < sort_key_size; ++i)
+                sort_key[i] = (*row)[row_size + i];
+
+            TRY(m_sorter.append(result, sort_key));
+        }
+
+        TRY(m_sorter.finish());
+        m_is_sorted = true;
+    }
+
+    return TRY(m_sorter.next());
+}
+
+void SortNode::rewind()
+{
+    m_child->rewind();
+    m_sorter.reset();
+    m_is_sorted = false;
+}
+
+void SortNode::explain(Vector<ByteString>& lines, size_t depth) const
+{
+    auto keys = ByteString::formatted("{} {}", m_sort_descriptor->size(), m_sort_descriptor->size() == 1 ? "key"sv : "keys"sv);
+    if (m_limit.has_value())
+        append_explain_line(lines, depth, ByteString::formatted("SORT ({}, top {})", keys, *m_limit));
+    else
+        append_explain_line(lines, depth, ByteString::formatted("SORT ({})", keys));
+    m_child->explain(lines, depth + 1);
+}
+
+LimitNode::LimitNode(NonnullOwnPtr<PlanNode> child, size_t offset, size_t limit)
+    : m_child(move(child))
+    , m_offset(offset)
+    , m_limit(limit)
+{
+}
+
+ResultOr<Optional<Tuple>> LimitNode::next(ExecutionContext& context)
+{
+    while (m_rows_skipped < m_offset) {
+        if (!TRY(m_child->next(context)).has_value())
+            return Optional<Tuple> {};
+        ++m_rows_skipped;
+    }
+
+    if (m_rows_produced >= m_limit)
+        return Optional<Tuple> {};
+
+    auto row = TRY(m_child->next(context));
+    if (row.has_value())
+        ++m_rows_produced;
+    return row;
+}
+
+void LimitNode::rewind()
+{
+    m_child->rewind();
+    m_rows_skipped = 0;
+    m_rows_produced = 0;
+}
+
+void LimitNode::explain(Vector<ByteString>& lines, size_t depth) const
+{
+    if (m_limit == NumericLimits<size_t>::max())
+        append_explain_line(lines, depth, ByteString::formatted("OFFSET {}", m_offset));
+    else if (m_offset == 0)
+        append_explain_line(lines, depth, ByteString::formatted("LIMIT {}", m_limit));
+    else
+        append_explain_line(lines, depth, ByteString::formatted("LIMIT {} OFFSET {}", m_limit, m_offset));
+    m_child->explain(lines, depth + 1);
+}
+
+static ByteString result_column_name(ResultColumn const& column, size_t column_index)
+{
+    auto fallback_column_name = [column_index]() {
+        return ByteString::formatted("Column{}", column_index);
+    };
+
+    if (auto const& alias = column.column_alias(); !alias.is_empty())
+        return alias;
+
+    if (column.select_from_expression()) {
+        if (is<ColumnNameExpression>(*column.expression())) {
+            auto const& column_name_expression = verify_cast<ColumnNameExpression>(*column.expression());
+            return column_name_expression.column_name();
+        }
+
+        // FIXME: Generate column names from other result column expressions.
+        return fallback_column_name();
+    }
+
+    VERIFY(column.select_from_table());
+
+    // FIXME: Generate column names from select-from-table result columns.
+    return fallback_column_name();
+}
+
+static void split_conjuncts(NonnullRefPtr<Expression> const& expression, Vector<NonnullRefPtr<Expression>>& conjuncts)
+{
+    if (is<BinaryOperatorExpression>(*expression)) {
+        auto const& binary_expression = verify_cast<BinaryOperatorExpression>(*expression);
+        if (binary_expression.type() == BinaryOperator::And) {
+            split_conjuncts(binary_expression.lhs(), conjuncts);
+            split_conjuncts(binary_expression.rhs(), conjuncts);
+            return;
+        }
+    }
+
+    conjuncts.append(expression);
+}
+
+// Collects the columns an expression refers to. Returns false if the expression is of a kind that
+// might refer to columns in ways we don't look into, which keeps it from being pushed down.
+static bool collect_column_references(Expression const& expression, Vector<ColumnNameExpression const*>& columns)
+{
+    if (is<NumericLiteral>(expression) || is<StringLiteral>(expression) || is<BlobLiteral>(expression) || is<BooleanLiteral>(expression) || is<NullLiteral>(expression) || is<Placeholder>(expression))
+        return true;
+
+    if (is<ColumnNameExpression>(expression)) {
+        columns.append(&static_cast<ColumnNameExpression const&>(expression));
+        return true;
+    }
+
+    if (is<ChainedExpression>(expression)) {
+        for (auto const& element : static_cast<ChainedExpression const&>(expression).expressions()) {
+            if (!collect_column_references(*element, columns))
+                return false;
+        }
+        return true;
+    }
+
+    if (is<BetweenExpression>(expression)) {
+        auto const& between = static_cast<BetweenExpression const&>(expression);
+        return collect_column_references(*between.expression(), columns)
+            && collect_column_references(*between.lhs(), columns)
+            && collect_column_references(*between.rhs(), columns);
+    }
+
+    if (is<InChainedExpression>(expression)) {
+        auto const& in_chained = static_cast<InChainedExpression const&>(expression);
+        return collect_column_references(*in_chained.expression(), columns)
+            && collect_column_references(*in_chained.expression_chain(), columns);
+    }
+
+    if (is<BinaryOperatorExpression>(expression) || is<MatchExpression>(expression) || is<IsExpression>(expression)) {
+        auto const& nested = static_cast<NestedDoubleExpression const&>(expression);
+        return collect_column_references(*nested.lhs(), columns) && collect_column_references(*nested.rhs(), columns);
+    }
+
+    if (is<UnaryOperatorExpression>(expression) || is<NullExpression>(expression) || is<CastExpression>(expression) || is<CollateExpression>(expression))
+        return collect_column_references(*static_cast<NestedExpression const&>(expression).expression(), columns);
+
+    return false;
+}
+
+// A conjunct of the form `column op value` or `value op column`, where the value doesn't depend on
+// the row and has been evaluated up front. These are what an index can look up.
+struct IndexablePredicate {
+    size_t column_index { 0 };
+    BinaryOperator op { BinaryOperator::Equals };
+    IndexScanNode::KeyValue value;
+};
+
+static Optional<BinaryOperator> comparison_with_swapped_operands(BinaryOperator op)
+{
+    switch (op) {
+    case BinaryOperator::Equals:
+        return BinaryOperator::Equals;
+    case BinaryOperator::LessThan:
+        return BinaryOperator::GreaterThan;
+    case BinaryOperator::LessThanEquals:
+        return BinaryOperator::GreaterThanEquals;
+    case BinaryOperator::GreaterThan:
+        return BinaryOperator::LessThan;
+    case BinaryOperator::GreaterThanEquals:
+        return BinaryOperator::LessThanEquals;
+    default:
+        return {};
+    }
+}
+
+// The planner has no statistics, so it estimates like System R did: an equality predicate selects
+// a tenth of the rows, a range predicate a third of them, and a range bounded on both sides a
+// quarter. Costs are relative to following a table's chain of rows, per row of the table; going
+// through an index reads an index entry on top of each row, and sorting costs about as much again
+// as reading the rows.
+static constexpr double equality_selectivity = 0.1;
+static constexpr double one_sided_range_selectivity = 1.0 / 3;
+static constexpr double two_sided_range_selectivity = 0.25;
+static constexpr double table_scan_row_cost = 1.0;
+static constexpr double index_scan_row_cost = 1.5;
+static constexpr double sort_row_cost = 1.0;
+
+struct IndexAccessPath {
+    NonnullRefPtr<IndexDef> index;
+    Vector<IndexScanNode::KeyValue> equal_values {};
+    Optional<IndexScanNode::Bound> lower_bound {};
+    Optional<IndexScanNode::Bound> upper_bound {};
+    bool provides_order { false };
+    double cost { 0 };
+};
+
+// Works out how an index would be used to read a table, given the indexable predicates on it and
+// the columns the rows should be ordered by (if all of them are columns of this table).
+static Optional<IndexAccessPath> plan_index_access(TableDef const& table, NonnullRefPtr<IndexDef> index, Vector<IndexablePredicate> const& predicates, Optional<Vector<size_t>> const& order_columns, bool needs_sort)
+{
+    Vector<size_t> key_part_columns;
+    for (auto const& key_part : index->key_definition()) {
+        auto column = table.columns().find_first_index_if([&](auto const& column) { return column->name() == key_part->name(); });
+        if (!column.has_value())
+            return {};
+        key_part_columns.append(*column);
+    }
+
+    IndexAccessPath path { .index = index };
+    double selectivity = 1.0;
+
+    for (auto column : key_part_columns) {
+        auto predicate = predicates.find_if([&](auto const& predicate) { return predicate.column_index == column && predicate.op == BinaryOperator::Equals; });
+        if (predicate.is_end())
+            break;
+        path.equal_values.append(predicate->value);
+        selectivity *= equality_selectivity;
+    }
+
+    if (path.equal_values.size() < key_part_columns.size()) {
+        auto column = key_part_columns[path.equal_values.size()];
+        for (auto const& predicate : predicates) {
+            if (predicate.column_index != column)
+                continue;
+
+            if (!path.lower_bound.has_value() && (predicate.op == BinaryOperator::GreaterThan || predicate.op == BinaryOperator::GreaterThanEquals))
+                path.lower_bound = IndexScanNode::Bound { predicate.value, predicate.op == BinaryOperator::GreaterThanEquals };
+            else if (!path.upper_bound.has_value() && (predicate.op == BinaryOperator::LessThan || predicate.op == BinaryOperator::LessThanEquals))
+                path.upper_bound = IndexScanNode::Bound { predicate.value, predicate.op == BinaryOperator::LessThanEquals };
+        }
+
+        if (path.lower_bound.has_value() && path.upper_bound.has_value())
+            selectivity *= two_sided_range_selectivity;
+        else if (path.lower_bound.has_value() || path.upper_bound.has_value())
+            selectivity *= one_sided_range_selectivity;
+    }
+
+    // Key parts that are looked up by equality are the same for all entries, so the ORDER BY
+    // columns may skip over them.
+    if (order_columns.has_value()) {
+        size_t key_part = 0;
+        path.provides_order = true;
+
+        for (auto column : *order_columns) {
+            while (key_part < path.equal_values.size() && key_part_columns[key_part] != column)
+                ++key_part;
+            if (key_part >= key_part_columns.size() || key_part_columns[key_part] != column) {
+                path.provides_order = false;
+                break;
+            }
+            ++key_part;
+        }
+    }
+
+    if (selectivity == 1.0 && !path.provides_order)
+        return {};
+
+    path.cost = selectivity * index_scan_row_cost;
+    if (needs_sort && !path.provides_order)
+        path.cost += selectivity * sort_row_cost;
+    return path;
+}
+
+QueryPlan::QueryPlan(Select const& statement, NonnullRefPtr<Database> database, Vector<Value> placeholder_values)
+    : m_statement(statement)
+    , m_placeholder_values(move(placeholder_values))
+    , m_context { move(database), &statement, m_placeholder_values.span(), nullptr }
+{
+}
+
+ResultOr<NonnullOwnPtr<QueryPlan>> QueryPlan::create(Select const& statement, NonnullRefPtr<Database> database, Vector<Value> placeholder_values)
+{
+    auto plan = TRY(adopt_nonnull_own_or_enomem(new (nothrow) QueryPlan(statement, move(database), move(placeholder_values))));
+    TRY(plan->build());
+    return plan;
+}
+
+ResultOr<void> QueryPlan::build()
+{
+    auto& statement = *m_statement;
+    auto& database = *m_context.database;
+
+    Vector<NonnullRefPtr<Expression>> expressions;
+
+    auto const& result_column_list = statement.result_column_list();
+    VERIFY(!result_column_list.is_empty());
+    bool select_star = result_column_list.size() == 1 && result_column_list[0]->type() == ResultType::All;
+
+    // Tables without columns don't take part in the cross join.
+    Vector<NonnullRefPtr<TableDef>> tables;
+
+    for (auto& table_descriptor : statement.table_or_subquery_list()) {
+        if (!table_descriptor->is_table())
+            return Result { SQLCommand::Select, SQLErrorCode::NotYetImplemented, "Sub-selects are not yet implemented"sv };
+
+        auto table_def = TRY(database.get_table(table_descriptor->schema_name(), table_descriptor->table_name()));
+
+        if (select_star) {
+            TRY(expressions.try_ensure_capacity(expressions.size() + table_def->columns().size()));
+            TRY(m_column_names.try_ensure_capacity(m_column_names.size() + table_def->columns().size()));
+
+            for (auto& col : table_def->columns()) {
+                expressions.unchecked_append(create_ast_node<ColumnNameExpression>(table_def->parent()->name(), table_def->name(), col->name()));
+                m_column_names.unchecked_append(col->name());
+            }
+        }
+
+        if (table_def->num_columns() != 0)
+            TRY(tables.try_append(move(table_def)));
+    }
+
+    if (!select_star) {
+        TRY(expressions.try_ensure_capacity(result_column_list.size()));
+        TRY(m_column_names.try_ensure_capacity(result_column_list.size()));
+
+        for (size_t i = 0; i < result_column_list.size(); ++i) {
+            auto const& col = result_column_list[i];
+
+            if (col->type() == ResultType::All) {
+                // FIXME can have '*' for example in conjunction with computed columns
+                return Result { SQLCommand::Select, SQLErrorCode::SyntaxError, "*"sv };
+            }
+
+            expressions.unchecked_append(*col->expression());
+            m_column_names.unchecked_append(result_column_name(col, i));
+        }
+    }
+
+    // The descriptor of a row of the full cross join, and the index of the table each of its
+    // columns comes from.
+    auto descriptor = adopt_ref(*new TupleDescriptor);
+    Vector<size_t> table_of_column;
+    Vector<size_t> first_column_of_table;
+    for (size_t table_index = 0; table_index < tables.size(); ++table_index) {
+        auto table_descriptor = tables[table_index]->to_tuple_descriptor();
+        first_column_of_table.append(descriptor->size());
+        descriptor->extend(table_descriptor);
+        for (size_t i = 0; i < table_descriptor->size(); ++i)
+            table_of_column.append(table_index);
+    }
+
+    // Finds the column a column name refers to, unless it's ambiguous or doesn't exist.
+    auto resolve_column = [&](ColumnNameExpression const& column) -> Optional<size_t> {
+        Optional<size_t> index_in_row;
+        for (size_t i = 0; i < descriptor->size(); ++i) {
+            auto const& column_descriptor = (*descriptor)[i];
+            if (!column.table_name().is_empty() && column_descriptor.table != column.table_name())
+                continue;
+            if (column_descriptor.name != column.column_name())
+                continue;
+            if (index_in_row.has_value())
+                return {};
+            index_in_row = i;
+        }
+        return index_in_row;
+    };
+
+    // Each conjunct of the WHERE clause is evaluated as soon as all tables it refers to have been
+    // joined; conjuncts that only refer to a single table are evaluated while scanning that table.
+    // Anything we can't analyze (including column names that don't resolve to exactly one column)
+    // is evaluated against the full row, which reports errors just like before.
+    Vector<Vector<NonnullRefPtr<Expression>>> scan_predicates;
+    Vector<Vector<NonnullRefPtr<Expression>>> join_predicates;
+    TRY(scan_predicates.try_resize(max<size_t>(tables.size(), 1)));
+    TRY(join_predicates.try_resize(max<size_t>(tables.size(), 1)));
+    auto predicates_are_conjuncts = FilterNode::PredicatesAreConjuncts::No;
+
+    if (auto const& where_clause = statement.where_clause()) {
+        Vector<NonnullRefPtr<Expression>> conjuncts;
+        split_conjuncts(*where_clause, conjuncts);
+        if (conjuncts.size() > 1)
+            predicates_are_conjuncts = FilterNode::PredicatesAreConjuncts::Yes;
+
+        auto last_join = join_predicates.size() - 1;
+
+        for (auto& conjunct : conjuncts) {
+            Vector<ColumnNameExpression const*> columns;
+            if (!collect_column_references(*conjunct, columns)) {
+                join_predicates[last_join].append(move(conjunct));
+                continue;
+            }
+
+            Optional<size_t> first_table;
+            Optional<size_t> last_table;
+            bool resolved = true;
+
+            for (auto const* column : columns) {
+                auto index_in_row = resolve_column(*column);
+                if (!index_in_row.has_value()) {
+                    resolved = false;
+                    break;
+                }
+
+                auto table_index = table_of_column[*index_in_row];
+                first_table = min(first_table.value_or(table_index), table_index);
+                last_table = max(last_table.value_or(table_index), table_index);
+            }
+
+            if (!resolved)
+                join_predicates[last_join].append(move(conjunct));
+            else if (!last_table.has_value())
+                scan_predicates[0].append(move(conjunct));
+            else if (first_table == last_table)
+                scan_predicates[*last_table].append(move(conjunct));
+            else
+                join_predicates[*last_table].append(move(conjunct));
+        }
+    }
+
+    // The ORDER BY clause can be satisfied by reading the outermost table in index order if it only
+    // sorts by columns of that table, in ascending order.
+    auto const& ordering_term_list = statement.ordering_term_list();
+    Optional<Vector<size_t>> order_columns;
+    if (!tables.is_empty() && !ordering_term_list.is_empty()) {
+        order_columns = Vector<size_t> {};
+        for (auto const& term : ordering_term_list) {
+            Optional<size_t> index_in_row;
+            if (term->order() == Order::Ascending && is<ColumnNameExpression>(*term->expression()))
+                index_in_row = resolve_column(static_cast<ColumnNameExpression const&>(*term->expression()));
+
+            if (!index_in_row.has_value() || table_of_column[*index_in_row] != 0) {
+                order_columns.clear();
+                break;
+            }
+            order_columns->append(*index_in_row);
+        }
+    }
+
+    auto find_indexable_predicates = [&](size_t table_index) {
+        Vector<IndexablePredicate> indexable_predicates;
+
+        for (auto const& conjunct : scan_predicates[table_index]) {
+            Expression const* expression = conjunct.ptr();
+            while (is<ChainedExpression>(*expression) && static_cast<ChainedExpression const&>(*expression).expressions().size() == 1)
+                expression = static_cast<ChainedExpression const&>(*expression).expressions().first().ptr();
+            if (!is<BinaryOperatorExpression>(*expression))
+                continue;
+
+            auto const& comparison = static_cast<BinaryOperatorExpression const&>(*expression);
+            Optional<BinaryOperator> op = comparison.type();
+            Expression const* column_expression = comparison.lhs().ptr();
+            Expression const* value_expression = comparison.rhs().ptr();
+            if (!is<ColumnNameExpression>(*column_expression)) {
+                swap(column_expression, value_expression);
+                op = comparison_with_swapped_operands(*op);
+            }
+            if (!op.has_value() || !comparison_with_swapped_operands(*op).has_value() || !is<ColumnNameExpression>(*column_expression))
+                continue;
+
+            Vector<ColumnNameExpression const*> value_columns;
+            if (!collect_column_references(*value_expression, value_columns) || !value_columns.is_empty())
+                continue;
+
+            auto index_in_row = resolve_column(static_cast<ColumnNameExpression const&>(*column_expression));
+            if (!index_in_row.has_value() || table_of_column[*index_in_row] != table_index)
+                continue;
+
+            // Errors are left for the filter to report when it evaluates the conjunct.
+            auto value = value_expression->evaluate(m_context);
+            auto column_index = *index_in_row - first_column_of_table[table_index];
+            if (value.is_error() || value.value().is_null() || value.value().type() != tables[table_index]->columns()[column_index]->type())
+                continue;
+
+            indexable_predicates.append({ column_index, *op, { value.release_value(), *value_expression } });
+        }
+
+        return indexable_predicates;
+    };
+
+    // Reads a table through the cheapest of its indexes, if any is cheaper than following the chain
+    // of rows. The conjuncts are still evaluated on the rows the index produces.
+    bool is_sorted_by_index = false;
+    auto create_scan = [&](size_t table_index) -> ErrorOr<NonnullOwnPtr<PlanNode>> {
+        auto& table = tables[table_index];
+        auto needs_sort = table_index == 0 && !ordering_term_list.is_empty();
+        auto table_order_columns = table_index == 0 ? order_columns : Optional<Vector<size_t>> {};
+
+        Optional<IndexAccessPath> best_path;
+        if (!table->indexes().is_empty()) {
+            auto indexable_predicates = find_indexable_predicates(table_index);
+            auto best_cost = table_scan_row_cost + (needs_sort ? sort_row_cost : 0);
+
+            for (auto const& index : table->indexes()) {
+                auto path = plan_index_access(table, index, indexable_predicates, table_order_columns, needs_sort);
+                if (path.has_value() && path->cost < best_cost) {
+                    best_cost = path->cost;
+                    best_path = path.release_value();
+                }
+            }
+        }
+
+        if (!best_path.has_value())
+            return adopt_nonnull_own_or_enomem<PlanNode>(new (nothrow) TableScanNode(table));
+
+        if (table_index == 0)
+            is_sorted_by_index = best_path->provides_order;
+        return adopt_nonnull_own_or_enomem<PlanNode>(new (nothrow) IndexScanNode(table, best_path->index, move(best_path->equal_values), move(best_path->lower_bound), move(best_path->upper_bound)));
+    };
+
+    // Expressions are compiled against the rows of the node they're evaluated on.
+    auto compile_expressions = [](Vector<NonnullRefPtr<Expression>> const& expressions, TupleDescriptor const& row_descriptor) -> ErrorOr<Vector<CompiledExpression>> {
+        Vector<CompiledExpression> compiled_expressions;
+        TRY(compiled_expressions.try_ensure_capacity(expressions.size()));
+        for (auto const& expression : expressions)
+            compiled_expressions.unchecked_append(TRY(CompiledExpression::compile(*expression, row_descriptor)));
+        return compiled_expressions;
+    };
+
+    auto add_filter = [&](NonnullOwnPtr<PlanNode> node, Vector<NonnullRefPtr<Expression>> const& predicates, TupleDescriptor const& row_descriptor) -> ErrorOr<NonnullOwnPtr<PlanNode>> {
+        if (predicates.is_empty())
+            return node;
+        return TRY(adopt_nonnull_own_or_enomem<PlanNode>(new (nothrow) FilterNode(move(node), TRY(compile_expressions(predicates, row_descriptor)), predicates_are_conjuncts)));
+    };
+
+    OwnPtr<PlanNode> root;
+    auto row_descriptor = adopt_ref(*new TupleDescriptor);
+
+    if (tables.is_empty()) {
+        root = TRY(adopt_nonnull_own_or_enomem<PlanNode>(new (nothrow) SingleRowNode));
+        root = TRY(add_filter(root.release_nonnull(), scan_predicates[0], row_descriptor));
+        root = TRY(add_filter(root.release_nonnull(), join_predicates[0], row_descriptor));
+    }
+
+    for (size_t table_index = 0; table_index < tables.size(); ++table_index) {
+        auto scan = TRY(create_scan(table_index));
+        scan = TRY(add_filter(move(scan), scan_predicates[table_index], tables[table_index]->to_tuple_descriptor()));
+
+        // Rows joined so far only have the columns of the tables up to and including this one.
+        auto joined_descriptor = adopt_ref(*new TupleDescriptor);
+        for (size_t i = 0; i <= table_index; ++i)
+            joined_descriptor->extend(tables[i]->to_tuple_descriptor());
+
+        if (root)
+            root = TRY(adopt_nonnull_own_or_enomem<PlanNode>(new (nothrow) NestedLoopJoinNode(root.release_nonnull(), move(scan), joined_descriptor)));
+        else
+            root = move(scan);
+
+        root = TRY(add_filter(root.release_nonnull(), join_predicates[table_index], joined_descriptor));
+        row_descriptor = move(joined_descriptor);
+    }
+
+    auto sort_descriptor = adopt_ref(*new TupleDescriptor);
+    if (!is_sorted_by_index) {
+        for (auto const& term : ordering_term_list) {
+            sort_descriptor->append(TupleElementDescriptor { .order = term->order() });
+            TRY(expressions.try_append(term->expression()));
+        }
+    }
+
+    root = TRY(adopt_nonnull_own_or_enomem<PlanNode>(new (nothrow) ProjectNode(root.release_nonnull(), TRY(compile_expressions(expressions, row_descriptor)))));
+
+    TRY(evaluate_limit_clause());
+
+    if (!sort_descriptor->is_empty()) {
+        // Only the rows that make it past the OFFSET and LIMIT have to be kept around while sorting.
+        Optional<size_t> sort_limit;
+        if (m_limit.has_value() && !Checked<size_t>::addition_would_overflow(*m_limit, m_offset))
+            sort_limit = *m_limit + m_offset;
+
+        root = TRY(adopt_nonnull_own_or_enomem<PlanNode>(new (nothrow) SortNode(root.release_nonnull(), move(sort_descriptor), sort_limit)));
+    }
+
+    if (statement.limit_clause())
+        root = TRY(adopt_nonnull_own_or_enomem<PlanNode>(new (nothrow) LimitNode(root.release_nonnull(), m_offset, m_limit.value_or(NumericLimits<size_t>::max()))));
+
+    m_root = move(root);
+    return {};
+}
+
+ResultOr<void> QueryPlan::evaluate_limit_clause()
+{
+    m_limit.clear();
+    m_offset = 0;
+
+    auto const& limit_clause = m_statement->limit_clause();
+    if (!limit_clause)
+        return {};
+
+    auto limit = TRY(limit_clause->limit_expression()->evaluate(m_context));
+    if (!limit.is_null()) {
+        auto limit_value_maybe = limit.to_int<size_t>();
+        if (!limit_value_maybe.has_value())
+            return Result { SQLCommand::Select, SQLErrorCode::SyntaxError, "LIMIT clause must evaluate to an integer value"sv };
+
+        m_limit = limit_value_maybe.value();
+    }
+
+    if (limit_clause->offset_expression() != nullptr) {
+        auto offset = TRY(limit_clause->offset_expression()->evaluate(m_context));
+        if (!offset.is_null()) {
+            auto offset_value_maybe = offset.to_int<size_t>();
+            if (!offset_value_maybe.has_value())
+                return Result { SQLCommand::Select, SQLErrorCode::SyntaxError, "OFFSET clause must evaluate to an integer value"sv };
+
+            m_offset = offset_value_maybe.value();
+        }
+    }
+
+    return {};
+}
+
+bool QueryPlan::rebind(NonnullRefPtr<Database> database, Vector<Value> placeholder_values)
+{
+    m_placeholder_values = move(placeholder_values);
+    m_context = { move(database), m_statement.ptr(), m_placeholder_values.span(), nullptr };
+
+    // The LIMIT and OFFSET are built into the plan, so they have to come out the same as before.
+    auto limit = m_limit;
+    auto offset = m_offset;
+    if (evaluate_limit_clause().is_error() || m_limit != limit || m_offset != offset)
+        return false;
+
+    if (!m_root->rebind(m_context))
+        return false;
+
+    m_root->rewind();
+    return true;
+}
+
+ResultOr<Optional<Tuple>> QueryPlan::next()
+{
+    return m_root->next(m_context);
+}
+
+Vector<ByteString> QueryPlan::explain() const
+{
+    Vector<ByteString> lines;
+    m_root->explain(lines, 0);
+    return lines;
+}
+
+}
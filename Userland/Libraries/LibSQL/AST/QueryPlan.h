@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/ByteString.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/Optional.h>
+#include <AK/Vector.h>
+#include <LibSQL/AST/AST.h>
+#include <LibSQL/AST/CompiledExpression.h>
+#include <LibSQL/BTree.h>
+#include <LibSQL/Forward.h>
+#include <LibSQL/Heap.h>
+#include <LibSQL/Key.h>
+#include <LibSQL/Result.h>
+#include <LibSQL/ResultSet.h>
+#include <LibSQL/RowSorter.h>
+#include <LibSQL/Tuple.h>
+#include <LibSQL/Value.h>
+
+namespace SQL::AST {
+
+// A SELECT statement is executed by a tree of PlanNodes. Rows are pulled from the root one at a
+// time, and every node pulls from its children only as far as it needs to; nothing but a sort
+// holds on to more than the row it's currently working on.
+class PlanNode {
+public:
+    virtual ~PlanNode() = default;
+
+    // Produces the next row, or an empty Optional once the node is exhausted.
+    virtual ResultOr<Optional<Tuple>> next(ExecutionContext&) = 0;
+
+    // Starts producing rows from the beginning again. Used for the inner side of joins.
+    virtual void rewind() = 0;
+
+    // Points the node at the tables of the context's database and re-evaluates what it derived from
+    // the placeholder values, before the plan is executed again. Returns false if the node can't be
+    // reused that way.
+    virtual bool rebind(ExecutionContext&) = 0;
+
+    // Describes the node, followed by its children indented one level deeper. Used by EXPLAIN.
+    virtual void explain(Vector<ByteString>& lines, size_t depth) const = 0;
+
+protected:
+    PlanNode() = default;
+
+    static void append_explain_line(Vector<ByteString>& lines, size_t depth, StringView description);
+};
+
+// Produces a single row without columns, for a SELECT without a FROM clause.
+class SingleRowNode final : public PlanNode {
+public:
+    virtual ResultOr<Optional<Tuple>> next(ExecutionContext&) override;
+    virtual void rewind() override { m_exhausted = false; }
+    virtual bool rebind(ExecutionContext&) override { return true; }
+    virtual void explain(Vector<ByteString>&, size_t depth) const override;
+
+private:
+    bool m_exhausted { false };
+};
+
+// Follows the chain of rows of a table, reading one row block per call.
+class TableScanNode final : public PlanNode {
+public:
+    explicit TableScanNode(NonnullRefPtr<TableDef>);
+
+    virtual ResultOr<Optional<Tuple>> next(ExecutionContext&) override;
+    virtual void rewind() override;
+    virtual bool rebind(ExecutionContext&) override;
+    virtual void explain(Vector<ByteString>&, size_t depth) const override;
+
+private:
+    NonnullRefPtr<TableDef> m_table;
+    NonnullRefPtr<TupleDescriptor> m_descriptor;
+    Vector<ByteString> m_index_names;
+    Block::Index m_next_block_index { 0 };
+};
+
+// Reads the rows of a table in the order of one of its indexes, restricted to the index entries
+// whose leading key parts are equal to the given values and whose next key part lies within the
+// given bounds.
+class IndexScanNode final : public PlanNode {
+public:
+    // A value to look up in the index, along with the expression it was evaluated from.
+    struct KeyValue {
+        Value value;
+        NonnullRefPtr<Expression const> expression;
+    };
+
+    struct Bound {
+        KeyValue value;
+        bool is_inclusive { true };
+    };
+
+    IndexScanNode(NonnullRefPtr<TableDef>, NonnullRefPtr<IndexDef>, Vector<KeyValue> equal_values, Optional<Bound> lower_bound, Optional<Bound> upper_bound);
+
+    virtual ResultOr<Optional<Tuple>> next(ExecutionContext&) override;
+    virtual void rewind() override;
+    virtual bool rebind(ExecutionContext&) override;
+    virtual void explain(Vector<ByteString>&, size_t depth) const override;
+
+private:
+    Key make_bound_key(BTree const&, Optional<Bound> const&) const;
+    void start_index_walk(Database&);
+    Optional<Block::Index> next_block_index();
+
+    NonnullRefPtr<TableDef> m_table;
+    NonnullRefPtr<IndexDef> m_index;
+    NonnullRefPtr<TupleDescriptor> m_descriptor;
+    Vector<ByteString> m_index_names;
+    Vector<KeyValue> m_equal_values;
+    Optional<Bound> m_lower_bound;
+    Optional<Bound> m_upper_bound;
+
+    // The index is walked as rows are pulled, so a LIMIT stops the walk as well.
+    RefPtr<BTree> m_tree;
+    Optional<BTreeIterator> m_iterator;
+    Key m_upper_key;
+};
+
+// Passes on the rows for which every predicate evaluates to true.
+class FilterNode final : public PlanNode {
+public:
+    // Conjuncts split off an AND must evaluate to a boolean, just like the operands of the AND itself.
+    enum class PredicatesAreConjuncts {
+        No,
+        Yes,
+    };
+
+    FilterNode(NonnullOwnPtr<PlanNode> child, Vector<CompiledExpression> predicates, PredicatesAreConjuncts);
+
+    virtual ResultOr<Optional<Tuple>> next(ExecutionContext&) override;
+    virtual void rewind() override { m_child->rewind(); }
+    virtual bool rebind(ExecutionContext& context) override { return m_child->rebind(context); }
+    virtual void explain(Vector<ByteString>&, size_t depth) const override;
+
+private:
+    NonnullOwnPtr<PlanNode> m_child;
+    Vector<CompiledExpression> m_predicates;
+    PredicatesAreConjuncts m_predicates_are_conjuncts { PredicatesAreConjuncts::No };
+};
+
+// Pairs every row of the outer child with every row of the inner child, rescanning the inner
+// child for each outer row.
+class NestedLoopJoinNode final : public PlanNode {
+public:
+    NestedLoopJoinNode(NonnullOwnPtr<PlanNode> outer, NonnullOwnPtr<PlanNode> inner, NonnullRefPtr<TupleDescriptor>);
+
+    virtual ResultOr<Optional<Tuple>> next(ExecutionContext&) override;
+    virtual void rewind() override;
+    virtual bool rebind(ExecutionContext& context) override { return m_outer->rebind(context) && m_inner->rebind(context); }
+    virtual void explain(Vector<ByteString>&, size_t depth) const override;
+
+private:
+    NonnullOwnPtr<PlanNode> m_outer;
+    NonnullOwnPtr<PlanNode> m_inner;
+    NonnullRefPtr<TupleDescriptor> m_descriptor;
+    Optional<Tuple> m_outer_row;
+};
+
+// Evaluates the result columns, followed by the sort key (if any), against each row.
+class ProjectNode final : public PlanNode {
+public:
+    ProjectNode(NonnullOwnPtr<PlanNode> child, Vector<CompiledExpression> expressions);
+
+    virtual ResultOr<Optional<Tuple>> next(ExecutionContext&) override;
+    virtual void rewind() override { m_child->rewind(); }
+    virtual bool rebind(ExecutionContext& context) override { return m_child->rebind(context); }
+    virtual void explain(Vector<ByteString>&, size_t depth) const override;
+
+private:
+    NonnullOwnPtr<PlanNode> m_child;
+    Vector<CompiledExpression> m_expressions;
+};
+
+// Collects all rows of its child and produces them ordered by the sort key at the end of each
+// row, with the sort key stripped off. If a limit is given, only that many rows are produced.
+class SortNode final : public PlanNode {
+public:
+    SortNode(NonnullOwnPtr<PlanNode> child, NonnullRefPtr<TupleDescriptor> sort_descriptor, Optional<size_t> limit);
+
+    virtual ResultOr<Optional<Tuple>> next(ExecutionContext&) override;
+    virtual void rewind() override;
+    virtual bool rebind(ExecutionContext& context) override { return m_child->rebind(context); }
+    virtual void explain(Vector<ByteString>&, size_t depth) const override;
+
+private:
+    NonnullOwnPtr<PlanNode> m_child;
+    NonnullRefPtr<TupleDescriptor> m_sort_descriptor;
+    Optional<size_t> m_limit;
+    RowSorter m_sorter;
+    bool m_is_sorted { false };
+};
+
+// Skips the first `offset` rows and stops pulling from its child after `limit` rows.
+class LimitNode final : public PlanNode {
+public:
+    LimitNode(NonnullOwnPtr<PlanNode> child, size_t offset, size_t limit);
+
+    virtual ResultOr<Optional<Tuple>> next(ExecutionContext&) override;
+    virtual void rewind() override;
+    virtual bool rebind(ExecutionContext& context) override { return m_child->rebind(context); }
+    virtual void explain(Vector<ByteString>&, size_t depth) const override;
+
+private:
+    NonnullOwnPtr<PlanNode> m_child;
+    size_t m_offset { 0 };
+    size_t m_limit { 0 };
+    size_t m_rows_skipped { 0 };
+    size_t m_rows_produced { 0 };
+};
+
+// The plan for one execution of a SELECT statement. It keeps the statement, the database and the
+// placeholder values alive for as long as rows are pulled from it.
+//
+// A prepared statement can hold on to its plan and rebind it for later executions, which skips
+// planning and compiling the expressions again.
+class QueryPlan {
+public:
+    static ResultOr<NonnullOwnPtr<QueryPlan>> create(Select const&, NonnullRefPtr<Database>, Vector<Value> placeholder_values);
+
+    Vector<ByteString> const& column_names() const { return m_column_names; }
+
+    // Prepares the plan to produce its rows from the beginning again, from the given database (for
+    // example a newer snapshot) and with the given placeholder values. Returns false if the tables
+    // or indexes the plan reads have changed, or if the placeholder values don't fit the plan, in
+    // which case a new plan has to be created.
+    [[nodiscard]] bool rebind(NonnullRefPtr<Database>, Vector<Value> placeholder_values);
+
+    // Produces the next result row, or an empty Optional once all rows have been produced.
+    ResultOr<Optional<Tuple>> next();
+
+    // Describes the plan one node per line, for EXPLAIN.
+    Vector<ByteString> explain() const;
+
+private:
+    QueryPlan(Select const&, NonnullRefPtr<Database>, Vector<Value> placeholder_values);
+
+    ResultOr<void> build();
+    ResultOr<void> evaluate_limit_clause();
+
+    NonnullRefPtr<Select const> m_statement;
+    Vector<Value> m_placeholder_values;
+    ExecutionContext m_context;
+    Vector<ByteString> m_column_names;
+    Optional<size_t> m_limit;
+    size_t m_offset { 0 };
+    OwnPtr<PlanNode> m_root;
+};
+
+}
@@ -4,8 +4,10 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/QuickSort.h>
 #include <LibSQL/BTree.h>
 #include <LibSQL/Meta.h>
+#include <LibSQL/Serializer.h>
 
 namespace SQL {
 
@@ -50,6 +52,10 @@ void BTree::initialize_root()
     } else {
         set_block_index(request_new_block_index());
         m_root = make<TreeNode>(*this, nullptr, block_index());
+
+        // Write the empty root right away. Otherwise its block would be a hole in the heap once
+        // later blocks are written, and the heap would try to read it when the root is first written.
+        serializer().serialize_and_write(*m_root.ptr());
         if (on_new_root)
             on_new_root();
     }
@@ -66,6 +72,14 @@ TreeNode* BTree::new_root()
     return m_root;
 }
 
+void BTree::replace_root(NonnullOwnPtr<TreeNode> root)
+{
+    set_block_index(root->block_index());
+    m_root = move(root);
+    if (on_new_root)
+        on_new_root();
+}
+
 bool BTree::insert(Key const& key)
 {
     if (!m_root)
@@ -80,6 +94,144 @@ bool BTree::update_key_pointer(Key const& key)
     return m_root->update_key_pointer(key);
 }
 
+bool BTree::remove(Key const& key)
+{
+    VERIFY(key.block_index() != 0);
+    if (!m_root)
+        initialize_root();
+    return m_root->remove(key);
+}
+
+bool BTree::is_empty()
+{
+    if (!m_root)
+        initialize_root();
+    return m_root->is_leaf() && m_root->size() == 0;
+}
+
+bool BTree::bulk_load(Vector<Key> keys, double fill_factor)
+{
+    VERIFY(fill_factor > 0 && fill_factor <= 1);
+    if (!is_empty())
+        return false;
+
+    quick_sort(keys, [](auto const& a, auto const& b) { return a < b; });
+    if (!duplicates_allowed()) {
+        for (size_t ix = 1; ix < keys.size(); ++ix) {
+            if (keys[ix - 1] == keys[ix])
+                return false;
+        }
+    }
+
+    auto max_node_size = static_cast<size_t>(serializer().heap().max_storage_size_in_page() * fill_factor);
+    Vector<Block::Index> nodes;
+    while (!keys.is_empty())
+        keys = bulk_load_level(move(keys), nodes, max_node_size);
+    return true;
+}
+
+static size_t varint_size(u64 value)
+{
+    size_t size = 1;
+    for (; value >= 0x80; value >>= 7)
+        ++size;
+    return size;
+}
+
+// Packs the keys of one level of the tree into nodes. A key sits between nodes[ix] and nodes[ix + 1]
+// of the level below, unless there is no level below and the nodes are leaves. The nodes of this
+// level take their place, and the keys that separate them are returned to make up the level above.
+Vector<Key> BTree::bulk_load_level(Vector<Key> keys, Vector<Block::Index>& nodes, size_t max_node_size)
+{
+    auto is_leaf = nodes.is_empty();
+    VERIFY(is_leaf || nodes.size() == keys.size() + 1);
+
+    struct Range {
+        size_t start { 0 };
+        size_t end { 0 };
+    };
+    Vector<Range> ranges;
+
+    // The size of a node is tallied the way TreeNode::serialize() lays it out. Its header is the
+    // number of keys, whether it's a leaf, and the rightmost down pointer, of at most 5 bytes each.
+    size_t const header_size = 5 + 1 + (is_leaf ? 0 : 5);
+    size_t start = 0;
+    size_t node_size = header_size;
+    ByteBuffer previous_key_bytes;
+
+    for (size_t ix = 0; ix < keys.size(); ++ix) {
+        Serializer key_serializer;
+        keys[ix].serialize_values(key_serializer);
+        auto key_bytes = key_serializer.bytes();
+
+        size_t shared_length = 0;
+        auto max_shared_length = min(key_bytes.size(), previous_key_bytes.size());
+        while (shared_length < max_shared_length && key_bytes[shared_length] == previous_key_bytes[shared_length])
+            ++shared_length;
+
+        auto suffix_length = key_bytes.size() - shared_length;
+        auto entry_size = varint_size(keys[ix].block_index()) + varint_size(shared_length) + varint_size(suffix_length) + suffix_length;
+        if (!is_leaf)
+            entry_size += varint_size(nodes[ix]);
+
+        // A full node ends before the key, which then separates it from the next node. Nodes get
+        // at least two keys, so that every level has less than a third of the nodes of the one below.
+        if (ix - start >= 2 && node_size + entry_size > max_node_size) {
+            ranges.append({ start, ix });
+            start = ix + 1;
+            node_size = header_size;
+            previous_key_bytes.clear();
+            continue;
+        }
+
+        node_size += entry_size;
+        previous_key_bytes = MUST(ByteBuffer::copy(key_bytes));
+    }
+
+    // If the last key ended up separating the last node from nothing, the node before it gives
+    // up its last key to become the separator instead.
+    if (start == keys.size()) {
+        auto& previous = ranges.last();
+        start = previous.end--;
+    }
+    ranges.append({ start, keys.size() });
+
+    Vector<Key> separators;
+    Vector<Block::Index> level_nodes;
+    for (size_t range_index = 0; range_index < ranges.size(); ++range_index) {
+        auto const& range = ranges[range_index];
+        if (range_index + 1 < ranges.size())
+            separators.append(keys[range.end]);
+
+        // A level of a single node has reached the top, and its node becomes the root.
+        auto is_root = ranges.size() == 1;
+        auto node = make<TreeNode>(*this, nullptr, is_root ? block_index() : request_new_block_index());
+        node->m_is_leaf = is_leaf;
+        node->m_down.clear();
+        for (auto ix = range.start; ix < range.end; ++ix) {
+            node->m_entries.append(move(keys[ix]));
+            if (is_leaf)
+                node->m_down.empend(node.ptr(), nullptr);
+            else
+                node->m_down.empend(node.ptr(), nodes[ix]);
+        }
+        if (is_leaf)
+            node->m_down.empend(node.ptr(), nullptr);
+        else
+            node->m_down.empend(node.ptr(), nodes[range.end]);
+
+        node->dump_if(SQL_DEBUG, "Bulk load to WAL");
+        serializer().serialize_and_write(*node);
+        level_nodes.append(node->block_index());
+
+        if (is_root)
+            m_root = move(node);
+    }
+
+    nodes = move(level_nodes);
+    return separators;
+}
+
 Optional<u32> BTree::get(Key& key)
 {
     if (!m_root)
@@ -103,6 +255,28 @@ BTreeIterator BTree::find(Key const& key)
     return end();
 }
 
+BTreeIterator BTree::lower_bound(Key const& key)
+{
+    if (!m_root)
+        initialize_root();
+
+    // The candidate is the smallest key not less than the given key found on the way down; a key
+    // in the subtree to its left would be smaller still.
+    auto result = end();
+    for (auto* node = m_root.ptr(); node;) {
+        size_t ix = 0;
+        while (ix < node->size() && (*node)[ix].compare(key) < 0)
+            ++ix;
+
+        if (ix < node->size())
+            result = BTreeIterator(node, (int)ix);
+        if (node->is_leaf())
+            break;
+        node = node->down_node(ix);
+    }
+    return result;
+}
+
 void BTree::list_tree()
 {
     if (!m_root)
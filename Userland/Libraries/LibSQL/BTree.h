@@ -59,7 +59,6 @@ public:
     [[nodiscard]] BTree& tree() const { return m_tree; }
     [[nodiscard]] TreeNode* up() const { return m_up; }
     [[nodiscard]] size_t size() const { return m_entries.size(); }
-    [[nodiscard]] size_t length() const;
     [[nodiscard]] Vector<Key> entries() const { return m_entries; }
     [[nodiscard]] Block::Index down_pointer(size_t) const;
     [[nodiscard]] TreeNode* down_node(size_t);
@@ -68,6 +67,7 @@ public:
     Key const& operator[](size_t index) const { return m_entries[index]; }
     bool insert(Key const&);
     bool update_key_pointer(Key const&);
+    bool remove(Key const&);
     TreeNode* node_for(Key const&);
     Optional<u32> get(Key&);
     void deserialize(Serializer&);
@@ -78,7 +78,11 @@ private:
     void dump_if(int, ByteString&& = "");
     bool insert_in_leaf(Key const&);
     void just_insert(Key const&, TreeNode* = nullptr);
+    void write_or_split();
     void split();
+    void remove_entry(size_t);
+    void remove_empty_child(Block::Index);
+    void deserialize_legacy(Serializer&);
     void list_node(int);
 
     BTree& m_tree;
@@ -93,14 +97,36 @@ private:
 
 class BTree : public Index {
 public:
+    static constexpr double DEFAULT_FILL_FACTOR = 0.9;
+
     static ErrorOr<NonnullRefPtr<BTree>> create(Serializer&, NonnullRefPtr<TupleDescriptor> const&, bool unique, Block::Index);
     static ErrorOr<NonnullRefPtr<BTree>> create(Serializer&, NonnullRefPtr<TupleDescriptor> const&, Block::Index);
 
     Block::Index root() const { return m_root ? m_root->block_index() : 0; }
     bool insert(Key const&);
     bool update_key_pointer(Key const&);
+
+    // Fills an empty tree with the given keys in one go. The keys are sorted and packed into leaves
+    // that are filled up to the given fraction of a page, and the levels above them are built the
+    // same way, bottom-up, instead of descending the tree and splitting nodes for every key. Leaving
+    // some room in the nodes keeps keys inserted later on from splitting them right away. Returns
+    // false without changing anything if the tree isn't empty, or if it doesn't allow duplicates
+    // and the keys contain some.
+    bool bulk_load(Vector<Key>, double fill_factor = DEFAULT_FILL_FACTOR);
+    bool is_empty();
+
+    // Takes the key with the same pointer out of the tree. Nodes left without keys are taken out
+    // of the tree as well, but nodes aren't merged otherwise, so they may end up sparsely filled.
+    // Trees written before keys were taken out may still contain removed keys with a null pointer.
+    bool remove(Key const&);
+
     Optional<u32> get(Key&);
     BTreeIterator find(Key const& key);
+
+    // Returns an iterator pointing to the first key that is not less than the given key. The given
+    // key may have fewer parts than the keys in the tree, in which case only those are compared.
+    BTreeIterator lower_bound(Key const& key);
+
     BTreeIterator begin();
     static BTreeIterator end();
     void list_tree();
@@ -111,6 +137,8 @@ private:
     BTree(Serializer&, NonnullRefPtr<TupleDescriptor> const&, bool unique, Block::Index);
     void initialize_root();
     TreeNode* new_root();
+    void replace_root(NonnullOwnPtr<TreeNode>);
+    Vector<Key> bulk_load_level(Vector<Key>, Vector<Block::Index>& nodes, size_t max_node_size);
     OwnPtr<TreeNode> m_root { nullptr };
 
     friend BTreeIterator;
@@ -6,6 +6,9 @@
  */
 
 #include <AK/ByteString.h>
+#include <AK/QuickSort.h>
+#include <LibCore/System.h>
+#include <LibFileSystem/FileSystem.h>
 #include <LibSQL/BTree.h>
 #include <LibSQL/Database.h>
 #include <LibSQL/Heap.h>
@@ -31,24 +34,12 @@ ResultOr<void> Database::open()
 {
     VERIFY(!m_open);
     TRY(m_heap->open());
-
-    m_schemas = TRY(BTree::create(m_serializer, SchemaDef::index_def()->to_tuple_descriptor(), m_heap->schemas_root()));
-    m_schemas->on_new_root = [&]() {
-        m_heap->set_schemas_root(m_schemas->root());
-    };
-
-    m_tables = TRY(BTree::create(m_serializer, TableDef::index_def()->to_tuple_descriptor(), m_heap->tables_root()));
-    m_tables->on_new_root = [&]() {
-        m_heap->set_tables_root(m_tables->root());
-    };
-
-    m_table_columns = TRY(BTree::create(m_serializer, ColumnDef::index_def()->to_tuple_descriptor(), m_heap->table_columns_root()));
-    m_table_columns->on_new_root = [&]() {
-        m_heap->set_table_columns_root(m_table_columns->root());
-    };
-
+    TRY(open_catalog());
     m_open = true;
 
+    if (m_heap->is_legacy())
+        TRY(migrate_legacy_heap());
+
     auto ensure_schema_exists = [&](auto schema_name) -> ResultOr<NonnullRefPtr<SchemaDef>> {
         if (auto result = get_schema(schema_name); result.is_error()) {
             if (result.error().error() != SQLErrorCode::SchemaDoesNotExist)
@@ -78,6 +69,146 @@ ResultOr<void> Database::open()
     return {};
 }
 
+ResultOr<NonnullRefPtr<Database>> Database::create_snapshot()
+{
+    VERIFY(is_open());
+    auto heap = TRY(m_heap->create_snapshot());
+    auto snapshot = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) Database(move(heap))));
+
+    TRY(snapshot->open_catalog());
+    snapshot->m_open = true;
+    return snapshot;
+}
+
+ErrorOr<void> Database::open_catalog()
+{
+    m_schemas = TRY(BTree::create(m_serializer, SchemaDef::index_def()->to_tuple_descriptor(), m_heap->schemas_root()));
+    m_schemas->on_new_root = [&]() {
+        m_heap->set_schemas_root(m_schemas->root());
+    };
+
+    m_tables = TRY(BTree::create(m_serializer, TableDef::index_def()->to_tuple_descriptor(), m_heap->tables_root()));
+    m_tables->on_new_root = [&]() {
+        m_heap->set_tables_root(m_tables->root());
+    };
+
+    m_table_columns = TRY(BTree::create(m_serializer, ColumnDef::index_def()->to_tuple_descriptor(), m_heap->table_columns_root()));
+    m_table_columns->on_new_root = [&]() {
+        m_heap->set_table_columns_root(m_table_columns->root());
+    };
+
+    m_table_indexes = TRY(BTree::create(m_serializer, IndexDef::index_def()->to_tuple_descriptor(), m_heap->table_indexes_root()));
+    m_table_indexes->on_new_root = [&]() {
+        m_heap->set_table_indexes_root(m_table_indexes->root());
+    };
+
+    return {};
+}
+
+ResultOr<void> Database::migrate_legacy_heap()
+{
+    // A legacy heap can only be read from, so its contents are copied to a new heap that then takes its place.
+    auto name = m_heap->name();
+    auto migrated_name = ByteString::formatted("{}-migrating", name);
+    dbgln_if(SQL_DEBUG, "Migrating {} from heap version {} to {}", name, m_heap->version(), Heap::VERSION);
+
+    auto remove_if_exists = [](ByteString const& path) -> ErrorOr<void> {
+        if (FileSystem::exists(path))
+            TRY(FileSystem::remove(path, FileSystem::RecursionMode::Disallowed));
+        return {};
+    };
+
+    // Anything left behind by an earlier migration that was cut short is started over.
+    TRY(remove_if_exists(migrated_name));
+    TRY(remove_if_exists(ByteString::formatted("{}-wal", migrated_name)));
+
+    {
+        auto migrated = TRY(Database::create(migrated_name));
+        TRY(migrated->open());
+        TRY(copy_to(*migrated));
+
+        // Everything has to have made it into the migrated heap's file before its write-ahead log
+        // is thrown away, rather than relying on the heap to do so when it goes away.
+        TRY(migrated->m_heap->flush());
+        TRY(migrated->m_heap->checkpoint());
+    }
+    TRY(remove_if_exists(ByteString::formatted("{}-wal", migrated_name)));
+
+    m_schemas = nullptr;
+    m_tables = nullptr;
+    m_table_columns = nullptr;
+    m_table_indexes = nullptr;
+    m_schema_cache.clear();
+    m_table_cache.clear();
+    m_index_trees.clear();
+    m_serializer = {};
+
+    m_heap = TRY(Heap::create(name));
+    TRY(Core::System::rename(migrated_name, name));
+
+    m_serializer = Serializer { m_heap };
+    TRY(m_heap->open());
+    TRY(open_catalog());
+    return {};
+}
+
+ResultOr<void> Database::copy_to(Database& target)
+{
+    HashMap<u32, ByteString> schema_names;
+    for (auto it = m_schemas->begin(); !it.is_end(); ++it) {
+        auto schema = TRY(SchemaDef::create(*it));
+        TRY(schema_names.try_set(schema->key().hash(), schema->name()));
+
+        if (auto result = target.add_schema(*schema); result.is_error() && result.error().error() != SQLErrorCode::SchemaExists)
+            return result.release_error();
+    }
+
+    Vector<Key> table_keys;
+    for (auto it = m_tables->begin(); !it.is_end(); ++it)
+        TRY(table_keys.try_append(*it));
+
+    for (auto const& table_key : table_keys) {
+        auto schema_name = schema_names.get(table_key["schema_hash"].to_int<u32>().value_or(0));
+        auto table_name = table_key["table_name"].to_byte_string();
+        if (!schema_name.has_value())
+            return Result { SQLCommand::Unknown, SQLErrorCode::SchemaDoesNotExist, table_name };
+
+        // Tables that every database has are already there.
+        if (!target.get_table(*schema_name, table_name).is_error())
+            continue;
+
+        auto table = TRY(get_table(*schema_name, table_name));
+        auto target_schema = TRY(target.get_schema(*schema_name));
+        auto new_table = TRY(TableDef::create(target_schema.ptr(), table_name));
+        for (auto const& column : table->columns())
+            new_table->append_column(column->name(), column->type());
+        TRY(target.add_table(*new_table));
+        auto target_table = TRY(target.get_table(*schema_name, table_name));
+
+        // Rows are listed from the one inserted last, so they are copied in reverse to keep their order.
+        auto rows = TRY(select_all(*table));
+        Vector<Row> target_rows;
+        TRY(target_rows.try_ensure_capacity(rows.size()));
+        for (size_t row_index = rows.size(); row_index > 0; --row_index) {
+            auto const& row = rows[row_index - 1];
+            Row target_row { target_table };
+            for (size_t column = 0; column < row.size(); ++column)
+                target_row[column] = row[column];
+            target_rows.unchecked_append(move(target_row));
+        }
+        TRY(target.bulk_insert(target_rows));
+
+        for (auto const& index : table->indexes()) {
+            auto target_index = TRY(IndexDef::create(target_table.ptr(), index->name(), index->unique()));
+            for (auto const& part : index->key_definition())
+                target_index->append_column(part->name(), part->type(), part->sort_order());
+            TRY(target.add_index(*target_table, *target_index));
+        }
+    }
+
+    return {};
+}
+
 Database::~Database() = default;
 
 ErrorOr<void> Database::commit()
@@ -172,9 +303,105 @@ ResultOr<NonnullRefPtr<TableDef>> Database::get_table(ByteString const& schema,
     for (auto it = m_table_columns->find(column_key); !it.is_end() && ((*it)["table_hash"].to_int<u32>() == table_hash); ++it)
         table_def->append_column(*it);
 
+    auto index_key = IndexDef::make_key(*table_def);
+    for (auto it = m_table_indexes->find(index_key); !it.is_end() && ((*it)["table_hash"].to_int<u32>() == table_hash); ++it) {
+        auto index_def = TRY(IndexDef::create(table_def, (*it)["index_name"].to_byte_string(), (*it)["unique"].to_int<int>() == 1, (*it).block_index()));
+
+        auto index_hash = index_def->hash();
+        auto key_part_key = ColumnDef::make_key(*index_def);
+        for (auto part_it = m_table_columns->find(key_part_key); !part_it.is_end() && ((*part_it)["table_hash"].to_int<u32>() == index_hash); ++part_it) {
+            auto column_type = (*part_it)["column_type"].to_int<UnderlyingType<SQLType>>();
+            VERIFY(column_type.has_value());
+            index_def->append_column((*part_it)["column_name"].to_byte_string(), static_cast<SQLType>(*column_type));
+        }
+
+        table_def->append_index(move(index_def));
+    }
+
     return table_def;
 }
 
+ResultOr<void> Database::add_index(TableDef& table, IndexDef& index)
+{
+    VERIFY(is_open());
+    VERIFY(m_table_cache.get(table.key().hash()).has_value());
+    VERIFY(index.parent() == &table);
+
+    for (auto const& existing_index : table.indexes()) {
+        if (existing_index->name() == index.name())
+            return Result { SQLCommand::Create, SQLErrorCode::IndexExists, index.name() };
+    }
+
+    if (!m_table_indexes->insert(index.key()))
+        return Result { SQLCommand::Create, SQLErrorCode::IndexExists, index.name() };
+
+    for (auto& part : index.key_definition()) {
+        if (!m_table_columns->insert(part->key()))
+            VERIFY_NOT_REACHED();
+    }
+
+    table.append_index(index);
+    TRY(insert_index_keys(index, TRY(select_all(table))));
+    return {};
+}
+
+NonnullRefPtr<BTree> Database::index_tree(IndexDef& index)
+{
+    VERIFY(is_open());
+
+    auto index_hash = index.hash();
+    if (auto it = m_index_trees.find(index_hash); it != m_index_trees.end())
+        return it->value;
+
+    // Removed keys stay behind in the tree, so a unique index can't rely on the tree refusing
+    // duplicate keys and has to allow them just the same.
+    auto tree = MUST(BTree::create(m_serializer, index.to_tuple_descriptor(), false, index.block_index()));
+    tree->on_new_root = [this, &index, tree_ptr = tree.ptr()]() {
+        index.set_block_index(tree_ptr->root());
+
+        auto index_key = index.key();
+        index_key.set_block_index(tree_ptr->root());
+        VERIFY(m_table_indexes->update_key_pointer(index_key));
+    };
+
+    m_index_trees.set(index_hash, tree);
+    return tree;
+}
+
+Key Database::make_index_key(IndexDef& index, Row const& row)
+{
+    Key key(index);
+    for (size_t part = 0; part < index.size(); ++part)
+        key[part] = row[index.key_definition()[part]->name()];
+
+    key.set_block_index(row.block_index());
+    return key;
+}
+
+ErrorOr<void> Database::insert_index_keys(IndexDef& index, Vector<Row> const& rows)
+{
+    Vector<Key> keys;
+    TRY(keys.try_ensure_capacity(rows.size()));
+    for (auto const& row : rows)
+        keys.unchecked_append(make_index_key(index, row));
+
+    auto tree = index_tree(index);
+    if (tree->is_empty()) {
+        if (!tree->bulk_load(move(keys)))
+            VERIFY_NOT_REACHED();
+        return {};
+    }
+
+    // Inserting the keys in order makes consecutive inserts descend to the same or the next leaf,
+    // whose nodes the tree still has loaded, instead of hopping across the whole index.
+    quick_sort(keys, [](auto const& a, auto const& b) { return a < b; });
+    for (auto const& key : keys) {
+        if (!tree->insert(key))
+            VERIFY_NOT_REACHED();
+    }
+    return {};
+}
+
 ErrorOr<Vector<Row>> Database::select_all(TableDef& table)
 {
     VERIFY(m_table_cache.get(table.key().hash()).has_value());
@@ -184,6 +411,13 @@ ErrorOr<Vector<Row>> Database::select_all(TableDef& table)
     return ret;
 }
 
+ErrorOr<Row> Database::select_row(TableDef& table, Block::Index block_index)
+{
+    VERIFY(m_table_cache.get(table.key().hash()).has_value());
+    VERIFY(block_index != 0);
+    return m_serializer.deserialize_block<Row>(block_index, table, block_index);
+}
+
 ErrorOr<Vector<Row>> Database::match(TableDef& table, Key const& key)
 {
     VERIFY(m_table_cache.get(table.key().hash()).has_value());
@@ -205,11 +439,13 @@ ErrorOr<void> Database::insert(Row& row)
     VERIFY(m_table_cache.get(row.table().key().hash()).has_value());
     // TODO: implement table constraints such as unique, foreign key, etc.
 
-    row.set_block_index(m_heap->request_new_block_index());
     row.set_next_block_index(row.table().block_index());
-    TRY(update(row));
+    row.set_block_index(TRY(m_serializer.serialize_and_insert<Tuple>(row)));
 
-    // TODO update indexes defined on table.
+    for (auto& index : row.table().indexes()) {
+        if (!index_tree(index)->insert(make_index_key(index, row)))
+            VERIFY_NOT_REACHED();
+    }
 
     auto table_key = row.table().key();
     table_key.set_block_index(row.block_index());
@@ -218,11 +454,39 @@ ErrorOr<void> Database::insert(Row& row)
     return {};
 }
 
+ErrorOr<void> Database::bulk_insert(Vector<Row>& rows)
+{
+    if (rows.is_empty())
+        return {};
+
+    auto& table = rows.first().table();
+    VERIFY(m_table_cache.get(table.key().hash()).has_value());
+
+    // Rows are chained from the one inserted last, just like when they're inserted one by one.
+    for (auto& row : rows) {
+        VERIFY(&row.table() == &table);
+        row.set_next_block_index(table.block_index());
+        row.set_block_index(TRY(m_serializer.serialize_and_insert<Tuple>(row)));
+        table.set_block_index(row.block_index());
+    }
+
+    for (auto& index : table.indexes())
+        TRY(insert_index_keys(index, rows));
+
+    auto table_key = table.key();
+    table_key.set_block_index(table.block_index());
+    VERIFY(m_tables->update_key_pointer(table_key));
+    return {};
+}
+
 ErrorOr<void> Database::remove(Row& row)
 {
     auto& table = row.table();
     VERIFY(m_table_cache.get(table.key().hash()).has_value());
 
+    for (auto& index : table.indexes())
+        index_tree(index)->remove(make_index_key(index, row));
+
     TRY(m_heap->free_storage(row.block_index()));
 
     if (table.block_index() == row.block_index()) {
@@ -239,7 +503,7 @@ ErrorOr<void> Database::remove(Row& row)
 
         if (current.next_block_index() == row.block_index()) {
             current.set_next_block_index(row.next_block_index());
-            TRY(update(current));
+            TRY(write_row(current));
             break;
         }
 
@@ -251,13 +515,35 @@ ErrorOr<void> Database::remove(Row& row)
 
 ErrorOr<void> Database::update(Row& tuple)
 {
-    VERIFY(m_table_cache.get(tuple.table().key().hash()).has_value());
+    auto& table = tuple.table();
+    VERIFY(m_table_cache.get(table.key().hash()).has_value());
     // TODO: implement table constraints such as unique, foreign key, etc.
 
-    m_serializer.reset();
-    m_serializer.serialize_and_write<Tuple>(tuple);
+    if (table.indexes().is_empty())
+        return write_row(tuple);
+
+    auto old_row = m_serializer.deserialize_block<Row>(tuple.block_index(), table, tuple.block_index());
+    TRY(write_row(tuple));
 
-    // TODO update indexes defined on table.
+    for (auto& index : table.indexes()) {
+        auto old_key = make_index_key(index, old_row);
+        auto new_key = make_index_key(index, tuple);
+        if (old_key == new_key)
+            continue;
+
+        auto tree = index_tree(index);
+        tree->remove(old_key);
+        if (!tree->insert(new_key))
+            VERIFY_NOT_REACHED();
+    }
+
+    return {};
+}
+
+ErrorOr<void> Database::write_row(Row& row)
+{
+    m_serializer.reset();
+    m_serializer.serialize_and_write<Tuple>(row);
     return {};
 }
 
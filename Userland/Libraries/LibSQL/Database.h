@@ -31,7 +31,16 @@ public:
     ResultOr<void> open();
     bool is_open() const { return m_open; }
     ErrorOr<void> commit();
+    ErrorOr<void> sync() { return m_heap->sync(); }
+    void set_group_commit(bool enabled) { m_heap->set_group_commit(enabled); }
+    bool has_unsynced_commits() const { return m_heap->has_unsynced_commits(); }
     ErrorOr<size_t> file_size_in_bytes() const { return m_heap->file_size_in_bytes(); }
+    BufferPoolStatistics buffer_pool_statistics() const { return m_heap->buffer_pool_statistics(); }
+
+    // Creates a read-only Database that keeps seeing the data committed so far. The snapshot has
+    // objects of its own, so it can be used on another thread while this Database is written to.
+    ResultOr<NonnullRefPtr<Database>> create_snapshot();
+    bool is_snapshot() const { return m_heap->is_snapshot(); }
 
     ResultOr<void> add_schema(SchemaDef const&);
     static Key get_schema_key(ByteString const&);
@@ -41,24 +50,43 @@ public:
     static Key get_table_key(ByteString const&, ByteString const&);
     ResultOr<NonnullRefPtr<TableDef>> get_table(ByteString const&, ByteString const&);
 
+    ResultOr<void> add_index(TableDef&, IndexDef&);
+    NonnullRefPtr<BTree> index_tree(IndexDef&);
+
     ErrorOr<Vector<Row>> select_all(TableDef&);
+    ErrorOr<Row> select_row(TableDef&, Block::Index);
     ErrorOr<Vector<Row>> match(TableDef&, Key const&);
     ErrorOr<void> insert(Row&);
+
+    // Inserts rows of the same table at once. Keys of indexes that are still empty are bulk loaded
+    // into their trees rather than inserted one by one; see BTree::bulk_load().
+    ErrorOr<void> bulk_insert(Vector<Row>&);
+
     ErrorOr<void> remove(Row&);
     ErrorOr<void> update(Row&);
 
 private:
     explicit Database(NonnullRefPtr<Heap>);
 
+    ErrorOr<void> open_catalog();
+    ResultOr<void> migrate_legacy_heap();
+    ResultOr<void> copy_to(Database&);
+
+    static Key make_index_key(IndexDef&, Row const&);
+    ErrorOr<void> insert_index_keys(IndexDef&, Vector<Row> const&);
+    ErrorOr<void> write_row(Row&);
+
     bool m_open { false };
     NonnullRefPtr<Heap> m_heap;
     Serializer m_serializer;
     RefPtr<BTree> m_schemas;
     RefPtr<BTree> m_tables;
     RefPtr<BTree> m_table_columns;
+    RefPtr<BTree> m_table_indexes;
 
     HashMap<u32, NonnullRefPtr<SchemaDef>> m_schema_cache;
     HashMap<u32, NonnullRefPtr<TableDef>> m_table_cache;
+    HashMap<u32, NonnullRefPtr<BTree>> m_index_trees;
 };
 
 }
@@ -46,6 +46,7 @@ class ColumnDefinition;
 class ColumnNameExpression;
 class CommonTableExpression;
 class CommonTableExpressionList;
+class CreateIndex;
 class CreateTable;
 class Delete;
 class DropColumn;
@@ -53,6 +54,7 @@ class DropTable;
 class ErrorExpression;
 class ErrorStatement;
 class ExistsExpression;
+class Explain;
 class Expression;
 class GroupByClause;
 class InChainedExpression;
@@ -72,7 +74,9 @@ class NullLiteral;
 class NumericLiteral;
 class OrderingTerm;
 class Parser;
+class PlanNode;
 class QualifiedTableName;
+class QueryPlan;
 class RenameColumn;
 class RenameTable;
 class ResultColumn;
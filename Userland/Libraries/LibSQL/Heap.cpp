@@ -9,33 +9,332 @@
 #include <AK/Format.h>
 #include <AK/QuickSort.h>
 #include <LibCore/System.h>
+#include <LibCrypto/Checksum/CRC32.h>
 #include <LibSQL/Heap.h>
 #include <sys/stat.h>
 
 namespace SQL {
 
-ErrorOr<NonnullRefPtr<Heap>> Heap::create(ByteString file_name)
+// Every block in the write-ahead log is stored in a frame: a header followed by the block's raw contents.
+struct WALFrameHeader {
+    u32 magic;
+    u32 index;
+    u32 flags;
+    u32 checksum;
+};
+static_assert(sizeof(WALFrameHeader) == 16);
+
+static constexpr u32 WAL_FRAME_MAGIC = 0x574c5153; // "SQLW"
+static constexpr u32 WAL_FRAME_FLAG_COMMIT = 1 << 0;
+
+enum class PageType : u8 {
+    Free = 0,
+    Slotted = 1,
+    Overflow = 2,
+};
+
+// Shared pages are the ones insert_storage() packs storage into.
+static constexpr u8 PAGE_FLAG_SHARED = 1 << 0;
+
+struct SlottedPageHeader {
+    PageType type;
+    u8 flags;
+    u16 slot_count;
+    u16 records_start;
+    u16 unused;
+};
+static_assert(sizeof(SlottedPageHeader) == 8);
+
+// A slot with offset 0 is free. The length of a record that overflows has SLOT_FLAG_OVERFLOW set.
+struct Slot {
+    u16 offset;
+    u16 length;
+};
+static_assert(sizeof(Slot) == 4);
+
+static constexpr u16 SLOT_FLAG_OVERFLOW = 0x8000;
+
+// A record that overflows starts with this header, followed by the part of its data kept in the slotted page.
+struct OverflowRecordHeader {
+    u32 size_in_bytes;
+    u32 first_overflow_page;
+};
+static_assert(sizeof(OverflowRecordHeader) == 8);
+
+struct OverflowPageHeader {
+    PageType type;
+    u8 unused;
+    u16 size_in_bytes;
+    u32 next_page;
+};
+static_assert(sizeof(OverflowPageHeader) == 8);
+
+// Records in shared pages larger than this are given a page of their own instead.
+static constexpr size_t MAX_SHARED_STORAGE_SIZE_DIVISOR = 4;
+
+// Shared pages with less room than this are not worth trying to pack more storage into.
+static constexpr size_t MIN_SHARED_PAGE_FREE_SPACE = 64;
+
+namespace {
+
+// Accessors for the header and slots of a slotted page.
+class ReadonlySlottedPage {
+public:
+    explicit ReadonlySlottedPage(ReadonlyBytes page)
+        : m_bytes(page)
+    {
+    }
+
+    SlottedPageHeader header() const
+    {
+        SlottedPageHeader header;
+        memcpy(&header, m_bytes.data(), sizeof(header));
+        return header;
+    }
+
+    bool is_shared() const { return (header().flags & PAGE_FLAG_SHARED) != 0; }
+    u16 slot_count() const { return header().slot_count; }
+
+    Slot slot(u16 index) const
+    {
+        Slot slot;
+        memcpy(&slot, m_bytes.offset_pointer(slot_offset(index)), sizeof(slot));
+        return slot;
+    }
+
+    bool is_in_use(u16 index) const { return index < slot_count() && slot(index).offset != 0; }
+
+    static u16 record_length(Slot slot) { return slot.length & ~SLOT_FLAG_OVERFLOW; }
+    static bool is_overflow(Slot slot) { return (slot.length & SLOT_FLAG_OVERFLOW) != 0; }
+
+    // Every record takes up at least enough room to be turned into an overflow record in place.
+    static size_t allocated_length(size_t length) { return max(length, sizeof(OverflowRecordHeader)); }
+
+    ReadonlyBytes record(u16 index) const
+    {
+        auto record_slot = slot(index);
+        return m_bytes.slice(record_slot.offset, record_length(record_slot));
+    }
+
+    size_t free_space() const
+    {
+        auto used = sizeof(SlottedPageHeader) + slot_count() * sizeof(Slot);
+        for (u16 index = 0; index < slot_count(); ++index) {
+            if (is_in_use(index))
+                used += allocated_length(record_length(slot(index)));
+        }
+        return m_bytes.size() - used;
+    }
+
+    // The room a record of the given slot can take up, including the room it already occupies.
+    size_t room_for(u16 index) const
+    {
+        auto room = free_space();
+        if (is_in_use(index))
+            room += allocated_length(record_length(slot(index)));
+        else if (index >= slot_count())
+            room -= min(room, sizeof(Slot));
+        return room;
+    }
+
+    Optional<u16> free_slot() const
+    {
+        for (u16 index = 0; index < slot_count(); ++index) {
+            if (!is_in_use(index))
+                return index;
+        }
+        if (slot_count() < Block::MAX_SLOTS)
+            return slot_count();
+        return {};
+    }
+
+protected:
+    static size_t slot_offset(u16 index) { return sizeof(SlottedPageHeader) + index * sizeof(Slot); }
+
+    size_t contiguous_free_space() const { return header().records_start - slot_offset(slot_count()); }
+
+    ReadonlyBytes m_bytes;
+};
+
+// The logic to allocate space for the records of a slotted page that is being modified.
+class SlottedPage : public ReadonlySlottedPage {
+public:
+    explicit SlottedPage(ByteBuffer& page)
+        : ReadonlySlottedPage(page.bytes())
+        , m_page(page)
+    {
+    }
+
+    static void initialize(ByteBuffer& page, u8 flags)
+    {
+        page.bytes().fill(0);
+        SlottedPage slotted_page { page };
+        slotted_page.set_header({ PageType::Slotted, flags, 0, static_cast<u16>(page.size()), 0 });
+    }
+
+    void set_header(SlottedPageHeader const& header) { m_page.overwrite(0, &header, sizeof(header)); }
+    void set_slot(u16 index, Slot slot) { m_page.overwrite(slot_offset(index), &slot, sizeof(slot)); }
+
+    void store(u16 index, u16 length, ReadonlyBytes data)
+    {
+        VERIFY(data.size() == record_length({ 0, length }));
+        auto allocated = allocated_length(data.size());
+
+        if (is_in_use(index) && allocated_length(record_length(slot(index))) >= allocated) {
+            auto offset = slot(index).offset;
+            m_page.overwrite(offset, data.data(), data.size());
+            set_slot(index, { offset, length });
+            return;
+        }
+
+        if (index >= slot_count()) {
+            VERIFY(index == slot_count());
+            auto new_header = header();
+            ++new_header.slot_count;
+            set_header(new_header);
+        }
+        set_slot(index, { 0, 0 });
+
+        if (contiguous_free_space() < allocated)
+            compact();
+        VERIFY(contiguous_free_space() >= allocated);
+
+        auto new_header = header();
+        new_header.records_start -= allocated;
+        set_header(new_header);
+        m_page.overwrite(new_header.records_start, data.data(), data.size());
+        set_slot(index, { new_header.records_start, length });
+    }
+
+    void remove(u16 index)
+    {
+        VERIFY(is_in_use(index));
+        set_slot(index, { 0, 0 });
+
+        auto new_header = header();
+        while (new_header.slot_count > 0 && slot(new_header.slot_count - 1).offset == 0)
+            --new_header.slot_count;
+        if (new_header.slot_count == 0)
+            new_header.records_start = m_page.size();
+        set_header(new_header);
+    }
+
+private:
+    // Moves all records to the end of the page, so that the room left by removed or shrunk records can be used again.
+    void compact()
+    {
+        auto original = MUST(ByteBuffer::copy(m_page));
+
+        auto new_header = header();
+        new_header.records_start = m_page.size();
+        for (u16 index = 0; index < slot_count(); ++index) {
+            if (!is_in_use(index))
+                continue;
+            auto record_slot = slot(index);
+            auto allocated = allocated_length(record_length(record_slot));
+            new_header.records_start -= allocated;
+            m_page.overwrite(new_header.records_start, original.offset_pointer(record_slot.offset), allocated);
+            set_slot(index, { new_header.records_start, record_slot.length });
+        }
+        set_header(new_header);
+    }
+
+    ByteBuffer& m_page;
+};
+
+}
+
+static u32 wal_frame_checksum(WALFrameHeader const& header, ReadonlyBytes data)
 {
-    return adopt_nonnull_ref_or_enomem(new (nothrow) Heap(move(file_name)));
+    Crypto::Checksum::CRC32 crc32;
+    crc32.update({ &header.index, sizeof(header.index) });
+    crc32.update({ &header.flags, sizeof(header.flags) });
+    crc32.update(data);
+    return crc32.digest();
 }
 
-Heap::Heap(ByteString file_name)
+ErrorOr<NonnullRefPtr<Heap>> Heap::create(ByteString file_name, u32 page_size)
+{
+    if (!Block::is_valid_size(page_size))
+        return Error::from_string_literal("Heap::create(): page size must be a power of two between 4 KiB and 16 KiB");
+    return adopt_nonnull_ref_or_enomem(new (nothrow) Heap(move(file_name), page_size));
+}
+
+Heap::Heap(ByteString file_name, u32 page_size)
     : m_name(move(file_name))
+    , m_page_size(page_size)
 {
 }
 
 Heap::~Heap()
 {
-    if (m_file && !m_write_ahead_log.is_empty()) {
-        if (auto maybe_error = flush(); maybe_error.is_error())
-            warnln("~Heap({}): {}", name(), maybe_error.error());
+    if (m_snapshot_source) {
+        Threading::MutexLocker locker { m_snapshot_source->m_lock };
+        m_snapshot_source->m_snapshots.remove_first_matching([&](auto* snapshot) { return snapshot == this; });
+        return;
+    }
+
+    if (!m_file)
+        return;
+
+    auto maybe_error = [&]() -> ErrorOr<void> {
+        TRY(flush());
+        TRY(checkpoint());
+        return {};
+    }();
+    if (maybe_error.is_error())
+        warnln("~Heap({}): {}", name(), maybe_error.error());
+}
+
+constexpr static auto FILE_ID = "SerenitySQL "sv;
+constexpr static auto VERSION_OFFSET = FILE_ID.length();
+constexpr static auto SCHEMAS_ROOT_OFFSET = VERSION_OFFSET + sizeof(u32);
+constexpr static auto TABLES_ROOT_OFFSET = SCHEMAS_ROOT_OFFSET + sizeof(u32);
+constexpr static auto TABLE_COLUMNS_ROOT_OFFSET = TABLES_ROOT_OFFSET + sizeof(u32);
+constexpr static auto TABLE_INDEXES_ROOT_OFFSET = TABLE_COLUMNS_ROOT_OFFSET + sizeof(u32);
+constexpr static auto USER_VALUES_OFFSET = TABLE_INDEXES_ROOT_OFFSET + sizeof(u32);
+constexpr static auto PAGE_SIZE_OFFSET = USER_VALUES_OFFSET + 16 * sizeof(u32);
+constexpr static auto ZERO_BLOCK_HEADER_SIZE = PAGE_SIZE_OFFSET + sizeof(u32);
+
+// Reads part of a file, if the file exists and is large enough.
+static ErrorOr<Optional<ByteBuffer>> read_file_range(ByteString const& path, size_t offset, size_t size)
+{
+    auto file_or_error = Core::File::open(path, Core::File::OpenMode::Read);
+    if (file_or_error.is_error()) {
+        if (file_or_error.error().is_errno() && file_or_error.error().code() == ENOENT)
+            return Optional<ByteBuffer> {};
+        return file_or_error.release_error();
+    }
+    auto file = file_or_error.release_value();
+    if (TRY(file->size()) < offset + size)
+        return Optional<ByteBuffer> {};
+
+    TRY(file->seek(offset, SeekMode::SetPosition));
+    auto buffer = TRY(ByteBuffer::create_uninitialized(size));
+    TRY(file->read_until_filled(buffer));
+    return buffer;
+}
+
+static ErrorOr<void> unlink_if_exists(ByteString const& path)
+{
+    if (auto result = Core::System::unlink(path); result.is_error()) {
+        if (result.error().is_errno() && result.error().code() == ENOENT)
+            return {};
+        return result.release_error();
     }
+    return {};
 }
 
 ErrorOr<void> Heap::open()
 {
     VERIFY(!m_file);
 
+    // The page size is needed to make sense of both the Heap's file and its write-ahead log.
+    TRY(read_header());
+
+    // Bring the Heap's file up to date with any transactions that were committed, but not checkpointed yet.
+    TRY(recover_from_wal());
+
     size_t file_size = 0;
     struct stat stat_buffer;
     if (stat(name().characters(), &stat_buffer) != 0) {
@@ -50,162 +349,596 @@ ErrorOr<void> Heap::open()
         file_size = stat_buffer.st_size;
     }
 
+    // Blocks are only ever written whole, so anything else is either not a heap file or was cut short.
+    if (file_size % m_page_size != 0) {
+        warnln("Heap::open({}): file size {} is not a multiple of the page size {}"sv, name(), file_size, m_page_size);
+        return Error::from_string_literal("Heap::open(): file size is not a multiple of the page size");
+    }
+
     if (file_size > 0) {
-        m_next_block = file_size / Block::SIZE;
+        m_next_block = file_size / m_page_size;
         m_highest_block_written = m_next_block - 1;
     }
 
     auto file = TRY(Core::File::open(name(), Core::File::OpenMode::ReadWrite));
+    m_file_descriptor = file->fd();
     m_file = TRY(Core::InputBufferedFile::create(move(file)));
+    m_wal_file = TRY(Core::File::open(wal_name(), Core::File::OpenMode::ReadWrite | Core::File::OpenMode::Truncate));
 
     if (file_size > 0) {
         if (auto error_maybe = read_zero_block(); error_maybe.is_error()) {
             m_file = nullptr;
+            m_wal_file = nullptr;
             return error_maybe.release_error();
         }
     } else {
         TRY(initialize_zero_block());
     }
 
-    // FIXME: We should more gracefully handle version incompatibilities. For now, we drop the database.
-    if (m_version != VERSION) {
-        dbgln_if(SQL_DEBUG, "Heap file {} opened has incompatible version {}. Deleting for version {}.", name(), m_version, VERSION);
-        m_file = nullptr;
+    if (is_legacy()) {
+        dbgln_if(SQL_DEBUG, "Heap file {} opened read-only; number of blocks = {}", name(), m_highest_block_written);
+        return {};
+    }
 
-        TRY(Core::System::unlink(name()));
-        return open();
+    // Perform a heap scan to find all free pages, and the shared pages with room for more storage
+    // FIXME: this is very inefficient; store free pages in a persistent heap structure
+    for (u32 page = 1; page <= m_highest_block_written; ++page) {
+        auto page_data = TRY(read_raw_block(page));
+        auto type = static_cast<PageType>((*page_data)[0]);
+        if (type == PageType::Free) {
+            TRY(m_free_pages.try_append(page));
+        } else if (type == PageType::Slotted) {
+            ReadonlySlottedPage slotted_page { page_data->bytes() };
+            if (slotted_page.is_shared() && slotted_page.free_space() >= MIN_SHARED_PAGE_FREE_SPACE)
+                TRY(m_shared_pages_with_free_space.try_append(page));
+        }
+    }
+
+    dbgln_if(SQL_DEBUG, "Heap file {} opened; page size = {}; number of pages = {}; free pages = {}", name(), m_page_size, m_highest_block_written, m_free_pages.size());
+    return {};
+}
+
+ErrorOr<void> Heap::read_header()
+{
+    // The zero block is in the Heap's file, or in the first frame of the write-ahead log if the file was never checkpointed.
+    auto header = TRY(read_file_range(name(), 0, ZERO_BLOCK_HEADER_SIZE));
+    if (!header.has_value()) {
+        auto frame = TRY(read_file_range(wal_name(), 0, sizeof(WALFrameHeader) + ZERO_BLOCK_HEADER_SIZE));
+        if (frame.has_value()) {
+            WALFrameHeader frame_header;
+            memcpy(&frame_header, frame->data(), sizeof(frame_header));
+            if (frame_header.magic == WAL_FRAME_MAGIC && frame_header.index == 0)
+                header = TRY(frame->slice(sizeof(WALFrameHeader), ZERO_BLOCK_HEADER_SIZE));
+        }
     }
 
-    // Perform a heap scan to find all free blocks
-    // FIXME: this is very inefficient; store free blocks in a persistent heap structure
-    for (Block::Index index = 1; index <= m_highest_block_written; ++index) {
-        auto block_data = TRY(read_raw_block(index));
-        auto size_in_bytes = *reinterpret_cast<u32*>(block_data.data());
-        if (size_in_bytes == 0)
-            TRY(m_free_block_indices.try_append(index));
+    // A new Heap, or a file that is not a heap file at all; read_zero_block() will complain about the latter.
+    if (!header.has_value() || StringView { header->bytes().trim(FILE_ID.length()) } != FILE_ID)
+        return {};
+
+    u32 version = 0;
+    memcpy(&version, header->offset_pointer(VERSION_OFFSET), sizeof(u32));
+    if (version == LEGACY_VERSION) {
+        m_page_size = Block::LEGACY_SIZE;
+        return {};
+    }
+    if (version == VERSION) {
+        u32 page_size = 0;
+        memcpy(&page_size, header->offset_pointer(PAGE_SIZE_OFFSET), sizeof(u32));
+        if (!Block::is_valid_size(page_size)) {
+            warnln("{}: Zero page corrupt. Invalid page size {}"sv, name(), page_size);
+            return Error::from_string_literal("Heap::read_header(): Zero page corrupt. Invalid page size");
+        }
+        m_page_size = page_size;
+        return {};
     }
 
-    dbgln_if(SQL_DEBUG, "Heap file {} opened; number of blocks = {}; free blocks = {}", name(), m_highest_block_written, m_free_block_indices.size());
+    // FIXME: We should more gracefully handle version incompatibilities. For now, we drop the database.
+    dbgln_if(SQL_DEBUG, "Heap file {} opened has incompatible version {}. Deleting for version {}.", name(), version, VERSION);
+    TRY(unlink_if_exists(name()));
+    TRY(unlink_if_exists(wal_name()));
     return {};
 }
 
+ErrorOr<NonnullRefPtr<Heap>> Heap::create_snapshot()
+{
+    VERIFY(m_file);
+    if (is_legacy())
+        return Error::from_string_view("Cannot take a snapshot of a legacy heap"sv);
+
+    auto snapshot = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) Heap(m_name, m_page_size)));
+    snapshot->m_snapshot_source = this;
+
+    // Pages that were allocated by the current transaction don't exist as far as the snapshot is concerned.
+    snapshot->m_highest_block_written = m_highest_block_written;
+    snapshot->m_next_block = m_highest_block_written + 1;
+
+    {
+        Threading::MutexLocker locker { m_lock };
+        TRY(m_snapshots.try_append(snapshot.ptr()));
+    }
+
+    // The roots we hold may have been changed by the current transaction, so read the committed ones.
+    TRY(snapshot->read_zero_block());
+    return snapshot;
+}
+
 ErrorOr<size_t> Heap::file_size_in_bytes() const
 {
+    if (m_snapshot_source)
+        return m_snapshot_source->file_size_in_bytes();
+
+    Threading::MutexLocker locker { m_lock };
+
+    // Committed blocks that have not been checkpointed yet will end up in the file as well.
     TRY(m_file->seek(0, SeekMode::FromEndPosition));
-    return TRY(m_file->tell());
+    auto file_size = TRY(m_file->tell());
+    return max(file_size, (m_highest_block_written + 1) * static_cast<size_t>(m_page_size));
+}
+
+u32 Heap::max_storage_size_in_page() const
+{
+    return m_page_size - sizeof(SlottedPageHeader) - sizeof(Slot);
+}
+
+size_t Heap::wal_frame_size() const
+{
+    return sizeof(WALFrameHeader) + m_page_size;
 }
 
-bool Heap::has_block(Block::Index index) const
+bool Heap::has_block(Block::Index index)
 {
-    return (index <= m_highest_block_written || m_write_ahead_log.contains(index))
-        && !m_free_block_indices.contains_slow(index);
+    if (is_legacy())
+        return index > 0 && index <= m_highest_block_written;
+
+    auto page = Block::page(index);
+    if (page == 0 || page >= m_next_block || m_free_pages.contains_slow(page))
+        return false;
+    if (page > m_highest_block_written && !m_dirty_blocks.contains(page))
+        return false;
+
+    auto page_data_or_error = read_raw_block(page);
+    if (page_data_or_error.is_error())
+        return false;
+    auto page_data = page_data_or_error.release_value();
+    if (static_cast<PageType>((*page_data)[0]) != PageType::Slotted)
+        return false;
+
+    // Storage that was requested, but never written to, does not count.
+    ReadonlySlottedPage slotted_page { page_data->bytes() };
+    auto slot = Block::slot(index);
+    return slotted_page.is_in_use(slot) && slotted_page.slot(slot).length != 0;
 }
 
 Block::Index Heap::request_new_block_index()
 {
-    if (!m_free_block_indices.is_empty())
-        return m_free_block_indices.take_last();
+    VERIFY(!is_read_only());
+    auto page = allocate_page();
+
+    // Reserve the first slot of the page, so the storage can grow to fill the page without having to move.
+    auto page_data = ByteBuffer::create_uninitialized(m_page_size).release_value_but_fixme_should_propagate_errors();
+    SlottedPage::initialize(page_data, 0);
+    SlottedPage { page_data }.store(0, 0, {});
+    stage_raw_block(page, move(page_data)).release_value_but_fixme_should_propagate_errors();
+
+    return Block::index(page, 0);
+}
+
+u32 Heap::allocate_page()
+{
+    if (!m_free_pages.is_empty())
+        return m_free_pages.take_last();
     return m_next_block++;
 }
 
+ErrorOr<void> Heap::free_page(u32 page)
+{
+    dbgln_if(SQL_DEBUG, "{}({})", __FUNCTION__, page);
+    VERIFY(page > 0);
+
+    // Zero out freed pages to facilitate a free page scan upon opening the database later
+    auto zeroed_data = TRY(ByteBuffer::create_zeroed(m_page_size));
+    TRY(stage_raw_block(page, move(zeroed_data)));
+
+    m_shared_pages_with_free_space.remove_all_matching([&](auto shared_page) { return shared_page == page; });
+    return m_free_pages.try_append(page);
+}
+
 ErrorOr<ByteBuffer> Heap::read_storage(Block::Index index)
+{
+    auto storage = TRY(read_pinned_storage(index));
+    return ByteBuffer::copy(storage.bytes());
+}
+
+ErrorOr<PinnedStorage> Heap::read_pinned_storage(Block::Index index)
 {
     dbgln_if(SQL_DEBUG, "{}({})", __FUNCTION__, index);
+    if (is_legacy())
+        return PinnedStorage { TRY(read_legacy_storage(index)) };
+
+    auto page = Block::page(index);
+    auto slot = Block::slot(index);
+    if (page == 0 || page >= m_next_block)
+        return Error::from_string_view("Reading from an invalid block index"sv);
+
+    auto page_data = TRY(read_raw_block(page));
+    ReadonlySlottedPage slotted_page { page_data->bytes() };
+    if (static_cast<PageType>((*page_data)[0]) != PageType::Slotted || !slotted_page.is_in_use(slot))
+        return Error::from_string_view("Reading from a free block index"sv);
+
+    auto record = slotted_page.record(slot);
+    if (!ReadonlySlottedPage::is_overflow(slotted_page.slot(slot))) {
+        dbgln_if(SQL_DEBUG, "  -> {} bytes", record.size());
+        return PinnedStorage { move(page_data), record };
+    }
+
+    OverflowRecordHeader header;
+    memcpy(&header, record.data(), sizeof(header));
+    dbgln_if(SQL_DEBUG, "  -> {} bytes, overflowing into page {}", header.size_in_bytes, header.first_overflow_page);
 
-    // Reconstruct the data storage from a potential chain of blocks
     ByteBuffer data;
-    while (index > 0) {
-        auto block = TRY(read_block(index));
-        dbgln_if(SQL_DEBUG, "  -> {} bytes", block.size_in_bytes());
-        TRY(data.try_append(block.data().bytes().slice(0, block.size_in_bytes())));
-        index = block.next_block();
+    TRY(data.try_ensure_capacity(header.size_in_bytes));
+    TRY(data.try_append(record.slice(sizeof(header))));
+    TRY(read_overflow_pages(header.first_overflow_page, data));
+    if (data.size() != header.size_in_bytes)
+        return Error::from_string_view("Overflow pages of storage are corrupt"sv);
+    return PinnedStorage { move(data) };
+}
+
+ErrorOr<Block::Index> Heap::insert_storage(ReadonlyBytes data)
+{
+    dbgln_if(SQL_DEBUG, "{}({} bytes)", __FUNCTION__, data.size());
+    if (is_read_only())
+        return Error::from_string_view("Writing to a read-only heap is not allowed"sv);
+    if (data.is_empty())
+        return Error::from_string_view("Writing empty data is not allowed"sv);
+
+    if (data.size() > m_page_size / MAX_SHARED_STORAGE_SIZE_DIVISOR) {
+        auto index = request_new_block_index();
+        TRY(write_storage(index, data));
+        return index;
     }
-    return data;
+
+    while (!m_shared_pages_with_free_space.is_empty()) {
+        auto page = m_shared_pages_with_free_space.last();
+        auto page_data = TRY(read_raw_block_for_writing(page));
+        SlottedPage slotted_page { page_data };
+
+        auto slot = slotted_page.free_slot();
+        if (slot.has_value() && slotted_page.room_for(*slot) >= SlottedPage::allocated_length(data.size())) {
+            slotted_page.store(*slot, data.size(), data);
+            if (slotted_page.free_space() < MIN_SHARED_PAGE_FREE_SPACE)
+                m_shared_pages_with_free_space.take_last();
+            TRY(stage_raw_block(page, move(page_data)));
+            return Block::index(page, *slot);
+        }
+
+        // Storage of a table tends to be of similar size, so the page is unlikely to fit the storage that comes next.
+        m_shared_pages_with_free_space.take_last();
+    }
+
+    auto page = allocate_page();
+    auto page_data = TRY(ByteBuffer::create_uninitialized(m_page_size));
+    SlottedPage::initialize(page_data, PAGE_FLAG_SHARED);
+    SlottedPage { page_data }.store(0, data.size(), data);
+    TRY(stage_raw_block(page, move(page_data)));
+    TRY(m_shared_pages_with_free_space.try_append(page));
+    return Block::index(page, 0);
 }
 
 ErrorOr<void> Heap::write_storage(Block::Index index, ReadonlyBytes data)
 {
     dbgln_if(SQL_DEBUG, "{}({}, {} bytes)", __FUNCTION__, index, data.size());
-    if (index == 0)
+    if (is_read_only())
+        return Error::from_string_view("Writing to a read-only heap is not allowed"sv);
+
+    auto page = Block::page(index);
+    auto slot = Block::slot(index);
+    if (page == 0)
         return Error::from_string_view("Writing to zero block is not allowed"sv);
     if (data.is_empty())
         return Error::from_string_view("Writing empty data is not allowed"sv);
-    if (m_free_block_indices.contains_slow(index))
+    if (page >= m_next_block || m_free_pages.contains_slow(page))
         return Error::from_string_view("Invalid write to a free block index"sv);
 
-    // Split up the storage across multiple blocks if necessary, creating a chain
-    u32 remaining_size = static_cast<u32>(data.size());
-    u32 offset_in_data = 0;
-    Block::Index existing_next_block_index = 0;
-    while (remaining_size > 0) {
-        auto block_data_size = AK::min(remaining_size, Block::DATA_SIZE);
-        remaining_size -= block_data_size;
-
-        ByteBuffer block_data;
-        if (has_block(index)) {
-            auto existing_block = TRY(read_block(index));
-            block_data = existing_block.data();
-            TRY(block_data.try_resize(block_data_size));
-            existing_next_block_index = existing_block.next_block();
-        } else {
-            block_data = TRY(ByteBuffer::create_uninitialized(block_data_size));
-            existing_next_block_index = 0;
-        }
+    auto page_data = TRY(read_raw_block_for_writing(page));
+    SlottedPage slotted_page { page_data };
+    if (static_cast<PageType>(page_data[0]) != PageType::Slotted || !slotted_page.is_in_use(slot))
+        return Error::from_string_view("Invalid write to a free block index"sv);
 
-        Block::Index next_block_index = existing_next_block_index;
-        if (next_block_index == 0 && remaining_size > 0)
-            next_block_index = request_new_block_index();
-        else if (remaining_size == 0)
-            next_block_index = 0;
+    // Overflow pages are written anew, if the storage still needs them.
+    if (SlottedPage::is_overflow(slotted_page.slot(slot))) {
+        OverflowRecordHeader header;
+        memcpy(&header, slotted_page.record(slot).data(), sizeof(header));
+        TRY(free_overflow_pages(header.first_overflow_page));
+    }
 
-        block_data.bytes().overwrite(0, data.offset(offset_in_data), block_data_size);
-        TRY(write_block({ index, block_data_size, next_block_index, move(block_data) }));
+    return store_in_page(page, page_data, slot, data);
+}
 
-        index = next_block_index;
-        offset_in_data += block_data_size;
+ErrorOr<void> Heap::store_in_page(u32 page, ByteBuffer& page_data, u16 slot, ReadonlyBytes data)
+{
+    SlottedPage slotted_page { page_data };
+    auto room = slotted_page.room_for(slot);
+    if (data.size() <= room) {
+        slotted_page.store(slot, data.size(), data);
+        return stage_raw_block(page, move(page_data));
     }
 
-    // Free remaining blocks in existing chain, if any
-    if (existing_next_block_index > 0)
-        TRY(free_storage(existing_next_block_index));
+    // Storage with a page of its own keeps as much of its data in that page as fits. Storage in a shared page keeps just
+    // the overflow header there, to leave room for the other storage in the page.
+    size_t kept_in_page = 0;
+    if (!slotted_page.is_shared())
+        kept_in_page = room - sizeof(OverflowRecordHeader);
+
+    OverflowRecordHeader header {
+        .size_in_bytes = static_cast<u32>(data.size()),
+        .first_overflow_page = TRY(write_overflow_pages(data.slice(kept_in_page))),
+    };
+    auto record = TRY(ByteBuffer::create_uninitialized(sizeof(header) + kept_in_page));
+    record.overwrite(0, &header, sizeof(header));
+    record.overwrite(sizeof(header), data.data(), kept_in_page);
+
+    slotted_page.store(slot, record.size() | SLOT_FLAG_OVERFLOW, record);
+    return stage_raw_block(page, move(page_data));
+}
+
+ErrorOr<u32> Heap::write_overflow_pages(ReadonlyBytes data)
+{
+    VERIFY(!data.is_empty());
+    auto page_capacity = m_page_size - sizeof(OverflowPageHeader);
+
+    Vector<u32> pages;
+    for (size_t offset = 0; offset < data.size(); offset += page_capacity)
+        TRY(pages.try_append(allocate_page()));
+
+    for (size_t i = 0; i < pages.size(); ++i) {
+        auto chunk = data.slice(i * page_capacity, min(page_capacity, data.size() - i * page_capacity));
+        OverflowPageHeader header {
+            .type = PageType::Overflow,
+            .unused = 0,
+            .size_in_bytes = static_cast<u16>(chunk.size()),
+            .next_page = i + 1 < pages.size() ? pages[i + 1] : 0,
+        };
+
+        auto page_data = TRY(ByteBuffer::create_zeroed(m_page_size));
+        page_data.overwrite(0, &header, sizeof(header));
+        page_data.overwrite(sizeof(header), chunk.data(), chunk.size());
+        TRY(stage_raw_block(pages[i], move(page_data)));
+    }
+    return pages.first();
+}
 
+ErrorOr<void> Heap::read_overflow_pages(u32 page, ByteBuffer& data)
+{
+    while (page > 0) {
+        auto page_data = TRY(read_raw_block(page));
+        OverflowPageHeader header;
+        memcpy(&header, page_data->bytes().data(), sizeof(header));
+        if (header.type != PageType::Overflow || header.size_in_bytes > m_page_size - sizeof(header))
+            return Error::from_string_view("Overflow pages of storage are corrupt"sv);
+
+        TRY(data.try_append(page_data->bytes().slice(sizeof(header), header.size_in_bytes)));
+        page = header.next_page;
+    }
     return {};
 }
 
-ErrorOr<ByteBuffer> Heap::read_raw_block(Block::Index index)
+ErrorOr<void> Heap::free_overflow_pages(u32 page)
+{
+    while (page > 0) {
+        auto page_data = TRY(read_raw_block(page));
+        OverflowPageHeader header;
+        memcpy(&header, page_data->bytes().data(), sizeof(header));
+        TRY(free_page(page));
+        page = header.next_page;
+    }
+    return {};
+}
+
+ErrorOr<ByteBuffer> Heap::read_legacy_storage(Block::Index index)
+{
+    // Legacy storage is a chain of blocks, each starting with the size of its data and the index of the next block.
+    static constexpr size_t legacy_header_size = sizeof(u32) + sizeof(Block::Index);
+
+    ByteBuffer data;
+    while (index > 0) {
+        if (index > m_highest_block_written)
+            return Error::from_string_view("Reading from an invalid block index"sv);
+
+        auto block = TRY(read_raw_block(index));
+        u32 size_in_bytes = 0;
+        Block::Index next_block = 0;
+        memcpy(&size_in_bytes, block->bytes().offset_pointer(0), sizeof(u32));
+        memcpy(&next_block, block->bytes().offset_pointer(sizeof(u32)), sizeof(Block::Index));
+        if (size_in_bytes > m_page_size - legacy_header_size)
+            return Error::from_string_view("Legacy storage is corrupt"sv);
+
+        dbgln_if(SQL_DEBUG, "  -> {} bytes", size_in_bytes);
+        TRY(data.try_append(block->bytes().slice(legacy_header_size, size_in_bytes)));
+        index = next_block;
+    }
+    return data;
+}
+
+ErrorOr<NonnullRefPtr<Page const>> Heap::read_raw_block(u32 index)
 {
-    VERIFY(m_file);
     VERIFY(index < m_next_block);
+    if (m_snapshot_source)
+        return m_snapshot_source->read_snapshot_block(*this, index);
+
+    VERIFY(m_file);
+    if (auto dirty_block = m_dirty_blocks.get(index); dirty_block.has_value())
+        return NonnullRefPtr { *dirty_block.value() };
+
+    Threading::MutexLocker locker { m_lock };
+    return read_committed_block(index);
+}
 
-    if (auto wal_entry = m_write_ahead_log.get(index); wal_entry.has_value())
-        return wal_entry.value();
+// Pages are shared, so they have to be copied before they can be modified and staged again.
+ErrorOr<ByteBuffer> Heap::read_raw_block_for_writing(u32 index)
+{
+    auto page = TRY(read_raw_block(index));
+    return ByteBuffer::copy(page->bytes());
+}
+
+// Must be called with m_lock held.
+ErrorOr<NonnullRefPtr<Page const>> Heap::read_committed_block(u32 index)
+{
+    if (auto cached_page = cached_block(index)) {
+        ++m_buffer_pool_hits;
+        return cached_page.release_nonnull();
+    }
+    ++m_buffer_pool_misses;
+
+    ByteBuffer buffer;
+    if (auto wal_frame_offset = m_wal_frame_offsets.get(index); wal_frame_offset.has_value()) {
+        buffer = TRY(read_wal_frame(*wal_frame_offset));
+    } else {
+        TRY(m_file->seek(static_cast<size_t>(index) * m_page_size, SeekMode::SetPosition));
+        buffer = TRY(ByteBuffer::create_uninitialized(m_page_size));
+        TRY(m_file->read_until_filled(buffer));
+    }
+    auto page = TRY(Page::create(move(buffer)));
+    TRY(cache_block(index, page));
+    return page;
+}
+
+ErrorOr<NonnullRefPtr<Page const>> Heap::read_snapshot_block(Heap& snapshot, u32 index)
+{
+    Threading::MutexLocker locker { m_lock };
+    if (auto preserved_block = snapshot.m_snapshot_blocks.get(index); preserved_block.has_value())
+        return NonnullRefPtr { *preserved_block.value() };
+    return read_committed_block(index);
+}
+
+// Must be called with m_lock held, before the new versions of the pages are committed.
+ErrorOr<void> Heap::preserve_blocks_for_snapshots(Vector<u32> const& pages)
+{
+    for (auto* snapshot : m_snapshots) {
+        for (auto page : pages) {
+            // A snapshot only reads pages that existed when it was created, and only needs their oldest version.
+            if (page >= snapshot->m_next_block || snapshot->m_snapshot_blocks.contains(page))
+                continue;
+            TRY(snapshot->m_snapshot_blocks.try_set(page, TRY(read_committed_block(page))));
+        }
+    }
+    return {};
+}
+
+ErrorOr<ByteBuffer> Heap::read_wal_frame(size_t offset)
+{
+    VERIFY(m_wal_file);
 
-    TRY(m_file->seek(index * Block::SIZE, SeekMode::SetPosition));
-    auto buffer = TRY(ByteBuffer::create_uninitialized(Block::SIZE));
-    TRY(m_file->read_until_filled(buffer));
+    TRY(m_wal_file->seek(offset + sizeof(WALFrameHeader), SeekMode::SetPosition));
+    auto buffer = TRY(ByteBuffer::create_uninitialized(m_page_size));
+    TRY(m_wal_file->read_until_filled(buffer));
     return buffer;
 }
 
-ErrorOr<Block> Heap::read_block(Block::Index index)
+RefPtr<Page const> Heap::cached_block(u32 index)
 {
-    dbgln_if(SQL_DEBUG, "{}({})", __FUNCTION__, index);
+    auto frame_index = m_buffer_pool_frames.get(index);
+    if (!frame_index.has_value())
+        return nullptr;
+
+    auto& frame = m_buffer_pool[*frame_index];
+    frame.referenced = true;
+    return frame.page;
+}
+
+ErrorOr<void> Heap::cache_block(u32 index, NonnullRefPtr<Page const> page)
+{
+    VERIFY(page->bytes().size() == m_page_size);
+    if (m_buffer_pool_capacity == 0)
+        return {};
+
+    // Whoever still holds on to the previous version of the page keeps seeing that one.
+    if (auto frame_index = m_buffer_pool_frames.get(index); frame_index.has_value()) {
+        auto& frame = m_buffer_pool[*frame_index];
+        frame.page = move(page);
+        frame.referenced = true;
+        return {};
+    }
+
+    if (m_buffer_pool.size() < m_buffer_pool_capacity) {
+        TRY(m_buffer_pool.try_append({ index, move(page), true }));
+        TRY(m_buffer_pool_frames.try_set(index, m_buffer_pool.size() - 1));
+        return {};
+    }
 
-    auto buffer = TRY(read_raw_block(index));
-    auto size_in_bytes = *reinterpret_cast<u32*>(buffer.offset_pointer(0));
-    auto next_block = *reinterpret_cast<Block::Index*>(buffer.offset_pointer(sizeof(u32)));
-    auto data = TRY(buffer.slice(Block::HEADER_SIZE, Block::DATA_SIZE));
+    // Sweep the clock hand around the pool, giving every recently used frame a second chance,
+    // until we find one that has not been referenced since the last time we passed it. Pinned
+    // frames can't be evicted; if that's all there is, the page simply isn't cached.
+    for (size_t frames_passed = 0; frames_passed < 2 * m_buffer_pool.size(); ++frames_passed) {
+        auto frame_index = m_buffer_pool_clock_hand;
+        m_buffer_pool_clock_hand = (m_buffer_pool_clock_hand + 1) % m_buffer_pool.size();
+
+        auto& frame = m_buffer_pool[frame_index];
+        if (frame.is_pinned())
+            continue;
+        if (frame.referenced) {
+            frame.referenced = false;
+            continue;
+        }
+
+        dbgln_if(SQL_DEBUG, "Evicting block {} from the buffer pool for block {}", frame.index, index);
+        m_buffer_pool_frames.remove(frame.index);
+        ++m_buffer_pool_evictions;
+
+        frame.index = index;
+        frame.page = move(page);
+        frame.referenced = true;
+        TRY(m_buffer_pool_frames.try_set(index, frame_index));
+        return {};
+    }
 
-    return Block { index, size_in_bytes, next_block, move(data) };
+    dbgln_if(SQL_DEBUG, "Not caching block {}, every frame of the buffer pool is pinned", index);
+    return {};
+}
+
+BufferPoolStatistics Heap::buffer_pool_statistics() const
+{
+    Threading::MutexLocker locker { m_lock };
+
+    size_t pinned_blocks = 0;
+    for (auto const& frame : m_buffer_pool) {
+        if (frame.is_pinned())
+            ++pinned_blocks;
+    }
+
+    return {
+        .capacity = m_buffer_pool_capacity,
+        .cached_blocks = m_buffer_pool.size(),
+        .pinned_blocks = pinned_blocks,
+        .hits = m_buffer_pool_hits,
+        .misses = m_buffer_pool_misses,
+        .evictions = m_buffer_pool_evictions,
+    };
+}
+
+void Heap::set_buffer_pool_capacity(size_t capacity)
+{
+    Threading::MutexLocker locker { m_lock };
+    m_buffer_pool_capacity = capacity;
+    clear_buffer_pool();
+}
+
+void Heap::clear_buffer_pool()
+{
+    m_buffer_pool.clear();
+    m_buffer_pool_frames.clear();
+    m_buffer_pool_clock_hand = 0;
 }
 
-ErrorOr<void> Heap::write_raw_block(Block::Index index, ReadonlyBytes data)
+ErrorOr<void> Heap::write_raw_block(u32 index, ReadonlyBytes data)
 {
     dbgln_if(SQL_DEBUG, "Write raw block {}", index);
 
     VERIFY(m_file);
-    VERIFY(data.size() == Block::SIZE);
+    VERIFY(data.size() == m_page_size);
 
-    TRY(m_file->seek(index * Block::SIZE, SeekMode::SetPosition));
+    TRY(m_file->seek(static_cast<size_t>(index) * m_page_size, SeekMode::SetPosition));
     TRY(m_file->write_until_depleted(data));
 
     if (index > m_highest_block_written)
@@ -214,94 +947,215 @@ ErrorOr<void> Heap::write_raw_block(Block::Index index, ReadonlyBytes data)
     return {};
 }
 
-ErrorOr<void> Heap::write_raw_block_to_wal(Block::Index index, ByteBuffer&& data)
+ErrorOr<void> Heap::stage_raw_block(u32 index, ByteBuffer&& data)
 {
     dbgln_if(SQL_DEBUG, "{}({})", __FUNCTION__, index);
     VERIFY(index < m_next_block);
-    VERIFY(data.size() == Block::SIZE);
+    VERIFY(data.size() == m_page_size);
 
-    TRY(m_write_ahead_log.try_set(index, move(data)));
+    TRY(m_dirty_blocks.try_set(index, TRY(Page::create(move(data)))));
 
     return {};
 }
 
-ErrorOr<void> Heap::write_block(Block const& block)
+ErrorOr<void> Heap::free_storage(Block::Index index)
 {
-    dbgln_if(SQL_DEBUG, "{}({})", __FUNCTION__, block.index());
-    VERIFY(block.index() < m_next_block);
-    VERIFY(block.next_block() < m_next_block);
-    VERIFY(block.size_in_bytes() > 0);
-    VERIFY(block.data().size() <= Block::DATA_SIZE);
-
-    auto size_in_bytes = block.size_in_bytes();
-    auto next_block = block.next_block();
-
-    auto heap_data = TRY(ByteBuffer::create_zeroed(Block::SIZE));
-    heap_data.overwrite(0, &size_in_bytes, sizeof(size_in_bytes));
-    heap_data.overwrite(sizeof(size_in_bytes), &next_block, sizeof(next_block));
+    dbgln_if(SQL_DEBUG, "{}({})", __FUNCTION__, index);
+    VERIFY(index > 0);
+    if (is_read_only())
+        return Error::from_string_view("Writing to a read-only heap is not allowed"sv);
+
+    auto page = Block::page(index);
+    auto slot = Block::slot(index);
+    auto page_data = TRY(read_raw_block_for_writing(page));
+    SlottedPage slotted_page { page_data };
+    VERIFY(static_cast<PageType>(page_data[0]) == PageType::Slotted && slotted_page.is_in_use(slot));
+
+    if (SlottedPage::is_overflow(slotted_page.slot(slot))) {
+        OverflowRecordHeader header;
+        memcpy(&header, slotted_page.record(slot).data(), sizeof(header));
+        TRY(free_overflow_pages(header.first_overflow_page));
+    }
 
-    block.data().bytes().copy_to(heap_data.bytes().slice(Block::HEADER_SIZE));
+    slotted_page.remove(slot);
+    if (slotted_page.slot_count() == 0)
+        return free_page(page);
 
-    return write_raw_block_to_wal(block.index(), move(heap_data));
+    auto has_room = slotted_page.is_shared() && slotted_page.free_space() >= MIN_SHARED_PAGE_FREE_SPACE;
+    TRY(stage_raw_block(page, move(page_data)));
+    if (has_room && !m_shared_pages_with_free_space.contains_slow(page))
+        TRY(m_shared_pages_with_free_space.try_append(page));
+    return {};
 }
 
-ErrorOr<void> Heap::free_storage(Block::Index index)
+ErrorOr<void> Heap::flush()
 {
-    dbgln_if(SQL_DEBUG, "{}({})", __FUNCTION__, index);
-    VERIFY(index > 0);
+    if (m_dirty_blocks.is_empty())
+        return {};
+    VERIFY(m_file);
 
-    while (index > 0) {
-        auto block = TRY(read_block(index));
-        TRY(free_block(block));
-        index = block.next_block();
+    auto indices = m_dirty_blocks.keys();
+    quick_sort(indices);
+
+    // Append all blocks of the transaction with a single write, the last one marking the commit.
+    auto frame_size = wal_frame_size();
+    auto frames = TRY(ByteBuffer::create_uninitialized(indices.size() * frame_size));
+    for (size_t i = 0; i < indices.size(); ++i) {
+        auto data = m_dirty_blocks.get(indices[i]).value()->bytes();
+
+        WALFrameHeader header {
+            .magic = WAL_FRAME_MAGIC,
+            .index = indices[i],
+            .flags = i == indices.size() - 1 ? WAL_FRAME_FLAG_COMMIT : 0,
+            .checksum = 0,
+        };
+        header.checksum = wal_frame_checksum(header, data);
+
+        frames.overwrite(i * frame_size, &header, sizeof(header));
+        frames.overwrite(i * frame_size + sizeof(header), data.data(), data.size());
     }
+
+    {
+        Threading::MutexLocker locker { m_lock };
+        TRY(preserve_blocks_for_snapshots(indices));
+
+        auto write_frames = [&]() -> ErrorOr<void> {
+            TRY(m_wal_file->seek(m_wal_size, SeekMode::SetPosition));
+            TRY(m_wal_file->write_until_depleted(frames));
+            return {};
+        }();
+        if (write_frames.is_error()) {
+            // Make sure a partially written transaction can't hide the ones that follow.
+            (void)m_wal_file->truncate(m_wal_size);
+            return write_frames.release_error();
+        }
+
+        for (size_t i = 0; i < indices.size(); ++i) {
+            TRY(m_wal_frame_offsets.try_set(indices[i], m_wal_size + i * frame_size));
+            if (indices[i] > m_highest_block_written)
+                m_highest_block_written = indices[i];
+
+            // The block is committed now, and likely to be used again soon. Hand the page over to the
+            // buffer pool, so it isn't pinned by the dirty block that it used to be.
+            TRY(cache_block(indices[i], m_dirty_blocks.take(indices[i]).release_value()));
+        }
+        m_wal_size += frames.size();
+        m_dirty_blocks.clear();
+        m_has_unsynced_commits = true;
+        dbgln_if(SQL_DEBUG, "Committed {} blocks to the WAL; WAL size = {}", indices.size(), m_wal_size);
+    }
+
+    if (!m_group_commit)
+        TRY(sync());
+
+    if (m_wal_size >= WAL_CHECKPOINT_THRESHOLD * frame_size)
+        TRY(checkpoint());
+
     return {};
 }
 
-ErrorOr<void> Heap::free_block(Block const& block)
+ErrorOr<void> Heap::sync()
 {
-    auto index = block.index();
-    dbgln_if(SQL_DEBUG, "{}({})", __FUNCTION__, index);
-
-    VERIFY(index > 0);
-    VERIFY(has_block(index));
+    if (!m_has_unsynced_commits)
+        return {};
 
-    // Zero out freed blocks to facilitate a free block scan upon opening the database later
-    auto zeroed_data = TRY(ByteBuffer::create_zeroed(Block::SIZE));
-    TRY(write_raw_block_to_wal(index, move(zeroed_data)));
-
-    return m_free_block_indices.try_append(index);
+    TRY(Core::System::fsync(m_wal_file->fd()));
+    m_has_unsynced_commits = false;
+    return {};
 }
 
-ErrorOr<void> Heap::flush()
+ErrorOr<void> Heap::checkpoint()
 {
+    if (m_wal_frame_offsets.is_empty())
+        return {};
     VERIFY(m_file);
-    auto indices = m_write_ahead_log.keys();
+
+    Threading::MutexLocker locker { m_lock };
+
+    // The log is what allows us to recover from a crash halfway through the checkpoint.
+    TRY(sync());
+
+    auto indices = m_wal_frame_offsets.keys();
     quick_sort(indices);
     for (auto index : indices) {
-        dbgln_if(SQL_DEBUG, "Flushing block {}", index);
-        auto& data = m_write_ahead_log.get(index).value();
-        TRY(write_raw_block(index, data));
+        dbgln_if(SQL_DEBUG, "Checkpointing block {}", index);
+        if (auto cached_page = cached_block(index))
+            TRY(write_raw_block(index, cached_page->bytes()));
+        else
+            TRY(write_raw_block(index, TRY(read_wal_frame(m_wal_frame_offsets.get(index).value()))));
     }
-    m_write_ahead_log.clear();
-    dbgln_if(SQL_DEBUG, "WAL flushed; new number of blocks = {}", m_highest_block_written);
+    TRY(Core::System::fsync(m_file_descriptor));
+
+    TRY(m_wal_file->truncate(0));
+    TRY(Core::System::fsync(m_wal_file->fd()));
+    m_wal_frame_offsets.clear();
+    m_wal_size = 0;
+
+    dbgln_if(SQL_DEBUG, "WAL checkpointed; new number of blocks = {}", m_highest_block_written);
     return {};
 }
 
-constexpr static auto FILE_ID = "SerenitySQL "sv;
-constexpr static auto VERSION_OFFSET = FILE_ID.length();
-constexpr static auto SCHEMAS_ROOT_OFFSET = VERSION_OFFSET + sizeof(u32);
-constexpr static auto TABLES_ROOT_OFFSET = SCHEMAS_ROOT_OFFSET + sizeof(u32);
-constexpr static auto TABLE_COLUMNS_ROOT_OFFSET = TABLES_ROOT_OFFSET + sizeof(u32);
-constexpr static auto USER_VALUES_OFFSET = TABLE_COLUMNS_ROOT_OFFSET + sizeof(u32);
+ErrorOr<void> Heap::recover_from_wal()
+{
+    auto wal_file_or_error = Core::File::open(wal_name(), Core::File::OpenMode::ReadWrite | Core::File::OpenMode::DontCreate);
+    if (wal_file_or_error.is_error()) {
+        if (wal_file_or_error.error().is_errno() && wal_file_or_error.error().code() == ENOENT)
+            return {};
+        return wal_file_or_error.release_error();
+    }
+    auto wal_file = wal_file_or_error.release_value();
+    auto wal = TRY(wal_file->read_until_eof());
+    if (wal.is_empty())
+        return {};
+
+    // Find the latest committed version of every block, stopping at the first damaged or incomplete frame.
+    auto frame_size = wal_frame_size();
+    HashMap<u32, size_t> committed_frame_offsets;
+    Vector<u32> uncommitted_indices;
+    Vector<size_t> uncommitted_frame_offsets;
+    for (size_t offset = 0; offset + frame_size <= wal.size(); offset += frame_size) {
+        WALFrameHeader header;
+        memcpy(&header, wal.offset_pointer(offset), sizeof(header));
+        auto data = wal.bytes().slice(offset + sizeof(header), m_page_size);
+        if (header.magic != WAL_FRAME_MAGIC || header.checksum != wal_frame_checksum(header, data))
+            break;
+
+        TRY(uncommitted_indices.try_append(header.index));
+        TRY(uncommitted_frame_offsets.try_append(offset));
+        if ((header.flags & WAL_FRAME_FLAG_COMMIT) == 0)
+            continue;
+
+        for (size_t i = 0; i < uncommitted_indices.size(); ++i)
+            TRY(committed_frame_offsets.try_set(uncommitted_indices[i], uncommitted_frame_offsets[i]));
+        uncommitted_indices.clear_with_capacity();
+        uncommitted_frame_offsets.clear_with_capacity();
+    }
+
+    dbgln_if(SQL_DEBUG, "Recovering {} blocks from WAL {}", committed_frame_offsets.size(), wal_name());
+    if (!committed_frame_offsets.is_empty()) {
+        auto file = TRY(Core::File::open(name(), Core::File::OpenMode::ReadWrite));
+        auto indices = committed_frame_offsets.keys();
+        quick_sort(indices);
+        for (auto index : indices) {
+            auto offset = committed_frame_offsets.get(index).value();
+            TRY(file->seek(static_cast<size_t>(index) * m_page_size, SeekMode::SetPosition));
+            TRY(file->write_until_depleted(wal.bytes().slice(offset + sizeof(WALFrameHeader), m_page_size)));
+        }
+        TRY(Core::System::fsync(file->fd()));
+    }
+
+    TRY(wal_file->truncate(0));
+    TRY(Core::System::fsync(wal_file->fd()));
+    return {};
+}
 
 ErrorOr<void> Heap::read_zero_block()
 {
     dbgln_if(SQL_DEBUG, "Read zero block from {}", name());
 
-    auto block = TRY(read_raw_block(0));
-    auto file_id_buffer = TRY(block.slice(0, FILE_ID.length()));
-    auto file_id = StringView(file_id_buffer);
+    auto page = TRY(read_raw_block(0));
+    auto block = page->bytes();
+    auto file_id = StringView(block.trim(FILE_ID.length()));
     if (file_id != FILE_ID) {
         warnln("{}: Zero page corrupt. This is probably not a {} heap file"sv, name(), FILE_ID);
         return Error::from_string_literal("Heap()::read_zero_block(): Zero page corrupt. This is probably not a SerenitySQL heap file");
@@ -319,6 +1173,9 @@ ErrorOr<void> Heap::read_zero_block()
     memcpy(&m_table_columns_root, block.offset_pointer(TABLE_COLUMNS_ROOT_OFFSET), sizeof(u32));
     dbgln_if(SQL_DEBUG, "Table columns root node: {}", m_table_columns_root);
 
+    memcpy(&m_table_indexes_root, block.offset_pointer(TABLE_INDEXES_ROOT_OFFSET), sizeof(u32));
+    dbgln_if(SQL_DEBUG, "Table indexes root node: {}", m_table_indexes_root);
+
     memcpy(m_user_values.data(), block.offset_pointer(USER_VALUES_OFFSET), m_user_values.size() * sizeof(u32));
     for (auto ix = 0u; ix < m_user_values.size(); ix++) {
         if (m_user_values[ix])
@@ -331,24 +1188,28 @@ ErrorOr<void> Heap::update_zero_block()
 {
     dbgln_if(SQL_DEBUG, "Write zero block to {}", name());
     dbgln_if(SQL_DEBUG, "Version: {}.{}", (m_version & 0xFFFF0000) >> 16, (m_version & 0x0000FFFF));
+    dbgln_if(SQL_DEBUG, "Page size: {}", m_page_size);
     dbgln_if(SQL_DEBUG, "Schemas root node: {}", m_schemas_root);
     dbgln_if(SQL_DEBUG, "Tables root node: {}", m_tables_root);
     dbgln_if(SQL_DEBUG, "Table Columns root node: {}", m_table_columns_root);
+    dbgln_if(SQL_DEBUG, "Table Indexes root node: {}", m_table_indexes_root);
     for (auto ix = 0u; ix < m_user_values.size(); ix++) {
         if (m_user_values[ix] > 0)
             dbgln_if(SQL_DEBUG, "User value {}: {}", ix, m_user_values[ix]);
     }
 
-    auto buffer = TRY(ByteBuffer::create_zeroed(Block::SIZE));
+    auto buffer = TRY(ByteBuffer::create_zeroed(m_page_size));
     auto buffer_bytes = buffer.bytes();
     buffer_bytes.overwrite(0, FILE_ID.characters_without_null_termination(), FILE_ID.length());
     buffer_bytes.overwrite(VERSION_OFFSET, &m_version, sizeof(u32));
     buffer_bytes.overwrite(SCHEMAS_ROOT_OFFSET, &m_schemas_root, sizeof(u32));
     buffer_bytes.overwrite(TABLES_ROOT_OFFSET, &m_tables_root, sizeof(u32));
     buffer_bytes.overwrite(TABLE_COLUMNS_ROOT_OFFSET, &m_table_columns_root, sizeof(u32));
+    buffer_bytes.overwrite(TABLE_INDEXES_ROOT_OFFSET, &m_table_indexes_root, sizeof(u32));
     buffer_bytes.overwrite(USER_VALUES_OFFSET, m_user_values.data(), m_user_values.size() * sizeof(u32));
+    buffer_bytes.overwrite(PAGE_SIZE_OFFSET, &m_page_size, sizeof(u32));
 
-    return write_raw_block_to_wal(0, move(buffer));
+    return stage_raw_block(0, move(buffer));
 }
 
 ErrorOr<void> Heap::initialize_zero_block()
@@ -357,6 +1218,7 @@ ErrorOr<void> Heap::initialize_zero_block()
     m_schemas_root = 0;
     m_tables_root = 0;
     m_table_columns_root = 0;
+    m_table_indexes_root = 0;
     m_next_block = 1;
     m_highest_block_written = 0;
     for (auto& user : m_user_values)
@@ -8,53 +8,123 @@
 #pragma once
 
 #include <AK/Array.h>
+#include <AK/AtomicRefCounted.h>
 #include <AK/ByteString.h>
 #include <AK/Debug.h>
 #include <AK/HashMap.h>
-#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
 #include <AK/Vector.h>
 #include <LibCore/File.h>
+#include <LibThreading/Mutex.h>
 
 namespace SQL {
 
 /**
- * A Block represents a single discrete chunk of 1024 bytes inside the Heap, and
- * acts as the container format for the actual data we are storing. This structure
- * is used for everything except block 0, the zero / super block.
+ * The Heap's file is divided into pages of equal size, which is chosen when the
+ * file is created. Page 0 is the zero / super block. Every other page is either
+ * free, a slotted page holding records, or an overflow page holding the part of
+ * a record that did not fit in its slotted page.
  *
- * If data needs to be stored that is larger than 1016 bytes, Blocks are chained
- * together by setting the next block index and the data is reconstructed by
- * repeatedly reading blocks until the next block index is 0.
+ * A slotted page starts with a header and an array of slots, and stores its
+ * records from the end of the page towards the slots. A slot points at the
+ * offset and length of its record, so records can be moved around within their
+ * page without changing their identity. A Block::Index identifies a record by
+ * its page and slot.
  */
 class Block {
 public:
     typedef u32 Index;
 
-    static constexpr u32 SIZE = 1024;
-    static constexpr u32 HEADER_SIZE = sizeof(u32) + sizeof(Index);
-    static constexpr u32 DATA_SIZE = SIZE - HEADER_SIZE;
+    static constexpr u32 MIN_SIZE = 4 * KiB;
+    static constexpr u32 MAX_SIZE = 16 * KiB;
+    static constexpr u32 DEFAULT_SIZE = 4 * KiB;
 
-    Block(Index index, u32 size_in_bytes, Index next_block, ByteBuffer data)
-        : m_index(index)
-        , m_size_in_bytes(size_in_bytes)
-        , m_next_block(next_block)
-        , m_data(move(data))
+    // Heap files before version 7 consist of 1 KiB blocks, each holding (part of) a single record.
+    static constexpr u32 LEGACY_SIZE = 1024;
+
+    static constexpr u32 SLOT_BITS = 8;
+    static constexpr u32 MAX_SLOTS = 1u << SLOT_BITS;
+
+    static constexpr Index index(u32 page, u32 slot) { return (page << SLOT_BITS) | slot; }
+    static constexpr u32 page(Index index) { return index >> SLOT_BITS; }
+    static constexpr u32 slot(Index index) { return index & (MAX_SLOTS - 1); }
+
+    static constexpr bool is_valid_size(u32 size) { return size >= MIN_SIZE && size <= MAX_SIZE && is_power_of_two(size); }
+};
+
+/**
+ * The contents of a page as read from a Heap. Pages are shared with the Heap's
+ * buffer pool instead of being copied for every read, so they never change; a
+ * modified page is a new Page. A page in the buffer pool that is referenced from
+ * elsewhere is pinned, and will not be evicted until it is released.
+ */
+class Page : public AtomicRefCounted<Page> {
+public:
+    static ErrorOr<NonnullRefPtr<Page>> create(ByteBuffer data)
+    {
+        return adopt_nonnull_ref_or_enomem(new (nothrow) Page(move(data)));
+    }
+
+    ReadonlyBytes bytes() const { return m_data.bytes(); }
+    u8 operator[](size_t index) const { return m_data[index]; }
+
+private:
+    explicit Page(ByteBuffer data)
+        : m_data(move(data))
+    {
+    }
+
+    ByteBuffer m_data;
+};
+
+/**
+ * Storage as read from a Heap. Storage that fits in its page is read in place,
+ * which keeps that page pinned for as long as the PinnedStorage is around;
+ * storage that spills into overflow pages is pieced together in a buffer of
+ * its own.
+ */
+class PinnedStorage {
+public:
+    PinnedStorage(NonnullRefPtr<Page const> page, ReadonlyBytes bytes_in_page)
+        : m_page(move(page))
+        , m_offset(bytes_in_page.data() - m_page->bytes().data())
+        , m_size(bytes_in_page.size())
     {
-        VERIFY(index > 0);
     }
 
-    Index index() const { return m_index; }
-    u32 size_in_bytes() const { return m_size_in_bytes; }
-    Index next_block() const { return m_next_block; }
-    ByteBuffer const& data() const { return m_data; }
+    explicit PinnedStorage(ByteBuffer data)
+        : m_data(move(data))
+    {
+    }
+
+    ReadonlyBytes bytes() const
+    {
+        if (m_page)
+            return m_page->bytes().slice(m_offset, m_size);
+        return m_data.bytes();
+    }
 
 private:
-    Index m_index;
-    u32 m_size_in_bytes;
-    Index m_next_block;
+    RefPtr<Page const> m_page;
+    size_t m_offset { 0 };
+    size_t m_size { 0 };
     ByteBuffer m_data;
 };
 
+/**
+ * Counters describing how well the Heap's buffer pool is doing. A hit is a
+ * block read that could be served from the pool instead of the file; reads of
+ * blocks modified by the current transaction are not counted.
+ */
+struct BufferPoolStatistics {
+    size_t capacity { 0 };
+    size_t cached_blocks { 0 };
+    size_t pinned_blocks { 0 };
+    u64 hits { 0 };
+    u64 misses { 0 };
+    u64 evictions { 0 };
+};
+
 /**
  * A Heap is a logical container for database (SQL) data. Conceptually a
  * Heap can be a database file, or a memory block, or another storage medium.
@@ -63,22 +133,62 @@ private:
  *
  * A Heap can be thought of the backing storage of a single database. It's
  * assumed that a single SQL database is backed by a single Heap.
+ *
+ * Storage is either given a page of its own with request_new_block_index(),
+ * which suits data that grows and shrinks by itself like B-tree nodes, or it is
+ * packed together with other small storage by insert_storage(), which suits
+ * table rows.
+ *
+ * Modified blocks are kept in memory until flush() commits them by appending
+ * them to the write-ahead log, a separate file next to the Heap's file. Every
+ * frame in the log is checksummed, and the last frame of a transaction is
+ * marked as its commit frame. Once the log grows large enough, its blocks are
+ * checkpointed back into the Heap's file. Upon opening, committed transactions
+ * found in the log are replayed into the Heap's file, and anything after the
+ * last intact commit frame is discarded.
+ *
+ * Heaps of an older version are opened read-only, so that their contents can
+ * be migrated to a new Heap.
+ *
+ * A snapshot of a Heap is a read-only Heap that keeps seeing the blocks as they
+ * were committed when the snapshot was created. Whenever a transaction commits
+ * a block that an open snapshot may still read, the snapshot is given a copy of
+ * the block's previous version first. Snapshots can be read from on other
+ * threads while the Heap they were taken from goes on committing transactions,
+ * which is also why a Heap's reference count is atomic.
  */
-class Heap : public RefCounted<Heap> {
+class Heap : public AtomicRefCounted<Heap> {
 public:
-    static constexpr u32 VERSION = 5;
+    static constexpr u32 VERSION = 7;
+    static constexpr u32 LEGACY_VERSION = 6;
+    static constexpr size_t DEFAULT_BUFFER_POOL_CAPACITY = 1024;
+    static constexpr size_t WAL_CHECKPOINT_THRESHOLD = 1024;
 
-    static ErrorOr<NonnullRefPtr<Heap>> create(ByteString);
+    static ErrorOr<NonnullRefPtr<Heap>> create(ByteString, u32 page_size = Block::DEFAULT_SIZE);
     virtual ~Heap();
 
     ByteString const& name() const { return m_name; }
+    ByteString wal_name() const { return ByteString::formatted("{}-wal", m_name); }
 
     ErrorOr<void> open();
     ErrorOr<size_t> file_size_in_bytes() const;
 
-    [[nodiscard]] bool has_block(Block::Index) const;
+    [[nodiscard]] bool has_block(Block::Index);
     [[nodiscard]] Block::Index request_new_block_index();
 
+    u32 page_size() const { return m_page_size; }
+
+    // The largest storage that fits in a page of its own without spilling into overflow pages.
+    u32 max_storage_size_in_page() const;
+
+    // A legacy Heap can only be read from; see Heap::LEGACY_VERSION.
+    bool is_legacy() const { return m_version == LEGACY_VERSION; }
+
+    // Creates a read-only view of the transactions committed so far; see above.
+    ErrorOr<NonnullRefPtr<Heap>> create_snapshot();
+    bool is_snapshot() const { return !m_snapshot_source.is_null(); }
+    bool is_read_only() const { return is_legacy() || is_snapshot(); }
+
     Block::Index schemas_root() const { return m_schemas_root; }
 
     void set_schemas_root(Block::Index root)
@@ -102,6 +212,14 @@ public:
         m_table_columns_root = root;
         update_zero_block().release_value_but_fixme_should_propagate_errors();
     }
+
+    Block::Index table_indexes_root() const { return m_table_indexes_root; }
+
+    void set_table_indexes_root(Block::Index root)
+    {
+        m_table_indexes_root = root;
+        update_zero_block().release_value_but_fixme_should_propagate_errors();
+    }
     u32 version() const { return m_version; }
 
     u32 user_value(size_t index) const
@@ -116,38 +234,112 @@ public:
     }
 
     ErrorOr<ByteBuffer> read_storage(Block::Index);
+    ErrorOr<PinnedStorage> read_pinned_storage(Block::Index);
+    ErrorOr<Block::Index> insert_storage(ReadonlyBytes);
     ErrorOr<void> write_storage(Block::Index, ReadonlyBytes);
     ErrorOr<void> free_storage(Block::Index);
 
     ErrorOr<void> flush();
+    ErrorOr<void> sync();
+    ErrorOr<void> checkpoint();
+
+    // With group commit enabled, flush() does not wait for the write-ahead log to hit the disk;
+    // the caller is expected to call sync() once for a batch of commits.
+    void set_group_commit(bool enabled) { m_group_commit = enabled; }
+    bool has_unsynced_commits() const { return m_has_unsynced_commits; }
+
+    BufferPoolStatistics buffer_pool_statistics() const;
+    void set_buffer_pool_capacity(size_t);
 
 private:
-    explicit Heap(ByteString);
+    Heap(ByteString, u32 page_size);
 
-    ErrorOr<ByteBuffer> read_raw_block(Block::Index);
-    ErrorOr<void> write_raw_block(Block::Index, ReadonlyBytes);
-    ErrorOr<void> write_raw_block_to_wal(Block::Index, ByteBuffer&&);
+    size_t wal_frame_size() const;
 
-    ErrorOr<Block> read_block(Block::Index);
-    ErrorOr<void> write_block(Block const&);
-    ErrorOr<void> free_block(Block const&);
+    ErrorOr<NonnullRefPtr<Page const>> read_raw_block(u32 page);
+    ErrorOr<ByteBuffer> read_raw_block_for_writing(u32 page);
+    ErrorOr<NonnullRefPtr<Page const>> read_committed_block(u32 page);
+    ErrorOr<NonnullRefPtr<Page const>> read_snapshot_block(Heap& snapshot, u32 page);
+    ErrorOr<void> preserve_blocks_for_snapshots(Vector<u32> const& pages);
+    ErrorOr<void> write_raw_block(u32 page, ReadonlyBytes);
+    ErrorOr<void> stage_raw_block(u32 page, ByteBuffer&&);
+    ErrorOr<ByteBuffer> read_wal_frame(size_t offset);
+    ErrorOr<void> recover_from_wal();
 
+    u32 allocate_page();
+    ErrorOr<void> free_page(u32 page);
+    ErrorOr<void> store_in_page(u32 page, ByteBuffer&, u16 slot, ReadonlyBytes);
+    ErrorOr<u32> write_overflow_pages(ReadonlyBytes);
+    ErrorOr<void> read_overflow_pages(u32 page, ByteBuffer&);
+    ErrorOr<void> free_overflow_pages(u32 page);
+    ErrorOr<ByteBuffer> read_legacy_storage(Block::Index);
+
+    RefPtr<Page const> cached_block(u32 page);
+    ErrorOr<void> cache_block(u32 page, NonnullRefPtr<Page const>);
+    void clear_buffer_pool();
+
+    ErrorOr<void> read_header();
     ErrorOr<void> read_zero_block();
     ErrorOr<void> initialize_zero_block();
     ErrorOr<void> update_zero_block();
 
     ByteString m_name;
 
+    // Guards everything that snapshots read from on other threads: the files, the write-ahead log
+    // offsets, the buffer pool, and the list of open snapshots along with their preserved blocks.
+    mutable Threading::Mutex m_lock;
+
     OwnPtr<Core::InputBufferedFile> m_file;
-    Block::Index m_highest_block_written { 0 };
-    Block::Index m_next_block { 1 };
+    int m_file_descriptor { -1 };
+    u32 m_page_size { Block::DEFAULT_SIZE };
+    u32 m_highest_block_written { 0 };
+    u32 m_next_block { 1 };
     Block::Index m_schemas_root { 0 };
     Block::Index m_tables_root { 0 };
     Block::Index m_table_columns_root { 0 };
+    Block::Index m_table_indexes_root { 0 };
     u32 m_version { VERSION };
     Array<u32, 16> m_user_values { 0 };
-    HashMap<Block::Index, ByteBuffer> m_write_ahead_log;
-    Vector<Block::Index> m_free_block_indices;
+    Vector<u32> m_free_pages;
+
+    // Pages that insert_storage() packs storage into, and that may have room for more.
+    Vector<u32> m_shared_pages_with_free_space;
+
+    // Blocks modified by the current transaction.
+    HashMap<u32, NonnullRefPtr<Page const>> m_dirty_blocks;
+
+    // Committed blocks in the write-ahead log that have not been checkpointed yet, and where
+    // their latest version starts in the log.
+    OwnPtr<Core::File> m_wal_file;
+    HashMap<u32, size_t> m_wal_frame_offsets;
+    size_t m_wal_size { 0 };
+    bool m_group_commit { false };
+    bool m_has_unsynced_commits { false };
+
+    // Committed blocks read from or written to disk, evicted with the CLOCK algorithm. Frames whose
+    // page is still referenced outside of the pool are pinned, and passed over by the clock hand.
+    struct BufferPoolFrame {
+        u32 index { 0 };
+        NonnullRefPtr<Page const> page;
+        bool referenced { false };
+
+        bool is_pinned() const { return page->ref_count() > 1; }
+    };
+    Vector<BufferPoolFrame> m_buffer_pool;
+    HashMap<u32, size_t> m_buffer_pool_frames;
+    size_t m_buffer_pool_capacity { DEFAULT_BUFFER_POOL_CAPACITY };
+    size_t m_buffer_pool_clock_hand { 0 };
+    u64 m_buffer_pool_hits { 0 };
+    u64 m_buffer_pool_misses { 0 };
+    u64 m_buffer_pool_evictions { 0 };
+
+    // The snapshots taken of this Heap that are still open.
+    Vector<Heap*> m_snapshots;
+
+    // For a snapshot, the Heap it was taken from, and the versions of blocks that were committed
+    // to that Heap after the snapshot was created, as they were before.
+    RefPtr<Heap> m_snapshot_source;
+    HashMap<u32, NonnullRefPtr<Page const>> m_snapshot_blocks;
 };
 
 }
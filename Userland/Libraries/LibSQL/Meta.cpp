@@ -88,6 +88,13 @@ Key ColumnDef::make_key(TableDef const& table_def)
     return key;
 }
 
+Key ColumnDef::make_key(IndexDef const& index)
+{
+    Key key(index_def());
+    key["table_hash"] = index.hash();
+    return key;
+}
+
 NonnullRefPtr<IndexDef> ColumnDef::index_def()
 {
     NonnullRefPtr<IndexDef> s_index_def = IndexDef::create("$column", true, 0).release_value_but_fixme_should_propagate_errors();
@@ -214,6 +221,12 @@ void TableDef::append_column(Key const& column)
     append_column(column["column_name"].to_byte_string(), static_cast<SQLType>(*column_type));
 }
 
+void TableDef::append_index(NonnullRefPtr<IndexDef> index)
+{
+    VERIFY(index->parent() == this);
+    m_indexes.append(move(index));
+}
+
 Key TableDef::make_key(SchemaDef const& schema_def)
 {
     return TableDef::make_key(schema_def.key());
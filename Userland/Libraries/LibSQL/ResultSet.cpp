@@ -4,35 +4,35 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/QuickSort.h>
 #include <LibSQL/ResultSet.h>
 
 namespace SQL {
 
-size_t ResultSet::binary_search(Tuple const& sort_key, size_t low, size_t high)
+void ResultSet::insert_row(Tuple const& row, Tuple const& sort_key)
 {
-    if (high <= low) {
-        auto compare = sort_key.compare(at(low).sort_key);
-        return (compare > 0) ? low + 1 : low;
-    }
-
-    auto mid = (low + high) / 2;
-    auto compare = sort_key.compare(at(mid).sort_key);
-    if (compare == 0)
-        return mid + 1;
-
-    if (compare > 0)
-        return binary_search(sort_key, mid + 1, high);
-    return binary_search(sort_key, low, mid);
+    empend(row, sort_key);
 }
 
-void ResultSet::insert_row(Tuple const& row, Tuple const& sort_key)
+void ResultSet::sort()
 {
-    if ((sort_key.size() == 0) || is_empty()) {
-        empend(row, sort_key);
-        return;
-    }
-    auto ix = binary_search(sort_key, 0, size() - 1);
-    insert(ix, ResultRow { row, sort_key });
+    // Sort a permutation rather than the rows themselves, so that every row is copied only once.
+    Vector<size_t> order;
+    order.ensure_capacity(size());
+    for (size_t ix = 0; ix < size(); ++ix)
+        order.unchecked_append(ix);
+
+    quick_sort(order, [&](size_t a, size_t b) {
+        auto compare = at(a).sort_key.compare(at(b).sort_key);
+        return compare < 0 || (compare == 0 && a < b);
+    });
+
+    Vector<ResultRow> sorted;
+    sorted.ensure_capacity(size());
+    for (auto ix : order)
+        sorted.unchecked_append(at(ix));
+
+    Vector<ResultRow>::operator=(move(sorted));
 }
 
 void ResultSet::limit(size_t offset, size_t limit)
@@ -37,9 +37,10 @@ public:
     void insert_row(Tuple const& row, Tuple const& sort_key);
     void limit(size_t offset, size_t limit);
 
-private:
-    size_t binary_search(Tuple const& sort_key, size_t low, size_t high);
+    // Orders the rows by their sort keys. Rows with equal sort keys keep the order they were inserted in.
+    void sort();
 
+private:
     SQLCommand m_command { SQLCommand::Unknown };
     Vector<ByteString> m_column_names;
 };
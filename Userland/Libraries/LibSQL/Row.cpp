@@ -18,14 +18,21 @@ Row::Row(NonnullRefPtr<TableDef> table, Block::Index block_index)
 
 void Row::deserialize(Serializer& serializer)
 {
-    Tuple::deserialize(serializer);
-    m_next_block_index = serializer.deserialize<Block::Index>();
+    if (serializer.is_legacy()) {
+        Tuple::deserialize(serializer);
+        m_next_block_index = serializer.deserialize<Block::Index>();
+        return;
+    }
+
+    deserialize_values(serializer);
+    m_next_block_index = serializer.deserialize_varint();
 }
 
 void Row::serialize(Serializer& serializer) const
 {
-    Tuple::serialize(serializer);
-    serializer.serialize<Block::Index>(next_block_index());
+    // The row's own block index is where it's stored, so it doesn't need to be stored itself.
+    serialize_values(serializer);
+    serializer.serialize_varint(next_block_index());
 }
 
 }
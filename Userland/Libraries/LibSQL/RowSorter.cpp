@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibSQL/RowSorter.h>
+#include <LibSQL/Serializer.h>
+
+namespace SQL {
+
+RowSorter::RowSorter(Optional<size_t> limit, size_t memory_budget)
+    : m_limit(limit)
+    , m_memory_budget(memory_budget)
+{
+}
+
+RowSorter::~RowSorter() = default;
+
+ErrorOr<void> RowSorter::append(Tuple const& row, Tuple const& sort_key)
+{
+    VERIFY(!m_is_finished);
+    auto row_size = row.length() + sort_key.length();
+
+    if (m_limit.has_value()) {
+        if (m_top_rows.size() == *m_limit) {
+            if (m_top_rows.is_empty())
+                return {};
+
+            // Rows that compare equal to the worst row kept so far come after it, so they can be dropped too.
+            auto const& worst = m_top_rows.peek_min();
+            if (sort_key.compare(worst->sort_key) >= 0)
+                return {};
+
+            auto evicted = m_top_rows.pop_min();
+            m_memory_used -= evicted->row.length() + evicted->sort_key.length();
+        }
+
+        m_top_rows.insert(TRY(adopt_nonnull_own_or_enomem(new (nothrow) TopRow { row, sort_key, m_sequence++ })));
+        m_memory_used += row_size;
+
+        if (m_memory_used > m_memory_budget)
+            stop_keeping_top_rows();
+        return {};
+    }
+
+    TRY(m_rows.try_empend(row, sort_key));
+    m_memory_used += row_size;
+
+    if (m_memory_used > m_memory_budget)
+        TRY(spill());
+    return {};
+}
+
+void RowSorter::stop_keeping_top_rows()
+{
+    // The limit is so large that the rows kept don't fit the budget anyway, so fall back to sorting
+    // everything. The rows are moved over best-first, which keeps the sort stable.
+    Vector<NonnullOwnPtr<TopRow>> top_rows;
+    top_rows.ensure_capacity(m_top_rows.size());
+    while (!m_top_rows.is_empty())
+        top_rows.unchecked_append(m_top_rows.pop_min());
+
+    m_rows.ensure_capacity(top_rows.size());
+    for (size_t ix = top_rows.size(); ix > 0; --ix)
+        m_rows.unchecked_append({ top_rows[ix - 1]->row, top_rows[ix - 1]->sort_key });
+
+    m_limit.clear();
+}
+
+ErrorOr<void> RowSorter::spill()
+{
+    m_rows.sort();
+    TRY(m_runs.try_append(TRY(Run::create(m_rows, m_runs.size()))));
+
+    m_rows.clear();
+    m_memory_used = 0;
+    return {};
+}
+
+ErrorOr<void> RowSorter::finish()
+{
+    VERIFY(!m_is_finished);
+    m_is_finished = true;
+
+    if (m_limit.has_value()) {
+        TRY(m_rows.try_ensure_capacity(m_top_rows.size()));
+        m_rows.resize(m_top_rows.size());
+
+        for (size_t ix = m_top_rows.size(); ix > 0; --ix) {
+            auto top_row = m_top_rows.pop_min();
+            m_rows[ix - 1] = { move(top_row->row), move(top_row->sort_key) };
+        }
+        return {};
+    }
+
+    if (m_runs.is_empty()) {
+        m_rows.sort();
+        return {};
+    }
+
+    if (!m_rows.is_empty())
+        TRY(spill());
+
+    for (auto& run : m_runs) {
+        TRY(run->open());
+        if (run->current().has_value())
+            m_merge.insert(run.ptr());
+    }
+
+    return {};
+}
+
+ErrorOr<Optional<Tuple>> RowSorter::next()
+{
+    VERIFY(m_is_finished);
+
+    if (m_runs.is_empty()) {
+        if (m_next_row >= m_rows.size())
+            return Optional<Tuple> {};
+        return move(m_rows[m_next_row++].row);
+    }
+
+    if (m_merge.is_empty())
+        return Optional<Tuple> {};
+
+    auto* run = m_merge.pop_min();
+    auto row = run->current()->row;
+
+    TRY(run->advance());
+    if (run->current().has_value())
+        m_merge.insert(run);
+
+    return row;
+}
+
+void RowSorter::reset()
+{
+    m_top_rows.clear();
+    m_rows.clear();
+    m_merge.clear();
+    m_runs.clear();
+    m_memory_used = 0;
+    m_sequence = 0;
+    m_next_row = 0;
+    m_is_finished = false;
+}
+
+RowSorter::Run::Run(NonnullOwnPtr<FileSystem::TempFile> file, size_t row_count, size_t index)
+    : m_file(move(file))
+    , m_row_count(row_count)
+    , m_index(index)
+{
+}
+
+ErrorOr<NonnullOwnPtr<RowSorter::Run>> RowSorter::Run::create(ResultSet const& rows, size_t index)
+{
+    auto file = TRY(FileSystem::TempFile::create_temp_file());
+    auto stream = TRY(Core::OutputBufferedFile::create(TRY(Core::File::open(file->path(), Core::File::OpenMode::Write | Core::File::OpenMode::Truncate))));
+
+    for (auto const& row : rows) {
+        Serializer serializer;
+        serializer.serialize<Tuple>(row.row);
+        serializer.serialize<Tuple>(row.sort_key);
+
+        TRY(stream->write_value<u32>(serializer.bytes().size()));
+        TRY(stream->write_until_depleted(serializer.bytes()));
+    }
+
+    TRY(stream->flush_buffer());
+    return adopt_nonnull_own_or_enomem(new (nothrow) Run(move(file), rows.size(), index));
+}
+
+ErrorOr<void> RowSorter::Run::open()
+{
+    m_stream = TRY(Core::InputBufferedFile::create(TRY(Core::File::open(m_file->path(), Core::File::OpenMode::Read))));
+    m_rows_read = 0;
+    return advance();
+}
+
+ErrorOr<void> RowSorter::Run::advance()
+{
+    if (m_rows_read == m_row_count) {
+        m_current.clear();
+        m_stream.clear();
+        return {};
+    }
+
+    auto size = TRY(m_stream->read_value<u32>());
+    auto buffer = TRY(ByteBuffer::create_uninitialized(size));
+    TRY(m_stream->read_until_filled(buffer));
+
+    Serializer serializer { move(buffer) };
+    auto row = serializer.deserialize<Tuple>();
+    auto sort_key = serializer.deserialize<Tuple>();
+    m_current = ResultRow { move(row), move(sort_key) };
+
+    ++m_rows_read;
+    return {};
+}
+
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/BinaryHeap.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <LibCore/File.h>
+#include <LibFileSystem/TempFile.h>
+#include <LibSQL/ResultSet.h>
+#include <LibSQL/Tuple.h>
+
+namespace SQL {
+
+/**
+ * A RowSorter orders rows by a sort key, for ORDER BY. Rows are appended, the sorter is finished
+ * once, and the rows are then read back in order. Rows with equal sort keys come out in the order
+ * they were appended in.
+ *
+ * If only the first `limit` rows will be read, the sorter keeps just those in a bounded heap.
+ * Otherwise rows are buffered until their estimated size exceeds the memory budget, at which point
+ * the buffered rows are sorted and spilled to a temporary file as a run. Spilled runs are merged
+ * while the rows are read back.
+ */
+class RowSorter {
+    AK_MAKE_NONCOPYABLE(RowSorter);
+    AK_MAKE_NONMOVABLE(RowSorter);
+
+public:
+    static constexpr size_t default_memory_budget = 64 * MiB;
+
+    explicit RowSorter(Optional<size_t> limit = {}, size_t memory_budget = default_memory_budget);
+    ~RowSorter();
+
+    ErrorOr<void> append(Tuple const& row, Tuple const& sort_key);
+    ErrorOr<void> finish();
+    ErrorOr<Optional<Tuple>> next();
+    void reset();
+
+    [[nodiscard]] size_t spilled_run_count() const { return m_runs.size(); }
+
+private:
+    struct TopRow {
+        Tuple row;
+        Tuple sort_key;
+        size_t sequence { 0 };
+    };
+
+    class Run {
+    public:
+        static ErrorOr<NonnullOwnPtr<Run>> create(ResultSet const& rows, size_t index);
+
+        ErrorOr<void> open();
+        ErrorOr<void> advance();
+
+        [[nodiscard]] Optional<ResultRow> const& current() const { return m_current; }
+        [[nodiscard]] size_t index() const { return m_index; }
+
+    private:
+        Run(NonnullOwnPtr<FileSystem::TempFile>, size_t row_count, size_t index);
+
+        NonnullOwnPtr<FileSystem::TempFile> m_file;
+        OwnPtr<Core::InputBufferedFile> m_stream;
+        size_t m_row_count { 0 };
+        size_t m_rows_read { 0 };
+        size_t m_index { 0 };
+        Optional<ResultRow> m_current;
+    };
+
+    struct WorstTopRowFirst {
+        bool operator()(NonnullOwnPtr<TopRow> const& a, NonnullOwnPtr<TopRow> const& b) const
+        {
+            auto compare = a->sort_key.compare(b->sort_key);
+            return compare > 0 || (compare == 0 && a->sequence > b->sequence);
+        }
+    };
+
+    struct SmallestRunFirst {
+        bool operator()(Run* a, Run* b) const
+        {
+            auto compare = a->current()->sort_key.compare(b->current()->sort_key);
+            return compare < 0 || (compare == 0 && a->index() < b->index());
+        }
+    };
+
+    struct IgnoreHeapIndex {
+        template<typename T>
+        void operator()(T const&, size_t) const { }
+    };
+
+    ErrorOr<void> spill();
+    void stop_keeping_top_rows();
+
+    Optional<size_t> m_limit;
+    size_t m_memory_budget { default_memory_budget };
+    size_t m_memory_used { 0 };
+    size_t m_sequence { 0 };
+    bool m_is_finished { false };
+
+    // The worst of the rows kept so far is at the top, so it's the one that gets evicted.
+    IntrusiveBinaryHeap<NonnullOwnPtr<TopRow>, WorstTopRowFirst, IgnoreHeapIndex> m_top_rows;
+
+    ResultSet m_rows { SQLCommand::Select };
+    size_t m_next_row { 0 };
+
+    Vector<NonnullOwnPtr<Run>> m_runs;
+    IntrusiveBinaryHeap<Run*, SmallestRunFirst, IgnoreHeapIndex> m_merge;
+};
+
+}
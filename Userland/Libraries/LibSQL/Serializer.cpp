@@ -10,14 +10,14 @@ namespace SQL {
 
 void Serializer::serialize(ByteString const& text)
 {
-    serialize<u32>(text.length());
+    serialize_varint(text.length());
     if (!text.is_empty())
         write((u8 const*)text.characters(), text.length());
 }
 
 void Serializer::deserialize_to(ByteString& text)
 {
-    auto length = deserialize<u32>();
+    auto length = is_legacy() ? deserialize<u32>() : deserialize_varint();
     if (length > 0) {
         text = ByteString(reinterpret_cast<char const*>(read(length)), length);
     } else {
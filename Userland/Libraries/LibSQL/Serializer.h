@@ -24,15 +24,24 @@ public:
     {
     }
 
+    // Deserializes from a buffer that didn't come from a heap, e.g. a sort run spilled to disk.
+    explicit Serializer(ByteBuffer buffer)
+        : m_buffer(move(buffer))
+    {
+    }
+
     void read_storage(Block::Index block_index)
     {
-        m_buffer = m_heap->read_storage(block_index).release_value_but_fixme_should_propagate_errors();
+        // Deserialize straight out of the heap's buffer pool; the page stays pinned until we move on.
+        m_buffer.clear();
+        m_storage = m_heap->read_pinned_storage(block_index).release_value_but_fixme_should_propagate_errors();
         m_current_offset = 0;
     }
 
     void reset()
     {
         m_buffer.clear();
+        m_storage.clear();
         m_current_offset = 0;
     }
 
@@ -66,6 +75,23 @@ public:
 
     void deserialize_to(ByteString& text);
 
+    ReadonlyBytes deserialize_bytes(size_t length)
+    {
+        return { read(length), length };
+    }
+
+    u64 deserialize_varint()
+    {
+        u64 value = 0;
+        for (size_t shift = 0;; shift += 7) {
+            VERIFY(shift < 64);
+            auto byte = *read(1);
+            value |= static_cast<u64>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+    }
+
     template<typename T, typename... Args>
     NonnullOwnPtr<T> make_and_deserialize(Args&&... args)
     {
@@ -101,6 +127,23 @@ public:
 
     void serialize(ByteString const&);
 
+    void serialize_bytes(ReadonlyBytes bytes)
+    {
+        write(bytes.data(), bytes.size());
+    }
+
+    // Unsigned LEB128: 7 bits per byte, least significant first, with the high bit set on all but the last byte.
+    void serialize_varint(u64 value)
+    {
+        while (value >= 0x80) {
+            u8 byte = (value & 0x7f) | 0x80;
+            write(&byte, 1);
+            value >>= 7;
+        }
+        u8 byte = value;
+        write(&byte, 1);
+    }
+
     template<typename T>
     bool serialize_and_write(T const& t)
     {
@@ -111,17 +154,44 @@ public:
         return true;
     }
 
+    // Like serialize_and_write(), but doesn't write anything if the serialized data would be longer than max_length.
+    template<typename T>
+    bool serialize_and_write(T const& t, size_t max_length)
+    {
+        VERIFY(!m_heap.is_null());
+        reset();
+        serialize<T>(t);
+        if (m_buffer.size() > max_length)
+            return false;
+        m_heap->write_storage(t.block_index(), m_buffer).release_value_but_fixme_should_propagate_errors();
+        return true;
+    }
+
+    // Stores the serialized data in a new block index, packed together with other small data.
+    template<typename T>
+    ErrorOr<Block::Index> serialize_and_insert(T const& t)
+    {
+        VERIFY(!m_heap.is_null());
+        reset();
+        serialize<T>(t);
+        return m_heap->insert_storage(m_buffer);
+    }
+
     [[nodiscard]] size_t offset() const { return m_current_offset; }
+    [[nodiscard]] ReadonlyBytes bytes() const { return m_storage.has_value() ? m_storage->bytes() : m_buffer.bytes(); }
     u32 request_new_block_index()
     {
         return m_heap->request_new_block_index();
     }
 
-    bool has_block(u32 pointer) const
+    bool has_block(u32 pointer)
     {
         return m_heap->has_block(pointer);
     }
 
+    // Data read from a legacy heap is in the format from before Heap::VERSION 7.
+    [[nodiscard]] bool is_legacy() const { return m_heap && m_heap->is_legacy(); }
+
     Heap& heap()
     {
         return *m_heap;
@@ -132,13 +202,14 @@ private:
     {
         if constexpr (SQL_DEBUG)
             dump(ptr, sz, "(out) =>");
+        VERIFY(!m_storage.has_value());
         m_buffer.append(ptr, sz);
         m_current_offset += sz;
     }
 
     u8 const* read(size_t sz)
     {
-        auto buffer_ptr = m_buffer.offset_pointer(m_current_offset);
+        auto buffer_ptr = bytes().offset_pointer(m_current_offset);
         if constexpr (SQL_DEBUG)
             dump(buffer_ptr, sz, "<= (in)");
         m_current_offset += sz;
@@ -159,6 +230,7 @@ private:
     }
 
     ByteBuffer m_buffer {};
+    Optional<PinnedStorage> m_storage;
     size_t m_current_offset { 0 };
     // FIXME: make this a NonnullRefPtr<Heap> so we can get rid of the null checks
     RefPtr<Heap> m_heap { nullptr };
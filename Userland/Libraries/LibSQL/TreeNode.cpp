@@ -103,50 +103,109 @@ TreeNode::TreeNode(BTree& tree, TreeNode* up, TreeNode* left, Block::Index block
 
 void TreeNode::deserialize(Serializer& serializer)
 {
-    auto nodes = serializer.deserialize<u32>();
+    m_entries.clear();
+    m_down.clear();
+    if (serializer.is_legacy()) {
+        deserialize_legacy(serializer);
+        return;
+    }
+
+    auto nodes = serializer.deserialize_varint();
     dbgln_if(SQL_DEBUG, "Deserializing node. Size {}", nodes);
-    if (nodes > 0) {
-        for (u32 i = 0; i < nodes; i++) {
-            auto left = serializer.deserialize<u32>();
-            dbgln_if(SQL_DEBUG, "Down[{}] {}", i, left);
-            if (!m_down.is_empty())
-                VERIFY((left == 0) == m_is_leaf);
-            else
-                m_is_leaf = (left == 0);
-            m_entries.append(serializer.deserialize<Key>(m_tree.descriptor()));
-            m_down.empend(this, left);
-        }
-        auto right = serializer.deserialize<u32>();
-        dbgln_if(SQL_DEBUG, "Right {}", right);
-        VERIFY((right == 0) == m_is_leaf);
-        m_down.empend(this, right);
+    if (nodes == 0) {
+        m_is_leaf = true;
+        m_down.empend(this, nullptr);
+        return;
     }
+
+    m_is_leaf = serializer.deserialize<u8>() != 0;
+    ByteBuffer key_bytes;
+    for (u32 i = 0; i < nodes; i++) {
+        auto left = m_is_leaf ? 0u : static_cast<Block::Index>(serializer.deserialize_varint());
+        dbgln_if(SQL_DEBUG, "Down[{}] {}", i, left);
+        auto pointer = static_cast<Block::Index>(serializer.deserialize_varint());
+
+        // Keys are stored as the number of bytes they share with the previous key, followed by the bytes that differ.
+        auto shared_length = serializer.deserialize_varint();
+        auto suffix_length = serializer.deserialize_varint();
+        VERIFY(shared_length <= key_bytes.size());
+        key_bytes.resize(shared_length);
+        key_bytes.append(serializer.deserialize_bytes(suffix_length));
+
+        Key key { m_tree.descriptor() };
+        Serializer key_serializer { MUST(ByteBuffer::copy(key_bytes)) };
+        key.deserialize_values(key_serializer);
+        key.set_block_index(pointer);
+        m_entries.append(move(key));
+        m_down.empend(this, left);
+    }
+
+    auto right = m_is_leaf ? 0u : static_cast<Block::Index>(serializer.deserialize_varint());
+    dbgln_if(SQL_DEBUG, "Right {}", right);
+    m_down.empend(this, right);
+}
+
+void TreeNode::deserialize_legacy(Serializer& serializer)
+{
+    auto nodes = serializer.deserialize<u32>();
+    dbgln_if(SQL_DEBUG, "Deserializing legacy node. Size {}", nodes);
+    if (nodes == 0) {
+        m_is_leaf = true;
+        m_down.empend(this, nullptr);
+        return;
+    }
+
+    for (u32 i = 0; i < nodes; i++) {
+        auto left = serializer.deserialize<u32>();
+        dbgln_if(SQL_DEBUG, "Down[{}] {}", i, left);
+        if (!m_down.is_empty())
+            VERIFY((left == 0) == m_is_leaf);
+        else
+            m_is_leaf = (left == 0);
+        m_entries.append(serializer.deserialize<Key>(m_tree.descriptor()));
+        m_down.empend(this, left);
+    }
+    auto right = serializer.deserialize<u32>();
+    dbgln_if(SQL_DEBUG, "Right {}", right);
+    VERIFY((right == 0) == m_is_leaf);
+    m_down.empend(this, right);
 }
 
 void TreeNode::serialize(Serializer& serializer) const
 {
-    u32 sz = size();
-    serializer.serialize<u32>(sz);
-    if (sz > 0) {
-        for (auto ix = 0u; ix < size(); ix++) {
-            auto& entry = m_entries[ix];
+    serializer.serialize_varint(size());
+    if (size() == 0)
+        return;
+
+    serializer.serialize<u8>(is_leaf() ? 1 : 0);
+    ByteBuffer previous_key_bytes;
+    for (auto ix = 0u; ix < size(); ix++) {
+        auto& entry = m_entries[ix];
+        if (!is_leaf()) {
             dbgln_if(SQL_DEBUG, "Serializing Left[{}] = {}", ix, m_down[ix].block_index());
-            serializer.serialize<u32>(is_leaf() ? 0u : m_down[ix].block_index());
-            serializer.serialize<Key>(entry);
+            serializer.serialize_varint(m_down[ix].block_index());
         }
-        dbgln_if(SQL_DEBUG, "Serializing Right = {}", m_down[size()].block_index());
-        serializer.serialize<u32>(is_leaf() ? 0u : m_down[size()].block_index());
+        serializer.serialize_varint(entry.block_index());
+
+        Serializer key_serializer;
+        entry.serialize_values(key_serializer);
+        auto key_bytes = key_serializer.bytes();
+
+        size_t shared_length = 0;
+        auto max_shared_length = min(key_bytes.size(), previous_key_bytes.size());
+        while (shared_length < max_shared_length && key_bytes[shared_length] == previous_key_bytes[shared_length])
+            ++shared_length;
+
+        serializer.serialize_varint(shared_length);
+        serializer.serialize_varint(key_bytes.size() - shared_length);
+        serializer.serialize_bytes(key_bytes.slice(shared_length));
+        previous_key_bytes = MUST(ByteBuffer::copy(key_bytes));
     }
-}
 
-size_t TreeNode::length() const
-{
-    if (!size())
-        return 0;
-    size_t len = sizeof(u32);
-    for (auto& key : m_entries)
-        len += sizeof(u32) + key.length();
-    return len;
+    if (!is_leaf()) {
+        dbgln_if(SQL_DEBUG, "Serializing Right = {}", m_down[size()].block_index());
+        serializer.serialize_varint(m_down[size()].block_index());
+    }
 }
 
 bool TreeNode::insert(Key const& key)
@@ -178,6 +237,122 @@ bool TreeNode::update_key_pointer(Key const& key)
     return false;
 }
 
+bool TreeNode::remove(Key const& key)
+{
+    dbgln_if(SQL_DEBUG, "[#{}] REMOVE({}, {})", block_index(), key.to_byte_string(), key.block_index());
+
+    // Keys equal to the one we're looking for can be on either side of an equal key in a non-leaf
+    // node when duplicates are allowed, so we have to look at all of them.
+    for (auto ix = 0u; ix < size(); ix++) {
+        auto compare = key.compare(m_entries[ix]);
+        if (compare > 0)
+            continue;
+
+        if (!is_leaf() && down_node(ix)->remove(key))
+            return true;
+        if (compare < 0)
+            return false;
+
+        if (m_entries[ix].block_index() == key.block_index()) {
+            remove_entry(ix);
+            return true;
+        }
+    }
+
+    if (!is_leaf())
+        return down_node(size())->remove(key);
+    return false;
+}
+
+// Note that this may take this node out of the tree and destroy it.
+void TreeNode::remove_entry(size_t ix)
+{
+    if (!is_leaf()) {
+        // The key separates two subtrees, so the largest key of the subtree on its left takes its place.
+        auto* leaf = down_node(ix);
+        while (!leaf->is_leaf())
+            leaf = leaf->down_node(leaf->size());
+        VERIFY(leaf->size() > 0);
+        m_entries[ix] = leaf->m_entries.last();
+        dump_if(SQL_DEBUG, "To WAL");
+        tree().serializer().serialize_and_write<TreeNode>(*this);
+        leaf->remove_entry(leaf->size() - 1);
+        return;
+    }
+
+    m_entries.remove(ix);
+    m_down.take_last();
+    if (size() > 0 || !m_up) {
+        dump_if(SQL_DEBUG, "To WAL");
+        tree().serializer().serialize_and_write<TreeNode>(*this);
+        return;
+    }
+
+    // Only the root is allowed to run out of keys.
+    m_up->remove_empty_child(block_index());
+}
+
+// Takes an empty child out of this node, along with a key next to it, which moves into the child's
+// sibling instead. Nodes aren't merged otherwise. Note that this may destroy this node as well.
+void TreeNode::remove_empty_child(Block::Index child_block_index)
+{
+    VERIFY(!is_leaf());
+    auto child_index = m_down.find_first_index_if([&](auto const& down) { return down.block_index() == child_block_index; });
+    VERIFY(child_index.has_value());
+
+    auto& tree = m_tree;
+    MUST(tree.serializer().heap().free_storage(child_block_index));
+
+    // The separator goes to the first leaf of the sibling on the right, or the last leaf of the one on the left.
+    Key separator { tree.descriptor() };
+    TreeNode* sibling_leaf = nullptr;
+    bool prepend_separator = *child_index < size();
+    if (prepend_separator) {
+        separator = m_entries.take(*child_index);
+        m_down.remove(*child_index);
+        for (sibling_leaf = down_node(*child_index); !sibling_leaf->is_leaf(); sibling_leaf = sibling_leaf->down_node(0))
+            ;
+    } else {
+        separator = m_entries.take(*child_index - 1);
+        m_down.remove(*child_index);
+        for (sibling_leaf = down_node(*child_index - 1); !sibling_leaf->is_leaf(); sibling_leaf = sibling_leaf->down_node(sibling_leaf->size()))
+            ;
+    }
+
+    if (size() > 0) {
+        dump_if(SQL_DEBUG, "To WAL");
+        tree.serializer().serialize_and_write<TreeNode>(*this);
+    } else {
+        // This node is down to a single child, which takes its place.
+        m_down[0].deserialize(tree.serializer());
+        auto child = move(m_down[0].m_node);
+        MUST(tree.serializer().heap().free_storage(block_index()));
+
+        if (!m_up) {
+            child->m_up = nullptr;
+            tree.replace_root(child.release_nonnull());
+        } else {
+            auto* up = m_up;
+            auto index_in_up = up->m_down.find_first_index_if([&](auto const& down) { return down.block_index() == block_index(); });
+            VERIFY(index_in_up.has_value());
+            child->m_up = up;
+            up->m_down.remove(*index_in_up);
+            up->m_down.insert(*index_in_up, DownPointer(up, child.leak_ptr()));
+            up->dump_if(SQL_DEBUG, "To WAL");
+            tree.serializer().serialize_and_write<TreeNode>(*up);
+        }
+    }
+
+    // Nothing of this node may be used from here on.
+    if (prepend_separator) {
+        sibling_leaf->m_entries.prepend(move(separator));
+    } else {
+        sibling_leaf->m_entries.append(move(separator));
+    }
+    sibling_leaf->m_down.empend(sibling_leaf, nullptr);
+    sibling_leaf->write_or_split();
+}
+
 bool TreeNode::insert_in_leaf(Key const& key)
 {
     VERIFY(is_leaf());
@@ -247,8 +422,10 @@ Optional<u32> TreeNode::get(Key& key)
         }
     }
     if (m_entries.is_empty()) {
-        dbgln_if(SQL_DEBUG, "[#{}] {} Empty node??", block_index(), key.to_byte_string());
-        VERIFY_NOT_REACHED();
+        // Only the root runs out of keys, once all of them have been removed.
+        dbgln_if(SQL_DEBUG, "[#{}] {} Empty root", block_index(), key.to_byte_string());
+        VERIFY(!m_up && is_leaf());
+        return {};
     }
     if (is_leaf()) {
         dbgln_if(SQL_DEBUG, "[#{}] {} > {} -> 0",
@@ -271,24 +448,30 @@ void TreeNode::just_insert(Key const& key, TreeNode* right)
             m_entries.insert(ix, key);
             VERIFY(is_leaf() == (right == nullptr));
             m_down.insert(ix + 1, DownPointer(this, right));
-            if (length() > Block::DATA_SIZE) {
-                split();
-            } else {
-                dump_if(SQL_DEBUG, "To WAL");
-                tree().serializer().serialize_and_write(*this);
-            }
+            write_or_split();
             return;
         }
     }
     m_entries.append(key);
     m_down.empend(this, right);
+    write_or_split();
+}
 
-    if (length() > Block::DATA_SIZE) {
-        split();
-    } else {
+void TreeNode::write_or_split()
+{
+    // Nodes are kept small enough to fit in their page, so that reading a node takes a single page read. A node with
+    // too few keys to split is left to spill into overflow pages.
+    auto& serializer = tree().serializer();
+    if (size() < 3) {
         dump_if(SQL_DEBUG, "To WAL");
-        tree().serializer().serialize_and_write(*this);
+        serializer.serialize_and_write(*this);
+        return;
     }
+
+    if (serializer.serialize_and_write(*this, serializer.heap().max_storage_size_in_page()))
+        dump_if(SQL_DEBUG, "To WAL");
+    else
+        split();
 }
 
 void TreeNode::split()
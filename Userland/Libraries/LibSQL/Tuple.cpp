@@ -60,6 +60,23 @@ void Tuple::serialize(Serializer& serializer) const
     }
 }
 
+void Tuple::serialize_values(Serializer& serializer) const
+{
+    serializer.serialize_varint(m_data.size());
+    for (auto const& value : m_data)
+        serializer.serialize<Value>(value);
+}
+
+void Tuple::deserialize_values(Serializer& serializer)
+{
+    auto number_of_elements = serializer.deserialize_varint();
+    VERIFY(number_of_elements == m_descriptor->size());
+    m_data.clear_with_capacity();
+    m_data.ensure_capacity(number_of_elements);
+    for (auto ix = 0u; ix < number_of_elements; ++ix)
+        m_data.unchecked_append(serializer.deserialize<Value>());
+}
+
 Tuple::Tuple(Tuple const& other)
     : m_descriptor(other.m_descriptor)
     , m_data()
@@ -68,6 +68,10 @@ public:
 
     [[nodiscard]] Vector<Value> take_data() { return move(m_data); }
 
+    // Serializes just the values, for storage that knows the descriptor of its tuples, like table rows and index keys.
+    void serialize_values(Serializer&) const;
+    void deserialize_values(Serializer&);
+
 protected:
     [[nodiscard]] Optional<size_t> index_of(StringView) const;
     void copy_from(Tuple const&);
@@ -15,6 +15,8 @@ namespace TLS {
 struct SignatureAndHashAlgorithm {
     HashAlgorithm hash;
     SignatureAlgorithm signature;
+
+    bool operator==(SignatureAndHashAlgorithm const&) const = default;
 };
 
 enum class KeyExchangeAlgorithm {
@@ -34,6 +36,8 @@ enum class KeyExchangeAlgorithm {
     ECDH_RSA,
     ECDHE_ECDSA,
     ECDH_anon,
+    // Defined in RFC 8446 section 4.2.8: TLS 1.3 cipher suites leave the key exchange to the key_share extension
+    KEY_SHARE,
 };
 
 // Defined in RFC 5246 section 7.4.1.4.1
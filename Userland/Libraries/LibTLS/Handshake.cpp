@@ -17,7 +17,38 @@ namespace TLS {
 
 ByteBuffer TLSv12::build_hello()
 {
-    fill_with_random(m_context.local_random);
+    auto& tls13 = m_context.tls13;
+    bool offer_tls13 = m_context.options.max_version == ProtocolVersion::VERSION_1_3;
+
+    Session const* session = nullptr;
+    if (m_context.options.session.has_value() && !m_context.options.session->is_expired() && m_context.options.usable_cipher_suites.contains_slow(m_context.options.session->cipher))
+        session = &m_context.options.session.value();
+    auto const* tls12_session = session && session->version == ProtocolVersion::VERSION_1_2 ? session : nullptr;
+    auto const* tls13_session = session && session->version == ProtocolVersion::VERSION_1_3 && offer_tls13 ? session : nullptr;
+
+    // RFC 8446 section 4.1.2: The ClientHello that follows a HelloRetryRequest is the same as the first one, except for
+    //                         the key share, the cookie, and the pre-shared key.
+    if (!tls13.received_hello_retry_request) {
+        fill_with_random(m_context.local_random);
+
+        if (tls12_session && !tls12_session->session_id.is_empty() && tls12_session->session_id.size() <= sizeof(m_context.session_id)) {
+            m_context.session_id_size = tls12_session->session_id.size();
+            memcpy(m_context.session_id, tls12_session->session_id.data(), m_context.session_id_size);
+        } else if (tls12_session || offer_tls13) {
+            // A made-up session ID is what a server echoes to accept a TLS 1.2 session ticket, and what TLS 1.3 asks
+            // for to look like a resumed TLS 1.2 session to middleboxes (RFC 8446 appendix D.4).
+            m_context.session_id_size = sizeof(m_context.session_id);
+            fill_with_random(m_context.session_id);
+        }
+
+        if (offer_tls13) {
+            Optional<SupportedGroup> group = m_context.options.elliptic_curves.first_matching([](auto group) { return create_elliptic_curve(group) != nullptr; });
+            if (!group.has_value() || generate_key_share(*group).is_error()) {
+                dbgln("Not offering TLS 1.3, as there is no key share to offer");
+                offer_tls13 = false;
+            }
+        }
+    }
 
     auto packet_version = (u16)m_context.options.version;
     auto version = (u16)m_context.options.version;
@@ -38,24 +69,6 @@ ByteBuffer TLSv12::build_hello()
     if (m_context.session_id_size)
         builder.append(m_context.session_id, m_context.session_id_size);
 
-    size_t extension_length = 0;
-    size_t alpn_length = 0;
-    size_t alpn_negotiated_length = 0;
-
-    // ALPN
-    if (!m_context.negotiated_alpn.is_empty()) {
-        alpn_negotiated_length = m_context.negotiated_alpn.length();
-        alpn_length = alpn_negotiated_length + 1;
-        extension_length += alpn_length + 6;
-    } else if (m_context.alpn.size()) {
-        for (auto& alpn : m_context.alpn) {
-            size_t length = alpn.length();
-            alpn_length += length + 1;
-        }
-        if (alpn_length)
-            extension_length += alpn_length + 6;
-    }
-
     // Ciphers
     builder.append((u16)(m_context.options.usable_cipher_suites.size() * sizeof(u16)));
     for (auto suite : m_context.options.usable_cipher_suites)
@@ -66,32 +79,13 @@ ByteBuffer TLSv12::build_hello()
     builder.append((u8)1);
     builder.append((u8)m_context.options.use_compression);
 
-    // set SNI if we have one, and the user hasn't explicitly asked us to omit it.
-    auto sni_length = 0;
-    if (!m_context.extensions.SNI.is_empty() && m_context.options.use_sni)
-        sni_length = m_context.extensions.SNI.length();
-
-    auto elliptic_curves_length = 2 * m_context.options.elliptic_curves.size();
-    auto supported_ec_point_formats_length = m_context.options.supported_ec_point_formats.size();
-    bool supports_elliptic_curves = elliptic_curves_length && supported_ec_point_formats_length;
-    bool enable_extended_master_secret = m_context.options.enable_extended_master_secret;
-
-    // signature_algorithms: 2b extension ID, 2b extension length, 2b vector length, 2xN signatures and hashes
-    extension_length += 2 + 2 + 2 + 2 * m_context.options.supported_signature_algorithms.size();
-
-    if (sni_length)
-        extension_length += sni_length + 9;
+    // extensions length (for later)
+    auto extensions_length_position = builder.length();
+    builder.append((u16)0);
 
-    // Only send elliptic_curves and ec_point_formats extensions if both are supported
-    if (supports_elliptic_curves)
-        extension_length += 6 + elliptic_curves_length + 5 + supported_ec_point_formats_length;
-
-    if (enable_extended_master_secret)
-        extension_length += 4;
-
-    builder.append((u16)extension_length);
-
-    if (sni_length) {
+    // set SNI if we have one, and the user hasn't explicitly asked us to omit it.
+    if (!m_context.extensions.SNI.is_empty() && m_context.options.use_sni) {
+        auto sni_length = m_context.extensions.SNI.length();
         // SNI extension
         builder.append((u16)ExtensionType::SERVER_NAME);
         // extension length
@@ -117,7 +111,10 @@ ByteBuffer TLSv12::build_hello()
         builder.append((u8)entry.signature);
     }
 
-    if (supports_elliptic_curves) {
+    // Only send elliptic_curves and ec_point_formats extensions if both are supported
+    auto elliptic_curves_length = 2 * m_context.options.elliptic_curves.size();
+    auto supported_ec_point_formats_length = m_context.options.supported_ec_point_formats.size();
+    if (elliptic_curves_length && supported_ec_point_formats_length) {
         // elliptic_curves extension
         builder.append((u16)ExtensionType::SUPPORTED_GROUPS);
         builder.append((u16)(2 + elliptic_curves_length));
@@ -133,27 +130,101 @@ ByteBuffer TLSv12::build_hello()
             builder.append((u8)format);
     }
 
-    if (enable_extended_master_secret) {
+    if (m_context.options.enable_extended_master_secret) {
         // extended_master_secret extension
         builder.append((u16)ExtensionType::EXTENDED_MASTER_SECRET);
         builder.append((u16)0);
     }
 
+    // ALPN
+    size_t alpn_length = 0;
+    if (!m_context.negotiated_alpn.is_empty()) {
+        alpn_length = m_context.negotiated_alpn.length() + 1;
+    } else {
+        for (auto& alpn : m_context.alpn)
+            alpn_length += alpn.length() + 1;
+    }
+
     if (alpn_length) {
-        // TODO
-        VERIFY_NOT_REACHED();
+        // application_layer_protocol_negotiation extension
+        builder.append((u16)ExtensionType::APPLICATION_LAYER_PROTOCOL_NEGOTIATION);
+        // Extension length
+        builder.append((u16)(alpn_length + 2));
+        // ProtocolNameList length
+        builder.append((u16)alpn_length);
+        auto append_protocol_name = [&](StringView name) {
+            builder.append((u8)name.length());
+            builder.append(name.bytes());
+        };
+        if (!m_context.negotiated_alpn.is_empty()) {
+            append_protocol_name(m_context.negotiated_alpn);
+        } else {
+            for (auto& alpn : m_context.alpn)
+                append_protocol_name(alpn);
+        }
+    }
+
+    // session_ticket extension, empty unless there is a ticket to resume with
+    // https://www.rfc-editor.org/rfc/rfc5077#section-3.2
+    builder.append((u16)ExtensionType::SESSION_TICKET);
+    if (tls12_session) {
+        builder.append((u16)tls12_session->ticket.size());
+        builder.append(tls12_session->ticket.bytes());
+    } else {
+        builder.append((u16)0);
     }
 
+    if (offer_tls13) {
+        // supported_versions extension
+        builder.append((u16)ExtensionType::SUPPORTED_VERSIONS);
+        builder.append((u16)5);
+        builder.append((u8)4);
+        builder.append((u16)ProtocolVersion::VERSION_1_3);
+        builder.append((u16)ProtocolVersion::VERSION_1_2);
+
+        // key_share extension, with a single share for the group we expect the server to pick
+        builder.append((u16)ExtensionType::KEY_SHARE);
+        builder.append((u16)(tls13.key_share_public_key.size() + 6));
+        builder.append((u16)(tls13.key_share_public_key.size() + 4));
+        builder.append((u16)tls13.key_share_group);
+        builder.append((u16)tls13.key_share_public_key.size());
+        builder.append(tls13.key_share_public_key.bytes());
+
+        // psk_key_exchange_modes extension: psk_dhe_ke only, so that resumed connections keep forward secrecy.
+        builder.append((u16)ExtensionType::PSK_KEY_EXCHANGE_MODES);
+        builder.append((u16)2);
+        builder.append((u8)1);
+        builder.append((u8)1);
+
+        if (!tls13.cookie.is_empty()) {
+            // cookie extension, echoing the one from the HelloRetryRequest
+            builder.append((u16)ExtensionType::COOKIE);
+            builder.append((u16)(tls13.cookie.size() + 2));
+            builder.append((u16)tls13.cookie.size());
+            builder.append(tls13.cookie.bytes());
+        }
+    }
+
+    // pre_shared_key extension, which has to be the last one.
+    // After a HelloRetryRequest, the pre-shared key is only of use if it goes with the hash of the chosen cipher suite.
+    tls13.offered_pre_shared_key = offer_tls13 && tls13_session
+        && (!tls13.received_hello_retry_request || hmac_hash() == get_hash_kind(tls13_session->cipher));
+    if (tls13.offered_pre_shared_key)
+        append_pre_shared_key(builder, *tls13_session);
+
+    builder.set_u16(extensions_length_position, builder.length() - extensions_length_position - 2);
+
     // set the "length" field of the packet
-    size_t remaining = builder.length() - start_length;
     size_t payload_position = 6;
-    builder.set(payload_position, remaining / 0x10000);
-    remaining %= 0x10000;
-    builder.set(payload_position + 1, remaining / 0x100);
-    remaining %= 0x100;
-    builder.set(payload_position + 2, remaining);
+    builder.set_u24(payload_position, builder.length() - start_length);
 
     auto packet = builder.build();
+
+    if (tls13.offered_pre_shared_key && write_pre_shared_key_binder(packet, *tls13_session).is_error()) {
+        dbgln("Failed to compute the pre-shared key binder");
+        VERIFY_NOT_REACHED();
+    }
+
     update_packet(packet);
 
     return packet;
@@ -187,7 +258,8 @@ ByteBuffer TLSv12::build_handshake_finished()
     auto outbuffer = Bytes { out, verify_data_length };
     ByteBuffer dummy;
 
-    auto digest = m_context.handshake_hash.digest();
+    // Note: The transcript goes on, the server's Finished message covers this one.
+    auto digest = m_context.handshake_hash.peek();
     auto hashbuf = ReadonlyBytes { digest.immutable_data(), m_context.handshake_hash.digest_size() };
     pseudorandom_function(outbuffer, m_context.master_key, (u8 const*)"client finished", 15, hashbuf, dummy);
 
@@ -225,8 +297,71 @@ ssize_t TLSv12::handle_handshake_finished(ReadonlyBytes buffer, WritePacketStage
         return (i8)Error::NeedMoreData;
     }
 
-    // TODO: Compare Hashes
-    dbgln_if(TLS_DEBUG, "FIXME: handle_handshake_finished :: Check message validity");
+    // RFC 5246 section 7.4.9: verify_data = PRF(master_secret, finished_label, Hash(handshake_messages))[0..verify_data_length-1];
+    //                         where handshake_messages are all the ones up to, but not including, this one.
+    constexpr u32 verify_data_length = 12;
+    u8 expected_verify_data[verify_data_length];
+    auto digest = m_context.handshake_hash.peek();
+    auto hashbuf = ReadonlyBytes { digest.immutable_data(), m_context.handshake_hash.digest_size() };
+    pseudorandom_function({ expected_verify_data, verify_data_length }, m_context.master_key, (u8 const*)"server finished", 15, hashbuf, {});
+
+    if (size != verify_data_length || !timing_safe_compare(expected_verify_data, buffer.offset_pointer(index), verify_data_length)) {
+        dbgln("server finished message does not match the handshake");
+        return (i8)Error::NotSafe;
+    }
+
+    // A resumed session has the server finish first, and we still have to answer with our own Finished message.
+    if (m_context.tls12_session.resumed) {
+        write_packets = WritePacketStage::Finished;
+        return index + size;
+    }
+
+    establish_connection();
+
+    return index + size;
+}
+
+// https://www.rfc-editor.org/rfc/rfc5077#section-3.3
+ssize_t TLSv12::handle_new_session_ticket(ReadonlyBytes buffer)
+{
+    if (buffer.size() < 9)
+        return (i8)Error::BrokenPacket;
+
+    u32 size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    auto lifetime_hint = AK::convert_between_host_and_network_endian(ByteReader::load32(buffer.offset_pointer(3)));
+    auto ticket_length = AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(7)));
+    if (size != 6u + ticket_length || buffer.size() < 9u + ticket_length)
+        return (i8)Error::BrokenPacket;
+
+    auto ticket = ByteBuffer::copy(buffer.slice(9, ticket_length));
+    if (ticket.is_error())
+        return (i8)Error::OutOfMemory;
+
+    m_context.tls12_session.ticket = ticket.release_value();
+    m_context.tls12_session.ticket_lifetime = lifetime_hint;
+    return size + 3;
+}
+
+Session TLSv12::make_tls12_session() const
+{
+    // RFC 5246 appendix F.1.4: An upper limit of 24 hours is suggested for session ID lifetimes.
+    constexpr u32 max_lifetime_in_seconds = 24 * 60 * 60;
+    auto lifetime = m_context.tls12_session.ticket_lifetime ? min(m_context.tls12_session.ticket_lifetime, max_lifetime_in_seconds) : max_lifetime_in_seconds;
+
+    Session session;
+    session.version = ProtocolVersion::VERSION_1_2;
+    session.cipher = m_context.cipher;
+    session.secret = MUST(ByteBuffer::copy(m_context.master_key));
+    session.session_id = MUST(ByteBuffer::copy(ReadonlyBytes { m_context.session_id, m_context.session_id_size }));
+    session.ticket = MUST(ByteBuffer::copy(m_context.tls12_session.ticket));
+    session.extended_master_secret = m_context.extensions.extended_master_secret;
+    session.received_at = UnixDateTime::now();
+    session.lifetime = Duration::from_seconds(lifetime);
+    return session;
+}
+
+void TLSv12::establish_connection()
+{
     m_context.connection_status = ConnectionStatus::Established;
 
     if (m_handshake_timeout_timer) {
@@ -236,15 +371,19 @@ ssize_t TLSv12::handle_handshake_finished(ReadonlyBytes buffer, WritePacketStage
         m_handshake_timeout_timer = nullptr;
     }
 
+    // TLS 1.3 hands out sessions after the handshake, and a resumed TLS 1.2 session only changes if we got a new ticket.
+    if (!is_tls13() && (m_context.session_id_size || !m_context.tls12_session.ticket.is_empty())) {
+        if (!m_context.tls12_session.resumed || !m_context.tls12_session.ticket.is_empty())
+            m_context.options.session_handler(make_tls12_session());
+    }
+
     if (on_connected)
         on_connected();
-
-    return index + size;
 }
 
 ssize_t TLSv12::handle_handshake_payload(ReadonlyBytes vbuffer)
 {
-    if (m_context.connection_status == ConnectionStatus::Established) {
+    if (m_context.connection_status == ConnectionStatus::Established && !is_tls13()) {
         dbgln_if(TLS_DEBUG, "Renegotiation attempt ignored");
         // FIXME: We should properly say "NoRenegotiation", but that causes a handshake failure
         //        so we just roll with it and pretend that we _did_ renegotiate
@@ -252,180 +391,210 @@ ssize_t TLSv12::handle_handshake_payload(ReadonlyBytes vbuffer)
         //        we do not have those at the moment :^)
         return 1;
     }
+    auto original_length = vbuffer.size();
+
+    // Handshake messages may be split across records, so pick up whatever was left over from the last one.
+    ByteBuffer reassembled_buffer;
     auto buffer = vbuffer;
+    if (!m_context.cached_handshake.is_empty()) {
+        reassembled_buffer = move(m_context.cached_handshake);
+        if (reassembled_buffer.try_append(vbuffer).is_error())
+            return (i8)Error::OutOfMemory;
+        buffer = reassembled_buffer;
+    }
     auto buffer_length = buffer.size();
-    auto original_length = buffer_length;
-    while (buffer_length >= 4 && !m_context.critical_error) {
+
+    while (buffer_length > 0 && !m_context.critical_error) {
         ssize_t payload_res = 0;
-        if (buffer_length < 1)
-            return (i8)Error::NeedMoreData;
+        size_t payload_size = buffer_length >= 4 ? buffer[1] * 0x10000 + buffer[2] * 0x100 + buffer[3] + 3 : 0;
+        dbgln_if(TLS_DEBUG, "payload size: {} buffer length: {}", payload_size, buffer_length);
+        if (buffer_length < 4 || payload_size + 1 > buffer_length) {
+            dbgln_if(TLS_DEBUG, "Handshake message continues in the next record");
+            auto cached_handshake = ByteBuffer::copy(buffer);
+            if (cached_handshake.is_error())
+                return (i8)Error::OutOfMemory;
+            m_context.cached_handshake = cached_handshake.release_value();
+            break;
+        }
         auto type = static_cast<HandshakeType>(buffer[0]);
         auto write_packets { WritePacketStage::Initial };
-        size_t payload_size = buffer[1] * 0x10000 + buffer[2] * 0x100 + buffer[3] + 3;
-        dbgln_if(TLS_DEBUG, "payload size: {} buffer length: {}", payload_size, buffer_length);
-        if (payload_size + 1 > buffer_length)
-            return (i8)Error::NeedMoreData;
 
-        switch (type) {
-        case HandshakeType::HELLO_REQUEST_RESERVED:
-            if (m_context.handshake_messages[0] >= 1) {
-                dbgln("unexpected hello request message");
-                payload_res = (i8)Error::UnexpectedMessage;
+        // TLS 1.3 messages that come after the handshake are not part of its transcript.
+        bool is_post_handshake_message = m_context.connection_status == ConnectionStatus::Established;
+
+        if (is_tls13() && type != HandshakeType::SERVER_HELLO) {
+            payload_res = handle_tls13_handshake_message(type, buffer.slice(1, payload_size), write_packets);
+        } else {
+            switch (type) {
+            case HandshakeType::HELLO_REQUEST_RESERVED:
+                if (m_context.handshake_messages[0] >= 1) {
+                    dbgln("unexpected hello request message");
+                    payload_res = (i8)Error::UnexpectedMessage;
+                    break;
+                }
+                ++m_context.handshake_messages[0];
+                dbgln("hello request (renegotiation?)");
+                if (m_context.connection_status == ConnectionStatus::Established) {
+                    // renegotiation
+                    payload_res = (i8)Error::NoRenegotiation;
+                } else {
+                    // :shrug:
+                    payload_res = (i8)Error::UnexpectedMessage;
+                }
                 break;
-            }
-            ++m_context.handshake_messages[0];
-            dbgln("hello request (renegotiation?)");
-            if (m_context.connection_status == ConnectionStatus::Established) {
-                // renegotiation
-                payload_res = (i8)Error::NoRenegotiation;
-            } else {
-                // :shrug:
-                payload_res = (i8)Error::UnexpectedMessage;
-            }
-            break;
-        case HandshakeType::CLIENT_HELLO:
-            // FIXME: We only support client mode right now
-            if (m_context.is_server) {
-                VERIFY_NOT_REACHED();
-            }
-            payload_res = (i8)Error::UnexpectedMessage;
-            break;
-        case HandshakeType::SERVER_HELLO:
-            if (m_context.handshake_messages[2] >= 1) {
-                dbgln("unexpected server hello message");
+            case HandshakeType::CLIENT_HELLO:
+                // FIXME: We only support client mode right now
+                if (m_context.is_server) {
+                    VERIFY_NOT_REACHED();
+                }
                 payload_res = (i8)Error::UnexpectedMessage;
                 break;
-            }
-            ++m_context.handshake_messages[2];
-            dbgln_if(TLS_DEBUG, "server hello");
-            if (m_context.is_server) {
-                dbgln("unsupported: server mode");
-                VERIFY_NOT_REACHED();
-            }
-            payload_res = handle_server_hello(buffer.slice(1, payload_size), write_packets);
-            break;
-        case HandshakeType::HELLO_VERIFY_REQUEST_RESERVED:
-            dbgln("unsupported: DTLS");
-            payload_res = (i8)Error::UnexpectedMessage;
-            break;
-        case HandshakeType::CERTIFICATE:
-            if (m_context.handshake_messages[4] >= 1) {
-                dbgln("unexpected certificate message");
+            case HandshakeType::SERVER_HELLO:
+                if (m_context.handshake_messages[2] >= 1) {
+                    dbgln("unexpected server hello message");
+                    payload_res = (i8)Error::UnexpectedMessage;
+                    break;
+                }
+                ++m_context.handshake_messages[2];
+                dbgln_if(TLS_DEBUG, "server hello");
+                if (m_context.is_server) {
+                    dbgln("unsupported: server mode");
+                    VERIFY_NOT_REACHED();
+                }
+                payload_res = handle_server_hello(buffer.slice(1, payload_size), write_packets);
+                break;
+            case HandshakeType::HELLO_VERIFY_REQUEST_RESERVED:
+                dbgln("unsupported: DTLS");
                 payload_res = (i8)Error::UnexpectedMessage;
                 break;
-            }
-            ++m_context.handshake_messages[4];
-            dbgln_if(TLS_DEBUG, "certificate");
-            if (m_context.connection_status == ConnectionStatus::Negotiating) {
+            case HandshakeType::NEW_SESSION_TICKET:
+                if (m_context.handshake_messages[12] >= 1 || !m_context.tls12_session.server_will_send_ticket || m_context.connection_status != ConnectionStatus::KeyExchange) {
+                    dbgln("unexpected new session ticket message");
+                    payload_res = (i8)Error::UnexpectedMessage;
+                    break;
+                }
+                ++m_context.handshake_messages[12];
+                dbgln_if(TLS_DEBUG, "new session ticket");
+                payload_res = handle_new_session_ticket(buffer.slice(1, payload_size));
+                break;
+            case HandshakeType::CERTIFICATE:
+                if (m_context.handshake_messages[4] >= 1) {
+                    dbgln("unexpected certificate message");
+                    payload_res = (i8)Error::UnexpectedMessage;
+                    break;
+                }
+                ++m_context.handshake_messages[4];
+                dbgln_if(TLS_DEBUG, "certificate");
+                if (m_context.connection_status == ConnectionStatus::Negotiating) {
+                    if (m_context.is_server) {
+                        dbgln("unsupported: server mode");
+                        VERIFY_NOT_REACHED();
+                    }
+                    payload_res = handle_certificate(buffer.slice(1, payload_size));
+                } else {
+                    payload_res = (i8)Error::UnexpectedMessage;
+                }
+                break;
+            case HandshakeType::SERVER_KEY_EXCHANGE_RESERVED:
+                if (m_context.handshake_messages[5] >= 1) {
+                    dbgln("unexpected server key exchange message");
+                    payload_res = (i8)Error::UnexpectedMessage;
+                    break;
+                }
+                ++m_context.handshake_messages[5];
+                dbgln_if(TLS_DEBUG, "server key exchange");
                 if (m_context.is_server) {
                     dbgln("unsupported: server mode");
                     VERIFY_NOT_REACHED();
+                } else {
+                    payload_res = handle_server_key_exchange(buffer.slice(1, payload_size));
                 }
-                payload_res = handle_certificate(buffer.slice(1, payload_size));
-            } else {
-                payload_res = (i8)Error::UnexpectedMessage;
-            }
-            break;
-        case HandshakeType::SERVER_KEY_EXCHANGE_RESERVED:
-            if (m_context.handshake_messages[5] >= 1) {
-                dbgln("unexpected server key exchange message");
-                payload_res = (i8)Error::UnexpectedMessage;
                 break;
-            }
-            ++m_context.handshake_messages[5];
-            dbgln_if(TLS_DEBUG, "server key exchange");
-            if (m_context.is_server) {
-                dbgln("unsupported: server mode");
-                VERIFY_NOT_REACHED();
-            } else {
-                payload_res = handle_server_key_exchange(buffer.slice(1, payload_size));
-            }
-            break;
-        case HandshakeType::CERTIFICATE_REQUEST:
-            if (m_context.handshake_messages[6] >= 1) {
-                dbgln("unexpected certificate request message");
-                payload_res = (i8)Error::UnexpectedMessage;
+            case HandshakeType::CERTIFICATE_REQUEST:
+                if (m_context.handshake_messages[6] >= 1) {
+                    dbgln("unexpected certificate request message");
+                    payload_res = (i8)Error::UnexpectedMessage;
+                    break;
+                }
+                ++m_context.handshake_messages[6];
+                if (m_context.is_server) {
+                    dbgln("invalid request");
+                    dbgln("unsupported: server mode");
+                    VERIFY_NOT_REACHED();
+                } else {
+                    // we do not support "certificate request"
+                    dbgln("certificate request");
+                    if (on_tls_certificate_request)
+                        on_tls_certificate_request(*this);
+                    m_context.client_verified = VerificationNeeded;
+                }
                 break;
-            }
-            ++m_context.handshake_messages[6];
-            if (m_context.is_server) {
-                dbgln("invalid request");
-                dbgln("unsupported: server mode");
-                VERIFY_NOT_REACHED();
-            } else {
-                // we do not support "certificate request"
-                dbgln("certificate request");
-                if (on_tls_certificate_request)
-                    on_tls_certificate_request(*this);
-                m_context.client_verified = VerificationNeeded;
-            }
-            break;
-        case HandshakeType::SERVER_HELLO_DONE_RESERVED:
-            if (m_context.handshake_messages[7] >= 1) {
-                dbgln("unexpected server hello done message");
-                payload_res = (i8)Error::UnexpectedMessage;
+            case HandshakeType::SERVER_HELLO_DONE_RESERVED:
+                if (m_context.handshake_messages[7] >= 1) {
+                    dbgln("unexpected server hello done message");
+                    payload_res = (i8)Error::UnexpectedMessage;
+                    break;
+                }
+                ++m_context.handshake_messages[7];
+                dbgln_if(TLS_DEBUG, "server hello done");
+                if (m_context.is_server) {
+                    dbgln("unsupported: server mode");
+                    VERIFY_NOT_REACHED();
+                } else {
+                    payload_res = handle_server_hello_done(buffer.slice(1, payload_size));
+                    if (payload_res > 0)
+                        write_packets = WritePacketStage::ClientHandshake;
+                }
                 break;
-            }
-            ++m_context.handshake_messages[7];
-            dbgln_if(TLS_DEBUG, "server hello done");
-            if (m_context.is_server) {
-                dbgln("unsupported: server mode");
-                VERIFY_NOT_REACHED();
-            } else {
-                payload_res = handle_server_hello_done(buffer.slice(1, payload_size));
-                if (payload_res > 0)
-                    write_packets = WritePacketStage::ClientHandshake;
-            }
-            break;
-        case HandshakeType::CERTIFICATE_VERIFY:
-            if (m_context.handshake_messages[8] >= 1) {
-                dbgln("unexpected certificate verify message");
-                payload_res = (i8)Error::UnexpectedMessage;
+            case HandshakeType::CERTIFICATE_VERIFY:
+                if (m_context.handshake_messages[8] >= 1) {
+                    dbgln("unexpected certificate verify message");
+                    payload_res = (i8)Error::UnexpectedMessage;
+                    break;
+                }
+                ++m_context.handshake_messages[8];
+                dbgln_if(TLS_DEBUG, "certificate verify");
+                if (m_context.connection_status == ConnectionStatus::KeyExchange) {
+                    payload_res = handle_certificate_verify(buffer.slice(1, payload_size));
+                } else {
+                    payload_res = (i8)Error::UnexpectedMessage;
+                }
                 break;
-            }
-            ++m_context.handshake_messages[8];
-            dbgln_if(TLS_DEBUG, "certificate verify");
-            if (m_context.connection_status == ConnectionStatus::KeyExchange) {
-                payload_res = handle_certificate_verify(buffer.slice(1, payload_size));
-            } else {
-                payload_res = (i8)Error::UnexpectedMessage;
-            }
-            break;
-        case HandshakeType::CLIENT_KEY_EXCHANGE_RESERVED:
-            if (m_context.handshake_messages[9] >= 1) {
-                dbgln("unexpected client key exchange message");
-                payload_res = (i8)Error::UnexpectedMessage;
+            case HandshakeType::CLIENT_KEY_EXCHANGE_RESERVED:
+                if (m_context.handshake_messages[9] >= 1) {
+                    dbgln("unexpected client key exchange message");
+                    payload_res = (i8)Error::UnexpectedMessage;
+                    break;
+                }
+                ++m_context.handshake_messages[9];
+                dbgln_if(TLS_DEBUG, "client key exchange");
+                if (m_context.is_server) {
+                    dbgln("unsupported: server mode");
+                    VERIFY_NOT_REACHED();
+                } else {
+                    payload_res = (i8)Error::UnexpectedMessage;
+                }
                 break;
-            }
-            ++m_context.handshake_messages[9];
-            dbgln_if(TLS_DEBUG, "client key exchange");
-            if (m_context.is_server) {
-                dbgln("unsupported: server mode");
-                VERIFY_NOT_REACHED();
-            } else {
-                payload_res = (i8)Error::UnexpectedMessage;
-            }
-            break;
-        case HandshakeType::FINISHED:
-            m_context.cached_handshake.clear();
-            if (m_context.handshake_messages[10] >= 1) {
-                dbgln("unexpected finished message");
-                payload_res = (i8)Error::UnexpectedMessage;
+            case HandshakeType::FINISHED:
+                if (m_context.handshake_messages[10] >= 1) {
+                    dbgln("unexpected finished message");
+                    payload_res = (i8)Error::UnexpectedMessage;
+                    break;
+                }
+                ++m_context.handshake_messages[10];
+                dbgln_if(TLS_DEBUG, "finished");
+                payload_res = handle_handshake_finished(buffer.slice(1, payload_size), write_packets);
+                if (payload_res > 0) {
+                    memset(m_context.handshake_messages, 0, sizeof(m_context.handshake_messages));
+                }
                 break;
+            default:
+                dbgln("message type not understood: {}", enum_to_string(type));
+                return (i8)Error::NotUnderstood;
             }
-            ++m_context.handshake_messages[10];
-            dbgln_if(TLS_DEBUG, "finished");
-            payload_res = handle_handshake_finished(buffer.slice(1, payload_size), write_packets);
-            if (payload_res > 0) {
-                memset(m_context.handshake_messages, 0, sizeof(m_context.handshake_messages));
-            }
-            break;
-        default:
-            dbgln("message type not understood: {}", enum_to_string(type));
-            return (i8)Error::NotUnderstood;
         }
 
-        if (type != HandshakeType::HELLO_REQUEST_RESERVED) {
+        if (type != HandshakeType::HELLO_REQUEST_RESERVED && !is_post_handshake_message) {
             update_hash(buffer.slice(0, payload_size + 1), 0);
         }
 
@@ -488,6 +657,11 @@ ssize_t TLSv12::handle_handshake_payload(ReadonlyBytes vbuffer)
                 write_packet(packet);
                 break;
             }
+            case Error::IllegalParameter: {
+                auto packet = build_alert(true, (u8)AlertDescription::ILLEGAL_PARAMETER);
+                write_packet(packet);
+                break;
+            }
             case Error::NeedMoreData:
                 // Ignore this, as it's not an "error"
                 dbgln_if(TLS_DEBUG, "More data needed");
@@ -537,17 +711,63 @@ ssize_t TLSv12::handle_handshake_payload(ReadonlyBytes vbuffer)
             break;
         case WritePacketStage::Finished:
             // finished
-            {
-                dbgln_if(TLS_DEBUG, "> change cipher spec");
-                auto packet = build_change_cipher_spec();
-                write_packet(packet);
+            if (is_tls13()) {
+                if (derive_tls13_application_secrets().is_error()) {
+                    auto packet = build_alert(true, (u8)AlertDescription::INTERNAL_ERROR);
+                    write_packet(packet);
+                    return (i8)Error::OutOfMemory;
+                }
+                {
+                    // RFC 8446 appendix D.4: The compatibility change_cipher_spec goes right before our second flight.
+                    dbgln_if(TLS_DEBUG, "> change cipher spec");
+                    auto packet = build_change_cipher_spec();
+                    write_packet(packet);
+                }
+                if (m_context.tls13.should_send_certificate) {
+                    dbgln_if(TLS_DEBUG, "> client certificate");
+                    auto packet = build_tls13_certificate();
+                    write_packet(packet);
+                }
+                {
+                    dbgln_if(TLS_DEBUG, "> client finished");
+                    auto packet = build_tls13_handshake_finished();
+                    write_packet(packet);
+                }
+                // The resumption secret covers our Finished message, and everything from here on uses the application keys.
+                if (derive_tls13_resumption_secret().is_error()
+                    || install_tls13_traffic_keys(m_context.tls13.client_application_traffic_secret, true).is_error()
+                    || install_tls13_traffic_keys(m_context.tls13.server_application_traffic_secret, false).is_error()) {
+                    auto packet = build_alert(true, (u8)AlertDescription::INTERNAL_ERROR);
+                    write_packet(packet);
+                    return (i8)Error::OutOfMemory;
+                }
+            } else {
+                {
+                    dbgln_if(TLS_DEBUG, "> change cipher spec");
+                    auto packet = build_change_cipher_spec();
+                    write_packet(packet);
+                }
+                {
+                    dbgln_if(TLS_DEBUG, "> client finished");
+                    auto packet = build_handshake_finished();
+                    write_packet(packet);
+                }
             }
-            {
-                dbgln_if(TLS_DEBUG, "> client finished");
-                auto packet = build_handshake_finished();
+            establish_connection();
+            break;
+        case WritePacketStage::HelloRetry: {
+            dbgln_if(TLS_DEBUG, "> client hello (retry)");
+            auto packet = build_hello();
+            write_packet(packet);
+            break;
+        }
+        case WritePacketStage::HandshakeKeys:
+            // Everything after the ServerHello is protected with keys that take the ServerHello into account.
+            if (derive_tls13_handshake_secrets().is_error()) {
+                auto packet = build_alert(true, (u8)AlertDescription::INTERNAL_ERROR);
                 write_packet(packet);
+                return (i8)Error::OutOfMemory;
             }
-            m_context.connection_status = ConnectionStatus::Established;
             break;
         }
         payload_size++;
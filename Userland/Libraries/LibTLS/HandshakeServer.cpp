@@ -17,14 +17,42 @@
 #include <LibCrypto/Curves/X25519.h>
 #include <LibCrypto/Curves/X448.h>
 #include <LibCrypto/PK/Code/EMSA_PKCS1_V1_5.h>
+#include <LibCrypto/PK/Code/EMSA_PSS.h>
 #include <LibTLS/TLSv12.h>
 
 namespace TLS {
 
+// RFC 8446 section 4.1.3: A HelloRetryRequest is a ServerHello with this special random value, SHA-256 of "HelloRetryRequest".
+static constexpr u8 hello_retry_request_random[32] = {
+    0xcf, 0x21, 0xad, 0x74, 0xe5, 0x9a, 0x61, 0x11, 0xbe, 0x1d, 0x8c, 0x02, 0x1e, 0x65, 0xb8, 0x91,
+    0xc2, 0xa2, 0x11, 0x16, 0x7a, 0xbb, 0x8c, 0x5e, 0x07, 0x9e, 0x09, 0xe2, 0xc8, 0xa8, 0x33, 0x9c
+};
+
+// RFC 8446 section 4.1.3: A TLS 1.3 server that negotiates TLS 1.2 ends its random value with this.
+static constexpr u8 tls12_downgrade_sentinel[8] = { 'D', 'O', 'W', 'N', 'G', 'R', 'D', 0x01 };
+
+OwnPtr<Crypto::Curves::EllipticCurve> TLSv12::create_elliptic_curve(SupportedGroup group)
+{
+    switch (group) {
+    case SupportedGroup::X25519:
+        return make<Crypto::Curves::X25519>();
+    case SupportedGroup::X448:
+        return make<Crypto::Curves::X448>();
+    case SupportedGroup::SECP256R1:
+        return make<Crypto::Curves::SECP256r1>();
+    case SupportedGroup::SECP384R1:
+        return make<Crypto::Curves::SECP384r1>();
+    default:
+        return nullptr;
+    }
+}
+
 ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& write_packets)
 {
     write_packets = WritePacketStage::Initial;
-    if (m_context.connection_status != ConnectionStatus::Disconnected && m_context.connection_status != ConnectionStatus::Renegotiating) {
+    // The ServerHello that follows a HelloRetryRequest finds the connection negotiating already.
+    bool is_after_hello_retry_request = m_context.tls13.received_hello_retry_request && m_context.connection_status == ConnectionStatus::Negotiating;
+    if (m_context.connection_status != ConnectionStatus::Disconnected && m_context.connection_status != ConnectionStatus::Renegotiating && !is_after_hello_retry_request) {
         dbgln("unexpected hello message");
         return (i8)Error::UnexpectedMessage;
     }
@@ -49,11 +77,13 @@ ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& writ
     auto version = static_cast<ProtocolVersion>(AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(res))));
 
     res += 2;
-    if (!supports_version(version))
+    // Note: TLS 1.3 is negotiated with the supported_versions extension, this is always TLS 1.2.
+    if (version != ProtocolVersion::VERSION_1_2)
         return (i8)Error::NotSafe;
 
     memcpy(m_context.remote_random, buffer.offset_pointer(res), sizeof(m_context.remote_random));
     res += sizeof(m_context.remote_random);
+    bool is_hello_retry_request = memcmp(m_context.remote_random, hello_retry_request_random, sizeof(hello_retry_request_random)) == 0;
 
     u8 session_length = buffer[res++];
     if (buffer.size() - res < session_length) {
@@ -61,6 +91,9 @@ ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& writ
         return (i8)Error::NeedMoreData;
     }
 
+    // Echoing our session ID back is how the server says it is resuming the session (or plays along for TLS 1.3).
+    bool session_id_echoed = session_length && session_length == m_context.session_id_size && memcmp(m_context.session_id, buffer.offset_pointer(res), session_length) == 0;
+
     if (session_length && session_length <= 32) {
         memcpy(m_context.session_id, buffer.offset_pointer(res), session_length);
         m_context.session_id_size = session_length;
@@ -79,16 +112,22 @@ ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& writ
     }
     auto cipher = static_cast<CipherSuite>(AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(res))));
     res += 2;
-    if (!supports_cipher(cipher)) {
+    if (!supports_cipher(cipher) || !m_context.options.usable_cipher_suites.contains_slow(cipher)) {
         m_context.cipher = CipherSuite::TLS_NULL_WITH_NULL_NULL;
         dbgln("No supported cipher could be agreed upon");
         return (i8)Error::NoCommonCipher;
     }
-    m_context.cipher = cipher;
-    dbgln_if(TLS_DEBUG, "Cipher: {}", enum_to_string(cipher));
+    if (is_after_hello_retry_request) {
+        // RFC 8446 section 4.1.4: The cipher suite can't change after a HelloRetryRequest, and neither can the hash.
+        if (cipher != m_context.cipher)
+            return (i8)Error::IllegalParameter;
+    } else {
+        m_context.cipher = cipher;
 
-    // Simplification: We only support handshake hash functions via HMAC
-    m_context.handshake_hash.initialize(hmac_hash());
+        // Simplification: We only support handshake hash functions via HMAC
+        m_context.handshake_hash.initialize(hmac_hash());
+    }
+    dbgln_if(TLS_DEBUG, "Cipher: {}", enum_to_string(cipher));
 
     // Compression method
     if (buffer.size() - res < 1)
@@ -104,6 +143,11 @@ ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& writ
         write_packets = WritePacketStage::ServerHandshake;
     }
 
+    Optional<SupportedGroup> server_key_share_group;
+    ReadonlyBytes server_key_share;
+    Optional<u16> selected_identity;
+    m_context.negotiated_version = ProtocolVersion::VERSION_1_2;
+
     // Presence of extensions is determined by availability of bytes after compression_method
     if (buffer.size() - res >= 2) {
         auto extensions_bytes_total = AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(res += 2)));
@@ -149,28 +193,9 @@ ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& writ
                 res += sni_name_length;
                 dbgln("SNI host_name: {}", m_context.extensions.SNI);
             }
-        } else if (extension_type == ExtensionType::APPLICATION_LAYER_PROTOCOL_NEGOTIATION && m_context.alpn.size()) {
-            if (buffer.size() - res > 2) {
-                auto alpn_length = AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(res)));
-                if (alpn_length && alpn_length <= extension_length - 2) {
-                    u8 const* alpn = buffer.offset_pointer(res + 2);
-                    size_t alpn_position = 0;
-                    while (alpn_position < alpn_length) {
-                        u8 alpn_size = alpn[alpn_position++];
-                        if (alpn_size + alpn_position >= extension_length)
-                            break;
-                        ByteString alpn_str { (char const*)alpn + alpn_position, alpn_length };
-                        if (alpn_size && m_context.alpn.contains_slow(alpn_str)) {
-                            m_context.negotiated_alpn = alpn_str;
-                            dbgln("negotiated alpn: {}", alpn_str);
-                            break;
-                        }
-                        alpn_position += alpn_length;
-                        if (!m_context.is_server) // server hello must contain one ALPN
-                            break;
-                    }
-                }
-            }
+        } else if (extension_type == ExtensionType::APPLICATION_LAYER_PROTOCOL_NEGOTIATION) {
+            if (auto result = handle_application_layer_protocol_negotiation(buffer.slice(res, extension_length)); result < 0)
+                return result;
             res += extension_length;
         } else if (extension_type == ExtensionType::SIGNATURE_ALGORITHMS) {
             dbgln("supported signatures: ");
@@ -190,15 +215,131 @@ ssize_t TLSv12::handle_server_hello(ReadonlyBytes buffer, WritePacketStage& writ
         } else if (extension_type == ExtensionType::EXTENDED_MASTER_SECRET) {
             m_context.extensions.extended_master_secret = true;
             res += extension_length;
+        } else if (extension_type == ExtensionType::SESSION_TICKET) {
+            // RFC 5077 section 3.2: The server will send a NewSessionTicket message before its ChangeCipherSpec.
+            m_context.tls12_session.server_will_send_ticket = true;
+            res += extension_length;
+        } else if (extension_type == ExtensionType::SUPPORTED_VERSIONS) {
+            if (extension_length != 2)
+                return (i8)Error::BrokenPacket;
+            auto selected_version = static_cast<ProtocolVersion>(AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(res))));
+            if (selected_version != ProtocolVersion::VERSION_1_3 || !supports_version(selected_version))
+                return (i8)Error::IllegalParameter;
+            m_context.negotiated_version = selected_version;
+            res += extension_length;
+        } else if (extension_type == ExtensionType::KEY_SHARE) {
+            // A HelloRetryRequest only names the group it wants a key share for, a ServerHello comes with the share itself.
+            if (extension_length < 2)
+                return (i8)Error::BrokenPacket;
+            server_key_share_group = static_cast<SupportedGroup>(AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(res))));
+            if (extension_length > 2) {
+                if (extension_length < 4)
+                    return (i8)Error::BrokenPacket;
+                auto key_exchange_length = AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(res + 2)));
+                if (key_exchange_length + 4u != extension_length)
+                    return (i8)Error::BrokenPacket;
+                server_key_share = buffer.slice(res + 4, key_exchange_length);
+            }
+            res += extension_length;
+        } else if (extension_type == ExtensionType::COOKIE) {
+            if (extension_length < 3)
+                return (i8)Error::BrokenPacket;
+            auto cookie = ByteBuffer::copy(buffer.slice(res + 2, extension_length - 2));
+            if (cookie.is_error())
+                return (i8)Error::OutOfMemory;
+            m_context.tls13.cookie = cookie.release_value();
+            res += extension_length;
+        } else if (extension_type == ExtensionType::PRE_SHARED_KEY) {
+            if (extension_length != 2)
+                return (i8)Error::BrokenPacket;
+            selected_identity = AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(res)));
+            res += extension_length;
         } else {
             dbgln("Encountered unknown extension {} with length {}", enum_to_string(extension_type), extension_length);
             res += extension_length;
         }
     }
 
+    if (is_hello_retry_request || is_tls13()) {
+        // RFC 8446 section 4.1.3: The server echoes whatever session ID we sent, and picks a TLS 1.3 cipher suite.
+        if (!is_tls13() || !is_tls13_cipher_suite(cipher) || (m_context.session_id_size && !session_id_echoed))
+            return (i8)Error::IllegalParameter;
+
+        auto result = is_hello_retry_request
+            ? handle_hello_retry_request(server_key_share_group, write_packets)
+            : handle_tls13_server_hello(server_key_share_group, server_key_share, selected_identity, write_packets);
+        if (result < 0)
+            return result;
+        return res;
+    }
+
+    if (is_after_hello_retry_request || is_tls13_cipher_suite(cipher))
+        return (i8)Error::IllegalParameter;
+
+    // RFC 8446 section 4.1.3: A client that offered TLS 1.3 has to abort when a TLS 1.3 server says it's downgrading,
+    //                         as that means someone in the middle made it look like we only speak TLS 1.2.
+    if (m_context.options.max_version == ProtocolVersion::VERSION_1_3) {
+        if (memcmp(m_context.remote_random + sizeof(m_context.remote_random) - sizeof(tls12_downgrade_sentinel), tls12_downgrade_sentinel, sizeof(tls12_downgrade_sentinel)) == 0)
+            return (i8)Error::IllegalParameter;
+    }
+
+    if (session_id_echoed) {
+        if (auto result = handle_session_resumption(); result < 0)
+            return result;
+    }
+
     return res;
 }
 
+ssize_t TLSv12::handle_application_layer_protocol_negotiation(ReadonlyBytes extension)
+{
+    if (m_context.alpn.is_empty())
+        return 0;
+
+    // RFC7301 section 3.1: The ServerHello's ProtocolNameList must contain exactly one ProtocolName, which has to
+    // be one of the ones the client offered.
+    if (extension.size() >= 3) {
+        auto alpn_length = AK::convert_between_host_and_network_endian(ByteReader::load16(extension.offset_pointer(0)));
+        u8 alpn_size = extension[2];
+        if (alpn_length != extension.size() - 2 || alpn_size == 0 || alpn_size + 1u != alpn_length)
+            return (i8)Error::BrokenPacket;
+
+        ByteString alpn_str { (char const*)extension.offset_pointer(3), alpn_size };
+        if (!m_context.alpn.contains_slow(alpn_str))
+            return (i8)Error::NotUnderstood;
+        m_context.negotiated_alpn = move(alpn_str);
+        dbgln_if(TLS_DEBUG, "negotiated alpn: {}", m_context.negotiated_alpn);
+    }
+    return 0;
+}
+
+// https://www.rfc-editor.org/rfc/rfc5246#section-7.3
+ssize_t TLSv12::handle_session_resumption()
+{
+    auto const& session = m_context.options.session;
+    if (!session.has_value() || session->version != ProtocolVersion::VERSION_1_2)
+        return 0;
+
+    // RFC 5246 section 7.4.1.3: A resumed session keeps its cipher suite.
+    // RFC 7627 section 5.3: It also has to agree on whether the master secret was derived from the session hash.
+    if (session->cipher != m_context.cipher || session->extended_master_secret != m_context.extensions.extended_master_secret)
+        return (i8)Error::IllegalParameter;
+
+    dbgln_if(TLS_DEBUG, "Resuming session");
+    auto master_key = ByteBuffer::copy(session->secret);
+    if (master_key.is_error())
+        return (i8)Error::OutOfMemory;
+    m_context.master_key = master_key.release_value();
+
+    if (!expand_key())
+        return (i8)Error::UnknownError;
+
+    // The server skips straight to ChangeCipherSpec and Finished.
+    m_context.tls12_session.resumed = true;
+    m_context.connection_status = ConnectionStatus::KeyExchange;
+    return 0;
+}
+
 ssize_t TLSv12::handle_server_hello_done(ReadonlyBytes buffer)
 {
     if (buffer.size() < 3)
@@ -309,22 +450,9 @@ ssize_t TLSv12::handle_ecdhe_server_key_exchange(ReadonlyBytes buffer, u8& serve
     if (!m_context.options.elliptic_curves.contains_slow(curve))
         return (i8)Error::NotUnderstood;
 
-    switch ((SupportedGroup)curve) {
-    case SupportedGroup::X25519:
-        m_context.server_key_exchange_curve = make<Crypto::Curves::X25519>();
-        break;
-    case SupportedGroup::X448:
-        m_context.server_key_exchange_curve = make<Crypto::Curves::X448>();
-        break;
-    case SupportedGroup::SECP256R1:
-        m_context.server_key_exchange_curve = make<Crypto::Curves::SECP256r1>();
-        break;
-    case SupportedGroup::SECP384R1:
-        m_context.server_key_exchange_curve = make<Crypto::Curves::SECP384r1>();
-        break;
-    default:
+    m_context.server_key_exchange_curve = create_elliptic_curve(curve);
+    if (!m_context.server_key_exchange_curve)
         return (i8)Error::NotUnderstood;
-    }
 
     server_public_key_length = buffer[6];
     if (server_public_key_length != m_context.server_key_exchange_curve->key_size())
@@ -364,7 +492,25 @@ ssize_t TLSv12::verify_rsa_server_key_exchange(ReadonlyBytes server_key_info_buf
 {
     auto signature_hash = signature_buffer[0];
     auto signature_algorithm = static_cast<SignatureAlgorithm>(signature_buffer[1]);
-    if (signature_algorithm != SignatureAlgorithm::RSA) {
+
+    // RFC 8446 section 4.2.3: The RSASSA-PSS schemes have the hash built into the signature algorithm.
+    bool is_pss = (HashAlgorithm)signature_hash == HashAlgorithm::INTRINSIC;
+    if (is_pss) {
+        switch (signature_algorithm) {
+        case SignatureAlgorithm::RSA_PSS_RSAE_SHA256:
+            signature_hash = (u8)HashAlgorithm::SHA256;
+            break;
+        case SignatureAlgorithm::RSA_PSS_RSAE_SHA384:
+            signature_hash = (u8)HashAlgorithm::SHA384;
+            break;
+        case SignatureAlgorithm::RSA_PSS_RSAE_SHA512:
+            signature_hash = (u8)HashAlgorithm::SHA512;
+            break;
+        default:
+            dbgln("verify_rsa_server_key_exchange failed: Signature algorithm is not RSA-PSS, instead {}", enum_to_string(signature_algorithm));
+            return (i8)Error::NotUnderstood;
+        }
+    } else if (signature_algorithm != SignatureAlgorithm::RSA) {
         dbgln("verify_rsa_server_key_exchange failed: Signature algorithm is not RSA, instead {}", enum_to_string(signature_algorithm));
         return (i8)Error::NotUnderstood;
     }
@@ -376,19 +522,6 @@ ssize_t TLSv12::verify_rsa_server_key_exchange(ReadonlyBytes server_key_info_buf
         dbgln("verify_rsa_server_key_exchange failed: Attempting to verify signature without certificates");
         return (i8)Error::NotSafe;
     }
-    // RFC5246 section 7.4.2: The sender's certificate MUST come first in the list.
-    auto certificate_public_key = m_context.certificates.first().public_key;
-    Crypto::PK::RSAPrivateKey dummy_private_key;
-    auto rsa = Crypto::PK::RSA(certificate_public_key.rsa, dummy_private_key);
-
-    auto signature_verify_buffer_result = ByteBuffer::create_uninitialized(signature_length);
-    if (signature_verify_buffer_result.is_error()) {
-        dbgln("verify_rsa_server_key_exchange failed: Not enough memory");
-        return (i8)Error::OutOfMemory;
-    }
-    auto signature_verify_buffer = signature_verify_buffer_result.release_value();
-    auto signature_verify_bytes = signature_verify_buffer.bytes();
-    rsa.verify(signature, signature_verify_bytes);
 
     auto message_result = ByteBuffer::create_uninitialized(64 + server_key_info_buffer.size());
     if (message_result.is_error()) {
@@ -419,9 +552,7 @@ ssize_t TLSv12::verify_rsa_server_key_exchange(ReadonlyBytes server_key_info_buf
         return (i8)Error::NotUnderstood;
     }
 
-    auto pkcs1 = Crypto::PK::EMSA_PKCS1_V1_5<Crypto::Hash::Manager>(hash_kind);
-    auto verification = pkcs1.verify(message, signature_verify_bytes, signature_length * 8);
-
+    auto verification = verify_rsa_signature(message, signature, hash_kind, is_pss);
     if (verification == Crypto::VerificationConsistency::Inconsistent) {
         dbgln("verify_rsa_server_key_exchange failed: Verification of signature inconsistent");
         return (i8)Error::NotSafe;
@@ -430,6 +561,31 @@ ssize_t TLSv12::verify_rsa_server_key_exchange(ReadonlyBytes server_key_info_buf
     return 0;
 }
 
+Crypto::VerificationConsistency TLSv12::verify_rsa_signature(ReadonlyBytes message, ReadonlyBytes signature, Crypto::Hash::HashKind hash_kind, bool is_pss)
+{
+    // RFC5246 section 7.4.2: The sender's certificate MUST come first in the list.
+    auto certificate_public_key = m_context.certificates.first().public_key;
+    Crypto::PK::RSAPrivateKey dummy_private_key;
+    auto rsa = Crypto::PK::RSA(certificate_public_key.rsa, dummy_private_key);
+
+    auto signature_verify_buffer_result = ByteBuffer::create_uninitialized(signature.size());
+    if (signature_verify_buffer_result.is_error())
+        return Crypto::VerificationConsistency::Inconsistent;
+    auto signature_verify_buffer = signature_verify_buffer_result.release_value();
+    auto signature_verify_bytes = signature_verify_buffer.bytes();
+    rsa.verify(signature, signature_verify_bytes);
+
+    if (is_pss) {
+        // RFC 8017 section 8.1.2: emBits is one less than the bit length of the modulus.
+        auto em_bits = certificate_public_key.rsa.modulus().one_based_index_of_highest_set_bit() - 1;
+        auto pss = Crypto::PK::EMSA_PSS<Crypto::Hash::Manager>(hash_kind);
+        return pss.verify(message, signature_verify_bytes, em_bits);
+    }
+
+    auto pkcs1 = Crypto::PK::EMSA_PKCS1_V1_5<Crypto::Hash::Manager>(hash_kind);
+    return pkcs1.verify(message, signature_verify_bytes, signature.size() * 8);
+}
+
 ssize_t TLSv12::handle_ecdhe_ecdsa_server_key_exchange(ReadonlyBytes buffer)
 {
     u8 server_public_key_length;
@@ -0,0 +1,699 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Debug.h>
+#include <AK/Endian.h>
+#include <AK/Memory.h>
+#include <AK/Random.h>
+#include <LibCrypto/Curves/SECPxxxr1.h>
+#include <LibTLS/KeySchedule.h>
+#include <LibTLS/TLSv12.h>
+
+namespace TLS {
+
+using namespace KeySchedule;
+
+static ErrorOr<ByteBuffer> transcript_hash_of(Crypto::Hash::Manager& transcript)
+{
+    return ByteBuffer::copy(transcript.peek().bytes());
+}
+
+ErrorOr<void> TLSv12::generate_key_share(SupportedGroup group)
+{
+    auto curve = create_elliptic_curve(group);
+    if (!curve)
+        return AK::Error::from_string_literal("Unsupported key share group");
+
+    auto private_key = TRY(curve->generate_private_key());
+    auto public_key = TRY(curve->generate_public_key(private_key));
+
+    auto& tls13 = m_context.tls13;
+    tls13.key_share_group = group;
+    tls13.key_share_curve = move(curve);
+    tls13.key_share_private_key = move(private_key);
+    tls13.key_share_public_key = move(public_key);
+    return {};
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-4.2.11
+void TLSv12::append_pre_shared_key(PacketBuilder& builder, Session const& session)
+{
+    auto binder_length = hash_length(get_hash_kind(session.cipher));
+
+    // RFC 8446 section 4.2.11.1: The age of the ticket in milliseconds, offset by ticket_age_add modulo 2^32.
+    auto ticket_age = (UnixDateTime::now() - session.received_at).to_milliseconds();
+    u32 obfuscated_ticket_age = static_cast<u32>(ticket_age) + session.ticket_age_add;
+
+    auto identities_length = 2 + session.ticket.size() + 4;
+    auto binders_length = 1 + binder_length;
+
+    builder.append((u16)ExtensionType::PRE_SHARED_KEY);
+    builder.append((u16)(2 + identities_length + 2 + binders_length));
+
+    builder.append((u16)identities_length);
+    builder.append((u16)session.ticket.size());
+    builder.append(session.ticket.bytes());
+    builder.append_u32(obfuscated_ticket_age);
+
+    // The binder covers the ClientHello up to here, so it is filled in once the rest of it is known.
+    u8 const binder_placeholder[Crypto::Hash::SHA384::DigestSize] {};
+    builder.append((u16)binders_length);
+    builder.append((u8)binder_length);
+    builder.append(binder_placeholder, binder_length);
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-4.2.11.2
+ErrorOr<void> TLSv12::write_pre_shared_key_binder(ByteBuffer& client_hello, Session const& session)
+{
+    constexpr size_t record_header_size = 5;
+    auto hash = get_hash_kind(session.cipher);
+    auto binder_length = hash_length(hash);
+
+    // The transcript for the binder is the ClientHello without its binders list, after whatever came before it.
+    auto truncated_client_hello = client_hello.bytes().slice(record_header_size, client_hello.size() - record_header_size - (2 + 1 + binder_length));
+    ByteBuffer transcript_hash;
+    if (m_context.tls13.received_hello_retry_request) {
+        auto transcript = m_context.handshake_hash.copy();
+        transcript.update(truncated_client_hello);
+        transcript_hash = TRY(transcript_hash_of(transcript));
+    } else {
+        transcript_hash = TRY(hash_of(hash, truncated_client_hello));
+    }
+
+    auto early_secret = TRY(hkdf_extract(hash, {}, session.secret));
+    auto empty_hash = TRY(hash_of(hash, {}));
+    auto binder_key = TRY(derive_secret(hash, early_secret, "res binder"sv, empty_hash));
+    auto binder = TRY(compute_finished_verify_data(hash, binder_key, transcript_hash));
+
+    client_hello.overwrite(client_hello.size() - binder_length, binder.data(), binder_length);
+    return {};
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-4.1.4
+ssize_t TLSv12::handle_hello_retry_request(Optional<SupportedGroup> selected_group, WritePacketStage& write_packets)
+{
+    auto& tls13 = m_context.tls13;
+    if (tls13.received_hello_retry_request) {
+        dbgln("unexpected second hello retry request");
+        return (i8)Error::UnexpectedMessage;
+    }
+
+    if (selected_group.has_value()) {
+        // The server has to pick a group we offered, and not the one we already sent a key share for.
+        if (*selected_group == tls13.key_share_group || !m_context.options.elliptic_curves.contains_slow(*selected_group))
+            return (i8)Error::IllegalParameter;
+        if (generate_key_share(*selected_group).is_error())
+            return (i8)Error::IllegalParameter;
+    } else if (tls13.cookie.is_empty()) {
+        // A HelloRetryRequest that doesn't change anything about our ClientHello is pointless.
+        return (i8)Error::IllegalParameter;
+    }
+
+    // The first ClientHello is replaced in the transcript by a message_hash message carrying its hash.
+    auto client_hello_hash = m_context.handshake_hash.peek();
+    auto digest_size = m_context.handshake_hash.digest_size();
+    u8 message_hash_header[4] = { (u8)HandshakeType::MESSAGE_HASH, 0, 0, (u8)digest_size };
+    m_context.handshake_hash.reset();
+    m_context.handshake_hash.update(message_hash_header, sizeof(message_hash_header));
+    m_context.handshake_hash.update(client_hello_hash.immutable_data(), digest_size);
+
+    // Let the ServerHello that answers our next ClientHello through.
+    m_context.handshake_messages[2] = 0;
+
+    tls13.received_hello_retry_request = true;
+    write_packets = WritePacketStage::HelloRetry;
+    return 0;
+}
+
+ssize_t TLSv12::handle_tls13_server_hello(Optional<SupportedGroup> server_key_share_group, ReadonlyBytes server_key_share, Optional<u16> selected_identity, WritePacketStage& write_packets)
+{
+    auto& tls13 = m_context.tls13;
+
+    if (selected_identity.has_value()) {
+        // We only ever offer one identity, and it has to go with the hash of the chosen cipher suite.
+        if (!tls13.offered_pre_shared_key || *selected_identity != 0 || get_hash_kind(m_context.options.session->cipher) != hmac_hash())
+            return (i8)Error::IllegalParameter;
+        tls13.accepted_pre_shared_key = true;
+    }
+
+    // We only offer psk_dhe_ke, so there has to be a key share either way.
+    if (!server_key_share_group.has_value() || server_key_share.is_empty() || *server_key_share_group != tls13.key_share_group)
+        return (i8)Error::IllegalParameter;
+
+    auto shared_point = tls13.key_share_curve->compute_coordinate(tls13.key_share_private_key, server_key_share);
+    if (shared_point.is_error()) {
+        dbgln("Failed to compute the shared point from the server's key share: {}", shared_point.error());
+        return (i8)Error::IllegalParameter;
+    }
+    auto shared_secret = tls13.key_share_curve->derive_premaster_key(shared_point.value());
+    if (shared_secret.is_error()) {
+        dbgln("Failed to derive the shared secret: {}", shared_secret.error());
+        return (i8)Error::IllegalParameter;
+    }
+    tls13.shared_secret = shared_secret.release_value();
+
+    // We won't need our share again.
+    tls13.key_share_private_key.clear();
+    tls13.key_share_curve = nullptr;
+
+    write_packets = WritePacketStage::HandshakeKeys;
+    return 0;
+}
+
+ssize_t TLSv12::handle_tls13_handshake_message(HandshakeType type, ReadonlyBytes buffer, WritePacketStage& write_packets)
+{
+    auto& messages = m_context.handshake_messages;
+    bool accepted_pre_shared_key = m_context.tls13.accepted_pre_shared_key;
+
+    if (m_context.connection_status == ConnectionStatus::Established) {
+        switch (type) {
+        case HandshakeType::NEW_SESSION_TICKET:
+            dbgln_if(TLS_DEBUG, "new session ticket");
+            return handle_tls13_new_session_ticket(buffer);
+        case HandshakeType::KEY_UPDATE:
+            dbgln_if(TLS_DEBUG, "key update");
+            return handle_key_update(buffer);
+        default:
+            dbgln("unexpected post-handshake message: {}", enum_to_string(type));
+            return (i8)Error::UnexpectedMessage;
+        }
+    }
+
+    // RFC 8446 section 2: EncryptedExtensions, then CertificateRequest, Certificate and CertificateVerify
+    //                     unless a pre-shared key was accepted, then Finished.
+    switch (type) {
+    case HandshakeType::ENCRYPTED_EXTENSIONS:
+        if (messages[11] >= 1 || m_context.connection_status != ConnectionStatus::Negotiating) {
+            dbgln("unexpected encrypted extensions message");
+            return (i8)Error::UnexpectedMessage;
+        }
+        ++messages[11];
+        dbgln_if(TLS_DEBUG, "encrypted extensions");
+        return handle_encrypted_extensions(buffer);
+    case HandshakeType::CERTIFICATE_REQUEST:
+        if (messages[11] != 1 || messages[4] >= 1 || messages[6] >= 1 || accepted_pre_shared_key) {
+            dbgln("unexpected certificate request message");
+            return (i8)Error::UnexpectedMessage;
+        }
+        ++messages[6];
+        dbgln_if(TLS_DEBUG, "certificate request");
+        return handle_tls13_certificate_request(buffer);
+    case HandshakeType::CERTIFICATE:
+        if (messages[11] != 1 || messages[4] >= 1 || accepted_pre_shared_key) {
+            dbgln("unexpected certificate message");
+            return (i8)Error::UnexpectedMessage;
+        }
+        ++messages[4];
+        dbgln_if(TLS_DEBUG, "certificate");
+        return handle_tls13_certificate(buffer);
+    case HandshakeType::CERTIFICATE_VERIFY:
+        if (messages[4] != 1 || messages[8] >= 1) {
+            dbgln("unexpected certificate verify message");
+            return (i8)Error::UnexpectedMessage;
+        }
+        ++messages[8];
+        dbgln_if(TLS_DEBUG, "certificate verify");
+        return handle_tls13_certificate_verify(buffer);
+    case HandshakeType::FINISHED:
+        if (messages[11] != 1 || messages[10] >= 1 || (!accepted_pre_shared_key && messages[8] != 1)) {
+            dbgln("unexpected finished message");
+            return (i8)Error::UnexpectedMessage;
+        }
+        ++messages[10];
+        dbgln_if(TLS_DEBUG, "finished");
+        return handle_tls13_handshake_finished(buffer, write_packets);
+    default:
+        dbgln("unexpected message during the handshake: {}", enum_to_string(type));
+        return (i8)Error::UnexpectedMessage;
+    }
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-4.3.1
+ssize_t TLSv12::handle_encrypted_extensions(ReadonlyBytes buffer)
+{
+    if (buffer.size() < 5)
+        return (i8)Error::BrokenPacket;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    auto extensions_length = AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(3)));
+    if (size != extensions_length + 2u || buffer.size() < 5u + extensions_length)
+        return (i8)Error::BrokenPacket;
+
+    size_t res = 5;
+    while (res < 5u + extensions_length) {
+        if (buffer.size() - res < 4)
+            return (i8)Error::BrokenPacket;
+
+        auto extension_type = (ExtensionType)AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(res)));
+        u16 extension_length = AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(res + 2)));
+        res += 4;
+        if (buffer.size() - res < extension_length)
+            return (i8)Error::BrokenPacket;
+
+        switch (extension_type) {
+        case ExtensionType::APPLICATION_LAYER_PROTOCOL_NEGOTIATION:
+            if (auto result = handle_application_layer_protocol_negotiation(buffer.slice(res, extension_length)); result < 0)
+                return result;
+            break;
+        case ExtensionType::KEY_SHARE:
+        case ExtensionType::PRE_SHARED_KEY:
+        case ExtensionType::SUPPORTED_VERSIONS:
+        case ExtensionType::COOKIE:
+            // These only ever go into the (unprotected) ServerHello.
+            dbgln("Encountered {} in the encrypted extensions", enum_to_string(extension_type));
+            return (i8)Error::IllegalParameter;
+        default:
+            dbgln_if(TLS_DEBUG, "Ignoring encrypted extension {} with length {}", enum_to_string(extension_type), extension_length);
+            break;
+        }
+        res += extension_length;
+    }
+
+    return res;
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-4.3.2
+ssize_t TLSv12::handle_tls13_certificate_request(ReadonlyBytes buffer)
+{
+    if (buffer.size() < 4)
+        return (i8)Error::BrokenPacket;
+
+    u8 context_length = buffer[3];
+    if (buffer.size() < 4u + context_length)
+        return (i8)Error::BrokenPacket;
+
+    auto context = ByteBuffer::copy(buffer.slice(4, context_length));
+    if (context.is_error())
+        return (i8)Error::OutOfMemory;
+
+    // Simplification: We don't sign anything with client certificates, so we answer with an empty certificate list
+    //                 and leave it to the server whether that's good enough.
+    m_context.tls13.certificate_request_context = context.release_value();
+    m_context.tls13.should_send_certificate = true;
+    return buffer.size();
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-4.4.2
+ssize_t TLSv12::handle_tls13_certificate(ReadonlyBytes buffer)
+{
+    if (buffer.size() < 7)
+        return (i8)Error::BrokenPacket;
+
+    // The certificate_request_context is empty for server certificates.
+    if (buffer[3] != 0)
+        return (i8)Error::IllegalParameter;
+
+    size_t certificate_list_length = buffer[4] * 0x10000 + buffer[5] * 0x100 + buffer[6];
+    if (buffer.size() < 7 + certificate_list_length)
+        return (i8)Error::BrokenPacket;
+
+    auto certificate_list = buffer.slice(7, certificate_list_length);
+    while (!certificate_list.is_empty()) {
+        // struct {
+        //     opaque cert_data<1..2^24-1>;
+        //     Extension extensions<0..2^16-1>;
+        // } CertificateEntry;
+        if (certificate_list.size() < 3)
+            return (i8)Error::BrokenPacket;
+        size_t certificate_length = certificate_list[0] * 0x10000 + certificate_list[1] * 0x100 + certificate_list[2];
+        if (certificate_list.size() < 3 + certificate_length + 2)
+            return (i8)Error::BrokenPacket;
+        auto extensions_length = AK::convert_between_host_and_network_endian(ByteReader::load16(certificate_list.offset_pointer(3 + certificate_length)));
+        if (certificate_list.size() < 3 + certificate_length + 2 + extensions_length)
+            return (i8)Error::BrokenPacket;
+
+        auto certificate = Certificate::parse_certificate(certificate_list.slice(3, certificate_length), false);
+        if (certificate.is_error()) {
+            dbgln("Failed to parse server certificate: {}", certificate.error());
+            // Only the sender's certificate has to make sense to us, the rest of the chain may well be optional.
+            if (m_context.certificates.is_empty())
+                return (i8)Error::UnsupportedCertificate;
+        } else {
+            m_context.certificates.append(certificate.release_value());
+        }
+
+        certificate_list = certificate_list.slice(3 + certificate_length + 2 + extensions_length);
+    }
+
+    if (m_context.certificates.is_empty()) {
+        dbgln("server did not send a certificate");
+        return (i8)Error::BadCertificate;
+    }
+
+    if (!m_context.verify_chain(m_context.extensions.SNI)) {
+        dbgln("certificate verification failed :(");
+        return (i8)Error::BadCertificate;
+    }
+
+    return buffer.size();
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-4.4.3
+ssize_t TLSv12::handle_tls13_certificate_verify(ReadonlyBytes buffer)
+{
+    if (buffer.size() < 7)
+        return (i8)Error::BrokenPacket;
+
+    auto signature_hash = (HashAlgorithm)buffer[3];
+    auto signature_algorithm = (SignatureAlgorithm)buffer[4];
+    auto signature_length = AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(5)));
+    if (buffer.size() < 7u + signature_length)
+        return (i8)Error::BrokenPacket;
+    auto signature = buffer.slice(7, signature_length);
+
+    bool was_offered = m_context.options.supported_signature_algorithms.contains_slow(SignatureAndHashAlgorithm { signature_hash, signature_algorithm });
+    if (!was_offered) {
+        dbgln("server signed with a scheme we didn't offer: {}/{}", to_underlying(signature_hash), enum_to_string(signature_algorithm));
+        return (i8)Error::IllegalParameter;
+    }
+
+    // The signature covers 64 spaces, a context string, a zero byte and the transcript hash up to the Certificate message.
+    constexpr auto context_string = "TLS 1.3, server CertificateVerify"sv;
+    auto transcript_hash = transcript_hash_of(m_context.handshake_hash);
+    if (transcript_hash.is_error())
+        return (i8)Error::OutOfMemory;
+    ByteBuffer content;
+    if (content.try_ensure_capacity(64 + context_string.length() + 1 + transcript_hash.value().size()).is_error())
+        return (i8)Error::OutOfMemory;
+    for (size_t i = 0; i < 64; ++i)
+        content.append(0x20);
+    content.append(context_string.bytes());
+    content.append(0);
+    content.append(transcript_hash.value());
+
+    auto const& certificate = m_context.certificates.first();
+    auto const& public_key = certificate.public_key;
+    bool is_rsa_key = public_key.algorithm.identifier.span() == rsa_encryption_oid.span();
+    bool is_ec_key = public_key.algorithm.identifier.span() == ec_public_key_encryption_oid.span();
+
+    // RFC 8446 section 4.4.3: RSA signatures must use an RSASSA-PSS algorithm.
+    if (signature_hash == HashAlgorithm::INTRINSIC && is_rsa_key) {
+        Crypto::Hash::HashKind hash_kind;
+        switch (signature_algorithm) {
+        case SignatureAlgorithm::RSA_PSS_RSAE_SHA256:
+            hash_kind = Crypto::Hash::HashKind::SHA256;
+            break;
+        case SignatureAlgorithm::RSA_PSS_RSAE_SHA384:
+            hash_kind = Crypto::Hash::HashKind::SHA384;
+            break;
+        case SignatureAlgorithm::RSA_PSS_RSAE_SHA512:
+            hash_kind = Crypto::Hash::HashKind::SHA512;
+            break;
+        default:
+            dbgln("Unsupported signature algorithm for an RSA key: {}", enum_to_string(signature_algorithm));
+            return (i8)Error::IllegalParameter;
+        }
+
+        if (verify_rsa_signature(content, signature, hash_kind, true) != Crypto::VerificationConsistency::Consistent) {
+            dbgln("certificate verify signature inconsistent");
+            return (i8)Error::NotSafe;
+        }
+        return buffer.size();
+    }
+
+    if (signature_algorithm == SignatureAlgorithm::ECDSA && is_ec_key) {
+        Crypto::Hash::HashKind hash_kind;
+        switch (signature_hash) {
+        case HashAlgorithm::SHA256:
+            hash_kind = Crypto::Hash::HashKind::SHA256;
+            break;
+        case HashAlgorithm::SHA384:
+            hash_kind = Crypto::Hash::HashKind::SHA384;
+            break;
+        case HashAlgorithm::SHA512:
+            hash_kind = Crypto::Hash::HashKind::SHA512;
+            break;
+        default:
+            dbgln("Unsupported hash algorithm for an ECDSA signature: {}", to_underlying(signature_hash));
+            return (i8)Error::IllegalParameter;
+        }
+
+        auto digest = hash_of(hash_kind, content);
+        if (digest.is_error())
+            return (i8)Error::OutOfMemory;
+
+        ErrorOr<bool> result = AK::Error::from_errno(ENOTSUP);
+        switch (public_key.algorithm.ec_parameters) {
+        case SupportedGroup::SECP256R1:
+            result = Crypto::Curves::SECP256r1 {}.verify(digest.value(), public_key.raw_key, signature);
+            break;
+        case SupportedGroup::SECP384R1:
+            result = Crypto::Curves::SECP384r1 {}.verify(digest.value(), public_key.raw_key, signature);
+            break;
+        default:
+            dbgln("Server certificate public key algorithm is not supported: {}", to_underlying(public_key.algorithm.ec_parameters));
+            return (i8)Error::UnsupportedCertificate;
+        }
+
+        if (result.is_error() || !result.value()) {
+            dbgln("certificate verify signature inconsistent");
+            return (i8)Error::NotSafe;
+        }
+        return buffer.size();
+    }
+
+    dbgln("Unsupported signature algorithm {}/{} for the server certificate", to_underlying(signature_hash), enum_to_string(signature_algorithm));
+    return (i8)Error::UnsupportedCertificate;
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-4.4.4
+ssize_t TLSv12::handle_tls13_handshake_finished(ReadonlyBytes buffer, WritePacketStage& write_packets)
+{
+    write_packets = WritePacketStage::Initial;
+
+    auto hash = hmac_hash();
+    if (buffer.size() < 3)
+        return (i8)Error::BrokenPacket;
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (size != hash_length(hash) || buffer.size() < 3 + size)
+        return (i8)Error::BrokenPacket;
+
+    auto transcript_hash = transcript_hash_of(m_context.handshake_hash);
+    if (transcript_hash.is_error())
+        return (i8)Error::OutOfMemory;
+    auto expected_verify_data = compute_finished_verify_data(hash, m_context.tls13.server_handshake_traffic_secret, transcript_hash.value());
+    if (expected_verify_data.is_error())
+        return (i8)Error::OutOfMemory;
+
+    if (!timing_safe_compare(expected_verify_data.value().data(), buffer.offset_pointer(3), size)) {
+        dbgln("server finished message does not match the handshake");
+        return (i8)Error::NotSafe;
+    }
+
+    write_packets = WritePacketStage::Finished;
+    return 3 + size;
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-4.6.1
+ssize_t TLSv12::handle_tls13_new_session_ticket(ReadonlyBytes buffer)
+{
+    // struct {
+    //     uint32 ticket_lifetime;
+    //     uint32 ticket_age_add;
+    //     opaque ticket_nonce<0..255>;
+    //     opaque ticket<1..2^16-1>;
+    //     Extension extensions<0..2^16-2>;
+    // } NewSessionTicket;
+    if (buffer.size() < 12)
+        return (i8)Error::BrokenPacket;
+
+    size_t size = buffer[0] * 0x10000 + buffer[1] * 0x100 + buffer[2];
+    if (buffer.size() < 3 + size)
+        return (i8)Error::BrokenPacket;
+
+    auto ticket_lifetime = AK::convert_between_host_and_network_endian(ByteReader::load32(buffer.offset_pointer(3)));
+    auto ticket_age_add = AK::convert_between_host_and_network_endian(ByteReader::load32(buffer.offset_pointer(7)));
+    u8 nonce_length = buffer[11];
+    if (buffer.size() < 12u + nonce_length + 2)
+        return (i8)Error::BrokenPacket;
+    auto nonce = buffer.slice(12, nonce_length);
+    auto ticket_length = AK::convert_between_host_and_network_endian(ByteReader::load16(buffer.offset_pointer(12 + nonce_length)));
+    if (ticket_length == 0 || buffer.size() < 14u + nonce_length + ticket_length)
+        return (i8)Error::BrokenPacket;
+    auto ticket = buffer.slice(14 + nonce_length, ticket_length);
+
+    // RFC 8446 section 4.6.1: A lifetime of zero means the ticket should be discarded right away, and servers must
+    //                         not use a lifetime of more than seven days.
+    constexpr u32 max_lifetime_in_seconds = 7 * 24 * 60 * 60;
+    if (ticket_lifetime == 0)
+        return 3 + size;
+    if (ticket_lifetime > max_lifetime_in_seconds)
+        return (i8)Error::IllegalParameter;
+
+    auto hash = hmac_hash();
+    auto pre_shared_key = hkdf_expand_label(hash, m_context.tls13.resumption_master_secret, "resumption"sv, nonce, hash_length(hash));
+    auto ticket_copy = ByteBuffer::copy(ticket);
+    if (pre_shared_key.is_error() || ticket_copy.is_error())
+        return (i8)Error::OutOfMemory;
+
+    Session session;
+    session.version = ProtocolVersion::VERSION_1_3;
+    session.cipher = m_context.cipher;
+    session.secret = pre_shared_key.release_value();
+    session.ticket = ticket_copy.release_value();
+    session.ticket_age_add = ticket_age_add;
+    session.received_at = UnixDateTime::now();
+    session.lifetime = Duration::from_seconds(ticket_lifetime);
+    m_context.options.session_handler(move(session));
+
+    return 3 + size;
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-4.6.3
+ssize_t TLSv12::handle_key_update(ReadonlyBytes buffer)
+{
+    if (buffer.size() < 4 || buffer[0] != 0 || buffer[1] != 0 || buffer[2] != 1 || buffer[3] > 1)
+        return (i8)Error::BrokenPacket;
+    bool update_requested = buffer[3] == 1;
+
+    auto hash = hmac_hash();
+    auto& tls13 = m_context.tls13;
+
+    // application_traffic_secret_N+1 = HKDF-Expand-Label(application_traffic_secret_N, "traffic upd", "", Hash.length)
+    auto next_server_secret = hkdf_expand_label(hash, tls13.server_application_traffic_secret, "traffic upd"sv, {}, hash_length(hash));
+    if (next_server_secret.is_error())
+        return (i8)Error::OutOfMemory;
+    tls13.server_application_traffic_secret = next_server_secret.release_value();
+    if (install_tls13_traffic_keys(tls13.server_application_traffic_secret, false).is_error())
+        return (i8)Error::OutOfMemory;
+
+    if (update_requested) {
+        // Our KeyUpdate still goes out with the old keys, everything after it uses the new ones.
+        auto packet = build_tls13_key_update(false);
+        write_packet(packet);
+
+        auto next_client_secret = hkdf_expand_label(hash, tls13.client_application_traffic_secret, "traffic upd"sv, {}, hash_length(hash));
+        if (next_client_secret.is_error())
+            return (i8)Error::OutOfMemory;
+        tls13.client_application_traffic_secret = next_client_secret.release_value();
+        if (install_tls13_traffic_keys(tls13.client_application_traffic_secret, true).is_error())
+            return (i8)Error::OutOfMemory;
+    }
+
+    return 4;
+}
+
+ErrorOr<void> TLSv12::derive_tls13_handshake_secrets()
+{
+    auto hash = hmac_hash();
+    auto& tls13 = m_context.tls13;
+    auto zeros = TRY(ByteBuffer::create_zeroed(hash_length(hash)));
+
+    // Early Secret = HKDF-Extract(0, PSK), where a missing PSK is a string of zeros.
+    ReadonlyBytes pre_shared_key = tls13.accepted_pre_shared_key ? m_context.options.session->secret.bytes() : zeros.bytes();
+    auto early_secret = TRY(hkdf_extract(hash, {}, pre_shared_key));
+
+    // Handshake Secret = HKDF-Extract(Derive-Secret(Early Secret, "derived", ""), (EC)DHE)
+    auto salt = TRY(derive_next_stage_salt(hash, early_secret));
+    tls13.handshake_secret = TRY(hkdf_extract(hash, salt, tls13.shared_secret));
+    tls13.shared_secret.clear();
+
+    auto transcript_hash = TRY(transcript_hash_of(m_context.handshake_hash));
+    tls13.client_handshake_traffic_secret = TRY(derive_secret(hash, tls13.handshake_secret, "c hs traffic"sv, transcript_hash));
+    tls13.server_handshake_traffic_secret = TRY(derive_secret(hash, tls13.handshake_secret, "s hs traffic"sv, transcript_hash));
+
+    // Master Secret = HKDF-Extract(Derive-Secret(Handshake Secret, "derived", ""), 0)
+    salt = TRY(derive_next_stage_salt(hash, tls13.handshake_secret));
+    tls13.master_secret = TRY(hkdf_extract(hash, salt, zeros));
+
+    TRY(install_tls13_traffic_keys(tls13.client_handshake_traffic_secret, true));
+    TRY(install_tls13_traffic_keys(tls13.server_handshake_traffic_secret, false));
+    m_context.crypto.created = 1;
+    m_context.cipher_spec_set = 1;
+    return {};
+}
+
+ErrorOr<void> TLSv12::derive_tls13_application_secrets()
+{
+    auto hash = hmac_hash();
+    auto& tls13 = m_context.tls13;
+
+    // The transcript runs up to and including the server's Finished message.
+    auto transcript_hash = TRY(transcript_hash_of(m_context.handshake_hash));
+    tls13.client_application_traffic_secret = TRY(derive_secret(hash, tls13.master_secret, "c ap traffic"sv, transcript_hash));
+    tls13.server_application_traffic_secret = TRY(derive_secret(hash, tls13.master_secret, "s ap traffic"sv, transcript_hash));
+    return {};
+}
+
+ErrorOr<void> TLSv12::derive_tls13_resumption_secret()
+{
+    auto hash = hmac_hash();
+    auto& tls13 = m_context.tls13;
+
+    // The transcript runs up to and including our Finished message.
+    auto transcript_hash = TRY(transcript_hash_of(m_context.handshake_hash));
+    tls13.resumption_master_secret = TRY(derive_secret(hash, tls13.master_secret, "res master"sv, transcript_hash));
+    return {};
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-7.3
+ErrorOr<void> TLSv12::install_tls13_traffic_keys(ReadonlyBytes traffic_secret, bool local)
+{
+    auto hash = hmac_hash();
+    auto key_size = key_length();
+    auto key = TRY(hkdf_expand_label(hash, traffic_secret, "key"sv, {}, key_size));
+    auto iv = TRY(hkdf_expand_label(hash, traffic_secret, "iv"sv, {}, iv_length()));
+
+    auto intent = local ? Crypto::Cipher::Intent::Encryption : Crypto::Cipher::Intent::Decryption;
+    auto cipher = Crypto::Cipher::AESCipher::GCMMode(key, key_size * 8, intent, Crypto::Cipher::PaddingMode::RFC5246);
+    if (local) {
+        m_cipher_local = move(cipher);
+        memcpy(m_context.crypto.local_iv, iv.data(), iv.size());
+        m_context.local_sequence_number = 0;
+    } else {
+        m_cipher_remote = move(cipher);
+        memcpy(m_context.crypto.remote_iv, iv.data(), iv.size());
+        m_context.remote_sequence_number = 0;
+    }
+    return {};
+}
+
+ByteBuffer TLSv12::build_tls13_handshake_finished()
+{
+    auto hash = hmac_hash();
+    auto transcript_hash = MUST(transcript_hash_of(m_context.handshake_hash));
+    auto verify_data = MUST(compute_finished_verify_data(hash, m_context.tls13.client_handshake_traffic_secret, transcript_hash));
+
+    PacketBuilder builder { ContentType::HANDSHAKE, m_context.options.version, verify_data.size() + 64 };
+    builder.append((u8)HandshakeType::FINISHED);
+    builder.append_u24(verify_data.size());
+    builder.append(verify_data.bytes());
+    auto packet = builder.build();
+    update_packet(packet);
+
+    return packet;
+}
+
+ByteBuffer TLSv12::build_tls13_certificate()
+{
+    auto const& context = m_context.tls13.certificate_request_context;
+
+    PacketBuilder builder { ContentType::HANDSHAKE, m_context.options.version };
+    builder.append((u8)HandshakeType::CERTIFICATE);
+    builder.append_u24(1 + context.size() + 3);
+    builder.append((u8)context.size());
+    builder.append(context.bytes());
+    // An empty certificate_list.
+    builder.append_u24(0);
+    auto packet = builder.build();
+    update_packet(packet);
+
+    return packet;
+}
+
+ByteBuffer TLSv12::build_tls13_key_update(bool request_update)
+{
+    PacketBuilder builder { ContentType::HANDSHAKE, m_context.options.version };
+    builder.append((u8)HandshakeType::KEY_UPDATE);
+    builder.append_u24(1);
+    builder.append((u8)request_update);
+    auto packet = builder.build();
+    update_packet(packet);
+
+    return packet;
+}
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibCrypto/Authentication/HMAC.h>
+#include <LibCrypto/Hash/HKDF.h>
+#include <LibTLS/KeySchedule.h>
+
+namespace TLS::KeySchedule {
+
+size_t hash_length(Crypto::Hash::HashKind hash)
+{
+    return hash == Crypto::Hash::HashKind::SHA384 ? Crypto::Hash::SHA384::DigestSize : Crypto::Hash::SHA256::DigestSize;
+}
+
+ErrorOr<ByteBuffer> hash_of(Crypto::Hash::HashKind hash, ReadonlyBytes message)
+{
+    Crypto::Hash::Manager manager(hash);
+    manager.update(message);
+    return ByteBuffer::copy(manager.digest().bytes());
+}
+
+static ErrorOr<ByteBuffer> hmac(Crypto::Hash::HashKind hash, ReadonlyBytes key, ReadonlyBytes message)
+{
+    Crypto::Authentication::HMAC<Crypto::Hash::Manager> authenticator(key, hash);
+    auto digest = authenticator.process(message);
+    return ByteBuffer::copy(digest.bytes());
+}
+
+ErrorOr<ByteBuffer> hkdf_extract(Crypto::Hash::HashKind hash, ReadonlyBytes salt, ReadonlyBytes input_keying_material)
+{
+    if (hash == Crypto::Hash::HashKind::SHA384)
+        return Crypto::Hash::HKDF::extract<Crypto::Authentication::HMAC<Crypto::Hash::SHA384>>(salt, input_keying_material);
+    return Crypto::Hash::HKDF::extract<Crypto::Authentication::HMAC<Crypto::Hash::SHA256>>(salt, input_keying_material);
+}
+
+ErrorOr<ByteBuffer> hkdf_expand_label(Crypto::Hash::HashKind hash, ReadonlyBytes secret, StringView label, ReadonlyBytes context, size_t length)
+{
+    // struct {
+    //     uint16 length = Length;
+    //     opaque label<7..255> = "tls13 " + Label;
+    //     opaque context<0..255> = Context;
+    // } HkdfLabel;
+    constexpr auto label_prefix = "tls13 "sv;
+    ByteBuffer hkdf_label;
+    TRY(hkdf_label.try_ensure_capacity(2 + 1 + label_prefix.length() + label.length() + 1 + context.size()));
+    u8 length_bytes[2] = { static_cast<u8>(length >> 8), static_cast<u8>(length) };
+    hkdf_label.append(length_bytes, sizeof(length_bytes));
+    hkdf_label.append(static_cast<u8>(label_prefix.length() + label.length()));
+    hkdf_label.append(label_prefix.bytes());
+    hkdf_label.append(label.bytes());
+    hkdf_label.append(static_cast<u8>(context.size()));
+    hkdf_label.append(context);
+
+    if (hash == Crypto::Hash::HashKind::SHA384)
+        return Crypto::Hash::HKDF::expand<Crypto::Authentication::HMAC<Crypto::Hash::SHA384>>(secret, hkdf_label, length);
+    return Crypto::Hash::HKDF::expand<Crypto::Authentication::HMAC<Crypto::Hash::SHA256>>(secret, hkdf_label, length);
+}
+
+ErrorOr<ByteBuffer> derive_secret(Crypto::Hash::HashKind hash, ReadonlyBytes secret, StringView label, ReadonlyBytes transcript_hash)
+{
+    return hkdf_expand_label(hash, secret, label, transcript_hash, hash_length(hash));
+}
+
+ErrorOr<ByteBuffer> derive_next_stage_salt(Crypto::Hash::HashKind hash, ReadonlyBytes secret)
+{
+    auto empty_hash = TRY(hash_of(hash, {}));
+    return derive_secret(hash, secret, "derived"sv, empty_hash);
+}
+
+ErrorOr<ByteBuffer> compute_finished_verify_data(Crypto::Hash::HashKind hash, ReadonlyBytes base_key, ReadonlyBytes transcript_hash)
+{
+    auto finished_key = TRY(hkdf_expand_label(hash, base_key, "finished"sv, {}, hash_length(hash)));
+    return hmac(hash, finished_key, transcript_hash);
+}
+
+}
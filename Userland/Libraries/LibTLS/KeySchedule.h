@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Error.h>
+#include <AK/StringView.h>
+#include <LibCrypto/Hash/HashManager.h>
+
+// The building blocks of the TLS 1.3 key schedule.
+// https://www.rfc-editor.org/rfc/rfc8446#section-7.1
+namespace TLS::KeySchedule {
+
+// Note: Every cipher suite we support for TLS 1.3 is built on either SHA-256 or SHA-384.
+size_t hash_length(Crypto::Hash::HashKind);
+ErrorOr<ByteBuffer> hash_of(Crypto::Hash::HashKind, ReadonlyBytes message);
+
+ErrorOr<ByteBuffer> hkdf_extract(Crypto::Hash::HashKind, ReadonlyBytes salt, ReadonlyBytes input_keying_material);
+ErrorOr<ByteBuffer> hkdf_expand_label(Crypto::Hash::HashKind, ReadonlyBytes secret, StringView label, ReadonlyBytes context, size_t length);
+
+// Derive-Secret(Secret, Label, Messages) = HKDF-Expand-Label(Secret, Label, Transcript-Hash(Messages), Hash.length)
+ErrorOr<ByteBuffer> derive_secret(Crypto::Hash::HashKind, ReadonlyBytes secret, StringView label, ReadonlyBytes transcript_hash);
+
+// The "derived" secret that links one stage of the key schedule to the next.
+ErrorOr<ByteBuffer> derive_next_stage_salt(Crypto::Hash::HashKind, ReadonlyBytes secret);
+
+// finished_key = HKDF-Expand-Label(BaseKey, "finished", "", Hash.length)
+// verify_data = HMAC(finished_key, Transcript-Hash(...))
+ErrorOr<ByteBuffer> compute_finished_verify_data(Crypto::Hash::HashKind, ReadonlyBytes base_key, ReadonlyBytes transcript_hash);
+
+}
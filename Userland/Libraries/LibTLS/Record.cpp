@@ -75,7 +75,9 @@ void TLSv12::update_packet(ByteBuffer& packet)
                 update_hash(packet.bytes(), header_size);
             }
         }
-        if (m_context.cipher_spec_set && m_context.crypto.created) {
+        if (m_context.cipher_spec_set && m_context.crypto.created && is_tls13()) {
+            encrypt_tls13_record(packet);
+        } else if (m_context.cipher_spec_set && m_context.crypto.created) {
             size_t length = packet.size() - header_size;
             size_t block_size = 0;
             size_t padding = 0;
@@ -232,6 +234,118 @@ void TLSv12::update_packet(ByteBuffer& packet)
     ++m_context.local_sequence_number;
 }
 
+// https://www.rfc-editor.org/rfc/rfc8446#section-5.3
+static void compute_tls13_nonce(Bytes iv, u8 const* static_iv, u64 sequence_number)
+{
+    // The 64-bit record sequence number is XORed with the right end of the static IV.
+    // -- Our GCM impl takes 16 bytes, the last 4 of which are the (zero) counter.
+    VERIFY(iv.size() == 16);
+    memcpy(iv.data(), static_iv, 12);
+    for (size_t i = 0; i < 8; ++i)
+        iv[4 + i] ^= (sequence_number >> (56 - 8 * i)) & 0xff;
+    memset(iv.offset(12), 0, 4);
+}
+
+// https://www.rfc-editor.org/rfc/rfc8446#section-5.2
+void TLSv12::encrypt_tls13_record(ByteBuffer& packet)
+{
+    constexpr size_t header_size = 5;
+    constexpr size_t tag_size = 16;
+    auto content_length = packet.size() - header_size;
+
+    // TLSInnerPlaintext: the content, followed by its actual type (and no padding).
+    auto inner_plaintext_result = ByteBuffer::create_uninitialized(content_length + 1);
+    auto ciphertext_result = ByteBuffer::create_uninitialized(header_size + content_length + 1 + tag_size);
+    if (inner_plaintext_result.is_error() || ciphertext_result.is_error()) {
+        dbgln("LibTLS: Failed to allocate enough memory for the ciphertext");
+        VERIFY_NOT_REACHED();
+    }
+    auto inner_plaintext = inner_plaintext_result.release_value();
+    inner_plaintext.overwrite(0, packet.offset_pointer(header_size), content_length);
+    inner_plaintext[content_length] = packet[0];
+
+    auto ciphertext = ciphertext_result.release_value();
+
+    // The record poses as application data, and its header is the additional data.
+    u8 aad[header_size];
+    aad[0] = (u8)ContentType::APPLICATION_DATA;
+    ByteReader::store(aad + 1, AK::convert_between_host_and_network_endian((u16)ProtocolVersion::VERSION_1_2));
+    ByteReader::store(aad + 3, AK::convert_between_host_and_network_endian((u16)(ciphertext.size() - header_size)));
+    ciphertext.overwrite(0, aad, header_size);
+
+    u8 iv[16];
+    compute_tls13_nonce({ iv, sizeof(iv) }, m_context.crypto.local_iv, m_context.local_sequence_number);
+
+    m_cipher_local.get<Crypto::Cipher::AESCipher::GCMMode>().encrypt(
+        inner_plaintext,
+        ciphertext.bytes().slice(header_size, inner_plaintext.size()),
+        { iv, sizeof(iv) },
+        { aad, header_size },
+        ciphertext.bytes().slice(header_size + inner_plaintext.size(), tag_size));
+
+    packet = move(ciphertext);
+}
+
+ssize_t TLSv12::decrypt_tls13_record(ReadonlyBytes record, ByteBuffer& plaintext, ContentType& type)
+{
+    constexpr size_t header_size = 5;
+    constexpr size_t tag_size = 16;
+    auto ciphertext = record.slice(header_size);
+
+    if (ciphertext.size() < tag_size + 1) {
+        dbgln("Invalid packet length");
+        auto packet = build_alert(true, (u8)AlertDescription::DECRYPT_ERROR);
+        write_packet(packet);
+        return (i8)Error::BrokenPacket;
+    }
+
+    auto plaintext_result = ByteBuffer::create_uninitialized(ciphertext.size() - tag_size);
+    if (plaintext_result.is_error()) {
+        dbgln("Failed to allocate memory for the packet");
+        return (i8)Error::DecryptionFailed;
+    }
+    plaintext = plaintext_result.release_value();
+
+    u8 iv[16];
+    compute_tls13_nonce({ iv, sizeof(iv) }, m_context.crypto.remote_iv, m_context.remote_sequence_number);
+
+    auto consistency = m_cipher_remote.get<Crypto::Cipher::AESCipher::GCMMode>().decrypt(
+        ciphertext.slice(0, plaintext.size()),
+        plaintext,
+        { iv, sizeof(iv) },
+        record.slice(0, header_size),
+        ciphertext.slice(plaintext.size()));
+
+    if (consistency != Crypto::VerificationConsistency::Consistent) {
+        dbgln("integrity check failed");
+        auto packet = build_alert(true, (u8)AlertDescription::BAD_RECORD_MAC);
+        write_packet(packet);
+        return (i8)Error::IntegrityCheckFailed;
+    }
+
+    // The actual content type is the last non-zero byte, anything after it is padding.
+    auto length = plaintext.size();
+    while (length > 0 && plaintext[length - 1] == 0)
+        --length;
+    if (length == 0) {
+        dbgln("record without a content type");
+        auto packet = build_alert(true, (u8)AlertDescription::UNEXPECTED_MESSAGE);
+        write_packet(packet);
+        return (i8)Error::UnexpectedMessage;
+    }
+    type = (ContentType)plaintext[length - 1];
+    plaintext.resize(length - 1);
+
+    if (type == ContentType::CHANGE_CIPHER_SPEC) {
+        dbgln("unexpected protected change cipher spec message");
+        auto packet = build_alert(true, (u8)AlertDescription::UNEXPECTED_MESSAGE);
+        write_packet(packet);
+        return (i8)Error::UnexpectedMessage;
+    }
+
+    return 0;
+}
+
 void TLSv12::update_hash(ReadonlyBytes message, size_t header_size)
 {
     dbgln_if(TLS_DEBUG, "Update hash with message of size {}", message.size());
@@ -345,7 +459,31 @@ ssize_t TLSv12::handle_message(ReadonlyBytes buffer)
 
     ByteBuffer decrypted;
 
-    if (m_context.cipher_spec_set && type != ContentType::CHANGE_CIPHER_SPEC) {
+    if (is_tls13() && type == ContentType::CHANGE_CIPHER_SPEC) {
+        // RFC 8446 section 5: A change_cipher_spec record of a single 0x01 byte that shows up during the handshake is
+        //                     only there to keep middleboxes happy, and it is dropped without counting as a record.
+        if (m_context.connection_status == ConnectionStatus::Established || length != 1 || plain[0] != 1) {
+            dbgln("unexpected change cipher message");
+            auto packet = build_alert(true, (u8)AlertDescription::UNEXPECTED_MESSAGE);
+            write_packet(packet);
+            return (i8)Error::UnexpectedMessage;
+        }
+        return header_size + length;
+    }
+
+    if (is_tls13() && m_context.cipher_spec_set) {
+        // Everything but an alert that the server sent before it could read our protected records is protected.
+        if (type == ContentType::APPLICATION_DATA) {
+            if (auto result = decrypt_tls13_record(buffer.slice(0, header_size + length), decrypted, type); result < 0)
+                return result;
+            plain = decrypted;
+        } else if (type != ContentType::ALERT) {
+            dbgln("unexpected unprotected message");
+            auto packet = build_alert(true, (u8)AlertDescription::UNEXPECTED_MESSAGE);
+            write_packet(packet);
+            return (i8)Error::UnexpectedMessage;
+        }
+    } else if (m_context.cipher_spec_set && type != ContentType::CHANGE_CIPHER_SPEC) {
         if constexpr (TLS_DEBUG) {
             dbgln("Encrypted: ");
             print_buffer(buffer.slice(header_size, length));
@@ -524,7 +662,7 @@ ssize_t TLSv12::handle_message(ReadonlyBytes buffer)
         break;
     case ContentType::ALERT:
         dbgln_if(TLS_DEBUG, "alert message of length {}", length);
-        if (length >= 2) {
+        if (plain.size() >= 2) {
             if constexpr (TLS_DEBUG)
                 print_buffer(plain);
 
@@ -541,7 +679,8 @@ ssize_t TLSv12::handle_message(ReadonlyBytes buffer)
 
             if (code == (u8)AlertDescription::CLOSE_NOTIFY) {
                 res += 2;
-                alert(AlertLevel::FATAL, AlertDescription::CLOSE_NOTIFY);
+                // RFC 5246 section 7.2.1: close_notify is a warning, a fatal alert makes servers forget the session.
+                alert(AlertLevel::WARNING, AlertDescription::CLOSE_NOTIFY);
                 if (!m_context.cipher_spec_set) {
                     // AWS CloudFront hits this.
                     dbgln("Server sent a close notify and we haven't agreed on a cipher suite. Treating it as a handshake failure.");
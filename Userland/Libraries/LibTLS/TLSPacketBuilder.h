@@ -43,6 +43,11 @@ public:
     {
         append(data.data(), data.size());
     }
+    inline void append_u32(u32 value)
+    {
+        value = AK::convert_between_host_and_network_endian(value);
+        append((u8 const*)&value, sizeof(value));
+    }
     inline void append_u24(u32 value)
     {
         u8 buf[3];
@@ -80,6 +85,16 @@ public:
         VERIFY(offset < m_current_length);
         m_packet_data[offset] = value;
     }
+    inline void set_u16(size_t offset, u16 value)
+    {
+        set(offset, value >> 8);
+        set(offset + 1, value & 0xff);
+    }
+    inline void set_u24(size_t offset, u32 value)
+    {
+        set(offset, (value >> 16) & 0xff);
+        set_u16(offset + 1, value & 0xffff);
+    }
     size_t length() const { return m_current_length; }
 
 private:
@@ -513,6 +513,11 @@ TLSv12::TLSv12(StreamVariantType stream, Options options)
     m_context.options = move(options);
     m_context.is_server = false;
     m_context.tls_buffer = {};
+    m_context.alpn = m_context.options.alpn_protocols;
+
+    // There is no point in offering the TLS 1.3 cipher suites when we don't offer TLS 1.3.
+    if (m_context.options.max_version != ProtocolVersion::VERSION_1_3)
+        m_context.options.usable_cipher_suites.remove_all_matching([](auto suite) { return is_tls13_cipher_suite(suite); });
 
     set_root_certificates(m_context.options.root_certificates.has_value()
             ? *m_context.options.root_certificates
@@ -9,6 +9,7 @@
 #include "Certificate.h"
 #include <AK/IPv4Address.h>
 #include <AK/Queue.h>
+#include <AK/Time.h>
 #include <AK/WeakPtr.h>
 #include <LibCore/Notifier.h>
 #include <LibCore/Socket.h>
@@ -63,6 +64,7 @@ enum class Error : i8 {
     NeedMoreData = -21,
     TimedOut = -22,
     OutOfMemory = -23,
+    IllegalParameter = -24,
 };
 
 enum class WritePacketStage {
@@ -70,6 +72,9 @@ enum class WritePacketStage {
     ClientHandshake = 1,
     ServerHandshake = 2,
     Finished = 3,
+    // TLS 1.3 only
+    HelloRetry = 4,
+    HandshakeKeys = 5,
 };
 
 enum class ConnectionStatus {
@@ -95,7 +100,12 @@ enum ClientVerificationStaus {
 // the preferred order.
 //
 // https://wiki.mozilla.org/Security/Server_Side_TLS
+//
+// The TLS 1.3 cipher suites come first, as they are only ever picked by servers that speak TLS 1.3 anyway.
+// Their iv size is that of the per-record nonce, which is never sent as part of the record.
 #define ENUMERATE_CIPHERS(C)                                                                                                                                      \
+    C(true, CipherSuite::TLS_AES_128_GCM_SHA256, KeyExchangeAlgorithm::KEY_SHARE, CipherAlgorithm::AES_128_GCM, Crypto::Hash::SHA256, 12, true)                   \
+    C(true, CipherSuite::TLS_AES_256_GCM_SHA384, KeyExchangeAlgorithm::KEY_SHARE, CipherAlgorithm::AES_256_GCM, Crypto::Hash::SHA384, 12, true)                   \
     C(true, CipherSuite::TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, KeyExchangeAlgorithm::ECDHE_ECDSA, CipherAlgorithm::AES_128_GCM, Crypto::Hash::SHA256, 8, true) \
     C(true, CipherSuite::TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256, KeyExchangeAlgorithm::ECDHE_RSA, CipherAlgorithm::AES_128_GCM, Crypto::Hash::SHA256, 8, true)     \
     C(true, CipherSuite::TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384, KeyExchangeAlgorithm::ECDHE_ECDSA, CipherAlgorithm::AES_256_GCM, Crypto::Hash::SHA384, 8, true) \
@@ -139,6 +149,50 @@ constexpr CipherAlgorithm get_cipher_algorithm(CipherSuite suite)
     }
 }
 
+constexpr bool is_tls13_cipher_suite(CipherSuite suite)
+{
+    return get_key_exchange_algorithm(suite) == KeyExchangeAlgorithm::KEY_SHARE;
+}
+
+// The hash that the TLS 1.2 PRF and the TLS 1.3 key schedule are built on, which is never weaker than SHA-256.
+constexpr Crypto::Hash::HashKind get_hash_kind(CipherSuite suite)
+{
+    switch (suite) {
+#define C(is_supported, suite, key_exchange, cipher, hash, iv_size, is_aead)                    \
+    case suite:                                                                                 \
+        if constexpr (hash ::DigestSize == Crypto::Hash::SHA384::DigestSize)                    \
+            return Crypto::Hash::HashKind::SHA384;                                              \
+        return Crypto::Hash::HashKind::SHA256;
+        ENUMERATE_CIPHERS(C)
+#undef C
+    default:
+        return Crypto::Hash::HashKind::SHA256;
+    }
+}
+
+// What it takes to resume a connection to the same server later on without a full handshake: a TLS 1.2 session
+// ID and/or ticket along with the master secret, or a TLS 1.3 ticket along with the pre-shared key that goes with it.
+// https://www.rfc-editor.org/rfc/rfc5246#appendix-F.1.4
+// https://www.rfc-editor.org/rfc/rfc5077
+// https://www.rfc-editor.org/rfc/rfc8446#section-2.2
+struct Session {
+    ProtocolVersion version { ProtocolVersion::VERSION_1_2 };
+    CipherSuite cipher { CipherSuite::TLS_NULL_WITH_NULL_NULL };
+
+    // The master secret for TLS 1.2, the pre-shared key for TLS 1.3.
+    ByteBuffer secret;
+
+    ByteBuffer session_id;
+    ByteBuffer ticket;
+    u32 ticket_age_add { 0 };
+    bool extended_master_secret { false };
+
+    UnixDateTime received_at;
+    Duration lifetime;
+
+    bool is_expired() const { return UnixDateTime::now() >= received_at + lifetime; }
+};
+
 struct Options {
     static Vector<CipherSuite> default_usable_cipher_suites()
     {
@@ -169,8 +223,14 @@ struct Options {
         return move(*this);                  \
     }
 
+    // The version that goes into the record headers, which stays at TLS 1.2 even when TLS 1.3 is negotiated.
     OPTION_WITH_DEFAULTS(ProtocolVersion, version, ProtocolVersion::VERSION_1_2)
+    // The newest version to offer.
+    OPTION_WITH_DEFAULTS(ProtocolVersion, max_version, ProtocolVersion::VERSION_1_3)
     OPTION_WITH_DEFAULTS(Vector<SignatureAndHashAlgorithm>, supported_signature_algorithms,
+        { HashAlgorithm::INTRINSIC, SignatureAlgorithm::RSA_PSS_RSAE_SHA512 },
+        { HashAlgorithm::INTRINSIC, SignatureAlgorithm::RSA_PSS_RSAE_SHA384 },
+        { HashAlgorithm::INTRINSIC, SignatureAlgorithm::RSA_PSS_RSAE_SHA256 },
         { HashAlgorithm::SHA512, SignatureAlgorithm::RSA },
         { HashAlgorithm::SHA384, SignatureAlgorithm::RSA },
         { HashAlgorithm::SHA256, SignatureAlgorithm::RSA },
@@ -195,6 +255,15 @@ struct Options {
     OPTION_WITH_DEFAULTS(Function<Vector<Certificate>()>, certificate_provider, [] { return Vector<Certificate> {}; })
     OPTION_WITH_DEFAULTS(bool, enable_extended_master_secret, true)
 
+    // https://www.rfc-editor.org/rfc/rfc7301
+    // The application protocols to offer, most preferred first.
+    OPTION_WITH_DEFAULTS(Vector<ByteString>, alpn_protocols, )
+
+    // A session handed out by an earlier connection to the same server, which is resumed if the server still knows it.
+    OPTION_WITH_DEFAULTS(Optional<Session>, session, )
+    // Called with each session the server lets us resume later on; TLS 1.3 tickets are meant to be used only once.
+    OPTION_WITH_DEFAULTS(Function<void(Session)>, session_handler, [](auto) {})
+
 #undef OPTION_WITH_DEFAULTS
 };
 
@@ -247,6 +316,7 @@ struct Context {
     u8 session_id[32];
     u8 session_id_size { 0 };
     CipherSuite cipher;
+    ProtocolVersion negotiated_version { ProtocolVersion::VERSION_1_2 };
     bool is_server { false };
     Vector<Certificate> certificates;
     Certificate private_key;
@@ -298,12 +368,12 @@ struct Context {
     bool has_invoked_finish_or_error_callback { false };
 
     // message flags
-    u8 handshake_messages[11] { 0 };
+    u8 handshake_messages[13] { 0 };
     ByteBuffer user_data;
     HashMap<ByteString, Certificate> root_certificates;
 
     Vector<ByteString> alpn;
-    StringView negotiated_alpn;
+    ByteString negotiated_alpn;
 
     size_t send_retries { 0 };
 
@@ -316,6 +386,40 @@ struct Context {
     } server_diffie_hellman_params;
 
     OwnPtr<Crypto::Curves::EllipticCurve> server_key_exchange_curve;
+
+    struct {
+        // Whether the server accepted the session we offered, and the ticket it gave us for the next one.
+        bool resumed { false };
+        bool server_will_send_ticket { false };
+        ByteBuffer ticket;
+        u32 ticket_lifetime { 0 };
+    } tls12_session;
+
+    // https://www.rfc-editor.org/rfc/rfc8446#section-7.1
+    struct {
+        SupportedGroup key_share_group {};
+        OwnPtr<Crypto::Curves::EllipticCurve> key_share_curve;
+        ByteBuffer key_share_private_key;
+        ByteBuffer key_share_public_key;
+        ByteBuffer shared_secret;
+
+        bool received_hello_retry_request { false };
+        ByteBuffer cookie;
+
+        bool offered_pre_shared_key { false };
+        bool accepted_pre_shared_key { false };
+
+        bool should_send_certificate { false };
+        ByteBuffer certificate_request_context;
+
+        ByteBuffer handshake_secret;
+        ByteBuffer master_secret;
+        ByteBuffer client_handshake_traffic_secret;
+        ByteBuffer server_handshake_traffic_secret;
+        ByteBuffer client_application_traffic_secret;
+        ByteBuffer server_application_traffic_secret;
+        ByteBuffer resumption_master_secret;
+    } tls13;
 };
 
 class TLSv12 final : public Core::Socket {
@@ -378,6 +482,7 @@ public:
 
     static Vector<Certificate> parse_pem_certificate(ReadonlyBytes certificate_pem_buffer, ReadonlyBytes key_pem_buffer);
 
+    // The application protocol the server picked from the ones offered, if any.
     StringView alpn() const { return m_context.negotiated_alpn; }
 
     bool supports_cipher(CipherSuite suite) const
@@ -395,9 +500,11 @@ public:
 
     bool supports_version(ProtocolVersion v) const
     {
-        return v == ProtocolVersion::VERSION_1_2;
+        return v == ProtocolVersion::VERSION_1_2 || (v == ProtocolVersion::VERSION_1_3 && m_context.options.max_version == ProtocolVersion::VERSION_1_3);
     }
 
+    bool is_tls13() const { return m_context.negotiated_version == ProtocolVersion::VERSION_1_3; }
+
     void alert(AlertLevel, AlertDescription);
 
     Function<void(AlertDescription)> on_tls_error;
@@ -407,6 +514,7 @@ public:
 
 private:
     void setup_connection();
+    void establish_connection();
 
     void consume(ReadonlyBytes record);
 
@@ -423,6 +531,9 @@ private:
 
     ByteBuffer build_hello();
     ByteBuffer build_handshake_finished();
+    ByteBuffer build_tls13_handshake_finished();
+    ByteBuffer build_tls13_certificate();
+    ByteBuffer build_tls13_key_update(bool request_update);
     ByteBuffer build_certificate();
     ByteBuffer build_alert(bool critical, u8 code);
     ByteBuffer build_change_cipher_spec();
@@ -438,7 +549,10 @@ private:
     void notify_client_for_app_data();
 
     ssize_t handle_server_hello(ReadonlyBytes, WritePacketStage&);
+    ssize_t handle_application_layer_protocol_negotiation(ReadonlyBytes);
+    ssize_t handle_session_resumption();
     ssize_t handle_handshake_finished(ReadonlyBytes, WritePacketStage&);
+    ssize_t handle_new_session_ticket(ReadonlyBytes);
     ssize_t handle_certificate(ReadonlyBytes);
     ssize_t handle_server_key_exchange(ReadonlyBytes);
     ssize_t handle_dhe_rsa_server_key_exchange(ReadonlyBytes);
@@ -450,10 +564,35 @@ private:
     ssize_t handle_handshake_payload(ReadonlyBytes);
     ssize_t handle_message(ReadonlyBytes);
 
+    // TLS 1.3, see HandshakeTLS13.cpp
+    ErrorOr<void> generate_key_share(SupportedGroup);
+    void append_pre_shared_key(PacketBuilder&, Session const&);
+    ErrorOr<void> write_pre_shared_key_binder(ByteBuffer& client_hello, Session const&);
+    ssize_t handle_hello_retry_request(Optional<SupportedGroup> selected_group, WritePacketStage&);
+    ssize_t handle_tls13_server_hello(Optional<SupportedGroup> server_key_share_group, ReadonlyBytes server_key_share, Optional<u16> selected_identity, WritePacketStage&);
+    ssize_t handle_tls13_handshake_message(HandshakeType, ReadonlyBytes, WritePacketStage&);
+    ssize_t handle_encrypted_extensions(ReadonlyBytes);
+    ssize_t handle_tls13_certificate_request(ReadonlyBytes);
+    ssize_t handle_tls13_certificate(ReadonlyBytes);
+    ssize_t handle_tls13_certificate_verify(ReadonlyBytes);
+    ssize_t handle_tls13_handshake_finished(ReadonlyBytes, WritePacketStage&);
+    ssize_t handle_tls13_new_session_ticket(ReadonlyBytes);
+    ssize_t handle_key_update(ReadonlyBytes);
+    ErrorOr<void> derive_tls13_handshake_secrets();
+    ErrorOr<void> derive_tls13_application_secrets();
+    ErrorOr<void> derive_tls13_resumption_secret();
+    ErrorOr<void> install_tls13_traffic_keys(ReadonlyBytes traffic_secret, bool local);
+    ssize_t decrypt_tls13_record(ReadonlyBytes record, ByteBuffer& plaintext, ContentType& type);
+    void encrypt_tls13_record(ByteBuffer& packet);
+    Session make_tls12_session() const;
+
     void pseudorandom_function(Bytes output, ReadonlyBytes secret, u8 const* label, size_t label_length, ReadonlyBytes seed, ReadonlyBytes seed_b);
 
     ssize_t verify_rsa_server_key_exchange(ReadonlyBytes server_key_info_buffer, ReadonlyBytes signature_buffer);
     ssize_t verify_ecdsa_server_key_exchange(ReadonlyBytes server_key_info_buffer, ReadonlyBytes signature_buffer);
+    Crypto::VerificationConsistency verify_rsa_signature(ReadonlyBytes message, ReadonlyBytes signature, Crypto::Hash::HashKind, bool is_pss);
+
+    static OwnPtr<Crypto::Curves::EllipticCurve> create_elliptic_curve(SupportedGroup);
 
     size_t key_length() const
     {
@@ -910,6 +910,7 @@ void KeyframeEffect::update_style_properties()
         return;
     }
 
+    target->unshare_computed_css_values();
     auto* style = target->computed_css_values();
     if (!style)
         return;
@@ -921,9 +922,10 @@ void KeyframeEffect::update_style_properties()
 
     // Traversal of the subtree is necessary to update the animated properties inherited from the target element.
     target->for_each_in_subtree_of_type<DOM::Element>([&](auto& element) {
-        auto* element_style = element.computed_css_values();
-        if (!element_style || !element.layout_node())
+        if (!element.computed_css_values() || !element.layout_node())
             return IterationDecision::Continue;
+        element.unshare_computed_css_values();
+        auto* element_style = element.computed_css_values();
 
         for (auto i = to_underlying(CSS::first_property_id); i <= to_underlying(CSS::last_property_id); ++i) {
             if (element_style->is_property_inherited(static_cast<CSS::PropertyID>(i))) {
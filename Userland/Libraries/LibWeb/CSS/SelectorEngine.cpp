@@ -801,4 +801,38 @@ bool can_use_fast_matches(CSS::Selector const& selector)
     return true;
 }
 
+bool can_match_off_main_thread(CSS::Selector const& selector)
+{
+    if (!can_use_fast_matches(selector))
+        return false;
+
+    // Of the selectors that fast_matches() handles, these are the ones that need more than reading the DOM tree:
+    // :local-link and :enabled/:disabled look at URLs and form state, and named namespaces are looked up by copying
+    // the namespace's name, none of which is safe to do off the main thread.
+    for (auto const& compound_selector : selector.compound_selectors()) {
+        for (auto const& simple_selector : compound_selector.simple_selectors) {
+            switch (simple_selector.type) {
+            case CSS::Selector::SimpleSelector::Type::PseudoClass: {
+                auto const pseudo_class = simple_selector.pseudo_class().type;
+                if (pseudo_class == CSS::PseudoClass::LocalLink
+                    || pseudo_class == CSS::PseudoClass::Enabled
+                    || pseudo_class == CSS::PseudoClass::Disabled) {
+                    return false;
+                }
+                break;
+            }
+            case CSS::Selector::SimpleSelector::Type::TagName:
+            case CSS::Selector::SimpleSelector::Type::Universal:
+                if (simple_selector.qualified_name().namespace_type == CSS::Selector::SimpleSelector::QualifiedName::NamespaceType::Named)
+                    return false;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
 }
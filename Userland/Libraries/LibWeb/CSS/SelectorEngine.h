@@ -15,5 +15,6 @@ bool matches(CSS::Selector const&, Optional<CSS::CSSStyleSheet const&> style_she
 
 [[nodiscard]] bool fast_matches(CSS::Selector const&, Optional<CSS::CSSStyleSheet const&> style_sheet_for_rule, DOM::Element const&);
 [[nodiscard]] bool can_use_fast_matches(CSS::Selector const&);
+[[nodiscard]] bool can_match_off_main_thread(CSS::Selector const&);
 
 }
@@ -7,6 +7,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/BinarySearch.h>
 #include <AK/Debug.h>
 #include <AK/Error.h>
@@ -16,6 +17,7 @@
 #include <AK/Math.h>
 #include <AK/QuickSort.h>
 #include <AK/TemporaryChange.h>
+#include <LibCore/System.h>
 #include <LibGfx/Font/Font.h>
 #include <LibGfx/Font/FontDatabase.h>
 #include <LibGfx/Font/FontStyleMapping.h>
@@ -24,6 +26,7 @@
 #include <LibGfx/Font/VectorFont.h>
 #include <LibGfx/Font/WOFF/Font.h>
 #include <LibGfx/Font/WOFF2/Font.h>
+#include <LibThreading/WorkerThread.h>
 #include <LibWeb/Animations/AnimationEffect.h>
 #include <LibWeb/Animations/DocumentTimeline.h>
 #include <LibWeb/Animations/TimingFunction.h>
@@ -65,6 +68,7 @@
 #include <LibWeb/DOM/Attr.h>
 #include <LibWeb/DOM/Document.h>
 #include <LibWeb/DOM/Element.h>
+#include <LibWeb/DOM/NamedNodeMap.h>
 #include <LibWeb/DOM/ShadowRoot.h>
 #include <LibWeb/HTML/HTMLBRElement.h>
 #include <LibWeb/HTML/HTMLHtmlElement.h>
@@ -313,18 +317,48 @@ StyleComputer::RuleCache const& StyleComputer::rule_cache_for_cascade_origin(Cas
     return true;
 }
 
-bool StyleComputer::should_reject_with_ancestor_filter(Selector const& selector) const
+bool StyleComputer::should_reject_with_ancestor_filter(AncestorFilter const& ancestor_filter, Selector const& selector)
 {
     for (u32 hash : selector.ancestor_hashes()) {
         if (hash == 0)
             break;
-        if (!m_ancestor_filter.may_contain(hash))
+        if (!ancestor_filter.may_contain(hash))
             return true;
     }
     return false;
 }
 
 Vector<MatchingRule> StyleComputer::collect_matching_rules(DOM::Element const& element, CascadeOrigin cascade_origin, Optional<CSS::Selector::PseudoElement::Type> pseudo_element) const
+{
+    Vector<MatchingRule> matching_rules;
+
+    if (!pseudo_element.has_value()) {
+        if (auto it = m_rules_matched_in_parallel.find(element); it != m_rules_matched_in_parallel.end()) {
+            switch (cascade_origin) {
+            case CascadeOrigin::Author:
+                matching_rules = it->value.author_rules;
+                break;
+            case CascadeOrigin::User:
+                matching_rules = it->value.user_rules;
+                break;
+            case CascadeOrigin::UserAgent:
+                matching_rules = it->value.user_agent_rules;
+                break;
+            default:
+                VERIFY_NOT_REACHED();
+            }
+            append_matching_rules(matching_rules, element, cascade_origin, pseudo_element, m_ancestor_filter, RulesToMatch::OnMainThread);
+            return matching_rules;
+        }
+    }
+
+    append_matching_rules(matching_rules, element, cascade_origin, pseudo_element, m_ancestor_filter, RulesToMatch::All);
+    return matching_rules;
+}
+
+// NOTE: With RulesToMatch::OffMainThread, this may run on any thread, so it must not touch anything but the DOM tree,
+//       the rule cache and the ancestor filter, and not even ref-count what it finds there.
+void StyleComputer::append_matching_rules(Vector<MatchingRule>& matching_rules, DOM::Element const& element, CascadeOrigin cascade_origin, Optional<CSS::Selector::PseudoElement::Type> pseudo_element, AncestorFilter const& ancestor_filter, RulesToMatch rules_to_match) const
 {
     auto const& root_node = element.root();
     auto shadow_root = is<DOM::ShadowRoot>(root_node) ? static_cast<DOM::ShadowRoot const*>(&root_node) : nullptr;
@@ -334,16 +368,17 @@ Vector<MatchingRule> StyleComputer::collect_matching_rules(DOM::Element const& e
     Vector<MatchingRule, 512> rules_to_run;
     auto add_rules_to_run = [&](Vector<MatchingRule> const& rules) {
         rules_to_run.grow_capacity(rules_to_run.size() + rules.size());
-        if (pseudo_element.has_value()) {
-            for (auto const& rule : rules) {
-                if (rule.contains_pseudo_element && filter_namespace_rule(element, rule))
-                    rules_to_run.unchecked_append(rule);
-            }
-        } else {
-            for (auto const& rule : rules) {
-                if (!rule.contains_pseudo_element && filter_namespace_rule(element, rule))
-                    rules_to_run.unchecked_append(rule);
+        for (auto const& rule : rules) {
+            if (rule.contains_pseudo_element != pseudo_element.has_value())
+                continue;
+            if (rules_to_match == RulesToMatch::NeedingRevalidationForStyleSharing) {
+                if (!rule.needs_revalidation_for_style_sharing)
+                    continue;
+            } else if (rules_to_match != RulesToMatch::All && rule.can_match_off_main_thread != (rules_to_match == RulesToMatch::OffMainThread)) {
+                continue;
             }
+            if (filter_namespace_rule(element, rule))
+                rules_to_run.unchecked_append(rule);
         }
     };
 
@@ -351,7 +386,7 @@ Vector<MatchingRule> StyleComputer::collect_matching_rules(DOM::Element const& e
         if (auto it = rule_cache.rules_by_class.find(class_name); it != rule_cache.rules_by_class.end())
             add_rules_to_run(it->value);
     }
-    if (auto id = element.id(); id.has_value()) {
+    if (auto const& id = element.id(); id.has_value()) {
         if (auto it = rule_cache.rules_by_id.find(id.value()); it != rule_cache.rules_by_id.end())
             add_rules_to_run(it->value);
     }
@@ -370,8 +405,7 @@ Vector<MatchingRule> StyleComputer::collect_matching_rules(DOM::Element const& e
 
     add_rules_to_run(rule_cache.other_rules);
 
-    Vector<MatchingRule> matching_rules;
-    matching_rules.ensure_capacity(rules_to_run.size());
+    matching_rules.ensure_capacity(matching_rules.size() + rules_to_run.size());
     for (auto const& rule_to_run : rules_to_run) {
         // FIXME: This needs to be revised when adding support for the :host and ::shadow selectors, which transition shadow tree boundaries
         auto rule_root = rule_to_run.shadow_root;
@@ -381,7 +415,7 @@ Vector<MatchingRule> StyleComputer::collect_matching_rules(DOM::Element const& e
 
         auto const& selector = rule_to_run.rule->selectors()[rule_to_run.selector_index];
 
-        if (should_reject_with_ancestor_filter(*selector))
+        if (should_reject_with_ancestor_filter(ancestor_filter, *selector))
             continue;
 
         if (rule_to_run.can_use_fast_matches) {
@@ -391,9 +425,8 @@ Vector<MatchingRule> StyleComputer::collect_matching_rules(DOM::Element const& e
             if (!SelectorEngine::matches(selector, *rule_to_run.sheet, element, pseudo_element))
                 continue;
         }
-        matching_rules.append(rule_to_run);
+        matching_rules.unchecked_append(rule_to_run);
     }
-    return matching_rules;
 }
 
 static void sort_matching_rules(Vector<MatchingRule>& matching_rules)
@@ -2333,6 +2366,125 @@ RefPtr<StyleProperties> StyleComputer::compute_pseudo_element_style_if_needed(DO
     return compute_style_impl(element, move(pseudo_element), ComputeStyleMode::CreatePseudoElementStyleIfNeeded);
 }
 
+bool StyleComputer::can_share_style(DOM::Element const& element)
+{
+    // Inline style, animations and the properties they animate all belong to a single element.
+    if (element.use_pseudo_element().has_value() || element.inline_style() || element.has_associated_animations() || element.cached_animation_name_animation())
+        return false;
+    auto const* parent = element.parent_or_shadow_host_element();
+    return parent && parent->computed_css_values();
+}
+
+bool StyleComputer::matches_same_revalidation_rules(DOM::Element const& element, DOM::Element const& other) const
+{
+    // NOTE: The ancestor filter is set up for the element's ancestors, but the other element's ancestors have the same
+    //       local names and attributes (see needs_revalidation_for_style_sharing()), so it works for both.
+    for (auto cascade_origin : { CascadeOrigin::UserAgent, CascadeOrigin::User, CascadeOrigin::Author }) {
+        Vector<MatchingRule> rules;
+        append_matching_rules(rules, element, cascade_origin, {}, m_ancestor_filter, RulesToMatch::NeedingRevalidationForStyleSharing);
+        Vector<MatchingRule> other_rules;
+        append_matching_rules(other_rules, other, cascade_origin, {}, m_ancestor_filter, RulesToMatch::NeedingRevalidationForStyleSharing);
+
+        if (rules.size() != other_rules.size())
+            return false;
+        for (auto const& rule : rules) {
+            auto it = other_rules.find_if([&](auto const& other_rule) {
+                return other_rule.rule == rule.rule && other_rule.selector_index == rule.selector_index;
+            });
+            if (it.is_end())
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool have_same_local_name_and_attributes(DOM::Element const& element, DOM::Element const& other)
+{
+    if (element.local_name() != other.local_name() || element.namespace_uri() != other.namespace_uri())
+        return false;
+
+    auto const& attributes = *element.attributes();
+    auto const& other_attributes = *other.attributes();
+    if (attributes.length() != other_attributes.length())
+        return false;
+    for (size_t i = 0; i < attributes.length(); ++i) {
+        auto const* attribute = attributes.item(i);
+        auto const* other_attribute = other_attributes.get_attribute_ns(attribute->namespace_uri(), attribute->local_name());
+        if (!other_attribute || other_attribute->value() != attribute->value())
+            return false;
+    }
+    return true;
+}
+
+// Custom properties aren't part of the StyleProperties, and var() looks them up through the element's ancestors instead.
+// Those are the same from the closest common ancestor up, so it's enough that none of the ones below it have any.
+static bool inherit_same_custom_properties(DOM::Element const& element, DOM::Element const& other)
+{
+    auto const* ancestor = element.parent_element();
+    auto const* other_ancestor = other.parent_element();
+    while (ancestor != other_ancestor) {
+        if (ancestor && !ancestor->custom_properties({}).is_empty())
+            return false;
+        if (other_ancestor && !other_ancestor->custom_properties({}).is_empty())
+            return false;
+        ancestor = ancestor ? ancestor->parent_element() : nullptr;
+        other_ancestor = other_ancestor ? other_ancestor->parent_element() : nullptr;
+    }
+    return true;
+}
+
+RefPtr<StyleProperties> StyleComputer::find_shared_style(DOM::Element& element) const
+{
+    auto const* parent_style = element.parent_or_shadow_host_element()->computed_css_values();
+
+    for (size_t i = 0; i < m_style_sharing_candidates.size(); ++i) {
+        auto const& candidate = m_style_sharing_candidates[i];
+        if (candidate.parent_style.ptr() != parent_style)
+            continue;
+        // Rules from shadow trees only apply within them.
+        if (&candidate.element->root() != &element.root())
+            continue;
+        if (!have_same_local_name_and_attributes(element, candidate.element))
+            continue;
+        if (!matches_same_revalidation_rules(element, candidate.element))
+            continue;
+        // NOTE: The parent style may be the same even though the parents' custom properties aren't, as an element keeps
+        //       its style when a restyle only changes its custom properties.
+        if (!inherit_same_custom_properties(element, candidate.element))
+            continue;
+
+        // The same rules match, so the element would end up with the same custom properties as well.
+        element.set_custom_properties({}, candidate.element->custom_properties({}));
+
+        auto style = candidate.style;
+        if (i != 0)
+            m_style_sharing_candidates.prepend(m_style_sharing_candidates.take(i));
+        return style;
+    }
+    return nullptr;
+}
+
+void StyleComputer::add_style_sharing_candidate(DOM::Element const& element, StyleProperties& style) const
+{
+    // Keep the candidates to the few most recently styled elements, which are mostly siblings and cousins of the
+    // element that's styled next.
+    static constexpr size_t maximum_candidate_count = 16;
+
+    // Computing the style may have started a CSS animation for the element.
+    if (!can_share_style(element))
+        return;
+
+    if (m_style_sharing_candidates.size() == maximum_candidate_count)
+        m_style_sharing_candidates.take_last();
+    m_style_sharing_candidates.prepend({ element, *element.parent_or_shadow_host_element()->computed_css_values(), style });
+}
+
+void StyleComputer::disable_style_sharing()
+{
+    m_style_sharing_enabled = false;
+    m_style_sharing_candidates.clear();
+}
+
 RefPtr<StyleProperties> StyleComputer::compute_style_impl(DOM::Element& element, Optional<CSS::Selector::PseudoElement::Type> pseudo_element, ComputeStyleMode mode) const
 {
     build_rule_cache_if_needed();
@@ -2351,6 +2503,12 @@ RefPtr<StyleProperties> StyleComputer::compute_style_impl(DOM::Element& element,
         return style;
     }
 
+    bool const may_share_style = m_style_sharing_enabled && mode == ComputeStyleMode::Normal && !pseudo_element.has_value() && can_share_style(element);
+    if (may_share_style) {
+        if (auto style = find_shared_style(element))
+            return style;
+    }
+
     auto style = StyleProperties::create();
     // 1. Perform the cascade. This produces the "specified style"
     bool did_match_any_pseudo_element_rules = false;
@@ -2380,6 +2538,9 @@ RefPtr<StyleProperties> StyleComputer::compute_style_impl(DOM::Element& element,
     // 8. Let the element adjust computed style
     element.adjust_computed_style(style);
 
+    if (may_share_style)
+        add_style_sharing_candidate(element, style);
+
     return style;
 }
 
@@ -2390,6 +2551,78 @@ void StyleComputer::build_rule_cache_if_needed() const
     const_cast<StyleComputer&>(*this).build_rule_cache();
 }
 
+// Elements only share style if they have the same parent style, local name and attributes, and their parents either are
+// the same element or share style themselves. Whether selectors made up of nothing but these match is then the same
+// for both, so only selectors that also depend on siblings or on element state need to be matched against both.
+static bool needs_revalidation_for_style_sharing(Selector const& selector)
+{
+    for (auto const& compound_selector : selector.compound_selectors()) {
+        if (compound_selector.combinator == Selector::Combinator::NextSibling
+            || compound_selector.combinator == Selector::Combinator::SubsequentSibling
+            || compound_selector.combinator == Selector::Combinator::Column) {
+            return true;
+        }
+        for (auto const& simple_selector : compound_selector.simple_selectors) {
+            if (simple_selector.type == Selector::SimpleSelector::Type::PseudoClass)
+                return true;
+        }
+    }
+    return false;
+}
+
+void StyleComputer::add_invalidation_sets_for_selector(RuleCache& rule_cache, Selector const& selector, InvalidationSet subject_invalidation_set)
+{
+    // Going from the subject to the left, the combinators tell us how the elements matched by each compound selector
+    // are related to the subject, and so which elements a change to one of them can affect.
+    auto invalidation_set = subject_invalidation_set;
+    for (size_t i = selector.compound_selectors().size(); i-- > 0;) {
+        auto const& compound_selector = selector.compound_selectors()[i];
+
+        for (auto const& simple_selector : compound_selector.simple_selectors) {
+            switch (simple_selector.type) {
+            case Selector::SimpleSelector::Type::Id:
+                rule_cache.invalidation_sets_by_id.ensure(simple_selector.name()) |= invalidation_set;
+                break;
+            case Selector::SimpleSelector::Type::Class:
+                rule_cache.invalidation_sets_by_class.ensure(simple_selector.name()) |= invalidation_set;
+                break;
+            case Selector::SimpleSelector::Type::Attribute:
+                rule_cache.invalidation_sets_by_attribute_name.ensure(simple_selector.attribute().qualified_name.name.lowercase_name) |= invalidation_set;
+                break;
+            case Selector::SimpleSelector::Type::PseudoClass: {
+                auto const& pseudo_class = simple_selector.pseudo_class();
+                auto argument_invalidation_set = invalidation_set;
+                // :nth-child(An+B of S) and friends count the siblings that match S.
+                if (pseudo_class.type == PseudoClass::NthChild || pseudo_class.type == PseudoClass::NthLastChild)
+                    argument_invalidation_set.siblings = true;
+                for (auto const& argument_selector : pseudo_class.argument_selector_list)
+                    add_invalidation_sets_for_selector(rule_cache, *argument_selector, argument_invalidation_set);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        switch (compound_selector.combinator) {
+        case Selector::Combinator::ImmediateChild:
+        case Selector::Combinator::Descendant:
+            invalidation_set.descendants = true;
+            break;
+        case Selector::Combinator::NextSibling:
+        case Selector::Combinator::SubsequentSibling:
+            invalidation_set.siblings = true;
+            break;
+        case Selector::Combinator::Column:
+            invalidation_set.descendants = true;
+            invalidation_set.siblings = true;
+            break;
+        case Selector::Combinator::None:
+            break;
+        }
+    }
+}
+
 NonnullOwnPtr<StyleComputer::RuleCache> StyleComputer::make_rule_cache_for_cascade_origin(CascadeOrigin cascade_origin)
 {
     auto rule_cache = make<RuleCache>();
@@ -2420,6 +2653,8 @@ NonnullOwnPtr<StyleComputer::RuleCache> StyleComputer::make_rule_cache_for_casca
                     false,
                     false,
                     SelectorEngine::can_use_fast_matches(selector),
+                    SelectorEngine::can_match_off_main_thread(selector),
+                    needs_revalidation_for_style_sharing(selector),
                 };
 
                 for (auto const& simple_selector : selector.compound_selectors().last().simple_selectors) {
@@ -2438,6 +2673,8 @@ NonnullOwnPtr<StyleComputer::RuleCache> StyleComputer::make_rule_cache_for_casca
                     }
                 }
 
+                add_invalidation_sets_for_selector(*rule_cache, selector, { .self = true });
+
                 bool added_to_bucket = false;
                 for (auto const& simple_selector : selector.compound_selectors().last().simple_selectors) {
                     if (simple_selector.type == CSS::Selector::SimpleSelector::Type::Id) {
@@ -2550,9 +2787,43 @@ void StyleComputer::build_rule_cache()
     m_user_agent_rule_cache = make_rule_cache_for_cascade_origin(CascadeOrigin::UserAgent);
 }
 
+InvalidationSet StyleComputer::invalidation_set_for_class(FlyString const& class_name) const
+{
+    build_rule_cache_if_needed();
+    InvalidationSet invalidation_set;
+    for (auto const* rule_cache : { m_user_agent_rule_cache.ptr(), m_user_rule_cache.ptr(), m_author_rule_cache.ptr() }) {
+        if (auto it = rule_cache->invalidation_sets_by_class.find(class_name); it != rule_cache->invalidation_sets_by_class.end())
+            invalidation_set |= it->value;
+    }
+    return invalidation_set;
+}
+
+InvalidationSet StyleComputer::invalidation_set_for_id(FlyString const& id) const
+{
+    build_rule_cache_if_needed();
+    InvalidationSet invalidation_set;
+    for (auto const* rule_cache : { m_user_agent_rule_cache.ptr(), m_user_rule_cache.ptr(), m_author_rule_cache.ptr() }) {
+        if (auto it = rule_cache->invalidation_sets_by_id.find(id); it != rule_cache->invalidation_sets_by_id.end())
+            invalidation_set |= it->value;
+    }
+    return invalidation_set;
+}
+
+InvalidationSet StyleComputer::invalidation_set_for_attribute(FlyString const& attribute_name) const
+{
+    build_rule_cache_if_needed();
+    InvalidationSet invalidation_set;
+    for (auto const* rule_cache : { m_user_agent_rule_cache.ptr(), m_user_rule_cache.ptr(), m_author_rule_cache.ptr() }) {
+        if (auto it = rule_cache->invalidation_sets_by_attribute_name.find(attribute_name); it != rule_cache->invalidation_sets_by_attribute_name.end())
+            invalidation_set |= it->value;
+    }
+    return invalidation_set;
+}
+
 void StyleComputer::invalidate_rule_cache()
 {
     m_author_rule_cache = nullptr;
+    m_style_sharing_candidates.clear();
 
     // NOTE: We could be smarter about keeping the user rule cache, and style sheet.
     //       Currently we are re-parsing the user style sheet every time we build the caches,
@@ -2568,6 +2839,10 @@ void StyleComputer::invalidate_rule_cache()
 void StyleComputer::did_load_font(FlyString const&)
 {
     document().invalidate_style();
+
+    // NOTE: Text anywhere in the document may have been measured with a fallback font, so nothing from the
+    //       previous layout pass can be reused.
+    document().set_needs_layout();
 }
 
 void StyleComputer::load_fonts_from_sheet(CSSStyleSheet const& sheet)
@@ -2691,4 +2966,109 @@ void StyleComputer::pop_ancestor(DOM::Element const& element)
     });
 }
 
+// The threads stay around from one style update to the next. Style is only ever computed on the main thread, so all
+// documents can share them.
+static Vector<NonnullOwnPtr<Threading::WorkerThread<Error>>>& style_matching_workers()
+{
+    static Vector<NonnullOwnPtr<Threading::WorkerThread<Error>>> workers;
+    return workers;
+}
+
+void StyleComputer::match_rules_in_parallel(Vector<JS::NonnullGCPtr<DOM::Element const>> const& elements)
+{
+    // Handing the matching to other threads only pays off when there's a good amount of it to do.
+    static constexpr size_t minimum_element_count = 1024;
+    static constexpr size_t maximum_thread_count = 8;
+    // Elements are handed out in batches of neighbors in tree order, so that each thread mostly walks up and down
+    // the tree when it brings its ancestor filter in sync with the next element.
+    static constexpr size_t batch_size = 64;
+
+    m_rules_matched_in_parallel.clear();
+
+    auto thread_count = min<size_t>(Core::System::hardware_concurrency(), maximum_thread_count);
+    if (thread_count < 2 || elements.size() < minimum_element_count)
+        return;
+
+    build_rule_cache_if_needed();
+
+    Vector<MatchingRuleSet> results;
+    results.resize(elements.size());
+    Atomic<size_t> next_batch { 0 };
+
+    auto match_batches = [&] {
+        AncestorFilter ancestor_filter;
+        Vector<DOM::Element const*, 32> ancestors;
+        Vector<DOM::Element const*, 32> new_ancestors;
+
+        for (;;) {
+            auto first = next_batch.fetch_add(1) * batch_size;
+            if (first >= elements.size())
+                return;
+            auto last = min(first + batch_size, elements.size());
+
+            for (auto i = first; i < last; ++i) {
+                auto const& element = *elements[i];
+
+                // Like the main thread during the style update, the filter holds the element and all of its ancestors.
+                new_ancestors.clear_with_capacity();
+                for (auto const* ancestor = &element; ancestor; ancestor = ancestor->parent_or_shadow_host_element())
+                    new_ancestors.append(ancestor);
+                new_ancestors.reverse();
+
+                size_t common_ancestor_count = 0;
+                while (common_ancestor_count < min(ancestors.size(), new_ancestors.size()) && ancestors[common_ancestor_count] == new_ancestors[common_ancestor_count])
+                    ++common_ancestor_count;
+
+                while (ancestors.size() > common_ancestor_count) {
+                    for_each_element_hash(*ancestors.take_last(), [&](u32 hash) {
+                        ancestor_filter.decrement(hash);
+                    });
+                }
+                for (auto j = common_ancestor_count; j < new_ancestors.size(); ++j) {
+                    for_each_element_hash(*new_ancestors[j], [&](u32 hash) {
+                        ancestor_filter.increment(hash);
+                    });
+                    ancestors.append(new_ancestors[j]);
+                }
+
+                auto& result = results[i];
+                append_matching_rules(result.user_agent_rules, element, CascadeOrigin::UserAgent, {}, ancestor_filter, RulesToMatch::OffMainThread);
+                append_matching_rules(result.user_rules, element, CascadeOrigin::User, {}, ancestor_filter, RulesToMatch::OffMainThread);
+                append_matching_rules(result.author_rules, element, CascadeOrigin::Author, {}, ancestor_filter, RulesToMatch::OffMainThread);
+            }
+        }
+    };
+
+    auto& workers = style_matching_workers();
+    while (workers.size() < thread_count - 1) {
+        auto worker = Threading::WorkerThread<Error>::create("StyleMatching"sv);
+        // If we can't get another thread, the ones we have (including this one) will just do more of the work.
+        if (worker.is_error())
+            break;
+        workers.append(worker.release_value());
+    }
+
+    auto worker_count = min(workers.size(), thread_count - 1);
+    for (size_t i = 0; i < worker_count; ++i) {
+        VERIFY(workers[i]->start_task([&]() -> ErrorOr<void> {
+            match_batches();
+            return {};
+        }));
+    }
+
+    match_batches();
+
+    for (size_t i = 0; i < worker_count; ++i)
+        MUST(workers[i]->wait_until_task_is_finished());
+
+    m_rules_matched_in_parallel.ensure_capacity(elements.size());
+    for (size_t i = 0; i < elements.size(); ++i)
+        m_rules_matched_in_parallel.set(elements[i], move(results[i]));
+}
+
+void StyleComputer::discard_rules_matched_in_parallel()
+{
+    m_rules_matched_in_parallel.clear();
+}
+
 }
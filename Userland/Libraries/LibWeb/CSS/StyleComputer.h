@@ -15,6 +15,7 @@
 #include <LibWeb/CSS/CSSKeyframesRule.h>
 #include <LibWeb/CSS/CSSStyleDeclaration.h>
 #include <LibWeb/CSS/Selector.h>
+#include <LibWeb/CSS/StyleInvalidation.h>
 #include <LibWeb/CSS/StyleProperties.h>
 #include <LibWeb/Forward.h>
 
@@ -91,6 +92,8 @@ struct MatchingRule {
     bool contains_pseudo_element { false };
     bool contains_root_pseudo_class { false };
     bool can_use_fast_matches { false };
+    bool can_match_off_main_thread { false };
+    bool needs_revalidation_for_style_sharing { false };
 };
 
 struct FontFaceKey {
@@ -129,8 +132,27 @@ public:
 
     Vector<MatchingRule> collect_matching_rules(DOM::Element const&, CascadeOrigin, Optional<CSS::Selector::PseudoElement::Type>) const;
 
+    // Matches the rules that can be matched off the main thread against the elements, spread over several threads that
+    // each keep their own ancestor filter. Until discard_rules_matched_in_parallel() is called, compute_style() only
+    // matches the remaining rules against these elements itself. The elements must be in tree order, and neither the
+    // DOM nor the style sheets may change in the meantime.
+    void match_rules_in_parallel(Vector<JS::NonnullGCPtr<DOM::Element const>> const&);
+    void discard_rules_matched_in_parallel();
+
+    // While style sharing is enabled, compute_style() lets an element reuse the style of a recently styled element that
+    // is guaranteed to end up with the same style. The elements aren't kept alive, so it must be disabled again before
+    // the DOM changes.
+    void enable_style_sharing() { m_style_sharing_enabled = true; }
+    void disable_style_sharing();
+
     void invalidate_rule_cache();
 
+    // Which elements may need their style recomputed when an element starts or stops having the given class, id or
+    // attribute, according to the selectors in all style sheets.
+    [[nodiscard]] InvalidationSet invalidation_set_for_class(FlyString const&) const;
+    [[nodiscard]] InvalidationSet invalidation_set_for_id(FlyString const&) const;
+    [[nodiscard]] InvalidationSet invalidation_set_for_attribute(FlyString const&) const;
+
     Gfx::Font const& initial_font() const;
 
     void did_load_font(FlyString const& family_name);
@@ -156,7 +178,28 @@ private:
     class FontLoader;
     struct MatchingFontCandidate;
 
-    [[nodiscard]] bool should_reject_with_ancestor_filter(Selector const&) const;
+    using AncestorFilter = CountingBloomFilter<u8, 14>;
+
+    enum class RulesToMatch {
+        All,
+        OnMainThread,
+        OffMainThread,
+        NeedingRevalidationForStyleSharing,
+    };
+
+    [[nodiscard]] static bool should_reject_with_ancestor_filter(AncestorFilter const&, Selector const&);
+    void append_matching_rules(Vector<MatchingRule>&, DOM::Element const&, CascadeOrigin, Optional<CSS::Selector::PseudoElement::Type>, AncestorFilter const&, RulesToMatch) const;
+
+    struct StyleSharingCandidate {
+        JS::NonnullGCPtr<DOM::Element const> element;
+        NonnullRefPtr<StyleProperties const> parent_style;
+        NonnullRefPtr<StyleProperties> style;
+    };
+
+    [[nodiscard]] static bool can_share_style(DOM::Element const&);
+    [[nodiscard]] bool matches_same_revalidation_rules(DOM::Element const&, DOM::Element const&) const;
+    RefPtr<StyleProperties> find_shared_style(DOM::Element&) const;
+    void add_style_sharing_candidate(DOM::Element const&, StyleProperties&) const;
 
     RefPtr<StyleProperties> compute_style_impl(DOM::Element&, Optional<CSS::Selector::PseudoElement::Type>, ComputeStyleMode) const;
     void compute_cascaded_values(StyleProperties&, DOM::Element&, Optional<CSS::Selector::PseudoElement::Type>, bool& did_match_any_pseudo_element_rules, ComputeStyleMode) const;
@@ -203,10 +246,15 @@ private:
         Vector<MatchingRule> root_rules;
         Vector<MatchingRule> other_rules;
 
+        HashMap<FlyString, InvalidationSet> invalidation_sets_by_class;
+        HashMap<FlyString, InvalidationSet> invalidation_sets_by_id;
+        HashMap<FlyString, InvalidationSet, AK::ASCIICaseInsensitiveFlyStringTraits> invalidation_sets_by_attribute_name;
+
         HashMap<FlyString, NonnullRefPtr<Animations::KeyframeEffect::KeyFrameSet>> rules_by_animation_keyframes;
     };
 
     NonnullOwnPtr<RuleCache> make_rule_cache_for_cascade_origin(CascadeOrigin);
+    static void add_invalidation_sets_for_selector(RuleCache&, Selector const&, InvalidationSet subject_invalidation_set);
 
     RuleCache const& rule_cache_for_cascade_origin(CascadeOrigin) const;
 
@@ -223,7 +271,12 @@ private:
 
     CSSPixelRect m_viewport_rect;
 
-    CountingBloomFilter<u8, 14> m_ancestor_filter;
+    AncestorFilter m_ancestor_filter;
+
+    HashMap<JS::NonnullGCPtr<DOM::Element const>, MatchingRuleSet> m_rules_matched_in_parallel;
+
+    bool m_style_sharing_enabled { false };
+    mutable Vector<StyleSharingCandidate> m_style_sharing_candidates;
 };
 
 }
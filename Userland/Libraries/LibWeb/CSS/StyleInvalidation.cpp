@@ -52,6 +52,9 @@ RequiredInvalidationAfterStyleChange compute_property_invalidation(CSS::Property
         }
     } else if (CSS::property_affects_stacking_context(property_id)) {
         invalidation.rebuild_stacking_context_tree = true;
+    } else if (property_id == CSS::PropertyID::BackgroundAttachment) {
+        // NOTE: The viewport paintable finds out about fixed backgrounds while building the stacking context tree.
+        invalidation.rebuild_stacking_context_tree = true;
     }
     invalidation.repaint = true;
 
@@ -28,6 +28,24 @@ struct RequiredInvalidationAfterStyleChange {
     static RequiredInvalidationAfterStyleChange full() { return { true, true, true, true }; }
 };
 
+// Which elements may match different selectors when an element starts or stops having a particular class, id or
+// attribute: the element itself, its descendants and/or its siblings (including their descendants, if descendants
+// are affected too).
+struct InvalidationSet {
+    bool self : 1 { false };
+    bool descendants : 1 { false };
+    bool siblings : 1 { false };
+
+    void operator|=(InvalidationSet const& other)
+    {
+        self |= other.self;
+        descendants |= other.descendants;
+        siblings |= other.siblings;
+    }
+
+    [[nodiscard]] bool is_empty() const { return !self && !descendants && !siblings; }
+};
+
 RequiredInvalidationAfterStyleChange compute_property_invalidation(CSS::PropertyID property_id, RefPtr<CSS::StyleValue const> const& old_value, RefPtr<CSS::StyleValue const> const& new_value);
 
 }
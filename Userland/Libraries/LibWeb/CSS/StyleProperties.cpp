@@ -54,6 +54,17 @@ void StyleProperties::set_animated_property(CSS::PropertyID id, NonnullRefPtr<St
     m_animated_property_values.set(id, move(value));
 }
 
+NonnullRefPtr<StyleProperties> StyleProperties::clone() const
+{
+    auto clone = create();
+    clone->m_property_values = m_property_values;
+    clone->m_animated_property_values = m_animated_property_values;
+    clone->m_math_depth = m_math_depth;
+    clone->m_font_list = m_font_list;
+    clone->m_line_height = m_line_height;
+    return clone;
+}
+
 void StyleProperties::reset_animated_properties()
 {
     m_animated_property_values.clear();
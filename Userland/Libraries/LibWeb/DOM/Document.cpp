@@ -104,6 +104,7 @@
 #include <LibWeb/Infra/Strings.h>
 #include <LibWeb/IntersectionObserver/IntersectionObserver.h>
 #include <LibWeb/Layout/BlockFormattingContext.h>
+#include <LibWeb/Layout/LayoutState.h>
 #include <LibWeb/Layout/TreeBuilder.h>
 #include <LibWeb/Layout/Viewport.h>
 #include <LibWeb/Namespace.h>
@@ -888,6 +889,7 @@ WebIDL::ExceptionOr<void> Document::set_title(String const& title)
 void Document::tear_down_layout_tree()
 {
     m_layout_root = nullptr;
+    m_layout_state = nullptr;
     m_paintable = nullptr;
 }
 
@@ -985,6 +987,12 @@ URL::URL Document::parse_url(StringView url) const
 }
 
 void Document::set_needs_layout()
+{
+    m_needs_full_layout = true;
+    set_needs_incremental_layout();
+}
+
+void Document::set_needs_incremental_layout()
 {
     if (m_needs_layout)
         return;
@@ -1065,18 +1073,20 @@ void Document::update_layout()
         }
     }
 
-    Layout::LayoutState layout_state;
+    auto layout_state = make<Layout::LayoutState>();
+    if (!m_needs_full_layout)
+        layout_state->previous_pass = m_layout_state.ptr();
 
     {
-        Layout::BlockFormattingContext root_formatting_context(layout_state, *m_layout_root, nullptr);
+        Layout::BlockFormattingContext root_formatting_context(*layout_state, *m_layout_root, nullptr);
 
         auto& viewport = static_cast<Layout::Viewport&>(*m_layout_root);
-        auto& viewport_state = layout_state.get_mutable(viewport);
+        auto& viewport_state = layout_state->get_mutable(viewport);
         viewport_state.set_content_width(viewport_rect.width());
         viewport_state.set_content_height(viewport_rect.height());
 
         if (document_element && document_element->layout_node()) {
-            auto& icb_state = layout_state.get_mutable(verify_cast<Layout::NodeWithStyleAndBoxModelMetrics>(*document_element->layout_node()));
+            auto& icb_state = layout_state->get_mutable(verify_cast<Layout::NodeWithStyleAndBoxModelMetrics>(*document_element->layout_node()));
             icb_state.set_content_width(viewport_rect.width());
         }
 
@@ -1088,7 +1098,13 @@ void Document::update_layout()
                 Layout::AvailableSize::make_definite(viewport_rect.height())));
     }
 
-    layout_state.commit(*m_layout_root);
+    layout_state->commit(*m_layout_root);
+
+    // Keep the results of this pass around for the next one, which only has to lay out the nodes marked from now on.
+    m_layout_root->reset_needs_layout();
+    layout_state->previous_pass = nullptr;
+    m_layout_state = move(layout_state);
+    m_needs_full_layout = false;
 
     // Broadcast the current viewport rect to any new paintables, so they know whether they're visible or not.
     inform_all_viewport_clients_about_the_current_viewport_rect();
@@ -1110,7 +1126,7 @@ void Document::update_layout()
     m_needs_layout = false;
 }
 
-[[nodiscard]] static CSS::RequiredInvalidationAfterStyleChange update_style_recursively(Node& node, CSS::StyleComputer& style_computer)
+[[nodiscard]] static CSS::RequiredInvalidationAfterStyleChange update_style_recursively(Node& node, CSS::StyleComputer& style_computer, bool parent_style_changed, size_t& restyled_element_count)
 {
     bool const needs_full_style_update = node.document().needs_full_style_update();
     CSS::RequiredInvalidationAfterStyleChange invalidation;
@@ -1123,17 +1139,28 @@ void Document::update_layout()
     //       We will still recompute style for the children, though.
     bool is_display_none = false;
 
+    // Nodes that are only on the way to the ones needing a style update keep their style, unless it's inherited from
+    // a parent whose style changed.
+    bool style_changed = parent_style_changed;
     if (is<Element>(node)) {
-        invalidation |= static_cast<Element&>(node).recompute_style();
-        is_display_none = static_cast<Element&>(node).computed_css_values()->display().is_none();
+        auto& element = static_cast<Element&>(node);
+        style_changed = false;
+        if (needs_full_style_update || element.needs_style_update() || parent_style_changed || !element.computed_css_values()) {
+            auto element_invalidation = element.recompute_style();
+            ++restyled_element_count;
+            invalidation |= element_invalidation;
+            // NOTE: Custom properties aren't part of the computed style, so we can't tell whether they changed.
+            style_changed = !element_invalidation.is_none() || !element.custom_properties({}).is_empty();
+        }
+        is_display_none = element.computed_css_values()->display().is_none();
     }
     node.set_needs_style_update(false);
 
-    if (needs_full_style_update || node.child_needs_style_update()) {
+    if (needs_full_style_update || node.child_needs_style_update() || style_changed) {
         if (node.is_element()) {
             if (auto* shadow_root = static_cast<DOM::Element&>(node).shadow_root_internal()) {
-                if (needs_full_style_update || shadow_root->needs_style_update() || shadow_root->child_needs_style_update()) {
-                    auto subtree_invalidation = update_style_recursively(*shadow_root, style_computer);
+                if (needs_full_style_update || shadow_root->needs_style_update() || shadow_root->child_needs_style_update() || style_changed) {
+                    auto subtree_invalidation = update_style_recursively(*shadow_root, style_computer, style_changed, restyled_element_count);
                     if (!is_display_none)
                         invalidation |= subtree_invalidation;
                 }
@@ -1141,8 +1168,8 @@ void Document::update_layout()
         }
 
         node.for_each_child([&](auto& child) {
-            if (needs_full_style_update || child.needs_style_update() || child.child_needs_style_update()) {
-                auto subtree_invalidation = update_style_recursively(child, style_computer);
+            if (needs_full_style_update || child.needs_style_update() || child.child_needs_style_update() || style_changed) {
+                auto subtree_invalidation = update_style_recursively(child, style_computer, style_changed, restyled_element_count);
                 if (!is_display_none)
                     invalidation |= subtree_invalidation;
             }
@@ -1158,6 +1185,33 @@ void Document::update_layout()
     return invalidation;
 }
 
+// Collects the elements that update_style_recursively() is sure to restyle, in the order it visits them.
+// It also restyles the descendants of elements whose style changed, but those are only known once it gets there.
+static void collect_elements_needing_style_update(Node const& node, bool needs_full_style_update, Vector<JS::NonnullGCPtr<Element const>>& elements)
+{
+    if (is<Element>(node)) {
+        auto const& element = static_cast<Element const&>(node);
+        if (needs_full_style_update || element.needs_style_update() || !element.computed_css_values())
+            elements.append(element);
+    }
+
+    if (!needs_full_style_update && !node.child_needs_style_update())
+        return;
+
+    if (is<Element>(node)) {
+        if (auto const* shadow_root = static_cast<Element const&>(node).shadow_root_internal()) {
+            if (needs_full_style_update || shadow_root->needs_style_update() || shadow_root->child_needs_style_update())
+                collect_elements_needing_style_update(*shadow_root, needs_full_style_update, elements);
+        }
+    }
+
+    node.for_each_child([&](auto const& child) {
+        if (needs_full_style_update || child.needs_style_update() || child.child_needs_style_update())
+            collect_elements_needing_style_update(child, needs_full_style_update, elements);
+        return IterationDecision::Continue;
+    });
+}
+
 void Document::update_style()
 {
     if (!browsing_context())
@@ -1183,12 +1237,24 @@ void Document::update_style()
 
     style_computer().reset_ancestor_filter();
 
-    auto invalidation = update_style_recursively(*this, style_computer());
+    // Selector matching is the expensive part of computing style that doesn't need anything but the DOM tree, so do
+    // as much of it as possible for all the elements at once, up front.
+    Vector<JS::NonnullGCPtr<Element const>> elements_needing_style_update;
+    collect_elements_needing_style_update(*this, needs_full_style_update(), elements_needing_style_update);
+    style_computer().match_rules_in_parallel(elements_needing_style_update);
+
+    style_computer().enable_style_sharing();
+    size_t restyled_element_count = 0;
+    auto invalidation = update_style_recursively(*this, style_computer(), false, restyled_element_count);
+    style_computer().disable_style_sharing();
+    style_computer().discard_rules_matched_in_parallel();
+    dbgln_if(LIBWEB_STYLE_INVALIDATION_DEBUG, "Style update restyled {} element(s){}", restyled_element_count, needs_full_style_update() ? " (full style update)"sv : ""sv);
     if (invalidation.rebuild_layout_tree) {
         invalidate_layout();
     } else {
+        // NOTE: Elements whose style change requires relayout have marked their layout nodes already.
         if (invalidation.relayout)
-            set_needs_layout();
+            set_needs_incremental_layout();
         if (invalidation.rebuild_stacking_context_tree)
             invalidate_stacking_context_tree();
     }
@@ -2769,6 +2835,10 @@ void Document::invalidate_stacking_context_tree()
 {
     if (auto* paintable_box = this->paintable_box())
         paintable_box->invalidate_stacking_context();
+
+    // Stacking contexts being created or going away means things are painted in a different order, and possibly moved.
+    if (auto navigable = this->navigable())
+        navigable->set_needs_display();
 }
 
 void Document::check_favicon_after_loading_link_resource()
@@ -227,8 +227,12 @@ public:
     void update_paint_and_hit_testing_properties_if_needed();
     void update_animated_style_if_needed();
 
+    // Lays out the whole layout tree again, without reusing anything from the previous layout pass.
     void set_needs_layout();
 
+    // Lays out the layout nodes marked with Layout::Node::set_needs_layout() again.
+    void set_needs_incremental_layout();
+
     void invalidate_layout();
     void invalidate_stacking_context_tree();
 
@@ -696,6 +700,9 @@ private:
 
     JS::GCPtr<Layout::Viewport> m_layout_root;
 
+    // The committed state of the last layout pass, which incremental layout passes take results from.
+    OwnPtr<Layout::LayoutState> m_layout_state;
+
     Optional<Color> m_normal_link_color;
     Optional<Color> m_active_link_color;
     Optional<Color> m_visited_link_color;
@@ -777,6 +784,7 @@ private:
     Vector<WeakPtr<CSS::MediaQueryList>> m_media_query_lists;
 
     bool m_needs_layout { false };
+    bool m_needs_full_layout { false };
 
     bool m_needs_full_style_update { false };
 
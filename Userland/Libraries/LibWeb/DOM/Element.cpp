@@ -445,7 +445,7 @@ void Element::run_attribute_change_steps(FlyString const& local_name, Optional<S
 
     // AD-HOC: Run our own internal attribute change handler.
     attribute_changed(local_name, value);
-    invalidate_style_after_attribute_change(local_name);
+    invalidate_style_after_attribute_change(local_name, old_value, value);
 
     document().bump_dom_tree_version();
 }
@@ -553,8 +553,14 @@ CSS::RequiredInvalidationAfterStyleChange Element::recompute_style()
         document().set_needs_to_resolve_paint_only_properties();
 
     if (!invalidation.rebuild_layout_tree && layout_node()) {
+        // NOTE: The old style may have painted (e.g. a shadow or an outline) somewhere the new one doesn't.
+        if (invalidation.repaint && paintable())
+            paintable()->set_needs_display();
+
         // If we're keeping the layout tree, we can just apply the new style to the existing layout tree.
         layout_node()->apply_style(*m_computed_css_values);
+        if (invalidation.relayout)
+            layout_node()->set_needs_layout();
         if (invalidation.repaint && paintable())
             paintable()->set_needs_display();
     }
@@ -578,10 +584,17 @@ NonnullRefPtr<CSS::StyleProperties> Element::resolved_css_values()
     return properties;
 }
 
+void Element::unshare_computed_css_values()
+{
+    if (m_computed_css_values && m_computed_css_values->ref_count() > 1)
+        m_computed_css_values = m_computed_css_values->clone();
+}
+
 void Element::reset_animated_css_properties()
 {
     if (!m_computed_css_values)
         return;
+    unshare_computed_css_values();
     m_computed_css_values->reset_animated_properties();
 }
 
@@ -1766,13 +1779,132 @@ ErrorOr<void> Element::scroll_into_view(Optional<Variant<bool, ScrollIntoViewOpt
     // FIXME: 8. Optionally perform some other action that brings the element to the user’s attention.
 }
 
-void Element::invalidate_style_after_attribute_change(FlyString const& attribute_name)
+// Whether changing the attribute can affect the style of elements in ways that the selectors using it don't tell.
+static bool attribute_change_affects_more_than_selectors_show(Element const& element, FlyString const& attribute_name)
+{
+    // Pseudo-classes like :link, :disabled or :placeholder-shown depend on these, on this element or its descendants.
+    if (attribute_name.is_one_of(
+            HTML::AttributeNames::checked,
+            HTML::AttributeNames::contenteditable,
+            HTML::AttributeNames::dir,
+            HTML::AttributeNames::disabled,
+            HTML::AttributeNames::href,
+            HTML::AttributeNames::lang,
+            HTML::AttributeNames::multiple,
+            HTML::AttributeNames::open,
+            HTML::AttributeNames::placeholder,
+            HTML::AttributeNames::readonly,
+            HTML::AttributeNames::selected,
+            HTML::AttributeNames::slot,
+            HTML::AttributeNames::type,
+            HTML::AttributeNames::value)) {
+        return true;
+    }
+
+    // The presentational hints of table cells look at the table's attributes, and the body's link colors apply to
+    // the links in the document.
+    return is<HTML::HTMLTableElement>(element) || is<HTML::HTMLBodyElement>(element);
+}
+
+void Element::invalidate_style_after_attribute_change(FlyString const& attribute_name, Optional<String> const& old_value, Optional<String> const& new_value)
 {
-    // FIXME: Only invalidate if the attribute can actually affect style.
-    (void)attribute_name;
+    // If the document is already marked for a full style update, there's no need to do anything here.
+    if (document().needs_full_style_update())
+        return;
 
+    // NOTE: Elements that aren't connected get their style computed once they are, so don't bother looking at the
+    //       style sheets for them.
     // FIXME: This will need to become smarter when we implement the :has() selector.
-    invalidate_style();
+    if (!is_connected() || attribute_change_affects_more_than_selectors_show(*this, attribute_name)) {
+        invalidate_style();
+        return;
+    }
+
+    auto const& style_computer = document().style_computer();
+
+    // The element's own style depends on its attributes through presentational hints.
+    CSS::InvalidationSet invalidation_set { .self = true };
+    invalidation_set |= style_computer.invalidation_set_for_attribute(attribute_name);
+
+    if (attribute_name == HTML::AttributeNames::class_ || attribute_name == HTML::AttributeNames::id) {
+        // Selectors match classes and ids case-insensitively in quirks mode, but the invalidation sets are keyed on
+        // them as written.
+        if (document().in_quirks_mode()) {
+            invalidate_style();
+            return;
+        }
+    }
+
+    if (attribute_name == HTML::AttributeNames::class_) {
+        auto split_classes = [](Optional<String> const& value) -> Vector<StringView> {
+            if (!value.has_value())
+                return {};
+            return value->bytes_as_string_view().split_view_if(Infra::is_ascii_whitespace);
+        };
+        auto old_classes = split_classes(old_value);
+        auto new_classes = split_classes(new_value);
+
+        // Only the classes that were added or removed can make selectors match differently.
+        for (auto const& old_class : old_classes) {
+            if (!new_classes.contains_slow(old_class))
+                invalidation_set |= style_computer.invalidation_set_for_class(MUST(FlyString::from_utf8(old_class)));
+        }
+        for (auto const& new_class : new_classes) {
+            if (!old_classes.contains_slow(new_class))
+                invalidation_set |= style_computer.invalidation_set_for_class(MUST(FlyString::from_utf8(new_class)));
+        }
+    } else if (attribute_name == HTML::AttributeNames::id) {
+        if (old_value.has_value())
+            invalidation_set |= style_computer.invalidation_set_for_id(FlyString { *old_value });
+        if (new_value.has_value())
+            invalidation_set |= style_computer.invalidation_set_for_id(FlyString { *new_value });
+    }
+
+    invalidate_style_of_affected_elements(invalidation_set);
+}
+
+void Element::invalidate_style_of_affected_elements(CSS::InvalidationSet const& invalidation_set)
+{
+    if constexpr (LIBWEB_STYLE_INVALIDATION_DEBUG) {
+        size_t element_count = 0;
+        auto count_elements = [&](Element const& element) {
+            if (!invalidation_set.descendants) {
+                ++element_count;
+                return;
+            }
+            element.for_each_in_inclusive_subtree_of_type<Element>([&](auto const&) {
+                ++element_count;
+                return IterationDecision::Continue;
+            });
+        };
+        if (invalidation_set.self || invalidation_set.descendants)
+            count_elements(*this);
+        if (invalidation_set.siblings && parent()) {
+            parent()->for_each_child_of_type<Element>([&](auto const& sibling) {
+                if (&sibling != this)
+                    count_elements(sibling);
+                return IterationDecision::Continue;
+            });
+        }
+        dbgln("Style invalidation for {}: self={} descendants={} siblings={}, {} element(s) to restyle", debug_description(), invalidation_set.self, invalidation_set.descendants, invalidation_set.siblings, element_count);
+    }
+
+    if (invalidation_set.descendants)
+        invalidate_style();
+    else if (invalidation_set.self)
+        set_needs_style_update(true);
+
+    if (invalidation_set.siblings && parent()) {
+        parent()->for_each_child_of_type<Element>([&](auto& sibling) {
+            if (&sibling == this)
+                return IterationDecision::Continue;
+            if (invalidation_set.descendants)
+                sibling.invalidate_style();
+            else
+                sibling.set_needs_style_update(true);
+            return IterationDecision::Continue;
+        });
+    }
 }
 
 // https://www.w3.org/TR/wai-aria-1.2/#tree_exclusion
@@ -166,6 +166,8 @@ public:
     CSS::StyleProperties* computed_css_values() { return m_computed_css_values.ptr(); }
     CSS::StyleProperties const* computed_css_values() const { return m_computed_css_values.ptr(); }
     void set_computed_css_values(RefPtr<CSS::StyleProperties>);
+    // Computed style may be shared with other elements, so it has to be unshared before it's modified in place.
+    void unshare_computed_css_values();
     NonnullRefPtr<CSS::StyleProperties> resolved_css_values();
 
     void reset_animated_css_properties();
@@ -394,7 +396,8 @@ protected:
 private:
     void make_html_uppercased_qualified_name();
 
-    void invalidate_style_after_attribute_change(FlyString const& attribute_name);
+    void invalidate_style_after_attribute_change(FlyString const& attribute_name, Optional<String> const& old_value, Optional<String> const& new_value);
+    void invalidate_style_of_affected_elements(CSS::InvalidationSet const&);
 
     WebIDL::ExceptionOr<JS::GCPtr<Node>> insert_adjacent(StringView where, JS::NonnullGCPtr<Node> node);
 
@@ -102,7 +102,10 @@ u32 HTMLVideoElement::video_height() const
 void HTMLVideoElement::set_video_track(JS::GCPtr<HTML::VideoTrack> video_track)
 {
     set_needs_style_update(true);
-    document().set_needs_layout();
+    if (auto* layout_node = this->layout_node())
+        layout_node->set_needs_layout();
+    else
+        document().set_needs_layout();
 
     if (m_video_track)
         m_video_track->pause_video({});
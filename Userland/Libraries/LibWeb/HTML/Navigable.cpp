@@ -35,6 +35,7 @@
 #include <LibWeb/Loader/GeneratedPagesLoader.h>
 #include <LibWeb/Page/Page.h>
 #include <LibWeb/Painting/Paintable.h>
+#include <LibWeb/Painting/StackingContext.h>
 #include <LibWeb/Painting/ViewportPaintable.h>
 #include <LibWeb/Platform/EventLoopPlugin.h>
 #include <LibWeb/Selection/Selection.h>
@@ -1999,7 +2000,8 @@ CSSPixelPoint Navigable::to_top_level_position(CSSPixelPoint a_position)
 
 void Navigable::set_viewport_rect(CSSPixelRect const& rect)
 {
-    bool did_change = false;
+    bool did_resize = false;
+    bool did_scroll = false;
 
     if (m_size != rect.size()) {
         m_size = rect.size();
@@ -2008,19 +2010,30 @@ void Navigable::set_viewport_rect(CSSPixelRect const& rect)
             document->invalidate_style();
             document->set_needs_layout();
         }
-        did_change = true;
-        m_needs_repaint = true;
+        did_resize = true;
     }
 
     if (m_viewport_scroll_offset != rect.location()) {
         m_viewport_scroll_offset = rect.location();
         scroll_offset_did_change();
-        did_change = true;
-        m_needs_repaint = true;
+        did_scroll = true;
     }
 
-    if (did_change && active_document()) {
-        active_document()->inform_all_viewport_clients_about_the_current_viewport_rect();
+    if (did_resize) {
+        set_needs_display();
+    } else if (did_scroll) {
+        // NOTE: Scrolling the viewport moves the whole document without changing it, unless some of it is painted relative
+        //       to the viewport instead.
+        auto document = active_document();
+        if (!document || !document->paintable() || document->paintable()->has_content_attached_to_viewport())
+            set_needs_display();
+        else
+            schedule_repaint();
+    }
+
+    if (did_resize || did_scroll) {
+        if (active_document())
+            active_document()->inform_all_viewport_clients_about_the_current_viewport_rect();
     }
 
     // Schedule the HTML event loop to ensure that a `resize` event gets fired.
@@ -2032,7 +2045,6 @@ void Navigable::perform_scroll_of_viewport(CSSPixelPoint position)
     auto viewport_rect = this->viewport_rect();
     viewport_rect.set_location(position);
     set_viewport_rect(viewport_rect);
-    set_needs_display();
 
     if (is_traversable() && active_browsing_context())
         active_browsing_context()->page().client().page_did_request_scroll_to(position);
@@ -2059,14 +2071,31 @@ void Navigable::set_size(CSSPixelSize size)
 
 void Navigable::set_needs_display()
 {
-    set_needs_display(viewport_rect());
+    // We don't know what changed, so none of the commands retained from painting before can be reused.
+    if (auto document = active_document(); document && document->paintable()) {
+        if (auto* stacking_context = document->paintable()->stacking_context())
+            stacking_context->invalidate_retained_commands_in_subtree();
+    }
+
+    set_needs_display_everywhere();
+}
+
+void Navigable::set_needs_display(CSSPixelRect const& rect)
+{
+    // NOTE: Paintables only pass their rect if they show up where their rect says (i.e. they aren't fixed-position,
+    //       transformed or scrolled), and ask for everything to be repainted otherwise.
+    m_damage.rect = m_damage.rect.united(rect);
+    schedule_repaint();
 }
 
-void Navigable::set_needs_display(CSSPixelRect const&)
+void Navigable::set_needs_display_everywhere()
 {
-    // FIXME: Ignore updates outside the visible viewport rect.
-    //        This requires accounting for fixed-position elements in the input rect, which we don't do yet.
+    m_damage.everything = true;
+    schedule_repaint();
+}
 
+void Navigable::schedule_repaint()
+{
     m_needs_repaint = true;
 
     if (is<TraversableNavigable>(*this)) {
@@ -2132,9 +2161,15 @@ void Navigable::paint(Painting::RecordingPainter& recording_painter, PaintConfig
 
     auto background_color = document->background_color();
 
-    recording_painter.fill_rect(bitmap_rect, background_color);
-    if (!document->paintable())
+    if (!document->paintable()) {
+        recording_painter.fill_rect(bitmap_rect, background_color);
         return;
+    }
+
+    // NOTE: The background is filled in for the whole canvas, so that the commands can also be used to paint the parts
+    //       of the document around the viewport.
+    auto canvas_rect = page.enclosing_device_rect(document->paintable()->canvas_rect()).to_type<int>();
+    recording_painter.fill_rect(canvas_rect.translated(-viewport_rect.location().to_type<int>()).united(bitmap_rect), background_color);
 
     Web::PaintContext context(recording_painter, page.palette(), page.client().device_pixels_per_css_pixel());
     context.set_device_viewport_rect(viewport_rect);
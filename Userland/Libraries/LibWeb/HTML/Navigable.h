@@ -171,6 +171,7 @@ public:
 
     void set_needs_display();
     void set_needs_display(CSSPixelRect const&);
+    void set_needs_display_everywhere();
 
     void set_is_popup(TokenizedFeature::Popup is_popup) { m_is_popup = is_popup; }
 
@@ -181,6 +182,14 @@ public:
 
     [[nodiscard]] bool needs_repaint() const { return m_needs_repaint; }
 
+    // What needs to be repainted since this was last called. The rect is relative to the document's origin, and doesn't
+    // matter if everything needs to be repainted.
+    struct Damage {
+        CSSPixelRect rect;
+        bool everything { false };
+    };
+    Damage take_damage() { return exchange(m_damage, {}); }
+
     struct PaintConfig {
         bool paint_overlay { false };
         bool should_show_line_box_borders { false };
@@ -219,6 +228,8 @@ protected:
     TokenizedFeature::Popup m_is_popup { TokenizedFeature::Popup::No };
 
 private:
+    void schedule_repaint();
+
     void reset_cursor_blink_cycle();
 
     void scroll_offset_did_change();
@@ -254,6 +265,7 @@ private:
     CSSPixelPoint m_viewport_scroll_offset;
 
     bool m_needs_repaint { false };
+    Damage m_damage;
 
     Web::EventHandler m_event_handler;
 
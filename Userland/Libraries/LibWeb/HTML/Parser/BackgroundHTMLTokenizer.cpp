@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibWeb/HTML/Parser/BackgroundHTMLTokenizer.h>
+
+namespace Web::HTML {
+
+// Enough tokens to make handing them over cheap next to making them, without keeping the tree builder waiting long for
+// the first ones.
+static constexpr size_t tokens_per_batch = 256;
+
+// How far the background thread gets ahead of the tree builder before it waits.
+static constexpr size_t maximum_pending_batch_count = 64;
+
+// https://html.spec.whatwg.org/multipage/parsing.html#parsing-main-inforeign
+static constexpr Array foreign_root_tag_names { "svg"sv, "math"sv };
+
+// https://html.spec.whatwg.org/multipage/parsing.html#html-integration-point
+// NOTE: Only the ones HTMLParser knows about.
+static constexpr Array integration_point_tag_names { "foreignobject"sv, "desc"sv, "title"sv };
+
+// The start tags that take the tree builder out of foreign content.
+static constexpr Array breakout_tag_names {
+    "b"sv, "big"sv, "blockquote"sv, "body"sv, "br"sv, "center"sv, "code"sv, "dd"sv, "div"sv, "dl"sv, "dt"sv, "em"sv,
+    "embed"sv, "h1"sv, "h2"sv, "h3"sv, "h4"sv, "h5"sv, "h6"sv, "head"sv, "hr"sv, "i"sv, "img"sv, "li"sv, "listing"sv,
+    "menu"sv, "meta"sv, "nobr"sv, "ol"sv, "p"sv, "pre"sv, "ruby"sv, "s"sv, "small"sv, "span"sv, "strong"sv, "strike"sv,
+    "sub"sv, "sup"sv, "table"sv, "tt"sv, "u"sv, "ul"sv, "var"sv
+};
+
+// Returns the name from the list rather than the token's, since the token is going to another thread.
+template<size_t Size>
+static Optional<StringView> find_tag_name(Array<StringView, Size> const& tag_names, StringView tag_name)
+{
+    for (auto name : tag_names) {
+        if (name == tag_name)
+            return name;
+    }
+    return {};
+}
+
+BackgroundHTMLTokenizer::BackgroundHTMLTokenizer(HTMLTokenizer::Checkpoint checkpoint, bool scripting_enabled)
+    : m_checkpoint(move(checkpoint))
+    , m_scripting_enabled(scripting_enabled)
+{
+}
+
+BackgroundHTMLTokenizer::~BackgroundHTMLTokenizer()
+{
+    {
+        Threading::MutexLocker locker { m_mutex };
+        m_should_stop = true;
+        m_condition.broadcast();
+    }
+    if (m_thread && m_thread->needs_to_be_joined())
+        [[maybe_unused]] auto result = m_thread->join();
+}
+
+ErrorOr<NonnullOwnPtr<BackgroundHTMLTokenizer>> BackgroundHTMLTokenizer::decode_and_start(StringView input, StringView encoding, bool scripting_enabled)
+{
+    auto decoder = TextCodec::decoder_for(encoding);
+    VERIFY(decoder.has_value());
+
+    auto tokenizer = TRY(adopt_nonnull_own_or_enomem(new (nothrow) BackgroundHTMLTokenizer({}, scripting_enabled)));
+    tokenizer->m_undecoded_input = TRY(ByteBuffer::copy(input.bytes()));
+    tokenizer->m_decoder = &decoder.value();
+    TRY(tokenizer->start_thread());
+    return tokenizer;
+}
+
+ErrorOr<NonnullOwnPtr<BackgroundHTMLTokenizer>> BackgroundHTMLTokenizer::start(StringView decoded_input, HTMLTokenizer::Checkpoint checkpoint, bool scripting_enabled)
+{
+    auto tokenizer = TRY(adopt_nonnull_own_or_enomem(new (nothrow) BackgroundHTMLTokenizer(move(checkpoint), scripting_enabled)));
+    tokenizer->m_decoded_input = decoded_input;
+    TRY(tokenizer->start_thread());
+    return tokenizer;
+}
+
+ErrorOr<void> BackgroundHTMLTokenizer::start_thread()
+{
+    m_thread = TRY(Threading::Thread::try_create([this] {
+        tokenize();
+        return static_cast<intptr_t>(0);
+    },
+        "HTMLTokenizer"sv));
+    m_thread->start();
+    return {};
+}
+
+ByteString BackgroundHTMLTokenizer::wait_for_decoded_input()
+{
+    Threading::MutexLocker locker { m_mutex };
+    m_condition.wait_while([&] { return !m_has_decoded_input; });
+    return m_decoded_input_for_main_thread.release_value();
+}
+
+Vector<HTMLTokenizer::BackgroundToken> BackgroundHTMLTokenizer::take_tokens()
+{
+    Threading::MutexLocker locker { m_mutex };
+    m_condition.wait_while([&] { return m_batches.is_empty() && !m_has_finished; });
+    if (m_batches.is_empty())
+        return {};
+    auto batch = m_batches.dequeue();
+    m_condition.broadcast();
+    return batch;
+}
+
+bool BackgroundHTMLTokenizer::hand_over(Vector<HTMLTokenizer::BackgroundToken> batch)
+{
+    Threading::MutexLocker locker { m_mutex };
+    m_condition.wait_while([&] { return m_batches.size() >= maximum_pending_batch_count && !m_should_stop; });
+    if (m_should_stop)
+        return false;
+    m_batches.enqueue(move(batch));
+    m_condition.broadcast();
+    return true;
+}
+
+void BackgroundHTMLTokenizer::tokenize()
+{
+    if (m_undecoded_input.has_value()) {
+        auto decoded_input = m_decoder->to_utf8(*m_undecoded_input).release_value_but_fixme_should_propagate_errors().to_byte_string();
+        m_undecoded_input.clear();
+
+        // NOTE: The main thread keeps the decoded input alive from here on, for as long as this thread is running.
+        m_decoded_input = decoded_input.view();
+        Threading::MutexLocker locker { m_mutex };
+        m_decoded_input_for_main_thread = move(decoded_input);
+        m_has_decoded_input = true;
+        m_condition.broadcast();
+    }
+
+    HTMLTokenizer tokenizer { {}, m_decoded_input, move(m_checkpoint) };
+    Vector<HTMLTokenizer::BackgroundToken> batch;
+
+    while (!m_should_stop.load(AK::MemoryOrder::memory_order_relaxed)) {
+        // NOTE: This stops short of the end of the input when the tokenizer needs the tree builder to carry on.
+        auto token = tokenizer.next_token();
+        if (!token.has_value())
+            break;
+
+        auto state_after_token = tokenizer.state();
+        auto predicted_state = predict_state_after(*token, state_after_token);
+        tokenizer.switch_to(predicted_state);
+
+        bool is_end_of_file = token->is_end_of_file();
+        batch.append({ token.release_value(), state_after_token, predicted_state, tokenizer.checkpoint() });
+        if (is_end_of_file)
+            break;
+
+        if (batch.size() == tokens_per_batch && !hand_over(move(batch)))
+            return;
+    }
+
+    if (!batch.is_empty() && !hand_over(move(batch)))
+        return;
+
+    Threading::MutexLocker locker { m_mutex };
+    m_has_finished = true;
+    m_condition.broadcast();
+}
+
+// Follows just enough of the tree builder to tell which start tags make it switch the tokenizer to another state: those
+// of a few HTML elements, as long as they're not in foreign content.
+HTMLTokenizer::State BackgroundHTMLTokenizer::predict_state_after(HTMLToken const& token, HTMLTokenizer::State state)
+{
+    if (token.is_end_tag()) {
+        if (!m_open_elements.is_empty() && m_open_elements.last().tag_name == token.raw_tag_name())
+            m_open_elements.take_last();
+        return state;
+    }
+
+    if (!token.is_start_tag())
+        return state;
+
+    auto tag_name = token.raw_tag_name();
+    bool is_in_foreign_content = !m_open_elements.is_empty() && m_open_elements.last().is_foreign;
+
+    if (is_in_foreign_content && find_tag_name(breakout_tag_names, tag_name).has_value()) {
+        while (!m_open_elements.is_empty() && m_open_elements.last().is_foreign)
+            m_open_elements.take_last();
+        is_in_foreign_content = false;
+    }
+
+    if (auto foreign_root_tag_name = find_tag_name(foreign_root_tag_names, tag_name); foreign_root_tag_name.has_value()) {
+        if (!token.is_self_closing())
+            m_open_elements.append({ *foreign_root_tag_name, true });
+        return state;
+    }
+
+    if (is_in_foreign_content) {
+        if (auto integration_point_tag_name = find_tag_name(integration_point_tag_names, tag_name); integration_point_tag_name.has_value() && !token.is_self_closing())
+            m_open_elements.append({ *integration_point_tag_name, false });
+        return state;
+    }
+
+    return HTMLTokenizer::state_after_html_start_tag(tag_name, m_scripting_enabled).value_or(state);
+}
+
+}
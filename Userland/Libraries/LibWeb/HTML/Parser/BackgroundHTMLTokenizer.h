@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/ByteBuffer.h>
+#include <AK/ByteString.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Queue.h>
+#include <AK/Vector.h>
+#include <LibTextCodec/Decoder.h>
+#include <LibThreading/ConditionVariable.h>
+#include <LibThreading/Mutex.h>
+#include <LibThreading/Thread.h>
+#include <LibWeb/HTML/Parser/HTMLTokenizer.h>
+
+namespace Web::HTML {
+
+// Runs an HTMLTokenizer on its own thread, ahead of the tree builder, and hands the tokens over to the main thread in
+// batches. Whenever the tree builder would switch the tokenizer to another state after a token, this guesses the switch
+// from the token and what it has seen of the document, and carries on in that state; HTMLTokenizer checks each guess
+// against what the tree builder actually did, and takes over from the last checkpoint when one turns out wrong.
+class BackgroundHTMLTokenizer {
+    AK_MAKE_NONCOPYABLE(BackgroundHTMLTokenizer);
+    AK_MAKE_NONMOVABLE(BackgroundHTMLTokenizer);
+
+public:
+    // Decodes the input on the background thread as well, and tokenizes it from the start.
+    static ErrorOr<NonnullOwnPtr<BackgroundHTMLTokenizer>> decode_and_start(StringView input, StringView encoding, bool scripting_enabled);
+
+    // Tokenizes already decoded input from the checkpoint on. The input has to outlive the background tokenizer.
+    static ErrorOr<NonnullOwnPtr<BackgroundHTMLTokenizer>> start(StringView decoded_input, HTMLTokenizer::Checkpoint, bool scripting_enabled);
+
+    // Stops the thread and waits for it to exit.
+    ~BackgroundHTMLTokenizer();
+
+    // Waits for the input to be decoded, and hands it over. This is only for a tokenizer made by decode_and_start(), and
+    // has to happen before the tokenizer is destroyed, as the tokens it makes point into the decoded input.
+    ByteString wait_for_decoded_input();
+
+    // Waits for the next batch of tokens. An empty batch means there won't be any more.
+    Vector<HTMLTokenizer::BackgroundToken> take_tokens();
+
+private:
+    BackgroundHTMLTokenizer(HTMLTokenizer::Checkpoint, bool scripting_enabled);
+
+    ErrorOr<void> start_thread();
+    void tokenize();
+    bool hand_over(Vector<HTMLTokenizer::BackgroundToken>);
+
+    HTMLTokenizer::State predict_state_after(HTMLToken const&, HTMLTokenizer::State);
+
+    // Set up by the main thread before the background thread starts, and only touched by that thread from then on.
+    Optional<ByteBuffer> m_undecoded_input;
+    TextCodec::Decoder* m_decoder { nullptr };
+    StringView m_decoded_input;
+    HTMLTokenizer::Checkpoint m_checkpoint;
+    bool m_scripting_enabled { false };
+
+    RefPtr<Threading::Thread> m_thread;
+    Atomic<bool> m_should_stop { false };
+
+    // Guarded by the mutex.
+    Threading::Mutex m_mutex;
+    Threading::ConditionVariable m_condition { m_mutex };
+    Optional<ByteString> m_decoded_input_for_main_thread;
+    bool m_has_decoded_input { false };
+    Queue<Vector<HTMLTokenizer::BackgroundToken>> m_batches;
+    bool m_has_finished { false };
+
+    // The elements that decide how start tags are handled: foreign elements, and HTML integration points in them. Only
+    // touched by the background thread.
+    struct OpenElement {
+        StringView tag_name;
+        bool is_foreign { false };
+    };
+    Vector<OpenElement> m_open_elements;
+};
+
+}
@@ -33,6 +33,7 @@
 #include <LibWeb/HTML/Parser/HTMLEncodingDetection.h>
 #include <LibWeb/HTML/Parser/HTMLParser.h>
 #include <LibWeb/HTML/Parser/HTMLToken.h>
+#include <LibWeb/HTML/Parser/SpeculativeHTMLParser.h>
 #include <LibWeb/HTML/Window.h>
 #include <LibWeb/HighResolutionTime/TimeOrigin.h>
 #include <LibWeb/Infra/CharacterTypes.h>
@@ -144,6 +145,15 @@ HTMLParser::HTMLParser(DOM::Document& document, StringView input, StringView enc
     m_document->set_encoding(MUST(String::from_utf8(standardized_encoding.value())));
 }
 
+HTMLParser::HTMLParser(DOM::Document& document, StringView input, StringView encoding, TokenizeInBackground)
+    : HTMLParser(document)
+{
+    m_tokenizer.start_tokenizing_in_background(input, encoding, m_scripting_enabled);
+    auto standardized_encoding = TextCodec::get_standardized_encoding(encoding);
+    VERIFY(standardized_encoding.has_value());
+    m_document->set_encoding(MUST(String::from_utf8(standardized_encoding.value())));
+}
+
 HTMLParser::HTMLParser(DOM::Document& document)
     : m_scripting_enabled(document.is_scripting_enabled())
     , m_document(JS::make_handle(document))
@@ -2732,6 +2742,18 @@ void HTMLParser::adjust_foreign_attributes(HTMLToken& token)
     }
 }
 
+// https://html.spec.whatwg.org/multipage/parsing.html#start-the-speculative-html-parser
+void HTMLParser::start_the_speculative_html_parser()
+{
+    // NOTE: The whole input is known up front, so looking through it once covers everything the parser has yet to get to,
+    //       except for what scripts write into it later.
+    if (m_has_run_speculative_parser)
+        return;
+    m_has_run_speculative_parser = true;
+
+    SpeculativeHTMLParser::run(*m_document, m_tokenizer.unconsumed_input());
+}
+
 void HTMLParser::increment_script_nesting_level()
 {
     ++m_script_nesting_level;
@@ -2826,7 +2848,8 @@ void HTMLParser::handle_text(HTMLToken& token)
                     // 2. Set the pending parsing-blocking script to null.
                     auto the_script = document().take_pending_parsing_blocking_script({});
 
-                    // FIXME: 3. Start the speculative HTML parser for this instance of the HTML parser.
+                    // 3. Start the speculative HTML parser for this instance of the HTML parser.
+                    start_the_speculative_html_parser();
 
                     // 4. Block the tokenizer for this instance of the HTML parser, such that the event loop will not run tasks that invoke the tokenizer.
                     m_tokenizer.set_blocked(true);
@@ -2845,7 +2868,8 @@ void HTMLParser::handle_text(HTMLToken& token)
                     if (m_aborted)
                         return;
 
-                    // FIXME: 7. Stop the speculative HTML parser for this instance of the HTML parser.
+                    // 7. Stop the speculative HTML parser for this instance of the HTML parser.
+                    // NOTE: The speculative parser runs to the end of the input as soon as it's started, so it has already stopped.
 
                     // 8. Unblock the tokenizer for this instance of the HTML parser, such that tasks that invoke the tokenizer can again be run.
                     m_tokenizer.set_blocked(false);
@@ -4263,12 +4287,21 @@ JS::NonnullGCPtr<HTMLParser> HTMLParser::create_for_scripting(DOM::Document& doc
     return document.heap().allocate_without_realm<HTMLParser>(document);
 }
 
+// Below this, tokenizing on another thread costs more than it saves.
+static constexpr size_t minimum_input_size_to_tokenize_in_background = 64 * KiB;
+
 JS::NonnullGCPtr<HTMLParser> HTMLParser::create_with_uncertain_encoding(DOM::Document& document, ByteBuffer const& input)
 {
-    if (document.has_encoding())
-        return document.heap().allocate_without_realm<HTMLParser>(document, input, document.encoding().value().to_byte_string());
-    auto encoding = run_encoding_sniffing_algorithm(document, input);
-    dbgln_if(HTML_PARSER_DEBUG, "The encoding sniffing algorithm returned encoding '{}'", encoding);
+    ByteString encoding;
+    if (document.has_encoding()) {
+        encoding = document.encoding().value().to_byte_string();
+    } else {
+        encoding = run_encoding_sniffing_algorithm(document, input);
+        dbgln_if(HTML_PARSER_DEBUG, "The encoding sniffing algorithm returned encoding '{}'", encoding);
+    }
+
+    if (input.size() >= minimum_input_size_to_tokenize_in_background)
+        return document.heap().allocate_without_realm<HTMLParser>(document, input, encoding, TokenizeInBackground::Yes);
     return document.heap().allocate_without_realm<HTMLParser>(document, input, encoding);
 }
 
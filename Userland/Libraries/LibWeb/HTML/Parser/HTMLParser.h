@@ -85,6 +85,12 @@ public:
 
 private:
     HTMLParser(DOM::Document&, StringView input, StringView encoding);
+
+    // Leaves decoding and tokenizing the input to another thread, while the tree builder runs on this one.
+    enum class TokenizeInBackground {
+        Yes,
+    };
+    HTMLParser(DOM::Document&, StringView input, StringView encoding, TokenizeInBackground);
     HTMLParser(DOM::Document&);
 
     virtual void visit_edges(Cell::Visitor&) override;
@@ -144,6 +150,7 @@ private:
     void process_using_the_rules_for(InsertionMode, HTMLToken&);
     void process_using_the_rules_for_foreign_content(HTMLToken&);
     void parse_generic_raw_text_element(HTMLToken&);
+    void start_the_speculative_html_parser();
     void increment_script_nesting_level();
     void decrement_script_nesting_level();
     void reset_the_insertion_mode_appropriately();
@@ -184,6 +191,7 @@ private:
     bool m_invoked_via_document_write { false };
     bool m_aborted { false };
     bool m_parser_pause_flag { false };
+    bool m_has_run_speculative_parser { false };
     bool m_stop_parsing { false };
     size_t m_script_nesting_level { 0 };
 
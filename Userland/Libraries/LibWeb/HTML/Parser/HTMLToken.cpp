@@ -8,6 +8,21 @@
 
 namespace Web::HTML {
 
+void HTMLToken::intern_names()
+{
+    if (!m_uninterned_names)
+        return;
+
+    if (m_uninterned_names->tag_name.has_value())
+        m_string_data = FlyString { m_uninterned_names->tag_name.release_value() };
+
+    auto& attribute_local_names = m_uninterned_names->attribute_local_names;
+    for (size_t i = 0; i < attribute_local_names.size(); ++i)
+        tag_attributes()->at(i).local_name = FlyString { move(attribute_local_names[i]) };
+
+    m_uninterned_names = nullptr;
+}
+
 String HTMLToken::to_string() const
 {
     StringBuilder builder;
@@ -156,6 +156,33 @@ public:
         m_string_data = move(name);
     }
 
+    // The tag name, whether or not it has been interned yet.
+    StringView raw_tag_name() const
+    {
+        VERIFY(is_start_tag() || is_end_tag());
+        if (m_uninterned_names && m_uninterned_names->tag_name.has_value())
+            return m_uninterned_names->tag_name->bytes_as_string_view();
+        return m_string_data.bytes_as_string_view();
+    }
+
+    // NOTE: FlyStrings can only be made on the main thread, so a tokenizer running on another thread leaves tag and
+    //       attribute names as plain strings, which intern_names() turns into FlyStrings once the token gets there.
+    void set_uninterned_tag_name(String name)
+    {
+        VERIFY(is_start_tag() || is_end_tag());
+        ensure_uninterned_names().tag_name = move(name);
+    }
+
+    void set_uninterned_local_name_of_last_attribute(String name)
+    {
+        VERIFY(has_attributes());
+        auto& names = ensure_uninterned_names().attribute_local_names;
+        names.resize(attribute_count());
+        names.last() = move(name);
+    }
+
+    void intern_names();
+
     bool is_self_closing() const
     {
         VERIFY(is_start_tag() || is_end_tag());
@@ -339,6 +366,18 @@ private:
         return m_data.get<OwnPtr<Vector<Attribute>>>().ptr();
     }
 
+    struct UninternedNames {
+        Optional<String> tag_name;
+        Vector<String> attribute_local_names;
+    };
+
+    UninternedNames& ensure_uninterned_names()
+    {
+        if (!m_uninterned_names)
+            m_uninterned_names = make<UninternedNames>();
+        return *m_uninterned_names;
+    }
+
     Vector<Attribute>& ensure_tag_attributes()
     {
         VERIFY(is_start_tag() || is_end_tag());
@@ -357,6 +396,9 @@ private:
     // Type::StartTag and Type::EndTag (tag name)
     FlyString m_string_data;
 
+    // Type::StartTag and Type::EndTag (see intern_names())
+    OwnPtr<UninternedNames> m_uninterned_names;
+
     // Type::Comment (comment data)
     String m_comment_data;
 
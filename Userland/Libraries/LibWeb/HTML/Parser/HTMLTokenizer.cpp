@@ -10,6 +10,7 @@
 #include <AK/GenericShorthands.h>
 #include <AK/SourceLocation.h>
 #include <LibTextCodec/Decoder.h>
+#include <LibWeb/HTML/Parser/BackgroundHTMLTokenizer.h>
 #include <LibWeb/HTML/Parser/Entities.h>
 #include <LibWeb/HTML/Parser/HTMLParser.h>
 #include <LibWeb/HTML/Parser/HTMLToken.h>
@@ -271,6 +272,16 @@ _StartOfFunction:
     if (m_aborted)
         return {};
 
+    if (should_resume_tokenizing_in_background())
+        resume_tokenizing_in_background();
+
+    if (m_background_tokenizer) {
+        if (stop_at_insertion_point == StopAtInsertionPoint::Yes)
+            stop_tokenizing_in_background();
+        else if (auto token = next_token_from_background(); token.has_value())
+            return token;
+    }
+
     for (;;) {
         if (stop_at_insertion_point == StopAtInsertionPoint::Yes && is_insertion_point_reached())
             return {};
@@ -347,19 +358,19 @@ _StartOfFunction:
             {
                 ON_WHITESPACE
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     m_current_token.set_end_position({}, nth_last_position(1));
                     SWITCH_TO(BeforeAttributeName);
                 }
                 ON('/')
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     m_current_token.set_end_position({}, nth_last_position(0));
                     SWITCH_TO(SelfClosingStartTag);
                 }
                 ON('>')
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     SWITCH_TO_AND_EMIT_CURRENT_TOKEN(Data);
                 }
                 ON_ASCII_UPPER_ALPHA
@@ -433,6 +444,11 @@ _StartOfFunction:
                 if (consume_next_if_match("[CDATA["sv)) {
                     // We keep the parser optional so that syntax highlighting can be lexer-only.
                     // The parser registers itself with the lexer it creates.
+                    if (m_stops_at_cdata_section) {
+                        // NOTE: Without the tree builder, there's no telling whether this is a CDATA section, so
+                        //       this is as far as this tokenizer goes.
+                        return {};
+                    }
                     if (m_parser != nullptr && m_parser->adjusted_current_node().namespace_uri() != Namespace::HTML) {
                         SWITCH_TO(CDATASection);
                     } else {
@@ -1120,31 +1136,31 @@ _StartOfFunction:
                 ON_WHITESPACE
                 {
                     m_current_token.last_attribute().name_end_position = nth_last_position(1);
-                    m_current_token.last_attribute().local_name = consume_current_builder();
+                    set_local_name_of_current_attribute(consume_current_builder());
                     RECONSUME_IN(AfterAttributeName);
                 }
                 ON('/')
                 {
                     m_current_token.last_attribute().name_end_position = nth_last_position(1);
-                    m_current_token.last_attribute().local_name = consume_current_builder();
+                    set_local_name_of_current_attribute(consume_current_builder());
                     RECONSUME_IN(AfterAttributeName);
                 }
                 ON('>')
                 {
                     m_current_token.last_attribute().name_end_position = nth_last_position(1);
-                    m_current_token.last_attribute().local_name = consume_current_builder();
+                    set_local_name_of_current_attribute(consume_current_builder());
                     RECONSUME_IN(AfterAttributeName);
                 }
                 ON_EOF
                 {
                     m_current_token.last_attribute().name_end_position = nth_last_position(1);
-                    m_current_token.last_attribute().local_name = consume_current_builder();
+                    set_local_name_of_current_attribute(consume_current_builder());
                     RECONSUME_IN(AfterAttributeName);
                 }
                 ON('=')
                 {
                     m_current_token.last_attribute().name_end_position = nth_last_position(1);
-                    m_current_token.last_attribute().local_name = consume_current_builder();
+                    set_local_name_of_current_attribute(consume_current_builder());
                     SWITCH_TO(BeforeAttributeValue);
                 }
                 ON_ASCII_UPPER_ALPHA
@@ -1952,7 +1968,7 @@ _StartOfFunction:
             {
                 ON_WHITESPACE
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (!current_end_tag_token_is_appropriate()) {
                         m_queued_tokens.enqueue(HTMLToken::make_character('<'));
                         m_queued_tokens.enqueue(HTMLToken::make_character('/'));
@@ -1964,7 +1980,7 @@ _StartOfFunction:
                 }
                 ON('/')
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (!current_end_tag_token_is_appropriate()) {
                         m_queued_tokens.enqueue(HTMLToken::make_character('<'));
                         m_queued_tokens.enqueue(HTMLToken::make_character('/'));
@@ -1976,7 +1992,7 @@ _StartOfFunction:
                 }
                 ON('>')
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (!current_end_tag_token_is_appropriate()) {
                         m_queued_tokens.enqueue(HTMLToken::make_character('<'));
                         m_queued_tokens.enqueue(HTMLToken::make_character('/'));
@@ -2071,7 +2087,7 @@ _StartOfFunction:
             {
                 ON_WHITESPACE
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (!current_end_tag_token_is_appropriate()) {
                         m_queued_tokens.enqueue(HTMLToken::make_character('<'));
                         m_queued_tokens.enqueue(HTMLToken::make_character('/'));
@@ -2083,7 +2099,7 @@ _StartOfFunction:
                 }
                 ON('/')
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (!current_end_tag_token_is_appropriate()) {
                         m_queued_tokens.enqueue(HTMLToken::make_character('<'));
                         m_queued_tokens.enqueue(HTMLToken::make_character('/'));
@@ -2095,7 +2111,7 @@ _StartOfFunction:
                 }
                 ON('>')
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (!current_end_tag_token_is_appropriate()) {
                         m_queued_tokens.enqueue(HTMLToken::make_character('<'));
                         m_queued_tokens.enqueue(HTMLToken::make_character('/'));
@@ -2295,7 +2311,7 @@ _StartOfFunction:
             {
                 ON_WHITESPACE
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (current_end_tag_token_is_appropriate())
                         SWITCH_TO(BeforeAttributeName);
 
@@ -2310,7 +2326,7 @@ _StartOfFunction:
                 }
                 ON('/')
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (current_end_tag_token_is_appropriate())
                         SWITCH_TO(SelfClosingStartTag);
 
@@ -2325,7 +2341,7 @@ _StartOfFunction:
                 }
                 ON('>')
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (current_end_tag_token_is_appropriate())
                         SWITCH_TO_AND_EMIT_CURRENT_TOKEN(Data);
 
@@ -2641,7 +2657,7 @@ _StartOfFunction:
             {
                 ON_WHITESPACE
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (current_end_tag_token_is_appropriate())
                         SWITCH_TO(BeforeAttributeName);
                     m_queued_tokens.enqueue(HTMLToken::make_character('<'));
@@ -2654,7 +2670,7 @@ _StartOfFunction:
                 }
                 ON('/')
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (current_end_tag_token_is_appropriate())
                         SWITCH_TO(SelfClosingStartTag);
                     m_queued_tokens.enqueue(HTMLToken::make_character('<'));
@@ -2667,7 +2683,7 @@ _StartOfFunction:
                 }
                 ON('>')
                 {
-                    m_current_token.set_tag_name(consume_current_builder());
+                    set_current_tag_name(consume_current_builder());
                     if (current_end_tag_token_is_appropriate())
                         SWITCH_TO_AND_EMIT_CURRENT_TOKEN(Data);
                     m_queued_tokens.enqueue(HTMLToken::make_character('<'));
@@ -2804,15 +2820,239 @@ HTMLTokenizer::HTMLTokenizer(StringView input, ByteString const& encoding)
 {
     auto decoder = TextCodec::decoder_for(encoding);
     VERIFY(decoder.has_value());
-    m_decoded_input = decoder->to_utf8(input).release_value_but_fixme_should_propagate_errors().to_byte_string();
+    set_decoded_input(decoder->to_utf8(input).release_value_but_fixme_should_propagate_errors().to_byte_string());
+    m_source_positions.empend(0u, 0u);
+}
+
+HTMLTokenizer::HTMLTokenizer(Badge<BackgroundHTMLTokenizer>, StringView decoded_input, Checkpoint checkpoint)
+    : m_interns_names(false)
+    , m_stops_at_cdata_section(true)
+{
+    m_utf8_view = Utf8View(decoded_input);
+    restore_checkpoint(checkpoint);
+}
+
+HTMLTokenizer::~HTMLTokenizer() = default;
+
+void HTMLTokenizer::set_decoded_input(ByteString decoded_input)
+{
+    m_decoded_input = move(decoded_input);
     m_utf8_view = Utf8View(m_decoded_input);
     m_utf8_iterator = m_utf8_view.begin();
     m_prev_utf8_iterator = m_utf8_view.begin();
-    m_source_positions.empend(0u, 0u);
+}
+
+// Tokenizing in the background only pays off for large documents, so after falling back to the main thread, this is how
+// much input the main thread gets through before handing tokenizing back to another thread.
+static constexpr size_t input_to_tokenize_before_resuming_in_background = 16 * KiB;
+
+void HTMLTokenizer::start_tokenizing_in_background(StringView input, StringView encoding, bool scripting_enabled)
+{
+    auto background_tokenizer_or_error = BackgroundHTMLTokenizer::decode_and_start(input, encoding, scripting_enabled);
+    if (background_tokenizer_or_error.is_error()) {
+        dbgln("HTMLTokenizer: Unable to tokenize in the background: {}", background_tokenizer_or_error.error());
+        auto decoder = TextCodec::decoder_for(encoding);
+        VERIFY(decoder.has_value());
+        set_decoded_input(decoder->to_utf8(input).release_value_but_fixme_should_propagate_errors().to_byte_string());
+        return;
+    }
+
+    m_background_tokenizer = background_tokenizer_or_error.release_value();
+    m_may_tokenize_in_background = true;
+    m_scripting_enabled = scripting_enabled;
+    m_is_waiting_for_decoded_input = true;
+    m_last_checkpoint = {};
+    m_tokens_since_last_checkpoint = 0;
+}
+
+Optional<HTMLTokenizer::State> HTMLTokenizer::state_after_html_start_tag(StringView tag_name, bool scripting_enabled)
+{
+    if (tag_name == "script"sv)
+        return State::ScriptData;
+    if (tag_name.is_one_of("style"sv, "xmp"sv, "iframe"sv, "noembed"sv, "noframes"sv) || (tag_name == "noscript"sv && scripting_enabled))
+        return State::RAWTEXT;
+    if (tag_name.is_one_of("textarea"sv, "title"sv))
+        return State::RCDATA;
+    if (tag_name == "plaintext"sv)
+        return State::PLAINTEXT;
+    return {};
+}
+
+Optional<HTMLTokenizer::Checkpoint> HTMLTokenizer::checkpoint() const
+{
+    if (!m_queued_tokens.is_empty() || !m_current_builder.is_empty())
+        return {};
+    if (!first_is_one_of(m_state, State::Data, State::RCDATA, State::RAWTEXT, State::ScriptData, State::PLAINTEXT))
+        return {};
+
+    // NOTE: Checkpoints get passed between threads, so they can't share the name with the tokenizer.
+    Optional<String> last_emitted_start_tag_name;
+    if (m_last_emitted_start_tag_name.has_value())
+        last_emitted_start_tag_name = String::from_utf8_without_validation(m_last_emitted_start_tag_name->bytes());
+
+    return Checkpoint {
+        .byte_offset = m_utf8_view.byte_offset_of(m_utf8_iterator),
+        .state = m_state,
+        .last_emitted_start_tag_name = move(last_emitted_start_tag_name),
+        .position = m_source_positions.is_empty() ? HTMLToken::Position {} : m_source_positions.last(),
+        .has_emitted_eof = m_has_emitted_eof,
+    };
+}
+
+void HTMLTokenizer::restore_checkpoint(Checkpoint const& checkpoint)
+{
+    m_utf8_iterator = m_utf8_view.iterator_at_byte_offset(checkpoint.byte_offset);
+    m_prev_utf8_iterator = m_utf8_iterator;
+    m_state = checkpoint.state;
+    m_last_emitted_start_tag_name = checkpoint.last_emitted_start_tag_name;
+    m_has_emitted_eof = checkpoint.has_emitted_eof;
+    m_queued_tokens.clear();
+    m_current_builder.clear();
+    m_temporary_buffer.clear();
+    m_source_positions.clear_with_capacity();
+    m_source_positions.append(checkpoint.position);
+}
+
+bool HTMLTokenizer::should_resume_tokenizing_in_background() const
+{
+    if (!m_may_tokenize_in_background || m_background_tokenizer)
+        return false;
+    if (m_explicit_eof_inserted || m_has_emitted_eof || m_insertion_point.defined)
+        return false;
+    if (m_utf8_view.byte_offset_of(m_utf8_iterator) < m_resume_tokenizing_in_background_at)
+        return false;
+    return checkpoint().has_value();
+}
+
+void HTMLTokenizer::resume_tokenizing_in_background()
+{
+    auto background_tokenizer_or_error = BackgroundHTMLTokenizer::start(m_decoded_input.view(), checkpoint().release_value(), m_scripting_enabled);
+    if (background_tokenizer_or_error.is_error()) {
+        dbgln("HTMLTokenizer: Unable to tokenize in the background: {}", background_tokenizer_or_error.error());
+        m_may_tokenize_in_background = false;
+        return;
+    }
+
+    m_background_tokenizer = background_tokenizer_or_error.release_value();
+    m_last_checkpoint = checkpoint().release_value();
+    m_tokens_since_last_checkpoint = 0;
+}
+
+Optional<HTMLToken> HTMLTokenizer::next_token_from_background()
+{
+    // The background tokenizer carried on after the last token in the state it expected the tree builder to switch to.
+    // If the tree builder did something else, none of the tokens after that one can be used.
+    if (m_predicted_state.has_value() && m_predicted_state.value() != m_state) {
+        dbgln_if(HTML_PARSER_DEBUG, "HTMLTokenizer: Background tokenizer expected {} instead of {}", state_name(m_predicted_state.value()), state_name(m_state));
+        stop_tokenizing_in_background();
+        return {};
+    }
+
+    if (m_next_background_token_index == m_background_tokens.size()) {
+        m_background_tokens = m_background_tokenizer->take_tokens();
+        m_next_background_token_index = 0;
+        if (m_is_waiting_for_decoded_input)
+            wait_for_input_decoded_in_background();
+
+        // NOTE: This happens at the end of the input, and where the background tokenizer needs the tree builder to
+        //       make sense of it.
+        if (m_background_tokens.is_empty()) {
+            stop_tokenizing_in_background();
+            return {};
+        }
+    }
+
+    auto& background_token = m_background_tokens[m_next_background_token_index++];
+    m_state = background_token.state_after_token;
+    m_predicted_state = background_token.predicted_state;
+    if (background_token.checkpoint.has_value()) {
+        m_last_checkpoint = background_token.checkpoint.release_value();
+        m_tokens_since_last_checkpoint = 0;
+    } else {
+        ++m_tokens_since_last_checkpoint;
+    }
+
+    auto token = move(background_token.token);
+    token.intern_names();
+    return token;
+}
+
+void HTMLTokenizer::wait_for_input_decoded_in_background()
+{
+    VERIFY(m_is_waiting_for_decoded_input);
+    set_decoded_input(m_background_tokenizer->wait_for_decoded_input());
+    m_is_waiting_for_decoded_input = false;
+}
+
+void HTMLTokenizer::stop_tokenizing_in_background()
+{
+    if (!m_background_tokenizer)
+        return;
+    discard_background_tokenizer();
+
+    // Tokenizing carries on from the last checkpoint, past the tokens the tree builder has already been given. Those come
+    // out the same as before, so they leave the tokenizer in the state the tree builder has already seen it in.
+    auto state = m_state;
+    auto tokens_to_skip = m_tokens_since_last_checkpoint;
+    m_resume_tokenizing_in_background_at = NumericLimits<size_t>::max();
+    restore_checkpoint(m_last_checkpoint);
+    for (size_t i = 0; i < tokens_to_skip; ++i)
+        (void)next_token();
+    m_state = state;
+
+    m_tokens_since_last_checkpoint = 0;
+    m_resume_tokenizing_in_background_at = m_utf8_view.byte_offset_of(m_utf8_iterator) + input_to_tokenize_before_resuming_in_background;
+}
+
+void HTMLTokenizer::discard_background_tokenizer()
+{
+    if (!m_background_tokenizer)
+        return;
+    if (m_is_waiting_for_decoded_input)
+        wait_for_input_decoded_in_background();
+    m_background_tokenizer = nullptr;
+    m_background_tokens.clear();
+    m_next_background_token_index = 0;
+    m_predicted_state.clear();
+}
+
+size_t HTMLTokenizer::input_offset()
+{
+    // NOTE: While tokenizing in the background, where the tree builder is in the input is only known when it's at a
+    //       checkpoint.
+    if (m_background_tokenizer && m_tokens_since_last_checkpoint > 0)
+        stop_tokenizing_in_background();
+    if (m_background_tokenizer)
+        return m_last_checkpoint.byte_offset;
+    return m_utf8_view.byte_offset_of(m_utf8_iterator);
+}
+
+ByteString HTMLTokenizer::source()
+{
+    if (m_is_waiting_for_decoded_input)
+        wait_for_input_decoded_in_background();
+    return m_decoded_input;
+}
+
+StringView HTMLTokenizer::unconsumed_input()
+{
+    auto offset = input_offset();
+    if (m_is_waiting_for_decoded_input)
+        wait_for_input_decoded_in_background();
+    return m_decoded_input.substring_view(offset);
+}
+
+void HTMLTokenizer::abort()
+{
+    m_aborted = true;
+    m_may_tokenize_in_background = false;
+    discard_background_tokenizer();
 }
 
 void HTMLTokenizer::insert_input_at_insertion_point(StringView input)
 {
+    stop_tokenizing_in_background();
+
     auto utf8_iterator_byte_offset = m_utf8_view.byte_offset_of(m_utf8_iterator);
     auto prev_utf8_iterator_byte_offset = m_utf8_view.byte_offset_of(m_prev_utf8_iterator);
 
@@ -2832,6 +3072,7 @@ void HTMLTokenizer::insert_input_at_insertion_point(StringView input)
 
 void HTMLTokenizer::insert_eof()
 {
+    stop_tokenizing_in_background();
     m_explicit_eof_inserted = true;
 }
 
@@ -2859,7 +3100,7 @@ void HTMLTokenizer::switch_to(Badge<HTMLParser>, State new_state)
 void HTMLTokenizer::will_emit(HTMLToken& token)
 {
     if (token.is_start_tag())
-        m_last_emitted_start_tag_name = token.tag_name().to_deprecated_fly_string();
+        m_last_emitted_start_tag_name = String::from_utf8_without_validation(token.raw_tag_name().bytes());
 
     auto is_start_or_end_tag = token.type() == HTMLToken::Type::StartTag || token.type() == HTMLToken::Type::EndTag;
     token.set_end_position({}, nth_last_position(is_start_or_end_tag ? 1 : 0));
@@ -2870,7 +3111,23 @@ bool HTMLTokenizer::current_end_tag_token_is_appropriate() const
     VERIFY(m_current_token.is_end_tag());
     if (!m_last_emitted_start_tag_name.has_value())
         return false;
-    return m_current_token.tag_name().to_deprecated_fly_string() == m_last_emitted_start_tag_name.value();
+    return m_current_token.raw_tag_name() == m_last_emitted_start_tag_name->bytes_as_string_view();
+}
+
+void HTMLTokenizer::set_current_tag_name(String name)
+{
+    if (m_interns_names)
+        m_current_token.set_tag_name(move(name));
+    else
+        m_current_token.set_uninterned_tag_name(move(name));
+}
+
+void HTMLTokenizer::set_local_name_of_current_attribute(String name)
+{
+    if (m_interns_names)
+        m_current_token.last_attribute().local_name = move(name);
+    else
+        m_current_token.set_uninterned_local_name_of_last_attribute(move(name));
 }
 
 bool HTMLTokenizer::consumed_as_part_of_an_attribute() const
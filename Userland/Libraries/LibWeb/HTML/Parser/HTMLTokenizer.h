@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <AK/OwnPtr.h>
 #include <AK/Queue.h>
 #include <AK/StringBuilder.h>
 #include <AK/StringView.h>
@@ -100,10 +101,13 @@ namespace Web::HTML {
     __ENUMERATE_TOKENIZER_STATE(DecimalCharacterReference)                \
     __ENUMERATE_TOKENIZER_STATE(NumericCharacterReferenceEnd)
 
+class BackgroundHTMLTokenizer;
+
 class HTMLTokenizer {
 public:
     explicit HTMLTokenizer();
     explicit HTMLTokenizer(StringView input, ByteString const& encoding);
+    ~HTMLTokenizer();
 
     enum class State {
 #define __ENUMERATE_TOKENIZER_STATE(state) state,
@@ -111,6 +115,33 @@ public:
 #undef __ENUMERATE_TOKENIZER_STATE
     };
 
+    // A point between two tokens where tokenizing can start over, knowing nothing but what's in here: nothing is
+    // queued up, and the tokenizer is in one of the states the tree builder switches it to.
+    struct Checkpoint {
+        size_t byte_offset { 0 };
+        State state { State::Data };
+        Optional<String> last_emitted_start_tag_name;
+        HTMLToken::Position position;
+        bool has_emitted_eof { false };
+    };
+
+    // A token made by a tokenizer running ahead of the tree builder on another thread. That tokenizer can't ask the
+    // tree builder which state to carry on in after the token, so it makes a guess, which has to be checked against
+    // what the tree builder actually did before the next token can be used.
+    struct BackgroundToken {
+        HTMLToken token;
+        State state_after_token { State::Data };
+        State predicted_state { State::Data };
+        Optional<Checkpoint> checkpoint;
+    };
+
+    // Tokenizes the input on another thread ahead of the tree builder, after decoding it there as well. This is only
+    // meant for a tokenizer that hasn't been given any input yet.
+    void start_tokenizing_in_background(StringView input, StringView encoding, bool scripting_enabled);
+
+    // The state the tree builder is going to switch the tokenizer to after an HTML start tag with this name, if any.
+    static Optional<State> state_after_html_start_tag(StringView tag_name, bool scripting_enabled);
+
     enum class StopAtInsertionPoint {
         No,
         Yes,
@@ -128,7 +159,10 @@ public:
     void set_blocked(bool b) { m_blocked = b; }
     bool is_blocked() const { return m_blocked; }
 
-    ByteString source() const { return m_decoded_input; }
+    ByteString source();
+
+    // The part of the input that the tokenizer hasn't gotten to yet.
+    StringView unconsumed_input();
 
     void insert_input_at_insertion_point(StringView input);
     void insert_eof();
@@ -137,7 +171,7 @@ public:
     bool is_insertion_point_defined() const { return m_insertion_point.defined; }
     bool is_insertion_point_reached()
     {
-        return m_insertion_point.defined && m_utf8_view.iterator_offset(m_utf8_iterator) >= m_insertion_point.position;
+        return m_insertion_point.defined && input_offset() >= m_insertion_point.position;
     }
     void undefine_insertion_point() { m_insertion_point.defined = false; }
     void store_insertion_point() { m_old_insertion_point = m_insertion_point; }
@@ -145,13 +179,33 @@ public:
     void update_insertion_point()
     {
         m_insertion_point.defined = true;
-        m_insertion_point.position = m_utf8_view.iterator_offset(m_utf8_iterator);
+        m_insertion_point.position = input_offset();
     }
 
     // This permanently cuts off the tokenizer input stream.
-    void abort() { m_aborted = true; }
+    void abort();
+
+    // Used by BackgroundHTMLTokenizer, for tokenizing on its own thread from a checkpoint on. The input has to outlive
+    // the tokenizer.
+    HTMLTokenizer(Badge<BackgroundHTMLTokenizer>, StringView decoded_input, Checkpoint);
+    State state() const { return m_state; }
+    Optional<Checkpoint> checkpoint() const;
 
 private:
+    void set_current_tag_name(String);
+    void set_local_name_of_current_attribute(String);
+
+    size_t input_offset();
+    void set_decoded_input(ByteString);
+    void restore_checkpoint(Checkpoint const&);
+
+    Optional<HTMLToken> next_token_from_background();
+    bool should_resume_tokenizing_in_background() const;
+    void resume_tokenizing_in_background();
+    void wait_for_input_decoded_in_background();
+    void stop_tokenizing_in_background();
+    void discard_background_tokenizer();
+
     void skip(size_t count);
     Optional<u32> next_code_point();
     Optional<u32> peek_code_point(size_t offset) const;
@@ -204,7 +258,7 @@ private:
     HTMLToken m_current_token;
     StringBuilder m_current_builder;
 
-    Optional<ByteString> m_last_emitted_start_tag_name;
+    Optional<String> m_last_emitted_start_tag_name;
 
     bool m_explicit_eof_inserted { false };
     bool m_has_emitted_eof { false };
@@ -218,6 +272,24 @@ private:
     bool m_aborted { false };
 
     Vector<HTMLToken::Position> m_source_positions;
+
+    // FlyStrings can only be made on the main thread, so a tokenizer running anywhere else leaves names uninterned.
+    bool m_interns_names { true };
+
+    // Whether a CDATA section can be told apart from a bogus comment, which takes the tree builder.
+    bool m_stops_at_cdata_section { false };
+
+    // See start_tokenizing_in_background().
+    OwnPtr<BackgroundHTMLTokenizer> m_background_tokenizer;
+    bool m_may_tokenize_in_background { false };
+    bool m_scripting_enabled { false };
+    bool m_is_waiting_for_decoded_input { false };
+    Vector<BackgroundToken> m_background_tokens;
+    size_t m_next_background_token_index { 0 };
+    Optional<State> m_predicted_state;
+    Checkpoint m_last_checkpoint;
+    size_t m_tokens_since_last_checkpoint { 0 };
+    size_t m_resume_tokenizing_in_background_at { 0 };
 };
 
 }
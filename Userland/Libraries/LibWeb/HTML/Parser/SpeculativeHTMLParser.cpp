@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/CharacterTypes.h>
+#include <AK/HashTable.h>
+#include <LibWeb/DOM/Document.h>
+#include <LibWeb/Fetch/Fetching/Fetching.h>
+#include <LibWeb/Fetch/Infrastructure/HTTP/Headers.h>
+#include <LibWeb/Fetch/Infrastructure/HTTP/Requests.h>
+#include <LibWeb/HTML/AttributeNames.h>
+#include <LibWeb/HTML/Parser/HTMLTokenizer.h>
+#include <LibWeb/HTML/Parser/SpeculativeHTMLParser.h>
+#include <LibWeb/HTML/Scripting/Environments.h>
+#include <LibWeb/HTML/TagNames.h>
+#include <LibWeb/Loader/LoadRequest.h>
+#include <LibWeb/Loader/ResourceLoader.h>
+#include <LibWeb/MimeSniff/MimeType.h>
+#include <LibWeb/ReferrerPolicy/AbstractOperations.h>
+#include <LibWeb/SVG/TagNames.h>
+
+namespace Web::HTML {
+
+static bool rel_contains(StringView rel, StringView keyword)
+{
+    for (auto token : rel.split_view_if(is_ascii_space)) {
+        if (token.equals_ignoring_ascii_case(keyword))
+            return true;
+    }
+    return false;
+}
+
+// Returns the URL the element is going to fetch, if the real element would fetch it the same way a preload does.
+static Optional<StringView> url_to_fetch_for(HTMLToken const& token, bool scripting_enabled)
+{
+    // NOTE: Elements with a crossorigin attribute are fetched with different credentials than a preload, and those with
+    //       a referrerpolicy attribute with a different Referer header, so they're left to the parser.
+    if (token.raw_attribute(AttributeNames::crossorigin).has_value() || token.raw_attribute(AttributeNames::referrerpolicy).has_value())
+        return {};
+
+    auto attribute = [&](FlyString const& name) -> Optional<StringView> {
+        if (auto value = token.raw_attribute(name); value.has_value())
+            return value->value.bytes_as_string_view();
+        return {};
+    };
+
+    if (token.tag_name() == TagNames::script) {
+        if (scripting_enabled && token.raw_attribute(AttributeNames::nomodule).has_value())
+            return {};
+        if (auto type = attribute(AttributeNames::type); type.has_value()) {
+            auto trimmed_type = type->trim_whitespace();
+            if (!trimmed_type.is_empty() && !trimmed_type.equals_ignoring_ascii_case("module"sv) && !MimeSniff::is_javascript_mime_type_essence_match(trimmed_type))
+                return {};
+        }
+        return attribute(AttributeNames::src);
+    }
+
+    if (token.tag_name() == TagNames::link) {
+        auto rel = attribute(AttributeNames::rel);
+        if (!rel.has_value() || !rel_contains(*rel, "stylesheet"sv) || rel_contains(*rel, "alternate"sv))
+            return {};
+        return attribute(AttributeNames::href);
+    }
+
+    if (token.tag_name() == TagNames::img) {
+        // NOTE: Which source an image with a srcset ends up using depends on layout, so only plain images are preloaded.
+        if (token.raw_attribute(AttributeNames::srcset).has_value())
+            return {};
+        return attribute(AttributeNames::src);
+    }
+
+    return {};
+}
+
+// Builds the request that the element's own fetch ends up handing to the ResourceLoader, headers and all, since only a
+// load of the very same request takes over a preload. This follows what fetch() and HTTP-network-or-cache fetch add to
+// a no-cors request with the document as its client.
+static LoadRequest create_preload_request(DOM::Document& document, URL::URL const& url, Fetch::Infrastructure::Request::Destination destination)
+{
+    auto request = Fetch::Infrastructure::Request::create(document.vm());
+    request->set_url(url);
+    request->set_client(&relevant_settings_object(document));
+    request->set_origin(document.origin());
+    request->set_destination(destination);
+    request->set_mode(Fetch::Infrastructure::Request::Mode::NoCORS);
+    request->set_credentials_mode(Fetch::Infrastructure::Request::CredentialsMode::Include);
+    request->set_referrer_policy(document.policy_container().referrer_policy);
+
+    // NOTE: This adds the same cookies as HTTP-network-or-cache fetch does for requests that include credentials.
+    auto load_request = LoadRequest::create_for_url_on_page(url, &document.page());
+    load_request.set_includes_credentials(true);
+
+    auto accept = "*/*"sv;
+    if (destination == Fetch::Infrastructure::Request::Destination::Image)
+        accept = "image/png,image/svg+xml,image/*;q=0.8,*/*;q=0.5"sv;
+    else if (destination == Fetch::Infrastructure::Request::Destination::Style)
+        accept = "text/css,*/*;q=0.1"sv;
+    load_request.set_header("Accept", accept);
+    load_request.set_header("Accept-Language", "*");
+
+    if (auto referrer = ReferrerPolicy::determine_requests_referrer(*request); referrer.has_value())
+        load_request.set_header("Referer", referrer->serialize().to_byte_string());
+
+    Fetch::Fetching::append_fetch_metadata_headers_for_request(*request);
+    for (auto const& header : *request->header_list())
+        load_request.set_header(ByteString::copy(header.name), ByteString::copy(header.value));
+
+    load_request.set_header("User-Agent", ByteString::copy(Fetch::Infrastructure::default_user_agent_value()));
+    return load_request;
+}
+
+void SpeculativeHTMLParser::run(DOM::Document& document, StringView input)
+{
+    if (!document.browsing_context())
+        return;
+
+    HTMLTokenizer tokenizer { input, "UTF-8"sv };
+    bool scripting_enabled = document.is_scripting_enabled();
+
+    auto base_url = document.base_url();
+    bool has_seen_base_element = false;
+
+    // Content of templates isn't rendered, and foreign content doesn't have the elements we're looking for.
+    size_t template_depth = 0;
+    size_t foreign_content_depth = 0;
+
+    // Scripts and style sheets hold up the parser and rendering respectively, so they're fetched before any images.
+    struct URLToFetch {
+        URL::URL url;
+        Fetch::Infrastructure::Request::Destination destination;
+    };
+    Vector<URLToFetch> urls_to_fetch_first;
+    Vector<URLToFetch> urls_to_fetch_last;
+    HashTable<URL::URL> urls_seen;
+
+    for (;;) {
+        auto token = tokenizer.next_token();
+        if (!token.has_value() || token->is_end_of_file())
+            break;
+
+        if (token->is_end_tag()) {
+            if (token->tag_name() == TagNames::template_ && template_depth > 0)
+                --template_depth;
+            else if (token->tag_name().is_one_of(SVG::TagNames::svg, TagNames::math) && foreign_content_depth > 0)
+                --foreign_content_depth;
+            continue;
+        }
+
+        if (!token->is_start_tag())
+            continue;
+
+        auto const& tag_name = token->tag_name();
+
+        // Switch the tokenizer to the states the tree builder would, so the content of these elements isn't mistaken for tags.
+        if (auto state = HTMLTokenizer::state_after_html_start_tag(tag_name.bytes_as_string_view(), scripting_enabled); state.has_value())
+            tokenizer.switch_to(state.value());
+
+        if (tag_name == TagNames::template_) {
+            ++template_depth;
+            continue;
+        }
+        if (tag_name.is_one_of(SVG::TagNames::svg, TagNames::math)) {
+            if (!token->is_self_closing())
+                ++foreign_content_depth;
+            continue;
+        }
+        if (template_depth > 0 || foreign_content_depth > 0)
+            continue;
+
+        // The first base element with an href sets the base URL for everything after it.
+        if (tag_name == TagNames::base) {
+            if (has_seen_base_element)
+                continue;
+            if (auto href = token->attribute(AttributeNames::href); href.has_value()) {
+                has_seen_base_element = true;
+                if (auto new_base_url = document.fallback_base_url().complete_url(*href); new_base_url.is_valid())
+                    base_url = move(new_base_url);
+            }
+            continue;
+        }
+
+        auto url_string = url_to_fetch_for(*token, scripting_enabled);
+        if (!url_string.has_value() || url_string->is_empty())
+            continue;
+
+        auto url = base_url.complete_url(*url_string);
+        if (!url.is_valid() || urls_seen.set(url) != HashSetResult::InsertedNewEntry)
+            continue;
+
+        if (tag_name == TagNames::img)
+            urls_to_fetch_last.append({ move(url), Fetch::Infrastructure::Request::Destination::Image });
+        else if (tag_name == TagNames::link)
+            urls_to_fetch_first.append({ move(url), Fetch::Infrastructure::Request::Destination::Style });
+        else
+            urls_to_fetch_first.append({ move(url), Fetch::Infrastructure::Request::Destination::Script });
+    }
+
+    for (auto const& urls : { &urls_to_fetch_first, &urls_to_fetch_last }) {
+        for (auto const& url_to_fetch : *urls) {
+            auto request = create_preload_request(document, url_to_fetch.url, url_to_fetch.destination);
+            ResourceLoader::the().preload(request);
+        }
+    }
+}
+
+}
@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/StringView.h>
+#include <LibWeb/Forward.h>
+
+namespace Web::HTML {
+
+// https://html.spec.whatwg.org/multipage/parsing.html#speculative-html-parsing
+// While the parser is blocked on a script, this looks ahead in the rest of the input for the scripts, style sheets and
+// images that the document is going to need, and starts fetching them so they're ready by the time the parser gets
+// there. Only the tokenizer runs over the input; nothing is added to the document.
+class SpeculativeHTMLParser {
+public:
+    static void run(DOM::Document&, StringView input);
+};
+
+}
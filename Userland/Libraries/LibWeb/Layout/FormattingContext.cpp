@@ -174,6 +174,23 @@ struct DummyFormattingContext : public FormattingContext {
     virtual void run(Box const&, LayoutMode, AvailableSpace const&) override { }
 };
 
+// Stands in for the formatting context of a box whose layout was taken over from the previous layout pass.
+struct ReusedFormattingContext : public FormattingContext {
+    ReusedFormattingContext(Type type, LayoutState& state, Box const& box, FormattingContext* parent, LayoutState::FormattingContextResult const& result)
+        : FormattingContext(type, state, box, parent)
+        , m_automatic_content_width(result.automatic_content_width)
+        , m_automatic_content_height(result.automatic_content_height)
+    {
+    }
+    virtual CSSPixels automatic_content_width() const override { return m_automatic_content_width; }
+    virtual CSSPixels automatic_content_height() const override { return m_automatic_content_height; }
+    virtual void run(Box const&, LayoutMode, AvailableSpace const&) override { }
+
+private:
+    CSSPixels m_automatic_content_width { 0 };
+    CSSPixels m_automatic_content_height { 0 };
+};
+
 OwnPtr<FormattingContext> FormattingContext::create_independent_formatting_context_if_needed(LayoutState& state, Box const& child_box)
 {
     auto type = formatting_context_type_created_by_box(child_box);
@@ -225,13 +242,31 @@ OwnPtr<FormattingContext> FormattingContext::layout_inside(Box const& child_box,
 
     auto independent_formatting_context = create_independent_formatting_context_if_needed(m_state, child_box);
     if (independent_formatting_context)
-        independent_formatting_context->run(child_box, layout_mode, available_space);
+        run_independent_formatting_context(independent_formatting_context, child_box, layout_mode, available_space);
     else
         run(child_box, layout_mode, available_space);
 
     return independent_formatting_context;
 }
 
+void FormattingContext::run_independent_formatting_context(OwnPtr<FormattingContext>& context, Box const& box, LayoutMode layout_mode, AvailableSpace const& available_space)
+{
+    // Only the results of normal layout in the top-level state are kept around for the next layout pass.
+    if (layout_mode != LayoutMode::Normal || m_state.m_parent) {
+        context->run(box, layout_mode, available_space);
+        return;
+    }
+
+    if (auto const* result = m_state.reuse_formatting_context_result(box, available_space)) {
+        context = make<ReusedFormattingContext>(context->type(), m_state, box, this, *result);
+        return;
+    }
+
+    auto used_values_before_run = m_state.get(box);
+    context->run(box, layout_mode, available_space);
+    m_state.record_formatting_context_result(box, available_space, used_values_before_run, *context);
+}
+
 CSSPixels FormattingContext::greatest_child_width(Box const& box) const
 {
     CSSPixels max_width = 0;
@@ -115,6 +115,10 @@ protected:
 
     OwnPtr<FormattingContext> layout_inside(Box const&, LayoutMode, AvailableSpace const&);
 
+    // Runs the independent formatting context established by the box, unless its results can be taken over from the
+    // previous layout pass. In that case, the context is replaced with one that reports the results of that pass.
+    void run_independent_formatting_context(OwnPtr<FormattingContext>&, Box const&, LayoutMode, AvailableSpace const&);
+
     struct SpaceUsedByFloats {
         CSSPixels left { 0 };
         CSSPixels right { 0 };
@@ -9,6 +9,7 @@
 #include <LibWeb/DOM/ShadowRoot.h>
 #include <LibWeb/Layout/AvailableSpace.h>
 #include <LibWeb/Layout/BlockContainer.h>
+#include <LibWeb/Layout/FormattingContext.h>
 #include <LibWeb/Layout/InlineNode.h>
 #include <LibWeb/Layout/LayoutState.h>
 #include <LibWeb/Layout/Viewport.h>
@@ -71,6 +72,81 @@ LayoutState::UsedValues const& LayoutState::get(NodeWithStyle const& node) const
     return *new_used_values_ptr;
 }
 
+void LayoutState::record_formatting_context_result(Box const& box, AvailableSpace const& available_space, UsedValues const& used_values_before_run, FormattingContext const& context)
+{
+    VERIFY(!m_parent);
+
+    formatting_context_results.set(box, adopt_own(*new FormattingContextResult {
+                                            .available_space = available_space,
+                                            .used_values_before_run = used_values_before_run,
+                                            .used_values_after_run = get(box),
+                                            .automatic_content_width = context.automatic_content_width(),
+                                            .automatic_content_height = context.automatic_content_height(),
+                                        }));
+}
+
+LayoutState::FormattingContextResult const* LayoutState::reuse_formatting_context_result(Box const& box, AvailableSpace const& available_space)
+{
+    VERIFY(!m_parent);
+
+    if (!previous_pass || box.needs_layout() || box.child_needs_layout())
+        return nullptr;
+
+    auto const* result = previous_pass->formatting_context_results.get(box).value_or(nullptr);
+    if (!result || result->available_space != available_space)
+        return nullptr;
+
+    auto& box_state = get_mutable(box);
+    if (!box_state.has_same_formatting_context_inputs_as(result->used_values_before_run))
+        return nullptr;
+
+    // NOTE: Absolutely positioned boxes are laid out against containing blocks that may be outside of the subtree,
+    //       so subtrees with such boxes in them are always laid out again.
+    auto has_absolutely_positioned_descendants = false;
+    box.for_each_in_subtree([&](Node const& node) {
+        if (!node.is_absolutely_positioned())
+            return IterationDecision::Continue;
+        has_absolutely_positioned_descendants = true;
+        return IterationDecision::Break;
+    });
+    if (has_absolutely_positioned_descendants)
+        return nullptr;
+
+    // NOTE: Containing blocks come before the boxes they contain in tree order, so they're always taken over first.
+    box.for_each_in_subtree([&](Node const& node) {
+        if (auto const* used_values = previous_pass->used_values_per_layout_node.get(node).value_or(nullptr))
+            get_mutable(used_values->node()).take_over_from(*used_values);
+        if (!is<Box>(node))
+            return IterationDecision::Continue;
+        auto const& nested_box = static_cast<Box const&>(node);
+        if (auto const* nested_result = previous_pass->formatting_context_results.get(nested_box).value_or(nullptr))
+            formatting_context_results.set(nested_box, make<FormattingContextResult>(*nested_result));
+        return IterationDecision::Continue;
+    });
+
+    // The box itself was positioned by its parent formatting context, which may have moved it since the previous pass.
+    auto parent_used_values = box_state;
+    box_state.take_over_from(result->used_values_after_run);
+    box_state.offset = parent_used_values.offset;
+    box_state.margin_left = parent_used_values.margin_left;
+    box_state.margin_right = parent_used_values.margin_right;
+    box_state.margin_top = parent_used_values.margin_top;
+    box_state.margin_bottom = parent_used_values.margin_bottom;
+    box_state.inset_left = parent_used_values.inset_left;
+    box_state.inset_right = parent_used_values.inset_right;
+    box_state.inset_top = parent_used_values.inset_top;
+    box_state.inset_bottom = parent_used_values.inset_bottom;
+    box_state.vertical_offset_of_parent_block_container = parent_used_values.vertical_offset_of_parent_block_container;
+    box_state.containing_line_box_fragment = parent_used_values.containing_line_box_fragment;
+    if (parent_used_values.table_cell_coordinates().has_value())
+        box_state.set_table_cell_coordinates(*parent_used_values.table_cell_coordinates());
+
+    auto reused_result = make<FormattingContextResult>(*result);
+    auto const* reused_result_ptr = reused_result.ptr();
+    formatting_context_results.set(box, move(reused_result));
+    return reused_result_ptr;
+}
+
 // https://www.w3.org/TR/css-overflow-3/#scrollable-overflow
 static CSSPixelRect measure_scrollable_overflow(Box const& box)
 {
@@ -264,7 +340,7 @@ void LayoutState::commit(Box& root)
 
             if (used_values.computed_svg_path().has_value() && is<Painting::SVGPathPaintable>(paintable_box)) {
                 auto& svg_geometry_paintable = static_cast<Painting::SVGPathPaintable&>(paintable_box);
-                svg_geometry_paintable.set_computed_path(move(*used_values.computed_svg_path()));
+                svg_geometry_paintable.set_computed_path(*used_values.computed_svg_path());
             }
         }
     }
@@ -609,4 +685,33 @@ void LayoutState::UsedValues::set_indefinite_content_height()
     m_has_definite_height = false;
 }
 
+void LayoutState::UsedValues::take_over_from(UsedValues const& other)
+{
+    auto const* containing_block_used_values = m_containing_block_used_values;
+    *this = other;
+    m_containing_block_used_values = containing_block_used_values;
+}
+
+bool LayoutState::UsedValues::has_same_formatting_context_inputs_as(UsedValues const& other) const
+{
+    // FIXME: Compare the override borders data too, so the cells of tables with collapsing borders can be reused.
+    if (m_override_borders_data.has_value() || other.m_override_borders_data.has_value())
+        return false;
+
+    return m_content_width == other.m_content_width
+        && m_content_height == other.m_content_height
+        && m_has_definite_width == other.m_has_definite_width
+        && m_has_definite_height == other.m_has_definite_height
+        && width_constraint == other.width_constraint
+        && height_constraint == other.height_constraint
+        && border_left == other.border_left
+        && border_right == other.border_right
+        && border_top == other.border_top
+        && border_bottom == other.border_bottom
+        && padding_left == other.padding_left
+        && padding_right == other.padding_right
+        && padding_top == other.padding_top
+        && padding_bottom == other.padding_bottom;
+}
+
 }
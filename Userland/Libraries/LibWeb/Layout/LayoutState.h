@@ -8,6 +8,7 @@
 
 #include <AK/HashMap.h>
 #include <LibGfx/Point.h>
+#include <LibWeb/Layout/AvailableSpace.h>
 #include <LibWeb/Layout/Box.h>
 #include <LibWeb/Layout/LineBox.h>
 #include <LibWeb/Painting/PaintableBox.h>
@@ -21,9 +22,6 @@ enum class SizeConstraint {
     MaxContent,
 };
 
-class AvailableSize;
-class AvailableSpace;
-
 struct LayoutState {
     LayoutState()
         : m_root(*this)
@@ -138,6 +136,12 @@ struct LayoutState {
         void set_computed_svg_transforms(Painting::SVGGraphicsPaintable::ComputedTransforms const& computed_transforms) { m_computed_svg_transforms = computed_transforms; }
         auto const& computed_svg_transforms() const { return m_computed_svg_transforms; }
 
+        // Copies everything but the containing block's used values, which have to come from the same state.
+        void take_over_from(UsedValues const&);
+
+        // Whether the formatting context established by the node would produce the same results with these used values.
+        bool has_same_formatting_context_inputs_as(UsedValues const&) const;
+
     private:
         AvailableSize available_width_inside() const;
         AvailableSize available_height_inside() const;
@@ -190,6 +194,28 @@ struct LayoutState {
 
     HashMap<JS::GCPtr<NodeWithStyle const>, NonnullOwnPtr<IntrinsicSizes>> mutable intrinsic_sizes;
 
+    // The inputs and results of the last run of each independent formatting context in LayoutMode::Normal.
+    // These are only recorded by the top-level state, so they can be reused by the next layout pass.
+    struct FormattingContextResult {
+        AvailableSpace available_space;
+        UsedValues used_values_before_run;
+        UsedValues used_values_after_run;
+        CSSPixels automatic_content_width { 0 };
+        CSSPixels automatic_content_height { 0 };
+    };
+
+    HashMap<JS::NonnullGCPtr<Box const>, NonnullOwnPtr<FormattingContextResult>> formatting_context_results;
+
+    void record_formatting_context_result(Box const&, AvailableSpace const&, UsedValues const& used_values_before_run, FormattingContext const&);
+
+    // If nothing the layout of the box's insides depends on has changed since the previous layout pass, takes
+    // over the used values of the box and its descendants from that pass and returns what its formatting context
+    // produced. The box must already have been dimensioned by its parent formatting context.
+    FormattingContextResult const* reuse_formatting_context_result(Box const&, AvailableSpace const&);
+
+    // The committed state of the previous layout pass of the same layout tree, if its results may be reused.
+    LayoutState const* previous_pass { nullptr };
+
     LayoutState const* m_parent { nullptr };
     LayoutState const& m_root;
 
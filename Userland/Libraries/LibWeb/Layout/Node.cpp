@@ -980,6 +980,31 @@ void Node::set_paintable(JS::GCPtr<Painting::Paintable> paintable)
     m_paintable = move(paintable);
 }
 
+void Node::set_needs_layout()
+{
+    m_needs_layout = true;
+
+    // Anonymous and generated children take their style from this node, so they have to be laid out again as well.
+    for (auto* child = first_child(); child; child = child->next_sibling()) {
+        if ((child->is_anonymous() || child->is_generated()) && !child->m_needs_layout)
+            child->set_needs_layout();
+    }
+
+    for (auto* ancestor = parent(); ancestor && !ancestor->m_child_needs_layout; ancestor = ancestor->parent())
+        ancestor->m_child_needs_layout = true;
+
+    document().set_needs_incremental_layout();
+}
+
+void Node::reset_needs_layout()
+{
+    for_each_in_inclusive_subtree([](Node& node) {
+        node.m_needs_layout = false;
+        node.m_child_needs_layout = false;
+        return IterationDecision::Continue;
+    });
+}
+
 JS::GCPtr<Painting::Paintable> Node::create_paintable() const
 {
     return nullptr;
@@ -130,6 +130,16 @@ public:
     bool is_grid_item() const { return m_is_grid_item; }
     void set_grid_item(bool b) { m_is_grid_item = b; }
 
+    // Nodes that need layout, and the ancestors of such nodes, are laid out again by the next layout pass.
+    // Independent formatting contexts established by boxes without either bit take over their results from
+    // the previous layout pass instead, see FormattingContext::run_independent_formatting_context().
+    bool needs_layout() const { return m_needs_layout; }
+    bool child_needs_layout() const { return m_child_needs_layout; }
+    void set_needs_layout();
+
+    // Clears both bits on this node and all of its descendants, once they have been laid out.
+    void reset_needs_layout();
+
     Box const* containing_block() const;
     Box* containing_block() { return const_cast<Box*>(const_cast<Node const*>(this)->containing_block()); }
 
@@ -187,6 +197,9 @@ private:
     bool m_is_flex_item { false };
     bool m_is_grid_item { false };
 
+    bool m_needs_layout { true };
+    bool m_child_needs_layout { false };
+
     GeneratedFor m_generated_for { GeneratedFor::NotGenerated };
 
     u32 m_initial_quote_nesting_level { 0 };
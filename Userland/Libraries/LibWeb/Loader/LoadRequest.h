@@ -40,6 +40,10 @@ public:
     ByteBuffer const& body() const { return m_body; }
     void set_body(ByteBuffer body) { m_body = move(body); }
 
+    // Whether the request is sent with credentials, like the cookies in its headers.
+    bool includes_credentials() const { return m_includes_credentials; }
+    void set_includes_credentials(bool includes_credentials) { m_includes_credentials = includes_credentials; }
+
     void start_timer() { m_load_timer.start(); }
     Duration load_time() const { return m_load_timer.elapsed_time(); }
 
@@ -65,7 +69,7 @@ public:
             if (it.value != jt->value)
                 return false;
         }
-        return m_url == other.m_url && m_method == other.m_method && m_body == other.m_body;
+        return m_url == other.m_url && m_method == other.m_method && m_body == other.m_body && m_includes_credentials == other.m_includes_credentials;
     }
 
     void set_header(ByteString const& name, ByteString const& value) { m_headers.set(name, value); }
@@ -81,6 +85,7 @@ private:
     Core::ElapsedTimer m_load_timer;
     JS::Handle<Page> m_page;
     bool m_main_resource { false };
+    bool m_includes_credentials { true };
 };
 
 }
@@ -184,6 +184,90 @@ static HashMap<ByteString, ByteString, CaseInsensitiveStringTraits> response_hea
     return response_headers;
 }
 
+// How long a preloaded response is kept around for a load to ask for it.
+static constexpr int preload_expiry_ms = 30'000;
+
+void ResourceLoader::preload(LoadRequest& request)
+{
+    auto url = request.url();
+    if (!url.scheme().is_one_of("http"sv, "https"sv) || m_preloads.contains(url))
+        return;
+
+    dbgln_if(SPAM_DEBUG, "ResourceLoader: Preloading \"{}\"", sanitized_url_for_logging(url));
+
+    auto preload = adopt_ref(*new Preload);
+    preload->request = request;
+    load(
+        request,
+        [this, url, preload](ReadonlyBytes data, auto const& response_headers, auto status_code) {
+            auto data_copy = ByteBuffer::copy(data).release_value_but_fixme_should_propagate_errors();
+            preload->finish(Preload::Succeeded { move(data_copy), response_headers, status_code });
+            if (!preload->is_claimed)
+                expire_preload_later(url, preload);
+        },
+        [this, url, preload](ByteString const& error, auto status_code, ReadonlyBytes payload, auto const& response_headers) {
+            auto payload_copy = ByteBuffer::copy(payload).release_value_but_fixme_should_propagate_errors();
+            preload->finish(Preload::Failed { error, status_code, move(payload_copy), response_headers });
+            if (!preload->is_claimed)
+                expire_preload_later(url, preload);
+        });
+
+    // NOTE: Loads that fail right away have nothing worth keeping, and would otherwise claim their own preload.
+    if (!preload->result.has_value())
+        m_preloads.set(url, preload);
+}
+
+void ResourceLoader::expire_preload_later(URL::URL const& url, NonnullRefPtr<Preload> const& preload)
+{
+    preload->expiry_timer = Platform::Timer::create_single_shot(preload_expiry_ms, [this, url, weak_preload = preload.ptr()] {
+        auto it = m_preloads.find(url);
+        if (it != m_preloads.end() && it->value.ptr() == weak_preload) {
+            dbgln_if(SPAM_DEBUG, "ResourceLoader: Dropping unused preload of \"{}\"", sanitized_url_for_logging(url));
+            m_preloads.remove(it);
+        }
+    });
+    preload->expiry_timer->start();
+}
+
+void ResourceLoader::Preload::finish(Variant<Succeeded, Failed> load_result)
+{
+    result = move(load_result);
+    if (is_claimed)
+        deliver();
+}
+
+void ResourceLoader::Preload::claim(SuccessCallback on_success, ErrorCallback on_error)
+{
+    is_claimed = true;
+    success_callback = move(on_success);
+    error_callback = move(on_error);
+    if (expiry_timer)
+        expiry_timer->stop();
+
+    // Like any other load, this one shouldn't finish before the caller gets to return.
+    if (result.has_value()) {
+        Platform::EventLoopPlugin::the().deferred_invoke([preload = NonnullRefPtr { *this }] {
+            preload->deliver();
+        });
+    }
+}
+
+void ResourceLoader::Preload::deliver()
+{
+    result->visit(
+        [&](Succeeded const& succeeded) {
+            success_callback(succeeded.data, succeeded.response_headers, succeeded.status_code);
+        },
+        [&](Failed const& failed) {
+            if (error_callback)
+                error_callback(failed.error, failed.status_code, failed.payload, failed.response_headers);
+        });
+
+    // Break the cycle between this preload and the callbacks of the load that claimed it.
+    success_callback = nullptr;
+    error_callback = nullptr;
+}
+
 void ResourceLoader::load(LoadRequest& request, SuccessCallback success_callback, ErrorCallback error_callback, Optional<u32> timeout, TimeoutCallback timeout_callback)
 {
     auto& url = request.url();
@@ -382,6 +466,17 @@ void ResourceLoader::load(LoadRequest& request, SuccessCallback success_callback
     }
 
     if (url.scheme() == "http" || url.scheme() == "https" || url.scheme() == "gemini") {
+        // A preload is only handed over to a load that would have sent the very same request, since the server may
+        // respond differently to different headers, and credentials decide whose response it is.
+        if (auto it = m_preloads.find(url); it != m_preloads.end() && it->value->request == request) {
+            dbgln_if(SPAM_DEBUG, "ResourceLoader: Using preloaded response for \"{}\"", url_for_logging);
+            auto preload = move(it->value);
+            m_preloads.remove(it);
+            log_success(request);
+            preload->claim(move(success_callback), move(error_callback));
+            return;
+        }
+
         auto proxy = ProxyMappings::the().proxy_for_url(url);
 
         HashMap<ByteString, ByteString> headers;
@@ -478,6 +573,7 @@ void ResourceLoader::clear_cache()
 {
     dbgln_if(CACHE_DEBUG, "Clearing {} items from ResourceLoader cache", s_resource_cache.size());
     s_resource_cache.clear();
+    m_preloads.clear();
 }
 
 void ResourceLoader::evict_from_cache(LoadRequest const& request)
@@ -10,12 +10,14 @@
 #include <AK/ByteString.h>
 #include <AK/Function.h>
 #include <AK/HashMap.h>
+#include <AK/Variant.h>
 #include <LibCore/EventReceiver.h>
 #include <LibCore/Proxy.h>
 #include <LibJS/SafeFunction.h>
 #include <LibURL/URL.h>
 #include <LibWeb/Loader/Resource.h>
 #include <LibWeb/Page/Page.h>
+#include <LibWeb/Platform/Timer.h>
 
 namespace Web {
 
@@ -127,6 +129,12 @@ public:
     void prefetch_dns(URL::URL const&);
     void preconnect(URL::URL const&);
 
+    // https://html.spec.whatwg.org/multipage/parsing.html#speculative-fetch
+    // Starts loading a resource that is expected to be needed soon. The next load of the same request (down to its
+    // method, headers, body and credentials) is given this load's response rather than going to the network again.
+    // Responses that aren't asked for in time are dropped.
+    void preload(LoadRequest&);
+
     Function<void()> on_load_counter_change;
 
     int pending_loads() const { return m_pending_loads; }
@@ -146,9 +154,38 @@ private:
 
     static bool is_port_blocked(int port);
 
+    struct Preload;
+    void expire_preload_later(URL::URL const&, NonnullRefPtr<Preload> const&);
+
+    struct Preload : public RefCounted<Preload> {
+        struct Succeeded {
+            ByteBuffer data;
+            HashMap<ByteString, ByteString, CaseInsensitiveStringTraits> response_headers;
+            Optional<u32> status_code;
+        };
+        struct Failed {
+            ByteString error;
+            Optional<u32> status_code;
+            ByteBuffer payload;
+            HashMap<ByteString, ByteString, CaseInsensitiveStringTraits> response_headers;
+        };
+
+        void finish(Variant<Succeeded, Failed>);
+        void claim(SuccessCallback, ErrorCallback);
+        void deliver();
+
+        LoadRequest request;
+        Optional<Variant<Succeeded, Failed>> result;
+        bool is_claimed { false };
+        SuccessCallback success_callback;
+        ErrorCallback error_callback;
+        RefPtr<Platform::Timer> expiry_timer;
+    };
+
     int m_pending_loads { 0 };
 
     HashTable<NonnullRefPtr<ResourceLoaderConnectorRequest>> m_active_requests;
+    HashMap<URL::URL, NonnullRefPtr<Preload>> m_preloads;
     NonnullRefPtr<ResourceLoaderConnector> m_connector;
     String m_user_agent;
     String m_platform;
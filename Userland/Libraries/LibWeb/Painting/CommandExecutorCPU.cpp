@@ -4,17 +4,30 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
+#include <LibCore/System.h>
 #include <LibGfx/Filters/StackBlurFilter.h>
 #include <LibGfx/StylePainter.h>
+#include <LibThreading/Mutex.h>
+#include <LibThreading/WorkerThread.h>
 #include <LibWeb/CSS/ComputedValues.h>
 #include <LibWeb/Painting/BorderRadiusCornerClipper.h>
 #include <LibWeb/Painting/CommandExecutorCPU.h>
 #include <LibWeb/Painting/FilterPainting.h>
+#include <LibWeb/Painting/GlyphRasterCache.h>
 #include <LibWeb/Painting/RecordingPainter.h>
 #include <LibWeb/Painting/ShadowPainting.h>
 
 namespace Web::Painting {
 
+// Only executors painting tiles of a target on several threads have locks to take.
+struct CommandExecutorCPU::TileLocks {
+    Threading::Mutex fonts;
+    Threading::Mutex paint_styles;
+};
+
+static constexpr size_t maximum_tile_painting_thread_count = 8;
+
 CommandExecutorCPU::CommandExecutorCPU(Gfx::Bitmap& bitmap)
     : m_target_bitmap(bitmap)
 {
@@ -24,10 +37,126 @@ CommandExecutorCPU::CommandExecutorCPU(Gfx::Bitmap& bitmap)
         .scaling_mode = {} });
 }
 
+CommandExecutorCPU::CommandExecutorCPU(Gfx::Bitmap& tile_bitmap, Gfx::IntPoint tile_location, TileLocks& tile_locks)
+    : CommandExecutorCPU(tile_bitmap)
+{
+    m_tile_location = tile_location;
+    m_tile_locks = &tile_locks;
+    painter().translate(-tile_location);
+}
+
+void CommandExecutorCPU::execute_in_tiles(CommandList& command_list, Gfx::Bitmap& target, Gfx::IntRect const& rect)
+{
+    // Each tile goes through all of the commands (skipping the ones outside of it), so tiles shouldn't be too small.
+    static constexpr int tile_size = 512;
+
+    // NOTE: Painting part of the target works just like painting a tile, so if the commands can't be split into tiles,
+    //       the whole target has to be painted.
+    if (target.scale() != 1 || !command_list.can_be_executed_in_tiles()) {
+        CommandExecutorCPU executor { target };
+        command_list.execute(executor);
+        return;
+    }
+
+    auto rect_to_paint = rect.intersected(target.rect());
+    auto thread_count = min<size_t>(Core::System::hardware_concurrency(), maximum_tile_painting_thread_count);
+
+    Vector<Gfx::IntRect> tile_rects;
+    if (thread_count < 2) {
+        if (!rect_to_paint.is_empty())
+            tile_rects.append(rect_to_paint);
+    } else {
+        for (int y = rect_to_paint.top(); y < rect_to_paint.bottom(); y += tile_size) {
+            for (int x = rect_to_paint.left(); x < rect_to_paint.right(); x += tile_size)
+                tile_rects.append(Gfx::IntRect { x, y, tile_size, tile_size }.intersected(rect_to_paint));
+        }
+    }
+
+    // The tiles' bitmaps share their pixels with the target, so there's nothing to copy back once they're painted.
+    Vector<Tile> tiles;
+    tiles.ensure_capacity(tile_rects.size());
+    for (auto const& tile_rect : tile_rects) {
+        auto tile_bitmap = MUST(Gfx::Bitmap::create_wrapper(target.format(), tile_rect.size(), 1, target.pitch(), target.scanline(tile_rect.y()) + tile_rect.x()));
+        tiles.unchecked_append({ move(tile_bitmap), tile_rect.location() });
+    }
+
+    execute_in_tiles(command_list, tiles);
+}
+
+// The threads stay around from one frame to the next. Painting only ever happens on the main thread, so every target
+// can share them.
+static Vector<NonnullOwnPtr<Threading::WorkerThread<Error>>>& tile_painting_workers()
+{
+    static Vector<NonnullOwnPtr<Threading::WorkerThread<Error>>> workers;
+    return workers;
+}
+
+void CommandExecutorCPU::execute_in_tiles(CommandList& command_list, ReadonlySpan<Tile> tiles)
+{
+    VERIFY(command_list.can_be_executed_in_tiles());
+    auto thread_count = min<size_t>(Core::System::hardware_concurrency(), maximum_tile_painting_thread_count);
+
+    TileLocks tile_locks;
+    Atomic<size_t> next_tile { 0 };
+
+    auto paint_tiles = [&] {
+        for (;;) {
+            auto index = next_tile.fetch_add(1);
+            if (index >= tiles.size())
+                return;
+            auto const& tile = tiles[index];
+            CommandExecutorCPU executor { *tile.bitmap, tile.location, tile_locks };
+            command_list.execute(executor);
+        }
+    };
+
+    auto& workers = tile_painting_workers();
+    auto workers_needed = min(thread_count, tiles.size()) - 1;
+    while (workers.size() < workers_needed) {
+        auto worker = Threading::WorkerThread<Error>::create("TilePainting"sv);
+        // If we can't get another thread, the ones we have (including this one) will just paint more tiles.
+        if (worker.is_error())
+            break;
+        workers.append(worker.release_value());
+    }
+
+    auto worker_count = min(workers.size(), workers_needed);
+    for (size_t i = 0; i < worker_count; ++i) {
+        VERIFY(workers[i]->start_task([&]() -> ErrorOr<void> {
+            paint_tiles();
+            return {};
+        }));
+    }
+
+    paint_tiles();
+
+    for (size_t i = 0; i < worker_count; ++i)
+        MUST(workers[i]->wait_until_task_is_finished());
+}
+
 CommandResult CommandExecutorCPU::draw_glyph_run(Vector<Gfx::DrawGlyphOrEmoji> const& glyph_run, Color const& color, Gfx::FloatPoint translation, double scale)
 {
     auto& painter = this->painter();
+
+    // Glyphs with a cached coverage mask are blended into the target once the fonts are no longer needed, so tiles
+    // painted on other threads don't have to wait for that. The rest are drawn by the painter as they come up.
+    // NOTE: Painters with a scale have to draw every glyph themselves.
+    bool can_blend_glyphs = painter.scale() == 1;
+    Vector<GlyphRasterCache::RasterizedGlyph> glyphs_to_blend;
+    auto blend_glyphs = [&] {
+        for (auto const& glyph : glyphs_to_blend) {
+            if (glyph.mask)
+                glyph.mask->blend_into(*painter.target(), painter.clip_rect(), glyph.position.translated(painter.translation()), color);
+        }
+        glyphs_to_blend.clear_with_capacity();
+    };
+
     for (auto& glyph_or_emoji : glyph_run) {
+        // The fonts are only locked for one glyph at a time, so tiles painting text on other threads can take turns.
+        Optional<Threading::MutexLocker> fonts_locker;
+        if (m_tile_locks)
+            fonts_locker.emplace(m_tile_locks->fonts);
+
         auto transformed_glyph = glyph_or_emoji;
         transformed_glyph.visit([&](auto& glyph) {
             glyph.position = glyph.position.scaled(scale).translated(translation);
@@ -35,17 +164,31 @@ CommandResult CommandExecutorCPU::draw_glyph_run(Vector<Gfx::DrawGlyphOrEmoji> c
         });
         if (glyph_or_emoji.has<Gfx::DrawGlyph>()) {
             auto& glyph = transformed_glyph.get<Gfx::DrawGlyph>();
+            if (can_blend_glyphs) {
+                if (auto rasterized_glyph = GlyphRasterCache::the().rasterize_glyph(*glyph.font, glyph.code_point, glyph.position); rasterized_glyph.has_value()) {
+                    glyphs_to_blend.append(rasterized_glyph.release_value());
+                    continue;
+                }
+            }
+            blend_glyphs();
             painter.draw_glyph(glyph.position, glyph.code_point, *glyph.font, color);
         } else {
             auto& emoji = transformed_glyph.get<Gfx::DrawEmoji>();
+            blend_glyphs();
             painter.draw_emoji(emoji.position.to_type<int>(), *emoji.emoji, *emoji.font);
         }
     }
+
+    blend_glyphs();
     return CommandResult::Continue;
 }
 
 CommandResult CommandExecutorCPU::draw_text(Gfx::IntRect const& rect, String const& raw_text, Gfx::TextAlignment alignment, Color const& color, Gfx::TextElision elision, Gfx::TextWrapping wrapping, Optional<NonnullRefPtr<Gfx::Font>> const& font)
 {
+    Optional<Threading::MutexLocker> fonts_locker;
+    if (m_tile_locks)
+        fonts_locker.emplace(m_tile_locks->fonts);
+
     auto& painter = this->painter();
     if (font.has_value()) {
         painter.draw_text(rect, raw_text, *font, alignment, color, elision, wrapping);
@@ -129,8 +272,11 @@ CommandResult CommandExecutorCPU::push_stacking_context(
     CSS::ImageRendering image_rendering, StackingContextTransform transform, Optional<StackingContextMask> mask)
 {
     painter().save();
-    if (is_fixed_position)
-        painter().translate(-painter().translation());
+    if (is_fixed_position) {
+        // When painting a tile, the origin of the target is outside of the tile's bitmap.
+        auto origin = &painter() == stacking_contexts.first().painter.ptr() ? -m_tile_location : Gfx::IntPoint {};
+        painter().translate(origin - painter().translation());
+    }
 
     if (mask.has_value()) {
         // TODO: Support masks and other stacking context features at the same time.
@@ -277,13 +423,19 @@ CommandResult CommandExecutorCPU::paint_text_shadow(int blur_radius, Gfx::IntRec
     // FIXME: "Spread" the shadow somehow.
     Gfx::IntPoint const baseline_start(text_rect.x(), text_rect.y() + fragment_baseline);
     shadow_painter.translate(baseline_start);
-    for (auto const& glyph_or_emoji : glyph_run) {
-        if (glyph_or_emoji.has<Gfx::DrawGlyph>()) {
-            auto const& glyph = glyph_or_emoji.get<Gfx::DrawGlyph>();
-            shadow_painter.draw_glyph(glyph.position, glyph.code_point, *glyph.font, color);
-        } else {
-            auto const& emoji = glyph_or_emoji.get<Gfx::DrawEmoji>();
-            shadow_painter.draw_emoji(emoji.position.to_type<int>(), *emoji.emoji, *emoji.font);
+    {
+        Optional<Threading::MutexLocker> fonts_locker;
+        if (m_tile_locks)
+            fonts_locker.emplace(m_tile_locks->fonts);
+
+        for (auto const& glyph_or_emoji : glyph_run) {
+            if (glyph_or_emoji.has<Gfx::DrawGlyph>()) {
+                auto const& glyph = glyph_or_emoji.get<Gfx::DrawGlyph>();
+                shadow_painter.draw_glyph(glyph.position, glyph.code_point, *glyph.font, color);
+            } else {
+                auto const& emoji = glyph_or_emoji.get<Gfx::DrawEmoji>();
+                shadow_painter.draw_emoji(emoji.position.to_type<int>(), *emoji.emoji, *emoji.font);
+            }
         }
     }
 
@@ -325,6 +477,10 @@ CommandResult CommandExecutorCPU::fill_path_using_color(Gfx::Path const& path, C
 
 CommandResult CommandExecutorCPU::fill_path_using_paint_style(Gfx::Path const& path, Gfx::PaintStyle const& paint_style, Gfx::Painter::WindingRule winding_rule, float opacity, Gfx::FloatPoint const& aa_translation)
 {
+    Optional<Threading::MutexLocker> paint_styles_locker;
+    if (m_tile_locks)
+        paint_styles_locker.emplace(m_tile_locks->paint_styles);
+
     Gfx::AntiAliasingPainter aa_painter(painter());
     aa_painter.translate(aa_translation);
     aa_painter.fill_path(path, paint_style, opacity, winding_rule);
@@ -341,6 +497,10 @@ CommandResult CommandExecutorCPU::stroke_path_using_color(Gfx::Path const& path,
 
 CommandResult CommandExecutorCPU::stroke_path_using_paint_style(Gfx::Path const& path, Gfx::PaintStyle const& paint_style, float thickness, float opacity, Gfx::FloatPoint const& aa_translation)
 {
+    Optional<Threading::MutexLocker> paint_styles_locker;
+    if (m_tile_locks)
+        paint_styles_locker.emplace(m_tile_locks->paint_styles);
+
     Gfx::AntiAliasingPainter aa_painter(painter());
     aa_painter.translate(aa_translation);
     aa_painter.stroke_path(path, paint_style, thickness, opacity);
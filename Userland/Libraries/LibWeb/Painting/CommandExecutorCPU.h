@@ -54,8 +54,30 @@ public:
 
     CommandExecutorCPU(Gfx::Bitmap& bitmap);
 
+    // Splits the given rect of the target into tiles and executes the commands for each of them on a pool of threads,
+    // leaving the rest of the target as it was. Falls back to executing them once for the whole target if the commands
+    // can't be split up.
+    static void execute_in_tiles(CommandList&, Gfx::Bitmap& target, Gfx::IntRect const& rect);
+
+    struct Tile {
+        NonnullRefPtr<Gfx::Bitmap> bitmap;
+        // Where the top left corner of the tile is, in the coordinates the commands were recorded in.
+        Gfx::IntPoint location;
+    };
+
+    // Executes the commands for each of the tiles on a pool of threads. The commands must be able to be executed in tiles.
+    static void execute_in_tiles(CommandList&, ReadonlySpan<Tile>);
+
 private:
+    // Fonts (with their glyph caches) and paint styles are reference counted and cached without any synchronization,
+    // so the executors painting tiles of the same target have to take turns using each of them.
+    struct TileLocks;
+
+    CommandExecutorCPU(Gfx::Bitmap& tile_bitmap, Gfx::IntPoint tile_location, TileLocks&);
+
     Gfx::Bitmap& m_target_bitmap;
+    Gfx::IntPoint m_tile_location;
+    TileLocks* m_tile_locks { nullptr };
     Vector<RefPtr<BorderRadiusCornerClipper>> m_corner_clippers;
 
     struct StackingContext {
@@ -13,6 +13,29 @@ void CommandList::append(Command&& command, Optional<i32> scroll_frame_id)
     m_commands.append({ scroll_frame_id, move(command) });
 }
 
+CommandList CommandList::copy_commands_from(size_t index) const
+{
+    CommandList copy;
+    for (size_t command_index = index; command_index < m_commands.size(); ++command_index) {
+        auto const& command_with_scroll_id = m_commands[command_index];
+        copy.append(Command { command_with_scroll_id.command }, command_with_scroll_id.scroll_frame_id);
+    }
+    return copy;
+}
+
+void CommandList::append_commands_of(CommandList const& other, u32 corner_clipper_id_offset)
+{
+    for (size_t command_index = 0; command_index < other.m_commands.size(); ++command_index) {
+        auto const& command_with_scroll_id = other.m_commands[command_index];
+        Command command = command_with_scroll_id.command;
+        if (command.has<SampleUnderCorners>())
+            command.get<SampleUnderCorners>().id += corner_clipper_id_offset;
+        else if (command.has<BlitCornerClipping>())
+            command.get<BlitCornerClipping>().id += corner_clipper_id_offset;
+        append(move(command), command_with_scroll_id.scroll_frame_id);
+    }
+}
+
 static Optional<Gfx::IntRect> command_bounding_rectangle(Command const& command)
 {
     return command.visit(
@@ -76,6 +99,26 @@ void CommandList::mark_unnecessary_commands()
     VERIFY(sample_blit_ranges.is_empty());
 }
 
+bool CommandList::can_be_executed_in_tiles() const
+{
+    for (size_t command_index = 0; command_index < m_commands.size(); ++command_index) {
+        auto const& command = m_commands[command_index].command;
+        // Backdrop filters sample the pixels around each pixel they produce.
+        if (command.has<ApplyBackdropFilter>())
+            return false;
+        // Scaled or rotated stacking contexts are resampled when they're drawn into their parent.
+        if (command.has<PushStackingContext>()) {
+            auto const& push_stacking_context = command.get<PushStackingContext>();
+            if (!Gfx::extract_2d_affine_transform(push_stacking_context.transform.matrix).is_identity_or_translation())
+                return false;
+            // The mask bitmap is copied (and so referenced) along with the other arguments of the command.
+            if (push_stacking_context.mask.has_value())
+                return false;
+        }
+    }
+    return true;
+}
+
 void CommandList::execute(CommandExecutor& executor)
 {
     executor.prepare_to_execute();
@@ -95,10 +95,21 @@ class CommandList {
 public:
     void append(Command&& command, Optional<i32> scroll_frame_id);
 
+    size_t size() const { return m_commands.size(); }
+
+    // Copies the commands from the given index on into a new list, so they can be appended to a later list again.
+    CommandList copy_commands_from(size_t index) const;
+    // Appends the commands of another list, shifting the IDs of their corner clippers by the given offset.
+    void append_commands_of(CommandList const&, u32 corner_clipper_id_offset);
+
     void apply_scroll_offsets(Vector<Gfx::IntPoint> const& offsets_by_frame_id);
     void mark_unnecessary_commands();
     void execute(CommandExecutor&);
 
+    // Whether executing the commands separately for each tile of the target, on several threads at once, produces the
+    // same result as executing them once for the whole target.
+    bool can_be_executed_in_tiles() const;
+
 private:
     struct CommandListItem {
         Optional<i32> scroll_frame_id;
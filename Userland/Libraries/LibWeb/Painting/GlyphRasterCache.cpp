@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/SIMD.h>
+#include <AK/TypeCasts.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/Font/ScaledFont.h>
+#include <LibWeb/Painting/GlyphRasterCache.h>
+
+namespace Web::Painting {
+
+ErrorOr<NonnullRefPtr<GlyphCoverageMask>> GlyphCoverageMask::create_from_glyph_bitmap(Gfx::Bitmap const& bitmap)
+{
+    auto coverage = TRY(FixedArray<u8>::create(bitmap.width() * bitmap.height()));
+    size_t index = 0;
+    for (int y = 0; y < bitmap.height(); ++y) {
+        for (int x = 0; x < bitmap.width(); ++x)
+            coverage[index++] = bitmap.get_pixel(x, y).alpha();
+    }
+    return adopt_nonnull_ref_or_enomem(new (nothrow) GlyphCoverageMask(bitmap.size(), move(coverage)));
+}
+
+// Exact for every product of two 8-bit values, and cheaper than dividing.
+static ALWAYS_INLINE u16 divide_by_255(u16 value)
+{
+    value += 128;
+    return (value + (value >> 8)) >> 8;
+}
+
+static ALWAYS_INLINE AK::SIMD::u16x16 divide_by_255(AK::SIMD::u16x16 value)
+{
+    value += 128;
+    return (value + (value >> 8)) >> 8;
+}
+
+static ALWAYS_INLINE void blend_pixel(Gfx::ARGB32& pixel, u8 coverage, Color color, bool target_is_opaque)
+{
+    if (coverage == 0)
+        return;
+    auto source = color.with_alpha(divide_by_255(coverage * color.alpha()));
+    if (source.alpha() == 255) {
+        pixel = source.value();
+        return;
+    }
+    auto destination = target_is_opaque ? Color::from_rgb(pixel) : Color::from_argb(pixel);
+    pixel = destination.blend(source).value();
+}
+
+void GlyphCoverageMask::blend_into(Gfx::Bitmap& target, Gfx::IntRect const& clip_rect, Gfx::IntPoint position, Color color) const
+{
+    using AK::SIMD::u16x16;
+    using AK::SIMD::u8x16;
+
+    auto rect = Gfx::IntRect { position, m_size }.intersected(clip_rect).intersected(target.rect());
+    if (rect.is_empty() || color.alpha() == 0)
+        return;
+
+    bool target_is_opaque;
+    switch (target.format()) {
+    case Gfx::BitmapFormat::BGRx8888:
+        target_is_opaque = true;
+        break;
+    case Gfx::BitmapFormat::BGRA8888:
+        target_is_opaque = false;
+        break;
+    case Gfx::BitmapFormat::RGBA8888:
+        // Same as BGRA8888 with red and blue swapped, so swapping them in the color is all it takes.
+        target_is_opaque = false;
+        color = Color(color.blue(), color.green(), color.red(), color.alpha());
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+
+    // Pixels are blended four at a time, as 16 bytes in B, G, R, A order (for BGRA8888 and BGRx8888 alike). Only pixels
+    // that end up opaque can be blended this way, which is all of them when drawing on an opaque background, as text
+    // almost always is.
+    u16x16 source_channels {};
+    for (size_t i = 0; i < 16; i += 4) {
+        source_channels[i + 0] = color.blue();
+        source_channels[i + 1] = color.green();
+        source_channels[i + 2] = color.red();
+        source_channels[i + 3] = 255;
+    }
+    constexpr u16x16 all_255 = { 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255 };
+
+    auto blend_four_pixels = [&](Gfx::ARGB32* pixels, u8 const* coverage) {
+        u8x16 destination;
+        __builtin_memcpy(&destination, pixels, sizeof(destination));
+        if (!target_is_opaque && (destination[3] & destination[7] & destination[11] & destination[15]) != 255) {
+            for (size_t i = 0; i < 4; ++i)
+                blend_pixel(pixels[i], coverage[i], color, target_is_opaque);
+            return;
+        }
+
+        u16x16 alpha;
+        for (size_t i = 0; i < 4; ++i) {
+            u16 pixel_alpha = divide_by_255(coverage[i] * color.alpha());
+            alpha[i * 4 + 0] = pixel_alpha;
+            alpha[i * 4 + 1] = pixel_alpha;
+            alpha[i * 4 + 2] = pixel_alpha;
+            alpha[i * 4 + 3] = pixel_alpha;
+        }
+
+        auto blended = divide_by_255(source_channels * alpha + __builtin_convertvector(destination, u16x16) * (all_255 - alpha));
+        auto result = __builtin_convertvector(blended, u8x16);
+        __builtin_memcpy(pixels, &result, sizeof(result));
+    };
+
+    for (int y = rect.top(); y < rect.bottom(); ++y) {
+        auto const* coverage = m_coverage.data() + (y - position.y()) * m_size.width() + (rect.left() - position.x());
+        auto* pixels = target.scanline(y) + rect.left();
+
+        int x = 0;
+        for (; x + 4 <= rect.width(); x += 4) {
+            u32 four_coverages;
+            __builtin_memcpy(&four_coverages, coverage + x, sizeof(four_coverages));
+            if (four_coverages == 0)
+                continue;
+            blend_four_pixels(pixels + x, coverage + x);
+        }
+        for (; x < rect.width(); ++x)
+            blend_pixel(pixels[x], coverage[x], color, target_is_opaque);
+    }
+}
+
+GlyphRasterCache& GlyphRasterCache::the()
+{
+    static GlyphRasterCache cache;
+    return cache;
+}
+
+static size_t index_of_subpixel_offset(Gfx::GlyphSubpixelOffset offset)
+{
+    return offset.y * Gfx::GlyphSubpixelOffset::subpixel_divisions() + offset.x;
+}
+
+GlyphRasterCache::Entry& GlyphRasterCache::ensure_entry(Gfx::Font const& font, u32 code_point)
+{
+    Key key { &font, code_point };
+    if (auto it = m_entries.find(key); it != m_entries.end()) {
+        m_entries_by_last_use.prepend(*it->value);
+        return *it->value;
+    }
+
+    auto entry = make<Entry>(font, code_point);
+    entry->left_bearing = font.glyph_left_bearing(code_point);
+    if (auto const* scaled_font = dynamic_cast<Gfx::ScaledFont const*>(&font); scaled_font && !scaled_font->has_color_bitmaps()) {
+        entry->glyph_id = scaled_font->glyph_id_for_code_point(code_point);
+        entry->can_be_drawn_with_mask = true;
+    }
+
+    auto& entry_reference = *entry;
+    m_size_in_bytes += entry->size_in_bytes;
+    m_entries_by_last_use.prepend(entry_reference);
+    m_entries.set(key, move(entry));
+    return entry_reference;
+}
+
+void GlyphRasterCache::evict_entries_over_budget(Entry const& entry_to_keep)
+{
+    while (m_size_in_bytes > budget_in_bytes) {
+        auto* entry = m_entries_by_last_use.last();
+        if (!entry || entry == &entry_to_keep)
+            return;
+        m_entries_by_last_use.remove(*entry);
+        m_size_in_bytes -= entry->size_in_bytes;
+        m_entries.remove(Key { entry->font.ptr(), entry->code_point });
+    }
+}
+
+Optional<GlyphRasterCache::RasterizedGlyph> GlyphRasterCache::rasterize_glyph(Gfx::Font const& font, u32 code_point, Gfx::FloatPoint position)
+{
+    Threading::MutexLocker locker { m_mutex };
+
+    auto& entry = ensure_entry(font, code_point);
+    if (!entry.can_be_drawn_with_mask)
+        return {};
+
+    auto top_left = position + Gfx::FloatPoint(entry.left_bearing, 0);
+    auto raster_position = Gfx::GlyphRasterPosition::get_nearest_fit_for(top_left);
+
+    auto& mask = entry.masks[index_of_subpixel_offset(raster_position.subpixel_offset)];
+    if (!mask.has_value()) {
+        auto const& scaled_font = static_cast<Gfx::ScaledFont const&>(*entry.font);
+        RefPtr<GlyphCoverageMask const> new_mask;
+        if (auto bitmap = scaled_font.rasterize_glyph_without_caching(entry.glyph_id, raster_position.subpixel_offset)) {
+            auto mask_or_error = GlyphCoverageMask::create_from_glyph_bitmap(*bitmap);
+            if (mask_or_error.is_error())
+                return {};
+            new_mask = mask_or_error.release_value();
+        }
+
+        if (new_mask) {
+            entry.size_in_bytes += new_mask->size_in_bytes();
+            m_size_in_bytes += new_mask->size_in_bytes();
+        }
+        mask = move(new_mask);
+        evict_entries_over_budget(entry);
+    }
+
+    return RasterizedGlyph { *mask, raster_position.blit_position };
+}
+
+}
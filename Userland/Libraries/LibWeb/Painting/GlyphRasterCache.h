@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/AtomicRefCounted.h>
+#include <AK/FixedArray.h>
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <LibGfx/Color.h>
+#include <LibGfx/Font/Font.h>
+#include <LibGfx/Forward.h>
+#include <LibGfx/Rect.h>
+#include <LibThreading/Mutex.h>
+
+namespace Web::Painting {
+
+// How much of each pixel a rasterized glyph covers, which is all that's needed to draw it in any color.
+class GlyphCoverageMask : public AtomicRefCounted<GlyphCoverageMask> {
+public:
+    static ErrorOr<NonnullRefPtr<GlyphCoverageMask>> create_from_glyph_bitmap(Gfx::Bitmap const&);
+
+    Gfx::IntSize size() const { return m_size; }
+    size_t size_in_bytes() const { return m_coverage.size(); }
+
+    // Blends the color into the target wherever the glyph covers it, with the mask's top left corner at the position.
+    void blend_into(Gfx::Bitmap& target, Gfx::IntRect const& clip_rect, Gfx::IntPoint position, Color) const;
+
+private:
+    GlyphCoverageMask(Gfx::IntSize size, FixedArray<u8> coverage)
+        : m_size(size)
+        , m_coverage(move(coverage))
+    {
+    }
+
+    Gfx::IntSize m_size;
+    FixedArray<u8> m_coverage;
+};
+
+// Keeps the coverage masks of recently drawn glyphs of vector fonts, for each subpixel offset they were drawn at, so
+// text doesn't have to be rasterized again every time it's painted. The cache is shared by everything that paints on
+// the CPU, and makes room by dropping the least recently used glyphs once their masks take up more than its budget.
+//
+// Glyphs that can't be drawn with a coverage mask (those of bitmap fonts and of fonts with color glyphs) are left to
+// Gfx::Painter.
+class GlyphRasterCache {
+    AK_MAKE_NONCOPYABLE(GlyphRasterCache);
+    AK_MAKE_NONMOVABLE(GlyphRasterCache);
+
+public:
+    static GlyphRasterCache& the();
+
+    struct RasterizedGlyph {
+        // Null for glyphs that don't cover any pixels, like spaces.
+        RefPtr<GlyphCoverageMask const> mask;
+        Gfx::IntPoint position;
+    };
+
+    // Returns the mask for drawing the glyph at the position, placed the same way Gfx::Painter::draw_glyph() would place
+    // it, or nothing if the glyph has to be drawn by a painter.
+    // NOTE: This uses the font, which needs the same protection from other threads here as anywhere else.
+    Optional<RasterizedGlyph> rasterize_glyph(Gfx::Font const&, u32 code_point, Gfx::FloatPoint position);
+
+private:
+    GlyphRasterCache() = default;
+
+    static constexpr size_t budget_in_bytes = 8 * MiB;
+    static constexpr size_t subpixel_offset_count = Gfx::GlyphSubpixelOffset::subpixel_divisions() * Gfx::GlyphSubpixelOffset::subpixel_divisions();
+
+    struct Key {
+        Gfx::Font const* font { nullptr };
+        u32 code_point { 0 };
+
+        bool operator==(Key const&) const = default;
+    };
+
+    struct KeyTraits : public DefaultTraits<Key> {
+        static unsigned hash(Key const& key) { return pair_int_hash(ptr_hash(key.font), key.code_point); }
+    };
+
+    struct Entry {
+        // Keeps the font, and with it the key's address, from going away while the glyph is cached.
+        NonnullRefPtr<Gfx::Font const> font;
+        u32 code_point { 0 };
+        u32 glyph_id { 0 };
+        float left_bearing { 0 };
+        bool can_be_drawn_with_mask { false };
+        size_t size_in_bytes { sizeof(Entry) };
+
+        // Indexed by subpixel offset; an empty Optional means the glyph hasn't been rasterized at that offset yet.
+        Array<Optional<RefPtr<GlyphCoverageMask const>>, subpixel_offset_count> masks;
+
+        IntrusiveListNode<Entry> list_node;
+    };
+
+    Entry& ensure_entry(Gfx::Font const&, u32 code_point);
+    void evict_entries_over_budget(Entry const& entry_to_keep);
+
+    Threading::Mutex m_mutex;
+    HashMap<Key, NonnullOwnPtr<Entry>, KeyTraits> m_entries;
+
+    // Most recently used first.
+    IntrusiveList<&Entry::list_node> m_entries_by_last_use;
+
+    size_t m_size_in_bytes { 0 };
+};
+
+}
@@ -83,6 +83,13 @@ public:
     double device_pixels_per_css_pixel() const { return m_device_pixels_per_css_pixel; }
 
     u32 allocate_corner_clipper_id() { return m_next_corner_clipper_id++; }
+    u32 next_corner_clipper_id() const { return m_next_corner_clipper_id; }
+    u32 allocate_corner_clipper_ids(u32 count)
+    {
+        auto first_id = m_next_corner_clipper_id;
+        m_next_corner_clipper_id += count;
+        return first_id;
+    }
 
     u64 paint_generation_id() const { return m_paint_generation_id; }
 
@@ -136,20 +136,57 @@ void Paintable::set_needs_display() const
     if (!navigable)
         return;
 
+    invalidate_retained_commands_of_enclosing_stacking_context();
+
+    if (!is_displayed_at_its_absolute_rect() || !computed_values().text_shadow().is_empty()) {
+        navigable->set_needs_display_everywhere();
+        return;
+    }
+
+    // NOTE: The text cursor is painted right after the last glyph, which is just outside of the fragment at the end of a line.
+    auto damaged_rect_of_fragment = [](PaintableFragment const& fragment) {
+        return fragment.absolute_rect().inflated(0, 1, 0, 1);
+    };
+
     if (is<Painting::InlinePaintable>(*this)) {
         auto const& fragments = static_cast<Painting::InlinePaintable const*>(this)->fragments();
         for (auto const& fragment : fragments)
-            navigable->set_needs_display(fragment.absolute_rect());
+            navigable->set_needs_display(damaged_rect_of_fragment(fragment));
     }
 
     if (!is<Painting::PaintableWithLines>(*containing_block))
         return;
     static_cast<Painting::PaintableWithLines const&>(*containing_block).for_each_fragment([&](auto& fragment) {
-        navigable->set_needs_display(fragment.absolute_rect());
+        navigable->set_needs_display(damaged_rect_of_fragment(fragment));
         return IterationDecision::Continue;
     });
 }
 
+void Paintable::invalidate_retained_commands_of_enclosing_stacking_context() const
+{
+    // NOTE: The stacking context tree may not have been built (again) yet, in which case there's nothing to invalidate.
+    for (auto const* paintable = this; paintable; paintable = paintable->parent()) {
+        if (auto const* stacking_context = paintable->stacking_context()) {
+            const_cast<StackingContext*>(stacking_context)->invalidate_retained_commands();
+            return;
+        }
+    }
+}
+
+bool Paintable::is_displayed_at_its_absolute_rect() const
+{
+    for (auto const* paintable = this; paintable; paintable = paintable->parent()) {
+        if (paintable->is_fixed_position() || paintable->computed_values().position() == CSS::Positioning::Sticky)
+            return false;
+        if (!paintable->computed_values().transformations().is_empty())
+            return false;
+        // A scrolled box doesn't move itself, but everything inside of it does.
+        if (paintable != this && paintable->is_paintable_box() && static_cast<PaintableBox const&>(*paintable).scroll_offset() != CSSPixelPoint {})
+            return false;
+    }
+    return true;
+}
+
 CSSPixelPoint Paintable::box_type_agnostic_position() const
 {
     if (is_paintable_box())
@@ -180,6 +180,11 @@ public:
     JS::GCPtr<HTML::Navigable> navigable() const;
 
     virtual void set_needs_display() const;
+    void invalidate_retained_commands_of_enclosing_stacking_context() const;
+
+    // Whether the paintable shows up in the viewport where its absolute rects say it is, which isn't the case if it
+    // (or any of its ancestors) is transformed, fixed, sticky or scrolled.
+    bool is_displayed_at_its_absolute_rect() const;
 
     PaintableBox* containing_block() const
     {
@@ -91,6 +91,8 @@ void PaintableBox::set_scroll_offset(CSSPixelPoint offset)
         return;
     }
 
+    set_needs_display();
+
     // https://drafts.csswg.org/cssom-view-1/#scrolling-events
     // Whenever an element gets scrolled (whether in response to user interaction or by an API),
     // the user agent must run these steps:
@@ -110,8 +112,6 @@ void PaintableBox::set_scroll_offset(CSSPixelPoint offset)
 
     // 4. Append the element to doc’s pending scroll event targets.
     document.pending_scroll_event_targets().append(*layout_box().dom_node());
-
-    set_needs_display();
 }
 
 void PaintableBox::scroll_by(int delta_x, int delta_y)
@@ -409,7 +409,10 @@ void PaintableBox::paint_background(PaintContext& context) const
 
     if (layout_box().is_root_element()) {
         // CSS 2.1 Appendix E.2: If the element is a root element, paint the background over the entire canvas.
+        // NOTE: The canvas doesn't depend on where the viewport is scrolled to, so this can be painted once for all of it.
         background_rect = context.css_viewport_rect();
+        if (auto const* viewport_paintable = document().paintable())
+            background_rect = background_rect.united(viewport_paintable->canvas_rect());
 
         // Section 2.11.2: If the computed value of background-image on the root element is none and its background-color is transparent,
         // user agents must instead propagate the computed values of the background properties from that element’s first HTML BODY child element.
@@ -859,8 +862,24 @@ TraversalDecision PaintableWithLines::hit_test(CSSPixelPoint position, HitTestTy
 
 void PaintableBox::set_needs_display() const
 {
-    if (auto navigable = this->navigable())
-        navigable->set_needs_display(absolute_rect());
+    auto navigable = this->navigable();
+    if (!navigable)
+        return;
+
+    invalidate_retained_commands_of_enclosing_stacking_context();
+
+    // NOTE: Shadows aren't part of the paint rect until the paint-only properties have been resolved again, and outlines
+    //       never are.
+    auto const& computed_values = this->computed_values();
+    if (!is_displayed_at_its_absolute_rect()
+        || !computed_values.box_shadow().is_empty()
+        || !computed_values.text_shadow().is_empty()
+        || computed_values.outline_style() != CSS::OutlineStyle::None) {
+        navigable->set_needs_display_everywhere();
+        return;
+    }
+
+    navigable->set_needs_display(absolute_paint_rect());
 }
 
 }
@@ -61,6 +61,19 @@ void StackingContext::set_last_paint_generation_id(u64 generation_id)
     m_last_paint_generation_id = generation_id;
 }
 
+void StackingContext::invalidate_retained_commands()
+{
+    for (auto* stacking_context = this; stacking_context; stacking_context = stacking_context->m_parent)
+        stacking_context->m_retained_commands = nullptr;
+}
+
+void StackingContext::invalidate_retained_commands_in_subtree()
+{
+    m_retained_commands = nullptr;
+    for (auto* child : m_children)
+        child->invalidate_retained_commands_in_subtree();
+}
+
 static PaintPhase to_paint_phase(StackingContext::StackingContextPaintPhase phase)
 {
     // There are not a fully correct mapping since some stacking context phases are combined.
@@ -248,6 +261,45 @@ void StackingContext::paint_internal(PaintContext& context) const
     }
 }
 
+void StackingContext::paint_contents_or_append_retained_commands(PaintContext& context) const
+{
+    // NOTE: Pushing the stacking context gives the recording painter a fresh state, so the commands recorded for the
+    //       contents only depend on the paintables in here and on how the context is set up.
+    auto& commands_list = context.recording_painter().commands_list();
+
+    // SVG masks and clip paths are painted with an extra transform and in a different way, so they're always painted from scratch.
+    if (context.draw_svg_geometry_for_clip_path() || !context.svg_transform().is_identity()) {
+        paint_internal(context);
+        return;
+    }
+
+    if (m_retained_commands
+        && m_retained_commands->device_pixels_per_css_pixel == context.device_pixels_per_css_pixel()
+        && m_retained_commands->should_show_line_box_borders == context.should_show_line_box_borders()
+        && m_retained_commands->should_paint_overlay == context.should_paint_overlay()
+        && m_retained_commands->has_focus == context.has_focus()) {
+        // The corner clippers need IDs that aren't used by anything else painted in this context.
+        auto first_corner_clipper_id = context.allocate_corner_clipper_ids(m_retained_commands->corner_clipper_id_count);
+        commands_list.append_commands_of(m_retained_commands->commands, first_corner_clipper_id - m_retained_commands->first_corner_clipper_id);
+        return;
+    }
+
+    auto first_command_index = commands_list.size();
+    auto first_corner_clipper_id = context.next_corner_clipper_id();
+
+    paint_internal(context);
+
+    m_retained_commands = make<RetainedCommands>(RetainedCommands {
+        .commands = commands_list.copy_commands_from(first_command_index),
+        .first_corner_clipper_id = first_corner_clipper_id,
+        .corner_clipper_id_count = context.next_corner_clipper_id() - first_corner_clipper_id,
+        .device_pixels_per_css_pixel = context.device_pixels_per_css_pixel(),
+        .should_show_line_box_borders = context.should_show_line_box_borders(),
+        .should_paint_overlay = context.should_paint_overlay(),
+        .has_focus = context.has_focus(),
+    });
+}
+
 // FIXME: This extracts the affine 2D part of the full transformation matrix.
 //  Use the whole matrix when we get better transformation support in LibGfx or use LibGL for drawing the bitmap
 Gfx::AffineTransform StackingContext::affine_transform_matrix() const
@@ -322,7 +374,7 @@ void StackingContext::paint(PaintContext& context) const
     if (paintable().is_paintable_box() && paintable_box().scroll_frame_id().has_value())
         context.recording_painter().set_scroll_frame_id(*paintable_box().scroll_frame_id());
     context.recording_painter().push_stacking_context(push_stacking_context_params);
-    paint_internal(context);
+    paint_contents_or_append_retained_commands(context);
     context.recording_painter().pop_stacking_context();
     context.recording_painter().restore();
 }
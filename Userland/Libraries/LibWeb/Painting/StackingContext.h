@@ -8,6 +8,7 @@
 
 #include <AK/Vector.h>
 #include <LibGfx/Matrix4x4.h>
+#include <LibWeb/Painting/CommandList.h>
 #include <LibWeb/Painting/InlinePaintable.h>
 #include <LibWeb/Painting/Paintable.h>
 
@@ -48,6 +49,11 @@ public:
 
     void set_last_paint_generation_id(u64 generation_id);
 
+    // Drops the commands retained for this stacking context and the ones containing it, so they get recorded again
+    // the next time they're painted.
+    void invalidate_retained_commands();
+    void invalidate_retained_commands_in_subtree();
+
 private:
     JS::NonnullGCPtr<Paintable> m_paintable;
     StackingContext* const m_parent { nullptr };
@@ -58,8 +64,23 @@ private:
     Vector<JS::NonnullGCPtr<Paintable const>> m_positioned_descendants_with_stack_level_0_and_stacking_contexts;
     Vector<JS::NonnullGCPtr<Paintable const>> m_non_positioned_floating_descendants;
 
+    // The commands recorded for the contents of this stacking context (including the stacking contexts nested in it)
+    // the last time it was painted. They're appended again instead of painting the contents, until something in here
+    // needs to be displayed again.
+    struct RetainedCommands {
+        CommandList commands;
+        u32 first_corner_clipper_id { 0 };
+        u32 corner_clipper_id_count { 0 };
+        double device_pixels_per_css_pixel { 0 };
+        bool should_show_line_box_borders { false };
+        bool should_paint_overlay { false };
+        bool has_focus { false };
+    };
+    mutable OwnPtr<RetainedCommands> m_retained_commands;
+
     static void paint_child(PaintContext&, StackingContext const&);
     void paint_internal(PaintContext&) const;
+    void paint_contents_or_append_retained_commands(PaintContext&) const;
 };
 
 }
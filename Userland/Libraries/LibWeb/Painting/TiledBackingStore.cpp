@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/QuickSort.h>
+#include <LibWeb/Painting/CommandExecutorCPU.h>
+#include <LibWeb/Painting/TiledBackingStore.h>
+
+namespace Web::Painting {
+
+static int tile_index_of(int coordinate)
+{
+    // NOTE: The document can extend to negative coordinates, so this has to round down rather than towards zero.
+    if (coordinate >= 0)
+        return coordinate / TiledBackingStore::tile_size;
+    return -((-coordinate + TiledBackingStore::tile_size - 1) / TiledBackingStore::tile_size);
+}
+
+template<typename Callback>
+void TiledBackingStore::for_each_tile_index_in(Gfx::IntRect const& rect, Callback callback)
+{
+    if (rect.is_empty())
+        return;
+    auto first_column = tile_index_of(rect.left());
+    auto last_column = tile_index_of(rect.right() - 1);
+    auto first_row = tile_index_of(rect.top());
+    auto last_row = tile_index_of(rect.bottom() - 1);
+    for (auto row = first_row; row <= last_row; ++row) {
+        for (auto column = first_column; column <= last_column; ++column)
+            callback(Gfx::IntPoint { column, row });
+    }
+}
+
+void TiledBackingStore::invalidate(Gfx::IntRect const& rect)
+{
+    for_each_tile_index_in(rect, [&](auto index) {
+        m_tiles.remove(index);
+    });
+}
+
+bool TiledBackingStore::paint_missing_tiles(CommandList& commands, Gfx::IntPoint viewport_location, Gfx::IntRect const& rect, Gfx::BitmapFormat format, size_t maximum_tile_count)
+{
+    Vector<Gfx::IntPoint> missing_tile_indices;
+    for_each_tile_index_in(rect, [&](auto index) {
+        if (!m_tiles.contains(index))
+            missing_tile_indices.append(index);
+    });
+
+    if (missing_tile_indices.size() > maximum_tile_count) {
+        auto center = rect.center();
+        auto distance_to_center = [&](Gfx::IntPoint index) {
+            return rect_of_tile(index).center().distance_from(center);
+        };
+        quick_sort(missing_tile_indices, [&](auto a, auto b) {
+            return distance_to_center(a) < distance_to_center(b);
+        });
+    }
+
+    auto tile_count = min(missing_tile_indices.size(), maximum_tile_count);
+
+    Vector<CommandExecutorCPU::Tile> tiles;
+    tiles.ensure_capacity(tile_count);
+    for (size_t i = 0; i < tile_count; ++i) {
+        auto bitmap_or_error = Gfx::Bitmap::create(format, { tile_size, tile_size });
+        if (bitmap_or_error.is_error()) {
+            dbgln("Unable to allocate a tile for the backing store: {}", bitmap_or_error.error());
+            return true;
+        }
+        // NOTE: The commands were recorded relative to the viewport, so that's where the tile has to be placed.
+        tiles.unchecked_append({ bitmap_or_error.release_value(), rect_of_tile(missing_tile_indices[i]).location() - viewport_location });
+    }
+
+    CommandExecutorCPU::execute_in_tiles(commands, tiles);
+
+    for (size_t i = 0; i < tile_count; ++i)
+        m_tiles.set(missing_tile_indices[i], tiles[i].bitmap);
+
+    return tile_count < missing_tile_indices.size();
+}
+
+void TiledBackingStore::copy_into(Gfx::Bitmap& target, Gfx::IntPoint target_location, Gfx::IntRect const& rect) const
+{
+    auto rect_to_copy = rect.intersected(target.rect().translated(target_location));
+
+    for_each_tile_index_in(rect_to_copy, [&](auto index) {
+        auto tile = m_tiles.get(index);
+        VERIFY(tile.has_value());
+
+        auto tile_rect = rect_of_tile(index);
+        auto rect_in_tile = tile_rect.intersected(rect_to_copy);
+        auto source_location = rect_in_tile.location() - tile_rect.location();
+        auto destination_location = rect_in_tile.location() - target_location;
+        for (int y = 0; y < rect_in_tile.height(); ++y) {
+            auto const* source = tile.value()->scanline(source_location.y() + y) + source_location.x();
+            auto* destination = target.scanline(destination_location.y() + y) + destination_location.x();
+            memcpy(destination, source, rect_in_tile.width() * sizeof(Gfx::ARGB32));
+        }
+    });
+}
+
+void TiledBackingStore::discard_tiles_outside(Gfx::IntRect const& rect)
+{
+    m_tiles.remove_all_matching([&](auto index, auto const&) {
+        return !rect_of_tile(index).intersects(rect);
+    });
+}
+
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
+#include <LibGfx/Bitmap.h>
+#include <LibGfx/Point.h>
+#include <LibGfx/Rect.h>
+#include <LibWeb/Painting/CommandList.h>
+
+namespace Web::Painting {
+
+// Keeps what was painted of the top-level document across frames, in tiles that are positioned relative to the document
+// rather than to the viewport. Scrolling then only has to paint the tiles that haven't been visible yet, and the tiles
+// around the viewport can be painted ahead of time while nothing else is going on.
+//
+// All rects and points are in device pixels, relative to the document's origin.
+class TiledBackingStore {
+public:
+    static constexpr int tile_size = 256;
+
+    // Throws away the tiles that overlap the rect.
+    void invalidate(Gfx::IntRect const&);
+    void invalidate_all() { m_tiles.clear(); }
+
+    // Paints the tiles covering the rect that are missing, closest to the middle of the rect first, up to the given
+    // number of tiles. The commands must have been recorded with the viewport at the given location, and must be able
+    // to be executed in tiles. Returns whether any tiles in the rect are still missing.
+    bool paint_missing_tiles(CommandList&, Gfx::IntPoint viewport_location, Gfx::IntRect const&, Gfx::BitmapFormat, size_t maximum_tile_count = NumericLimits<size_t>::max());
+
+    // Copies the rect of the document into the target, with the top left corner of the target being at the given location.
+    // The tiles covering the rect must have been painted.
+    void copy_into(Gfx::Bitmap& target, Gfx::IntPoint target_location, Gfx::IntRect const&) const;
+
+    // Throws away the tiles that don't overlap the rect, to put a limit on how much memory they take up.
+    void discard_tiles_outside(Gfx::IntRect const&);
+
+private:
+    static Gfx::IntRect rect_of_tile(Gfx::IntPoint index) { return { index.x() * tile_size, index.y() * tile_size, tile_size, tile_size }; }
+
+    template<typename Callback>
+    static void for_each_tile_index_in(Gfx::IntRect const&, Callback);
+
+    // Keyed by the position of the tile in the grid of tiles, i.e. by its location divided by the tile size.
+    HashMap<Gfx::IntPoint, NonnullRefPtr<Gfx::Bitmap>> m_tiles;
+};
+
+}
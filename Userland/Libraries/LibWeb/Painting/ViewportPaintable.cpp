@@ -38,10 +38,17 @@ void ViewportPaintable::build_stacking_context_tree_if_needed()
 void ViewportPaintable::build_stacking_context_tree()
 {
     set_stacking_context(make<StackingContext>(*this, nullptr, 0));
+    m_has_content_attached_to_viewport = false;
 
     size_t index_in_tree_order = 1;
     for_each_in_subtree([&](Paintable const& paintable) {
         const_cast<Paintable&>(paintable).invalidate_stacking_context();
+        if (paintable.is_fixed_position())
+            m_has_content_attached_to_viewport = true;
+        for (auto const& background_layer : paintable.computed_values().background_layers()) {
+            if (background_layer.attachment == CSS::BackgroundAttachment::Fixed)
+                m_has_content_attached_to_viewport = true;
+        }
         auto* parent_context = const_cast<Paintable&>(paintable).enclosing_stacking_context();
         auto establishes_stacking_context = paintable.layout_node().establishes_stacking_context();
         if ((paintable.is_positioned() || establishes_stacking_context) && paintable.computed_values().z_index().value_or(0) == 0)
@@ -60,6 +67,30 @@ void ViewportPaintable::build_stacking_context_tree()
     stacking_context()->sort();
 }
 
+CSSPixelRect ViewportPaintable::canvas_rect() const
+{
+    auto rect = absolute_rect();
+    if (auto scrollable_overflow_rect = this->scrollable_overflow_rect(); scrollable_overflow_rect.has_value())
+        rect = rect.united(*scrollable_overflow_rect);
+    return rect;
+}
+
+bool ViewportPaintable::has_content_attached_to_viewport() const
+{
+    // NOTE: This is figured out while building the stacking context tree, which is rebuilt whenever something becomes
+    //       fixed-position or gets a fixed background. Until it's built, we can't tell.
+    if (!stacking_context())
+        return true;
+    return m_has_content_attached_to_viewport;
+}
+
+void ViewportPaintable::set_needs_display() const
+{
+    // NOTE: The viewport is asked to be displayed again when it's not clear what changed, e.g. the selection.
+    if (auto navigable = this->navigable())
+        navigable->set_needs_display();
+}
+
 void ViewportPaintable::paint_all_phases(PaintContext& context)
 {
     build_stacking_context_tree_if_needed();
@@ -36,12 +36,23 @@ public:
 
     bool handle_mousewheel(Badge<EventHandler>, CSSPixelPoint, unsigned, unsigned, int wheel_delta_x, int wheel_delta_y) override;
 
+    virtual void set_needs_display() const override;
+
+    // The viewport and everything that can be scrolled into it.
+    CSSPixelRect canvas_rect() const;
+
+    // Whether anything is painted relative to the viewport rather than the document (i.e. fixed-position boxes and fixed
+    // backgrounds), which means the viewport can't be scrolled by just moving what was painted before.
+    bool has_content_attached_to_viewport() const;
+
 private:
     void build_stacking_context_tree();
 
     explicit ViewportPaintable(Layout::Viewport const&);
 
     virtual void visit_edges(Visitor&) override;
+
+    bool m_has_content_attached_to_viewport { false };
 };
 
 }
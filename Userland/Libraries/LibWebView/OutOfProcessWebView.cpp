@@ -34,8 +34,12 @@ OutOfProcessWebView::OutOfProcessWebView()
         set_content_size(content_size);
     };
 
-    on_ready_to_paint = [this]() {
-        update();
+    on_ready_to_paint = [this](auto const& damaged_rect) {
+        if (m_content_scales_to_viewport || m_device_pixel_ratio != 1.0f) {
+            update();
+            return;
+        }
+        update(damaged_rect.translated(frame_thickness(), frame_thickness()));
     };
 
     on_request_file = [this](auto const& path, auto request_id) {
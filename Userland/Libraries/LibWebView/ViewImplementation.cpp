@@ -60,15 +60,20 @@ u64 ViewImplementation::page_id() const
     return m_client_state.page_index;
 }
 
-void ViewImplementation::server_did_paint(Badge<WebContentClient>, i32 bitmap_id, Gfx::IntSize size)
+void ViewImplementation::server_did_paint(Badge<WebContentClient>, i32 bitmap_id, Gfx::IntSize size, Gfx::IntRect const& damaged_rect)
 {
     if (m_client_state.back_bitmap.id == bitmap_id) {
+        // If something other than the previous front bitmap is on screen, all of it has to be shown again.
+        auto rect_to_show = damaged_rect;
+        if (!m_client_state.has_usable_bitmap || m_backup_bitmap || m_client_state.front_bitmap.last_painted_size != size.to_type<Web::DevicePixels>())
+            rect_to_show = { {}, size };
+
         m_client_state.has_usable_bitmap = true;
         m_client_state.back_bitmap.last_painted_size = size.to_type<Web::DevicePixels>();
         swap(m_client_state.back_bitmap, m_client_state.front_bitmap);
         m_backup_bitmap = nullptr;
         if (on_ready_to_paint)
-            on_ready_to_paint();
+            on_ready_to_paint(rect_to_show);
     }
 
     client().async_ready_to_paint(page_id());
@@ -44,7 +44,7 @@ public:
 
     String const& handle() const { return m_client_state.client_handle; }
 
-    void server_did_paint(Badge<WebContentClient>, i32 bitmap_id, Gfx::IntSize size);
+    void server_did_paint(Badge<WebContentClient>, i32 bitmap_id, Gfx::IntSize size, Gfx::IntRect const& damaged_rect);
 
     void load(URL::URL const&);
     void load_html(StringView);
@@ -130,7 +130,8 @@ public:
     void enable_inspector_prototype();
 
     Function<void(Gfx::IntSize)> on_did_layout;
-    Function<void()> on_ready_to_paint;
+    // The rect is in device pixels, and is the part of the front bitmap that changed since it was last shown.
+    Function<void(Gfx::IntRect const&)> on_ready_to_paint;
     Function<String(Web::HTML::ActivateTab, Web::HTML::WebViewHints, Optional<u64>)> on_new_web_view;
     Function<void()> on_activate_tab;
     Function<void()> on_close;
@@ -41,10 +41,10 @@ void WebContentClient::notify_process_information(WebView::ProcessHandle const&
     m_process_handle = handle;
 }
 
-void WebContentClient::did_paint(u64 page_id, Gfx::IntRect const& rect, i32 bitmap_id)
+void WebContentClient::did_paint(u64 page_id, Gfx::IntRect const& rect, i32 bitmap_id, Gfx::IntRect const& damaged_rect)
 {
     if (auto view = view_for_page_id(page_id); view.has_value())
-        view->server_did_paint({}, bitmap_id, rect.size());
+        view->server_did_paint({}, bitmap_id, rect.size(), damaged_rect);
 }
 
 void WebContentClient::did_start_loading(u64 page_id, URL::URL const& url, bool is_redirect)
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibCore/File.h>
+#include <RequestServer/CachedRequest.h>
+
+namespace RequestServer {
+
+CachedRequest::CachedRequest(ConnectionFromClient& client, URL::URL url, NonnullOwnPtr<Core::File>&& output_stream, i32 request_id)
+    : Request(client, move(output_stream), request_id)
+    , m_url(move(url))
+{
+}
+
+NonnullOwnPtr<CachedRequest> CachedRequest::create(ConnectionFromClient& client, URL::URL url, HTTP::HttpCache::CachedResponse response, NonnullOwnPtr<Core::File>&& output_stream, i32 request_id)
+{
+    auto request = adopt_own(*new CachedRequest(client, move(url), move(output_stream), request_id));
+    request->stream_cached_response(move(response));
+    return request;
+}
+
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/NonnullOwnPtr.h>
+#include <LibCore/Forward.h>
+#include <LibHTTP/HttpCache.h>
+#include <RequestServer/Request.h>
+
+namespace RequestServer {
+
+// A request answered from the HTTP cache, without going to the network.
+class CachedRequest final : public Request {
+public:
+    virtual ~CachedRequest() override = default;
+    static NonnullOwnPtr<CachedRequest> create(ConnectionFromClient&, URL::URL, HTTP::HttpCache::CachedResponse, NonnullOwnPtr<Core::File>&&, i32 request_id);
+
+    virtual URL::URL url() const override { return m_url; }
+
+private:
+    CachedRequest(ConnectionFromClient&, URL::URL, NonnullOwnPtr<Core::File>&&, i32 request_id);
+
+    URL::URL m_url;
+};
+
+}
@@ -13,7 +13,10 @@ namespace RequestServer::ConnectionCache {
 
 HashMap<ConnectionKey, NonnullOwnPtr<Vector<NonnullOwnPtr<Connection<Core::TCPSocket, Core::Socket>>>>> g_tcp_connection_cache {};
 HashMap<ConnectionKey, NonnullOwnPtr<Vector<NonnullOwnPtr<Connection<TLS::TLSv12>>>>> g_tls_connection_cache {};
+HashMap<ConnectionKey, NonnullOwnPtr<Http2ConnectionEntry>> g_http2_connection_cache {};
+HashMap<ConnectionKey, Vector<Http2ConnectionWaiter>> g_http2_connection_waiters {};
 HashMap<ByteString, InferredServerProperties> g_inferred_server_properties;
+HashMap<ConnectionKey, Vector<TLS::Session>> g_tls_session_cache;
 
 void request_did_finish(URL::URL const& url, Core::Socket const* socket)
 {
@@ -95,8 +98,104 @@ void request_did_finish(URL::URL const& url, Core::Socket const* socket)
         dbgln("Unknown socket {} finished for URL {}", socket, url);
 }
 
+HTTP::Http2Connection* usable_http2_connection(ConnectionKey const& key)
+{
+    auto entry = g_http2_connection_cache.get(key);
+    if (!entry.has_value() || !(*entry)->connection->is_usable())
+        return nullptr;
+    return (*entry)->connection.ptr();
+}
+
+void offer_cached_tls_session(TLS::Options& options, ConnectionKey const& key)
+{
+    // Servers hand out a handful of tickets per connection at most, keeping a few around is plenty.
+    constexpr size_t max_sessions_per_server = 4;
+
+    if (auto it = g_tls_session_cache.find(key); it != g_tls_session_cache.end()) {
+        auto& sessions = it->value;
+        sessions.remove_all_matching([](auto& session) { return session.is_expired(); });
+        if (!sessions.is_empty()) {
+            // NOTE: TLS 1.3 tickets are only good for a single connection (RFC 8446 section C.4), TLS 1.2 sessions can be resumed repeatedly.
+            if (sessions.last().version == TLS::ProtocolVersion::VERSION_1_3)
+                options.set_session(sessions.take_last());
+            else
+                options.set_session(sessions.last());
+            dbgln_if(REQUESTSERVER_DEBUG, "Offering a cached TLS session to {}:{}", key.hostname, key.port);
+        }
+        if (sessions.is_empty())
+            g_tls_session_cache.remove(it);
+    }
+
+    options.set_session_handler([key](TLS::Session session) {
+        auto& sessions = g_tls_session_cache.ensure(key);
+        if (sessions.size() >= max_sessions_per_server)
+            sessions.remove(0);
+        sessions.append(move(session));
+    });
+}
+
+ErrorOr<NonnullOwnPtr<TLS::TLSv12>> connect_offering_http2(Proxy& proxy, URL::URL const& url, ConnectionKey const& key)
+{
+    // NOTE: The handshake runs a nested event loop, in which more requests for the server are likely to come in. Unless the
+    //       server is known not to speak HTTP/2, they wait for the handshake, as they can all share the connection if it does.
+    bool should_hold_requests = g_inferred_server_properties.ensure(key.hostname).supports_http2.value_or(true) && !g_http2_connection_waiters.contains(key);
+    if (should_hold_requests)
+        g_http2_connection_waiters.set(key, {});
+
+    TLS::Options options;
+    options.set_alpn_protocols({ "h2", "http/1.1" });
+    offer_cached_tls_session(options, key);
+    auto result = proxy.tunnel<TLS::TLSv12, TLS::TLSv12>(url, move(options));
+    if (!result.is_error())
+        g_inferred_server_properties.ensure(key.hostname).supports_http2 = result.value()->alpn() == "h2"sv;
+
+    if (should_hold_requests) {
+        // NOTE: The caller sets up the HTTP/2 connection once we return, if there is going to be one.
+        Core::deferred_invoke([key, waiters = g_http2_connection_waiters.take(key).release_value()]() mutable {
+            auto* connection = usable_http2_connection(key);
+            dbgln_if(REQUESTSERVER_DEBUG, "Resuming {} requests for {}:{} {}", waiters.size(), key.hostname, key.port, connection ? "on an HTTP/2 connection"sv : "without HTTP/2"sv);
+            for (auto& waiter : waiters)
+                waiter(connection);
+        });
+    }
+
+    return result;
+}
+
+static void remove_http2_connection(ConnectionKey const& key, HTTP::Http2Connection const& connection)
+{
+    auto it = g_http2_connection_cache.find(key);
+    if (it == g_http2_connection_cache.end() || it->value->connection.ptr() != &connection)
+        return;
+    dbgln_if(REQUESTSERVER_DEBUG, "Removing HTTP/2 connection {} to {}:{}", &connection, key.hostname, key.port);
+    g_http2_connection_cache.remove(it);
+}
+
+HTTP::Http2Connection& add_http2_connection(ConnectionKey const& key, NonnullOwnPtr<TLS::TLSv12> socket, Proxy proxy)
+{
+    auto connection = HTTP::Http2Connection::construct(move(socket));
+    auto removal_timer = Core::Timer::create_single_shot(ConnectionKeepAliveTimeMilliseconds, [key, connection = connection.ptr()] {
+        Core::deferred_invoke([key, connection] {
+            if (connection->stream_count() == 0)
+                remove_http2_connection(key, *connection);
+        });
+    });
+
+    connection->on_idle = [removal_timer] { removal_timer->restart(); };
+    connection->on_close = [key, connection = connection.ptr()] { remove_http2_connection(key, *connection); };
+
+    dbgln_if(REQUESTSERVER_DEBUG, "Adding HTTP/2 connection {} to {}:{}", connection, key.hostname, key.port);
+    g_http2_connection_cache.set(key, make<Http2ConnectionEntry>(connection, move(removal_timer), move(proxy)));
+    return *connection;
+}
+
 void dump_jobs()
 {
+    dbgln("=========== HTTP/2 Connection Cache ==========");
+    for (auto& connection : g_http2_connection_cache) {
+        dbgln(" - {}:{}", connection.key.hostname, connection.key.port);
+        dbgln("  - Connection {} (usable={}) ({} streams)", connection.value->connection, connection.value->connection->is_usable(), connection.value->connection->stream_count());
+    }
     dbgln("=========== TLS Connection Cache ==========");
     for (auto& connection : g_tls_connection_cache) {
         dbgln(" - {}:{}", connection.key.hostname, connection.key.port);
@@ -15,6 +15,7 @@
 #include <LibCore/NetworkJob.h>
 #include <LibCore/SOCKSProxyClient.h>
 #include <LibCore/Timer.h>
+#include <LibHTTP/Http2Connection.h>
 #include <LibTLS/TLSv12.h>
 #include <LibURL/URL.h>
 
@@ -115,15 +116,38 @@ namespace RequestServer::ConnectionCache {
 
 struct InferredServerProperties {
     size_t requests_served_per_connection { NumericLimits<size_t>::max() };
+    Optional<bool> supports_http2;
 };
 
+// A connection that every request to the server shares, instead of them queueing up for a connection of their own.
+struct Http2ConnectionEntry {
+    NonnullRefPtr<HTTP::Http2Connection> connection;
+    NonnullRefPtr<Core::Timer> removal_timer;
+    Proxy proxy {};
+};
+
+// Requests that wait for the server to tell whether it speaks HTTP/2, which they're handed the connection in if it does.
+using Http2ConnectionWaiter = Function<void(HTTP::Http2Connection*)>;
+
 extern HashMap<ConnectionKey, NonnullOwnPtr<Vector<NonnullOwnPtr<Connection<Core::TCPSocket, Core::Socket>>>>> g_tcp_connection_cache;
 extern HashMap<ConnectionKey, NonnullOwnPtr<Vector<NonnullOwnPtr<Connection<TLS::TLSv12>>>>> g_tls_connection_cache;
+extern HashMap<ConnectionKey, NonnullOwnPtr<Http2ConnectionEntry>> g_http2_connection_cache;
+extern HashMap<ConnectionKey, Vector<Http2ConnectionWaiter>> g_http2_connection_waiters;
 extern HashMap<ByteString, InferredServerProperties> g_inferred_server_properties;
+extern HashMap<ConnectionKey, Vector<TLS::Session>> g_tls_session_cache;
 
 void request_did_finish(URL::URL const&, Core::Socket const*);
 void dump_jobs();
 
+HTTP::Http2Connection* usable_http2_connection(ConnectionKey const&);
+ErrorOr<NonnullOwnPtr<TLS::TLSv12>> connect_offering_http2(Proxy&, URL::URL const&, ConnectionKey const&);
+HTTP::Http2Connection& add_http2_connection(ConnectionKey const&, NonnullOwnPtr<TLS::TLSv12>, Proxy);
+void offer_cached_tls_session(TLS::Options&, ConnectionKey const&);
+
+// Only HTTP jobs know how to run on an HTTP/2 connection, and only over TLS, which is where the protocol is negotiated.
+template<typename ConnectionType, typename JobType>
+constexpr bool can_use_http2 = IsSame<typename ConnectionType::SocketType, TLS::TLSv12> && requires(JobType job, HTTP::Http2Connection& connection) { job->start(connection); };
+
 constexpr static size_t MaxConcurrentConnectionsPerURL = 4;
 constexpr static size_t ConnectionKeepAliveTimeMilliseconds = 10'000;
 
@@ -159,6 +183,7 @@ ErrorOr<void> recreate_socket_if_needed(T& connection, URL::URL const& url)
                     return connection.job_data.provide_client_certificates();
                 return {};
             });
+            offer_cached_tls_session(options, { url.serialized_host().release_value_but_fixme_should_propagate_errors().to_byte_string(), url.port_or_default(), connection.proxy.data });
             TRY(set_socket(TRY((connection.proxy.template tunnel<SocketType, SocketStorageType>(url, move(options))))));
         } else {
             TRY(set_socket(TRY((connection.proxy.template tunnel<SocketType, SocketStorageType>(url)))));
@@ -172,14 +197,35 @@ decltype(auto) get_or_create_connection(auto& cache, URL::URL const& url, auto j
 {
     using CacheEntryType = RemoveCVReference<decltype(*cache.begin()->value)>;
 
+    using ConnectionType = RemoveCVReference<decltype(*cache.begin()->value->at(0))>;
+
     auto hostname = url.serialized_host().release_value_but_fixme_should_propagate_errors().to_byte_string();
     auto& properties = g_inferred_server_properties.ensure(hostname);
 
-    auto& sockets_for_url = *cache.ensure({ move(hostname), url.port_or_default(), proxy_data }, [] { return make<CacheEntryType>(); });
+    ConnectionKey key { move(hostname), url.port_or_default(), proxy_data };
+    auto& sockets_for_url = *cache.ensure(key, [] { return make<CacheEntryType>(); });
 
     Proxy proxy { proxy_data };
 
     using ReturnType = decltype(sockets_for_url[0].ptr());
+
+    if constexpr (can_use_http2<ConnectionType, decltype(job)>) {
+        if (auto* connection = usable_http2_connection(key)) {
+            dbgln_if(REQUESTSERVER_DEBUG, "Start request for URL {} on HTTP/2 connection {}", url, connection);
+            job->start(*connection);
+            return ReturnType { nullptr };
+        }
+        if (auto it = g_http2_connection_waiters.find(key); it != g_http2_connection_waiters.end()) {
+            dbgln_if(REQUESTSERVER_DEBUG, "Request for URL {} waits for the connection being set up", url);
+            it->value.append([&cache, url, job, proxy_data](HTTP::Http2Connection* connection) {
+                if (connection)
+                    job->start(*connection);
+                else
+                    get_or_create_connection(cache, url, job, proxy_data);
+            });
+            return ReturnType { nullptr };
+        }
+    }
     // Find the connection with an empty queue; if none exist, we'll find the least backed-up connection later.
     // Note that servers that are known to serve a single request per connection (e.g. HTTP/1.0) usually have
     // issues with concurrent connections, so we'll only allow one connection per URL in that case to avoid issues.
@@ -189,8 +235,20 @@ decltype(auto) get_or_create_connection(auto& cache, URL::URL const& url, auto j
     auto did_add_new_connection = false;
     auto failed_to_find_a_socket = it.is_end();
     if (failed_to_find_a_socket && sockets_for_url.size() < ConnectionCache::MaxConcurrentConnectionsPerURL) {
-        using ConnectionType = RemoveCVReference<decltype(*cache.begin()->value->at(0))>;
-        auto connection_result = proxy.tunnel<typename ConnectionType::SocketType, typename ConnectionType::StorageType>(url);
+        auto connection_result = [&] {
+            if constexpr (can_use_http2<ConnectionType, decltype(job)>)
+                return connect_offering_http2(proxy, url, key);
+            else
+                return proxy.tunnel<typename ConnectionType::SocketType, typename ConnectionType::StorageType>(url);
+        }();
+        if constexpr (can_use_http2<ConnectionType, decltype(job)>) {
+            if (!connection_result.is_error() && connection_result.value()->alpn() == "h2"sv) {
+                auto& connection = add_http2_connection(key, connection_result.release_value(), move(proxy));
+                dbgln_if(REQUESTSERVER_DEBUG, "Start request for URL {} on new HTTP/2 connection {}", url, &connection);
+                job->start(connection);
+                return ReturnType { nullptr };
+            }
+        }
         if (connection_result.is_error()) {
             dbgln("ConnectionCache: Connection to {} failed: {}", url, connection_result.error());
             Core::deferred_invoke([job] {
@@ -163,6 +163,11 @@ public:
         ConnectionCache::request_did_finish(m_url, &socket);
     }
 
+    void start(HTTP::Http2Connection&)
+    {
+        // NOTE: There's nothing to do, the connection is now there for requests to the server to use.
+    }
+
     void fail(Core::NetworkJob::Error error)
     {
         dbgln("Pre-connect to {} failed: {}", m_url, Core::to_string(error));
@@ -13,7 +13,9 @@
 #include <AK/Optional.h>
 #include <AK/OwnPtr.h>
 #include <AK/Types.h>
+#include <LibHTTP/HttpCache.h>
 #include <LibHTTP/HttpRequest.h>
+#include <RequestServer/CachedRequest.h>
 #include <RequestServer/ConnectionCache.h>
 #include <RequestServer/ConnectionFromClient.h>
 #include <RequestServer/Request.h>
@@ -24,15 +26,32 @@ template<typename TSelf, typename TJob>
 void init(TSelf* self, TJob job)
 {
     job->on_headers_received = [self](auto& headers, auto response_code) {
+        if (auto* cache_writer = self->cache_writer()) {
+            cache_writer->did_receive_response(response_code.value_or(0), headers);
+
+            // The client didn't ask for the revalidation, so it gets the stored response instead once the job is done.
+            if (cache_writer->has_revalidated_response())
+                return;
+        }
         if (response_code.has_value())
             self->set_status_code(response_code.value());
         self->set_response_headers(headers);
     };
 
     job->on_finish = [self](bool success) {
-        Core::deferred_invoke([url = self->job().url(), socket = self->job().socket()] {
-            ConnectionCache::request_did_finish(url, socket);
-        });
+        // NOTE: Requests on an HTTP/2 connection have no socket of their own to hand to the next request.
+        if (auto* socket = self->job().socket()) {
+            Core::deferred_invoke([url = self->job().url(), socket] {
+                ConnectionCache::request_did_finish(url, socket);
+            });
+        }
+        if (auto* cache_writer = self->cache_writer()) {
+            if (auto revalidated_response = cache_writer->take_revalidated_response(); revalidated_response.has_value()) {
+                self->stream_cached_response(revalidated_response.release_value());
+                return;
+            }
+            cache_writer->did_finish(success);
+        }
         if (auto* response = self->job().response()) {
             self->set_status_code(response->code());
             self->set_response_headers(response->headers());
@@ -47,6 +66,8 @@ void init(TSelf* self, TJob job)
         self->did_finish(success);
     };
     job->on_progress = [self](Optional<u64> total, u64 current) {
+        if (auto* cache_writer = self->cache_writer(); cache_writer && cache_writer->has_revalidated_response())
+            return;
         self->did_progress(total, current);
     };
     if constexpr (requires { job->on_certificate_requested; }) {
@@ -70,6 +91,21 @@ OwnPtr<Request> start_request(TBadgedProtocol&& protocol, i32 request_id, Connec
         return {};
     }
 
+    auto cache_match = HTTP::HttpCache::the().find(method, url, headers);
+    if (cache_match.has_value() && cache_match->freshness == HTTP::HttpCache::Freshness::Fresh) {
+        auto output_stream = MUST(Core::File::adopt_fd(pipe_result.value().write_fd, Core::File::OpenMode::Write));
+        auto cached_request = CachedRequest::create(client, url, move(cache_match->response), move(output_stream), request_id);
+        cached_request->set_request_fd(pipe_result.value().read_fd);
+        return cached_request;
+    }
+
+    auto request_headers = headers;
+    Optional<HTTP::HttpCache::CachedResponse> response_to_revalidate;
+    if (cache_match.has_value()) {
+        response_to_revalidate = move(cache_match->response);
+        HTTP::HttpCache::add_validators(*response_to_revalidate, request_headers);
+    }
+
     HTTP::HttpRequest request;
     if (method.equals_ignoring_ascii_case("post"sv))
         request.set_method(HTTP::HttpRequest::Method::POST);
@@ -90,7 +126,7 @@ OwnPtr<Request> start_request(TBadgedProtocol&& protocol, i32 request_id, Connec
     else
         request.set_method(HTTP::HttpRequest::Method::GET);
     request.set_url(url);
-    request.set_headers(headers);
+    request.set_headers(request_headers);
 
     auto allocated_body_result = ByteBuffer::copy(body);
     if (allocated_body_result.is_error())
@@ -98,9 +134,11 @@ OwnPtr<Request> start_request(TBadgedProtocol&& protocol, i32 request_id, Connec
     request.set_body(allocated_body_result.release_value());
 
     auto output_stream = MUST(Core::File::adopt_fd(pipe_result.value().write_fd, Core::File::OpenMode::Write));
-    auto job = TJob::construct(move(request), *output_stream);
+    auto cache_writer = make<HTTP::HttpCache::Writer>(*output_stream, method, url, headers, move(response_to_revalidate));
+    auto job = TJob::construct(move(request), *cache_writer);
     auto protocol_request = TRequest::create_with_job(forward<TBadgedProtocol>(protocol), client, (TJob&)*job, move(output_stream), request_id);
     protocol_request->set_request_fd(pipe_result.value().read_fd);
+    protocol_request->set_cache_writer(move(cache_writer));
 
     if constexpr (IsSame<typename TBadgedProtocol::Type, HttpsProtocol>)
         ConnectionCache::get_or_create_connection(ConnectionCache::g_tls_connection_cache, url, job, proxy_data);
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <LibCore/File.h>
 #include <RequestServer/ConnectionFromClient.h>
 #include <RequestServer/Request.h>
 
@@ -48,4 +49,67 @@ void Request::did_request_certificates()
     m_client.did_request_certificates({}, *this);
 }
 
+void Request::stream_cached_response(HTTP::HttpCache::CachedResponse response)
+{
+    m_cached_response = move(response);
+
+    // NOTE: The pipe is writable from the start, so this also waits for the client to have been told the request started.
+    m_output_notifier = Core::Notifier::construct(m_output_stream->fd(), Core::Notifier::Type::Write);
+    m_output_notifier->on_activation = [this] {
+        send_cached_response();
+    };
+}
+
+void Request::send_cached_response()
+{
+    auto finish = [this](bool success) {
+        m_output_notifier->set_enabled(false);
+        set_downloaded_size(m_sent_cached_body_size);
+        // NOTE: The client only hears about the request finishing if it knows the total size.
+        did_progress(m_sent_cached_body_size, m_sent_cached_body_size);
+        did_finish(success);
+    };
+
+    if (!m_cached_body) {
+        auto body_or_error = HTTP::HttpCache::the().open_body(*m_cached_response);
+        auto buffer_or_error = ByteBuffer::create_uninitialized(64 * KiB);
+        if (body_or_error.is_error() || buffer_or_error.is_error()) {
+            dbgln("Request: Unable to read the cached response for {}", url());
+            finish(false);
+            return;
+        }
+        m_cached_body = body_or_error.release_value();
+        m_cached_body_buffer = buffer_or_error.release_value();
+
+        set_status_code(m_cached_response->status_code);
+        set_response_headers(m_cached_response->response_headers);
+    }
+
+    for (;;) {
+        if (m_unsent_cached_body.is_empty()) {
+            auto bytes_or_error = m_cached_body->read_some(m_cached_body_buffer);
+            if (bytes_or_error.is_error()) {
+                finish(false);
+                return;
+            }
+            if (bytes_or_error.value().is_empty())
+                break;
+            m_unsent_cached_body = bytes_or_error.value();
+        }
+
+        auto written_or_error = m_output_stream->write_some(m_unsent_cached_body);
+        if (written_or_error.is_error()) {
+            // The client hasn't caught up yet, so this carries on once the pipe is writable again.
+            if (written_or_error.error().is_errno() && written_or_error.error().code() == EAGAIN)
+                return;
+            finish(false);
+            return;
+        }
+        m_unsent_cached_body = m_unsent_cached_body.slice(written_or_error.value());
+        m_sent_cached_body_size += written_or_error.value();
+    }
+
+    finish(true);
+}
+
 }
@@ -6,10 +6,14 @@
 
 #pragma once
 
+#include <AK/ByteBuffer.h>
 #include <AK/HashMap.h>
 #include <AK/NonnullOwnPtr.h>
 #include <AK/Optional.h>
+#include <AK/OwnPtr.h>
 #include <AK/RefCounted.h>
+#include <LibCore/Notifier.h>
+#include <LibHTTP/HttpCache.h>
 #include <LibURL/URL.h>
 #include <RequestServer/Forward.h>
 
@@ -42,6 +46,12 @@ public:
     void set_downloaded_size(size_t size) { m_downloaded_size = size; }
     Core::File const& output_stream() const { return *m_output_stream; }
 
+    // Answers the request with a response from the HTTP cache, once the client has been told the request started.
+    void stream_cached_response(HTTP::HttpCache::CachedResponse);
+
+    HTTP::HttpCache::Writer* cache_writer() { return m_cache_writer; }
+    void set_cache_writer(NonnullOwnPtr<HTTP::HttpCache::Writer> cache_writer) { m_cache_writer = move(cache_writer); }
+
 protected:
     explicit Request(ConnectionFromClient&, NonnullOwnPtr<Core::File>&&, i32 request_id);
 
@@ -54,6 +64,19 @@ private:
     size_t m_downloaded_size { 0 };
     NonnullOwnPtr<Core::File> m_output_stream;
     HashMap<ByteString, ByteString, CaseInsensitiveStringTraits> m_response_headers;
+
+    // Writes to the output stream, so it's declared after it to be destroyed first.
+    OwnPtr<HTTP::HttpCache::Writer> m_cache_writer;
+
+    void send_cached_response();
+
+    // While a response from the HTTP cache is being sent.
+    Optional<HTTP::HttpCache::CachedResponse> m_cached_response;
+    OwnPtr<Core::File> m_cached_body;
+    RefPtr<Core::Notifier> m_output_notifier;
+    ByteBuffer m_cached_body_buffer;
+    ReadonlyBytes m_unsent_cached_body;
+    u64 m_sent_cached_body_size { 0 };
 };
 
 }
@@ -62,6 +62,20 @@ void ConnectionFromClient::disconnect(SQL::ConnectionID connection_id)
         dbgln("Database connection has disappeared");
 }
 
+Messages::SQLServer::BufferPoolStatisticsResponse ConnectionFromClient::buffer_pool_statistics(SQL::ConnectionID connection_id)
+{
+    dbgln_if(SQLSERVER_DEBUG, "ConnectionFromClient::buffer_pool_statistics(connection_id: {})", connection_id);
+
+    auto database_connection = DatabaseConnection::connection_for(connection_id);
+    if (!database_connection) {
+        dbgln("Database connection has disappeared");
+        return { 0, 0, 0, 0, 0, 0 };
+    }
+
+    auto statistics = database_connection->database()->buffer_pool_statistics();
+    return { statistics.capacity, statistics.cached_blocks, statistics.pinned_blocks, statistics.hits, statistics.misses, statistics.evictions };
+}
+
 Messages::SQLServer::PrepareStatementResponse ConnectionFromClient::prepare_statement(SQL::ConnectionID connection_id, ByteString const& sql)
 {
     dbgln_if(SQLSERVER_DEBUG, "ConnectionFromClient::prepare_statement(connection_id: {}, sql: '{}')", connection_id, sql);
@@ -39,6 +39,7 @@ private:
     virtual Messages::SQLServer::ExecuteStatementResponse execute_statement(SQL::StatementID, Vector<SQL::Value> const& placeholder_values) override;
     virtual void ready_for_next_result(SQL::StatementID, SQL::ExecutionID) override;
     virtual void disconnect(SQL::ConnectionID) override;
+    virtual Messages::SQLServer::BufferPoolStatisticsResponse buffer_pool_statistics(SQL::ConnectionID) override;
 
     ByteString m_database_path;
 };
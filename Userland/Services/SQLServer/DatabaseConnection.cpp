@@ -5,6 +5,8 @@
  */
 
 #include <AK/LexicalPath.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/EventReceiver.h>
 #include <SQLServer/DatabaseConnection.h>
 #include <SQLServer/SQLStatement.h>
 
@@ -12,6 +14,7 @@ namespace SQLServer {
 
 static HashMap<SQL::ConnectionID, NonnullRefPtr<DatabaseConnection>> s_connections;
 static SQL::ConnectionID s_next_connection_id = 0;
+static HashMap<ByteString, Vector<Function<void(ErrorOr<void>)>>> s_callbacks_awaiting_sync;
 
 static ErrorOr<NonnullRefPtr<SQL::Database>> find_or_create_database(StringView database_path, StringView database_name)
 {
@@ -21,7 +24,9 @@ static ErrorOr<NonnullRefPtr<SQL::Database>> find_or_create_database(StringView
     }
 
     auto database_file = ByteString::formatted("{}/{}.db", database_path, database_name);
-    return SQL::Database::create(move(database_file));
+    auto database = TRY(SQL::Database::create(move(database_file)));
+    database->set_group_commit(true);
+    return database;
 }
 
 RefPtr<DatabaseConnection> DatabaseConnection::connection_for(SQL::ConnectionID connection_id)
@@ -64,6 +69,42 @@ void DatabaseConnection::disconnect()
     s_connections.remove(connection_id());
 }
 
+void DatabaseConnection::when_commits_are_durable(Function<void(ErrorOr<void>)> callback)
+{
+    if (!m_database->has_unsynced_commits()) {
+        callback({});
+        return;
+    }
+
+    auto& callbacks = s_callbacks_awaiting_sync.ensure(m_database_name);
+    callbacks.append(move(callback));
+    if (callbacks.size() > 1)
+        return;
+
+    // Give statements that are already queued up a chance to commit before we sync.
+    Core::deferred_invoke([database = m_database, database_name = m_database_name] {
+        auto callbacks = s_callbacks_awaiting_sync.take(database_name).release_value();
+        auto result = database->sync();
+        dbgln_if(SQLSERVER_DEBUG, "DatabaseConnection: synced {} commits to database '{}'", callbacks.size(), database_name);
+
+        for (auto& callback : callbacks) {
+            if (result.is_error())
+                callback(Error::copy(result.error()));
+            else
+                callback({});
+        }
+    });
+}
+
+ErrorOr<void> DatabaseConnection::run_on_reader_thread(Function<void()> task)
+{
+    if (!m_reader_thread)
+        m_reader_thread = TRY(ReaderThread::create("SQLServer reader"sv));
+
+    m_reader_thread->enqueue(move(task));
+    return {};
+}
+
 SQL::ResultOr<SQL::StatementID> DatabaseConnection::prepare_statement(StringView sql)
 {
     dbgln_if(SQLSERVER_DEBUG, "DatabaseConnection::prepare_statement(connection_id {}, database '{}', sql '{}'", connection_id(), m_database_name, sql);
@@ -6,12 +6,15 @@
 
 #pragma once
 
+#include <AK/Function.h>
 #include <AK/NonnullRefPtr.h>
+#include <AK/OwnPtr.h>
 #include <AK/RefCounted.h>
 #include <LibSQL/Database.h>
 #include <LibSQL/Result.h>
 #include <LibSQL/Type.h>
 #include <SQLServer/Forward.h>
+#include <SQLServer/ReaderThread.h>
 
 namespace SQLServer {
 
@@ -27,6 +30,14 @@ public:
     void disconnect();
     SQL::ResultOr<SQL::StatementID> prepare_statement(StringView sql);
 
+    // Invokes the callback once everything this connection's database has committed so far is
+    // durable. Commits from all connections to the same database share a single sync.
+    void when_commits_are_durable(Function<void(ErrorOr<void>)>);
+
+    // Runs a task for a read-only statement on this connection's reader thread; see ReaderThread.
+    // The task must not hold on to anything that is used on the main thread as well.
+    ErrorOr<void> run_on_reader_thread(Function<void()>);
+
 private:
     DatabaseConnection(NonnullRefPtr<SQL::Database> database, ByteString database_name, int client_id);
 
@@ -34,6 +45,7 @@ private:
     ByteString m_database_name;
     SQL::ConnectionID m_connection_id { 0 };
     int m_client_id { 0 };
+    OwnPtr<ReaderThread> m_reader_thread;
 };
 
 }
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <SQLServer/ReaderThread.h>
+
+namespace SQLServer {
+
+ErrorOr<NonnullOwnPtr<ReaderThread>> ReaderThread::create(StringView name)
+{
+    auto reader_thread = TRY(adopt_nonnull_own_or_enomem(new (nothrow) ReaderThread()));
+    reader_thread->m_thread = TRY(Threading::Thread::try_create([&self = *reader_thread] { return self.run(); }, name));
+    reader_thread->m_thread->start();
+    return reader_thread;
+}
+
+ReaderThread::~ReaderThread()
+{
+    {
+        Threading::MutexLocker locker { m_mutex };
+        m_should_exit = true;
+        m_condition.signal();
+    }
+    (void)m_thread->join();
+}
+
+void ReaderThread::enqueue(Function<void()> task)
+{
+    Threading::MutexLocker locker { m_mutex };
+    m_tasks.enqueue(move(task));
+    m_condition.signal();
+}
+
+intptr_t ReaderThread::run()
+{
+    while (true) {
+        Function<void()> task;
+        {
+            Threading::MutexLocker locker { m_mutex };
+            m_condition.wait_while([&] { return m_tasks.is_empty() && !m_should_exit; });
+            if (m_should_exit)
+                return 0;
+            task = m_tasks.dequeue();
+        }
+        task();
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Queue.h>
+#include <AK/RefPtr.h>
+#include <LibThreading/ConditionVariable.h>
+#include <LibThreading/Mutex.h>
+#include <LibThreading/Thread.h>
+
+namespace SQLServer {
+
+/**
+ * A ReaderThread runs the read-only statements of a DatabaseConnection, one after the other, next
+ * to the main thread that runs every statement modifying the database. Read-only statements work
+ * on a snapshot of the database, so they neither see nor hold up the writes that happen meanwhile.
+ *
+ * Tasks that have not started yet when the ReaderThread is destroyed are dropped.
+ */
+class ReaderThread {
+    AK_MAKE_NONCOPYABLE(ReaderThread);
+    AK_MAKE_NONMOVABLE(ReaderThread);
+
+public:
+    static ErrorOr<NonnullOwnPtr<ReaderThread>> create(StringView name);
+    ~ReaderThread();
+
+    void enqueue(Function<void()>);
+
+private:
+    ReaderThread() = default;
+
+    intptr_t run();
+
+    RefPtr<Threading::Thread> m_thread;
+    Threading::Mutex m_mutex;
+    Threading::ConditionVariable m_condition { m_mutex };
+    Queue<Function<void()>> m_tasks;
+    bool m_should_exit { false };
+};
+
+}
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <LibCore/EventLoop.h>
 #include <LibCore/EventReceiver.h>
 #include <LibSQL/AST/Parser.h>
 #include <SQLServer/ConnectionFromClient.h>
@@ -15,6 +16,9 @@ namespace SQLServer {
 static HashMap<SQL::StatementID, NonnullRefPtr<SQLStatement>> s_statements;
 static SQL::StatementID s_next_statement_id = 0;
 
+// The number of rows a SELECT pulls from its plan at a time, on the connection's reader thread.
+static constexpr size_t ROWS_PER_FETCH = 64;
+
 RefPtr<SQLStatement> SQLStatement::statement_for(SQL::StatementID statement_id)
 {
     if (s_statements.contains(statement_id))
@@ -31,12 +35,13 @@ SQL::ResultOr<NonnullRefPtr<SQLStatement>> SQLStatement::create(DatabaseConnecti
     if (parser.has_errors())
         return SQL::Result { SQL::SQLCommand::Unknown, SQL::SQLErrorCode::SyntaxError, parser.errors()[0].to_byte_string() };
 
-    return TRY(adopt_nonnull_ref_or_enomem(new (nothrow) SQLStatement(connection, move(statement))));
+    return TRY(adopt_nonnull_ref_or_enomem(new (nothrow) SQLStatement(connection, ByteString { sql }, move(statement))));
 }
 
-SQLStatement::SQLStatement(DatabaseConnection& connection, NonnullRefPtr<SQL::AST::Statement> statement)
+SQLStatement::SQLStatement(DatabaseConnection& connection, ByteString sql, NonnullRefPtr<SQL::AST::Statement> statement)
     : m_connection(connection)
     , m_statement_id(s_next_statement_id++)
+    , m_sql(move(sql))
     , m_statement(move(statement))
 {
     dbgln_if(SQLSERVER_DEBUG, "SQLStatement({})", connection.connection_id());
@@ -69,7 +74,13 @@ Optional<SQL::ExecutionID> SQLStatement::execute(Vector<SQL::Value> placeholder_
 
     auto execution_id = m_next_execution_id++;
 
-    Core::deferred_invoke([this, strong_this = NonnullRefPtr(*this), placeholder_values = move(placeholder_values), execution_id] {
+    Core::deferred_invoke([this, strong_this = NonnullRefPtr(*this), placeholder_values = move(placeholder_values), execution_id]() mutable {
+        // A SELECT doesn't modify the database, so it doesn't have to wait for other statements to finish.
+        if (is<SQL::AST::Select>(*m_statement)) {
+            execute_select(move(placeholder_values), execution_id);
+            return;
+        }
+
         auto execution_result = m_statement->execute(connection().database(), placeholder_values);
 
         if (execution_result.is_error()) {
@@ -77,33 +88,188 @@ Optional<SQL::ExecutionID> SQLStatement::execute(Vector<SQL::Value> placeholder_
             return;
         }
 
-        auto client_connection = ConnectionFromClient::client_connection_for(connection().client_id());
-        if (!client_connection) {
-            warnln("Cannot return statement execution results. Client disconnected");
+        // Don't report success before the statement's changes are durable.
+        connection().when_commits_are_durable([this, strong_this = NonnullRefPtr(*this), result = execution_result.release_value(), execution_id](ErrorOr<void> sync_result) mutable {
+            if (sync_result.is_error()) {
+                report_error(SQL::Result { result.command(), SQL::SQLErrorCode::InternalError, ByteString::formatted("{}", sync_result.error()) }, execution_id);
+                return;
+            }
+            report_success(move(result), execution_id);
+        });
+    });
+
+    return execution_id;
+}
+
+void SQLStatement::report_success(SQL::ResultSet result, SQL::ExecutionID execution_id)
+{
+    auto client_connection = ConnectionFromClient::client_connection_for(connection().client_id());
+    if (!client_connection) {
+        warnln("Cannot return statement execution results. Client disconnected");
+        return;
+    }
+
+    auto result_size = result.size();
+
+    if (should_send_result_rows(result)) {
+        client_connection->async_execution_success(statement_id(), execution_id, result.column_names(), true, 0, 0, 0);
+
+        m_ongoing_executions.set(execution_id, { move(result), result_size, {}, false, false });
+        ready_for_next_result(execution_id);
+    } else {
+        if (result.command() == SQL::SQLCommand::Insert)
+            client_connection->async_execution_success(statement_id(), execution_id, result.column_names(), false, result_size, 0, 0);
+        else if (result.command() == SQL::SQLCommand::Update)
+            client_connection->async_execution_success(statement_id(), execution_id, result.column_names(), false, 0, result_size, 0);
+        else if (result.command() == SQL::SQLCommand::Delete)
+            client_connection->async_execution_success(statement_id(), execution_id, result.column_names(), false, 0, 0, result_size);
+        else
+            client_connection->async_execution_success(statement_id(), execution_id, result.column_names(), false, 0, 0, 0);
+    }
+}
+
+// Runs on the reader thread.
+SQL::ResultOr<NonnullRefPtr<SQL::AST::Select>> SQLStatement::parse_select(StringView sql)
+{
+    auto parser = SQL::AST::Parser(SQL::AST::Lexer(sql));
+    auto statement = parser.next_statement();
+
+    if (parser.has_errors())
+        return SQL::Result { SQL::SQLCommand::Select, SQL::SQLErrorCode::SyntaxError, parser.errors()[0].to_byte_string() };
+
+    VERIFY(is<SQL::AST::Select>(*statement));
+    return NonnullRefPtr { static_cast<SQL::AST::Select&>(*statement) };
+}
+
+// Runs on the reader thread.
+SQL::ResultOr<SQLStatement::FetchedRows> SQLStatement::fetch_rows(NonnullOwnPtr<SQL::AST::QueryPlan> plan)
+{
+    FetchedRows fetched;
+    TRY(fetched.rows.try_ensure_capacity(ROWS_PER_FETCH));
+
+    while (fetched.rows.size() < ROWS_PER_FETCH) {
+        auto row = TRY(plan->next());
+        if (!row.has_value())
+            break;
+        fetched.rows.unchecked_append(row.release_value());
+    }
+
+    fetched.has_more_rows = fetched.rows.size() == ROWS_PER_FETCH;
+    fetched.plan = move(plan);
+    return fetched;
+}
+
+void SQLStatement::post_fetched_rows(Core::EventLoop& event_loop, SQL::StatementID statement_id, SQL::ExecutionID execution_id, SQL::ResultOr<SQLStatement::FetchedRows> fetched)
+{
+    // The statement is looked up again on the main thread, as this thread mustn't hold on to it.
+    event_loop.deferred_invoke([statement_id, execution_id, fetched = move(fetched)]() mutable {
+        if (auto statement = SQLStatement::statement_for(statement_id))
+            statement->did_fetch_rows(execution_id, move(fetched));
+    });
+    event_loop.wake();
+}
+
+void SQLStatement::execute_select(Vector<SQL::Value> placeholder_values, SQL::ExecutionID execution_id)
+{
+    // The snapshot is taken right away, so the SELECT sees everything that was committed before it.
+    auto snapshot = connection().database()->create_snapshot();
+    if (snapshot.is_error()) {
+        report_error(snapshot.release_error(), execution_id);
+        return;
+    }
+
+    auto& event_loop = Core::EventLoop::current();
+
+    // The reader thread gets a copy of the SQL text that isn't shared with this thread, as string
+    // reference counts aren't atomic.
+    auto sql = ByteString { m_sql.view() };
+
+    auto result = connection().run_on_reader_thread([&event_loop, statement_id = statement_id(), execution_id, sql = move(sql), snapshot = snapshot.release_value(), placeholder_values = move(placeholder_values), plan = move(m_cached_plan)]() mutable {
+        auto fetched = [&]() -> SQL::ResultOr<FetchedRows> {
+            // The plan of an earlier execution is reused if it still fits. Otherwise the statement is
+            // parsed again on this thread, so that the new plan doesn't share any part of its AST
+            // with the main thread.
+            if (!plan || !plan->rebind(snapshot, placeholder_values)) {
+                auto select = TRY(parse_select(sql));
+                plan = TRY(SQL::AST::QueryPlan::create(*select, move(snapshot), move(placeholder_values)));
+            }
+            auto column_names = plan->column_names();
+
+            auto rows = TRY(fetch_rows(plan.release_nonnull()));
+            rows.column_names = move(column_names);
+            return rows;
+        }();
+
+        post_fetched_rows(event_loop, statement_id, execution_id, move(fetched));
+    });
+    if (result.is_error())
+        report_error(SQL::Result { SQL::SQLCommand::Select, SQL::SQLErrorCode::InternalError, ByteString::formatted("{}", result.error()) }, execution_id);
+}
+
+void SQLStatement::fetch_more_rows(SQL::ExecutionID execution_id)
+{
+    auto execution = m_ongoing_executions.get(execution_id);
+    VERIFY(execution.has_value() && execution->plan);
+    execution->is_fetching_rows = true;
+
+    auto& event_loop = Core::EventLoop::current();
+    auto result = connection().run_on_reader_thread([&event_loop, statement_id = statement_id(), execution_id, plan = execution->plan.release_nonnull()]() mutable {
+        post_fetched_rows(event_loop, statement_id, execution_id, fetch_rows(move(plan)));
+    });
+    if (result.is_error()) {
+        m_ongoing_executions.remove(execution_id);
+        report_error(SQL::Result { SQL::SQLCommand::Select, SQL::SQLErrorCode::InternalError, ByteString::formatted("{}", result.error()) }, execution_id);
+    }
+}
+
+void SQLStatement::did_fetch_rows(SQL::ExecutionID execution_id, SQL::ResultOr<FetchedRows> fetched)
+{
+    auto client_connection = ConnectionFromClient::client_connection_for(connection().client_id());
+    if (!client_connection) {
+        warnln("Cannot return statement execution results. Client disconnected");
+        return;
+    }
+
+    if (fetched.is_error()) {
+        m_ongoing_executions.remove(execution_id);
+        report_error(fetched.release_error(), execution_id);
+        return;
+    }
+
+    if (!m_ongoing_executions.contains(execution_id)) {
+        // These are the first rows, and the client is told whether there are any rows at all.
+        auto has_results = !fetched.value().rows.is_empty();
+        client_connection->async_execution_success(statement_id(), execution_id, fetched.value().column_names, has_results, 0, 0, 0);
+        if (!has_results) {
+            cache_plan(fetched.value().plan.release_nonnull());
             return;
         }
 
-        auto result = execution_result.release_value();
-        auto result_size = result.size();
-
-        if (should_send_result_rows(result)) {
-            client_connection->async_execution_success(statement_id(), execution_id, result.column_names(), true, 0, 0, 0);
-
-            m_ongoing_executions.set(execution_id, { move(result), result_size });
-            ready_for_next_result(execution_id);
-        } else {
-            if (result.command() == SQL::SQLCommand::Insert)
-                client_connection->async_execution_success(statement_id(), execution_id, result.column_names(), false, result_size, 0, 0);
-            else if (result.command() == SQL::SQLCommand::Update)
-                client_connection->async_execution_success(statement_id(), execution_id, result.column_names(), false, 0, result_size, 0);
-            else if (result.command() == SQL::SQLCommand::Delete)
-                client_connection->async_execution_success(statement_id(), execution_id, result.column_names(), false, 0, 0, result_size);
-            else
-                client_connection->async_execution_success(statement_id(), execution_id, result.column_names(), false, 0, 0, 0);
-        }
-    });
+        m_ongoing_executions.set(execution_id, { SQL::ResultSet { SQL::SQLCommand::Select }, 0, {}, false, false });
+    }
 
-    return execution_id;
+    auto& execution = m_ongoing_executions.get(execution_id).value();
+    auto& rows = fetched.value().rows;
+    if (auto result = execution.result.try_ensure_capacity(execution.result.size() + rows.size()); result.is_error()) {
+        m_ongoing_executions.remove(execution_id);
+        report_error(SQL::Result { SQL::SQLCommand::Select, SQL::SQLErrorCode::InternalError, ByteString::formatted("{}", result.error()) }, execution_id);
+        return;
+    }
+    for (auto& row : rows)
+        execution.result.unchecked_append({ move(row), SQL::Tuple {} });
+
+    execution.result_size += rows.size();
+    execution.plan = move(fetched.value().plan);
+    execution.is_fetching_rows = false;
+    execution.plan_is_exhausted = !fetched.value().has_more_rows;
+    ready_for_next_result(execution_id);
+}
+
+// Every plan owns the AST it was made from, so a plan that isn't kept can be dropped on this thread.
+void SQLStatement::cache_plan(NonnullOwnPtr<SQL::AST::QueryPlan> plan)
+{
+    if (!m_cached_plan)
+        m_cached_plan = move(plan);
 }
 
 void SQLStatement::ready_for_next_result(SQL::ExecutionID execution_id)
@@ -115,11 +281,21 @@ void SQLStatement::ready_for_next_result(SQL::ExecutionID execution_id)
     }
 
     auto execution = m_ongoing_executions.get(execution_id);
-    if (!execution.has_value()) {
+    if (!execution.has_value() || execution->is_fetching_rows) {
+        return;
+    }
+
+    if (execution->result.is_empty() && execution->plan && !execution->plan_is_exhausted) {
+        fetch_more_rows(execution_id);
         return;
     }
 
     if (execution->result.is_empty()) {
+        // The rows share parts of the plan, such as their tuple descriptors, so the plan is only
+        // handed on to the next execution once all of them are gone.
+        if (execution->plan)
+            cache_plan(execution->plan.release_nonnull());
+
         client_connection->async_results_exhausted(statement_id(), execution_id, execution->result_size);
         m_ongoing_executions.remove(execution_id);
         return;
@@ -136,6 +312,7 @@ bool SQLStatement::should_send_result_rows(SQL::ResultSet const& result) const
 
     switch (result.command()) {
     case SQL::SQLCommand::Describe:
+    case SQL::SQLCommand::Explain:
     case SQL::SQLCommand::Select:
         return true;
     default:
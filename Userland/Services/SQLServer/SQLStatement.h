@@ -9,7 +9,9 @@
 #include <AK/NonnullRefPtr.h>
 #include <AK/RefCounted.h>
 #include <AK/Vector.h>
+#include <LibCore/Forward.h>
 #include <LibSQL/AST/AST.h>
+#include <LibSQL/AST/QueryPlan.h>
 #include <LibSQL/Result.h>
 #include <LibSQL/ResultSet.h>
 #include <LibSQL/Type.h>
@@ -29,10 +31,29 @@ public:
     void ready_for_next_result(SQL::ExecutionID);
 
 private:
-    SQLStatement(DatabaseConnection&, NonnullRefPtr<SQL::AST::Statement> statement);
+    // Rows of a SELECT, pulled from its plan on the connection's reader thread. The plan is handed
+    // back along with them.
+    struct FetchedRows {
+        OwnPtr<SQL::AST::QueryPlan> plan;
+        Vector<ByteString> column_names;
+        Vector<SQL::Tuple> rows;
+        bool has_more_rows { false };
+    };
+
+    SQLStatement(DatabaseConnection&, ByteString sql, NonnullRefPtr<SQL::AST::Statement> statement);
 
     bool should_send_result_rows(SQL::ResultSet const& result) const;
     void report_error(SQL::Result, SQL::ExecutionID execution_id);
+    void report_success(SQL::ResultSet, SQL::ExecutionID execution_id);
+
+    static SQL::ResultOr<NonnullRefPtr<SQL::AST::Select>> parse_select(StringView sql);
+    static SQL::ResultOr<FetchedRows> fetch_rows(NonnullOwnPtr<SQL::AST::QueryPlan>);
+    static void post_fetched_rows(Core::EventLoop&, SQL::StatementID, SQL::ExecutionID, SQL::ResultOr<FetchedRows>);
+
+    void execute_select(Vector<SQL::Value> placeholder_values, SQL::ExecutionID execution_id);
+    void fetch_more_rows(SQL::ExecutionID execution_id);
+    void did_fetch_rows(SQL::ExecutionID execution_id, SQL::ResultOr<FetchedRows>);
+    void cache_plan(NonnullOwnPtr<SQL::AST::QueryPlan>);
 
     DatabaseConnection& m_connection;
     SQL::StatementID m_statement_id { 0 };
@@ -40,10 +61,24 @@ private:
     struct Execution {
         SQL::ResultSet result;
         size_t result_size { 0 };
+
+        // A SELECT runs on the connection's reader thread, against a snapshot of the database. Its
+        // rows are pulled from its plan in batches as the client asks for them, and the plan is
+        // away on the reader thread while a batch is being fetched.
+        OwnPtr<SQL::AST::QueryPlan> plan;
+        bool is_fetching_rows { false };
+        bool plan_is_exhausted { false };
     };
     HashMap<SQL::ExecutionID, Execution> m_ongoing_executions;
     SQL::ExecutionID m_next_execution_id { 0 };
 
+    // The plan of a SELECT that has produced all of its rows, to be rebound for the next execution
+    // instead of planning the statement again.
+    OwnPtr<SQL::AST::QueryPlan> m_cached_plan;
+
+    // A SELECT is parsed again on the reader thread for every plan, as AST nodes aren't safe to
+    // share between threads.
+    ByteString m_sql;
     NonnullRefPtr<SQL::AST::Statement> m_statement;
 };
 
@@ -14,12 +14,14 @@
 
 ErrorOr<int> serenity_main(Main::Arguments)
 {
-    TRY(Core::System::pledge("stdio accept unix rpath wpath cpath"));
+    TRY(Core::System::pledge("stdio accept unix rpath wpath cpath thread"));
 
     auto database_path = ByteString::formatted("{}/sql", Core::StandardPaths::data_directory());
     TRY(Core::Directory::create(database_path, Core::Directory::CreateDirectories::Yes));
 
     TRY(Core::System::unveil(database_path, "rwc"sv));
+    // Sorts that don't fit in memory spill their runs to temporary files.
+    TRY(Core::System::unveil("/tmp"sv, "rwc"sv));
     TRY(Core::System::unveil(nullptr, nullptr));
 
     Core::EventLoop event_loop;
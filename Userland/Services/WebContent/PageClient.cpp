@@ -62,16 +62,21 @@ PageClient::PageClient(PageHost& owner, u64 id)
             return;
         }
 
-        auto& back_bitmap = *m_backing_stores.back_bitmap;
         auto viewport_rect = page().css_to_device_rect(page().top_level_traversable()->viewport_rect());
-        paint(viewport_rect, back_bitmap);
+        auto damaged_rect = paint_next_frame(viewport_rect);
 
         auto& backing_stores = m_backing_stores;
         swap(backing_stores.front_bitmap, backing_stores.back_bitmap);
         swap(backing_stores.front_bitmap_id, backing_stores.back_bitmap_id);
+        backing_stores.stale_rect_of_back_bitmap = backing_stores.stale_rect_of_front_bitmap.united(damaged_rect.to_type<Web::DevicePixels>());
+        backing_stores.stale_rect_of_front_bitmap = {};
 
         m_paint_state = PaintState::WaitingForClient;
-        client().async_did_paint(m_id, viewport_rect.to_type<int>(), backing_stores.front_bitmap_id);
+        client().async_did_paint(m_id, viewport_rect.to_type<int>(), backing_stores.front_bitmap_id, damaged_rect);
+    });
+
+    m_prepaint_timer = Web::Platform::Timer::create_single_shot(0, [this] {
+        prepaint_tiles_around_viewport();
     });
 
 #ifdef HAS_ACCELERATED_GRAPHICS
@@ -119,6 +124,9 @@ void PageClient::add_backing_store(i32 front_bitmap_id, Gfx::ShareableBitmap con
     m_backing_stores.back_bitmap_id = back_bitmap_id;
     m_backing_stores.front_bitmap = *const_cast<Gfx::ShareableBitmap&>(front_bitmap).bitmap();
     m_backing_stores.back_bitmap = *const_cast<Gfx::ShareableBitmap&>(back_bitmap).bitmap();
+    // Neither bitmap has anything painted into it yet.
+    m_backing_stores.stale_rect_of_front_bitmap = m_backing_stores.front_bitmap->rect().to_type<Web::DevicePixels>();
+    m_backing_stores.stale_rect_of_back_bitmap = m_backing_stores.back_bitmap->rect().to_type<Web::DevicePixels>();
 }
 
 void PageClient::visit_edges(JS::Cell::Visitor& visitor)
@@ -135,7 +143,29 @@ ConnectionFromClient& PageClient::client() const
 
 void PageClient::set_has_focus(bool has_focus)
 {
+    if (m_has_focus == has_focus)
+        return;
     m_has_focus = has_focus;
+    if (page().top_level_traversable_is_initialized())
+        page().top_level_traversable()->set_needs_display();
+}
+
+void PageClient::set_device_pixels_per_css_pixel(float device_pixels_per_css_pixel)
+{
+    if (m_device_pixels_per_css_pixel == device_pixels_per_css_pixel)
+        return;
+    m_device_pixels_per_css_pixel = device_pixels_per_css_pixel;
+    if (page().top_level_traversable_is_initialized())
+        page().top_level_traversable()->set_needs_display();
+}
+
+void PageClient::set_should_show_line_box_borders(bool should_show_line_box_borders)
+{
+    if (m_should_show_line_box_borders == should_show_line_box_borders)
+        return;
+    m_should_show_line_box_borders = should_show_line_box_borders;
+    if (page().top_level_traversable_is_initialized())
+        page().top_level_traversable()->set_needs_display();
 }
 
 void PageClient::setup_palette()
@@ -165,6 +195,8 @@ void PageClient::set_palette_impl(Gfx::PaletteImpl& impl)
     m_palette_impl = impl;
     if (auto* document = page().top_level_browsing_context().active_document())
         document->invalidate_style();
+    if (page().top_level_traversable_is_initialized())
+        page().top_level_traversable()->set_needs_display();
 }
 
 void PageClient::set_preferred_color_scheme(Web::CSS::PreferredColorScheme color_scheme)
@@ -200,6 +232,12 @@ Web::Layout::Viewport* PageClient::layout_root()
 void PageClient::paint(Web::DevicePixelRect const& content_rect, Gfx::Bitmap& target, Web::PaintOptions paint_options)
 {
     Web::Painting::CommandList painting_commands;
+    record_painting_commands(painting_commands, content_rect, paint_options);
+    execute_painting_commands(painting_commands, target, { {}, content_rect.size().to_type<int>() });
+}
+
+void PageClient::record_painting_commands(Web::Painting::CommandList& painting_commands, Web::DevicePixelRect const& content_rect, Web::PaintOptions paint_options)
+{
     Web::Painting::RecordingPainter recording_painter(painting_commands);
 
     Gfx::IntRect bitmap_rect { {}, content_rect.size().to_type<int>() };
@@ -210,7 +248,10 @@ void PageClient::paint(Web::DevicePixelRect const& content_rect, Gfx::Bitmap& ta
     paint_config.should_show_line_box_borders = m_should_show_line_box_borders;
     paint_config.has_focus = m_has_focus;
     page().top_level_traversable()->paint(recording_painter, paint_config);
+}
 
+void PageClient::execute_painting_commands(Web::Painting::CommandList& painting_commands, Gfx::Bitmap& target, Gfx::IntRect const& rect_to_paint)
+{
     if (s_use_gpu_painter) {
 #ifdef HAS_ACCELERATED_GRAPHICS
         Web::Painting::CommandExecutorGPU painting_command_executor(*m_accelerated_graphics_context, target);
@@ -224,9 +265,92 @@ void PageClient::paint(Web::DevicePixelRect const& content_rect, Gfx::Bitmap& ta
         }
 #endif
     } else {
-        Web::Painting::CommandExecutorCPU painting_command_executor(target);
-        painting_commands.execute(painting_command_executor);
+        Web::Painting::CommandExecutorCPU::execute_in_tiles(painting_commands, target, rect_to_paint);
+    }
+}
+
+bool PageClient::can_use_tiled_backing_store(Web::Painting::CommandList const& painting_commands, Gfx::Bitmap const& target) const
+{
+    if (s_use_gpu_painter || target.scale() != 1 || !painting_commands.can_be_executed_in_tiles())
+        return false;
+
+    // Anything painted relative to the viewport would end up in the wrong place once the viewport is scrolled.
+    auto document = page().top_level_traversable()->active_document();
+    return document && document->paintable() && !document->paintable()->has_content_attached_to_viewport();
+}
+
+Gfx::IntRect PageClient::paint_next_frame(Web::DevicePixelRect const& viewport_rect)
+{
+    auto& back_bitmap = *m_backing_stores.back_bitmap;
+    auto damage = page().top_level_traversable()->take_damage();
+
+    auto viewport_location = viewport_rect.location().to_type<int>();
+    Gfx::IntRect viewport_rect_in_bitmap { {}, viewport_rect.size().to_type<int>() };
+    auto damaged_rect_of_document = page().enclosing_device_rect(damage.rect).to_type<int>();
+
+    // Everything that's visible changes when the viewport is scrolled or resized.
+    Gfx::IntRect damaged_rect;
+    if (damage.everything || viewport_rect != m_last_painted_viewport_rect)
+        damaged_rect = viewport_rect_in_bitmap;
+    else
+        damaged_rect = damaged_rect_of_document.translated(-viewport_location).intersected(viewport_rect_in_bitmap);
+    m_last_painted_viewport_rect = viewport_rect;
+
+    // Whatever was painted ahead of time is out of date once anything changes.
+    if (damage.everything) {
+        m_tiled_backing_store.invalidate_all();
+        m_prepainting_commands.clear();
+    } else if (!damaged_rect_of_document.is_empty()) {
+        m_tiled_backing_store.invalidate(damaged_rect_of_document);
+        m_prepainting_commands.clear();
+    }
+
+    // The back bitmap is a frame behind the front one, so it's also missing whatever changed in the last frame.
+    auto rect_to_paint = damaged_rect.united(m_backing_stores.stale_rect_of_back_bitmap.to_type<int>());
+    if (rect_to_paint.is_empty())
+        return damaged_rect;
+
+    Web::Painting::CommandList painting_commands;
+    record_painting_commands(painting_commands, viewport_rect, {});
+
+    if (!can_use_tiled_backing_store(painting_commands, back_bitmap)) {
+        m_tiled_backing_store.invalidate_all();
+        m_prepainting_commands.clear();
+        execute_painting_commands(painting_commands, back_bitmap, rect_to_paint);
+        return damaged_rect;
     }
+
+    auto rect_of_document_to_paint = rect_to_paint.translated(viewport_location);
+    m_tiled_backing_store.paint_missing_tiles(painting_commands, viewport_location, rect_of_document_to_paint, back_bitmap.format());
+    m_tiled_backing_store.copy_into(back_bitmap, viewport_location, rect_of_document_to_paint);
+
+    m_prepainting_commands = move(painting_commands);
+    m_prepainting_viewport_location = viewport_location;
+    if (!m_prepaint_timer->is_active())
+        m_prepaint_timer->start();
+
+    return damaged_rect;
+}
+
+void PageClient::prepaint_tiles_around_viewport()
+{
+    // NOTE: Only a few tiles are painted at a time, so that input and the next frame don't have to wait for all of them.
+    static constexpr size_t tiles_to_prepaint_at_a_time = 4;
+
+    if (!m_prepainting_commands.has_value() || !m_backing_stores.back_bitmap)
+        return;
+
+    // Most scrolling is vertical, so a viewport's worth of the document above and below it is painted, but only a bit
+    // to the sides.
+    auto viewport_rect = m_last_painted_viewport_rect.to_type<int>();
+    auto rect_to_prepaint = viewport_rect.inflated(2 * Web::Painting::TiledBackingStore::tile_size, 2 * viewport_rect.height());
+    m_tiled_backing_store.discard_tiles_outside(viewport_rect.inflated(4 * Web::Painting::TiledBackingStore::tile_size, 4 * viewport_rect.height()));
+
+    auto has_missing_tiles = m_tiled_backing_store.paint_missing_tiles(*m_prepainting_commands, m_prepainting_viewport_location, rect_to_prepaint, m_backing_stores.back_bitmap->format(), tiles_to_prepaint_at_a_time);
+    if (has_missing_tiles)
+        m_prepaint_timer->start();
+    else
+        m_prepainting_commands.clear();
 }
 
 void PageClient::set_viewport_rect(Web::DevicePixelRect const& rect)
@@ -13,6 +13,8 @@
 #include <LibWeb/HTML/AudioPlayState.h>
 #include <LibWeb/HTML/FileFilter.h>
 #include <LibWeb/Page/Page.h>
+#include <LibWeb/Painting/CommandList.h>
+#include <LibWeb/Painting/TiledBackingStore.h>
 #include <LibWeb/PixelUnits.h>
 #include <WebContent/Forward.h>
 
@@ -44,9 +46,9 @@ public:
     void set_palette_impl(Gfx::PaletteImpl&);
     void set_viewport_rect(Web::DevicePixelRect const&);
     void set_screen_rects(Vector<Web::DevicePixelRect, 4> const& rects, size_t main_screen_index) { m_screen_rect = rects[main_screen_index]; }
-    void set_device_pixels_per_css_pixel(float device_pixels_per_css_pixel) { m_device_pixels_per_css_pixel = device_pixels_per_css_pixel; }
+    void set_device_pixels_per_css_pixel(float);
     void set_preferred_color_scheme(Web::CSS::PreferredColorScheme);
-    void set_should_show_line_box_borders(bool b) { m_should_show_line_box_borders = b; }
+    void set_should_show_line_box_borders(bool);
     void set_has_focus(bool);
     void set_is_scripting_enabled(bool);
     void set_window_position(Web::DevicePixelPoint);
@@ -158,6 +160,12 @@ private:
 
     Web::Layout::Viewport* layout_root();
     void setup_palette();
+
+    void record_painting_commands(Web::Painting::CommandList&, Web::DevicePixelRect const& content_rect, Web::PaintOptions);
+    void execute_painting_commands(Web::Painting::CommandList&, Gfx::Bitmap& target, Gfx::IntRect const& rect_to_paint);
+    bool can_use_tiled_backing_store(Web::Painting::CommandList const&, Gfx::Bitmap const& target) const;
+    Gfx::IntRect paint_next_frame(Web::DevicePixelRect const& viewport_rect);
+    void prepaint_tiles_around_viewport();
     ConnectionFromClient& client() const;
 
     PageHost& m_owner;
@@ -192,9 +200,21 @@ private:
         i32 back_bitmap_id { -1 };
         RefPtr<Gfx::Bitmap> front_bitmap;
         RefPtr<Gfx::Bitmap> back_bitmap;
+
+        // The parts of each bitmap that don't match the last frame that was painted.
+        Web::DevicePixelRect stale_rect_of_front_bitmap;
+        Web::DevicePixelRect stale_rect_of_back_bitmap;
     };
     BackingStores m_backing_stores;
 
+    Web::DevicePixelRect m_last_painted_viewport_rect;
+    Web::Painting::TiledBackingStore m_tiled_backing_store;
+
+    // The commands recorded for the last frame, which are used to paint the tiles around the viewport in the meantime.
+    Optional<Web::Painting::CommandList> m_prepainting_commands;
+    Gfx::IntPoint m_prepainting_viewport_location;
+    RefPtr<Web::Platform::Timer> m_prepaint_timer;
+
     // NOTE: These documents are not visited, but manually removed from the map on document finalization.
     HashMap<JS::RawGCPtr<Web::DOM::Document>, JS::NonnullGCPtr<WebContentConsoleClient>> m_console_clients;
     WeakPtr<WebContentConsoleClient> m_top_level_document_console_client;
@@ -5,8 +5,11 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/AllOf.h>
 #include <AK/ByteString.h>
+#include <AK/CharacterTypes.h>
 #include <AK/Format.h>
+#include <AK/LexicalPath.h>
 #include <AK/String.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/ArgsParser.h>
@@ -130,16 +133,26 @@ public:
 
     void source_file(ByteString file_name)
     {
-        m_input_file_chain.append(move(file_name));
+        m_input_file_chain.append({ move(file_name), {} });
         m_quit_when_files_read = false;
     }
 
     void read_file(ByteString file_name)
     {
-        m_input_file_chain.append(move(file_name));
+        m_input_file_chain.append({ move(file_name), {} });
         m_quit_when_files_read = true;
     }
 
+    void import_file(ByteString file_name, ByteString table_name)
+    {
+        m_input_file_chain.append({ move(file_name), move(table_name) });
+    }
+
+    void set_quit_when_files_read(bool quit_when_files_read)
+    {
+        m_quit_when_files_read = quit_when_files_read;
+    }
+
     auto run()
     {
         read_sql();
@@ -155,15 +168,34 @@ private:
     NonnullRefPtr<SQL::SQLClient> m_sql_client;
     SQL::ConnectionID m_connection_id { 0 };
     Core::EventLoop& m_loop;
+    // Rows of an imported CSV file are inserted this many at a time, so that the database can
+    // insert them together.
+    static constexpr size_t import_batch_size = 1000;
+
+    struct InputFile {
+        ByteString name;
+
+        // Set if this is a CSV file whose rows are to be inserted into the table.
+        Optional<ByteString> import_table;
+    };
+
+    struct CSVField {
+        ByteString text;
+        bool quoted { false };
+    };
+
     OwnPtr<Core::InputBufferedFile> m_input_file { nullptr };
+    Optional<ByteString> m_import_table {};
+    ByteString m_import_columns {};
     bool m_quit_when_files_read { false };
-    Vector<ByteString> m_input_file_chain {};
+    Vector<InputFile> m_input_file_chain {};
     Array<u8, 4096> m_buffer {};
 
     Optional<ByteString> get_line()
     {
         if (!m_input_file && !m_input_file_chain.is_empty()) {
-            auto file_name = m_input_file_chain.take_first();
+            auto input_file = m_input_file_chain.take_first();
+            auto const& file_name = input_file.name;
             auto file_or_error = Core::File::open(file_name, Core::File::OpenMode::Read);
             if (file_or_error.is_error()) {
                 warnln("Input file {} could not be opened: {}", file_name, file_or_error.error());
@@ -177,7 +209,11 @@ private:
             }
 
             m_input_file = buffered_file_or_error.release_value();
+            m_import_table = move(input_file.import_table);
+            m_import_columns = {};
         }
+        if (m_input_file && m_import_table.has_value())
+            return read_import_statement();
         if (m_input_file) {
             auto line = m_input_file->read_line(m_buffer);
             if (line.is_error()) {
@@ -200,6 +236,156 @@ private:
         return line_result.value();
     }
 
+    // Turns the next rows of the CSV file being imported into a single INSERT statement. The first
+    // line of the file names the columns the values go into.
+    Optional<ByteString> read_import_statement()
+    {
+        StringBuilder values;
+        size_t row_count = 0;
+
+        while (row_count < import_batch_size && !m_input_file->is_eof()) {
+            auto record = read_csv_record();
+            if (!record.has_value())
+                return {};
+
+            auto fields = parse_csv_record(*record);
+            if (fields.size() == 1 && fields[0].text.is_empty() && !fields[0].quoted)
+                continue;
+
+            if (m_import_columns.is_empty()) {
+                if (!is_plain_identifier(*m_import_table)) {
+                    warnln("Cannot import into table '{}': only letters, digits and underscores are allowed in its name", *m_import_table);
+                    return stop_import();
+                }
+
+                StringBuilder columns;
+                for (size_t i = 0; i < fields.size(); ++i) {
+                    // The names are pasted into the INSERT statement as they are, so they mustn't be able
+                    // to change what it does.
+                    auto column = fields[i].text.view().trim_whitespace();
+                    if (!is_plain_identifier(column)) {
+                        warnln("Cannot import column '{}': only letters, digits and underscores are allowed in column names", column);
+                        return stop_import();
+                    }
+                    if (i > 0)
+                        columns.append(", "sv);
+                    columns.append(column);
+                }
+                m_import_columns = columns.to_byte_string();
+                continue;
+            }
+
+            if (row_count++ > 0)
+                values.append(", "sv);
+            values.append('(');
+            for (size_t i = 0; i < fields.size(); ++i) {
+                if (i > 0)
+                    values.append(", "sv);
+                append_csv_value(values, fields[i]);
+            }
+            values.append(')');
+        }
+
+        // Rows only run out at the end of the file.
+        if (row_count == 0)
+            return stop_import();
+
+        return ByteString::formatted("INSERT INTO {} ({}) VALUES {};", *m_import_table, m_import_columns, values.string_view());
+    }
+
+    Optional<ByteString> stop_import()
+    {
+        m_input_file->close();
+        m_input_file = nullptr;
+        m_import_table = {};
+        if (m_quit_when_files_read && m_input_file_chain.is_empty())
+            return {};
+        return get_line();
+    }
+
+    // A quoted field may span several lines, so a record only ends at a line break outside of quotes.
+    // Doubled quotes within a quoted field come in pairs, so the quotes seen so far being odd in
+    // number means a quoted field is still open.
+    Optional<ByteString> read_csv_record()
+    {
+        StringBuilder record;
+        size_t quote_count = 0;
+
+        do {
+            auto line = m_input_file->read_line(m_buffer);
+            if (line.is_error()) {
+                warnln("Failed to read line: {}", line.error());
+                return {};
+            }
+
+            auto text = line.value();
+            if (text.ends_with('\r'))
+                text = text.substring_view(0, text.length() - 1);
+            if (quote_count % 2 != 0)
+                record.append('\n');
+            record.append(text);
+            quote_count += text.count("\""sv);
+        } while (quote_count % 2 != 0 && !m_input_file->is_eof());
+
+        return record.to_byte_string();
+    }
+
+    static bool is_plain_identifier(StringView name)
+    {
+        return !name.is_empty()
+            && (is_ascii_alpha(name[0]) || name[0] == '_')
+            && all_of(name, [](auto ch) { return is_ascii_alphanumeric(ch) || ch == '_'; });
+    }
+
+    static Vector<CSVField> parse_csv_record(StringView record)
+    {
+        Vector<CSVField> fields;
+        StringBuilder field;
+        bool quoted = false;
+        bool in_quotes = false;
+
+        for (size_t i = 0; i < record.length(); ++i) {
+            auto ch = record[i];
+            if (in_quotes) {
+                if (ch != '"')
+                    field.append(ch);
+                else if (i + 1 < record.length() && record[i + 1] == '"')
+                    field.append(record[++i]);
+                else
+                    in_quotes = false;
+            } else if (ch == '"') {
+                in_quotes = quoted = true;
+            } else if (ch == ',') {
+                fields.append({ field.to_byte_string(), quoted });
+                field.clear();
+                quoted = false;
+            } else {
+                field.append(ch);
+            }
+        }
+
+        fields.append({ field.to_byte_string(), quoted });
+        return fields;
+    }
+
+    // Unquoted fields that look like numbers are inserted as numbers, everything else as text.
+    static void append_csv_value(StringBuilder& builder, CSVField const& field)
+    {
+        auto text = field.quoted ? field.text.view() : field.text.view().trim_whitespace();
+        auto is_number = !field.quoted && !text.is_empty()
+            && all_of(text, [](auto ch) { return is_ascii_digit(ch) || "+-.eE"sv.contains(ch); })
+            && text.to_number<double>().has_value();
+
+        if (is_number) {
+            builder.append(text);
+            return;
+        }
+
+        builder.append('\'');
+        builder.append(text.replace("'"sv, "''"sv, ReplaceMode::All));
+        builder.append('\'');
+    }
+
     ByteString read_next_piece()
     {
         StringBuilder piece;
@@ -218,7 +404,8 @@ private:
             auto& line = line_maybe.value();
             auto lexer = SQL::AST::Lexer(line);
 
-            m_editor->add_to_history(line);
+            if (!m_import_table.has_value())
+                m_editor->add_to_history(line);
             piece.append(line);
 
             bool is_first_token = true;
@@ -318,6 +505,28 @@ private:
             } else {
                 outln("\033[33;1mUsage: .connect <database name>\033[0m");
             }
+        } else if (command == ".stats") {
+            if (m_database_name.is_empty()) {
+                outln("\033[33;1mNot connected to a database\033[0m");
+            } else {
+                auto statistics = m_sql_client->buffer_pool_statistics(m_connection_id);
+                auto lookups = statistics.hits() + statistics.misses();
+                outln("Buffer pool: {} of {} blocks cached, {} pinned", statistics.cached_blocks(), statistics.capacity(), statistics.pinned_blocks());
+                outln("Hits: {}, misses: {}, evictions: {}", statistics.hits(), statistics.misses(), statistics.evictions());
+                if (lookups > 0)
+                    outln("Hit rate: {:.1}%", 100.0 * statistics.hits() / lookups);
+            }
+        } else if (command.starts_with(".import "sv)) {
+            if (!m_input_file) {
+                auto parts = command.split_view(' ');
+                if (parts.size() == 3) {
+                    import_file(parts[1], parts[2]);
+                } else {
+                    outln("\033[33;1mUsage: .import <csv file> <table>\033[0m");
+                }
+            } else {
+                outln("\033[33;1mCannot import csv files while reading sql files\033[0m");
+            }
         } else if (command.starts_with(".read "sv)) {
             if (!m_input_file) {
                 auto parts = command.split_view(' ');
@@ -341,6 +550,8 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     ByteString database_name(getlogin());
     ByteString file_to_source;
     ByteString file_to_read;
+    ByteString file_to_import;
+    ByteString import_table;
     bool suppress_sqlrc = false;
     auto sqlrc_path = ByteString::formatted("{}/.sqlrc", Core::StandardPaths::home_directory());
 #if !defined(AK_OS_SERENITY)
@@ -352,6 +563,8 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(database_name, "Database to connect to", "database", 'd', "database");
     args_parser.add_option(file_to_read, "File to read", "read", 'r', "file");
     args_parser.add_option(file_to_source, "File to source", "source", 's', "file");
+    args_parser.add_option(file_to_import, "CSV file to import, with the column names on its first line", "import", 'i', "file");
+    args_parser.add_option(import_table, "Table to import into (defaults to the name of the imported file)", "table", 't', "table");
     args_parser.add_option(suppress_sqlrc, "Don't read ~/.sqlrc", "no-sqlrc", 'n');
 #if !defined(AK_OS_SERENITY)
     args_parser.add_option(sql_server_path, "Path to SQLServer to launch if needed", "sql-server-path", 'p', "path");
@@ -379,5 +592,13 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         repl.source_file(file_to_source);
     if (!file_to_read.is_empty())
         repl.read_file(file_to_read);
+    if (!file_to_import.is_empty()) {
+        if (import_table.is_empty())
+            import_table = LexicalPath::title(file_to_import);
+        repl.import_file(file_to_import, import_table);
+
+        // Like reading a file, importing one is done without dropping into the prompt.
+        repl.set_quit_when_files_read(true);
+    }
     return repl.run();
 }